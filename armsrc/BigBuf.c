@@ -13,6 +13,7 @@
 #include "string.h"
 #include "dbprint.h"
 #include "pm3_cmd.h"
+#include "cmd.h"
 
 extern uint8_t _stack_start, __bss_end__;
 
@@ -66,6 +67,13 @@ static dmabuf8_t dma_8 = {
 // trace related variables
 static uint32_t trace_len = 0;
 static bool tracing = true;
+// when streaming, the trace is split in two halves. LogTrace fills one while
+// the sniff loops push the other to the client between frames
+static bool trace_streaming = false;
+static uint32_t trace_base = 0;         // start of the half LogTrace fills
+static uint32_t trace_pending = 0;      // next record of the half waiting to be sent
+static uint32_t trace_pending_len = 0;  // bytes of it still to send
+static uint32_t trace_dropped = 0;      // frames lost because both halves were full
 
 // compute the available size for BigBuf
 void BigBuf_initialize(void) {
@@ -165,11 +173,13 @@ void BigBuf_print_status(void) {
 }
 
 // return the maximum trace length (i.e. the unallocated size of BigBuf)
-uint16_t BigBuf_max_traceLen(void) {
+uint32_t BigBuf_max_traceLen(void) {
     return s_bigbuf_hi;
 }
 
 void clear_trace(void) {
+    if (trace_streaming)
+        trace_stream_flush();
     trace_len = 0;
 }
 
@@ -185,6 +195,102 @@ bool get_tracing(void) {
     return tracing;
 }
 
+// Enabling starts with an empty trace, disabling pushes what is left to the client.
+void set_trace_streaming(bool enable) {
+    if (enable) {
+        trace_len = 0;
+        trace_base = 0;
+        trace_pending_len = 0;
+        trace_dropped = 0;
+        tracing = true;
+    } else if (trace_streaming) {
+        trace_stream_flush();
+    }
+    trace_streaming = enable;
+}
+
+bool get_trace_streaming(void) {
+    return trace_streaming;
+}
+
+// frames LogTrace lost since streaming was enabled, the client reports them when it stops
+uint32_t get_trace_stream_dropped(void) {
+    return trace_dropped;
+}
+
+static inline uint32_t trace_stream_half(void) {
+    return BigBuf_max_traceLen() / 2;
+}
+
+// Hand the half LogTrace fills over to be sent and log into the other one.
+// No I/O, fails while the other half still waits for the client
+static inline bool trace_stream_swap(void) {
+    if (trace_pending_len)
+        return false;
+
+    trace_pending = trace_base;
+    trace_pending_len = trace_len - trace_base;
+    trace_base = (trace_base == 0) ? trace_stream_half() : 0;
+    trace_len = trace_base;
+    return true;
+}
+
+// Send the records of [*start, *start + *len) in packets split on record boundaries,
+// so the client can append them as is. One packet of at most max bytes, or all of them
+static void trace_stream_send(uint32_t *start, uint32_t *len, uint16_t max, bool all) {
+    uint8_t *trace = BigBuf_get_addr();
+
+    while (*len) {
+        uint32_t end = *start + *len;
+        uint32_t pos = *start;
+
+        while (pos < end) {
+            tracelog_hdr_t *hdr = (tracelog_hdr_t *)(trace + pos);
+            uint32_t reclen = TRACELOG_HDR_LEN + hdr->data_len + TRACELOG_PARITY_LEN(hdr);
+
+            // a record always goes, even on its own
+            if (pos > *start && pos + reclen - *start > max)
+                break;
+            pos += reclen;
+        }
+
+        reply_ng(CMD_TRACE_STREAM_DATA, PM3_SUCCESS, trace + *start, pos - *start);
+        *len -= MIN(*len, pos - *start);
+        *start = pos;
+
+        if (all == false)
+            break;
+    }
+}
+
+// Called by the sniff loops when the air is quiet, and by the main loop between commands. Sends one small packet of
+// the half waiting to go, or hands the logging half over once it is half full,
+// so LogTrace rarely finds both halves taken.
+void trace_stream_poll(void) {
+    if (trace_streaming == false)
+        return;
+
+    if (trace_pending_len == 0) {
+        if (trace_len - trace_base < trace_stream_half() / 2)
+            return;
+        trace_stream_swap();
+    }
+    trace_stream_send(&trace_pending, &trace_pending_len, TRACE_STREAM_CHUNK, false);
+}
+
+// Send everything logged, oldest half first, and empty the trace.
+// Blocks until done, not for use inside the sniff loops
+void trace_stream_flush(void) {
+    trace_stream_send(&trace_pending, &trace_pending_len, PM3_CMD_DATA_SIZE, true);
+
+    uint32_t start = trace_base;
+    uint32_t len = trace_len - trace_base;
+    trace_stream_send(&start, &len, PM3_CMD_DATA_SIZE, true);
+
+    trace_base = 0;
+    trace_len = 0;
+}
+
 /**
  * Get the number of bytes traced
  * @return
@@ -209,10 +315,21 @@ bool RAMFUNC LogTrace(const uint8_t *btBytes, uint16_t iLen, uint32_t timestamp_
 
     uint32_t num_paritybytes = (iLen - 1) / 8 + 1; // number of valid paritybytes in *parity
 
-    // Return when trace is full
-    if (TRACELOG_HDR_LEN + iLen + num_paritybytes >= BigBuf_max_traceLen() - trace_len) {
-        tracing = false;
-        return false;
+    // when streaming only the current half is ours
+    uint32_t limit = (trace_streaming) ? trace_base + trace_stream_half() : BigBuf_max_traceLen();
+
+    // Return when trace is full, unless streaming can switch to the other half
+    if (TRACELOG_HDR_LEN + iLen + num_paritybytes >= limit - trace_len) {
+        if (trace_streaming == false || trace_len == trace_base) {
+            tracing = false;
+            return false;
+        }
+        // the client hasn't got the other half yet, lose this frame but keep sniffing
+        if (trace_stream_swap() == false) {
+            trace_dropped++;
+            return true;
+        }
+        hdr = (tracelog_hdr_t *)(trace + trace_len);
     }
 
     uint32_t duration;
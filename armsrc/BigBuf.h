@@ -20,6 +20,7 @@
 #define MAX_MIFARE_PARITY_SIZE  3   // need 18 parity bits for the 18 Byte above. 3 Bytes are enough to store these
 #define CARD_MEMORY_SIZE        4096
 #define DMA_BUFFER_SIZE         256
+#define TRACE_STREAM_CHUNK      256 // bytes trace_stream_poll sends at once, keeps the sniff loops from falling behind
 
 // 8 data bits and 1 parity bit per payload byte, 1 correction bit, 1 SOC bit, 2 EOC bits
 #define TOSEND_BUFFER_SIZE (9 * MAX_FRAME_SIZE + 1 + 1 + 2)
@@ -27,7 +28,7 @@
 uint8_t *BigBuf_get_addr(void);
 uint32_t BigBuf_get_size(void);
 uint8_t *BigBuf_get_EM_addr(void);
-uint16_t BigBuf_max_traceLen(void);
+uint32_t BigBuf_max_traceLen(void);
 void BigBuf_initialize(void);
 void BigBuf_Clear(void);
 void BigBuf_Clear_ext(bool verbose);
@@ -42,6 +43,11 @@ void clear_trace(void);
 void set_tracing(bool enable);
 void set_tracelen(uint32_t value);
 bool get_tracing(void);
+void set_trace_streaming(bool enable);
+bool get_trace_streaming(void);
+uint32_t get_trace_stream_dropped(void);
+void trace_stream_poll(void);
+void trace_stream_flush(void);
 
 bool RAMFUNC LogTrace(const uint8_t *btBytes, uint16_t iLen, uint32_t timestamp_start, uint32_t timestamp_end, uint8_t *parity, bool readerToTag);
 bool LogTrace_ISO15693(const uint8_t *bytes, uint16_t len, uint32_t ts_start, uint32_t ts_end, uint8_t *parity, bool reader2tag);
@@ -135,7 +135,7 @@ static uint32_t IceAWIDdemod(void) {
     int dummyIdx = 0;
 
     //askdemod and manchester decode
-    int idx = detectAWID(dest, &size, &dummyIdx);
+    int idx = detectAWID(dest, &size, &dummyIdx, NULL);
 
     if (idx <= 0 || size != 96) {
         BigBuf_free();
@@ -193,7 +193,7 @@ static uint32_t IceIOdemod(void) {
     uint8_t *dest = BigBuf_get_addr();
 
     //fskdemod and get start index
-    int idx = detectIOProx(dest, &size, &dummyIdx);
+    int idx = detectIOProx(dest, &size, &dummyIdx, NULL);
 
     if (idx < 0) {
         BigBuf_free();
@@ -237,7 +237,7 @@ static uint32_t IceHIDDemod(void) {
     uint8_t *dest = BigBuf_get_addr();
 
     // FSK demodulator
-    int idx = HIDdemodFSK(dest, &size, &hi2, &hi, &lo, &dummyIdx);
+    int idx = HIDdemodFSK(dest, &size, &hi2, &hi, &lo, &dummyIdx, NULL);
     if (idx < 0) {
         BigBuf_free();
         return PM3_ESOFT;
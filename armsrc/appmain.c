@@ -46,6 +46,7 @@
 #include "util.h"
 #include "ticks.h"
 #include "commonutil.h"
+#include "bigbuf_lz4.h"
 
 #ifdef WITH_LCD
 #include "LCD.h"
@@ -414,6 +415,7 @@ static void SendStatus(void) {
 
 static void SendCapabilities(void) {
     capabilities_t capabilities;
+    memset(&capabilities, 0, sizeof(capabilities));
     capabilities.version = CAPABILITIES_VERSION;
     capabilities.via_fpc = g_reply_via_fpc;
     capabilities.via_usb = g_reply_via_usb;
@@ -519,6 +521,7 @@ static void SendCapabilities(void) {
 #else
     capabilities.compiled_with_lcd = false;
 #endif
+    capabilities.bigbuf_lz4_download = true;
     reply_ng(CMD_CAPABILITIES, PM3_SUCCESS, (uint8_t *)&capabilities, sizeof(capabilities));
 }
 
@@ -725,6 +728,13 @@ void ListenReaderField(uint8_t limit) {
         }
     }
 }
+
+// CMD_DOWNLOAD_BIGBUF_LZ4 sends its packets with this
+static int bigbuf_lz4_reply(const uint8_t *data, uint16_t len, void *ctx) {
+    (void)ctx;
+    return reply_ng(CMD_DOWNLOADED_BIGBUF_LZ4, PM3_SUCCESS, (uint8_t *)data, len);
+}
+
 static void PacketReceived(PacketCommandNG *packet) {
     /*
     if (packet->ng) {
@@ -767,6 +777,21 @@ static void PacketReceived(PacketCommandNG *packet) {
             reply_ng(CMD_SET_TEAROFF, PM3_SUCCESS, NULL, 0);
             break;
         }
+        case CMD_SET_TRACE_STREAMING: {
+            struct p {
+                uint8_t on;
+            } PACKED;
+            struct p *payload = (struct p *)packet->data.asBytes;
+            // frames lost since enabling, only the client can tell the user
+            struct {
+                uint32_t dropped;
+            } PACKED reply;
+            reply.dropped = get_trace_stream_dropped();
+            // disabling flushes the remaining records before we acknowledge
+            set_trace_streaming(payload->on);
+            reply_ng(CMD_SET_TRACE_STREAMING, PM3_SUCCESS, (uint8_t *)&reply, sizeof(reply));
+            break;
+        }
         // always available
         case CMD_HF_DROPFIELD: {
             hf_field_off();
@@ -831,6 +856,17 @@ static void PacketReceived(PacketCommandNG *packet) {
             reply_ng(CMD_LF_SNIFF_RAW_ADC, PM3_SUCCESS, (uint8_t *)&bits, sizeof(bits));
             break;
         }
+        case CMD_LF_SNIFF_STREAM: {
+            struct p {
+                uint32_t samples;
+                uint16_t overruns;
+            } PACKED payload;
+            uint16_t overruns = 0;
+            payload.samples = SniffLFStream(false, &overruns);
+            payload.overruns = overruns;
+            reply_ng(CMD_LF_SNIFF_STREAM, PM3_SUCCESS, (uint8_t *)&payload, sizeof(payload));
+            break;
+        }
         case CMD_LF_HID_WATCH: {
             uint32_t high, low;
             int res = lf_hid_watch(0, &high, &low);
@@ -1836,6 +1872,35 @@ static void PacketReceived(PacketCommandNG *packet) {
             LED_B_OFF();
             break;
         }
+        case CMD_DOWNLOAD_BIGBUF_LZ4: {
+            LED_B_ON();
+            struct p {
+                uint32_t start;
+                uint32_t len;
+                uint8_t flags;
+            } PACKED;
+            struct p *payload = (struct p *)packet->data.asBytes;
+
+            // packed samples don't have neighbours in whole bytes
+            uint8_t flags = payload->flags;
+            if (getSamplingConfig()->bits_per_sample != 8)
+                flags &= ~BIGBUF_LZ4_DELTA;
+
+            uint32_t len = payload->len;
+            if (payload->start >= BigBuf_get_size())
+                len = 0;
+            else
+                len = MIN(len, BigBuf_get_size() - payload->start);
+
+            int res = bigbuf_lz4_compress(BigBuf_get_addr() + payload->start, len, flags, bigbuf_lz4_reply, NULL);
+            if (res != PM3_SUCCESS)
+                Dbprintf("compressed transfer to client failed :: result: %d", res);
+
+            // the end, with the sampling config as CMD_DOWNLOAD_BIGBUF
+            reply_ng(CMD_DOWNLOAD_BIGBUF_LZ4, res, (uint8_t *)getSamplingConfig(), sizeof(sample_config));
+            LED_B_OFF();
+            break;
+        }
 #ifdef WITH_LF
         case CMD_LF_UPLOAD_SIM_SAMPLES: {
             // iceman; since changing fpga_bitstreams clears bigbuff, Its better to call it before.
@@ -2341,7 +2406,10 @@ void  __attribute__((noreturn)) AppMain(void) {
         int ret = receive_ng(&rx);
         if (ret == PM3_SUCCESS) {
             PacketReceived(&rx);
-        } else if (ret != PM3_ENODATA) {
+        } else if (ret == PM3_ENODATA) {
+            // reader commands don't poll, push what they traced while idle
+            trace_stream_poll();
+        } else {
 
             Dbprintf("Error in frame reception: %d %s", ret, (ret == PM3_EIO) ? "PM3_EIO" : "");
             // TODO if error, shall we resync ?
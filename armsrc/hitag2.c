@@ -1043,6 +1043,9 @@ void SniffHitag2(void) {
                 g_logging = true;
                 LED_D_ON();
             }
+        } else {
+            // nothing on the air, push a piece of the trace
+            trace_stream_poll();
         }
 
         /*lf_count_edge_periods(10000);*/
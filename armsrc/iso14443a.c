@@ -706,7 +706,12 @@ void RAMFUNC SniffIso14443a(uint8_t param) {
                 break;
             }
         }
-        if (dataLen < 1) continue;
+        if (dataLen < 1) {
+            // caught up and nobody is sending, push a piece of the trace
+            if (TagIsActive == false && ReaderIsActive == false)
+                trace_stream_poll();
+            continue;
+        }
 
         // primary buffer was stopped( <-- we lost data!
         if (!AT91C_BASE_PDC_SSC->PDC_RCR) {
@@ -1691,7 +1691,12 @@ void SniffIso14443b(void) {
     for (;;) {
 
         volatile int behind_by = ((uint16_t *)AT91C_BASE_PDC_SSC->PDC_RPR - upTo) & (DMA_BUFFER_SIZE - 1);
-        if (behind_by < 1) continue;
+        if (behind_by < 1) {
+            // caught up and nobody is sending, push a piece of the trace
+            if (tag_is_active == false && reader_is_active == false)
+                trace_stream_poll();
+            continue;
+        }
 
         samples++;
         if (samples == 1) {
@@ -1273,7 +1273,7 @@ int lf_hid_watch(int findone, uint32_t *high, uint32_t *low) {
         // 50 * 128 * 2 - big enough to catch 2 sequences of largest format
         size = MIN(12800, BigBuf_max_traceLen());
 
-        int idx = HIDdemodFSK(dest, &size, &hi2, &hi, &lo, &dummyIdx);
+        int idx = HIDdemodFSK(dest, &size, &hi2, &hi, &lo, &dummyIdx, NULL);
         if (idx < 0) continue;
 
         if (idx > 0 && lo > 0 && (size == 96 || size == 192)) {
@@ -1382,7 +1382,7 @@ int lf_awid_watch(int findone, uint32_t *high, uint32_t *low) {
         size = MIN(12800, BigBuf_max_traceLen());
 
         //askdemod and manchester decode
-        int idx = detectAWID(dest, &size, &dummyIdx);
+        int idx = detectAWID(dest, &size, &dummyIdx, NULL);
 
         if (idx <= 0 || size != 96) continue;
         // Index map
@@ -1562,7 +1562,7 @@ int lf_io_watch(int findone, uint32_t *high, uint32_t *low) {
         size_t size = MIN(12000, BigBuf_max_traceLen());
 
         //fskdemod and get start index
-        int idx = detectIOProx(dest, &size, &dummyIdx);
+        int idx = detectIOProx(dest, &size, &dummyIdx, NULL);
         if (idx < 0) continue;
         //valid tag found
 
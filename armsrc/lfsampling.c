@@ -17,6 +17,7 @@
 #include "lfdemod.h"
 #include "string.h"  // memset
 #include "appmain.h" // print stack
+#include "cmd.h"     // reply_ng
 
 /*
 Default LF config is set to:
@@ -405,6 +406,124 @@ uint32_t SniffLF(bool verbose, uint32_t sample_size) {
     return ReadLF(false, verbose, sample_size);
 }
 
+// raw ADC samples per DMA buffer, two of them take turns
+#define LF_STREAM_DMA_SIZE  512
+
+/**
+* Continuous sniff (field off). Instead of filling BigBuf once, the samples are decimated and
+* averaged per the sampling config and sent to the client as they come, in CMD_LF_SNIFF_STREAM_DATA
+* blocks. The ADC fills one DMA buffer while the other one is decimated and sent. Should sending
+* fall behind, the samples arriving meanwhile are dropped and the overrun count in the next block goes up.
+* Runs until the button is pressed or the client sends a command.
+* @param overruns - how many times samples were dropped
+* @return number of samples sent
+**/
+uint32_t SniffLFStream(bool verbose, uint16_t *overruns) {
+
+    BigBuf_free();
+    BigBuf_Clear_ext(false);
+
+    uint8_t *dma = BigBuf_malloc(2 * LF_STREAM_DMA_SIZE);
+    lf_stream_data_t *blk = (lf_stream_data_t *)BigBuf_malloc(PM3_CMD_DATA_SIZE);
+
+    if (verbose)
+        printLFConfig();
+
+    uint8_t decimation = (config.decimation > 0) ? config.decimation : 1;
+    bool avg = config.averaging && decimation > 1;
+
+    LFSetupFPGAForADC(config.divisor, false);
+
+    AT91C_BASE_PDC_SSC->PDC_PTCR = AT91C_PDC_RXTDIS;
+    AT91C_BASE_PDC_SSC->PDC_RPR = (uint32_t)dma;
+    AT91C_BASE_PDC_SSC->PDC_RCR = LF_STREAM_DMA_SIZE;
+    AT91C_BASE_PDC_SSC->PDC_RNPR = (uint32_t)(dma + LF_STREAM_DMA_SIZE);
+    AT91C_BASE_PDC_SSC->PDC_RNCR = LF_STREAM_DMA_SIZE;
+    (void)AT91C_BASE_SSC->SSC_RHR; // clear receive register
+    AT91C_BASE_PDC_SSC->PDC_PTCR = AT91C_PDC_RXTEN;
+
+    uint8_t *this_buf = dma;
+    uint32_t sent = 0;
+    uint16_t len = 0;
+    uint8_t dec_counter = 0;
+    uint32_t sum = 0;
+    *overruns = 0;
+    blk->start = 0;
+    blk->overruns = 0;
+
+    LED_A_ON();
+    for (;;) {
+
+        WDT_HIT();
+
+        if (BUTTON_PRESS() || data_available())
+            break;
+
+        if ((AT91C_BASE_SSC->SSC_SR & AT91C_SSC_ENDRX) == 0)
+            continue;
+
+        // both buffers full, the DMA stopped. Start over, what came in meanwhile is lost
+        bool overrun = (AT91C_BASE_SSC->SSC_SR & AT91C_SSC_RXBUFF);
+
+        for (uint16_t i = 0; i < LF_STREAM_DMA_SIZE; i++) {
+
+            uint8_t sample = this_buf[i];
+            if (decimation > 1) {
+                sum += sample;
+                if (++dec_counter < decimation)
+                    continue;
+
+                dec_counter = 0;
+                if (avg)
+                    sample = sum / decimation;
+                sum = 0;
+            }
+
+            blk->samples[len++] = sample;
+            if (len == LF_STREAM_BLOCK_SAMPLES) {
+                reply_ng(CMD_LF_SNIFF_STREAM_DATA, PM3_SUCCESS, (uint8_t *)blk, PM3_CMD_DATA_SIZE);
+                sent += len;
+                blk->start = sent;
+                len = 0;
+            }
+        }
+
+        if (overrun) {
+            (*overruns)++;
+            blk->overruns = *overruns;
+            AT91C_BASE_PDC_SSC->PDC_RPR = (uint32_t)dma;
+            AT91C_BASE_PDC_SSC->PDC_RCR = LF_STREAM_DMA_SIZE;
+            AT91C_BASE_PDC_SSC->PDC_RNPR = (uint32_t)(dma + LF_STREAM_DMA_SIZE);
+            AT91C_BASE_PDC_SSC->PDC_RNCR = LF_STREAM_DMA_SIZE;
+            this_buf = dma;
+            continue;
+        }
+
+        // hand the buffer back to the DMA, behind the one filling now
+        AT91C_BASE_PDC_SSC->PDC_RNPR = (uint32_t)this_buf;
+        AT91C_BASE_PDC_SSC->PDC_RNCR = LF_STREAM_DMA_SIZE;
+        this_buf = (this_buf == dma) ? dma + LF_STREAM_DMA_SIZE : dma;
+    }
+
+    AT91C_BASE_PDC_SSC->PDC_PTCR = AT91C_PDC_RXTDIS;
+
+    // what is left
+    if (len) {
+        reply_ng(CMD_LF_SNIFF_STREAM_DATA, PM3_SUCCESS, (uint8_t *)blk, sizeof(lf_stream_data_t) + len);
+        sent += len;
+    }
+
+    StopTicks();
+    FpgaWriteConfWord(FPGA_MAJOR_MODE_OFF);
+    LED_A_OFF();
+    BigBuf_free();
+
+    if (verbose)
+        Dbprintf("Done, streamed " _YELLOW_("%u") " samples, " _YELLOW_("%u") " overruns", sent, *overruns);
+
+    return sent;
+}
+
 /**
 * acquisition of T55x7 LF signal. Similar to other LF, but adjusted with @marshmellows thresholds
 * the data is collected in BigBuf.
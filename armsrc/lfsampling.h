@@ -42,6 +42,12 @@ uint32_t SampleLF(bool verbose, uint32_t sample_size);
 **/
 uint32_t SniffLF(bool verbose, uint32_t sample_size);
 
+/**
+* Continuous sniff, the samples go to the client in CMD_LF_SNIFF_STREAM_DATA blocks instead of BigBuf.
+* @return number of samples sent
+**/
+uint32_t SniffLFStream(bool verbose, uint16_t *overruns);
+
 uint32_t DoAcquisition(uint8_t decimation, uint8_t bits_per_sample, bool avg, int16_t trigger_threshold,
                        bool verbose, uint32_t sample_size, uint32_t cancel_after, int32_t samples_to_skip);
 
@@ -642,12 +642,15 @@ usage(void) {
             "\t-c calculate CRCs\t\t-d dump algorithm parameters\n"
             "\t-D list preset algorithms\t-e echo (and reformat) input\n"
             "\t-s search for algorithm\t\t-v calculate reversed CRCs\n"
-            "\t-g search for alg given hex+crc\n"
+            "\t-g search for alg given hex+crc\t-g -f read hex+crc lines of file\n"
             "\t-h | -u | -? show this help\n"
             "Common Use Examples:\n"
             "\t   reveng -g 01020304e3\n"
             "\t      Searches for a known/common crc preset that computes the crc\n"
             "\t      on the end of the given hex string\n"
+            "\t   reveng -g 01020304e3 010204039d\n"
+            "\t      Searches the presets on each hex string and lists the ones\n"
+            "\t      that compute the crc on the end of all of them\n"
             "\t   reveng -w 8 -s 01020304e3 010204039d\n"
             "\t      Searches for any possible 8 bit width crc calc that computes\n"
             "\t      the crc on the end of the given hex string(s)\n"
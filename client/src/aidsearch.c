@@ -10,9 +10,29 @@
 #include "aidsearch.h"
 #include <ctype.h>
 #include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
 #include "fileutils.h"
 #include "pm3_cmd.h"
 
+// longest AID in the list, in hex chars
+#define AID_INDEX_MAX_LEN   32
+
+// The list is parsed once for the process. Its AIDs are kept upper case, sorted
+// by length and then by value, a lookup bisects once per length the list has.
+// Vendor, name, etc stay in the json until an AID is printed
+typedef struct {
+    char aid[AID_INDEX_MAX_LEN + 1];
+    uint8_t len;
+    uint16_t elm;           // index in the json array
+} aid_index_t;
+
+static pthread_mutex_t aid_lock = PTHREAD_MUTEX_INITIALIZER;
+static json_t *aid_root = NULL;
+static aid_index_t *aid_index = NULL;
+// entries of length l are aid_index[aid_first[l]] .. aid_index[aid_first[l + 1] - 1]
+static uint16_t aid_first[AID_INDEX_MAX_LEN + 2];
+
 static int openAIDFile(json_t **root, bool verbose) {
     json_error_t error;
 
@@ -47,14 +67,6 @@ static int closeAIDFile(json_t *root) {
     return PM3_SUCCESS;
 }
 
-json_t *AIDSearchInit(bool verbose) {
-    json_t *root = NULL;
-    int res = openAIDFile(&root, verbose);
-    if (res != PM3_SUCCESS)
-        return NULL;
-
-    return root;
-}
 
 json_t *AIDSearchGetElm(json_t *root, int elmindx) {
     json_t *data = json_array_get(root, elmindx);
@@ -86,15 +98,133 @@ static const char *jsonStrGet(json_t *data, const char *name) {
     return cstr;
 }
 
+// aidsmall starts aidlarge, hex case doesn't matter
 static bool aidCompare(const char *aidlarge, const char *aidsmall) {
-    if (strcmp(aidlarge, aidsmall) == 0)
-        return true;
+    size_t len = strlen(aidsmall);
+    if (strlen(aidlarge) < len)
+        return false;
 
-    if (strlen(aidlarge) > strlen(aidsmall))
-        if (strncmp(aidlarge, aidsmall, strlen(aidsmall)) == 0)
-            return true;
+    for (size_t i = 0; i < len; i++)
+        if (toupper(aidlarge[i]) != toupper(aidsmall[i]))
+            return false;
 
-    return false;
+    return true;
+}
+
+static int aid_index_cmp(const void *a, const void *b) {
+    const aid_index_t *x = a, *y = b;
+    if (x->len != y->len)
+        return x->len - y->len;
+    int res = strcmp(x->aid, y->aid);
+    if (res)
+        return res;
+    // the first of the same AIDs in the file wins, as with the scan
+    return x->elm - y->elm;
+}
+
+static int aid_index_build(json_t *root) {
+    size_t count = json_array_size(root);
+    aid_index_t *index = calloc(count, sizeof(aid_index_t));
+    if (index == NULL)
+        return PM3_EMALLOC;
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        json_t *data = json_array_get(root, i);
+        if (!json_is_object(data))
+            continue;
+        const char *dictaid = jsonStrGet(data, "AID");
+        if (dictaid == NULL || strlen(dictaid) > AID_INDEX_MAX_LEN)
+            continue;
+
+        aid_index_t *e = &index[n++];
+        e->len = strlen(dictaid);
+        for (int j = 0; j < e->len; j++)
+            e->aid[j] = toupper(dictaid[j]);
+        e->elm = i;
+    }
+    qsort(index, n, sizeof(aid_index_t), aid_index_cmp);
+
+    memset(aid_first, 0, sizeof(aid_first));
+    size_t j = 0;
+    for (int l = 0; l <= AID_INDEX_MAX_LEN + 1; l++) {
+        while (j < n && index[j].len < l)
+            j++;
+        aid_first[l] = j;
+    }
+
+    aid_index = index;
+    return PM3_SUCCESS;
+}
+
+json_t *AIDSearchInit(bool verbose) {
+    pthread_mutex_lock(&aid_lock);
+    if (aid_root == NULL) {
+        json_t *root = NULL;
+        if (openAIDFile(&root, verbose) == PM3_SUCCESS && aid_index_build(root) == PM3_SUCCESS) {
+            aid_root = root;
+        } else {
+            json_decref(root);
+        }
+    } else if (verbose) {
+        PrintAndLogEx(SUCCESS, "Loaded AID list OK. %zu records.", json_array_size(aid_root));
+    }
+
+    // callers free it when done, the index keeps its own reference
+    json_t *root = json_incref(aid_root);
+    pthread_mutex_unlock(&aid_lock);
+    return root;
+}
+
+json_t *AIDSearchScan(json_t *root, const char *aid) {
+    if (root == NULL || aid == NULL)
+        return NULL;
+
+    json_t *elm = NULL;
+    size_t maxaidlen = 0;
+    for (size_t elmindx = 0; elmindx < json_array_size(root); elmindx++) {
+        json_t *data = AIDSearchGetElm(root, elmindx);
+        if (data == NULL)
+            continue;
+        const char *dictaid = jsonStrGet(data, "AID");
+        if (dictaid && aidCompare(aid, dictaid)) {  // dictaid may be less length than requested aid
+            if (maxaidlen < strlen(dictaid)) {
+                maxaidlen = strlen(dictaid);
+                elm = data;
+            }
+        }
+    }
+    return elm;
+}
+
+json_t *AIDSearchFind(json_t *root, const char *aid) {
+    if (root == NULL || aid == NULL)
+        return NULL;
+
+    // a list loaded some other way has no index
+    if (root != aid_root)
+        return AIDSearchScan(root, aid);
+
+    // only the first chars can match
+    char q[AID_INDEX_MAX_LEN + 1] = {0};
+    size_t qlen = 0;
+    for (; aid[qlen] && qlen < AID_INDEX_MAX_LEN; qlen++)
+        q[qlen] = toupper(aid[qlen]);
+
+    // the longest AID in the list that starts the one looked up
+    for (int l = qlen; l > 0; l--) {
+        int lo = aid_first[l], hi = aid_first[l + 1];
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (strncmp(aid_index[mid].aid, q, l) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo < aid_first[l + 1] && strncmp(aid_index[lo].aid, q, l) == 0)
+            return json_array_get(root, aid_index[lo].elm);
+    }
+    return NULL;
 }
 
 bool AIDGetFromElm(json_t *data, uint8_t *aid, size_t aidmaxlen, int *aidlen) {
@@ -119,21 +249,7 @@ int PrintAIDDescription(json_t *xroot, char *aid, bool verbose) {
     if (root == NULL)
         goto out;
 
-    json_t *elm = NULL;
-    uint32_t maxaidlen = 0;
-    for (uint32_t elmindx = 0; elmindx < json_array_size(root); elmindx++) {
-        json_t *data = AIDSearchGetElm(root, elmindx);
-        if (data == NULL)
-            continue;
-        const char *dictaid = jsonStrGet(data, "AID");
-        if (aidCompare(aid, dictaid)) {  // dictaid may be less length than requested aid
-            if (maxaidlen < strlen(dictaid) && strlen(dictaid) <= strlen(aid)) {
-                maxaidlen = strlen(dictaid);
-                elm = data;
-            }
-        }
-    }
-
+    json_t *elm = AIDSearchFind(root, aid);
     if (elm == NULL)
         goto out;
 
@@ -19,8 +19,13 @@
 
 int PrintAIDDescription(json_t *xroot, char *aid, bool verbose);
 int PrintAIDDescriptionBuf(json_t *root, uint8_t *aid, size_t aidlen, bool verbose);
+// The list is loaded once and shared, free each reference with AIDSearchFree
 json_t *AIDSearchInit(bool verbose);
 json_t *AIDSearchGetElm(json_t *root, int elmindx);
+// element of the longest AID in the list that starts aid (hex), NULL if none
+json_t *AIDSearchFind(json_t *root, const char *aid);
+// the same, by a scan of the whole list
+json_t *AIDSearchScan(json_t *root, const char *aid);
 bool AIDGetFromElm(json_t *data, uint8_t *aid, size_t aidmaxlen, int *aidlen);
 int AIDSearchFree(json_t *root);
 
@@ -0,0 +1,279 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Checksum search over many frames
+//-----------------------------------------------------------------------------
+#include "chksumsearch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "commonutil.h"         // ARRAYLEN
+#include "pm3_cmd.h"            // error codes
+
+// frames checked per step, a multiple of the vector width
+#define CHKSUM_LANES    16
+
+typedef enum {
+    OP_ADD,
+    OP_SUB,
+    OP_XOR,
+    OP_BSD,
+} chksum_op_t;
+
+static const struct {
+    const char *name;
+    chksum_op_t op;
+    uint8_t bits;       // 8 bytes, 4 nibbles, 2 crumbs
+    uint16_t range;     // the values it can give
+} families[CHKSUM_FAMILIES] = {
+    [CHKSUM_ADD8] = { "add bytes",    OP_ADD, 8, 0xFFFF },
+    [CHKSUM_ADD4] = { "add nibbles",  OP_ADD, 4, 0xFFFF },
+    [CHKSUM_ADD2] = { "add crumbs",   OP_ADD, 2, 0xFFFF },
+    [CHKSUM_SUB8] = { "sub bytes",    OP_SUB, 8, 0xFFFF },
+    [CHKSUM_SUB4] = { "sub nibbles",  OP_SUB, 4, 0xFFFF },
+    [CHKSUM_XOR8] = { "xor bytes",    OP_XOR, 8, 0x00FF },
+    [CHKSUM_XOR4] = { "xor nibbles",  OP_XOR, 4, 0x000F },
+    [CHKSUM_XOR2] = { "xor crumbs",   OP_XOR, 2, 0x0003 },
+    [CHKSUM_BSD8] = { "BSD bytes",    OP_BSD, 8, 0x00FF },
+    [CHKSUM_BSD4] = { "BSD nibbles",  OP_BSD, 4, 0x000F },
+};
+
+static const uint16_t masks_8[] = { 0xFF, 0x7F, 0x3F, 0x1F, 0x0F };
+static const uint16_t masks_16[] = { 0xFFFF, 0x0FFF, 0x00FF };
+
+const char *chksum_family_name(chksum_family_t family) {
+    return (family < CHKSUM_FAMILIES) ? families[family].name : "unknown";
+}
+
+static uint16_t chksum_add_term(uint8_t b, uint8_t bits) {
+    switch (bits) {
+        case 4:
+            return NIBBLE_LOW(b) + NIBBLE_HIGH(b);
+        case 2:
+            return CRUMB(b, 0) + CRUMB(b, 2) + CRUMB(b, 4) + CRUMB(b, 6);
+        default:
+            return b;
+    }
+}
+
+static uint16_t chksum_xor_term(uint8_t b, uint8_t bits) {
+    switch (bits) {
+        case 4:
+            return NIBBLE_LOW(b) ^ NIBBLE_HIGH(b);
+        case 2:
+            return CRUMB(b, 0) ^ CRUMB(b, 2) ^ CRUMB(b, 4) ^ CRUMB(b, 6);
+        default:
+            return b;
+    }
+}
+
+uint16_t chksum_calc(chksum_family_t family, const uint8_t *data, size_t len, uint16_t init, uint16_t xorout, uint16_t mask) {
+    if (family >= CHKSUM_FAMILIES)
+        return 0;
+
+    uint8_t bits = families[family].bits;
+    uint16_t sum = init;
+
+    switch (families[family].op) {
+        case OP_ADD:
+            for (size_t i = 0; i < len; i++)
+                sum += chksum_add_term(data[i], bits);
+            break;
+        case OP_SUB:
+            for (size_t i = 0; i < len; i++)
+                sum -= chksum_add_term(data[i], bits);
+            break;
+        case OP_XOR:
+            for (size_t i = 0; i < len; i++)
+                sum ^= chksum_xor_term(data[i], bits);
+            break;
+        case OP_BSD:
+            if (bits == 8) {
+                sum &= 0xFF;
+                for (size_t i = 0; i < len; i++) {
+                    sum = ((sum & 0xFF) >> 1) | ((sum & 0x1) << 7);   // rotate accumulator
+                    sum = (sum + data[i]) & 0xFF;
+                }
+            } else {
+                sum &= 0xF;
+                for (size_t i = 0; i < len; i++) {
+                    sum = ((sum & 0xF) >> 1) | ((sum & 0x1) << 3);
+                    sum = (sum + NIBBLE_HIGH(data[i])) & 0xF;
+                    sum = ((sum & 0xF) >> 1) | ((sum & 0x1) << 3);
+                    sum = (sum + NIBBLE_LOW(data[i])) & 0xF;
+                }
+            }
+            break;
+    }
+    return (sum ^ xorout) & mask;
+}
+
+// v is the checksum of each frame with init 0, f its checksum field. Both are
+// padded to whole lanes with the first frame, which fits by construction
+static bool chksum_fits_add(const uint16_t *v, const uint16_t *f, size_t n, uint16_t init, uint16_t xorout, uint16_t mask) {
+    for (size_t i = 0; i < n; i += CHKSUM_LANES) {
+        uint16_t bad = 0;
+        for (int k = 0; k < CHKSUM_LANES; k++)
+            bad |= (uint16_t)(init + v[i + k]) ^ xorout ^ f[i + k];
+        if (bad & mask)
+            return false;
+    }
+    return true;
+}
+
+static bool chksum_fits_xor(const uint16_t *v, const uint16_t *f, size_t n, uint16_t xorout, uint16_t mask) {
+    for (size_t i = 0; i < n; i += CHKSUM_LANES) {
+        uint16_t bad = 0;
+        for (int k = 0; k < CHKSUM_LANES; k++)
+            bad |= v[i + k] ^ xorout ^ f[i + k];
+        if (bad & mask)
+            return false;
+    }
+    return true;
+}
+
+static int chksum_add_hypothesis(chksum_hypothesis_t **out, size_t *found, size_t *cap, const chksum_hypothesis_t *h) {
+    if (*found == *cap) {
+        size_t ncap = *cap ? *cap * 2 : 64;
+        chksum_hypothesis_t *tmp = realloc(*out, ncap * sizeof(chksum_hypothesis_t));
+        if (tmp == NULL)
+            return PM3_EMALLOC;
+        *out = tmp;
+        *cap = ncap;
+    }
+    (*out)[(*found)++] = *h;
+    return PM3_SUCCESS;
+}
+
+int chksum_search(const uint8_t **frames, const size_t *lens, size_t count, const chksum_search_opt_t *opt, chksum_hypothesis_t **out, size_t *found) {
+
+    *out = NULL;
+    *found = 0;
+
+    uint8_t width = opt->width;
+    if (count == 0 || (width != 1 && width != 2))
+        return PM3_EINVARG;
+
+    // data bytes every frame has
+    size_t shortest = (size_t) -1;
+    for (size_t i = 0; i < count; i++) {
+        if (lens[i] <= width)
+            return PM3_EINVARG;
+        shortest = MIN(shortest, lens[i] - width);
+    }
+
+    size_t padded = (count + CHKSUM_LANES - 1) / CHKSUM_LANES * CHKSUM_LANES;
+    uint16_t *v = calloc(padded, sizeof(uint16_t));
+    uint16_t *f = calloc(padded, sizeof(uint16_t));
+    if (v == NULL || f == NULL) {
+        free(v);
+        free(f);
+        return PM3_EMALLOC;
+    }
+
+    const uint16_t *masks = (width == 1) ? masks_8 : masks_16;
+    size_t nmasks = (width == 1) ? ARRAYLEN(masks_8) : ARRAYLEN(masks_16);
+    if (opt->mask) {
+        masks = &opt->mask;
+        nmasks = 1;
+    }
+
+    size_t cap = 0;
+    int ret = PM3_SUCCESS;
+
+    for (uint8_t le = 0; le < ((width == 2) ? 2 : 1) && ret == PM3_SUCCESS; le++) {
+
+        for (size_t i = 0; i < padded; i++) {
+            const uint8_t *c = frames[i < count ? i : 0] + lens[i < count ? i : 0] - width;
+            if (width == 1)
+                f[i] = c[0];
+            else
+                f[i] = le ? (c[1] << 8 | c[0]) : (c[0] << 8 | c[1]);
+        }
+
+        for (chksum_family_t fam = 0; fam < CHKSUM_FAMILIES && ret == PM3_SUCCESS; fam++) {
+            chksum_op_t op = families[fam].op;
+
+            for (size_t head = 0; head <= opt->max_head && ret == PM3_SUCCESS; head++) {
+                for (size_t tail = 0; tail <= opt->max_tail && ret == PM3_SUCCESS; tail++) {
+
+                    // no frame may run out of data
+                    if (head + tail >= shortest)
+                        continue;
+
+                    if (op != OP_BSD) {
+                        for (size_t i = 0; i < padded; i++) {
+                            size_t n = i < count ? i : 0;
+                            v[i] = chksum_calc(fam, frames[n] + head, lens[n] - width - head - tail, 0, 0, 0xFFFF);
+                        }
+                    }
+
+                    for (size_t m = 0; m < nmasks && ret == PM3_SUCCESS; m++) {
+                        uint16_t mask = masks[m];
+                        if (mask > families[fam].range)
+                            continue;
+
+                        // the checksum fields must fit in the mask
+                        uint16_t over = 0;
+                        for (size_t i = 0; i < padded; i++)
+                            over |= f[i] & ~mask;
+                        if (over)
+                            continue;
+
+                        chksum_hypothesis_t h = {
+                            .family = fam,
+                            .width = width,
+                            .le = le,
+                            .skip_head = head,
+                            .skip_tail = tail,
+                            .mask = mask,
+                        };
+
+                        if (op == OP_XOR) {
+                            // init and the final xor are one constant
+                            h.xorout = (v[0] ^ f[0]) & mask;
+                            if (chksum_fits_xor(v, f, padded, h.xorout, mask))
+                                ret = chksum_add_hypothesis(out, found, &cap, &h);
+                            continue;
+                        }
+
+                        // init bits above the mask never reach the checksum, except for BSD's rotation
+                        uint32_t inits = (op == OP_BSD) ? families[fam].range : mask;
+                        for (uint32_t init = 0; init <= inits && ret == PM3_SUCCESS; init++) {
+                            h.init = init;
+                            bool fits = true;
+
+                            if (op == OP_BSD) {
+                                size_t dlen = lens[0] - width - head - tail;
+                                h.xorout = (chksum_calc(fam, frames[0] + head, dlen, init, 0, 0xFFFF) ^ f[0]) & mask;
+                                for (size_t i = 1; i < count && fits; i++) {
+                                    dlen = lens[i] - width - head - tail;
+                                    fits = chksum_calc(fam, frames[i] + head, dlen, init, h.xorout, mask) == f[i];
+                                }
+                            } else {
+                                h.xorout = ((uint16_t)(init + v[0]) ^ f[0]) & mask;
+                                fits = chksum_fits_add(v, f, padded, init, h.xorout, mask);
+                            }
+
+                            if (fits)
+                                ret = chksum_add_hypothesis(out, found, &cap, &h);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    free(v);
+    free(f);
+
+    if (ret != PM3_SUCCESS) {
+        free(*out);
+        *out = NULL;
+        *found = 0;
+    }
+    return ret;
+}
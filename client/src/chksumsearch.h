@@ -0,0 +1,59 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Checksum search over many frames
+//
+// Every frame ends with its checksum. The search tries the checksum families
+// of `analyse chksum` on every data range, mask and init value, the final xor
+// is taken from the first frame. A hypothesis is dropped on the first frame it
+// doesn't fit, the frames are checked in lanes the compiler vectorises.
+//-----------------------------------------------------------------------------
+
+#ifndef CHKSUMSEARCH_H__
+#define CHKSUMSEARCH_H__
+
+#include "common.h"
+
+typedef enum {
+    CHKSUM_ADD8,        // add bytes
+    CHKSUM_ADD4,        // add nibbles
+    CHKSUM_ADD2,        // add crumbs
+    CHKSUM_SUB8,        // subtract bytes
+    CHKSUM_SUB4,        // subtract nibbles
+    CHKSUM_XOR8,        // xor bytes, LRC
+    CHKSUM_XOR4,        // xor nibbles
+    CHKSUM_XOR2,        // xor crumbs
+    CHKSUM_BSD8,        // BSD rotate and add, bytes
+    CHKSUM_BSD4,        // BSD rotate and add, nibbles
+    CHKSUM_FAMILIES
+} chksum_family_t;
+
+typedef struct {
+    chksum_family_t family;
+    uint8_t width;          // checksum bytes at the end of the frame
+    bool le;                // two byte checksum is little endian
+    uint8_t skip_head;      // data starts after this many bytes
+    uint8_t skip_tail;      // and ends this many bytes before the checksum
+    uint16_t mask;
+    uint16_t init;
+    uint16_t xorout;
+} chksum_hypothesis_t;
+
+typedef struct {
+    uint8_t width;          // 1 or 2 checksum bytes
+    uint16_t mask;          // only this mask, 0 tries all
+    uint8_t max_head;       // data ranges tried
+    uint8_t max_tail;
+} chksum_search_opt_t;
+
+const char *chksum_family_name(chksum_family_t family);
+
+// checksum of data, as calcSum* in `analyse chksum` with init and xorout added
+uint16_t chksum_calc(chksum_family_t family, const uint8_t *data, size_t len, uint16_t init, uint16_t xorout, uint16_t mask);
+
+// All hypotheses that fit all frames, in search order. out is allocated
+int chksum_search(const uint8_t **frames, const size_t *lens, size_t count, const chksum_search_opt_t *opt, chksum_hypothesis_t **out, size_t *found);
+
+#endif
@@ -12,7 +12,8 @@
 #include <stdlib.h>       // size_t
 #include <string.h>
 #include <ctype.h>        // tolower
-//#include <stdio.h>        // printf
+#include <inttypes.h>
+#include <stdio.h>        // printf
 #include "commonutil.h"   // reflect...
 #include "comms.h"        // clearCommandBuffer
 #include "cmdparser.h"    // command_t
@@ -22,6 +23,9 @@
 #include "tea.h"
 #include "legic_prng.h"
 #include "cmddata.h"      // demodbuffer
+#include "util_posix.h"   // msclock
+#include "chksumsearch.h"
+#include "aidsearch.h"
 
 static int CmdHelp(const char *Cmd);
 
@@ -43,28 +47,39 @@ static int usage_analyse_checksum(void) {
     PrintAndLogEx(NORMAL, "The bytes will be added with eachother and than limited with the applied mask");
     PrintAndLogEx(NORMAL, "Finally compute ones' complement of the least significant bytes");
     PrintAndLogEx(NORMAL, "");
+    PrintAndLogEx(NORMAL, "With a file of frames, each ending with its checksum, searches the checksum families,");
+    PrintAndLogEx(NORMAL, "data ranges, masks, init and final xor values that fit all of them");
+    PrintAndLogEx(NORMAL, "");
     PrintAndLogEx(NORMAL, "Usage:  analyse chksum [h] [v] b <bytes> m <mask>");
+    PrintAndLogEx(NORMAL, "        analyse chksum [h] f <file> [w <1|2>] [m <mask>] [s <n>] [e <n>]");
     PrintAndLogEx(NORMAL, "Options:");
     PrintAndLogEx(NORMAL, "           h          This help");
     PrintAndLogEx(NORMAL, "           v          suppress header");
     PrintAndLogEx(NORMAL, "           b <bytes>  bytes to calc missing XOR in a LCR");
-    PrintAndLogEx(NORMAL, "           m <mask>   bit mask to limit the outpuyt");
+    PrintAndLogEx(NORMAL, "           m <mask>   bit mask to limit the outpuyt, with f only this mask is tried");
+    PrintAndLogEx(NORMAL, "           f <file>   frames, one hex string per line, # comments");
+    PrintAndLogEx(NORMAL, "           w <1|2>    checksum bytes at the end of the frames (default 1)");
+    PrintAndLogEx(NORMAL, "           s <n>      skip up to n bytes at the start of the data (default 8)");
+    PrintAndLogEx(NORMAL, "           e <n>      skip up to n bytes before the checksum (default 4)");
     PrintAndLogEx(NORMAL, "");
     PrintAndLogEx(NORMAL, "Examples:");
     PrintAndLogEx(NORMAL, "      analyse chksum b 137AF00A0A0D m FF");
     PrintAndLogEx(NORMAL, "expected output: 0x61");
+    PrintAndLogEx(NORMAL, "      analyse chksum f frames.txt w 2");
     return PM3_SUCCESS;
 }
 static int usage_analyse_crc(void) {
     PrintAndLogEx(NORMAL, "A stub method to test different crc implementations inside the PM3 sourcecode. Just because you figured out the poly, doesn't mean you get the desired output");
     PrintAndLogEx(NORMAL, "");
-    PrintAndLogEx(NORMAL, "Usage:  analyse crc [h] <bytes>");
+    PrintAndLogEx(NORMAL, "Usage:  analyse crc [h] [b] <bytes>");
     PrintAndLogEx(NORMAL, "Options:");
     PrintAndLogEx(NORMAL, "           h          This help");
+    PrintAndLogEx(NORMAL, "           b          benchmark the crc16 tables against the bit loop");
     PrintAndLogEx(NORMAL, "           <bytes>    bytes to calc crc");
     PrintAndLogEx(NORMAL, "");
     PrintAndLogEx(NORMAL, "Examples:");
     PrintAndLogEx(NORMAL, "      analyse crc 137AF00A0A0D");
+    PrintAndLogEx(NORMAL, "      analyse crc b");
     return PM3_SUCCESS;
 }
 static int usage_analyse_nuid(void) {
@@ -79,6 +94,19 @@ static int usage_analyse_nuid(void) {
     PrintAndLogEx(NORMAL, "      analyse nuid 11223344556677");
     return PM3_SUCCESS;
 }
+static int usage_analyse_aid(void) {
+    PrintAndLogEx(NORMAL, "Look up an AID in the AID list, the longest AID in the list that starts it");
+    PrintAndLogEx(NORMAL, "");
+    PrintAndLogEx(NORMAL, "Usage:  analyse aid [h] [b] <hex>");
+    PrintAndLogEx(NORMAL, "Options:");
+    PrintAndLogEx(NORMAL, "           h          This help");
+    PrintAndLogEx(NORMAL, "           b          benchmark the AID index against a scan of the list");
+    PrintAndLogEx(NORMAL, "           <hex>      AID");
+    PrintAndLogEx(NORMAL, "");
+    PrintAndLogEx(NORMAL, "Examples:");
+    PrintAndLogEx(NORMAL, "      analyse aid A0000000041010");
+    return PM3_SUCCESS;
+}
 static int usage_analyse_a(void) {
     PrintAndLogEx(NORMAL, "Iceman's personal garbage test command");
     PrintAndLogEx(NORMAL, "");
@@ -283,10 +311,72 @@ static int CmdAnalyseLCR(const char *Cmd) {
     PrintAndLogEx(NORMAL, "Target [%02X] requires final LRC XOR byte value: 0x%02X", data[len - 1], finalXor);
     return 0;
 }
+// MB/s of one crc over buf, runs until 100ms have passed
+static double crc16_throughput(CrcType_t ct, uint16_t init, bool refin, bool refout, const uint8_t *buf, size_t len, uint16_t *crc) {
+    uint64_t bytes = 0;
+    uint64_t t1 = msclock();
+    uint64_t ms;
+    do {
+        *crc = (ct == CRC_NONE) ? Crc16(buf, len, init, CRC16_POLY_CCITT, refin, refout) : Crc16ex(ct, buf, len);
+        bytes += len;
+    } while ((ms = msclock() - t1) < 100);
+    return (double)bytes / (1024 * 1024) / ((double)ms / 1000);
+}
+
+static int analyse_crc_benchmark(void) {
+    const size_t len = 1024 * 1024;
+    uint8_t *buf = malloc(len);
+    if (buf == NULL)
+        return PM3_EMALLOC;
+
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < len; i++) {
+        x = x * 1103515245 + 12345;
+        buf[i] = x >> 24;
+    }
+
+    static const struct {
+        CrcType_t ct;
+        const char *name;
+        uint16_t init;
+        bool refin;
+        bool refout;
+        uint16_t xorout;
+    } types[] = {
+        { CRC_14443_A, "14443-A", 0xC6C6, true, true, 0x0000 },
+        { CRC_14443_B, "14443-B", 0xFFFF, true, true, 0xFFFF },
+        { CRC_15693,   "15693",   0xFFFF, true, true, 0xFFFF },
+        { CRC_ICLASS,  "iCLASS",  0x4807, true, true, 0x0000 },
+        { CRC_FELICA,  "FeliCa",  0x0000, false, false, 0x0000 },
+        { CRC_CCITT,   "CCITT",   0xFFFF, false, false, 0x0000 },
+        { CRC_KERMIT,  "KERMIT",  0x0000, true, true, 0x0000 },
+        { CRC_11784,   "11784",   0x0000, false, true, 0x0000 },
+    };
+
+    PrintAndLogEx(INFO, "crc16 throughput over %zu kB", len / 1024);
+    PrintAndLogEx(INFO, "type    |  table MB/s | bit loop MB/s |");
+    PrintAndLogEx(INFO, "--------+-------------+---------------+-----");
+    for (size_t i = 0; i < ARRAYLEN(types); i++) {
+        uint16_t crc_table = 0, crc_bits = 0;
+        double table = crc16_throughput(types[i].ct, 0, false, false, buf, len, &crc_table);
+        double bits = crc16_throughput(CRC_NONE, types[i].init, types[i].refin, types[i].refout, buf, len, &crc_bits);
+        crc_bits ^= types[i].xorout;
+        PrintAndLogEx(INFO, "%-7s | %11.1f | %13.1f | %s"
+                      , types[i].name
+                      , table
+                      , bits
+                      , (crc_table == crc_bits) ? _GREEN_("ok") : _RED_("fail")
+                     );
+    }
+    free(buf);
+    return PM3_SUCCESS;
+}
+
 static int CmdAnalyseCRC(const char *Cmd) {
 
     char cmdp = tolower(param_getchar(Cmd, 0));
     if (strlen(Cmd) == 0 || cmdp == 'h') return usage_analyse_crc();
+    if (cmdp == 'b' && param_getlength(Cmd, 0) == 1) return analyse_crc_benchmark();
 
     int len = strlen(Cmd);
     if (len & 1) return usage_analyse_crc();
@@ -305,10 +395,8 @@ static int CmdAnalyseCRC(const char *Cmd) {
 
     // 51  f5  7a  d6
     uint8_t uid[] = {0x51, 0xf5, 0x7a, 0xd6}; //12 34 56
-    init_table(CRC_LEGIC);
     uint8_t legic8 = CRC8Legic(uid, sizeof(uid));
     PrintAndLogEx(NORMAL, "Legic 16 | %X (EF6F expected) [legic8 = %02x]", crc16_legic(data, len, legic8), legic8);
-    init_table(CRC_FELICA);
     PrintAndLogEx(NORMAL, "FeliCa | %X ", crc16_xmodem(data, len));
 
     PrintAndLogEx(NORMAL, "\nTests of reflection. Current methods in source code");
@@ -379,6 +467,124 @@ static int CmdAnalyseCRC(const char *Cmd) {
     free(data);
     return 0;
 }
+// one hex frame per line, # comments. The bytes of all frames go in one buffer
+static int analyse_load_frames(const char *filename, uint8_t **buf, size_t **lens, size_t *count) {
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        PrintAndLogEx(ERR, "Error: Could not open file ["_YELLOW_("%s")"]", filename);
+        return PM3_EFILE;
+    }
+
+    size_t cap = 0, size = 0, used = 0;
+    char line[1024];
+    uint8_t frame[512];
+    while (fgets(line, sizeof(line), f)) {
+
+        line[strcspn(line, "\r\n")] = '\0';
+
+        // skip comments and empty lines
+        char *p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '#' || *p == '\0')
+            continue;
+
+        int len = 0;
+        if (param_gethex_to_eol(p, 0, frame, sizeof(frame), &len) || len == 0) {
+            PrintAndLogEx(WARNING, "skipping frame %zu, not a hex string", *count + 1);
+            continue;
+        }
+
+        if (*count == cap) {
+            cap = cap ? cap * 2 : 64;
+            size_t *tmp = realloc(*lens, cap * sizeof(size_t));
+            if (tmp == NULL) {
+                fclose(f);
+                return PM3_EMALLOC;
+            }
+            *lens = tmp;
+        }
+        if (used + len > size) {
+            size = (used + len) * 2;
+            uint8_t *tmp = realloc(*buf, size);
+            if (tmp == NULL) {
+                fclose(f);
+                return PM3_EMALLOC;
+            }
+            *buf = tmp;
+        }
+        memcpy(*buf + used, frame, len);
+        used += len;
+        (*lens)[(*count)++] = len;
+    }
+    fclose(f);
+
+    if (*count == 0) {
+        PrintAndLogEx(WARNING, "no frames in file ["_YELLOW_("%s")"]", filename);
+        return PM3_EINVARG;
+    }
+    return PM3_SUCCESS;
+}
+
+static int analyse_chksum_search(const char *filename, const chksum_search_opt_t *opt) {
+    uint8_t *buf = NULL;
+    size_t *lens = NULL, count = 0;
+    int res = analyse_load_frames(filename, &buf, &lens, &count);
+    if (res != PM3_SUCCESS) {
+        free(buf);
+        free(lens);
+        return res;
+    }
+
+    const uint8_t **frames = calloc(count, sizeof(uint8_t *));
+    if (frames == NULL) {
+        free(buf);
+        free(lens);
+        return PM3_EMALLOC;
+    }
+    for (size_t i = 0, off = 0; i < count; off += lens[i], i++)
+        frames[i] = buf + off;
+
+    PrintAndLogEx(INFO, "%zu frames, %u byte checksum", count, opt->width);
+
+    chksum_hypothesis_t *hyp = NULL;
+    size_t found = 0;
+    uint64_t t1 = msclock();
+    res = chksum_search(frames, lens, count, opt, &hyp, &found);
+    t1 = msclock() - t1;
+
+    if (res == PM3_EINVARG) {
+        PrintAndLogEx(WARNING, "all frames must be longer than the checksum");
+    } else if (res == PM3_SUCCESS) {
+        if (found) {
+            PrintAndLogEx(NORMAL, "");
+            PrintAndLogEx(INFO, "family      | data          | mask   | init   | xorout");
+            PrintAndLogEx(INFO, "------------+---------------+--------+--------+-------");
+        }
+        for (size_t i = 0; i < found; i++) {
+            const chksum_hypothesis_t *h = &hyp[i];
+            char range[20];
+            snprintf(range, sizeof(range), "[%u:-%u]%s", h->skip_head, h->skip_tail + h->width, (h->width == 2) ? (h->le ? " LE" : " BE") : "");
+            PrintAndLogEx(SUCCESS, "%-11s | %-13s | 0x%04X | 0x%04X | 0x%04X"
+                          , chksum_family_name(h->family)
+                          , range
+                          , h->mask
+                          , h->init
+                          , h->xorout
+                         );
+        }
+        if (found == 0)
+            PrintAndLogEx(FAILED, "no checksum fits all frames");
+        PrintAndLogEx(INFO, "%zu hypotheses fit all frames, %" PRIu64 " ms", found, t1);
+    }
+
+    free(hyp);
+    free(frames);
+    free(buf);
+    free(lens);
+    return res;
+}
+
 static int CmdAnalyseCHKSUM(const char *Cmd) {
 
     uint8_t data[50];
@@ -386,7 +592,14 @@ static int CmdAnalyseCHKSUM(const char *Cmd) {
     uint32_t mask = 0xFFFF;
     bool errors = false;
     bool useHeader = false;
+    bool hasMask = false;
     int len = 0;
+    char filename[FILE_PATH_SIZE] = {0};
+    chksum_search_opt_t opt = {
+        .width = 1,
+        .max_head = 8,
+        .max_tail = 4,
+    };
     memset(data, 0x0, sizeof(data));
 
     while (param_getchar(Cmd, cmdp) != 0x00 && !errors) {
@@ -401,6 +614,30 @@ static int CmdAnalyseCHKSUM(const char *Cmd) {
             case 'm':
             case 'M':
                 mask = param_get32ex(Cmd, cmdp + 1, 0, 16);
+                hasMask = true;
+                cmdp += 2;
+                break;
+            case 'f':
+            case 'F':
+                if (param_getstr(Cmd, cmdp + 1, filename, sizeof(filename)) == 0)
+                    errors = true;
+                cmdp += 2;
+                break;
+            case 'w':
+            case 'W':
+                opt.width = param_get8ex(Cmd, cmdp + 1, 1, 10);
+                if (opt.width != 1 && opt.width != 2)
+                    errors = true;
+                cmdp += 2;
+                break;
+            case 's':
+            case 'S':
+                opt.max_head = param_get8ex(Cmd, cmdp + 1, 8, 10);
+                cmdp += 2;
+                break;
+            case 'e':
+            case 'E':
+                opt.max_tail = param_get8ex(Cmd, cmdp + 1, 4, 10);
                 cmdp += 2;
                 break;
             case 'v':
@@ -420,6 +657,15 @@ static int CmdAnalyseCHKSUM(const char *Cmd) {
     //Validations
     if (errors || cmdp == 0) return usage_analyse_checksum();
 
+    if (filename[0]) {
+        if (hasMask) {
+            if (mask == 0 || mask > ((opt.width == 1) ? 0xFF : 0xFFFF))
+                return usage_analyse_checksum();
+            opt.mask = mask;
+        }
+        return analyse_chksum_search(filename, &opt);
+    }
+
     if (useHeader) {
         PrintAndLogEx(NORMAL, "     add          | sub         | add 1's compl    | sub 1's compl   | xor");
         PrintAndLogEx(NORMAL, "byte nibble crumb | byte nibble | byte nibble cumb | byte nibble     | byte nibble cumb |  BSD       |");
@@ -854,6 +1100,88 @@ static void generate4bNUID(uint8_t *uid, uint8_t *nuid) {
     nuid[3] = crc & 0xFF;
 }
 
+// lookups per second, run for about 200 ms
+static double aid_lookups(json_t *root, char **aids, size_t count, bool scan) {
+    uint64_t n = 0, t1 = msclock(), t2 = t1;
+    while (t2 - t1 < 200) {
+        for (size_t i = 0; i < count; i++)
+            (scan) ? AIDSearchScan(root, aids[i]) : AIDSearchFind(root, aids[i]);
+        n += count;
+        t2 = msclock();
+    }
+    return (double)n * 1000 / (t2 - t1);
+}
+
+static int analyse_aid_benchmark(void) {
+    uint64_t t1 = msclock();
+    json_t *root = AIDSearchInit(false);
+    t1 = msclock() - t1;
+    if (root == NULL)
+        return PM3_EFILE;
+
+    // every AID of the list, longer and shorter, and some that aren't in it
+    size_t listed = json_array_size(root);
+    char **aids = calloc(listed * 4, sizeof(char *));
+    if (aids == NULL) {
+        AIDSearchFree(root);
+        return PM3_EMALLOC;
+    }
+
+    size_t count = 0;
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < listed; i++) {
+        const char *aid = json_string_value(json_object_get(AIDSearchGetElm(root, i), "AID"));
+        if (aid == NULL || strlen(aid) < 2)
+            continue;
+
+        size_t len = strlen(aid);
+        aids[count] = calloc(len + 5, sizeof(char));
+        aids[count + 1] = calloc(len + 5, sizeof(char));
+        aids[count + 2] = calloc(len + 5, sizeof(char));
+        aids[count + 3] = calloc(17, sizeof(char));
+        if (aids[count] && aids[count + 1] && aids[count + 2] && aids[count + 3]) {
+            strcpy(aids[count], aid);
+            snprintf(aids[count + 1], len + 5, "%s0102", aid);
+            memcpy(aids[count + 2], aid, len - 2);
+            x = x * 1103515245 + 12345;
+            snprintf(aids[count + 3], 17, "F%07X%08X", x >> 4, x * 69069);
+        }
+        count += 4;
+    }
+
+    size_t same = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (aids[i] && AIDSearchFind(root, aids[i]) == AIDSearchScan(root, aids[i]))
+            same++;
+    }
+
+    double index = aid_lookups(root, aids, count, false);
+    double scan = aid_lookups(root, aids, count, true);
+
+    PrintAndLogEx(INFO, "AID list, %zu records, loaded and indexed in %" PRIu64 " ms", listed, t1);
+    PrintAndLogEx(INFO, "%zu lookups, index and scan agree on %zu: %s", count, same, (same == count) ? _GREEN_("ok") : _RED_("fail"));
+    PrintAndLogEx(INFO, "index  | %12.0f lookups/s", index);
+    PrintAndLogEx(INFO, "scan   | %12.0f lookups/s", scan);
+
+    for (size_t i = 0; i < count; i++)
+        free(aids[i]);
+    free(aids);
+    AIDSearchFree(root);
+    return PM3_SUCCESS;
+}
+
+static int CmdAnalyseAID(const char *Cmd) {
+    char cmdp = tolower(param_getchar(Cmd, 0));
+    if (strlen(Cmd) == 0 || cmdp == 'h') return usage_analyse_aid();
+    if (cmdp == 'b' && param_getlength(Cmd, 0) == 1) return analyse_aid_benchmark();
+
+    uint8_t aid[100] = {0};
+    int len = 0;
+    if (param_gethex_to_eol(Cmd, 0, aid, sizeof(aid), &len) || len == 0) return usage_analyse_aid();
+
+    return PrintAIDDescriptionBuf(NULL, aid, len, true);
+}
+
 static int CmdAnalyseNuid(const char *Cmd) {
     uint8_t nuid[4] = {0};
     uint8_t uid[7] = {0};
@@ -951,6 +1279,7 @@ static command_t CommandTable[] = {
     {"lfsr",    CmdAnalyseLfsr,     AlwaysAvailable, "LFSR tests"},
     {"a",       CmdAnalyseA,        AlwaysAvailable, "num bits test"},
     {"nuid",    CmdAnalyseNuid,     AlwaysAvailable, "create NUID from 7byte UID"},
+    {"aid",     CmdAnalyseAID,      AlwaysAvailable, "Look up an AID in the AID list"},
     {"demodbuff", CmdAnalyseDemodBuffer, AlwaysAvailable, "Load binary string to demodbuffer"},
     {"freq",    CmdAnalyseFreq,     AlwaysAvailable, "Calc wave lengths"},
     {NULL, NULL, NULL, NULL}
@@ -13,6 +13,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <inttypes.h>
 
 #ifdef _WIN32
 #  include <io.h>
@@ -23,8 +24,10 @@
 #endif /* _WIN32 */
 
 #include "reveng.h"
+#include "crcmodels.h"
 #include "ui.h"
 #include "util.h"
+#include "util_posix.h"       // msclock
 #include "pm3_cmd.h"
 
 #define MAX_ARGS 20
@@ -388,135 +391,187 @@ static int CmdrevengTestC(const char *Cmd) {
     return 1;
 }
 */
-//returns a calloced string (needs to be freed)
-static char *SwapEndianStr(const char *inStr, const size_t len, const uint8_t blockSize) {
-    char *tmp = calloc(len + 1, sizeof(char));
-    for (uint8_t block = 0; block < (uint8_t)(len / blockSize); block++) {
-        for (size_t i = 0; i < blockSize; i += 2) {
-            tmp[i + (blockSize * block)] = inStr[(blockSize - 1 - i - 1) + (blockSize * block)];
-            tmp[i + (blockSize * block) + 1] = inStr[(blockSize - 1 - i) + (blockSize * block)];
-        }
+static void PrintMatch(int idx, const char *frame, uint8_t match, bool indent) {
+    const char *name = crc_model_name(idx);
+    // the computed value, as it is at the end of the frame
+    const char *value = frame + strlen(frame) - crc_model_chars(idx);
+
+    if (match & (CRC_MATCH_VALUE | CRC_MATCH_SWAPPED)) {
+        const char *kind = (match & CRC_MATCH_VALUE) ? "value" : "value endian swapped";
+        if (indent)
+            PrintAndLogEx(SUCCESS, "    %s | %s: %s", name, kind, value);
+        else
+            PrintAndLogEx(SUCCESS, "\nfound possible match\nmodel: %s | %s: %s\n", name, kind, value);
+    }
+    if (match & (CRC_MATCH_REV_VALUE | CRC_MATCH_REV_SWAPPED)) {
+        const char *kind = (match & CRC_MATCH_REV_VALUE) ? "value" : "value endian swapped";
+        if (indent)
+            PrintAndLogEx(SUCCESS, "    %s reversed | %s: %s", name, kind, value);
+        else
+            PrintAndLogEx(SUCCESS, "\nfound possible match\nmodel reversed: %s | %s: %s\n", name, kind, value);
     }
-    return tmp;
 }
 
-// takes hex string in and searches for a matching result (hex string must include checksum)
-static int CmdrevengSearch(const char *Cmd) {
-
-#define NMODELS 106
-
-    char inHexStr[256] = {0x00};
-    int dataLen = param_getstr(Cmd, 0, inHexStr, sizeof(inHexStr));
-    if (dataLen < 4) return 0;
+// takes hex strings in and searches for matching models (hex strings must include checksum)
+// One frame prints every match. With more, the matches of each frame and the ones all frames agree on
+static int CmdrevengSearch(char **frames, size_t count) {
 
-    // these two arrays, must match preset size.
-    char *Models[NMODELS];
-    uint8_t width[NMODELS] = {0};
-    int count = 0;
-
-    char result[30];
-    char revResult[30];
-    int ans = GetModels(Models, &count, width);
-    bool found = false;
-    if (!ans) {
-        for (int i = 0; i < count; i++) {
-            free(Models[i]);
+    for (size_t i = 0; i < count; i++) {
+        for (char *p = frames[i]; *p; p++) {
+            if (isxdigit((unsigned char)*p) == 0) {
+                PrintAndLogEx(ERR, "error: frame %zu is not a hex string", i + 1);
+                return PM3_EINVARG;
+            }
+            *p = tolower((unsigned char)*p);
         }
-        return 0;
     }
 
-    // try each model and get result
-    for (int i = 0; i < count; i++) {
-        /*if (found) {
-            free(Models[i]);
-            continue;
-        }*/
-        // round up to # of characters in this model's crc
-        uint8_t crcChars = ((width[i] + 7) / 8) * 2;
-        // can't test a model that has more crc digits than our data
-        if (crcChars >= dataLen) {
-            free(Models[i]);
-            continue;
-        }
-
-        PrintAndLogEx(DEBUG
-                      , "DEBUG: dataLen %d, crcChars %u,  width[i] %u"
-                      , dataLen
-                      , crcChars
-                      , width[i]
-                     );
+    if (count == 0 || (count == 1 && strlen(frames[0]) < 4))
+        return PM3_EINVARG;
 
-        if (crcChars == 0) {
-            free(Models[i]);
-            continue;
+    for (size_t i = 0; i < count; i++) {
+        if (strlen(frames[i]) < 4) {
+            PrintAndLogEx(ERR, "error: frame %zu is too short", i + 1);
+            return PM3_EINVARG;
         }
+    }
 
-        memset(result, 0, 30);
-        char *inCRC = calloc(crcChars + 1, sizeof(char));
-        memcpy(inCRC, inHexStr + (dataLen - crcChars), crcChars);
+    int nmodels = crc_models_count();
+    if (nmodels == 0) {
+        PrintAndLogEx(WARNING, "no preset models available");
+        return PM3_ESOFT;
+    }
 
-        char *outHex = calloc(dataLen - crcChars + 1, sizeof(char));
-        memcpy(outHex, inHexStr, dataLen - crcChars);
+    uint8_t *hits = calloc(count * nmodels, sizeof(uint8_t));
+    if (hits == NULL) {
+        PrintAndLogEx(WARNING, "out of memory?");
+        return PM3_EMALLOC;
+    }
+
+    uint64_t t1 = msclock();
+    int res = crc_search((const char **)frames, count, num_CPUs(), hits);
+    if (res != PM3_SUCCESS) {
+        free(hits);
+        return res;
+    }
+    t1 = msclock() - t1;
 
-        ans = RunModel(Models[i], outHex, false, 0, result);
-        if (ans) {
-            // test for match
-            if (memcmp(result, inCRC, crcChars) == 0) {
-                PrintAndLogEx(SUCCESS, "\nfound possible match\nmodel: %s | value: %s\n", Models[i], result);
-                //optional - stop searching if found...
+    if (count == 1) {
+        bool found = false;
+        for (int m = 0; m < nmodels; m++) {
+            if (hits[m]) {
+                PrintMatch(m, frames[0], hits[m], false);
                 found = true;
-            } else {
-                if (crcChars > 2) {
-                    char *swapEndian = SwapEndianStr(result, crcChars, crcChars);
-                    if (memcmp(swapEndian, inCRC, crcChars) == 0) {
-                        PrintAndLogEx(SUCCESS, "\nfound possible match\nmodel: %s | value endian swapped: %s\n", Models[i], swapEndian);
-                        // optional - stop searching if found...
-                        found = true;
-                    }
-                    free(swapEndian);
-                }
             }
         }
-        ans = RunModel(Models[i], outHex, true, 0, revResult);
-        if (ans) {
-            // test for match
-            if (memcmp(revResult, inCRC, crcChars) == 0) {
-                PrintAndLogEx(SUCCESS, "\nfound possible match\nmodel reversed: %s | value: %s\n", Models[i], revResult);
-                // optional - stop searching if found...
+        if (found == false)
+            PrintAndLogEx(FAILED, "\nno matches found\n");
+        free(hits);
+        return PM3_SUCCESS;
+    }
+
+    for (size_t f = 0; f < count; f++) {
+        PrintAndLogEx(INFO, "frame " _YELLOW_("%zu") " | %s", f + 1, frames[f]);
+        bool found = false;
+        for (int m = 0; m < nmodels; m++) {
+            if (hits[f * nmodels + m]) {
+                PrintMatch(m, frames[f], hits[f * nmodels + m], true);
                 found = true;
-            } else {
-                if (crcChars > 2) {
-                    char *swapEndian = SwapEndianStr(revResult, crcChars, crcChars);
-                    if (memcmp(swapEndian, inCRC, crcChars) == 0) {
-                        PrintAndLogEx(SUCCESS, "\nfound possible match\nmodel reversed: %s | value endian swapped: %s\n", Models[i], swapEndian);
-                        // optional - stop searching if found...
-                        found = true;
-                    }
-                    free(swapEndian);
-                }
             }
         }
-        free(inCRC);
-        free(outHex);
-        free(Models[i]);
+        if (found == false)
+            PrintAndLogEx(FAILED, "    no matches found");
     }
 
+    PrintAndLogEx(NORMAL, "");
+    PrintAndLogEx(INFO, "matching all " _YELLOW_("%zu") " frames", count);
+    bool found = false;
+    for (int m = 0; m < nmodels; m++) {
+        uint8_t all = 0xFF;
+        for (size_t f = 0; f < count; f++)
+            all &= hits[f * nmodels + m];
+        if (all & (CRC_MATCH_VALUE | CRC_MATCH_SWAPPED))
+            PrintAndLogEx(SUCCESS, "    " _GREEN_("%s") "%s", crc_model_name(m), (all & CRC_MATCH_VALUE) ? "" : " | endian swapped");
+        if (all & (CRC_MATCH_REV_VALUE | CRC_MATCH_REV_SWAPPED))
+            PrintAndLogEx(SUCCESS, "    " _GREEN_("%s") " reversed%s", crc_model_name(m), (all & CRC_MATCH_REV_VALUE) ? "" : " | endian swapped");
+        found |= (all != 0);
+    }
     if (found == false)
-        PrintAndLogEx(FAILED, "\nno matches found\n");
+        PrintAndLogEx(FAILED, "    no model matches all frames");
 
+    PrintAndLogEx(INFO, "%d models, %zu frames in %" PRIu64 " ms", nmodels, count, t1);
+    free(hits);
+    return PM3_SUCCESS;
+}
+
+// one hex frame per line, # comments
+static int LoadFrames(const char *filename, char ***frames, size_t *count) {
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        PrintAndLogEx(ERR, "Error: Could not open file ["_YELLOW_("%s")"]", filename);
+        return PM3_EFILE;
+    }
+
+    size_t cap = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+
+        // skip comments and empty lines
+        char *p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '#' || *p == '\0')
+            continue;
+
+        size_t len = 0;
+        while (p[len] && isspace((unsigned char)p[len]) == 0)
+            len++;
+
+        if (*count == cap) {
+            cap = cap ? cap * 2 : 64;
+            char **tmp = realloc(*frames, cap * sizeof(char *));
+            if (tmp == NULL) {
+                fclose(f);
+                return PM3_EMALLOC;
+            }
+            *frames = tmp;
+        }
+
+        char *frame = calloc(len + 1, sizeof(char));
+        if (frame == NULL) {
+            fclose(f);
+            return PM3_EMALLOC;
+        }
+        memcpy(frame, p, len);
+        (*frames)[(*count)++] = frame;
+    }
+    fclose(f);
+
+    if (*count == 0) {
+        PrintAndLogEx(WARNING, "no frames in file ["_YELLOW_("%s")"]", filename);
+        return PM3_EINVARG;
+    }
     return PM3_SUCCESS;
 }
 
 int CmdCrc(const char *Cmd) {
-    char c[100 + 7];
+    char c[1024 + 7];
     snprintf(c, sizeof(c), "reveng ");
-    snprintf(c + strlen(c), sizeof(c) - strlen(c), Cmd, strlen(Cmd));
+    snprintf(c + strlen(c), sizeof(c) - strlen(c), "%s", Cmd);
 
     char *argv[MAX_ARGS];
     int argc = split(c, argv);
 
-    if (argc == 3 && memcmp(argv[1], "-g", 2) == 0) {
-        CmdrevengSearch(argv[2]);
+    if (argc == 4 && strcmp(argv[1], "-g") == 0 && strcmp(argv[2], "-f") == 0) {
+        char **frames = NULL;
+        size_t count = 0;
+        if (LoadFrames(argv[3], &frames, &count) == PM3_SUCCESS)
+            CmdrevengSearch(frames, count);
+        for (size_t i = 0; i < count; i++)
+            free(frames[i]);
+        free(frames);
+    } else if (argc >= 3 && memcmp(argv[1], "-g", 2) == 0) {
+        CmdrevengSearch(argv + 2, argc - 2);
     } else {
         reveng_main(argc, argv);
     }
@@ -526,4 +581,3 @@ int CmdCrc(const char *Cmd) {
     }
     return PM3_SUCCESS;
 }
-
@@ -15,6 +15,13 @@
 #include <limits.h>   // for CmdNorm INT_MIN && INT_MAX
 #include <math.h>     // pow
 #include <ctype.h>    // tolower
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include "commonutil.h"          // ARRAYLEN
 #include "cmdparser.h"           // for command_t
 #include "ui.h"                  // for show graph controls
@@ -28,11 +35,9 @@
 #include "mifare/ndef.h"
 #include "cliparser.h"
 #include "cmdlft55xx.h"          // print...
-
-uint8_t DemodBuffer[MAX_DEMOD_BUF_LEN];
-size_t DemodBufferLen = 0;
-int32_t g_DemodStartIdx = 0;
-int g_DemodClock = 0;
+#include "fft.h"                 // fft_autocorr
+#include "util_posix.h"          // msclock
+#include "bigbuf_lz4.h"          // compressed samples download
 
 static int CmdHelp(const char *Cmd);
 
@@ -215,11 +220,28 @@ static int usage_data_rawdemod_p2(void) {
 }
 static int usage_data_autocorr(void) {
     PrintAndLogEx(NORMAL, "Autocorrelate is used to detect repeating sequences. We use it as detection of length in bits a message inside the signal is");
-    PrintAndLogEx(NORMAL, "Usage: data autocorr w <window> [g]");
+    PrintAndLogEx(NORMAL, "Usage: data autocorr w <window> [g] [b]");
     PrintAndLogEx(NORMAL, "Options:");
     PrintAndLogEx(NORMAL, "       h              This help");
     PrintAndLogEx(NORMAL, "       w <window>     window length for correlation - default = 4000");
     PrintAndLogEx(NORMAL, "       g              save back to GraphBuffer (overwrite)");
+    PrintAndLogEx(NORMAL, "       b              benchmark FFT against direct correlation");
+    return PM3_SUCCESS;
+}
+static int usage_data_samples(void) {
+    PrintAndLogEx(NORMAL, "Get raw samples for graph window (GraphBuffer) from device.");
+    PrintAndLogEx(NORMAL, "Firmwares that can, send them LZ4 compressed.");
+    PrintAndLogEx(NORMAL, "Usage: data samples [h] [d] [<bytes>] [t]");
+    PrintAndLogEx(NORMAL, "Options:");
+    PrintAndLogEx(NORMAL, "       h              This help");
+    PrintAndLogEx(NORMAL, "       d              delta code the samples before compressing, smaller for smooth signals");
+    PrintAndLogEx(NORMAL, "       <bytes>        number of bytes to download (def: all of BigBuf)");
+    PrintAndLogEx(NORMAL, "       t              offline round trip of the graph buffer through the compressed download");
+    PrintAndLogEx(NORMAL, "");
+    PrintAndLogEx(NORMAL, "Examples:");
+    PrintAndLogEx(NORMAL, "       data samples 12000");
+    PrintAndLogEx(NORMAL, "       data samples d 12000");
+    PrintAndLogEx(NORMAL, "       data load -f traces/lf_EM4102-1.pm3; data samples t");
     return PM3_SUCCESS;
 }
 static int usage_data_detectclock(void) {
@@ -275,6 +297,12 @@ void setDemodBuff(uint8_t *buff, size_t size, size_t start_idx) {
     DemodBufferLen = size;
 }
 
+// error bits the raw demod left among the bits it put in the demod buffer
+void setDemodErrors(int errors, size_t bits) {
+    demod_ctx()->demod_errors = (errors > 0) ? errors : 0;
+    demod_ctx()->demod_bits = bits;
+}
+
 bool getDemodBuff(uint8_t *buff, size_t *size) {
     if (buff == NULL) return false;
     if (size == NULL) return false;
@@ -366,25 +394,25 @@ static double compute_autoc(const int *data, size_t n, int lag) {
 
 // option '1' to save DemodBuffer any other to restore
 void save_restoreDB(uint8_t saveOpt) {
-    static uint8_t SavedDB[MAX_DEMOD_BUF_LEN];
-    static size_t SavedDBlen;
-    static bool DB_Saved = false;
-    static size_t savedDemodStartIdx = 0;
-    static int savedDemodClock = 0;
+    demod_ctx_t *ctx = demod_ctx();
 
     if (saveOpt == GRAPH_SAVE) { //save
 
-        memcpy(SavedDB, DemodBuffer, sizeof(DemodBuffer));
-        SavedDBlen = DemodBufferLen;
-        DB_Saved = true;
-        savedDemodStartIdx = g_DemodStartIdx;
-        savedDemodClock = g_DemodClock;
-    } else if (DB_Saved) { //restore
+        if (ctx->saved_demod == NULL) {
+            ctx->saved_demod = calloc(MAX_DEMOD_BUF_LEN, sizeof(uint8_t));
+            if (ctx->saved_demod == NULL)
+                return;
+        }
+        memcpy(ctx->saved_demod, DemodBuffer, sizeof(DemodBuffer));
+        ctx->saved_demod_len = DemodBufferLen;
+        ctx->saved_demod_start_idx = g_DemodStartIdx;
+        ctx->saved_demod_clock = g_DemodClock;
+    } else if (ctx->saved_demod) { //restore
 
-        memcpy(DemodBuffer, SavedDB, sizeof(DemodBuffer));
-        DemodBufferLen = SavedDBlen;
-        g_DemodClock = savedDemodClock;
-        g_DemodStartIdx = savedDemodStartIdx;
+        memcpy(DemodBuffer, ctx->saved_demod, sizeof(DemodBuffer));
+        DemodBufferLen = ctx->saved_demod_len;
+        g_DemodClock = ctx->saved_demod_clock;
+        g_DemodStartIdx = ctx->saved_demod_start_idx;
     }
 }
 
@@ -500,6 +528,7 @@ int CmdGetBitStream(const char *Cmd) {
     for (uint32_t i = 0; i < GraphTraceLen; i++)
         GraphBuffer[i] = (GraphBuffer[i] >= 1) ? 1 : 0;
 
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
@@ -526,7 +555,7 @@ int ASKDemod_ext(int clk, int invert, int maxErr, size_t maxLen, bool amplify, b
 
     if (!maxLen) maxLen = pm3_capabilities.bigbuf_size;
 
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN, sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         return PM3_EMALLOC;
     }
@@ -536,7 +565,6 @@ int ASKDemod_ext(int clk, int invert, int maxErr, size_t maxLen, bool amplify, b
     PrintAndLogEx(DEBUG, "DEBUG: (ASKDemod_ext) #samples from graphbuff: %zu", BitLen);
 
     if (BitLen < 255) {
-        free(bits);
         return PM3_ESOFT;
     }
 
@@ -544,6 +572,9 @@ int ASKDemod_ext(int clk, int invert, int maxErr, size_t maxLen, bool amplify, b
 
     int foundclk = 0;
 
+    // edges of the samples as they came from the graph
+    const lf_waves_t *waves = (amplify) ? NULL : getGraphWaves(bits, BitLen);
+
     //amplify signal before ST check
     if (amplify) {
         askAmp(bits, BitLen);
@@ -551,7 +582,7 @@ int ASKDemod_ext(int clk, int invert, int maxErr, size_t maxLen, bool amplify, b
 
     size_t ststart = 0, stend = 0;
 //    if (*stCheck)
-    bool st = DetectST(bits, &BitLen, &foundclk, &ststart, &stend);
+    bool st = DetectST(bits, &BitLen, &foundclk, &ststart, &stend, waves);
 
     if (clk == 0) {
         if (foundclk == 32 || foundclk == 64) {
@@ -561,24 +592,25 @@ int ASKDemod_ext(int clk, int invert, int maxErr, size_t maxLen, bool amplify, b
 
     if (st) {
         *stCheck = st;
-        CursorCPos = ststart;
-        CursorDPos = stend;
+        if (demod_ctx_is_default()) {
+            CursorCPos = ststart;
+            CursorDPos = stend;
+        }
         if (verbose)
             PrintAndLogEx(DEBUG, "Found Sequence Terminator - First one is shown by orange / blue graph markers");
     }
 
     int startIdx = 0;
-    int errCnt = askdemod_ext(bits, &BitLen, &clk, &invert, maxErr, askamp, askType, &startIdx);
+    // a sequence terminator is cut out of the samples
+    int errCnt = askdemod_ext(bits, &BitLen, &clk, &invert, maxErr, askamp, askType, &startIdx, (st) ? NULL : waves);
 
     if (errCnt < 0 || BitLen < 16) { //if fatal error (or -1)
         PrintAndLogEx(DEBUG, "DEBUG: (ASKDemod_ext) No data found errors:%d, invert:%c, bitlen:%zu, clock:%d", errCnt, (invert) ? 'Y' : 'N', BitLen, clk);
-        free(bits);
         return PM3_ESOFT;
     }
 
     if (errCnt > maxErr) {
         PrintAndLogEx(DEBUG, "DEBUG: (ASKDemod_ext) Too many errors found, errors:%d, bits:%zu, clock:%d", errCnt, BitLen, clk);
-        free(bits);
         return PM3_ESOFT;
     }
 
@@ -586,6 +618,7 @@ int ASKDemod_ext(int clk, int invert, int maxErr, size_t maxLen, bool amplify, b
 
     //output
     setDemodBuff(bits, BitLen, 0);
+    setDemodErrors(errCnt, BitLen);
     setClockGrid(clk, startIdx);
 
     if (verbose) {
@@ -603,7 +636,6 @@ int ASKDemod_ext(int clk, int invert, int maxErr, size_t maxLen, bool amplify, b
     if (emSearch)
         AskEm410xDecode(true, &hi, &lo);
 
-    free(bits);
     return PM3_SUCCESS;
 }
 int ASKDemod(int clk, int invert, int maxErr, size_t maxLen, bool amplify, bool verbose, bool emSearch, uint8_t askType) {
@@ -763,18 +795,19 @@ int ASKbiphaseDemod(int offset, int clk, int invert, int maxErr, bool verbose) {
     //ask raw demod GraphBuffer first
 
     uint8_t BitStream[MAX_DEMOD_BUF_LEN];
-    size_t size = getFromGraphBuf(BitStream);
+    size_t size = getFromGraphBufEx(BitStream, sizeof(BitStream));
     if (size == 0) {
         PrintAndLogEx(DEBUG, "DEBUG: no data in graphbuf");
         return PM3_ESOFT;
     }
     int startIdx = 0;
     //invert here inverts the ask raw demoded bits which has no effect on the demod, but we need the pointer
-    int errCnt = askdemod_ext(BitStream, &size, &clk, &invert, maxErr, 0, 0, &startIdx);
+    int errCnt = askdemod_ext(BitStream, &size, &clk, &invert, maxErr, 0, 0, &startIdx, getGraphWaves(BitStream, size));
     if (errCnt < 0 || errCnt > maxErr) {
         PrintAndLogEx(DEBUG, "DEBUG: no data or error found %d, clock: %d", errCnt, clk);
         return PM3_ESOFT;
     }
+    int askErrCnt = errCnt;
 
     //attempt to Biphase decode BitStream
     errCnt = BiphaseRawDecode(BitStream, &size, &offset, invert);
@@ -789,6 +822,7 @@ int ASKbiphaseDemod(int offset, int clk, int invert, int maxErr, bool verbose) {
 
     //success set DemodBuffer and return
     setDemodBuff(BitStream, size, 0);
+    setDemodErrors(askErrCnt + errCnt, size);
     setClockGrid(clk, startIdx + clk * offset / 2);
     if (g_debugMode || verbose) {
         PrintAndLogEx(DEBUG, "Biphase Decoded using offset %d | clock %d | #errors %d | start index %d\ndata\n", offset, clk, errCnt, (startIdx + clk * offset / 2));
@@ -829,30 +863,49 @@ static int Cmdaskrawdemod(const char *Cmd) {
     return ASKDemod_ext(clk, invert, maxErr, maxLen, amplify, true, false, 0, &st);
 }
 
-int AutoCorrelate(const int *in, int *out, size_t len, size_t window, bool SaveGrph, bool verbose) {
-    // sanity check
-    if (window > len) window = len;
+// autocorrelation sums straight from the definition, O(len * lags). Reference for `data autocorr b`
+static void autocorr_sums_naive(const int *in, size_t len, double mean, double *sums, size_t lags) {
+    for (size_t i = 0; i < lags; ++i) {
+        double autocv = 0.0;
+        for (size_t j = 0; j < (len - i); j++) {
+            autocv += (in[j] - mean) * (in[j + i] - mean);
+        }
+        sums[i] = autocv;
+    }
+}
 
-    if (verbose) PrintAndLogEx(INFO, "performing " _YELLOW_("%zu") " correlations", GraphTraceLen - window);
+// fills correl_buf with the autocovariance of the first len - window lags,
+// returns the distance between the last two lags correlating above the variance
+static size_t autocorr_buffer(const int *in, size_t len, size_t window, int *correl_buf, bool naive) {
 
-    //test
-    double autocv = 0.0;    // Autocovariance value
-    size_t correlation = 0;
-    int lastmax = 0;
+    size_t lags = len - window;
+    if (lags == 0)
+        return 0;
+
+    double *sums = calloc(lags, sizeof(double));
+    if (sums == NULL)
+        return 0;
 
     // in, len, 4000
     double mean = compute_mean(in, len);
     // Computed variance
     double variance = compute_variance(in, len);
 
-    int *correl_buf = calloc(MAX_GRAPH_TRACE_LEN, sizeof(int));
+    if (naive) {
+        autocorr_sums_naive(in, len, mean, sums, lags);
+    } else if (fft_autocorr(demod_ctx_fft_plan(demod_ctx(), fft_size(2 * len)), in, len, mean, FFT_WINDOW_NONE, sums, lags) != PM3_SUCCESS) {
+        PrintAndLogEx(WARNING, "failed to allocate memory, falling back to direct correlation");
+        autocorr_sums_naive(in, len, mean, sums, lags);
+    }
+
+    double autocv = 0.0;    // Autocovariance value
+    size_t correlation = 0;
+    int lastmax = 0;
 
-    for (size_t i = 0; i < len - window; ++i) {
+    for (size_t i = 0; i < lags; ++i) {
 
-        for (size_t j = 0; j < (len - i); j++) {
-            autocv += (in[j] - mean) * (in[j + i] - mean);
-        }
-        autocv = (1.0 / (len - i)) * autocv;
+        // the running value isn't reset between lags
+        autocv = (1.0 / (len - i)) * (autocv + sums[i]);
 
         correl_buf[i] = autocv;
 
@@ -867,6 +920,22 @@ int AutoCorrelate(const int *in, int *out, size_t len, size_t window, bool SaveG
         }
     }
 
+    free(sums);
+    return correlation;
+}
+
+int AutoCorrelate(const int *in, int *out, size_t len, size_t window, bool SaveGrph, bool verbose) {
+    // sanity check
+    if (window > len) window = len;
+
+    if (verbose) PrintAndLogEx(INFO, "performing " _YELLOW_("%zu") " correlations", GraphTraceLen - window);
+
+    int *correl_buf = calloc(len + 1, sizeof(int));
+    if (correl_buf == NULL)
+        return 0;
+
+    size_t correlation = autocorr_buffer(in, len, window, correl_buf, false);
+
     //
     int hi = 0, idx = 0;
     int distance = 0, hi_1 = 0, idx_1 = 0;
@@ -900,6 +969,7 @@ int AutoCorrelate(const int *in, int *out, size_t len, size_t window, bool SaveG
     if (SaveGrph) {
         //GraphTraceLen = GraphTraceLen - window;
         memcpy(out, correl_buf, len * sizeof(int));
+        demod_ctx_touch(demod_ctx());
         if (distance > 0) {
             setClockGrid(distance, idx);
             retval = distance;
@@ -915,11 +985,52 @@ int AutoCorrelate(const int *in, int *out, size_t len, size_t window, bool SaveG
     return retval;
 }
 
+// times both correlation engines on the same samples and compares their output
+static int autocorr_benchmark(const int *in, size_t len, size_t window) {
+    if (window > len) window = len;
+
+    int *naive = calloc(MAX(len, 1), sizeof(int));
+    int *fast = calloc(MAX(len, 1), sizeof(int));
+    if (naive == NULL || fast == NULL) {
+        PrintAndLogEx(WARNING, "failed to allocate memory");
+        free(naive);
+        free(fast);
+        return PM3_EMALLOC;
+    }
+
+    uint64_t t1 = msclock();
+    size_t corr_fft = autocorr_buffer(in, len, window, fast, false);
+    uint64_t t_fft = msclock() - t1;
+
+    t1 = msclock();
+    size_t corr_naive = autocorr_buffer(in, len, window, naive, true);
+    uint64_t t_naive = msclock() - t1;
+
+    int maxdiff = 0;
+    for (size_t i = 0; i < len - window; i++) {
+        maxdiff = MAX(maxdiff, ABS(naive[i] - fast[i]));
+    }
+
+    PrintAndLogEx(INFO, "%zu samples, %zu lags", len, len - window);
+    PrintAndLogEx(INFO, "direct  " _YELLOW_("%6" PRIu64) " ms", t_naive);
+    PrintAndLogEx(INFO, "fft     " _YELLOW_("%6" PRIu64) " ms  ( x%.1f )", t_fft, (double)t_naive / MAX(t_fft, 1));
+    PrintAndLogEx(INFO, "largest difference %d", maxdiff);
+    if (corr_fft == corr_naive)
+        PrintAndLogEx(SUCCESS, "correlation " _GREEN_("matches") " ( %zu samples )", corr_fft);
+    else
+        PrintAndLogEx(FAILED, "correlation " _RED_("differs") " ( fft %zu, direct %zu )", corr_fft, corr_naive);
+
+    free(naive);
+    free(fast);
+    return PM3_SUCCESS;
+}
+
 static int CmdAutoCorr(const char *Cmd) {
 
     uint32_t window = 4000;
     uint8_t cmdp = 0;
     bool updateGrph = false;
+    bool benchmark = false;
     bool errors = false;
 
     while (param_getchar(Cmd, cmdp) != 0x00 && !errors) {
@@ -930,6 +1041,10 @@ static int CmdAutoCorr(const char *Cmd) {
                 updateGrph = true;
                 cmdp++;
                 break;
+            case 'b':
+                benchmark = true;
+                cmdp++;
+                break;
             case 'w':
                 window = param_get32ex(Cmd, cmdp + 1, 4000, 10);
                 if (window >= GraphTraceLen) {
@@ -947,6 +1062,9 @@ static int CmdAutoCorr(const char *Cmd) {
     //Validations
     if (errors || cmdp == 0) return usage_data_autocorr();
 
+    if (benchmark)
+        return autocorr_benchmark(GraphBuffer, GraphTraceLen, window);
+
     AutoCorrelate(GraphBuffer, GraphBuffer, GraphTraceLen, window, updateGrph, true);
 
     return PM3_SUCCESS;
@@ -962,6 +1080,9 @@ static int CmdBitsamples(const char *Cmd) {
         return PM3_ETIMEOUT;
     }
 
+    if (reserveGraphBuf(sizeof(got) * 8) == false)
+        return PM3_EMALLOC;
+
     for (size_t j = 0; j < ARRAYLEN(got); j++) {
         for (uint8_t k = 0; k < 8; k++) {
             if (got[j] & (1 << (7 - k)))
@@ -971,6 +1092,7 @@ static int CmdBitsamples(const char *Cmd) {
         }
     }
     GraphTraceLen = cnt;
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
@@ -1007,6 +1129,7 @@ static int CmdDecimate(const char *Cmd) {
         GraphBuffer[i] = GraphBuffer[i * n];
 
     GraphTraceLen /= n;
+    demod_ctx_touch(demod_ctx());
     PrintAndLogEx(SUCCESS, "decimated by " _GREEN_("%u"), n);
     RepaintGraphWindow();
     return PM3_SUCCESS;
@@ -1035,15 +1158,27 @@ static int CmdUndecimate(const char *Cmd) {
     int factor = arg_get_int_def(ctx, 1, 2);
     CLIParserFree(ctx);
 
-    //We have memory, don't we?
-    int swap[MAX_GRAPH_TRACE_LEN] = {0};
-    uint32_t g_index = 0, s_index = 0;
-    while (g_index < GraphTraceLen && s_index + factor < MAX_GRAPH_TRACE_LEN) {
+    if (factor < 2) {
+        PrintAndLogEx(WARNING, "factor must be 2 or more");
+        return PM3_EINVARG;
+    }
+
+    size_t swaplen = GraphTraceLen * factor;
+    int *swap = calloc(MAX(swaplen, 1), sizeof(int));
+    if (swap == NULL || reserveGraphBuf(swaplen) == false) {
+        free(swap);
+        return PM3_EMALLOC;
+    }
+
+    size_t g_index = 0, s_index = 0;
+    while (g_index < GraphTraceLen) {
+        // last sample has nothing to ramp to
+        int next = (g_index + 1 < GraphTraceLen) ? GraphBuffer[g_index + 1] : GraphBuffer[g_index];
         int count = 0;
-        for (count = 0; count < factor && s_index + count < MAX_GRAPH_TRACE_LEN; count++) {
+        for (count = 0; count < factor; count++) {
             swap[s_index + count] = (
                                         (double)(factor - count) / (factor - 1)) * GraphBuffer[g_index] +
-                                    ((double)count / factor) * GraphBuffer[g_index + 1]
+                                    ((double)count / factor) * next
                                     ;
         }
         s_index += count;
@@ -1051,7 +1186,9 @@ static int CmdUndecimate(const char *Cmd) {
     }
 
     memcpy(GraphBuffer, swap, s_index * sizeof(int));
+    free(swap);
     GraphTraceLen = s_index;
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
@@ -1098,6 +1235,7 @@ static int CmdAskEdgeDetect(const char *Cmd) {
     sscanf(Cmd, "%i", &thresLen);
 
     ans = AskEdgeDetect(GraphBuffer, GraphBuffer, GraphTraceLen, thresLen);
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
     return ans;
 }
@@ -1133,7 +1271,7 @@ static int CmdDetectClockRate(const char *Cmd) {
 }
 
 static char *GetFSKType(uint8_t fchigh, uint8_t fclow, uint8_t invert) {
-    static char fType[8];
+    static __thread char fType[8];
     memset(fType, 0x00, 8);
     char *fskType = fType;
 
@@ -1166,20 +1304,21 @@ int FSKrawDemod(uint8_t rfLen, uint8_t invert, uint8_t fchigh, uint8_t fclow, bo
     if (getSignalProperties()->isnoise)
         return PM3_ESOFT;
 
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN, sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         return PM3_EMALLOC;
     }
 
     size_t BitLen = getFromGraphBuf(bits);
     if (BitLen == 0) {
-        free(bits);
         return PM3_ESOFT;
     }
 
+    const lf_waves_t *waves = getGraphWaves(bits, BitLen);
+
     //get field clock lengths
     if (!fchigh || !fclow) {
-        uint16_t fcs = countFC(bits, BitLen, true);
+        uint16_t fcs = countFC(bits, BitLen, true, waves);
         if (!fcs) {
             fchigh = 10;
             fclow = 8;
@@ -1191,13 +1330,14 @@ int FSKrawDemod(uint8_t rfLen, uint8_t invert, uint8_t fchigh, uint8_t fclow, bo
     //get bit clock length
     if (!rfLen) {
         int firstClockEdge = 0; //todo - align grid on graph with this...
-        rfLen = detectFSKClk(bits, BitLen, fchigh, fclow, &firstClockEdge);
+        rfLen = detectFSKClk(bits, BitLen, fchigh, fclow, &firstClockEdge, waves);
         if (!rfLen) rfLen = 50;
     }
     int startIdx = 0;
-    int size = fskdemod(bits, BitLen, rfLen, invert, fchigh, fclow, &startIdx);
+    int size = fskdemod(bits, BitLen, rfLen, invert, fchigh, fclow, &startIdx, waves);
     if (size > 0) {
         setDemodBuff(bits, size, 0);
+        setDemodErrors(0, size);
         setClockGrid(rfLen, startIdx);
 
         // Now output the bitstream to the scrollback by line of 16 bits
@@ -1212,7 +1352,6 @@ int FSKrawDemod(uint8_t rfLen, uint8_t invert, uint8_t fchigh, uint8_t fclow, bo
     }
 
 out:
-    free(bits);
     return PM3_SUCCESS;
 }
 
@@ -1247,26 +1386,23 @@ int PSKDemod(int clk, int invert, int maxErr, bool verbose) {
     if (getSignalProperties()->isnoise)
         return PM3_ESOFT;
 
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN, sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         return PM3_EMALLOC;
     }
     size_t bitlen = getFromGraphBuf(bits);
     if (bitlen == 0) {
-        free(bits);
         return PM3_ESOFT;
     }
 
     int startIdx = 0;
-    int errCnt = pskRawDemod_ext(bits, &bitlen, &clk, &invert, &startIdx);
+    int errCnt = pskRawDemod_ext(bits, &bitlen, &clk, &invert, &startIdx, getGraphWaves(bits, bitlen));
     if (errCnt > maxErr) {
         if (g_debugMode || verbose) PrintAndLogEx(DEBUG, "DEBUG: (PSKdemod) Too many errors found, clk: %d, invert: %d, numbits: %zu, errCnt: %d", clk, invert, bitlen, errCnt);
-        free(bits);
         return PM3_ESOFT;
     }
     if (errCnt < 0 || bitlen < 16) { //throw away static - allow 1 and -1 (in case of threshold command first)
         if (g_debugMode || verbose) PrintAndLogEx(DEBUG, "DEBUG: (PSKdemod) no data found, clk: %d, invert: %d, numbits: %zu, errCnt: %d", clk, invert, bitlen, errCnt);
-        free(bits);
         return PM3_ESOFT;
     }
     if (verbose || g_debugMode) {
@@ -1277,8 +1413,8 @@ int PSKDemod(int clk, int invert, int maxErr, bool verbose) {
     }
     //prime demod buffer for output
     setDemodBuff(bits, bitlen, 0);
+    setDemodErrors(errCnt, bitlen);
     setClockGrid(clk, startIdx);
-    free(bits);
     return PM3_SUCCESS;
 }
 
@@ -1293,7 +1429,7 @@ int NRZrawDemod(int clk, int invert, int maxErr, bool verbose) {
     if (getSignalProperties()->isnoise)
         return PM3_ESOFT;
 
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN, sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         return PM3_EMALLOC;
     }
@@ -1301,25 +1437,23 @@ int NRZrawDemod(int clk, int invert, int maxErr, bool verbose) {
     size_t BitLen = getFromGraphBuf(bits);
 
     if (BitLen == 0) {
-        free(bits);
         return PM3_ESOFT;
     }
 
     errCnt = nrzRawDemod(bits, &BitLen, &clk, &invert, &clkStartIdx);
     if (errCnt > maxErr) {
         PrintAndLogEx(DEBUG, "DEBUG: (NRZrawDemod) Too many errors found, clk: %d, invert: %d, numbits: %zu, errCnt: %d", clk, invert, BitLen, errCnt);
-        free(bits);
         return PM3_ESOFT;
     }
     if (errCnt < 0 || BitLen < 16) { //throw away static - allow 1 and -1 (in case of threshold command first)
         PrintAndLogEx(DEBUG, "DEBUG: (NRZrawDemod) no data found, clk: %d, invert: %d, numbits: %zu, errCnt: %d", clk, invert, BitLen, errCnt);
-        free(bits);
         return PM3_ESOFT;
     }
 
     if (verbose || g_debugMode) PrintAndLogEx(DEBUG, "DEBUG: (NRZrawDemod) Tried NRZ Demod using Clock: %d - invert: %d - Bits Found: %zu", clk, invert, BitLen);
     //prime demod buffer for output
     setDemodBuff(bits, BitLen, 0);
+    setDemodErrors(errCnt, BitLen);
     setClockGrid(clk, clkStartIdx);
 
 
@@ -1330,7 +1464,6 @@ int NRZrawDemod(int clk, int invert, int maxErr, bool verbose) {
         printDemodBuff();
     }
 
-    free(bits);
     return PM3_SUCCESS;
 }
 
@@ -1436,6 +1569,9 @@ void setClockGrid(uint32_t clk, int offset) {
     else
         PrintAndLogEx(DEBUG, "DEBUG: (setClockGrid) demodoffset %d, clk %d", offset, clk);
 
+    // the plot only follows the default context
+    if (demod_ctx_is_default() == false) return;
+
     if (offset > clk) offset %= clk;
     if (offset < 0) offset += clk;
 
@@ -1523,34 +1659,131 @@ static int CmdHide(const char *Cmd) {
 //zero mean GraphBuffer
 int CmdHpf(const char *Cmd) {
     (void)Cmd; // Cmd is not used so far
-    uint8_t bits[GraphTraceLen];
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
+    if (bits == NULL)
+        return PM3_EMALLOC;
+
     size_t size = getFromGraphBuf(bits);
     removeSignalOffset(bits, size);
     // push it back to graph
     setGraphBuf(bits, size);
     // set signal properties low/high/mean/amplitude and is_noise detection
-    computeSignalProperties(bits, size);
+    updateSignalProperties();
 
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
 
-static bool _headBit(BitstreamOut *stream) {
-    int bytepos = stream->position >> 3; // divide by 8
-    int bitpos = (stream->position++) & 7; // mask out 00000111
-    return (*(stream->buffer + bytepos) >> (7 - bitpos)) & 1;
+// delta coding pays off on smooth signals only, `data samples d` asks for it
+static uint8_t samples_lz4_flags = 0;
+
+int getSamples(uint32_t n, bool verbose) {
+    return getSamplesEx(0, n, verbose);
 }
 
-static uint8_t getByte(uint8_t bits_per_sample, BitstreamOut *b) {
-    uint8_t val = 0;
-    for (int i = 0 ; i < bits_per_sample; i++)
-        val |= (_headBit(b) << (7 - i));
+// Compressed download. The packets are decoded as they come in and each block
+// goes straight into the graph buffer, the bytes only stay in the lz4 ring
+typedef struct {
+    bigbuf_lz4_decoder_t dec;
+    uint8_t sample;         // the last sample, the delta is added to it
+    uint32_t packets;
+    uint32_t bytes;
+} samples_lz4_t;
+
+static void samples_lz4_block(const uint8_t *bytes, uint32_t offset, uint16_t n, void *ctx) {
+    samples_lz4_t *s = (samples_lz4_t *)ctx;
+    int *graph = GraphBuffer + offset;
+    if (s->dec.flags & BIGBUF_LZ4_DELTA) {
+        for (uint16_t j = 0; j < n; j++) {
+            s->sample += bytes[j];
+            graph[j] = ((int)s->sample) - 127;
+        }
+    } else {
+        for (uint16_t j = 0; j < n; j++)
+            graph[j] = ((int)bytes[j]) - 127;
+    }
+}
 
-    return val;
+static int samples_lz4_packet(const uint8_t *data, uint16_t len, void *ctx) {
+    samples_lz4_t *s = (samples_lz4_t *)ctx;
+    int res = bigbuf_lz4_decode(&s->dec, data, len);
+    if (res != PM3_SUCCESS)
+        return res;
+
+    s->packets++;
+    s->bytes += len;
+    return PM3_SUCCESS;
 }
 
-int getSamples(uint32_t n, bool verbose) {
-    return getSamplesEx(0, n, verbose);
+// n bytes into the graph buffer, as samples - 127. The graph buffer has room for them
+static samples_lz4_t *samples_lz4_create(uint32_t n) {
+    samples_lz4_t *s = calloc(1, sizeof(samples_lz4_t));
+    uint8_t *ring = calloc(BIGBUF_LZ4_RING, sizeof(uint8_t));
+    if (s == NULL || ring == NULL) {
+        free(s);
+        free(ring);
+        return NULL;
+    }
+    bigbuf_lz4_decode_init(&s->dec, ring, n, samples_lz4_block, s);
+    return s;
+}
+
+static void samples_lz4_free(samples_lz4_t *s) {
+    if (s == NULL)
+        return;
+    free(s->dec.ring);
+    free(s);
+}
+
+// n bytes from start of BigBuf into the graph buffer
+static int getSamplesLZ4(uint32_t start, uint32_t n, PacketResponseNG *resp) {
+    struct p {
+        uint32_t start;
+        uint32_t len;
+        uint8_t flags;
+    } PACKED payload = { start, n, samples_lz4_flags };
+
+    samples_lz4_t *s = samples_lz4_create(n);
+    if (s == NULL)
+        return PM3_EMALLOC;
+
+    clearCommandBuffer();
+    SendCommandNG(CMD_DOWNLOAD_BIGBUF_LZ4, (uint8_t *)&payload, sizeof(payload));
+
+    int res = PM3_SUCCESS;
+    for (;;) {
+        if (WaitForResponseTimeout(CMD_UNKNOWN, resp, 2500) == false) {
+            samples_lz4_free(s);
+            return PM3_ETIMEOUT;
+        }
+
+        if (resp->cmd == CMD_DOWNLOADED_BIGBUF_LZ4) {
+            if (res == PM3_SUCCESS)
+                res = samples_lz4_packet(resp->data.asBytes, resp->length, s);
+        } else if (resp->cmd == CMD_DOWNLOAD_BIGBUF_LZ4) {
+            break;
+        }
+    }
+
+    if (res == PM3_SUCCESS && resp->status != PM3_SUCCESS)
+        res = resp->status;
+    if (res == PM3_SUCCESS && s->dec.len != n)
+        res = PM3_ESOFT;
+
+    PrintAndLogEx(DEBUG, "compressed download, %u bytes in %u packets, %u bytes", n, s->packets, s->bytes);
+    samples_lz4_free(s);
+    return res;
+}
+
+// bits of packed sample j, the packed bytes are in the graph buffer as byte - 127
+static uint8_t samples_unpack(uint32_t j, uint8_t bits_per_sample) {
+    uint8_t val = 0;
+    for (uint8_t i = 0; i < bits_per_sample; i++) {
+        uint32_t pos = j * bits_per_sample + i;
+        uint8_t b = GraphBuffer[pos / 8] + 127;
+        val |= ((b >> (7 - (pos % 8))) & 1) << (7 - i);
+    }
+    return val;
 }
 
 int getSamplesEx(uint32_t start, uint32_t end, bool verbose) {
@@ -1564,9 +1797,6 @@ int getSamplesEx(uint32_t start, uint32_t end, bool verbose) {
     // we don't have to worry about remaining trash
     // in the last byte in case the bits-per-sample
     // does not line up on byte boundaries
-    uint8_t got[pm3_capabilities.bigbuf_size - 1];
-    memset(got, 0x00, sizeof(got));
-
     uint32_t n = end - start;
 
     if (n <= 0 || n > pm3_capabilities.bigbuf_size - 1)
@@ -1575,48 +1805,64 @@ int getSamplesEx(uint32_t start, uint32_t end, bool verbose) {
     if (verbose)
         PrintAndLogEx(INFO, "Reading " _YELLOW_("%u") " bytes from device memory", n);
 
+    if (reserveGraphBuf(n) == false)
+        return PM3_EMALLOC;
+
     PacketResponseNG response;
-    if (!GetFromDevice(BIG_BUF, got, n, start, NULL, 0, &response, 10000, true)) {
-        PrintAndLogEx(WARNING, "timeout while waiting for reply.");
-        return PM3_ETIMEOUT;
+    bool fetched = false;
+    bool have_config = false;
+
+    // firmwares that can, send the samples compressed
+    if (pm3_capabilities.bigbuf_lz4_download) {
+        int res = getSamplesLZ4(start, n, &response);
+        if (res == PM3_SUCCESS) {
+            fetched = true;
+            have_config = response.length >= sizeof(sample_config);
+        } else {
+            PrintAndLogEx(DEBUG, "compressed download failed ( %d ), falling back", res);
+        }
+    }
+
+    if (fetched == false) {
+        // the bytes land at the start of the graph buffer and are widened in place, from the
+        // end so a sample never overwrites a byte still to be read
+        uint8_t *got = (uint8_t *)GraphBuffer;
+        if (!GetFromDevice(BIG_BUF, got, n, start, NULL, 0, &response, 10000, true)) {
+            PrintAndLogEx(WARNING, "timeout while waiting for reply.");
+            return PM3_ETIMEOUT;
+        }
+        for (uint32_t j = n; j > 0; j--)
+            GraphBuffer[j - 1] = ((int)got[j - 1]) - 127;
+
+        //Old devices without this feature would send 0 at arg[0]
+        have_config = response.oldarg[0] > 0;
     }
 
     if (verbose) PrintAndLogEx(SUCCESS, "Data fetched");
 
     uint8_t bits_per_sample = 8;
 
-    //Old devices without this feature would send 0 at arg[0]
-    if (response.oldarg[0] > 0) {
+    if (have_config) {
         sample_config *sc = (sample_config *) response.data.asBytes;
         if (verbose) PrintAndLogEx(INFO, "Samples @ " _YELLOW_("%d") " bits/smpl, decimation 1:%d ", sc->bits_per_sample, sc->decimation);
         bits_per_sample = sc->bits_per_sample;
     }
 
-    if (bits_per_sample < 8) {
+    if (bits_per_sample < 8 && bits_per_sample > 0) {
 
         if (verbose) PrintAndLogEx(INFO, "Unpacking...");
 
-        BitstreamOut bout = { got, bits_per_sample * n,  0};
-        uint32_t j = 0;
-        for (j = 0; j * bits_per_sample < n * 8 && j < n; j++) {
-            uint8_t sample = getByte(bits_per_sample, &bout);
-            GraphBuffer[j] = ((int) sample) - 127;
-        }
-        GraphTraceLen = j;
-
-        if (verbose) PrintAndLogEx(INFO, "Unpacked %d samples", j);
+        // in place from the end, sample j only reads bytes up to j
+        for (uint32_t j = n; j > 0; j--)
+            GraphBuffer[j - 1] = ((int)samples_unpack(j - 1, bits_per_sample)) - 127;
 
-    } else {
-        for (uint32_t j = 0; j < n; j++) {
-            GraphBuffer[j] = ((int)got[j]) - 127;
-        }
-        GraphTraceLen = n;
+        if (verbose) PrintAndLogEx(INFO, "Unpacked %d samples", n);
     }
+    GraphTraceLen = n;
 
-    uint8_t bits[GraphTraceLen];
-    size_t size = getFromGraphBuf(bits);
+    demod_ctx_touch(demod_ctx());
     // set signal properties low/high/mean/amplitude and is_noise detection
-    computeSignalProperties(bits, size);
+    updateSignalProperties();
 
     setClockGrid(0, 0);
     DemodBufferLen = 0;
@@ -1624,9 +1870,80 @@ int getSamplesEx(uint32_t start, uint32_t end, bool verbose) {
     return PM3_SUCCESS;
 }
 
+// The graph buffer, as the bytes the device would hold, goes through the
+// compressed download and the decoding of getSamplesEx and back
+static int samples_lz4_test(uint8_t flags) {
+    uint32_t n = GraphTraceLen;
+    uint8_t *dev = calloc(n, sizeof(uint8_t));
+    uint8_t *orig = calloc(n, sizeof(uint8_t));
+    samples_lz4_t *s = samples_lz4_create(n);
+    if (dev == NULL || orig == NULL || s == NULL) {
+        free(dev);
+        free(orig);
+        samples_lz4_free(s);
+        return PM3_EMALLOC;
+    }
+
+    for (uint32_t j = 0; j < n; j++) {
+        dev[j] = orig[j] = MAX(0, MIN(255, GraphBuffer[j] + 127));
+        GraphBuffer[j] = 0;
+    }
+
+    int res = bigbuf_lz4_compress(dev, n, flags, samples_lz4_packet, s);
+
+    bool ok = (res == PM3_SUCCESS) && (s->dec.len == n) && (memcmp(dev, orig, n) == 0);
+    for (uint32_t j = 0; ok && j < n; j++)
+        ok = GraphBuffer[j] == ((int)orig[j]) - 127;
+
+    if (ok) {
+        PrintAndLogEx(SUCCESS, "round trip ok, %s  %u bytes -> %u bytes in %u packets ( " _YELLOW_("%.1f%%") " )",
+                      (flags & BIGBUF_LZ4_DELTA) ? "delta + lz4" : "lz4        ", n, s->bytes, s->packets, n ? 100.0 * s->bytes / n : 0);
+    } else {
+        PrintAndLogEx(FAILED, "round trip " _RED_("failed") ", %s ( %d )", (flags & BIGBUF_LZ4_DELTA) ? "delta + lz4" : "lz4", res);
+    }
+
+    // the graph is back as the device would have sent it
+    for (uint32_t j = 0; j < n; j++)
+        GraphBuffer[j] = ((int)orig[j]) - 127;
+    demod_ctx_touch(demod_ctx());
+
+    free(dev);
+    free(orig);
+    samples_lz4_free(s);
+    return ok ? PM3_SUCCESS : PM3_ESOFT;
+}
+
 static int CmdSamples(const char *Cmd) {
-    int n = strtol(Cmd, NULL, 0);
-    return getSamples(n, false);
+    char cmdp = tolower(param_getchar(Cmd, 0));
+    if (cmdp == 'h')
+        return usage_data_samples();
+
+    if (cmdp == 't') {
+        if (GraphTraceLen == 0) {
+            PrintAndLogEx(WARNING, "no samples, load a trace with " _YELLOW_("`data load`") " first");
+            return PM3_ENODATA;
+        }
+        int res = samples_lz4_test(0);
+        if (res == PM3_SUCCESS)
+            res = samples_lz4_test(BIGBUF_LZ4_DELTA);
+        RepaintGraphWindow();
+        return res;
+    }
+
+    if (!session.pm3_present) {
+        PrintAndLogEx(WARNING, "device offline, only " _YELLOW_("`data samples t`") " works offline");
+        return PM3_ENOTTY;
+    }
+
+    uint8_t i = 0;
+    if (cmdp == 'd') {
+        samples_lz4_flags = BIGBUF_LZ4_DELTA;
+        i++;
+    }
+    uint32_t n = param_get32ex(Cmd, i, 0, 0);
+    int res = getSamples(n, false);
+    samples_lz4_flags = 0;
+    return res;
 }
 
 int CmdTuneSamples(const char *Cmd) {
@@ -1773,10 +2090,14 @@ int CmdTuneSamples(const char *Cmd) {
     // graph LF measurements
     // even here, these values has 3% error.
     uint16_t test1 = 0;
+    if (reserveGraphBuf(256) == false)
+        return PM3_EMALLOC;
+
     for (int i = 0; i < 256; i++) {
         GraphBuffer[i] = package->results[i] - 128;
         test1 += package->results[i];
     }
+    demod_ctx_touch(demod_ctx());
 
     if (test1 > 0) {
         PrintAndLogEx(SUCCESS, "\nDisplaying LF tuning graph. Divisor %d (blue) is %.2f kHz, %d (red) is %.2f kHz.\n\n",
@@ -1794,6 +2115,131 @@ int CmdTuneSamples(const char *Cmd) {
     return PM3_SUCCESS;
 }
 
+// whole file in memory, mapped where possible so long captures aren't copied around
+static int samples_map(const char *path, char **data, size_t *len, bool *mapped) {
+
+    *data = NULL;
+    *len = 0;
+    *mapped = false;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return PM3_EFILE;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return PM3_EFILE;
+    }
+
+    if (st.st_size == 0) {
+        close(fd);
+        return PM3_SUCCESS;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return PM3_EFILE;
+
+    *data = map;
+    *len = st.st_size;
+    *mapped = true;
+#else
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return PM3_EFILE;
+
+    fseek(f, 0, SEEK_END);
+    long fsize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (fsize <= 0) {
+        fclose(f);
+        return PM3_SUCCESS;
+    }
+
+    *data = calloc(fsize, sizeof(char));
+    if (*data == NULL) {
+        fclose(f);
+        return PM3_EMALLOC;
+    }
+    *len = fread(*data, 1, fsize, f);
+    fclose(f);
+#endif
+    return PM3_SUCCESS;
+}
+
+static void samples_unmap(char *data, size_t len, bool mapped) {
+#ifndef _WIN32
+    if (mapped) {
+        munmap(data, len);
+        return;
+    }
+#else
+    (void)len;
+    (void)mapped;
+#endif
+    free(data);
+}
+
+int loadSamplesPM3(const char *path) {
+
+    char *data;
+    size_t len;
+    bool mapped;
+    int res = samples_map(path, &data, &len, &mapped);
+    if (res != PM3_SUCCESS)
+        return res;
+
+    // one sample per line, the graph buffer grows once
+    size_t lines = 0;
+    for (const char *p = data; p && (p = memchr(p, '\n', data + len - p)) != NULL; p++)
+        lines++;
+    if (len && data[len - 1] != '\n')
+        lines++;
+
+    if (reserveGraphBuf(lines) == false) {
+        samples_unmap(data, len, mapped);
+        return PM3_EMALLOC;
+    }
+
+    // same as atoi() on each line
+    int *graph = GraphBuffer;
+    size_t n = 0;
+    const char *p = data, *end = data + len;
+    while (p < end) {
+        while (p < end && *p != '\n' && isspace((unsigned char)*p))
+            p++;
+
+        bool neg = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            neg = (*p++ == '-');
+
+        int v = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+            v = v * 10 + (*p++ - '0');
+
+        graph[n++] = neg ? -v : v;
+
+        const char *nl = memchr(p, '\n', end - p);
+        p = (nl) ? nl + 1 : end;
+    }
+    GraphTraceLen = n;
+    samples_unmap(data, len, mapped);
+
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
+    if (bits == NULL)
+        return PM3_EMALLOC;
+
+    size_t size = getFromGraphBuf(bits);
+
+    removeSignalOffset(bits, size);
+    setGraphBuf(bits, size);
+    updateSignalProperties();
+    return PM3_SUCCESS;
+}
+
 static int CmdLoad(const char *Cmd) {
 
     CLIParserContext *ctx;
@@ -1821,34 +2267,15 @@ static int CmdLoad(const char *Cmd) {
         }
     }
 
-    FILE *f = fopen(path, "r");
-    if (!f) {
+    int res = loadSamplesPM3(path);
+    if (res == PM3_EFILE)
         PrintAndLogEx(WARNING, "couldn't open '%s'", path);
-        free(path);
-        return PM3_EFILE;
-    }
     free(path);
-
-    GraphTraceLen = 0;
-    char line[80];
-    while (fgets(line, sizeof(line), f)) {
-        GraphBuffer[GraphTraceLen] = atoi(line);
-        GraphTraceLen++;
-
-        if (GraphTraceLen >= MAX_GRAPH_TRACE_LEN)
-            break;
-    }
-    fclose(f);
+    if (res != PM3_SUCCESS)
+        return res;
 
     PrintAndLogEx(SUCCESS, "loaded " _YELLOW_("%zu") " samples", GraphTraceLen);
 
-    uint8_t bits[GraphTraceLen];
-    size_t size = getFromGraphBuf(bits);
-
-    removeSignalOffset(bits, size);
-    setGraphBuf(bits, size);
-    computeSignalProperties(bits, size);
-
     setClockGrid(0, 0);
     DemodBufferLen = 0;
     RepaintGraphWindow();
@@ -1868,6 +2295,7 @@ int CmdLtrim(const char *Cmd) {
 
     GraphTraceLen -= ds;
     g_DemodStartIdx -= ds;
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
@@ -1881,6 +2309,7 @@ static int CmdRtrim(const char *Cmd) {
     if (GraphTraceLen <= ds) return PM3_ESOFT;
 
     GraphTraceLen = ds;
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
@@ -1900,6 +2329,7 @@ static int CmdMtrim(const char *Cmd) {
     for (uint32_t i = 0; i < GraphTraceLen; i++)
         GraphBuffer[i] = GraphBuffer[start + i];
 
+    demod_ctx_touch(demod_ctx());
     return PM3_SUCCESS;
 }
 
@@ -1920,10 +2350,9 @@ int CmdNorm(const char *Cmd) {
         }
     }
 
-    uint8_t bits[GraphTraceLen];
-    size_t size = getFromGraphBuf(bits);
+    demod_ctx_touch(demod_ctx());
     // set signal properties low/high/mean/amplitude and is_noise detection
-    computeSignalProperties(bits, size);
+    updateSignalProperties();
 
     RepaintGraphWindow();
     return PM3_SUCCESS;
@@ -2037,11 +2466,9 @@ static int CmdDirectionalThreshold(const char *Cmd) {
 
     directionalThreshold(GraphBuffer, GraphBuffer, GraphTraceLen, up, down);
 
-    // set signal properties low/high/mean/amplitude and isnoice detection
-    uint8_t bits[GraphTraceLen];
-    size_t size = getFromGraphBuf(bits);
-    // set signal properties low/high/mean/amplitude and is_noice detection
-    computeSignalProperties(bits, size);
+    demod_ctx_touch(demod_ctx());
+    // set signal properties low/high/mean/amplitude and is_noise detection
+    updateSignalProperties();
 
     RepaintGraphWindow();
     return PM3_SUCCESS;
@@ -2070,10 +2497,9 @@ static int CmdZerocrossings(const char *Cmd) {
         }
     }
 
-    uint8_t bits[GraphTraceLen];
-    size_t size = getFromGraphBuf(bits);
+    demod_ctx_touch(demod_ctx());
     // set signal properties low/high/mean/amplitude and is_noise detection
-    computeSignalProperties(bits, size);
+    updateSignalProperties();
 
     RepaintGraphWindow();
     return PM3_SUCCESS;
@@ -2323,10 +2749,9 @@ static int CmdDataIIR(const char *Cmd) {
     //iceIIR_Butterworth(GraphBuffer, GraphTraceLen);
     iceSimple_Filter(GraphBuffer, GraphTraceLen, k);
 
-    uint8_t bits[GraphTraceLen];
-    size_t size = getFromGraphBuf(bits);
+    demod_ctx_touch(demod_ctx());
     // set signal properties low/high/mean/amplitude and is_noise detection
-    computeSignalProperties(bits, size);
+    updateSignalProperties();
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
@@ -2565,7 +2990,7 @@ static command_t CommandTable[] = {
     {"load",            CmdLoad,                 AlwaysAvailable,  "Load contents of file into graph window"},
     {"ndef",            CmdDataNDEF,             AlwaysAvailable,  "Decode NDEF records"},
     {"print",           CmdPrintDemodBuff,       AlwaysAvailable,  "print the data in the DemodBuffer"},
-    {"samples",         CmdSamples,              IfPm3Present,     "[512 - 40000] -- Get raw samples for graph window (GraphBuffer)"},
+    {"samples",         CmdSamples,              AlwaysAvailable,  "[512 - 40000] -- Get raw samples for graph window (GraphBuffer)"},
     {"save",            CmdSave,                 AlwaysAvailable,  "Save signal trace data  (from graph window)"},
     {"setdebugmode",    CmdSetDebugMode,         AlwaysAvailable,  "<0|1|2> -- Set Debugging Level on client side"},
     {"tune",            CmdTuneSamples,          IfPm3Present,     "Measure tuning of device antenna. Results shown in graph window"},
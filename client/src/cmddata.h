@@ -12,6 +12,7 @@
 #define CMDDATA_H__
 
 #include "common.h"
+#include "demodctx.h"           // DemodBuffer, MAX_DEMOD_BUF_LEN
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,24 +71,19 @@ int NRZrawDemod(int clk, int invert, int maxErr, bool verbose);
 
 void printDemodBuff(void);
 void setDemodBuff(uint8_t *buff, size_t size, size_t start_idx);
+void setDemodErrors(int errors, size_t bits);
 bool getDemodBuff(uint8_t *buff, size_t *size);
 void save_restoreDB(uint8_t saveOpt);// option '1' to save DemodBuffer any other to restore
 int AutoCorrelate(const int *in, int *out, size_t len, size_t window, bool SaveGrph, bool verbose);
 
 int getSamples(uint32_t n, bool verbose);
 int getSamplesEx(uint32_t start, uint32_t end, bool verbose);
+int loadSamplesPM3(const char *path);   // .pm3 file into the current demod context, conditioned like `data load`
 
 void setClockGrid(uint32_t clk, int offset);
 int directionalThreshold(const int *in, int *out, size_t len, int8_t up, int8_t down);
 int AskEdgeDetect(const int *in, int *out, int len, int threshold);
 
-#define MAX_DEMOD_BUF_LEN (1024*128)
-extern uint8_t DemodBuffer[MAX_DEMOD_BUF_LEN];
-extern size_t DemodBufferLen;
-
-extern int g_DemodClock;
-extern int32_t g_DemodStartIdx;
-
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,235 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Dictionary commands
+//-----------------------------------------------------------------------------
+#include "cmddict.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include "cmdparser.h"          // command_t
+#include "cliparser.h"
+#include "comms.h"              // clearCommandBuffer
+#include "fileutils.h"
+#include "dictionary.h"
+#include "util.h"
+
+static int CmdHelp(const char *Cmd);
+
+// text dictionaries first, compiled ones as fallback
+static int dict_search(const char *name, char **path) {
+    if (searchFile(path, DICTIONARIES_SUBDIR, name, ".dic", true) == PM3_SUCCESS)
+        return PM3_SUCCESS;
+
+    return searchFile(path, DICTIONARIES_SUBDIR, name, DICTIONARY_COMPILED_SUFFIX, false);
+}
+
+static int dict_get_order(bool freq, bool sort, dictionary_order_t *order) {
+    if (freq && sort) {
+        PrintAndLogEx(WARNING, "select one of --freq or --sort");
+        return PM3_EINVARG;
+    }
+    *order = (freq) ? DICT_ORDER_FREQUENCY : (sort) ? DICT_ORDER_SORTED : DICT_ORDER_FILE;
+    return PM3_SUCCESS;
+}
+
+static int dict_check_keylen(int keylen) {
+    if (keylen < 1 || keylen > DICTIONARY_MAX_KEYLEN) {
+        PrintAndLogEx(WARNING, "key length must be between 1 and %u bytes", DICTIONARY_MAX_KEYLEN);
+        return PM3_EINVARG;
+    }
+    return PM3_SUCCESS;
+}
+
+static int CmdDictCompile(const char *Cmd) {
+    CLIParserContext *ctx;
+    CLIParserInit(&ctx, "dict compile",
+                  "Compile a text dictionary to a deduplicated binary dictionary.\n"
+                  "A compiled dictionary next to the text one, which is not older than it, is used automatically\n"
+                  "by all commands loading that dictionary.",
+                  "dict compile -f mfc_default_keys                -> creates mfc_default_keys" DICTIONARY_COMPILED_SUFFIX "\n"
+                  "dict compile -f iclass_default_keys -k 8\n"
+                  "dict compile -f t55xx_default_pwds -k 4 --sort -o t55.dicb"
+                 );
+
+    void *argtable[] = {
+        arg_param_begin,
+        arg_str1("f", "file", "<fn>", "text dictionary"),
+        arg_int0("k", "keylen", "<dec>", "key length in bytes (def 6)"),
+        arg_str0("o", "out", "<fn>", "output file (def <file>" DICTIONARY_COMPILED_SUFFIX ")"),
+        arg_lit0(NULL, "freq", "order keys by frequency"),
+        arg_lit0(NULL, "sort", "sort keys ascending"),
+        arg_param_end
+    };
+    CLIExecWithReturn(ctx, Cmd, argtable, false);
+
+    int fnlen = 0;
+    char filename[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 1), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+
+    int keylen = arg_get_int_def(ctx, 2, 6);
+
+    int outlen = 0;
+    char outfile[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 3), (uint8_t *)outfile, FILE_PATH_SIZE, &outlen);
+
+    bool freq = arg_get_lit(ctx, 4);
+    bool sort = arg_get_lit(ctx, 5);
+    CLIParserFree(ctx);
+
+    dictionary_order_t order;
+    if (dict_get_order(freq, sort, &order) != PM3_SUCCESS)
+        return PM3_EINVARG;
+
+    if (dict_check_keylen(keylen) != PM3_SUCCESS)
+        return PM3_EINVARG;
+
+    char *path = NULL;
+    if (searchFile(&path, DICTIONARIES_SUBDIR, filename, ".dic", false) != PM3_SUCCESS)
+        return PM3_EFILE;
+
+    char *cpath = NULL;
+    if (outlen == 0) {
+        cpath = dictionary_compiled_name(path);
+        if (cpath == NULL) {
+            free(path);
+            return PM3_EMALLOC;
+        }
+    }
+
+    const char *infiles[] = { path };
+    int res = dictionary_compile(infiles, 1, (outlen) ? outfile : cpath, keylen, order, true);
+
+    free(cpath);
+    free(path);
+    return res;
+}
+
+static int CmdDictMerge(const char *Cmd) {
+    CLIParserContext *ctx;
+    CLIParserInit(&ctx, "dict merge",
+                  "Merge text and/or compiled dictionaries into one compiled dictionary.\n"
+                  "Duplicates are removed, with --freq keys found in most inputs come first.",
+                  "dict merge -f mfc_default_keys -f extended_keys -o all_keys.dicb --freq"
+                 );
+
+    void *argtable[] = {
+        arg_param_begin,
+        arg_strx1("f", "file", "<fn>", "input dictionary, text or compiled (repeatable)"),
+        arg_int0("k", "keylen", "<dec>", "key length in bytes (def 6)"),
+        arg_str1("o", "out", "<fn>", "output file"),
+        arg_lit0(NULL, "freq", "order keys by frequency"),
+        arg_lit0(NULL, "sort", "sort keys ascending"),
+        arg_param_end
+    };
+    CLIExecWithReturn(ctx, Cmd, argtable, false);
+
+    struct arg_str *files = arg_get_str(ctx, 1);
+    int keylen = arg_get_int_def(ctx, 2, 6);
+
+    int outlen = 0;
+    char outfile[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 3), (uint8_t *)outfile, FILE_PATH_SIZE, &outlen);
+
+    bool freq = arg_get_lit(ctx, 4);
+    bool sort = arg_get_lit(ctx, 5);
+
+    dictionary_order_t order;
+    if (dict_get_order(freq, sort, &order) != PM3_SUCCESS || dict_check_keylen(keylen) != PM3_SUCCESS) {
+        CLIParserFree(ctx);
+        return PM3_EINVARG;
+    }
+
+    int cnt = files->count;
+    char **paths = calloc(cnt, sizeof(char *));
+    if (paths == NULL) {
+        CLIParserFree(ctx);
+        return PM3_EMALLOC;
+    }
+
+    int res = PM3_SUCCESS;
+    for (int i = 0; i < cnt; i++) {
+        res = dict_search(files->sval[i], &paths[i]);
+        if (res != PM3_SUCCESS)
+            break;
+    }
+    CLIParserFree(ctx);
+
+    if (res == PM3_SUCCESS)
+        res = dictionary_compile((const char **)paths, cnt, outfile, keylen, order, true);
+
+    for (int i = 0; i < cnt; i++)
+        free(paths[i]);
+    free(paths);
+    return res;
+}
+
+static int CmdDictInfo(const char *Cmd) {
+    CLIParserContext *ctx;
+    CLIParserInit(&ctx, "dict info",
+                  "Show header of a compiled dictionary and verify its checksum",
+                  "dict info -f mfc_default_keys" DICTIONARY_COMPILED_SUFFIX
+                 );
+
+    void *argtable[] = {
+        arg_param_begin,
+        arg_str1("f", "file", "<fn>", "compiled dictionary"),
+        arg_int0("n", NULL, "<dec>", "number of keys to print (def 0)"),
+        arg_param_end
+    };
+    CLIExecWithReturn(ctx, Cmd, argtable, false);
+
+    int fnlen = 0;
+    char filename[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 1), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+    int n = arg_get_int_def(ctx, 2, 0);
+    CLIParserFree(ctx);
+
+    char *path = NULL;
+    if (searchFile(&path, DICTIONARIES_SUBDIR, filename, DICTIONARY_COMPILED_SUFFIX, false) != PM3_SUCCESS)
+        return PM3_EFILE;
+
+    dictionary_t dict;
+    int res = dictionary_open(path, &dict, true);
+    if (res != PM3_SUCCESS) {
+        PrintAndLogEx(FAILED, "not a valid compiled dictionary " _YELLOW_("%s"), path);
+        free(path);
+        return res;
+    }
+
+    PrintAndLogEx(INFO, "file........ " _YELLOW_("%s"), path);
+    PrintAndLogEx(INFO, "version..... %u", DICTIONARY_VERSION);
+    PrintAndLogEx(INFO, "key length.. %u", dict.keylen);
+    PrintAndLogEx(INFO, "keys........ " _GREEN_("%u"), dict.keycnt);
+    PrintAndLogEx(INFO, "order....... %s", dictionary_order_str(dict.order));
+    PrintAndLogEx(INFO, "crc32....... %08X ( " _GREEN_("ok") " )", dict.crc);
+
+    for (uint32_t i = 0; i < dict.keycnt && i < (uint32_t)n; i++) {
+        PrintAndLogEx(INFO, "%5u | %s", i, sprint_hex_inrow(dict.keys + (size_t)i * dict.keylen, dict.keylen));
+    }
+
+    dictionary_close(&dict);
+    free(path);
+    return PM3_SUCCESS;
+}
+
+static command_t CommandTable[] = {
+    {"help",    CmdHelp,         AlwaysAvailable, "This help"},
+    {"compile", CmdDictCompile,  AlwaysAvailable, "Compile text dictionary to binary dictionary"},
+    {"merge",   CmdDictMerge,    AlwaysAvailable, "Merge dictionaries into one binary dictionary"},
+    {"info",    CmdDictInfo,     AlwaysAvailable, "Show and verify binary dictionary"},
+    {NULL, NULL, NULL, NULL}
+};
+
+static int CmdHelp(const char *Cmd) {
+    (void)Cmd; // Cmd is not used so far
+    CmdsHelp(CommandTable);
+    return PM3_SUCCESS;
+}
+
+int CmdDict(const char *Cmd) {
+    clearCommandBuffer();
+    return CmdsParse(CommandTable, Cmd);
+}
@@ -0,0 +1,16 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Dictionary commands
+//-----------------------------------------------------------------------------
+
+#ifndef CMDDICT_H__
+#define CMDDICT_H__
+
+#include "common.h"
+
+int CmdDict(const char *Cmd);
+
+#endif
@@ -332,11 +332,15 @@ int CmdHFPlot(const char *Cmd) {
         return PM3_ETIMEOUT;
     }
 
+    if (reserveGraphBuf(FPGA_TRACE_SIZE) == false)
+        return PM3_EMALLOC;
+
     for (size_t i = 0; i < FPGA_TRACE_SIZE; i++) {
         GraphBuffer[i] = ((int)buf[i]) - 127;
     }
 
     GraphTraceLen = FPGA_TRACE_SIZE;
+    demod_ctx_touch(demod_ctx());
 
     ShowGraphWindow();
 
@@ -1450,6 +1450,12 @@ static int CmdHFFelicaSniff(const char *Cmd) {
         PrintAndLogEx(INFO, "Set default triggers2skip: %" PRIu64, triggers2skip);
     }
 
+    // the sniff loop has no time to push the trace, it would silently stop at a full BigBuf
+    if (trace_stream_active()) {
+        PrintAndLogEx(WARNING, "FeliCa sniff can't stream its trace, stop it first with " _YELLOW_("`trace stream --stop`"));
+        return PM3_EINVARG;
+    }
+
     PrintAndLogEx(INFO, "Start Sniffing now. You can stop sniffing with clicking the PM3 Button");
     PrintAndLogEx(INFO, "During sniffing, other pm3 commands may not response.");
     clearCommandBuffer();
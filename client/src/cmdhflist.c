@@ -14,6 +14,7 @@
 #include <inttypes.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "commonutil.h"  // ARRAYLEN
 #include "mifare/mifarehost.h"
@@ -35,8 +36,18 @@ enum MifareAuthSeq {
     masData,
     masError,
 };
-static enum MifareAuthSeq MifareAuthState;
-static TAuthData AuthData;
+enum pico_state {PICO_NONE, PICO_SELECT, PICO_AUTH_EPURSE, PICO_AUTH_MACS };
+
+// the trace annotation state, one per thread
+static __thread enum MifareAuthSeq MifareAuthState;
+static __thread TAuthData AuthData;
+static __thread struct Crypto1State *traceCrypto1;
+static __thread uint64_t mfLastKey;
+static __thread enum pico_state pico_curr_state = PICO_NONE;
+static __thread uint8_t pico_csn[8];
+static __thread uint8_t pico_epurse[8];
+static __thread uint8_t pico_rmac[4];
+static __thread uint8_t pico_tmac[4];
 
 void ClearAuthData(void) {
     AuthData.uid = 0;
@@ -46,6 +57,52 @@ void ClearAuthData(void) {
     AuthData.ks3 = 0;
 }
 
+void ClearAnnotateState(void) {
+    MifareAuthState = masNone;
+    ClearAuthData();
+    if (traceCrypto1) {
+        crypto1_destroy(traceCrypto1);
+        traceCrypto1 = NULL;
+    }
+    mfLastKey = 0;
+    pico_curr_state = PICO_NONE;
+    memset(pico_csn, 0, sizeof(pico_csn));
+    memset(pico_epurse, 0, sizeof(pico_epurse));
+    memset(pico_rmac, 0, sizeof(pico_rmac));
+    memset(pico_tmac, 0, sizeof(pico_tmac));
+}
+
+void SaveAnnotateState(annotate_state_t *st) {
+    st->mf_auth_state = MifareAuthState;
+    st->auth = AuthData;
+    st->has_crypto1 = (traceCrypto1 != NULL);
+    if (traceCrypto1)
+        st->crypto1 = *traceCrypto1;
+    st->mf_last_key = mfLastKey;
+    st->iclass_state = pico_curr_state;
+    memcpy(st->csn, pico_csn, sizeof(st->csn));
+    memcpy(st->epurse, pico_epurse, sizeof(st->epurse));
+    memcpy(st->rmac, pico_rmac, sizeof(st->rmac));
+    memcpy(st->tmac, pico_tmac, sizeof(st->tmac));
+}
+
+void LoadAnnotateState(const annotate_state_t *st) {
+    ClearAnnotateState();
+    MifareAuthState = st->mf_auth_state;
+    AuthData = st->auth;
+    if (st->has_crypto1) {
+        traceCrypto1 = calloc(1, sizeof(struct Crypto1State));
+        if (traceCrypto1)
+            *traceCrypto1 = st->crypto1;
+    }
+    mfLastKey = st->mf_last_key;
+    pico_curr_state = st->iclass_state;
+    memcpy(pico_csn, st->csn, sizeof(pico_csn));
+    memcpy(pico_epurse, st->epurse, sizeof(pico_epurse));
+    memcpy(pico_rmac, st->rmac, sizeof(pico_rmac));
+    memcpy(pico_tmac, st->tmac, sizeof(pico_tmac));
+}
+
 /**
  * @brief iso14443A_CRC_check Checks CRC in command or response
  * @param isResponse
@@ -332,13 +389,6 @@ void annotateIso14443a(char *exp, size_t size, uint8_t *cmd, uint8_t cmdsize) {
 
 void annotateIclass(char *exp, size_t size, uint8_t *cmd, uint8_t cmdsize, bool isResponse) {
 
-    enum pico_state {PICO_NONE, PICO_SELECT, PICO_AUTH_EPURSE, PICO_AUTH_MACS };
-    static enum pico_state curr_state = PICO_NONE;
-    static uint8_t csn[8];
-    static uint8_t epurse[8];
-    static uint8_t rmac[4];
-    static uint8_t tmac[4];
-
     if (isResponse == false)  {
         uint8_t c = cmd[0] & 0x0F;
         uint8_t parity = 0;
@@ -349,25 +399,25 @@ void annotateIclass(char *exp, size_t size, uint8_t *cmd, uint8_t cmdsize, bool
         switch (c) {
             case ICLASS_CMD_HALT:
                 snprintf(exp, size, "HALT");
-                curr_state = PICO_NONE;
+                pico_curr_state = PICO_NONE;
                 break;
             case ICLASS_CMD_SELECT:
                 snprintf(exp, size, "SELECT");
-                curr_state = PICO_SELECT;
+                pico_curr_state = PICO_SELECT;
                 break;
             case ICLASS_CMD_ACTALL:
                 snprintf(exp, size, "ACTALL");
-                curr_state = PICO_NONE;
+                pico_curr_state = PICO_NONE;
                 break;
             case ICLASS_CMD_DETECT:
                 snprintf(exp, size, "DETECT");
-                curr_state = PICO_NONE;
+                pico_curr_state = PICO_NONE;
                 break;
             case ICLASS_CMD_CHECK:
                 snprintf(exp, size, "CHECK");
-                curr_state = PICO_AUTH_MACS;
-                memcpy(rmac, cmd + 1, 4);
-                memcpy(tmac, cmd + 5, 4);
+                pico_curr_state = PICO_AUTH_MACS;
+                memcpy(pico_rmac, cmd + 1, 4);
+                memcpy(pico_tmac, cmd + 5, 4);
                 break;
             case ICLASS_CMD_READ4:
                 snprintf(exp, size, "READ4(%d)", cmd[1]);
@@ -383,45 +433,45 @@ void annotateIclass(char *exp, size_t size, uint8_t *cmd, uint8_t cmdsize, bool
             }
             case ICLASS_CMD_PAGESEL:
                 snprintf(exp, size, "PAGESEL(%d)", cmd[1]);
-                curr_state = PICO_NONE;
+                pico_curr_state = PICO_NONE;
                 break;
             case ICLASS_CMD_UPDATE:
                 snprintf(exp, size, "UPDATE(%d)", cmd[1]);
-                curr_state = PICO_NONE;
+                pico_curr_state = PICO_NONE;
                 break;
             case ICLASS_CMD_READCHECK:
                 if (ICLASS_CREDIT(cmd[0])) {
                     snprintf(exp, size, "READCHECK[Kc](%d)", cmd[1]);
-                    curr_state = PICO_AUTH_EPURSE;
+                    pico_curr_state = PICO_AUTH_EPURSE;
                 } else {
                     snprintf(exp, size, "READCHECK[Kd](%d)", cmd[1]);
-                    curr_state = PICO_AUTH_EPURSE;
+                    pico_curr_state = PICO_AUTH_EPURSE;
                 }
                 break;
             case ICLASS_CMD_ACT:
                 snprintf(exp, size, "ACT");
-                curr_state = PICO_NONE;
+                pico_curr_state = PICO_NONE;
                 break;
             default:
                 snprintf(exp, size, "?");
-                curr_state = PICO_NONE;
+                pico_curr_state = PICO_NONE;
                 break;
         }
 
     } else {
 
-        if (curr_state == PICO_SELECT) {
-            memcpy(csn, cmd, 8);
-            curr_state = PICO_NONE;
-        } else if (curr_state == PICO_AUTH_EPURSE) {
-            memcpy(epurse, cmd, 8);
-        } else if (curr_state == PICO_AUTH_MACS) {
+        if (pico_curr_state == PICO_SELECT) {
+            memcpy(pico_csn, cmd, 8);
+            pico_curr_state = PICO_NONE;
+        } else if (pico_curr_state == PICO_AUTH_EPURSE) {
+            memcpy(pico_epurse, cmd, 8);
+        } else if (pico_curr_state == PICO_AUTH_MACS) {
 
             uint8_t key[8];
-            if (check_known_default(csn, epurse, rmac, tmac, key)) {
+            if (check_known_default(pico_csn, pico_epurse, pico_rmac, pico_tmac, key)) {
                 snprintf(exp, size, "( " _GREEN_("%s") ")", sprint_hex(key, 8));
             }
-            curr_state = PICO_NONE;
+            pico_curr_state = PICO_NONE;
         }
     }
     return;
@@ -1336,8 +1386,6 @@ void annotateMifare(char *exp, size_t size, uint8_t *cmd, uint8_t cmdsize, uint8
 }
 
 bool DecodeMifareData(uint8_t *cmd, uint8_t cmdsize, uint8_t *parity, bool isResponse, uint8_t *mfData, size_t *mfDataLen) {
-    static struct Crypto1State *traceCrypto1;
-
     *mfDataLen = 0;
 
     if (MifareAuthState == masAuthComplete) {
@@ -1354,7 +1402,6 @@ bool DecodeMifareData(uint8_t *cmd, uint8_t cmdsize, uint8_t *parity, bool isRes
         return false;
 
     if (MifareAuthState == masFirstData) {
-        static uint64_t mfLastKey;
         if (AuthData.first_auth) {
             AuthData.ks2 = AuthData.ar_enc ^ prng_successor(AuthData.nt, 64);
             AuthData.ks3 = AuthData.at_enc ^ prng_successor(AuthData.nt, 96);
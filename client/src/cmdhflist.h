@@ -11,6 +11,7 @@
 #define CMDHFLIST_H
 
 #include "common.h"
+#include "crapto1/crapto1.h"
 
 typedef struct {
     uint32_t uid;       // UID
@@ -27,7 +28,25 @@ typedef struct {
     uint32_t ks3;       // at ^ at_enc
 } TAuthData;
 
+// Annotation state carried from one trace record to the next. Every thread has its own,
+// a listing split over threads hands it on with Save / Load
+typedef struct {
+    uint8_t mf_auth_state;
+    TAuthData auth;
+    bool has_crypto1;
+    struct Crypto1State crypto1;
+    uint64_t mf_last_key;
+    uint8_t iclass_state;
+    uint8_t csn[8];
+    uint8_t epurse[8];
+    uint8_t rmac[4];
+    uint8_t tmac[4];
+} annotate_state_t;
+
 void ClearAuthData(void);
+void ClearAnnotateState(void);
+void SaveAnnotateState(annotate_state_t *st);
+void LoadAnnotateState(const annotate_state_t *st);
 
 uint8_t iso14443A_CRC_check(bool isResponse, uint8_t *d, uint8_t n);
 uint8_t iso14443B_CRC_check(uint8_t *d, uint8_t n);
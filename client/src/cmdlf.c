@@ -18,8 +18,10 @@
 #include <string.h>
 #include <limits.h>
 #include <ctype.h>
+#include <inttypes.h>
 
 #include "cmdparser.h"    // command_t
+#include "cliparser.h"
 #include "comms.h"
 #include "commonutil.h"  // ARRAYLEN
 
@@ -58,6 +60,10 @@
 #include "cmdlfti.h"        // for ti menu
 #include "cmdlfviking.h"    // for viking menu
 #include "cmdlfvisa2000.h"  // for VISA2000 menu
+#include "lfsearch.h"       // for `lf search` engine
+#include "lfstream.h"       // for `lf stream`
+#include "util.h"           // num_CPUs
+#include "util_posix.h"     // msclock
 
 #define LF_CMDREAD_MAX_EXTRA_SYMBOLS 4
 static bool g_lf_threshold_set = false;
@@ -217,17 +223,22 @@ static int usage_lf_simpsk(void) {
     return PM3_SUCCESS;
 }
 static int usage_lf_find(void) {
-    PrintAndLogEx(NORMAL, "Usage:  lf search [h] <0|1> [u]");
+    PrintAndLogEx(NORMAL, "Usage:  lf search [h] <0|1> [u] [s] [b]");
     PrintAndLogEx(NORMAL, "");
     PrintAndLogEx(NORMAL, "Options:");
     PrintAndLogEx(NORMAL, "       h             This help");
     PrintAndLogEx(NORMAL, "       <0|1>         Use data from Graphbuffer, if not set, try reading data from tag.");
     PrintAndLogEx(NORMAL, "       u             Search for Unknown tags, if not set, reads only known tags.");
+    PrintAndLogEx(NORMAL, "       s             Try the demodulators one after another and stop at the first match");
+    PrintAndLogEx(NORMAL, "       b             Benchmark, time the sequential search against the parallel one and check they agree");
+    PrintAndLogEx(NORMAL, "");
+    PrintAndLogEx(NORMAL, "All demodulators run in parallel on the same samples, matches are ranked most likely first.");
     PrintAndLogEx(NORMAL, "Examples:");
     PrintAndLogEx(NORMAL,  _YELLOW_("      lf search") "      - try reading data from tag & search for known tags");
     PrintAndLogEx(NORMAL,  _YELLOW_("      lf search 1") "    - use data from GraphBuffer & search for known tags");
     PrintAndLogEx(NORMAL,  _YELLOW_("      lf search u") "    - try reading data from tag & search for known and unknown tags");
     PrintAndLogEx(NORMAL,  _YELLOW_("      lf search 1 u") "  - use data from GraphBuffer & search for known and unknown tags");
+    PrintAndLogEx(NORMAL,  _YELLOW_("      lf search 1 b") "  - use data from GraphBuffer & compare search times");
     return PM3_SUCCESS;
 }
 static int usage_lf_tune(void) {
@@ -526,6 +537,9 @@ int CmdFlexdemod(const char *Cmd) {
 
     // iceman,  use demod buffer?  blue line?
     // HACK writing back to graphbuffer.
+    if (reserveGraphBuf(32 * 64) == false)
+        return PM3_EMALLOC;
+
     GraphTraceLen = 32 * 64;
     i = 0;
     for (bit = 0; bit < 64; bit++) {
@@ -537,6 +551,7 @@ int CmdFlexdemod(const char *Cmd) {
             phase = !phase;
         }
     }
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
@@ -828,6 +843,135 @@ int CmdLFSniff(const char *Cmd) {
     return ret;
 }
 
+static int CmdLFStream(const char *Cmd) {
+
+    CLIParserContext *ctx;
+    CLIParserInit(&ctx, "lf stream",
+                  "Continuous LF sniff, the samples are streamed to the client and decoded while they come in.\n"
+                  "Runs until the button or Enter is pressed, the samples are not kept.\n"
+                  "Without -t, -e, -i or -d the first three run.\n"
+                  "The raw demod detects the clock on the first " _YELLOW_("40000") " samples, on the whole file with -f.\n"
+                  "Use `lf config` to set decimation and averaging",
+                  "lf stream\n"
+                  "lf stream -t -e\n"
+                  "lf stream -f traces/lf_sniff_blue_cloner_em4100.pm3 -b 100\n"
+                  "lf stream -d fs -f traces/lf_AWID-15-259.pm3 -b 7 -c"
+                 );
+
+    void *argtable[] = {
+        arg_param_begin,
+        arg_lit0("t", "t55xx", "decode T55xx downlink commands"),
+        arg_lit0("e", "em4x05", "decode EM4x05 commands"),
+        arg_lit0("i", "ids", "search tag ids"),
+        arg_str0("d", "demod", "<fs|ar|nr|p1>", "raw bitstream, fs = fsk, ar = ask/raw, nr = nrz, p1 = psk1"),
+        arg_str0("f", "file", "<filename>", "replay a .pm3 file as simulated device"),
+        arg_int0("b", "block", "<dec>", "replay block size, 1 - 506 samples (default 506)"),
+        arg_lit0("c", "check", "replay, compare the raw bitstream to the one of `data rawdemod`"),
+        arg_param_end
+    };
+    CLIExecWithReturn(ctx, Cmd, argtable, true);
+
+    uint8_t decoders = 0;
+    if (arg_get_lit(ctx, 1))
+        decoders |= LF_STREAM_T55XX;
+    if (arg_get_lit(ctx, 2))
+        decoders |= LF_STREAM_EM4X05;
+    if (arg_get_lit(ctx, 3))
+        decoders |= LF_STREAM_TAGS;
+
+    int mlen = 0;
+    char m[3] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 4), (uint8_t *)m, sizeof(m) - 1, &mlen);
+
+    int fnlen = 0;
+    char filename[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 5), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+
+    int block = arg_get_int_def(ctx, 6, LF_STREAM_BLOCK_SAMPLES);
+    bool check = arg_get_lit(ctx, 7);
+    CLIParserFree(ctx);
+
+    lf_modulation_t mod = LF_MOD_ASK;
+    if (mlen) {
+        str_lower(m);
+        if (strcmp(m, "fs") == 0)
+            mod = LF_MOD_FSK;
+        else if (strcmp(m, "ar") == 0)
+            mod = LF_MOD_ASK;
+        else if (strcmp(m, "nr") == 0)
+            mod = LF_MOD_NRZ;
+        else if (strcmp(m, "p1") == 0)
+            mod = LF_MOD_PSK;
+        else {
+            PrintAndLogEx(WARNING, "unknown modulation " _YELLOW_("%s") ", use fs, ar, nr or p1", m);
+            return PM3_EINVARG;
+        }
+        decoders |= LF_STREAM_DEMOD;
+    }
+
+    if (block < 1 || block > (int)LF_STREAM_BLOCK_SAMPLES) {
+        PrintAndLogEx(WARNING, "block size must be 1 - %zu", LF_STREAM_BLOCK_SAMPLES);
+        return PM3_EINVARG;
+    }
+
+    if (decoders == 0)
+        decoders = LF_STREAM_ALL;
+
+    if (check && ((decoders & LF_STREAM_DEMOD) == 0 || fnlen == 0)) {
+        PrintAndLogEx(WARNING, "-c needs -d and -f");
+        return PM3_EINVARG;
+    }
+
+    if (fnlen == 0 && !session.pm3_present) {
+        PrintAndLogEx(WARNING, "streaming needs a device, or use -f with a .pm3 file");
+        return PM3_ENOTTY;
+    }
+
+    PrintAndLogEx(NORMAL, "");
+    PrintAndLogEx(SUCCESS, "   offset | Source | Command / Tag");
+    PrintAndLogEx(SUCCESS, "----------+--------+------------------------------------------------------------------------");
+
+    if (fnlen)
+        return lf_stream_replay(filename, decoders, mod, block, check);
+
+    int res = lf_stream_start(decoders, mod);
+    if (res != PM3_SUCCESS)
+        return res;
+
+    PrintAndLogEx(INFO, "Press " _GREEN_("Enter") " or the button to exit");
+    clearCommandBuffer();
+    SendCommandNG(CMD_LF_SNIFF_STREAM, NULL, 0);
+
+    // the blocks are decoded on arrival, this only waits for the end
+    PacketResponseNG resp;
+    bool done = false;
+    while (done == false) {
+        if (kbd_enter_pressed()) {
+            SendCommandNG(CMD_BREAK_LOOP, NULL, 0);
+            done = true;
+            if (WaitForResponseTimeout(CMD_LF_SNIFF_STREAM, &resp, 2500) == false) {
+                PrintAndLogEx(WARNING, "command execution time out");
+                lf_stream_stop();
+                return PM3_ETIMEOUT;
+            }
+        } else {
+            done = WaitForResponseTimeout(CMD_LF_SNIFF_STREAM, &resp, 100);
+        }
+    }
+
+    struct p {
+        uint32_t samples;
+        uint16_t overruns;
+    } PACKED;
+    struct p *payload = (struct p *)resp.data.asBytes;
+    if (resp.status == PM3_SUCCESS && resp.length >= sizeof(struct p)) {
+        PrintAndLogEx(INFO, "device sent " _YELLOW_("%u") " samples", payload->samples);
+        if (payload->overruns)
+            PrintAndLogEx(WARNING, "samples were dropped " _YELLOW_("%u") " times, try a higher decimation in " _YELLOW_("`lf config`"), payload->overruns);
+    }
+    return lf_stream_stop();
+}
+
 static void ChkBitstream(void) {
     // convert to bitstream if necessary
     for (int i = 0; i < (int)(GraphTraceLen / 2); i++) {
@@ -1324,6 +1468,9 @@ int CmdVchDemod(const char *Cmd) {
 
     // clone
     if (strcmp(Cmd, "clone") == 0) {
+        if (reserveGraphBuf(strlen(bits) * 16) == false)
+            return PM3_EMALLOC;
+
         GraphTraceLen = 0;
         char *s;
         for (s = bits; *s; s++) {
@@ -1331,6 +1478,7 @@ int CmdVchDemod(const char *Cmd) {
                 GraphBuffer[GraphTraceLen++] = (*s == '1') ? 1 : 0;
             }
         }
+        demod_ctx_touch(demod_ctx());
         RepaintGraphWindow();
     }
     return PM3_SUCCESS;
@@ -1382,14 +1530,34 @@ int CmdLFfind(const char *Cmd) {
     int retval = PM3_SUCCESS;
     int ans = 0;
     size_t minLength = 2000;
-    char cmdp = tolower(param_getchar(Cmd, 0));
-    char testRaw = param_getchar(Cmd, 1);
-
-    if (strlen(Cmd) > 3 || cmdp == 'h') return usage_lf_find();
-
-    if (cmdp == 'u') testRaw = 'u';
+    bool use_gb = false, search_unknown = false, sequential = false, benchmark = false;
+    uint8_t cmdp = 0;
+    while (param_getchar(Cmd, cmdp) != 0x00) {
+        switch (tolower(param_getchar(Cmd, cmdp))) {
+            case 'h':
+                return usage_lf_find();
+            case '0':
+                break;
+            case '1':
+                use_gb = true;
+                break;
+            case 'u':
+                search_unknown = true;
+                break;
+            case 's':
+                sequential = true;
+                break;
+            case 'b':
+                benchmark = true;
+                break;
+            default:
+                PrintAndLogEx(WARNING, "Unknown parameter '%c'", param_getchar(Cmd, cmdp));
+                return usage_lf_find();
+        }
+        cmdp++;
+    }
 
-    bool isOnline = (session.pm3_present && (cmdp != '1'));
+    bool isOnline = (session.pm3_present && use_gb == false);
 
     if (isOnline)
         lf_read(false, 30000);
@@ -1448,35 +1616,53 @@ int CmdLFfind(const char *Cmd) {
         }
     }
 
-    if (demodVisa2k(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Visa2000 ID") " found!"); goto out;}
-    if (demodDestron(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("FDX-A FECAVA Destron ID") " found!"); goto out;} // to do before HID
-    if (demodHID(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("HID Prox ID") " found!"); goto out;}
-    if (demodAWID(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("AWID ID") " found!"); goto out;}
-    if (demodIOProx(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("IO Prox ID") " found!"); goto out;}
-    if (demodParadox(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Paradox ID") " found!"); goto out;}
-    if (demodNexWatch(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("NexWatch ID") " found!"); goto out;}
-    if (demodIndala(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Indala ID") " found!");  goto out;}
-    if (demodEM410x(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("EM410x ID") " found!"); goto out;}
-    if (demodFDXB(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("FDX-B ID") " found!"); goto out;}
-    if (demodGuard(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Guardall G-Prox II ID") " found!"); goto out; }
-    if (demodIdteck(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Idteck ID") " found!"); goto out;}
-    if (demodJablotron(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Jablotron ID") " found!"); goto out;}
-    if (demodNedap(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("NEDAP ID") " found!"); goto out;}
-    if (demodNoralsy(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Noralsy ID") " found!"); goto out;}
-    if (demodKeri(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("KERI ID") " found!"); goto out;}
-    if (demodPac(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("PAC/Stanley ID") " found!"); goto out;}
-    if (demodPresco(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Presco ID") " found!"); goto out;}
-    if (demodPyramid(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Pyramid ID") " found!"); goto out;}
-    if (demodSecurakey(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Securakey ID") " found!"); goto out;}
-    if (demodViking(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Viking ID") " found!"); goto out;}
-    if (demodGallagher(true) == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("GALLAGHER ID") " found!"); goto out;}
+    if (benchmark) {
+        uint64_t t1 = msclock();
+        int idx = lf_search_sequential(GraphBuffer, GraphTraceLen, getSignalProperties());
+        uint64_t seq_ms = msclock() - t1;
+
+        lf_search_result_t res;
+        retval = lf_search(GraphBuffer, GraphTraceLen, getSignalProperties(), num_CPUs(), &res);
+        PrintAndLogEx(SUCCESS, "sequential........ " _YELLOW_("%" PRIu64) " ms  ( %s )", seq_ms, (idx < 0) ? "no match" : lf_search_decoder(idx)->name);
+        PrintAndLogEx(SUCCESS, "parallel.......... " _YELLOW_("%" PRIu64) " ms  ( %u matches, %d threads )", res.ms, res.count, num_CPUs());
+        lf_search_free(&res);
+
+        // each decoder on its own context while the others run, against each one alone
+        int diff = lf_search_verify(GraphBuffer, GraphTraceLen, getSignalProperties(), num_CPUs());
+        if (diff == 0)
+            PrintAndLogEx(SUCCESS, "contexts.......... " _GREEN_("ok") "  ( %u decoders agree )", lf_search_decoder_count());
+        else
+            PrintAndLogEx(FAILED, "contexts.......... " _RED_("%d decoders disagree"), diff);
+        return retval;
+    }
+
+    if (sequential) {
+        for (uint8_t i = 0; i < lf_search_decoder_count(); i++) {
+            const lf_search_decoder_t *dec = lf_search_decoder(i);
+            if (dec->demod(true) == PM3_SUCCESS) {
+                PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("%s") " found!", dec->name);
+                goto out;
+            }
+        }
+    } else {
+        lf_search_result_t res;
+        if (lf_search(GraphBuffer, GraphTraceLen, getSignalProperties(), num_CPUs(), &res) == PM3_SUCCESS) {
+            lf_search_print(&res, true);
+            uint8_t found = res.count;
+            lf_search_free(&res);
+            if (found)
+                goto out;
+        } else {
+            lf_search_free(&res);
+        }
+    }
 
 //    if (demodTI() == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Texas Instrument ID") " found!"); goto out;}
 //    if (demodFermax() == PM3_SUCCESS) { PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("Fermax ID") " found!"); goto out;}
 
     PrintAndLogEx(FAILED, _RED_("No known 125/134 kHz tags found!"));
 
-    if (testRaw == 'u') {
+    if (search_unknown) {
         //test unknown tag formats (raw mode)
         PrintAndLogEx(INFO, "\nChecking for unknown tags:\n");
         ans = AutoCorrelate(GraphBuffer, GraphBuffer, GraphTraceLen, 8000, false, false);
@@ -1568,6 +1754,7 @@ static command_t CommandTable[] = {
 //    {"simpsk",      CmdLFnrzSim,        IfPm3Lf,         "Simulate " _YELLOW_("LF NRZ tag") " from demodbuffer or input"},
     {"simbidir",    CmdLFSimBidir,      IfPm3Lf,         "Simulate LF tag (with bidirectional data transmission between reader and tag)"},
     {"sniff",       CmdLFSniff,         IfPm3Lf,         "Sniff LF traffic between reader and tag"},
+    {"stream",      CmdLFStream,        AlwaysAvailable, "Continuous sniff, decodes T55xx / EM4x05 commands, tag ids and raw bitstreams while sniffing"},
     {"tune",        CmdLFTune,          IfPm3Lf,         "Continuously measure LF antenna tuning"},
 //    {"vchdemod",    CmdVchDemod,        AlwaysAvailable, "['clone'] -- Demodulate samples for VeriChip"},
 //    {"flexdemod",   CmdFlexdemod,       AlwaysAvailable, "Demodulate samples for Motorola FlexPass"},
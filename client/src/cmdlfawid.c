@@ -198,7 +198,7 @@ static int CmdAWIDWatch(const char *Cmd) {
 //print full AWID Prox ID and some bit format details if found
 int demodAWID(bool verbose) {
     (void) verbose; // unused so far
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN, sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         PrintAndLogEx(DEBUG, "DEBUG: Error - AWID failed to allocate memory");
         return PM3_EMALLOC;
@@ -207,12 +207,11 @@ int demodAWID(bool verbose) {
     size_t size = getFromGraphBuf(bits);
     if (size == 0) {
         PrintAndLogEx(DEBUG, "DEBUG: Error - AWID not enough samples");
-        free(bits);
         return PM3_ENODATA;
     }
     //get binary from fsk wave
     int waveIdx = 0;
-    int idx = detectAWID(bits, &size, &waveIdx);
+    int idx = detectAWID(bits, &size, &waveIdx, getGraphWaves(bits, size));
     if (idx <= 0) {
 
         if (idx == -1)
@@ -228,7 +227,6 @@ int demodAWID(bool verbose) {
         else
             PrintAndLogEx(DEBUG, "DEBUG: Error - AWID error demoding fsk %d", idx);
 
-        free(bits);
         return PM3_ESOFT;
     }
 
@@ -257,7 +255,6 @@ int demodAWID(bool verbose) {
     size = removeParity(bits, idx + 8, 4, 1, 88);
     if (size != 66) {
         PrintAndLogEx(DEBUG, "DEBUG: Error - AWID at parity check-tag size does not match AWID format");
-        free(bits);
         return PM3_ESOFT;
     }
     // ok valid card found!
@@ -327,7 +324,6 @@ int demodAWID(bool verbose) {
             }
             break;
     }
-    free(bits);
 
     PrintAndLogEx(DEBUG, "DEBUG: AWID idx: %d, Len: %zu Printing Demod Buffer:", idx, size);
     if (g_debugMode)
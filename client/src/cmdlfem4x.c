@@ -35,8 +35,6 @@
 #include "cliparser.h"
 #include "cmdhw.h"
 
-static uint64_t g_em410xid = 0;
-
 static int CmdHelp(const char *Cmd);
 
 //////////////// 410x commands
@@ -311,6 +309,9 @@ int AskEm410xDecode(bool verbose, uint32_t *hi, uint64_t *lo) {
         return PM3_ESOFT;
     }
 
+    // the last ID stays with the demod context, for watch and spoof
+    demod_ctx()->em410x_id = *lo;
+
     //set GraphBuffer for clone or sim command
     setDemodBuff(DemodBuffer, (size == 40) ? 64 : 128, idx + 1);
     setClockGrid(g_DemodClock, g_DemodStartIdx + ((idx + 1)*g_DemodClock));
@@ -380,7 +381,6 @@ static int CmdEM410xDemod(const char *Cmd) {
     if (AskEm410xDemod(clk, invert, maxErr, maxLen, amplify, &hi, &lo, true) != PM3_SUCCESS)
         return PM3_ESOFT;
 
-    g_em410xid = lo;
     return PM3_SUCCESS;
 }
 
@@ -545,7 +545,7 @@ static int CmdEM410xWatchnSpoof(const char *Cmd) {
 
     // loops if the captured ID was in XL-format.
     CmdEM410xWatch(Cmd);
-    PrintAndLogEx(SUCCESS, "# Replaying captured ID: "_YELLOW_("%010" PRIx64), g_em410xid);
+    PrintAndLogEx(SUCCESS, "# Replaying captured ID: "_YELLOW_("%010" PRIx64), demod_ctx()->em410x_id);
     CmdLFaskSim("");
     return PM3_SUCCESS;
 }
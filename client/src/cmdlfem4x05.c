@@ -160,7 +160,7 @@ static bool downloadSamplesEM(void) {
 
     setGraphBuf(got, sizeof(got));
     // set signal properties low/high/mean/amplitude and is_noise detection
-    computeSignalProperties(got, sizeof(got));
+    updateSignalProperties();
     RepaintGraphWindow();
     if (getSignalProperties()->isnoise) {
         PrintAndLogEx(DEBUG, "No tag found - signal looks like noise");
@@ -1640,23 +1640,6 @@ int CmdEM4x05Unlock(const char *Cmd) {
     return exit_code;
 }
 
-static size_t em4x05_Sniff_GetNextBitStart (size_t idx, size_t sc, int *data, size_t *pulsesamples)
-{
-    while ((idx < sc) && (data[idx] <= 10)) // find a going high
-        idx++;
-
-    while ((idx < sc) && (data[idx] > -10)) // find going low  may need to add something here it SHOULD be a small clk around 0, but white seems to extend a bit.
-        idx++;
-
-    (*pulsesamples) = 0;
-    while ((idx < sc) && ((data[idx+1] - data[idx]) < 10 )) {  // find "sharp rise"
-        (*pulsesamples)++;
-        idx++;
-    }
-
-    return idx;
-}
-
 uint32_t static em4x05_Sniff_GetBlock (char *bits, bool fwd) {
     uint32_t value = 0;
     uint8_t idx;
@@ -1714,24 +1697,270 @@ uint32_t static em4x05_Sniff_GetBlock (char *bits, bool fwd) {
     return value;
 }
 
-int CmdEM4x05Sniff(const char *Cmd) {
+enum {
+    EM_SNIFF_HIGH,          // find a going high
+    EM_SNIFF_LOW,           // find going low
+    EM_SNIFF_RISE,          // find "sharp rise"
+};
+
+enum {
+    EM_SNIFF_START,         // first bit
+    EM_SNIFF_ZERO,          // "0" bit width reference
+    EM_SNIFF_BITS,
+    EM_SNIFF_NEXT,
+    EM_SNIFF_DONE,
+};
+
+// only the current and the next sample are ever looked at
+static int em4x05_Sniff_Sample(em4x05_sniff_t *s, size_t idx) {
+    if (idx >= s->count)
+        return 0;
+    return s->last[idx & 1];
+}
 
-    bool sampleData = true;
+// searches the next bit start from s->pos as far as the samples go. Returns true when found,
+// with s->pos at the bit start and the low samples before it in s->pulses
+static bool em4x05_Sniff_GetNextBitStart(em4x05_sniff_t *s) {
+    if (s->searching == false) {
+        s->searching = true;
+        s->phase = EM_SNIFF_HIGH;
+        s->mark = s->pos;
+    }
+
+    for (;;) {
+        if (s->pos >= s->count) {
+            if (s->eof == false)
+                return false;
+            if (s->phase != EM_SNIFF_RISE)
+                s->pulses = 0;
+            break;
+        }
+
+        if (s->phase == EM_SNIFF_HIGH) {
+            if (em4x05_Sniff_Sample(s, s->pos) <= 10) {
+                s->pos++;
+                continue;
+            }
+            s->phase = EM_SNIFF_LOW;
+        }
+
+        if (s->phase == EM_SNIFF_LOW) {
+            // may need to add something here it SHOULD be a small clk around 0, but white seems to extend a bit.
+            if (em4x05_Sniff_Sample(s, s->pos) > -10) {
+                s->pos++;
+                continue;
+            }
+            s->phase = EM_SNIFF_RISE;
+            s->pulses = 0;
+        }
+
+        // needs the next sample
+        if (s->pos + 1 >= s->count && s->eof == false)
+            return false;
+
+        if ((em4x05_Sniff_Sample(s, s->pos + 1) - em4x05_Sniff_Sample(s, s->pos)) >= 10)
+            break;
+
+        s->pulses++;
+        s->pos++;
+    }
+
+    s->searching = false;
+    return true;
+}
+
+static void em4x05_Sniff_Packet(em4x05_sniff_t *s) {
+
+    em4x05_sniff_frame_t f;
+    memset(&f, 0, sizeof(f));
     bool haveData = false;
-    size_t idx = 0;
-    char cmdText [100];
-    char dataText [100];
-    char blkAddr[4];
-    char bits[80];
-    int bitidx;
-    int ZeroWidth;    // 32-42 "1" is 32
-    int CycleWidth;
-    size_t pulseSamples;
-    size_t pktOffset;
-    int i;
-    bool eop = false;
     uint32_t tmpValue;
-    bool pwd = false;
+    char *bits = s->bits;
+    int bitidx = s->bitidx;
+
+    bits[bitidx++] = '0';   // Append last zero from the last bit find
+
+    // EM4305 command lengths
+    // Login        0011 <pwd>          => 4 +     45 => 49
+    // Write Word   0101 <adr> <data>   => 4 + 7 + 45 => 56
+    // Read Word    1001 <adr>          => 4 + 7      => 11
+    // Protect      1100       <data>   => 4 +     45 => 49
+    // Disable      1010       <data>   => 4 +     45 => 49
+    // -> disaable 1010 11111111 0 11111111 0 11111111 0 11111111 0 00000000 0
+
+    // Check to see if we got the leading 0
+    if (((strncmp(bits, "00011", 5) == 0) && (bitidx == 50)) ||
+            ((strncmp(bits, "00101", 5) == 0) && (bitidx == 57)) ||
+            ((strncmp(bits, "01001", 5) == 0) && (bitidx == 12)) ||
+            ((strncmp(bits, "01100", 5) == 0) && (bitidx == 50)) ||
+            ((strncmp(bits, "01010", 5) == 0) && (bitidx == 50))) {
+        memmove(bits, &bits[1], bitidx - 1);
+        bitidx--;
+        printf("Trim leading 0\n");
+    }
+    bits[bitidx] = 0;
+
+    // logon
+    if ((strncmp(bits, "0011", 4) == 0) && (bitidx == 49)) {
+        haveData = true;
+        f.pwd = true;
+        sprintf(f.cmd, "Logon");
+        sprintf(f.blk, "   ");
+        tmpValue = em4x05_Sniff_GetBlock(&bits[4], s->fwd);
+        sprintf(f.data, "%08X", tmpValue);
+    }
+
+    // write
+    if ((strncmp(bits, "0101", 4) == 0) && (bitidx == 56)) {
+        haveData = true;
+        sprintf(f.cmd, "Write");
+        tmpValue = (bits[4] - '0') + ((bits[5] - '0') << 1) + ((bits[6] - '0') << 2)  + ((bits[7] - '0') << 3);
+        sprintf(f.blk, "%d", tmpValue);
+        if (tmpValue == 2)
+            f.pwd = true;
+        tmpValue = em4x05_Sniff_GetBlock(&bits[11], s->fwd);
+        sprintf(f.data, "%08X", tmpValue);
+    }
+
+    // read
+    if ((strncmp(bits, "1001", 4) == 0) && (bitidx == 11)) {
+        haveData = true;
+        f.pwd = false;
+        sprintf(f.cmd, "Read");
+        tmpValue = (bits[4] - '0') + ((bits[5] - '0') << 1) + ((bits[6] - '0') << 2)  + ((bits[7] - '0') << 3);
+        sprintf(f.blk, "%d", tmpValue);
+        sprintf(f.data, " ");
+    }
+
+    // protect
+    if ((strncmp(bits, "1100", 4) == 0) && (bitidx == 49)) {
+        haveData = true;
+        f.pwd = false;
+        sprintf(f.cmd, "Protect");
+        sprintf(f.blk, " ");
+        tmpValue = em4x05_Sniff_GetBlock(&bits[11], s->fwd);
+        sprintf(f.data, "%08X", tmpValue);
+    }
+
+    // disable
+    if ((strncmp(bits, "1010", 4) == 0) && (bitidx == 49)) {
+        haveData = true;
+        f.pwd = false;
+        sprintf(f.cmd, "Disable");
+        sprintf(f.blk, " ");
+        tmpValue = em4x05_Sniff_GetBlock(&bits[11], s->fwd);
+        sprintf(f.data, "%08X", tmpValue);
+    }
+
+    if (haveData && s->cb) {
+        f.offset = s->pkt_offset;
+        memcpy(f.raw, bits, bitidx + 1);
+        s->cb(&f, s->cb_arg);
+    }
+}
+
+// the capture ended before the next bit start search, a search already under way runs to the end
+static bool em4x05_Sniff_AtEnd(em4x05_sniff_t *s) {
+    size_t at = (s->searching) ? s->mark : s->pos;
+    return (s->eof && at >= s->count);
+}
+
+// runs the packet search as far as the samples go
+static void em4x05_Sniff_Run(em4x05_sniff_t *s) {
+    for (;;) {
+        switch (s->state) {
+            case EM_SNIFF_START:
+                if (em4x05_Sniff_AtEnd(s)) {
+                    s->state = EM_SNIFF_DONE;
+                    break;
+                }
+                if (em4x05_Sniff_GetNextBitStart(s) == false)
+                    return;
+
+                s->pkt_offset = s->pos;
+                // Should be 18 so a bit less to allow for processing
+                s->state = (s->pulses >= 10) ? EM_SNIFF_ZERO : EM_SNIFF_NEXT;
+                break;
+            case EM_SNIFF_ZERO:
+                // Use first bit to get "0" bit samples as a reference
+                if (em4x05_Sniff_GetNextBitStart(s) == false)
+                    return;
+
+                s->zero_width = s->pos - s->mark;
+                if (s->zero_width <= 50) {
+                    s->pkt_offset -= s->zero_width;
+                    memset(s->bits, 0x00, sizeof(s->bits));
+                    s->bitidx = 0;
+                    s->state = EM_SNIFF_BITS;
+                } else {
+                    s->state = EM_SNIFF_NEXT;
+                }
+                break;
+            case EM_SNIFF_BITS: {
+                if (em4x05_Sniff_AtEnd(s)) {
+                    s->state = EM_SNIFF_NEXT;
+                    break;
+                }
+                if (em4x05_Sniff_GetNextBitStart(s) == false)
+                    return;
+
+                int CycleWidth = s->pos - s->mark;
+                if ((CycleWidth > 300) || (CycleWidth < (s->zero_width - 5))) { // to long or too short
+                    em4x05_Sniff_Packet(s);
+                    s->state = EM_SNIFF_NEXT;
+                } else {
+                    int i = (CycleWidth - s->zero_width) / 28;
+                    // room for the closing zero as well
+                    if (s->bitidx + i + 2 < (int)sizeof(s->bits)) {
+                        s->bits[s->bitidx++] = '0';
+                        for (int ii = 0; ii < i; ii++)
+                            s->bits[s->bitidx++] = '1';
+                    }
+                }
+                break;
+            }
+            case EM_SNIFF_NEXT:
+                s->pos++;
+                s->state = EM_SNIFF_START;
+                break;
+            case EM_SNIFF_DONE:
+                return;
+        }
+    }
+}
+
+void em4x05_sniff_init(em4x05_sniff_t *s, bool fwd, em4x05_sniff_cb_t cb, void *arg) {
+    memset(s, 0, sizeof(em4x05_sniff_t));
+    s->fwd = fwd;
+    s->state = EM_SNIFF_START;
+    s->cb = cb;
+    s->cb_arg = arg;
+}
+
+void em4x05_sniff_feed(em4x05_sniff_t *s, const int *samples, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        s->last[s->count & 1] = samples[i];
+        s->count++;
+        em4x05_Sniff_Run(s);
+    }
+}
+
+void em4x05_sniff_finish(em4x05_sniff_t *s) {
+    s->eof = true;
+    em4x05_Sniff_Run(s);
+}
+
+static void em4x05_Sniff_Print(const em4x05_sniff_frame_t *f, void *arg) {
+    (void)arg;
+    if (f->pwd)
+        PrintAndLogEx(SUCCESS, "%6zu | %-10s  | "_YELLOW_("%8s")" | "_YELLOW_("%3s")" | %s", f->offset, f->cmd, f->data, f->blk, f->raw);
+    else
+        PrintAndLogEx(SUCCESS, "%6zu | %-10s  | "_GREEN_("%8s")" | "_GREEN_("%3s")" | %s", f->offset, f->cmd, f->data, f->blk, f->raw);
+}
+
+int CmdEM4x05Sniff(const char *Cmd) {
+
+    bool sampleData = true;
     bool fwd = false;
 
     CLIParserContext *ctx;
@@ -1769,129 +1998,10 @@ int CmdEM4x05Sniff(const char *Cmd) {
     PrintAndLogEx(SUCCESS, "offset | Command     |   Data   | blk | raw");
     PrintAndLogEx(SUCCESS, "-------+-------------+----------+-----+------------------------------------------------------------");
 
-    idx = 0;
-    // loop though sample buffer
-    while (idx < GraphTraceLen) {
-        eop = false;
-        haveData = false;
-        pwd = false;
-
-        idx = em4x05_Sniff_GetNextBitStart (idx, GraphTraceLen, GraphBuffer, &pulseSamples);
-        pktOffset = idx;
-        if (pulseSamples >= 10)  { // Should be 18 so a bit less to allow for processing
-        
-            // Use first bit to get "0" bit samples as a reference
-            ZeroWidth = idx;
-            idx = em4x05_Sniff_GetNextBitStart (idx, GraphTraceLen, GraphBuffer, &pulseSamples);
-            ZeroWidth = idx - ZeroWidth;
-
-            if (ZeroWidth <= 50) {
-                pktOffset -= ZeroWidth;
-                memset(bits,0x00,sizeof(bits));
-                bitidx = 0;
-
-                while ((idx < GraphTraceLen) && !eop) {
-                    CycleWidth = idx;
-                    idx = em4x05_Sniff_GetNextBitStart (idx, GraphTraceLen, GraphBuffer, &pulseSamples);
-
-                    CycleWidth = idx - CycleWidth;
-                    if ((CycleWidth > 300) || (CycleWidth < (ZeroWidth-5))) { // to long or too short
-                        eop = true;
-                        bits[bitidx++] = '0';   // Append last zero from the last bit find
-                        cmdText[0] = 0;
-
-                        // EM4305 command lengths
-                        // Login        0011 <pwd>          => 4 +     45 => 49
-                        // Write Word   0101 <adr> <data>   => 4 + 7 + 45 => 56
-                        // Read Word    1001 <adr>          => 4 + 7      => 11
-                        // Protect      1100       <data>   => 4 +     45 => 49
-                        // Disable      1010       <data>   => 4 +     45 => 49
-                        // -> disaable 1010 11111111 0 11111111 0 11111111 0 11111111 0 00000000 0
-
-                        // Check to see if we got the leading 0
-                        if  (((strncmp (bits,"00011",5) == 0)&& (bitidx == 50)) ||
-                             ((strncmp (bits,"00101",5) == 0)&& (bitidx == 57)) ||
-                             ((strncmp (bits,"01001",5) == 0)&& (bitidx == 12)) ||
-                             ((strncmp (bits,"01100",5) == 0)&& (bitidx == 50)) ||
-                             ((strncmp (bits,"01010",5) == 0)&& (bitidx == 50))) {
-                                 memcpy (bits,&bits[1],bitidx-1);
-                                 bitidx--;
-                             printf ("Trim leading 0\n");
-                        }
-                        bits[bitidx] = 0;
-         //   printf ("==> %s\n",bits);
-                        // logon
-                        if ((strncmp (bits,"0011",4) == 0) && (bitidx == 49)) {
-                            haveData = true;
-                            pwd = true;
-                            sprintf (cmdText,"Logon");
-                            sprintf (blkAddr,"   ");
-                            tmpValue = em4x05_Sniff_GetBlock (&bits[4], fwd);
-                            sprintf (dataText,"%08X",tmpValue);
-                        }
-
-                        // write
-                        if ((strncmp (bits,"0101",4) == 0) && (bitidx == 56)) {
-                            haveData = true;
-                            sprintf (cmdText,"Write");
-                            tmpValue = (bits[4] - '0') + ((bits[5] - '0') << 1) + ((bits[6] - '0') << 2)  + ((bits[7] - '0') << 3);
-                            sprintf (blkAddr,"%d",tmpValue);
-                            if (tmpValue == 2)
-                                pwd = true;
-                            tmpValue = em4x05_Sniff_GetBlock (&bits[11], fwd);
-                            sprintf (dataText,"%08X",tmpValue);
-                        }
-
-                        // read
-                        if ((strncmp (bits,"1001",4) == 0) && (bitidx == 11)) {
-                            haveData = true;
-                            pwd = false;
-                            sprintf (cmdText,"Read");
-                            tmpValue = (bits[4] - '0') + ((bits[5] - '0') << 1) + ((bits[6] - '0') << 2)  + ((bits[7] - '0') << 3);
-                            sprintf (blkAddr,"%d",tmpValue);
-                            sprintf (dataText," ");
-                        }
-
-                        // protect
-                        if ((strncmp (bits,"1100",4) == 0) && (bitidx == 49)) {
-                            haveData = true;
-                            pwd = false;
-                            sprintf (cmdText,"Protect");
-                            sprintf (blkAddr," ");
-                            tmpValue = em4x05_Sniff_GetBlock (&bits[11], fwd);
-                            sprintf (dataText,"%08X",tmpValue);
-                        }
-
-                        // disable
-                        if ((strncmp (bits,"1010",4) == 0) && (bitidx == 49)) {
-                            haveData = true;
-                            pwd = false;
-                            sprintf (cmdText,"Disable");
-                            sprintf (blkAddr," ");
-                            tmpValue = em4x05_Sniff_GetBlock (&bits[11], fwd);
-                            sprintf (dataText,"%08X",tmpValue);
-                        }
-
-                      //  bits[bitidx] = 0;
-                    } else {
-                        i = (CycleWidth - ZeroWidth) / 28;
-                        bits[bitidx++] = '0';
-                        for (int ii = 0; ii < i; ii++)
-                            bits[bitidx++] = '1';
-                    }
-                }
-            }
-        }
-        idx++;
-
-        // Print results
-        if (haveData) { //&& (minWidth > 1) && (maxWidth > minWidth)){
-            if (pwd)
-                PrintAndLogEx(SUCCESS, "%6llu | %-10s  | "_YELLOW_("%8s")" | "_YELLOW_("%3s")" | %s", pktOffset, cmdText, dataText, blkAddr, bits);
-            else
-                PrintAndLogEx(SUCCESS, "%6llu | %-10s  | "_GREEN_("%8s")" | "_GREEN_("%3s")" | %s", pktOffset, cmdText, dataText, blkAddr, bits);
-        }
-    }
+    em4x05_sniff_t sniff;
+    em4x05_sniff_init(&sniff, fwd, em4x05_Sniff_Print, NULL);
+    em4x05_sniff_feed(&sniff, GraphBuffer, GraphTraceLen);
+    em4x05_sniff_finish(&sniff);
 
     // footer
     PrintAndLogEx(SUCCESS, "---------------------------------------------------------------------------------------------------");
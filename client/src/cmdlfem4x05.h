@@ -15,6 +15,44 @@
 
 int CmdLFEM4X05(const char *Cmd);
 
+// one command found by the sniffer
+typedef struct {
+    size_t offset;              // sample index the packet starts at
+    char cmd[16];
+    char data[16];
+    char blk[4];
+    bool pwd;                   // password or a write to the password block
+    char raw[80];
+} em4x05_sniff_frame_t;
+
+typedef void (*em4x05_sniff_cb_t)(const em4x05_sniff_frame_t *frame, void *arg);
+
+// EM4x05 command sniffer. Takes the samples in pieces of any size, it only keeps the last two samples
+// and the bits of the packet in progress
+typedef struct {
+    bool fwd;
+    uint8_t state;
+    uint8_t phase;              // bit start search
+    bool searching;
+    bool eof;
+    size_t pos;                 // sample the search is at
+    size_t count;               // samples seen
+    int last[2];
+    size_t pulses;
+    size_t mark;
+    size_t pkt_offset;
+    int zero_width;
+    int bitidx;
+    char bits[80];
+    em4x05_sniff_cb_t cb;
+    void *cb_arg;
+} em4x05_sniff_t;
+
+void em4x05_sniff_init(em4x05_sniff_t *s, bool fwd, em4x05_sniff_cb_t cb, void *arg);
+void em4x05_sniff_feed(em4x05_sniff_t *s, const int *samples, size_t len);
+void em4x05_sniff_finish(em4x05_sniff_t *s);
+
+
 bool EM4x05IsBlock0(uint32_t *word);
 int EM4x05ReadWord_ext(uint8_t addr, uint32_t pwd, bool usePwd, uint32_t *word);
 
@@ -101,7 +101,10 @@ int demodHID(bool verbose) {
     //raw fsk demod no manchester decoding no start bit finding just get binary from wave
     uint32_t hi2 = 0, hi = 0, lo = 0;
 
-    uint8_t bits[GraphTraceLen];
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
+    if (bits == NULL)
+        return PM3_EMALLOC;
+
     size_t size = getFromGraphBuf(bits);
     if (size == 0) {
         PrintAndLogEx(DEBUG, "DEBUG: Error - " _RED_("HID not enough samples"));
@@ -109,7 +112,7 @@ int demodHID(bool verbose) {
     }
     //get binary from fsk wave
     int waveIdx = 0;
-    int idx = HIDdemodFSK(bits, &size, &hi2, &hi, &lo, &waveIdx);
+    int idx = HIDdemodFSK(bits, &size, &hi2, &hi, &lo, &waveIdx, getGraphWaves(bits, size));
     if (idx < 0) {
 
         if (idx == -1)
@@ -309,7 +309,7 @@ static int CmdIndalaDemodAlt(const char *Cmd) {
     // worst case with GraphTraceLen=40000 is < 4096
     // under normal conditions it's < 2048
     uint8_t data[MAX_GRAPH_TRACE_LEN] = {0};
-    size_t datasize = getFromGraphBuf(data);
+    size_t datasize = getFromGraphBufEx(data, sizeof(data));
 
     uint8_t rawbits[4096];
     int rawbit = 0;
@@ -479,6 +479,9 @@ static int CmdIndalaDemodAlt(const char *Cmd) {
     // Remodulating for tag cloning
     // HACK: 2015-01-04 this will have an impact on our new way of seening lf commands (demod)
     // since this changes graphbuffer data.
+    if (reserveGraphBuf(32 * uidlen) == false)
+        return PM3_EMALLOC;
+
     GraphTraceLen = 32 * uidlen;
     i = 0;
     int phase;
@@ -494,6 +497,7 @@ static int CmdIndalaDemodAlt(const char *Cmd) {
         }
     }
 
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
     return PM3_SUCCESS;
 }
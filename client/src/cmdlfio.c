@@ -99,14 +99,14 @@ int demodIOProx(bool verbose) {
     (void) verbose; // unused so far
     int idx = 0, retval = PM3_SUCCESS;
     uint8_t bits[MAX_GRAPH_TRACE_LEN] = {0};
-    size_t size = getFromGraphBuf(bits);
+    size_t size = getFromGraphBufEx(bits, sizeof(bits));
     if (size < 65) {
         PrintAndLogEx(DEBUG, "DEBUG: Error - IO prox not enough samples in GraphBuffer");
         return PM3_ESOFT;
     }
     //get binary from fsk wave
     int waveIdx = 0;
-    idx = detectIOProx(bits, &size, &waveIdx);
+    idx = detectIOProx(bits, &size, &waveIdx, getGraphWaves(bits, size));
     if (idx < 0) {
         if (g_debugMode) {
             if (idx == -1) {
@@ -79,7 +79,7 @@ int demodParadox(bool verbose) {
     (void) verbose; // unused so far
     //raw fsk demod no manchester decoding no start bit finding just get binary from wave
     uint8_t bits[MAX_GRAPH_TRACE_LEN] = {0};
-    size_t size = getFromGraphBuf(bits);
+    size_t size = getFromGraphBufEx(bits, sizeof(bits));
     if (size == 0) {
         PrintAndLogEx(DEBUG, "DEBUG: Error - Paradox not enough samples");
         return PM3_ESOFT;
@@ -87,7 +87,7 @@ int demodParadox(bool verbose) {
 
     int wave_idx = 0;
     //get binary from fsk wave
-    int idx = detectParadox(bits, &size, &wave_idx);
+    int idx = detectParadox(bits, &size, &wave_idx, getGraphWaves(bits, size));
     if (idx < 0) {
         if (idx == -1)
             PrintAndLogEx(DEBUG, "DEBUG: Error - Paradox not enough samples");
@@ -325,14 +325,14 @@ int CmdLFParadox(const char *Cmd) {
 }
 
 // loop to get raw paradox waveform then FSK demodulate the TAG ID from it
-int detectParadox(uint8_t *dest, size_t *size, int *wave_start_idx) {
+int detectParadox(uint8_t *dest, size_t *size, int *wave_start_idx, const lf_waves_t *waves) {
     //make sure buffer has data
     if (*size < 96 * 50) return -1;
 
     if (getSignalProperties()->isnoise) return -2;
 
     // FSK demodulator
-    *size = fskdemod(dest, *size, 50, 1, 10, 8, wave_start_idx); // paradox fsk2a
+    *size = fskdemod(dest, *size, 50, 1, 10, 8, wave_start_idx, waves); // paradox fsk2a
 
     //did we get a good demod?
     if (*size < 96) return -3;
@@ -10,9 +10,10 @@
 #define CMDLFPARADOX_H__
 
 #include "common.h"
+#include "lfdemod.h"     // lf_waves_t
 
 int CmdLFParadox(const char *Cmd);
 
 int demodParadox(bool verbose);
-int detectParadox(uint8_t *dest, size_t *size, int *wave_start_idx);
+int detectParadox(uint8_t *dest, size_t *size, int *wave_start_idx, const lf_waves_t *waves);
 #endif
@@ -70,14 +70,14 @@ int demodPyramid(bool verbose) {
     (void) verbose; // unused so far
     //raw fsk demod no manchester decoding no start bit finding just get binary from wave
     uint8_t bits[MAX_GRAPH_TRACE_LEN] = {0};
-    size_t size = getFromGraphBuf(bits);
+    size_t size = getFromGraphBufEx(bits, sizeof(bits));
     if (size == 0) {
         PrintAndLogEx(DEBUG, "DEBUG: Error - Pyramid not enough samples");
         return PM3_ESOFT;
     }
     //get binary from fsk wave
     int waveIdx = 0;
-    int idx = detectPyramid(bits, &size, &waveIdx);
+    int idx = detectPyramid(bits, &size, &waveIdx, getGraphWaves(bits, size));
     if (idx < 0) {
         if (idx == -1)
             PrintAndLogEx(DEBUG, "DEBUG: Error - Pyramid: not enough samples");
@@ -359,7 +359,7 @@ int getPyramidBits(uint32_t fc, uint32_t cn, uint8_t *pyramidBits) {
 }
 
 // FSK Demod then try to locate a Farpointe Data (pyramid) ID
-int detectPyramid(uint8_t *dest, size_t *size, int *waveStartIdx) {
+int detectPyramid(uint8_t *dest, size_t *size, int *waveStartIdx, const lf_waves_t *waves) {
     //make sure buffer has data
     if (*size < 128 * 50) return -1;
 
@@ -367,7 +367,7 @@ int detectPyramid(uint8_t *dest, size_t *size, int *waveStartIdx) {
     if (getSignalProperties()->isnoise) return -2;
 
     // FSK demodulator RF/50 FSK 10,8
-    *size = fskdemod(dest, *size, 50, 1, 10, 8, waveStartIdx);  // pyramid fsk2
+    *size = fskdemod(dest, *size, 50, 1, 10, 8, waveStartIdx, waves);  // pyramid fsk2
 
     //did we get a good demod?
     if (*size < 128) return -3;
@@ -10,11 +10,12 @@
 #define CMDLFPYRAMID_H__
 
 #include "common.h"
+#include "lfdemod.h"     // lf_waves_t
 
 int CmdLFPyramid(const char *Cmd);
 
 int demodPyramid(bool verbose);
-int detectPyramid(uint8_t *dest, size_t *size, int *waveStartIdx);
+int detectPyramid(uint8_t *dest, size_t *size, int *waveStartIdx, const lf_waves_t *waves);
 int getPyramidBits(uint32_t fc, uint32_t cn, uint8_t *pyramidBits);
 #endif
 
@@ -3784,29 +3784,288 @@ static uint8_t t55sniffTrimSamples(int *pulseBuffer, int *pulseIdx, uint8_t len)
         pulseBuffer[ii] = pulseBuffer[ii + len];
     }
 
-    *pulseIdx -= len;
+    // the packet may have used stale widths past the last pulse
+    *pulseIdx = (*pulseIdx > len) ? *pulseIdx - len : 0;
     return PM3_SUCCESS;
 }
 
-static int CmdT55xxSniff(const char *Cmd) {
+// Check one pulse width for valid packets, pulses are kept until a packet uses them.
+static void t55sniffPulse(t55xx_sniff_t *s, int pulseSamples) {
 
-    bool sampleData = true;
     bool haveData = false;
-    uint8_t cmdp = 0;
-    uint8_t width0 = 0, width1 = 0;
-    uint8_t tolerance = 5, page, blockAddr;
+    uint8_t page = 0, blockAddr = 0;
     uint16_t dataLen = 0;
-    size_t idx = 0;
     uint32_t usedPassword, blockData;
-    int pulseSamples = 0;
-    int pulseIdx = 0;
     int minWidth = 1000;
     int maxWidth = 0;
-    char modeText [100];
-    char pwdText  [100];
-    char dataText [100];
-    int pulseBuffer[80] = { 0 }; // max should be 73 +/- - Holds Pulse widths
-    char data[80]; //  linked to pulseBuffer. - Holds 0/1 from pulse widths
+    uint8_t tolerance = s->tolerance;
+    int *pulseBuffer = s->pulse_buffer;
+    t55xx_sniff_frame_t f;
+    char *data = f.raw; //  linked to pulseBuffer. - Holds 0/1 from pulse widths
+
+    memset(&f, 0, sizeof(f));
+    sprintf(f.mode, "Default");
+    sprintf(f.pwd, " ");
+    sprintf(f.data, " ");
+
+    pulseBuffer[s->pulse_idx++] = pulseSamples;
+    if (s->pulse_idx > 79) { // make room for next sample - if not used by now, it wont be.
+        t55sniffTrimSamples(pulseBuffer, &s->pulse_idx, 1);
+    }
+
+    // Check Samples for valid packets;
+    // We should find (outside of leading bits) we have a packet of "1" and "0" at same widths.
+    if (s->pulse_idx >= 6) {// min size for a read - ignoring 1of4 10 0 <adr>
+
+        // We auto find widths
+        if ((s->width0 == 0) && (s->width1 == 0)) {
+            // We ignore bit 0 for the moment as it may be a ref. pulse, so check last
+            uint8_t ii = 2;
+            minWidth = pulseBuffer[1];
+            maxWidth = pulseBuffer[1];
+            bool done = false;
+
+            while ((!done) && (ii < s->pulse_idx) && ((maxWidth <= minWidth) || (approxEq(minWidth, maxWidth, tolerance)))) { // min should be 8, 16-32 more normal
+                if (pulseBuffer[ii] + 3 < minWidth) {
+                    minWidth = pulseBuffer[ii];
+                    done = true;
+                }
+                if (pulseBuffer[ii] - 1 > maxWidth) {
+                    maxWidth = pulseBuffer[ii];
+                    done = true;
+                }
+                ii++;
+            }
+        } else {
+            minWidth = s->width0;
+            maxWidth = s->width1;
+        }
+    }
+
+    //  out of bounds... min max far enough appart and minWidth is large enough
+    if (((maxWidth - minWidth) < 6) || (minWidth < 6)) // min 8 +/-
+        return;
+
+    // At this point we should have
+    // - a min of 6 samples
+    // - the 0 and 1 sample widths
+    // - min 0 and min seperations (worst case)
+    // No max checks done (yet) as have seen samples > then specs in use.
+
+    // Check first bit.
+
+    // Long leading 0
+    if (haveData == false && (approxEq(pulseBuffer[0], 136 + minWidth, tolerance) && approxEq(pulseBuffer[1], maxWidth, tolerance))) {
+        // printf ("Long Leading 0 - not yet hanled | have 1 Fisrt bit | Min : %-3d - Max : %-3d : diff : %d\n",minWidth,maxWidth, maxWidth-minWidth);
+        return;
+    }
+
+    // Fixed bit - Default
+    if (haveData == false && (approxEq(pulseBuffer[0], maxWidth, tolerance))) {
+        dataLen = t55sniffGetPacket(pulseBuffer, data, minWidth, maxWidth, tolerance);
+
+        //   if ((dataLen == 39) )
+        //           printf ("Fixed | Data end of 80 samples | offset : %llu - datalen %-2d - data : %s  --- - Bit 0 width : %d\n",idx,dataLen,data,pulseBuffer[0]);
+
+        if (data[0] == '0') { // should never get here..
+            dataLen = 0;
+            data[0] = 0;
+        } else {
+
+            // Default Read
+            if (dataLen == 6) {
+                t55sniffTrimSamples(pulseBuffer, &s->pulse_idx, 4); // left 1 or 2 samples seemed to help
+
+                page = data[1] - '0';
+                blockAddr = 0;
+                for (uint8_t i = 3; i < 6; i++) {
+                    blockAddr <<= 1;
+                    if (data[i] == '1')
+                        blockAddr |= 1;
+                }
+                blockData = 0;
+                haveData = true;
+                sprintf(f.mode, "Default Read");
+            }
+
+            // Password Write
+            if (dataLen == 70) {
+                t55sniffTrimSamples(pulseBuffer, &s->pulse_idx, 70);
+
+                page = data[1] - '0';
+                usedPassword = 0;
+                for (uint8_t i = 2; i <= 33; i++) {
+                    usedPassword <<= 1;
+                    if (data[i] == '1')
+                        usedPassword |= 1;
+                }
+                // Lock bit 34
+                blockData = 0;
+                for (uint8_t i = 35; i <= 66; i++) {
+                    blockData <<= 1;
+                    if (data[i] == '1')
+                        blockData |= 1;
+                }
+                blockAddr = 0;
+                for (uint8_t i = 67; i <= 69; i++) {
+                    blockAddr <<= 1;
+                    if (data[i] == '1')
+                        blockAddr |= 1;
+                }
+                haveData = true;
+                sprintf(f.mode, "Default pwd write");
+                sprintf(f.pwd, "%08X", usedPassword);
+                sprintf(f.data, "%08X", blockData);
+            }
+
+            // Default Write (or password read ??)
+            if (dataLen == 38) {
+                t55sniffTrimSamples(pulseBuffer, &s->pulse_idx, 38);
+
+                page = data[1] - '0';
+                usedPassword = 0;
+                blockData = 0;
+                for (uint8_t i = 3; i <= 34; i++) {
+                    blockData <<= 1;
+                    if (data[i] == '1')
+                        blockData |= 1;
+                }
+                blockAddr = 0;
+                for (uint8_t i = 35; i <= 37; i++) {
+                    blockAddr <<= 1;
+                    if (data[i] == '1')
+                        blockAddr |= 1;
+                }
+                haveData = true;
+                sprintf(f.mode, "Default write");
+                sprintf(f.data, "%08X", blockData);
+            }
+        }
+    }
+
+    // Leading 0
+    if (haveData == false && (approxEq(pulseBuffer[0], minWidth, tolerance))) {
+        // leading 0 (should = 0 width)
+        // 1 of 4 (leads with 00)
+        dataLen = t55sniffGetPacket(pulseBuffer, data, minWidth, maxWidth, tolerance);
+        // **** Should check to 0 to be actual 0 as well i.e. 01 .... data ....
+        if ((data[0] == '0') && (data[1] == '1')) {
+            if (dataLen == 73) {
+                t55sniffTrimSamples(pulseBuffer, &s->pulse_idx, 73);
+
+                page = data[2] - '0';
+                usedPassword = 0;
+                for (uint8_t i = 5; i <= 36; i++) {
+                    usedPassword <<= 1;
+                    if (data[i] == '1')
+                        usedPassword |= 1;
+                }
+                blockData = 0;
+                for (uint8_t i = 38; i <= 69; i++) {
+                    blockData <<= 1;
+                    if (data[i] == '1')
+                        blockData |= 1;
+                }
+                blockAddr = 0;
+                for (uint8_t i = 70; i <= 72; i++) {
+                    blockAddr <<= 1;
+                    if (data[i] == '1')
+                        blockAddr |= 1;
+                }
+                haveData = true;
+                sprintf(f.mode, "Leading 0 pwd write");
+                sprintf(f.pwd, "%08X", usedPassword);
+                sprintf(f.data, "%08X", blockData);
+            }
+        }
+    }
+
+    if (haveData && s->cb) { //&& (minWidth > 1) && (maxWidth > minWidth)){
+        f.offset = s->idx;
+        f.blk = blockAddr;
+        f.page = page;
+        f.width0 = minWidth;
+        f.width1 = maxWidth;
+        s->cb(&f, s->cb_arg);
+    }
+}
+
+enum {
+    T55_SNIFF_SKIP,         // skip one sample after a zero length pulse
+    T55_SNIFF_FIND_HIGH,
+    T55_SNIFF_COUNT_HIGH,
+};
+
+void t55xx_sniff_init(t55xx_sniff_t *s, uint8_t width0, uint8_t width1, uint8_t tolerance, t55xx_sniff_cb_t cb, void *arg) {
+    memset(s, 0, sizeof(t55xx_sniff_t));
+    s->width0 = width0;
+    s->width1 = width1;
+    s->tolerance = tolerance;
+    s->state = T55_SNIFF_SKIP;
+    s->cb = cb;
+    s->cb_arg = arg;
+}
+
+void t55xx_sniff_feed(t55xx_sniff_t *s, const int *samples, size_t len) {
+
+    for (size_t i = 0; i < len;) {
+        int sample = samples[i];
+        switch (s->state) {
+            case T55_SNIFF_SKIP:
+                i++;
+                s->idx++;
+                s->state = T55_SNIFF_FIND_HIGH;
+                break;
+            case T55_SNIFF_FIND_HIGH:
+                if (sample < 0) {
+                    i++;
+                    s->idx++;
+                    break;
+                }
+                s->pulse_samples = 0;
+                s->state = T55_SNIFF_COUNT_HIGH;
+                break;
+            case T55_SNIFF_COUNT_HIGH:
+                // last bit seems to be high to zero, but can vary in width..
+                if (sample > 0) {
+                    s->pulse_samples++;
+                    i++;
+                    s->idx++;
+                    break;
+                }
+                if (s->pulse_samples > 0) {
+                    t55sniffPulse(s, s->pulse_samples);
+                    s->state = T55_SNIFF_FIND_HIGH;
+                } else {
+                    s->state = T55_SNIFF_SKIP;
+                }
+                break;
+        }
+    }
+}
+
+void t55xx_sniff_finish(t55xx_sniff_t *s) {
+    if (s->state == T55_SNIFF_COUNT_HIGH && s->pulse_samples > 0)
+        t55sniffPulse(s, s->pulse_samples);
+
+    s->state = T55_SNIFF_SKIP;
+    s->pulse_samples = 0;
+}
+
+static void t55sniffPrint(const t55xx_sniff_frame_t *f, void *arg) {
+    (void)arg;
+    if (f->blk == 7)
+        PrintAndLogEx(SUCCESS, "%-20s  | "_GREEN_("%8s")" | "_YELLOW_("%8s")" |  "_YELLOW_("%d")"  |   "_GREEN_("%d")"  | %3d | %3d | %s", f->mode, f->pwd, f->data, f->blk, f->page, f->width0, f->width1, f->raw);
+    else
+        PrintAndLogEx(SUCCESS, "%-20s  | "_GREEN_("%8s")" | "_GREEN_("%8s")" |  "_GREEN_("%d")"  |   "_GREEN_("%d")"  | %3d | %3d | %s", f->mode, f->pwd, f->data, f->blk, f->page, f->width0, f->width1, f->raw);
+}
+
+static int CmdT55xxSniff(const char *Cmd) {
+
+    bool sampleData = true;
+    uint8_t cmdp = 0;
+    uint8_t width0 = 0, width1 = 0;
+    uint8_t tolerance = 5;
 
 
     /*
@@ -3877,217 +4136,10 @@ static int CmdT55xxSniff(const char *Cmd) {
     PrintAndLogEx(SUCCESS, "Downlink mode         | password |   Data   | blk | page |  0  |  1  | raw");
     PrintAndLogEx(SUCCESS, "----------------------+----------+----------+-----+------+-----+-----+-------------------------------------------------------------------------------");
 
-    idx = 0;
-    // loop though sample buffer
-    while (idx < GraphTraceLen) {
-
-        minWidth = 1000;
-        maxWidth = 0;
-        dataLen = 0;
-        data[0] = 0;
-        haveData = false;
-        sprintf(modeText, "Default");
-        sprintf(pwdText, " ");
-        sprintf(dataText, " ");
-
-        if (pulseSamples == 0) {
-            idx++;
-        }
-
-        // find high
-        while ((idx < GraphTraceLen) && (GraphBuffer[idx] < 0)) {
-            idx++;
-        }
-
-        // count high samples
-        pulseSamples = 0;
-        while ((idx < GraphTraceLen) && (GraphBuffer[idx] > 0)) { // last bit seems to be high to zero, but can vary in width..
-            pulseSamples++;
-            idx++;
-        }
-
-        if (pulseSamples > 0) {
-            pulseBuffer[pulseIdx++] = pulseSamples;
-            if (pulseIdx > 79) { // make room for next sample - if not used by now, it wont be.
-                t55sniffTrimSamples(pulseBuffer, &pulseIdx, 1);
-            }
-
-            // Check Samples for valid packets;
-            // We should find (outside of leading bits) we have a packet of "1" and "0" at same widths.
-            if (pulseIdx >= 6) {// min size for a read - ignoring 1of4 10 0 <adr>
-
-                // We auto find widths
-                if ((width0 == 0) && (width1 == 0)) {
-                    // We ignore bit 0 for the moment as it may be a ref. pulse, so check last
-                    uint8_t ii = 2;
-                    minWidth = pulseBuffer[1];
-                    maxWidth = pulseBuffer[1];
-                    bool done = false;
-
-                    while ((!done) && (ii < pulseIdx) && ((maxWidth <= minWidth) || (approxEq(minWidth, maxWidth, tolerance)))) { // min should be 8, 16-32 more normal
-                        if (pulseBuffer[ii] + 3 < minWidth) {
-                            minWidth = pulseBuffer[ii];
-                            done = true;
-                        }
-                        if (pulseBuffer[ii] - 1 > maxWidth) {
-                            maxWidth = pulseBuffer[ii];
-                            done = true;
-                        }
-                        ii++;
-                    }
-                } else {
-                    minWidth = width0;
-                    maxWidth = width1;
-                }
-            }
-
-            //  out of bounds... min max far enough appart and minWidth is large enough
-            if (((maxWidth - minWidth) < 6) || (minWidth < 6)) // min 8 +/-
-                continue;
-
-            // At this point we should have
-            // - a min of 6 samples
-            // - the 0 and 1 sample widths
-            // - min 0 and min seperations (worst case)
-            // No max checks done (yet) as have seen samples > then specs in use.
-
-            // Check first bit.
-
-            // Long leading 0
-            if (haveData == false && (approxEq(pulseBuffer[0], 136 + minWidth, tolerance) && approxEq(pulseBuffer[1], maxWidth, tolerance))) {
-                // printf ("Long Leading 0 - not yet hanled | have 1 Fisrt bit | Min : %-3d - Max : %-3d : diff : %d\n",minWidth,maxWidth, maxWidth-minWidth);
-                continue;
-            }
-
-            // Fixed bit - Default
-            if (haveData == false && (approxEq(pulseBuffer[0], maxWidth, tolerance))) {
-                dataLen = t55sniffGetPacket(pulseBuffer, data, minWidth, maxWidth, tolerance);
-
-                //   if ((dataLen == 39) )
-                //           printf ("Fixed | Data end of 80 samples | offset : %llu - datalen %-2d - data : %s  --- - Bit 0 width : %d\n",idx,dataLen,data,pulseBuffer[0]);
-
-                if (data[0] == '0') { // should never get here..
-                    dataLen = 0;
-                    data[0] = 0;
-                } else {
-
-                    // Default Read
-                    if (dataLen == 6) {
-                        t55sniffTrimSamples(pulseBuffer, &pulseIdx, 4); // left 1 or 2 samples seemed to help
-
-                        page = data[1] - '0';
-                        blockAddr = 0;
-                        for (uint8_t i = 3; i < 6; i++) {
-                            blockAddr <<= 1;
-                            if (data[i] == '1')
-                                blockAddr |= 1;
-                        }
-                        blockData = 0;
-                        haveData = true;
-                        sprintf(modeText, "Default Read");
-                    }
-
-                    // Password Write
-                    if (dataLen == 70) {
-                        t55sniffTrimSamples(pulseBuffer, &pulseIdx, 70);
-
-                        page = data[1] - '0';
-                        usedPassword = 0;
-                        for (uint8_t i = 2; i <= 33; i++) {
-                            usedPassword <<= 1;
-                            if (data[i] == '1')
-                                usedPassword |= 1;
-                        }
-                        // Lock bit 34
-                        blockData = 0;
-                        for (uint8_t i = 35; i <= 66; i++) {
-                            blockData <<= 1;
-                            if (data[i] == '1')
-                                blockData |= 1;
-                        }
-                        blockAddr = 0;
-                        for (uint8_t i = 67; i <= 69; i++) {
-                            blockAddr <<= 1;
-                            if (data[i] == '1')
-                                blockAddr |= 1;
-                        }
-                        haveData = true;
-                        sprintf(modeText, "Default pwd write");
-                        sprintf(pwdText, "%08X", usedPassword);
-                        sprintf(dataText, "%08X", blockData);
-                    }
-
-                    // Default Write (or password read ??)
-                    if (dataLen == 38) {
-                        t55sniffTrimSamples(pulseBuffer, &pulseIdx, 38);
-
-                        page = data[1] - '0';
-                        usedPassword = 0;
-                        blockData = 0;
-                        for (uint8_t i = 3; i <= 34; i++) {
-                            blockData <<= 1;
-                            if (data[i] == '1')
-                                blockData |= 1;
-                        }
-                        blockAddr = 0;
-                        for (uint8_t i = 35; i <= 37; i++) {
-                            blockAddr <<= 1;
-                            if (data[i] == '1')
-                                blockAddr |= 1;
-                        }
-                        haveData = true;
-                        sprintf(modeText, "Default write");
-                        sprintf(dataText, "%08X", blockData);
-                    }
-                }
-            }
-
-            // Leading 0
-            if (haveData == false && (approxEq(pulseBuffer[0], minWidth, tolerance))) {
-                // leading 0 (should = 0 width)
-                // 1 of 4 (leads with 00)
-                dataLen = t55sniffGetPacket(pulseBuffer, data, minWidth, maxWidth, tolerance);
-                // **** Should check to 0 to be actual 0 as well i.e. 01 .... data ....
-                if ((data[0] == '0') && (data[1] == '1')) {
-                    if (dataLen == 73) {
-                        t55sniffTrimSamples(pulseBuffer, &pulseIdx, 73);
-
-                        page = data[2] - '0';
-                        usedPassword = 0;
-                        for (uint8_t i = 5; i <= 36; i++) {
-                            usedPassword <<= 1;
-                            if (data[i] == '1')
-                                usedPassword |= 1;
-                        }
-                        blockData = 0;
-                        for (uint8_t i = 38; i <= 69; i++) {
-                            blockData <<= 1;
-                            if (data[i] == '1')
-                                blockData |= 1;
-                        }
-                        blockAddr = 0;
-                        for (uint8_t i = 70; i <= 72; i++) {
-                            blockAddr <<= 1;
-                            if (data[i] == '1')
-                                blockAddr |= 1;
-                        }
-                        haveData = true;
-                        sprintf(modeText, "Leading 0 pwd write");
-                        sprintf(pwdText, "%08X", usedPassword);
-                        sprintf(dataText, "%08X", blockData);
-                    }
-                }
-            }
-        }
-
-        // Print results
-        if (haveData) { //&& (minWidth > 1) && (maxWidth > minWidth)){
-            if (blockAddr == 7)
-                PrintAndLogEx(SUCCESS, "%-20s  | "_GREEN_("%8s")" | "_YELLOW_("%8s")" |  "_YELLOW_("%d")"  |   "_GREEN_("%d")"  | %3d | %3d | %s", modeText, pwdText, dataText, blockAddr, page, minWidth, maxWidth, data);
-            else
-                PrintAndLogEx(SUCCESS, "%-20s  | "_GREEN_("%8s")" | "_GREEN_("%8s")" |  "_GREEN_("%d")"  |   "_GREEN_("%d")"  | %3d | %3d | %s", modeText, pwdText, dataText, blockAddr, page, minWidth, maxWidth, data);
-        }
-    }
+    t55xx_sniff_t sniff;
+    t55xx_sniff_init(&sniff, width0, width1, tolerance, t55sniffPrint, NULL);
+    t55xx_sniff_feed(&sniff, GraphBuffer, GraphTraceLen);
+    t55xx_sniff_finish(&sniff);
 
     // footer
     PrintAndLogEx(SUCCESS, "-----------------------------------------------------------------------------------------------------------------------------------------------------");
@@ -152,6 +152,41 @@ typedef struct {
     bool valid;
 }  t55xx_memory_item_t ;
 
+// one downlink command found by the sniffer
+typedef struct {
+    size_t offset;              // sample index the last pulse of the command ended at
+    char mode[24];
+    char pwd[9];
+    char data[9];
+    uint8_t blk;
+    uint8_t page;
+    int width0;
+    int width1;
+    char raw[80];
+} t55xx_sniff_frame_t;
+
+typedef void (*t55xx_sniff_cb_t)(const t55xx_sniff_frame_t *frame, void *arg);
+
+// T55xx downlink sniffer. Takes the samples in pieces of any size, the pulse state is kept in between,
+// so a live stream decodes the same as the whole capture at once
+typedef struct {
+    uint8_t width0;             // 0 and 1 pulse widths, 0 for auto detect
+    uint8_t width1;
+    uint8_t tolerance;
+    uint8_t state;
+    size_t idx;
+    int pulse_samples;
+    int pulse_idx;
+    int pulse_buffer[80];       // max should be 73 +/- - Holds Pulse widths
+    t55xx_sniff_cb_t cb;
+    void *cb_arg;
+} t55xx_sniff_t;
+
+void t55xx_sniff_init(t55xx_sniff_t *s, uint8_t width0, uint8_t width1, uint8_t tolerance, t55xx_sniff_cb_t cb, void *arg);
+void t55xx_sniff_feed(t55xx_sniff_t *s, const int *samples, size_t len);
+// end of samples, a pulse still being counted is taken as complete
+void t55xx_sniff_finish(t55xx_sniff_t *s);
+
 t55xx_conf_block_t Get_t55xx_Config(void);
 void Set_t55xx_Config(t55xx_conf_block_t conf);
 
@@ -122,6 +122,7 @@ int demodTI(bool verbose) {
     }
 
     GraphTraceLen -= (convLen + 16);
+    demod_ctx_touch(demod_ctx());
 
     RepaintGraphWindow();
 
@@ -207,6 +208,7 @@ int demodTI(bool verbose) {
         GraphBuffer[maxPos + 1] = -800;
     }
 
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
 
     PrintAndLogEx(DEBUG, "TI tag : raw tag bits | %s", bits);
@@ -250,7 +252,6 @@ int demodTI(bool verbose) {
             (shift1 >> 16) & 0xFF,
             (shift1 >> 24) & 0xFF
         };
-        init_table(CRC_KERMIT);
         uint16_t calccrc = crc16_kermit(raw, sizeof(raw));
         const char *crc_str = (calccrc == (shift2 & 0xFFFF)) ? _GREEN_("ok") : _RED_("fail");
         PrintAndLogEx(INFO, "Tag data = %08X%08X  [%04X] (%s)", shift1, shift0, calccrc, crc_str);
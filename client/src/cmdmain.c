@@ -23,6 +23,7 @@
 #include "comms.h"
 #include "cmdhf.h"
 #include "cmddata.h"
+#include "cmddict.h"
 #include "cmdhw.h"
 #include "cmdlf.h"
 #include "cmdtrace.h"
@@ -258,6 +259,7 @@ static command_t CommandTable[] = {
 
     {"analyse", CmdAnalyse,   AlwaysAvailable,         "{ Analyse utils... }"},
     {"data",    CmdData,      AlwaysAvailable,         "{ Plot window / data buffer manipulation... }"},
+    {"dict",    CmdDict,      AlwaysAvailable,         "{ Dictionary manipulation... }"},
     {"emv",     CmdEMV,       AlwaysAvailable,         "{ EMV ISO-14443 / ISO-7816... }"},
     {"hf",      CmdHF,        AlwaysAvailable,         "{ High frequency commands... }"},
     {"hw",      CmdHW,        AlwaysAvailable,         "{ Hardware commands... }"},
@@ -12,6 +12,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <pthread.h>
 
 #ifdef HAVE_PYTHON
 //#define PY_SSIZE_T_CLEAN
@@ -31,6 +34,9 @@
 #include "proxmark3.h"
 #include "ui.h"
 #include "fileutils.h"
+#include "cliparser.h"
+#include "util.h"         // num_CPUs
+#include "util_posix.h"   // msclock
 
 #ifdef HAVE_PYTHON
 // Partly ripped from PyRun_SimpleFileExFlags
@@ -258,6 +264,7 @@ static int CmdScriptRun(const char *Cmd) {
         PrintAndLogEx(SUCCESS, "args " _YELLOW_("'%s'"), arguments);
 
         luascriptfile_idx++;
+        uint64_t t1 = msclock();
 
         // create new Lua state
         lua_State *lua_state;
@@ -275,8 +282,11 @@ static int CmdScriptRun(const char *Cmd) {
         //Add the 'bit' library
         set_bit_library(lua_state);
 
-        error = luaL_loadfile(lua_state, script_path);
+        error = lua_cache_loadfile(lua_state, script_path);
         free(script_path);
+        t1 = msclock() - t1;
+        lua_cache_stats_t loaded;
+        lua_cache_get_stats(lua_state, &loaded);
         if (!error) {
             lua_pushstring(lua_state, arguments);
             lua_setglobal(lua_state, "args");
@@ -295,11 +305,17 @@ static int CmdScriptRun(const char *Cmd) {
             PrintAndLogEx(FAILED, _RED_("error") " - %s", str);
         }
 
+        // state setup and the script, then the modules it required
+        lua_cache_stats_t stats;
+        lua_cache_get_stats(lua_state, &stats);
+        t1 += stats.ms - loaded.ms;
+
         //luaL_dofile(lua_state, buf);
         // close the Lua state
         lua_close(lua_state);
         luascriptfile_idx--;
         PrintAndLogEx(SUCCESS, "\nfinished " _YELLOW_("%s"), preferredName);
+        PrintAndLogEx(INFO, "startup " _YELLOW_("%" PRIu64) " ms, %u chunks from cache, %u compiled", t1, stats.hits, stats.compiled);
         return PM3_SUCCESS;
     }
 
@@ -415,10 +431,343 @@ static int CmdScriptRun(const char *Cmd) {
     return ret;
 }
 
+// output of print() for one item
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} script_batch_out_t;
+
+typedef struct {
+    const char *script_path;
+    char **items;
+    size_t count;
+    char **results;         // what the script printed
+    char **errors;          // why it failed
+    size_t next;
+    char *error;            // the script didn't load
+    pthread_mutex_t lock;
+} script_batch_job_t;
+
+static void script_batch_append(script_batch_out_t *out, const char *s, size_t len) {
+    if (out->len + len + 1 > out->cap) {
+        size_t cap = MAX(out->cap * 2, out->len + len + 64);
+        char *tmp = realloc(out->buf, cap);
+        if (tmp == NULL)
+            return;
+        out->buf = tmp;
+        out->cap = cap;
+    }
+    memcpy(out->buf + out->len, s, len);
+    out->len += len;
+    out->buf[out->len] = '\0';
+}
+
+// print() of the batch states, as l_printandlogex but into the result of the current item.
+// Every argument goes through tostring, nil, booleans and tables are printed as well
+static int l_batch_print(lua_State *L) {
+    script_batch_out_t *out = lua_touserdata(L, lua_upvalueindex(1));
+    int n = lua_gettop(L);
+    for (int i = 1; i <= n; i++) {
+        size_t len;
+        const char *s = luaL_tolstring(L, i, &len);
+        script_batch_append(out, s, len);
+        script_batch_append(out, "\t", 1);
+        lua_pop(L, 1);
+    }
+    script_batch_append(out, "\n", 1);
+    return 0;
+}
+
+// io.write() of the batch states, into the result as well
+static int l_batch_write(lua_State *L) {
+    script_batch_out_t *out = lua_touserdata(L, lua_upvalueindex(1));
+    int n = lua_gettop(L);
+    for (int i = 1; i <= n; i++) {
+        size_t len;
+        const char *s = luaL_checklstring(L, i, &len);
+        script_batch_append(out, s, len);
+    }
+    return 0;
+}
+
+// a prompt would wait for ever, the batch has no console
+static int l_batch_read(lua_State *L) {
+    return luaL_error(L, "no console input in script batch");
+}
+
+// io.open() of the batch states, read only: the workers run side by side and
+// would write over each other's files
+static int l_batch_open(lua_State *L) {
+    const char *mode = luaL_optstring(L, 2, "r");
+    if (mode[0] != 'r' || strchr(mode, '+') != NULL)
+        return luaL_error(L, "no file writes in script batch");
+
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_insert(L, 1);
+    lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+    return lua_gettop(L);
+}
+
+// drops name from the table on top of the stack
+static void script_batch_strip(lua_State *L, const char *name) {
+    lua_pushnil(L);
+    lua_setfield(L, -2, name);
+}
+
+static void *script_batch_worker(void *arg) {
+    script_batch_job_t *job = (script_batch_job_t *)arg;
+
+    // every worker has its own state, with only the offline pm3 functions
+    lua_State *L = luaL_newstate();
+    luaL_openlibs(L);
+    set_pm3_offline_libraries(L);
+    set_bin_library(L);
+    set_bit_library(L);
+
+    // a script must not end the client, run commands or touch files
+    lua_getglobal(L, "os");
+    script_batch_strip(L, "exit");
+    script_batch_strip(L, "execute");
+    script_batch_strip(L, "remove");
+    script_batch_strip(L, "rename");
+    script_batch_strip(L, "tmpname");
+    lua_pop(L, 1);
+
+    lua_getglobal(L, "io");
+    script_batch_strip(L, "popen");
+    script_batch_strip(L, "output");
+    script_batch_strip(L, "tmpfile");
+    lua_getfield(L, -1, "open");
+    lua_pushcclosure(L, l_batch_open, 1);
+    lua_setfield(L, -2, "open");
+    lua_pop(L, 1);
+
+    script_batch_out_t out = {0};
+    lua_pushlightuserdata(L, &out);
+    lua_pushcclosure(L, l_batch_print, 1);
+    lua_setglobal(L, "print");
+
+    lua_getglobal(L, "io");
+    lua_pushlightuserdata(L, &out);
+    lua_pushcclosure(L, l_batch_write, 1);
+    lua_setfield(L, -2, "write");
+    lua_pushcfunction(L, l_batch_read);
+    lua_setfield(L, -2, "read");
+    lua_pop(L, 1);
+
+    // the chunk is loaded once and run for every item
+    if (lua_cache_loadfile(L, job->script_path) != LUA_OK) {
+        pthread_mutex_lock(&job->lock);
+        if (job->error == NULL)
+            job->error = str_dup(lua_tostring(L, -1));
+        pthread_mutex_unlock(&job->lock);
+        lua_close(L);
+        return NULL;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->count)
+            break;
+
+        lua_pushstring(L, job->items[i]);
+        lua_setglobal(L, "args");
+
+        out.len = 0;
+        lua_pushvalue(L, 1);
+        if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+            const char *err = lua_tostring(L, -1);
+            job->errors[i] = str_dup(err ? err : "error - but no error (?!)");
+        }
+        lua_settop(L, 1);
+
+        // the result takes the buffer
+        job->results[i] = out.buf;
+        out.buf = NULL;
+        out.len = 0;
+        out.cap = 0;
+    }
+
+    lua_close(L);
+    return NULL;
+}
+
+static int script_batch_load_items(const char *filename, char ***items, size_t *count) {
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        PrintAndLogEx(ERR, "Error: Could not open file ["_YELLOW_("%s")"]", filename);
+        return PM3_EFILE;
+    }
+
+    size_t cap = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        // skip comments and empty lines
+        char *p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '#' || *p == '\0')
+            continue;
+
+        if (*count == cap) {
+            cap = cap ? cap * 2 : 64;
+            char **tmp = realloc(*items, cap * sizeof(char *));
+            if (tmp == NULL) {
+                fclose(f);
+                return PM3_EMALLOC;
+            }
+            *items = tmp;
+        }
+        (*items)[(*count)++] = str_dup(p);
+    }
+    fclose(f);
+
+    if (*count == 0) {
+        PrintAndLogEx(WARNING, "no items in file ["_YELLOW_("%s")"]", filename);
+        return PM3_EINVARG;
+    }
+    return PM3_SUCCESS;
+}
+
+static int CmdScriptBatch(const char *Cmd) {
+    CLIParserContext *ctx;
+    CLIParserInit(&ctx, "script batch",
+                  "Runs a Lua script once for every line of a file, the line is the script's args.\n"
+                  "The lines are shared out over threads, each with its own Lua state that only has\n"
+                  "the pm3 functions that don't need the device. What the script prints is shown per line, in order.\n"
+                  "A state runs many lines, so globals a script sets are still there on its next line.\n"
+                  "The states can't run commands or write files: os.execute, os.remove, os.rename, io.popen\n"
+                  "and io.output are gone and io.open only reads. io.read and os.exit are gone as well.",
+                  "script batch -n data_hex_crc -f frames.txt\n"
+                  "script batch -n data_hex_crc -f frames.txt -t 4"
+                 );
+
+    void *argtable[] = {
+        arg_param_begin,
+        arg_str1("n", "name", "<script>", "Lua script name"),
+        arg_str1("f", "file", "<filename>", "file with the args, one line per run"),
+        arg_int0("t", "threads", "<dec>", "number of threads (def: number of CPUs)"),
+        arg_param_end
+    };
+    CLIExecWithReturn(ctx, Cmd, argtable, false);
+
+    char name[128] = {0};
+    int nlen = 0;
+    CLIParamStrToBuf(arg_get_str(ctx, 1), (uint8_t *)name, sizeof(name) - 1, &nlen);
+
+    char filename[FILE_PATH_SIZE] = {0};
+    int fnlen = 0;
+    CLIParamStrToBuf(arg_get_str(ctx, 2), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+
+    int threads = arg_get_int_def(ctx, 3, num_CPUs());
+    CLIParserFree(ctx);
+
+    char *script_path = NULL;
+    if (searchFile(&script_path, LUA_SCRIPTS_SUBDIR, name, ".lua", false) != PM3_SUCCESS)
+        return PM3_EFILE;
+
+    char **items = NULL;
+    size_t count = 0;
+    int res = script_batch_load_items(filename, &items, &count);
+    if (res != PM3_SUCCESS) {
+        for (size_t i = 0; i < count; i++)
+            free(items[i]);
+        free(items);
+        free(script_path);
+        return res;
+    }
+
+    script_batch_job_t job = {
+        .script_path = script_path,
+        .items = items,
+        .count = count,
+        .results = calloc(count, sizeof(char *)),
+        .errors = calloc(count, sizeof(char *)),
+    };
+
+    if (job.results == NULL || job.errors == NULL) {
+        res = PM3_EMALLOC;
+        goto out;
+    }
+
+    threads = MAX(1, MIN(threads, (int)MIN(count, 64)));
+    PrintAndLogEx(SUCCESS, "executing lua " _YELLOW_("%s") " on " _YELLOW_("%zu") " lines, %d thread%s", script_path, count, threads, (threads == 1) ? "" : "s");
+
+    pthread_mutex_init(&job.lock, NULL);
+    uint64_t t1 = msclock();
+
+    pthread_t tids[64];
+    int started = 0;
+    // the calling thread works too
+    for (; started < threads - 1; started++) {
+        if (pthread_create(&tids[started], NULL, script_batch_worker, &job) != 0)
+            break;
+    }
+    script_batch_worker(&job);
+    for (int i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    t1 = msclock() - t1;
+    pthread_mutex_destroy(&job.lock);
+
+    if (job.error) {
+        PrintAndLogEx(FAILED, _RED_("error") " - %s", job.error);
+        res = PM3_ESOFT;
+        goto out;
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        PrintAndLogEx(NORMAL, "");
+        PrintAndLogEx(INFO, "--- " _YELLOW_("%s"), items[i]);
+        if (job.results[i]) {
+            // drop the last newline, PrintAndLogEx adds one
+            size_t len = strlen(job.results[i]);
+            if (len && job.results[i][len - 1] == '\n')
+                job.results[i][len - 1] = '\0';
+            PrintAndLogEx(NORMAL, "%s", job.results[i]);
+        }
+        if (job.errors[i]) {
+            PrintAndLogEx(FAILED, _RED_("error") " - %s", job.errors[i]);
+            failed++;
+        }
+    }
+
+    PrintAndLogEx(NORMAL, "");
+    PrintAndLogEx(SUCCESS, "finished " _YELLOW_("%s") ", %zu lines, %zu failed, %" PRIu64 " ms, %.1f lines/s"
+                  , name
+                  , count
+                  , failed
+                  , t1
+                  , (t1) ? (double)count * 1000 / t1 : (double)count * 1000
+                 );
+
+out:
+    for (size_t i = 0; i < count; i++) {
+        free(items[i]);
+        if (job.results)
+            free(job.results[i]);
+        if (job.errors)
+            free(job.errors[i]);
+    }
+    free(items);
+    free(job.results);
+    free(job.errors);
+    free(job.error);
+    free(script_path);
+    return res;
+}
+
 static command_t CommandTable[] = {
     {"help",  CmdHelp,          AlwaysAvailable, "Usage info"},
     {"list",  CmdScriptList,    AlwaysAvailable, "List available scripts"},
     {"run",   CmdScriptRun,     AlwaysAvailable, "<name> -- execute a script"},
+    {"batch", CmdScriptBatch,   AlwaysAvailable, "-n <name> -f <file> -- run a Lua script over many inputs, offline and threaded"},
     {NULL, NULL, NULL, NULL}
 };
 
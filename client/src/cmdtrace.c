@@ -10,6 +10,8 @@
 #include "cmdtrace.h"
 
 #include <ctype.h>
+#include <stdarg.h>
+#include <pthread.h>
 
 #include "cmdparser.h"    // command_t
 #include "protocols.h"
@@ -20,23 +22,197 @@
 #include "cmdlfhitag.h"         // annotate hitag
 #include "pm3_cmd.h"            // tracelog_hdr_t
 #include "cliparser.h"          // args..
+#include "tracefile.h"          // indexed traces
 
 static int CmdHelp(const char *Cmd);
 
 // trace pointer
 static uint8_t *g_trace;
 static long g_traceLen = 0;
+// indexed trace, read block by block when listed instead of g_trace
+static tracefile_t g_tracefile = { .cached = UINT32_MAX };
 
-static bool is_last_record(uint16_t tracepos, uint16_t traceLen) {
+static void trace_clear(void) {
+    free(g_trace);
+    g_trace = NULL;
+    g_traceLen = 0;
+    if (g_tracefile.f)
+        tracefile_close(&g_tracefile);
+}
+
+typedef enum {
+    TRACE_FMT_TEXT,
+    TRACE_FMT_CSV,
+    TRACE_FMT_JSON,
+} trace_fmt_t;
+
+typedef struct {
+    uint8_t protocol;
+    bool use_tags;          // annotate indexed records by their own protocol tag
+    bool show_hex;
+    bool show_wait_cycles;
+    bool mark_crc;
+    bool use_us;
+    bool use_relative;
+    uint32_t prev_eot;      // end of the previous record, for relative times
+    uint64_t from;          // window, relative to the start of the trace
+    uint64_t to;
+    uint32_t first_timestamp;
+    int threads;
+    trace_fmt_t fmt;
+    FILE *f;                // output file, console if NULL
+    uint64_t rows;          // rows written, for json separators
+} trace_list_opt_t;
+
+// Buffered output of a trace segment, so segments annotated by workers can be printed in order.
+// A NULL buffer means lines are written out immediately.
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t size;
+    print_capture_t log;    // other lines the annotators printed, replayed with the segment
+} trace_out_t;
+
+// writes one line of listing, only ever called from the main thread
+static void trace_emit(trace_list_opt_t *opt, const char *line) {
+
+    const char *sep = "";
+    if (opt->fmt == TRACE_FMT_JSON)
+        sep = (opt->rows) ? "," : " ";
+    opt->rows++;
+
+    if (opt->f == NULL) {
+        PrintAndLogEx(NORMAL, "%s%s", sep, line);
+        return;
+    }
+
+    size_t n = strlen(line) + 1;
+    char *plain = calloc(n, sizeof(char));
+    if (plain == NULL)
+        return;
+    memcpy_filter_ansi(plain, line, n, true);
+    fprintf(opt->f, "%s%s\n", sep, plain);
+    free(plain);
+}
+
+static void trace_emit_buffer(trace_list_opt_t *opt, trace_out_t *out) {
+    char *line = out->buf;
+    while (line && line < out->buf + out->len) {
+        char *nl = strchr(line, '\n');
+        *nl = '\0';
+        trace_emit(opt, line);
+        line = nl + 1;
+    }
+    out->len = 0;
+    PrintAndLogReplay(&out->log);
+}
+
+static void trace_out_line(trace_list_opt_t *opt, trace_out_t *out, const char *fmt, ...) {
+    char buf[1024];
+    char *line = buf;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (n < 0)
+        return;
+
+    // csv / json rows of long frames
+    if (n >= (int)sizeof(buf)) {
+        line = calloc(n + 1, sizeof(char));
+        if (line == NULL)
+            return;
+        va_start(args, fmt);
+        vsnprintf(line, n + 1, fmt, args);
+        va_end(args);
+    }
+
+    if (out == NULL) {
+        trace_emit(opt, line);
+        if (line != buf)
+            free(line);
+        return;
+    }
+
+    if (out->len + n + 2 > out->size) {
+        size_t size = MAX(out->size * 2, out->len + n + 2 + 4096);
+        char *tmp = realloc(out->buf, size);
+        if (tmp == NULL) {
+            if (line != buf)
+                free(line);
+            return;
+        }
+        out->buf = tmp;
+        out->size = size;
+    }
+    memcpy(out->buf + out->len, line, n);
+    out->len += n;
+    out->buf[out->len++] = '\n';
+    out->buf[out->len] = '\0';
+    if (line != buf)
+        free(line);
+}
+
+// Lines printed while annotating into a buffered segment. A text listing on the console keeps
+// them between its rows, otherwise they go to the console once the segment is printed
+static void trace_out_log(trace_list_opt_t *opt, trace_out_t *out, print_capture_t *log) {
+
+    if (opt->fmt == TRACE_FMT_TEXT && opt->f == NULL) {
+        for (size_t pos = 0; log->buf && pos < log->len; pos += strlen(log->buf + pos) + 1)
+            trace_out_line(opt, out, "%s", log->buf + pos);
+
+    } else if (log->len) {
+        print_capture_t *dst = &out->log;
+        if (dst->len + log->len > dst->size) {
+            size_t size = MAX(dst->size * 2, dst->len + log->len + 1024);
+            char *tmp = realloc(dst->buf, size);
+            if (tmp == NULL) {
+                PrintAndLogCaptureFree(log);
+                return;
+            }
+            dst->buf = tmp;
+            dst->size = size;
+        }
+        memcpy(dst->buf + dst->len, log->buf, log->len);
+        dst->len += log->len;
+    }
+    PrintAndLogCaptureFree(log);
+}
+
+// csv / json friendly copy of an annotation, without colors
+static void trace_quote(char *dst, size_t size, const char *src, trace_fmt_t fmt) {
+    char plain[128];
+    size_t n = MIN(strlen(src) + 1, sizeof(plain));
+    memcpy_filter_ansi(plain, src, n, true);
+    plain[sizeof(plain) - 1] = '\0';
+
+    size_t o = 0;
+    dst[o++] = '"';
+    for (const char *c = plain; *c && o + 3 < size; c++) {
+        if (*c == '"') {
+            dst[o++] = (fmt == TRACE_FMT_CSV) ? '"' : '\\';
+        } else if (*c == '\\' && fmt == TRACE_FMT_JSON) {
+            dst[o++] = '\\';
+        } else if ((uint8_t)*c < 0x20) {
+            continue;
+        }
+        dst[o++] = *c;
+    }
+    dst[o++] = '"';
+    dst[o] = '\0';
+}
+
+static bool is_last_record(uint32_t tracepos, uint32_t traceLen) {
     return ((tracepos + TRACELOG_HDR_LEN) >= traceLen);
 }
 
-static bool next_record_is_response(uint16_t tracepos, uint8_t *trace) {
+static bool next_record_is_response(uint32_t tracepos, uint8_t *trace) {
     tracelog_hdr_t *hdr = (tracelog_hdr_t *)(trace + tracepos);
     return (hdr->isResponse);
 }
 
-static bool merge_topaz_reader_frames(uint32_t timestamp, uint32_t *duration, uint16_t *tracepos, uint16_t traceLen,
+static bool merge_topaz_reader_frames(uint32_t timestamp, uint32_t *duration, uint32_t *tracepos, uint32_t traceLen,
                                       uint8_t *trace, uint8_t *frame, uint8_t *topaz_reader_command, uint16_t *data_len) {
 
 #define MAX_TOPAZ_READER_CMD_LEN 16
@@ -70,7 +246,7 @@ static bool merge_topaz_reader_frames(uint32_t timestamp, uint32_t *duration, ui
     return true;
 }
 
-static uint16_t printHexLine(uint16_t tracepos, uint16_t traceLen, uint8_t *trace, uint8_t protocol) {
+static uint32_t printHexLine(uint32_t tracepos, uint32_t traceLen, uint8_t *trace, uint8_t protocol) {
     // sanity check
     if (is_last_record(tracepos, traceLen)) return traceLen;
 
@@ -88,7 +264,7 @@ static uint16_t printHexLine(uint16_t tracepos, uint16_t traceLen, uint8_t *trac
         return tracepos;
     }
 
-    uint16_t ret;
+    uint32_t ret;
 
     switch (protocol) {
         case ISO_14443A: {
@@ -131,7 +307,9 @@ static uint16_t printHexLine(uint16_t tracepos, uint16_t traceLen, uint8_t *trac
     return ret;
 }
 
-static uint16_t printTraceLine(uint16_t tracepos, uint16_t traceLen, uint8_t *trace, uint8_t protocol, bool showWaitCycles, bool markCRCBytes, uint32_t *prev_eot, bool use_us) {
+// times are printed relative to opt->first_timestamp, the start of the whole trace.
+// Output goes to out, or straight to the console / output file when out is NULL
+static uint32_t printTraceLine(uint32_t tracepos, uint32_t traceLen, uint8_t *trace, uint8_t protocol, trace_list_opt_t *opt, uint32_t *prev_eot, trace_out_t *out) {
     // sanity check
     if (is_last_record(tracepos, traceLen)) {
         PrintAndLogEx(DEBUG, "last record triggered.  t-pos: %u  t-len %u", tracepos, traceLen);
@@ -145,7 +323,6 @@ static uint16_t printTraceLine(uint16_t tracepos, uint16_t traceLen, uint8_t *tr
     char explanation[40] = {0};
     uint8_t mfData[32] = {0};
     size_t mfDataLen = 0;
-    tracelog_hdr_t *first_hdr = (tracelog_hdr_t *)(trace);
     tracelog_hdr_t *hdr = (tracelog_hdr_t *)(trace + tracepos);
 
     duration = hdr->duration;
@@ -269,7 +446,7 @@ static uint16_t printTraceLine(uint16_t tracepos, uint16_t traceLen, uint8_t *tr
 
     }
 
-    if (markCRCBytes) {
+    if (opt->mark_crc) {
         //CRC-command
         if (crcStatus == 0 || crcStatus == 1) {
             char *pos1 = line[(data_len - 2) / 18] + (((data_len - 2) % 18) * 4);
@@ -381,78 +558,163 @@ static uint16_t printTraceLine(uint16_t tracepos, uint16_t traceLen, uint8_t *tr
         }
     }
 
-    int num_lines = MIN((data_len - 1) / 18 + 1, 18);
-    for (int j = 0; j < num_lines ; j++) {
-        if (j == 0) {
+    uint32_t time1 = hdr->timestamp - opt->first_timestamp;
+    uint32_t time2 = end_of_transmission_timestamp - opt->first_timestamp;
+    if (prev_eot) {
+        time1 = hdr->timestamp - previous_end_of_transmission_timestamp;
+        time2 = duration;
+    }
 
-            uint32_t time1 = hdr->timestamp - first_hdr->timestamp;
-            uint32_t time2 = end_of_transmission_timestamp - first_hdr->timestamp;
-            if (prev_eot) {
-                time1 = hdr->timestamp - previous_end_of_transmission_timestamp;
-                time2 = duration;
-            }
+    if (opt->fmt == TRACE_FMT_TEXT) {
+        int num_lines = MIN((data_len - 1) / 18 + 1, 18);
+        for (int j = 0; j < num_lines ; j++) {
+            if (j == 0) {
+                if (opt->use_us) {
+                    trace_out_line(opt, out, " %10.1f | %10.1f | %s |%-72s | %s| %s",
+                                   (float)time1 / 13.56,
+                                   (float)time2 / 13.56,
+                                   (hdr->isResponse ? "Tag" : _YELLOW_("Rdr")),
+                                   line[j],
+                                   (j == num_lines - 1) ? crc : "    ",
+                                   (j == num_lines - 1) ? explanation : ""
+                                  );
+                } else {
+                    trace_out_line(opt, out, " %10u | %10u | %s |%-72s | %s| %s",
+                                   (hdr->timestamp - opt->first_timestamp),
+                                   (end_of_transmission_timestamp - opt->first_timestamp),
+                                   (hdr->isResponse ? "Tag" : _YELLOW_("Rdr")),
+                                   line[j],
+                                   (j == num_lines - 1) ? crc : "    ",
+                                   (j == num_lines - 1) ? explanation : ""
+                                  );
+                }
 
-            if (use_us) {
-                PrintAndLogEx(NORMAL, " %10.1f | %10.1f | %s |%-72s | %s| %s",
-                              (float)time1 / 13.56,
-                              (float)time2 / 13.56,
-                              (hdr->isResponse ? "Tag" : _YELLOW_("Rdr")),
-                              line[j],
-                              (j == num_lines - 1) ? crc : "    ",
-                              (j == num_lines - 1) ? explanation : ""
-                             );
             } else {
-                PrintAndLogEx(NORMAL, " %10u | %10u | %s |%-72s | %s| %s",
-                              (hdr->timestamp - first_hdr->timestamp),
-                              (end_of_transmission_timestamp - first_hdr->timestamp),
-                              (hdr->isResponse ? "Tag" : _YELLOW_("Rdr")),
-                              line[j],
-                              (j == num_lines - 1) ? crc : "    ",
-                              (j == num_lines - 1) ? explanation : ""
-                             );
+                trace_out_line(opt, out, "            |            |     |%-72s | %s| %s",
+                               line[j],
+                               (j == num_lines - 1) ? crc : "    ",
+                               (j == num_lines - 1) ? explanation : ""
+                              );
             }
-
-        } else {
-            PrintAndLogEx(NORMAL, "            |            |     |%-72s | %s| %s",
-                          line[j],
-                          (j == num_lines - 1) ? crc : "    ",
-                          (j == num_lines - 1) ? explanation : ""
-                         );
         }
     }
 
+    // decrypted mifare data
+    char mfexp[40] = {0};
+    uint8_t mfcrc = 2;
     if (protocol == PROTO_MIFARE) {
-        if (DecodeMifareData(frame, data_len, parityBytes, hdr->isResponse, mfData, &mfDataLen)) {
-            memset(explanation, 0x00, sizeof(explanation));
+        // the key recovery prints its own lines, a buffered listing keeps them in place
+        print_capture_t log = {0};
+        print_capture_t *prev_log = (out) ? PrintAndLogCapture(&log) : NULL;
+        bool decoded = DecodeMifareData(frame, data_len, parityBytes, hdr->isResponse, mfData, &mfDataLen);
+        if (out) {
+            PrintAndLogCapture(prev_log);
+            trace_out_log(opt, out, &log);
+        }
+
+        if (decoded) {
             if (hdr->isResponse == false) {
-                annotateIso14443a(explanation, sizeof(explanation), mfData, mfDataLen);
+                annotateIso14443a(mfexp, sizeof(mfexp), mfData, mfDataLen);
+            }
+            mfcrc = iso14443A_CRC_check(hdr->isResponse, mfData, mfDataLen);
+            if (opt->fmt == TRACE_FMT_TEXT) {
+                trace_out_line(opt, out, "            |            |  *  |%-72s | %-4s| %s",
+                               sprint_hex_inrow_spaces(mfData, mfDataLen, 2),
+                               (mfcrc == 0 ? "!crc" : (mfcrc == 1 ? " ok " : "    ")),
+                               mfexp);
             }
-            uint8_t crcc = iso14443A_CRC_check(hdr->isResponse, mfData, mfDataLen);
-            PrintAndLogEx(NORMAL, "            |            |  *  |%-72s | %-4s| %s",
-                          sprint_hex_inrow_spaces(mfData, mfDataLen, 2),
-                          (crcc == 0 ? "!crc" : (crcc == 1 ? " ok " : "    ")),
-                          explanation);
         }
     }
 
-    if (is_last_record(tracepos, traceLen)) {
-        return traceLen;
-    }
-
-    if (showWaitCycles && hdr->isResponse == false && next_record_is_response(tracepos, trace)) {
+    bool has_fdt = false;
+    uint32_t next_timestamp = 0;
+    if (is_last_record(tracepos, traceLen) == false
+            && opt->show_wait_cycles && hdr->isResponse == false && next_record_is_response(tracepos, trace)) {
 
         tracelog_hdr_t *next_hdr = (tracelog_hdr_t *)(trace + tracepos);
+        next_timestamp = next_hdr->timestamp;
+        has_fdt = true;
+
+        if (opt->fmt == TRACE_FMT_TEXT) {
+            trace_out_line(opt, out, " %10u | %10u | %s |fdt (Frame Delay Time): " _YELLOW_("%d"),
+                           (end_of_transmission_timestamp - opt->first_timestamp),
+                           (next_timestamp - opt->first_timestamp),
+                           "   ",
+                           (next_timestamp - end_of_transmission_timestamp));
+        }
+    }
 
-        PrintAndLogEx(NORMAL, " %10u | %10u | %s |fdt (Frame Delay Time): " _YELLOW_("%d"),
-                      (end_of_transmission_timestamp - first_hdr->timestamp),
-                      (next_hdr->timestamp - first_hdr->timestamp),
-                      "   ",
-                      (next_hdr->timestamp - end_of_transmission_timestamp));
+    if (opt->fmt != TRACE_FMT_TEXT) {
+        // one row per record, no terminal formatting
+        char times[48];
+        if (opt->use_us)
+            snprintf(times, sizeof(times), (opt->fmt == TRACE_FMT_CSV) ? "%.1f,%.1f" : "\"start\":%.1f,\"end\":%.1f", (float)time1 / 13.56, (float)time2 / 13.56);
+        else
+            snprintf(times, sizeof(times), (opt->fmt == TRACE_FMT_CSV) ? "%u,%u" : "\"start\":%u,\"end\":%u", time1, time2);
+
+        char data[(data_len * 2) + 1];
+        for (int i = 0; i < data_len; i++)
+            sprintf(data + (i * 2), "%02x", frame[i]);
+        data[data_len * 2] = '\0';
+
+        char mfdata[(mfDataLen * 2) + 1];
+        for (size_t i = 0; i < mfDataLen; i++)
+            sprintf(mfdata + (i * 2), "%02x", mfData[i]);
+        mfdata[mfDataLen * 2] = '\0';
+
+        const char *crcs = (crcStatus == 0) ? "fail" : (crcStatus == 1) ? "ok" : "";
+        const char *mfcrcs = (mfcrc == 0) ? "fail" : (mfcrc == 1) ? "ok" : "";
+
+        char fdt[16] = {0};
+        if (has_fdt)
+            snprintf(fdt, sizeof(fdt), "%d", (int32_t)(next_timestamp - end_of_transmission_timestamp));
+
+        char qexp[100], qmfexp[100];
+        trace_quote(qexp, sizeof(qexp), explanation, opt->fmt);
+        trace_quote(qmfexp, sizeof(qmfexp), mfexp, opt->fmt);
+
+        if (opt->fmt == TRACE_FMT_CSV) {
+            trace_out_line(opt, out, "%s,%s,%s,%s,%s,%s,%s,%s,%s",
+                           times, (hdr->isResponse ? "Tag" : "Rdr"), data, crcs, qexp, fdt, mfdata, mfcrcs, qmfexp);
+        } else {
+            trace_out_line(opt, out, "{%s,\"src\":\"%s\",\"data\":\"%s\",\"crc\":\"%s\",\"annotation\":%s%s%s%s%s%s%s%s}",
+                           times, (hdr->isResponse ? "Tag" : "Rdr"), data, crcs, qexp,
+                           (has_fdt) ? ",\"fdt\":" : "", fdt,
+                           (mfDataLen) ? ",\"decrypted\":\"" : "", mfdata,
+                           (mfDataLen) ? "\",\"decrypted_crc\":\"" : "", (mfDataLen) ? mfcrcs : "",
+                           (mfDataLen) ? "\"" : "");
+        }
+    }
+
+    if (is_last_record(tracepos, traceLen)) {
+        return traceLen;
     }
 
     return tracepos;
 }
 
+// maps the -t parameter to a protocol, anything unknown means no crc, no annotations
+static uint8_t get_trace_protocol(const char *type) {
+    if (strcmp(type,      "iclass") == 0)   return ICLASS;
+    else if (strcmp(type, "14a") == 0)      return ISO_14443A;
+    else if (strcmp(type, "14b") == 0)      return ISO_14443B;
+    else if (strcmp(type, "topaz") == 0)    return TOPAZ;
+    else if (strcmp(type, "7816") == 0)     return ISO_7816_4;
+    else if (strcmp(type, "des") == 0)      return MFDES;
+    else if (strcmp(type, "legic") == 0)    return LEGIC;
+    else if (strcmp(type, "15") == 0)       return ISO_15693;
+    else if (strcmp(type, "felica") == 0)   return FELICA;
+    else if (strcmp(type, "mf") == 0)       return PROTO_MIFARE;
+    else if (strcmp(type, "hitag1") == 0)   return PROTO_HITAG1;
+    else if (strcmp(type, "hitag2") == 0)   return PROTO_HITAG2;
+    else if (strcmp(type, "hitags") == 0)   return PROTO_HITAGS;
+    else if (strcmp(type, "thinfilm") == 0) return THINFILM;
+    else if (strcmp(type, "lto") == 0)      return LTO;
+    else if (strcmp(type, "cryptorf") == 0) return PROTO_CRYPTORF;
+    else if (strcmp(type, "raw") == 0)      return -1;
+    return -1;
+}
+
 static int download_trace(void) {
 
     if (IfPm3Present() == false) {
@@ -461,10 +723,7 @@ static int download_trace(void) {
     }
 
     // reserve some space.
-    if (g_trace)
-        free(g_trace);
-
-    g_traceLen = 0;
+    trace_clear();
 
     g_trace = calloc(PM3_CMD_DATA_SIZE, sizeof(uint8_t));
     if (g_trace == NULL) {
@@ -478,7 +737,7 @@ static int download_trace(void) {
     PacketResponseNG response;
     if (!GetFromDevice(BIG_BUF, g_trace, PM3_CMD_DATA_SIZE, 0, NULL, 0, &response, 4000, true)) {
         PrintAndLogEx(WARNING, "timeout while waiting for reply.");
-        free(g_trace);
+        trace_clear();
         return PM3_ETIMEOUT;
     }
 
@@ -491,12 +750,13 @@ static int download_trace(void) {
         g_trace = calloc(g_traceLen, sizeof(uint8_t));
         if (g_trace == NULL) {
             PrintAndLogEx(FAILED, "Cannot allocate memory for trace");
+            g_traceLen = 0;
             return PM3_EMALLOC;
         }
 
         if (!GetFromDevice(BIG_BUF, g_trace, g_traceLen, 0, NULL, 0, NULL, 2500, false)) {
             PrintAndLogEx(WARNING, "command execution time out");
-            free(g_trace);
+            trace_clear();
             return PM3_ETIMEOUT;
         }
     }
@@ -519,8 +779,9 @@ static int CmdTraceLoad(const char *Cmd) {
     CLIParserContext *ctx;
     CLIParserInit(&ctx, "trace load",
                   "Load protocol data from binary file to trace buffer\n"
-                  "File extension is (.trace)",
-                  "trace load -f mytracefile"
+                  "File extension is (.trace), indexed traces (" TRACEFILE_SUFFIX ") are read on demand when listed",
+                  "trace load -f mytracefile\n"
+                  "trace load -f mytracefile" TRACEFILE_SUFFIX
                  );
 
     void *argtable[] = {
@@ -535,8 +796,25 @@ static int CmdTraceLoad(const char *Cmd) {
     CLIParamStrToBuf(arg_get_str(ctx, 1), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
     CLIParserFree(ctx);
 
-    if (g_trace)
-        free(g_trace);
+    trace_clear();
+
+    if (str_endswith(filename, TRACEFILE_SUFFIX)) {
+        char *path = NULL;
+        if (searchFile(&path, RESOURCES_SUBDIR, filename, TRACEFILE_SUFFIX, false) != PM3_SUCCESS)
+            return PM3_EFILE;
+
+        int res = tracefile_open(path, &g_tracefile);
+        free(path);
+        if (res != PM3_SUCCESS)
+            return res;
+
+        PrintAndLogEx(SUCCESS, "Indexed trace, " _YELLOW_("%" PRIu64) " records in %u blocks%s"
+                      , g_tracefile.hdr.record_count
+                      , g_tracefile.hdr.block_count
+                      , (g_tracefile.hdr.flags & TRACEFILE_FLAG_LZ4) ? ", lz4" : ""
+                     );
+        return PM3_SUCCESS;
+    }
 
     size_t len = 0;
     if (loadFile_safe(filename, ".trace", (void **)&g_trace, &len) != PM3_SUCCESS) {
@@ -550,18 +828,100 @@ static int CmdTraceLoad(const char *Cmd) {
     return PM3_SUCCESS;
 }
 
+// writes the current trace, plain or indexed, to file
+static int trace_save(const char *preferredName, bool indexed, bool compress, uint8_t protocol, uint32_t block_records) {
+
+    char *fn = newfilenamemcopy(preferredName, (indexed) ? TRACEFILE_SUFFIX : ".trace");
+    if (fn == NULL)
+        return PM3_EMALLOC;
+
+    FILE *f = NULL;
+    tracefile_writer_t w;
+    int res;
+    if (indexed) {
+        res = tracefile_create(&w, fn, block_records, compress);
+    } else {
+        f = fopen(fn, "wb");
+        res = (f) ? PM3_SUCCESS : PM3_EFILE;
+        if (f == NULL)
+            PrintAndLogEx(WARNING, "file not found or locked. '" _YELLOW_("%s")"'", fn);
+    }
+    if (res != PM3_SUCCESS) {
+        free(fn);
+        return res;
+    }
+
+    uint64_t bytes = 0;
+    if (g_tracefile.f) {
+        // an indexed source keeps its record tags
+        for (uint32_t b = 0; b < g_tracefile.hdr.block_count && res == PM3_SUCCESS; b++) {
+            const uint8_t *tags;
+            uint8_t *records;
+            uint32_t len;
+            res = tracefile_read_block(&g_tracefile, b, &tags, &records, &len);
+            if (res != PM3_SUCCESS)
+                break;
+
+            if (indexed == false) {
+                if (fwrite(records, 1, len, f) != len)
+                    res = PM3_EFILE;
+                bytes += len;
+                continue;
+            }
+
+            for (uint32_t pos = 0, i = 0; pos + TRACELOG_HDR_LEN <= len && res == PM3_SUCCESS; i++) {
+                tracelog_hdr_t *hdr = (tracelog_hdr_t *)(records + pos);
+                uint32_t reclen = TRACELOG_HDR_LEN + hdr->data_len + TRACELOG_PARITY_LEN(hdr);
+                res = tracefile_append(&w, records + pos, reclen, tags[i]);
+                bytes += reclen;
+                pos += reclen;
+            }
+        }
+    } else {
+        if (indexed)
+            res = tracefile_append(&w, g_trace, g_traceLen, protocol);
+        else if (fwrite(g_trace, 1, g_traceLen, f) != (size_t)g_traceLen)
+            res = PM3_EFILE;
+        bytes = g_traceLen;
+    }
+
+    if (indexed) {
+        int fres = tracefile_finish(&w);
+        if (res == PM3_SUCCESS)
+            res = fres;
+    } else {
+        fclose(f);
+    }
+
+    if (res == PM3_SUCCESS)
+        PrintAndLogEx(SUCCESS, "saved " _YELLOW_("%" PRIu64) " bytes of trace to " _YELLOW_("%s"), bytes, fn);
+    else
+        PrintAndLogEx(FAILED, "failed to save trace to " _YELLOW_("%s"), fn);
+
+    free(fn);
+    return res;
+}
+
 static int CmdTraceSave(const char *Cmd) {
 
     CLIParserContext *ctx;
     CLIParserInit(&ctx, "trace save",
                   "Save protocol data from trace buffer to binary file\n"
-                  "File extension is (.trace)",
-                  "trace save -f mytracefile"
+                  "File extension is (.trace), indexed traces use (" TRACEFILE_SUFFIX ")\n"
+                  "Indexed traces keep an index entry every n records and a protocol tag per record,\n"
+                  "`trace list` then only reads and decodes the records it shows.",
+                  "trace save -f mytracefile\n"
+                  "trace save -f mytracefile --idx -t 14a          -> indexed, records tagged as ISO14443-A\n"
+                  "trace save -f mytracefile --lz4 -n 1024         -> indexed and compressed, index every 1024 records"
                  );
 
     void *argtable[] = {
         arg_param_begin,
-        arg_strx0("f", "file", "<filename>", "trace file to load"),
+        arg_strx0("f", "file", "<filename>", "trace file to save"),
+        arg_lit0(NULL, "idx", "save as indexed trace"),
+        arg_lit0(NULL, "lz4", "save as indexed trace with lz4 compressed blocks"),
+        arg_str0("t", "type", NULL, "protocol tag for the records of an indexed trace"),
+        arg_int0("n", NULL, "<dec>", "records per index entry (def " _YELLOW_("512") ")"),
         arg_param_end
     };
     CLIExecWithReturn(ctx, Cmd, argtable, false);
@@ -569,21 +929,773 @@ static int CmdTraceSave(const char *Cmd) {
     int fnlen = 0;
     char filename[FILE_PATH_SIZE] = {0};
     CLIParamStrToBuf(arg_get_str(ctx, 1), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+
+    bool compress = arg_get_lit(ctx, 3);
+    bool indexed = arg_get_lit(ctx, 2) || compress;
+
+    int tlen = 0;
+    char type[10] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 4), (uint8_t *)type, sizeof(type), &tlen);
+    str_lower(type);
+
+    uint32_t block_records = arg_get_int_def(ctx, 5, TRACEFILE_BLOCK_RECORDS);
     CLIParserFree(ctx);
 
-    if (g_traceLen == 0) {
+    if (g_traceLen == 0 && g_tracefile.f == NULL) {
         download_trace();
     }
 
-    if (g_traceLen == 0) {
+    if (g_traceLen == 0 && g_tracefile.f == NULL) {
         PrintAndLogEx(WARNING, "trace is empty, nothing to save");
         return PM3_SUCCESS;
     }
 
-    saveFile(filename, ".trace", g_trace, g_traceLen);
+    return trace_save(filename, indexed, compress, get_trace_protocol(type), block_records);
+}
+
+// Streaming capture.
+// The device pushes record aligned chunks of its trace (CMD_TRACE_STREAM_DATA) whenever
+// BigBuf fills up or the trace gets cleared. They are received in the comms thread and
+// appended to a trace file, so long sniffs are no longer limited by the size of BigBuf.
+// Live decode is queued and printed by the main thread, annotating must not hold up the
+// comms thread while the device is sending.
+typedef struct {
+    bool active;
+    FILE *f;                // plain trace file
+    tracefile_writer_t w;   // or indexed trace file
+    bool indexed;
+    char *filename;
+    uint8_t *buf;           // plain trace: all received records, becomes the trace buffer when stopped
+    uint32_t len;
+    uint32_t size;
+    uint64_t bytes;
+    uint32_t records;
+    uint32_t chunks;
+    uint32_t first_timestamp;
+    uint8_t protocol;
+    bool live;
+    uint8_t *queue;         // live decode: records received, not printed yet
+    uint32_t queue_len;
+    uint32_t queue_size;
+    annotate_state_t state; // live decode: annotation state from one print to the next
+} trace_stream_t;
+
+static trace_stream_t g_stream;
+static pthread_mutex_t g_stream_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void trace_stream_data(const uint8_t *data, uint16_t len) {
+    pthread_mutex_lock(&g_stream_lock);
+
+    if (g_stream.active == false) {
+        pthread_mutex_unlock(&g_stream_lock);
+        PrintAndLogEx(DEBUG, "dropped %u bytes of streamed trace, no stream active", len);
+        return;
+    }
+
+    if (g_stream.records == 0 && len >= TRACELOG_HDR_LEN)
+        g_stream.first_timestamp = ((tracelog_hdr_t *)data)->timestamp;
+
+    for (uint16_t pos = 0; pos + TRACELOG_HDR_LEN <= len;) {
+        tracelog_hdr_t *hdr = (tracelog_hdr_t *)(data + pos);
+        pos += TRACELOG_HDR_LEN + hdr->data_len + TRACELOG_PARITY_LEN(hdr);
+        g_stream.records++;
+    }
+    g_stream.chunks++;
+    g_stream.bytes += len;
+
+    if (g_stream.indexed) {
+        if (tracefile_append(&g_stream.w, data, len, g_stream.protocol) != PM3_SUCCESS)
+            PrintAndLogEx(WARNING, "failed to write streamed trace to " _YELLOW_("%s"), g_stream.filename);
+    } else {
+        if (fwrite(data, 1, len, g_stream.f) != len)
+            PrintAndLogEx(WARNING, "failed to write streamed trace to " _YELLOW_("%s"), g_stream.filename);
+
+        if (g_stream.len + len > g_stream.size) {
+            uint32_t size = MAX(g_stream.size * 2, g_stream.len + len);
+            uint8_t *tmp = realloc(g_stream.buf, size);
+            if (tmp == NULL) {
+                PrintAndLogEx(WARNING, "failed to allocate memory, streamed trace only kept in file");
+                free(g_stream.buf);
+                g_stream.buf = NULL;
+                g_stream.size = 0;
+                g_stream.len = 0;
+            } else {
+                g_stream.buf = tmp;
+                g_stream.size = size;
+            }
+        }
+        if (g_stream.buf) {
+            memcpy(g_stream.buf + g_stream.len, data, len);
+            g_stream.len += len;
+        }
+    }
+
+    if (g_stream.live) {
+        if (g_stream.queue_len + len > g_stream.queue_size) {
+            uint32_t size = MAX(g_stream.queue_size * 2, g_stream.queue_len + len);
+            uint8_t *tmp = realloc(g_stream.queue, size);
+            if (tmp == NULL) {
+                PrintAndLogEx(WARNING, "failed to allocate memory, %u bytes of streamed trace not decoded", len);
+            } else {
+                g_stream.queue = tmp;
+                g_stream.queue_size = size;
+            }
+        }
+        if (g_stream.queue_len + len <= g_stream.queue_size) {
+            memcpy(g_stream.queue + g_stream.queue_len, data, len);
+            g_stream.queue_len += len;
+        }
+    }
+
+    pthread_mutex_unlock(&g_stream_lock);
+}
+
+void trace_stream_print(void) {
+    pthread_mutex_lock(&g_stream_lock);
+    if (g_stream.active == false || g_stream.queue_len == 0) {
+        pthread_mutex_unlock(&g_stream_lock);
+        return;
+    }
+
+    // take the queue, the comms thread starts a new one
+    uint8_t *data = g_stream.queue;
+    uint32_t len = g_stream.queue_len;
+    g_stream.queue = NULL;
+    g_stream.queue_len = 0;
+    g_stream.queue_size = 0;
+    trace_list_opt_t opt = {
+        .protocol = g_stream.protocol,
+        .first_timestamp = g_stream.first_timestamp,
+    };
+    pthread_mutex_unlock(&g_stream_lock);
+
+    // the state is only touched here and in start / stop, all in the main thread
+    LoadAnnotateState(&g_stream.state);
+    for (uint32_t pos = 0; pos < len;) {
+        pos = printTraceLine(pos, len, data, opt.protocol, &opt, NULL, NULL);
+    }
+    SaveAnnotateState(&g_stream.state);
+    ClearAnnotateState();
+    free(data);
+}
+
+bool trace_stream_active(void) {
+    pthread_mutex_lock(&g_stream_lock);
+    bool active = g_stream.active;
+    pthread_mutex_unlock(&g_stream_lock);
+    return active;
+}
+
+static int trace_stream_start(const char *preferredName, uint8_t protocol, bool live, bool indexed, bool compress) {
+
+    char *fn = newfilenamemcopy(preferredName, (indexed) ? TRACEFILE_SUFFIX : ".trace");
+    if (fn == NULL)
+        return PM3_EMALLOC;
+
+    pthread_mutex_lock(&g_stream_lock);
+    memset(&g_stream, 0, sizeof(g_stream));
+
+    int res = PM3_SUCCESS;
+    if (indexed) {
+        res = tracefile_create(&g_stream.w, fn, 0, compress);
+    } else {
+        g_stream.f = fopen(fn, "wb");
+        if (g_stream.f == NULL) {
+            PrintAndLogEx(WARNING, "file not found or locked. '" _YELLOW_("%s")"'", fn);
+            res = PM3_EFILE;
+        }
+    }
+
+    if (res != PM3_SUCCESS) {
+        pthread_mutex_unlock(&g_stream_lock);
+        free(fn);
+        return res;
+    }
+
+    g_stream.active = true;
+    g_stream.indexed = indexed;
+    g_stream.filename = fn;
+    g_stream.protocol = protocol;
+    g_stream.live = live;
+    pthread_mutex_unlock(&g_stream_lock);
+
+    if (live) {
+        ClearAnnotateState();
+        SaveAnnotateState(&g_stream.state);
+
+        PrintAndLogEx(NORMAL, "      Start |        End | Src | Data (! denotes parity error)                                           | CRC | Annotation");
+        PrintAndLogEx(NORMAL, "------------+------------+-----+-------------------------------------------------------------------------+-----+--------------------");
+    }
+    PrintAndLogEx(INFO, "streaming trace to " _YELLOW_("%s"), fn);
     return PM3_SUCCESS;
 }
 
+// dropped: frames the device lost because the client didn't get the trace out in time
+static int trace_stream_stop(uint32_t dropped) {
+
+    trace_stream_print();
+
+    pthread_mutex_lock(&g_stream_lock);
+    if (g_stream.active == false) {
+        pthread_mutex_unlock(&g_stream_lock);
+        PrintAndLogEx(WARNING, "no trace stream active");
+        return PM3_EINVARG;
+    }
+
+    int res = PM3_SUCCESS;
+    if (g_stream.indexed) {
+        res = tracefile_finish(&g_stream.w);
+    } else {
+        fflush(g_stream.f);
+        fclose(g_stream.f);
+    }
+
+    PrintAndLogEx(SUCCESS, "streamed " _YELLOW_("%u") " records, " _YELLOW_("%" PRIu64) " bytes in %u chunks to " _YELLOW_("%s")
+                  , g_stream.records
+                  , g_stream.bytes
+                  , g_stream.chunks
+                  , g_stream.filename
+                 );
+
+    if (dropped) {
+        PrintAndLogEx(WARNING, "device lost " _RED_("%u") " frames, the streamed trace is incomplete", dropped);
+        PrintAndLogEx(HINT, "the sniff command used doesn't stream, or USB didn't keep up");
+        if (res == PM3_SUCCESS)
+            res = PM3_EOVFLOW;
+    }
+
+    // the streamed trace becomes the trace buffer
+    trace_clear();
+    if (g_stream.indexed) {
+        if (res == PM3_SUCCESS)
+            res = tracefile_open(g_stream.filename, &g_tracefile);
+    } else {
+        g_trace = g_stream.buf;
+        g_traceLen = g_stream.len;
+    }
+
+    free(g_stream.filename);
+    free(g_stream.queue);
+    memset(&g_stream, 0, sizeof(g_stream));
+    pthread_mutex_unlock(&g_stream_lock);
+    return res;
+}
+
+// simulated device, feeds a trace file in record aligned chunks like the device does
+static int trace_stream_replay(const char *filename) {
+    uint8_t *data = NULL;
+    size_t len = 0;
+    if (loadFile_safe(filename, ".trace", (void **)&data, &len) != PM3_SUCCESS) {
+        PrintAndLogEx(FAILED, "Could not open file " _YELLOW_("%s"), filename);
+        return PM3_EIO;
+    }
+
+    size_t start = 0, pos = 0;
+    while (pos + TRACELOG_HDR_LEN <= len) {
+        tracelog_hdr_t *hdr = (tracelog_hdr_t *)(data + pos);
+        size_t reclen = TRACELOG_HDR_LEN + hdr->data_len + TRACELOG_PARITY_LEN(hdr);
+        if (pos + reclen > len)
+            break;
+
+        if (pos + reclen - start > PM3_CMD_DATA_SIZE) {
+            trace_stream_data(data + start, pos - start);
+            trace_stream_print();
+            start = pos;
+        }
+        pos += reclen;
+    }
+
+    if (pos > start)
+        trace_stream_data(data + start, pos - start);
+
+    if (pos != len)
+        PrintAndLogEx(WARNING, "ignored %zu bytes of truncated record at end of " _YELLOW_("%s"), len - pos, filename);
+
+    free(data);
+    return PM3_SUCCESS;
+}
+
+static int CmdTraceStream(const char *Cmd) {
+
+    CLIParserContext *ctx;
+    CLIParserInit(&ctx, "trace stream",
+                  "Stream the device trace to file while sniffing, BigBuf is pushed to the client whenever it fills up.\n"
+                  "Start streaming, run your sniff command(s) and stop streaming to get the complete trace.\n"
+                  "With a protocol given the records are annotated as they arrive.\n"
+                  "The 14a, 14b, 15693, iCLASS and Hitag2 sniffs stream while running, `hf felica sniff` can't.\n"
+                  "Frames the device had to drop are reported when stopped.\n"
+                  "The streamed trace is loaded in the trace buffer when stopped, see `trace list -1`",
+                  "trace stream -f mysniff -t 14a     -> start streaming with live decode\n"
+                  "trace stream --stop                -> stop streaming\n"
+                  "trace stream -f mysniff --lz4      -> stream to a compressed indexed trace, for very long sniffs\n"
+                  "trace stream -f copy --replay traces/hf_14a_mfu.trace -t 14a  -> replay a trace file as simulated device"
+                 );
+
+    void *argtable[] = {
+        arg_param_begin,
+        arg_str0("f", "file", "<filename>", "trace file to stream to"),
+        arg_str0("t", "type", NULL, "protocol to annotate the trace while streaming"),
+        arg_lit0(NULL, "stop", "stop streaming"),
+        arg_str0(NULL, "replay", "<filename>", "trace file to stream instead of device"),
+        arg_lit0(NULL, "idx", "stream to an indexed trace (" TRACEFILE_SUFFIX ")"),
+        arg_lit0(NULL, "lz4", "stream to an indexed trace with lz4 compressed blocks"),
+        arg_param_end
+    };
+    CLIExecWithReturn(ctx, Cmd, argtable, true);
+
+    int fnlen = 0;
+    char filename[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 1), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+
+    int tlen = 0;
+    char type[10] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 2), (uint8_t *)type, sizeof(type), &tlen);
+    str_lower(type);
+
+    bool stop = arg_get_lit(ctx, 3);
+
+    int rlen = 0;
+    char replay[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 4), (uint8_t *)replay, FILE_PATH_SIZE, &rlen);
+
+    bool compress = arg_get_lit(ctx, 6);
+    bool indexed = arg_get_lit(ctx, 5) || compress;
+    CLIParserFree(ctx);
+
+    if (stop) {
+        uint32_t dropped = 0;
+        if (IfPm3Present()) {
+            // device flushes the remaining records before it acknowledges
+            clearCommandBuffer();
+            uint8_t on = 0;
+            SendCommandNG(CMD_SET_TRACE_STREAMING, &on, sizeof(on));
+            PacketResponseNG resp;
+            if (WaitForResponseTimeout(CMD_SET_TRACE_STREAMING, &resp, 2500) == false) {
+                PrintAndLogEx(WARNING, "command execution time out");
+            } else if (resp.length >= sizeof(dropped)) {
+                dropped = resp.data.asDwords[0];
+            }
+        }
+        return trace_stream_stop(dropped);
+    }
+
+    if (fnlen == 0) {
+        PrintAndLogEx(WARNING, "missing trace file, see `trace stream -h`");
+        return PM3_EINVARG;
+    }
+
+    if (g_stream.active) {
+        PrintAndLogEx(WARNING, "trace stream already active, stop it with `trace stream --stop`");
+        return PM3_EINVARG;
+    }
+
+    if (rlen == 0 && IfPm3Present() == false) {
+        PrintAndLogEx(WARNING, "streaming needs a device, or use --replay with a trace file");
+        return PM3_EINVARG;
+    }
+
+    int res = trace_stream_start(filename, get_trace_protocol(type), (tlen > 0), indexed, compress);
+    if (res != PM3_SUCCESS)
+        return res;
+
+    if (rlen) {
+        res = trace_stream_replay(replay);
+        trace_stream_stop(0);
+        return res;
+    }
+
+    clearCommandBuffer();
+    uint8_t on = 1;
+    SendCommandNG(CMD_SET_TRACE_STREAMING, &on, sizeof(on));
+    PacketResponseNG resp;
+    if (WaitForResponseTimeout(CMD_SET_TRACE_STREAMING, &resp, 2500) == false) {
+        PrintAndLogEx(WARNING, "command execution time out");
+        trace_stream_stop(0);
+        return PM3_ETIMEOUT;
+    }
+
+    PrintAndLogEx(HINT, "run your sniff command(s), then " _YELLOW_("`trace stream --stop`"));
+    return PM3_SUCCESS;
+}
+
+// Records are annotated in segments, which workers can handle out of order. A segment only
+// starts at a reader frame following a tag response, so merged topaz frames never straddle two.
+// MIFARE and iCLASS annotation carries state from one record to the next, their records only
+// start a segment where that state resets: at a REQA / WUPA for MIFARE, an ACTALL for iCLASS.
+// A segment starting anywhere else after such records picks up the state the one before left.
+#define TRACE_SEGMENT_RECORDS   256
+
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    uint32_t rec;           // tag index of the first record
+    uint32_t prev_eot;      // end of the record before, updated to the end of the segment
+    bool fresh;             // annotated from a cleared state
+    annotate_state_t state; // annotation state at the end of the segment
+    trace_out_t out;
+    bool done;
+} trace_segment_t;
+
+// One pool of workers annotates all the buffers of a listing. Workers take segments in order
+// but never run more than window segments ahead of the one being printed, so the buffered
+// output stays bounded
+typedef struct {
+    uint8_t *trace;
+    uint32_t len;
+    const uint8_t *tags;
+    const trace_list_opt_t *opt;
+    trace_segment_t *segs;
+    uint32_t next;
+    uint32_t count;
+    uint32_t printed;
+    uint32_t window;
+    int busy;               // workers inside a segment
+    bool stop;              // listing aborted
+    bool quit;              // listing done, workers exit
+    bool dirty;             // a MIFARE or iCLASS record was seen
+    annotate_state_t carry; // annotation state at the end of the previous buffer
+    int threads;
+    int started;
+    pthread_t *tids;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} trace_pool_t;
+
+static bool trace_stateful(uint8_t protocol) {
+    return protocol == PROTO_MIFARE || protocol == ICLASS;
+}
+
+static bool trace_state_resets(uint8_t protocol, const tracelog_hdr_t *hdr) {
+    if (hdr->isResponse || hdr->data_len == 0)
+        return false;
+
+    if (protocol == PROTO_MIFARE)
+        return hdr->data_len == 1 && (hdr->frame[0] == ISO14443A_CMD_REQA || hdr->frame[0] == ISO14443A_CMD_WUPA);
+
+    if (protocol == ICLASS)
+        return (hdr->frame[0] & 0x0F) == ICLASS_CMD_ACTALL;
+
+    return false;
+}
+
+static bool trace_list_segment(uint8_t *trace, uint32_t len, const uint8_t *tags, trace_segment_t *seg, trace_list_opt_t *opt, trace_out_t *out) {
+
+    uint32_t pos = seg->start, rec = seg->rec;
+    while (pos < seg->end && is_last_record(pos, len) == false) {
+
+        uint8_t protocol = (tags && opt->use_tags) ? tags[rec] : opt->protocol;
+        uint32_t next;
+        if (opt->show_hex)
+            next = printHexLine(pos, len, trace, protocol);
+        else
+            next = printTraceLine(pos, len, trace, protocol, opt, (opt->use_relative) ? &seg->prev_eot : NULL, out);
+
+        // topaz reader frames are merged, keep the tag index in step
+        while (pos < next && pos + TRACELOG_HDR_LEN <= len) {
+            tracelog_hdr_t *hdr = (tracelog_hdr_t *)(trace + pos);
+            pos += TRACELOG_HDR_LEN + hdr->data_len + TRACELOG_PARITY_LEN(hdr);
+            rec++;
+        }
+        pos = next;
+
+        if (out == NULL && opt->show_hex == false && kbd_enter_pressed())
+            return false;
+    }
+    return true;
+}
+
+static void *trace_list_worker(void *arg) {
+    trace_pool_t *pool = (trace_pool_t *)arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->quit == false && (pool->stop || pool->next >= pool->count || pool->next >= pool->printed + pool->window))
+            pthread_cond_wait(&pool->cond, &pool->lock);
+
+        if (pool->quit)
+            break;
+
+        uint32_t i = pool->next++;
+        trace_segment_t *seg = &pool->segs[i];
+        pool->busy++;
+
+        // segments are taken in order, the one before is always being worked on
+        const annotate_state_t *from = NULL;
+        if (seg->fresh == false) {
+            if (i == 0) {
+                from = &pool->carry;
+            } else {
+                while (pool->segs[i - 1].done == false)
+                    pthread_cond_wait(&pool->cond, &pool->lock);
+                from = &pool->segs[i - 1].state;
+            }
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        if (from)
+            LoadAnnotateState(from);
+        else
+            ClearAnnotateState();
+
+        // workers only read opt, output is buffered per segment
+        trace_list_segment(pool->trace, pool->len, pool->tags, seg, (trace_list_opt_t *)pool->opt, &seg->out);
+        SaveAnnotateState(&seg->state);
+
+        pthread_mutex_lock(&pool->lock);
+        seg->done = true;
+        pool->busy--;
+        pthread_cond_broadcast(&pool->cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    ClearAnnotateState();
+    return NULL;
+}
+
+// the workers are only started once a buffer has more than one segment
+static void trace_pool_start(trace_pool_t *pool) {
+
+    pool->tids = calloc(pool->threads, sizeof(pthread_t));
+    for (; pool->tids && pool->started < pool->threads; pool->started++) {
+        if (pthread_create(&pool->tids[pool->started], NULL, trace_list_worker, pool) != 0)
+            break;
+    }
+
+    if (pool->started == 0) {
+        free(pool->tids);
+        pool->tids = NULL;
+        pool->threads = 0;
+    }
+    pool->window = pool->started * 4;
+}
+
+static void trace_pool_stop(trace_pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->started; i++)
+        pthread_join(pool->tids[i], NULL);
+
+    free(pool->tids);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+// second pass, annotate segments in parallel and print them in order
+static bool trace_pool_run(trace_pool_t *pool, uint8_t *trace, uint32_t len, const uint8_t *tags, trace_list_opt_t *opt, trace_segment_t *segs, uint32_t count) {
+
+    pthread_mutex_lock(&pool->lock);
+    pool->trace = trace;
+    pool->len = len;
+    pool->tags = tags;
+    pool->opt = opt;
+    pool->segs = segs;
+    pool->next = 0;
+    pool->count = count;
+    pool->printed = 0;
+    pool->stop = false;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    bool res = true;
+    for (uint32_t i = 0; i < count; i++) {
+        pthread_mutex_lock(&pool->lock);
+        while (segs[i].done == false)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        pthread_mutex_unlock(&pool->lock);
+
+        trace_emit_buffer(opt, &segs[i].out);
+        free(segs[i].out.buf);
+        segs[i].out.buf = NULL;
+
+        bool abort = kbd_enter_pressed();
+        pthread_mutex_lock(&pool->lock);
+        pool->printed = i + 1;
+        pool->stop = abort;
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->lock);
+
+        if (abort) {
+            res = false;
+            break;
+        }
+    }
+
+    // the segments are freed by the caller, no worker may still be on one
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy)
+        pthread_cond_wait(&pool->cond, &pool->lock);
+    pool->count = 0;
+    pool->segs = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (res)
+        pool->carry = segs[count - 1].state;
+
+    for (uint32_t i = 0; i < count; i++) {
+        free(segs[i].out.buf);
+        PrintAndLogCaptureFree(&segs[i].out.log);
+    }
+    return res;
+}
+
+// Lists the records of a tracelog buffer which fall in the window. Records before it are
+// skipped without being decoded. first is the extended timestamp of the first record in the
+// buffer, start the one of the whole trace. Returns false once past the window.
+static bool trace_list_records(uint8_t *trace, uint32_t len, const uint8_t *tags, uint64_t first, uint64_t start, trace_list_opt_t *opt, trace_pool_t *pool) {
+
+    uint64_t wraps = first & 0xFFFFFFFF00000000ULL;
+    uint32_t last = (uint32_t)first;
+    uint32_t pos = 0, rec = 0;
+    uint32_t eot = opt->prev_eot;
+    uint32_t seg_records = 0;
+    bool prev_response = false;
+    bool in_window = true;
+    bool dirty = (pool && pool->dirty);
+
+    trace_segment_t *segs = NULL;
+    uint32_t count = 0, size = 0;
+
+    // first pass, find the window and cut it into segments
+    while (pos < len && is_last_record(pos, len) == false) {
+
+        tracelog_hdr_t *hdr = (tracelog_hdr_t *)(trace + pos);
+        if (hdr->timestamp < last)
+            wraps += 0x100000000ULL;
+        last = hdr->timestamp;
+
+        uint64_t t = (wraps | hdr->timestamp) - start;
+        if (t > opt->to) {
+            in_window = false;
+            break;
+        }
+
+        if (t >= opt->from) {
+            uint8_t protocol = (tags && opt->use_tags) ? tags[rec] : opt->protocol;
+            bool stateful = trace_stateful(protocol);
+            bool resets = trace_state_resets(protocol, hdr);
+
+            bool cut = (count == 0);
+            if (count && seg_records >= TRACE_SEGMENT_RECORDS && hdr->isResponse == false)
+                cut = (stateful) ? resets : prev_response;
+
+            if (cut) {
+                if (count == size) {
+                    size = (size) ? size * 2 : 64;
+                    trace_segment_t *tmp = realloc(segs, size * sizeof(trace_segment_t));
+                    if (tmp == NULL) {
+                        PrintAndLogEx(WARNING, "failed to allocate memory");
+                        free(segs);
+                        return false;
+                    }
+                    segs = tmp;
+                }
+                if (count)
+                    segs[count - 1].end = pos;
+                memset(&segs[count], 0, sizeof(trace_segment_t));
+                segs[count].start = pos;
+                segs[count].rec = rec;
+                segs[count].prev_eot = eot;
+                segs[count].fresh = resets || dirty == false;
+                count++;
+                seg_records = 0;
+            }
+            if (stateful)
+                dirty = true;
+
+            seg_records++;
+            prev_response = hdr->isResponse;
+            eot = hdr->timestamp + hdr->duration * ((protocol == ICLASS || protocol == ISO_15693) ? 32 : 1);
+        }
+
+        pos += TRACELOG_HDR_LEN + hdr->data_len + TRACELOG_PARITY_LEN(hdr);
+        rec++;
+    }
+
+    if (count == 0) {
+        free(segs);
+        return in_window;
+    }
+    segs[count - 1].end = pos;
+
+    if (pool) {
+        pool->dirty = dirty;
+        if (count > 1 && pool->started == 0 && pool->threads > 1)
+            trace_pool_start(pool);
+    }
+
+    bool res = in_window;
+    if (pool && pool->started && opt->show_hex == false) {
+
+        // a buffer listed by the workers is picked up by them, whatever its size
+        if (trace_pool_run(pool, trace, len, tags, opt, segs, count) == false)
+            res = false;
+
+    } else {
+        if (pool)
+            LoadAnnotateState(&pool->carry);
+
+        for (uint32_t i = 0; i < count; i++) {
+            if (trace_list_segment(trace, len, tags, &segs[i], opt, NULL) == false) {
+                res = false;
+                break;
+            }
+            if (i + 1 < count)
+                segs[i + 1].prev_eot = segs[i].prev_eot;
+        }
+
+        if (pool)
+            SaveAnnotateState(&pool->carry);
+    }
+
+    opt->prev_eot = segs[count - 1].prev_eot;
+    free(segs);
+    return res;
+}
+
+static int trace_list(trace_list_opt_t *opt) {
+
+    // annotation starts over for every listing
+    ClearAnnotateState();
+
+    trace_pool_t pool = { .threads = (opt->show_hex) ? 0 : opt->threads };
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.cond, NULL);
+    SaveAnnotateState(&pool.carry);
+
+    int res = PM3_SUCCESS;
+    if (g_tracefile.f == NULL) {
+        uint32_t first = ((tracelog_hdr_t *)g_trace)->timestamp;
+        opt->first_timestamp = first;
+        trace_list_records(g_trace, g_traceLen, NULL, first, first, opt, &pool);
+        trace_pool_stop(&pool);
+        return res;
+    }
+
+    // only the blocks holding the window are read and decoded
+    uint64_t start = g_tracefile.index[0].timestamp;
+    opt->first_timestamp = (uint32_t)start;
+
+    uint64_t from = (opt->from > UINT64_MAX - start) ? UINT64_MAX : start + opt->from;
+    for (uint32_t b = tracefile_find_block(&g_tracefile, from); b < g_tracefile.hdr.block_count; b++) {
+        const uint8_t *tags;
+        uint8_t *records;
+        uint32_t len;
+        res = tracefile_read_block(&g_tracefile, b, &tags, &records, &len);
+        if (res != PM3_SUCCESS) {
+            PrintAndLogEx(FAILED, "failed to read block %u of indexed trace", b);
+            break;
+        }
+
+        if (trace_list_records(records, len, tags, g_tracefile.index[b].timestamp, start, opt, &pool) == false)
+            break;
+    }
+    trace_pool_stop(&pool);
+    return res;
+}
+
 int CmdTraceList(const char *Cmd) {
     CLIParserContext *ctx;
     CLIParserInit(&ctx, "trace list",
@@ -607,7 +1719,10 @@ int CmdTraceList(const char *Cmd) {
                   "trace list -t lto      -> interpret as " _YELLOW_("LTO-CM") " communications\n"
                   "trace list -t cryptorf -> interpret as " _YELLOW_("CryptoRF") " communitcations\n"
                   "trace list -t 14a f    -> show frame delay times\n"
-                  "trace list -t 14a 1    -> use trace buffer "
+                  "trace list -t 14a 1    -> use trace buffer \n"
+                  "trace list -1 --from 1000000 --to 2000000  -> only list records in this time window\n"
+                  "trace list -1 -t 14a --csv -o hf14a.csv    -> write annotated records to a CSV file\n"
+                  "trace list -1 -t 14a --json -j 1           -> JSON output, annotated on a single thread"
                  );
 
     void *argtable[] = {
@@ -620,6 +1735,12 @@ int CmdTraceList(const char *Cmd) {
         arg_lit0("x", NULL, "show hexdump to convert to pcap(ng)\n"
                  "                                   or to import into Wireshark using encapsulation type \"ISO 14443\""),
         arg_strx0("t", "type", NULL, "protocol to annotate the trace"),
+        arg_u64_0(NULL, "from", "<dec>", "only list records starting at or after this time"),
+        arg_u64_0(NULL, "to", "<dec>", "only list records starting at or before this time"),
+        arg_lit0(NULL, "csv", "one CSV row per record"),
+        arg_lit0(NULL, "json", "one JSON object per record"),
+        arg_str0("o", "out", "<fn>", "write listing to file instead of console"),
+        arg_int0("j", "threads", "<dec>", "threads used to annotate (def number of CPUs)"),
         arg_param_end
     };
     CLIExecWithReturn(ctx, Cmd, argtable, false);
@@ -636,54 +1757,103 @@ int CmdTraceList(const char *Cmd) {
     CLIParamStrToBuf(arg_get_str(ctx, 7), (uint8_t *)type, sizeof(type), &tlen);
     str_lower(type);
 
+    bool csv = arg_get_lit(ctx, 10);
+    bool json = arg_get_lit(ctx, 11);
+
+    int fnlen = 0;
+    char filename[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 12), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+
+    trace_list_opt_t opt = {
+        .show_hex = show_hex,
+        .show_wait_cycles = show_wait_cycles,
+        .mark_crc = mark_crc,
+        .use_us = use_us,
+        .use_tags = (tlen == 0),
+        .from = arg_get_u64_def(ctx, 8, 0),
+        .to = arg_get_u64_def(ctx, 9, UINT64_MAX),
+        .use_relative = use_relative,
+        .threads = arg_get_int_def(ctx, 13, num_CPUs()),
+        .fmt = (json) ? TRACE_FMT_JSON : (csv) ? TRACE_FMT_CSV : TRACE_FMT_TEXT,
+    };
     CLIParserFree(ctx);
 
+    if (csv && json) {
+        PrintAndLogEx(FAILED, "select only one of " _YELLOW_("--csv") " or " _YELLOW_("--json"));
+        return PM3_EINVARG;
+    }
+
+    if (show_hex && (csv || json || fnlen)) {
+        PrintAndLogEx(FAILED, "hexdump can't be combined with " _YELLOW_("--csv") ", " _YELLOW_("--json") " or " _YELLOW_("-o"));
+        return PM3_EINVARG;
+    }
+
     clearCommandBuffer();
 
-    // no crc, no annotations
-    uint8_t protocol = -1;
-
-    // validate type of output
-    if (strcmp(type,      "iclass") == 0)   protocol = ICLASS;
-    else if (strcmp(type, "14a") == 0)      protocol = ISO_14443A;
-    else if (strcmp(type, "14b") == 0)      protocol = ISO_14443B;
-    else if (strcmp(type, "topaz") == 0)    protocol = TOPAZ;
-    else if (strcmp(type, "7816") == 0)     protocol = ISO_7816_4;
-    else if (strcmp(type, "des") == 0)      protocol = MFDES;
-    else if (strcmp(type, "legic") == 0)    protocol = LEGIC;
-    else if (strcmp(type, "15") == 0)       protocol = ISO_15693;
-    else if (strcmp(type, "felica") == 0)   protocol = FELICA;
-    else if (strcmp(type, "mf") == 0)       protocol = PROTO_MIFARE;
-    else if (strcmp(type, "hitag1") == 0)   protocol = PROTO_HITAG1;
-    else if (strcmp(type, "hitag2") == 0)   protocol = PROTO_HITAG2;
-    else if (strcmp(type, "hitags") == 0)   protocol = PROTO_HITAGS;
-    else if (strcmp(type, "thinfilm") == 0) protocol = THINFILM;
-    else if (strcmp(type, "lto") == 0)      protocol = LTO;
-    else if (strcmp(type, "cryptorf") == 0) protocol = PROTO_CRYPTORF;
-    else if (strcmp(type, "raw") == 0)      protocol = -1;
-
-    if (use_buffer == false || (g_traceLen == 0)) {
+    uint8_t protocol = get_trace_protocol(type);
+    opt.protocol = protocol;
+
+    if (use_buffer == false || (g_traceLen == 0 && g_tracefile.f == NULL)) {
         download_trace();
     }
 
-    PrintAndLogEx(SUCCESS, "Recorded activity (trace len = " _YELLOW_("%lu") " bytes)", g_traceLen);
-    if (g_traceLen == 0) {
-        return PM3_SUCCESS;
+    if (g_tracefile.f) {
+        PrintAndLogEx(SUCCESS, "Recorded activity (indexed trace, " _YELLOW_("%" PRIu64) " records)", g_tracefile.hdr.record_count);
+        if (g_tracefile.hdr.record_count == 0)
+            return PM3_SUCCESS;
+    } else {
+        PrintAndLogEx(SUCCESS, "Recorded activity (trace len = " _YELLOW_("%lu") " bytes)", g_traceLen);
+        if (g_traceLen == 0) {
+            return PM3_SUCCESS;
+        }
     }
 
-    uint16_t tracepos = 0;
-
     /*
     if (protocol == FELICA) {
         printFelica(g_traceLen, g_trace);
     } */
 
     if (show_hex) {
-        while (tracepos < g_traceLen) {
-            tracepos = printHexLine(tracepos, g_traceLen, g_trace, protocol);
+        trace_list(&opt);
+    } else if (opt.fmt != TRACE_FMT_TEXT) {
+
+        if (fnlen) {
+            opt.f = fopen(filename, "w");
+            if (opt.f == NULL) {
+                PrintAndLogEx(WARNING, "file not found or locked. '" _YELLOW_("%s")"'", filename);
+                return PM3_EFILE;
+            }
+        }
+
+        if (protocol == ISO_14443A || protocol == PROTO_MIFARE)
+            ClearAuthData();
+
+        const char *head = (opt.fmt == TRACE_FMT_JSON) ? "["
+                           : (use_relative) ? "gap,duration,src,data,crc,annotation,fdt,decrypted,decrypted_crc,decrypted_annotation"
+                           : "start,end,src,data,crc,annotation,fdt,decrypted,decrypted_crc,decrypted_annotation";
+        if (opt.f)
+            fprintf(opt.f, "%s\n", head);
+        else
+            PrintAndLogEx(NORMAL, "%s", head);
+
+        trace_list(&opt);
+
+        if (opt.fmt == TRACE_FMT_JSON) {
+            if (opt.f)
+                fprintf(opt.f, "]\n");
+            else
+                PrintAndLogEx(NORMAL, "]");
         }
     } else {
 
+        if (fnlen) {
+            opt.f = fopen(filename, "w");
+            if (opt.f == NULL) {
+                PrintAndLogEx(WARNING, "file not found or locked. '" _YELLOW_("%s")"'", filename);
+                return PM3_EFILE;
+            }
+        }
+
         if (use_relative) {
             PrintAndLogEx(INFO, _YELLOW_("gap") " = time between transfers. " _YELLOW_("duration") " = duration of data transfer. " _YELLOW_("src") " = source of transfer");
         } else {
@@ -738,28 +1908,22 @@ int CmdTraceList(const char *Cmd) {
 
         PrintAndLogEx(NORMAL, "");
         if (use_relative) {
-            PrintAndLogEx(NORMAL, "        Gap |   Duration | Src | Data (! denotes parity error, ' denotes short bytes)                    | CRC | Annotation");
+            trace_emit(&opt, "        Gap |   Duration | Src | Data (! denotes parity error, ' denotes short bytes)                    | CRC | Annotation");
         } else {
-            PrintAndLogEx(NORMAL, "      Start |        End | Src | Data (! denotes parity error)                                           | CRC | Annotation");
+            trace_emit(&opt, "      Start |        End | Src | Data (! denotes parity error)                                           | CRC | Annotation");
         }
-        PrintAndLogEx(NORMAL, "------------+------------+-----+-------------------------------------------------------------------------+-----+--------------------");
+        trace_emit(&opt, "------------+------------+-----+-------------------------------------------------------------------------+-----+--------------------");
 
         // clean authentication data used with the mifare classic decrypt fct
         if (protocol == ISO_14443A || protocol == PROTO_MIFARE)
             ClearAuthData();
 
-        uint32_t previous_EOT = 0;
-        uint32_t *prev_EOT = NULL;
-        if (use_relative) {
-            prev_EOT = &previous_EOT;
-        }
-
-        while (tracepos < g_traceLen) {
-            tracepos = printTraceLine(tracepos, g_traceLen, g_trace, protocol, show_wait_cycles, mark_crc, prev_EOT, use_us);
+        trace_list(&opt);
+    }
 
-            if (kbd_enter_pressed())
-                break;
-        }
+    if (opt.f) {
+        fclose(opt.f);
+        PrintAndLogEx(SUCCESS, "saved " _YELLOW_("%" PRIu64) " lines to " _YELLOW_("%s"), opt.rows, filename);
     }
 
     if (show_hex)
@@ -773,6 +1937,7 @@ static command_t CommandTable[] = {
     {"list",    CmdTraceList,     AlwaysAvailable, "List protocol data in trace buffer"},
     {"load",    CmdTraceLoad,     AlwaysAvailable, "Load trace from file"},
     {"save",    CmdTraceSave,     AlwaysAvailable, "Save trace buffer to file"},
+    {"stream",  CmdTraceStream,   AlwaysAvailable, "Stream trace to file while sniffing"},
     {NULL, NULL, NULL, NULL}
 };
 
@@ -16,4 +16,11 @@
 int CmdTrace(const char *Cmd);
 int CmdTraceList(const char *Cmd);
 
+// appends a chunk of streamed trace records, called from the comms thread
+void trace_stream_data(const uint8_t *data, uint16_t len);
+// prints the streamed records queued for live decode, called from the main thread
+void trace_stream_print(void);
+// true while a trace stream is running
+bool trace_stream_active(void);
+
 #endif
@@ -112,18 +112,59 @@ int CmdWiegandEncode(const char *Cmd) {
     return PM3_SUCCESS;
 }
 
+static int wiegand_load_file(const char *filename, wiegand_message_t **packed, size_t *count) {
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        PrintAndLogEx(ERR, "Error: Could not open file ["_YELLOW_("%s")"]", filename);
+        return PM3_EFILE;
+    }
+
+    size_t cap = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+
+        // skip comments and empty lines
+        char *p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '#' || *p == '\0')
+            continue;
+
+        if (*count == cap) {
+            cap = cap ? cap * 2 : 64;
+            wiegand_message_t *tmp = realloc(*packed, cap * sizeof(wiegand_message_t));
+            if (tmp == NULL) {
+                fclose(f);
+                return PM3_EMALLOC;
+            }
+            *packed = tmp;
+        }
+
+        uint32_t top = 0, mid = 0, bot = 0;
+        hexstring_to_u96(&top, &mid, &bot, p);
+        (*packed)[(*count)++] = initialize_message_object(top, mid, bot);
+    }
+    fclose(f);
+    return PM3_SUCCESS;
+}
+
 int CmdWiegandDecode(const char *Cmd) {
 
     CLIParserContext *ctx;
     CLIParserInit(&ctx, "wiegand decode",
-                  "Decode raw hex to wiegand format",
-                  "wiegand decode --raw 2006f623ae"
+                  "Decode raw hex to wiegand format.\n"
+                  "A file holds one raw hex per line, all of them are decoded",
+                  "wiegand decode --raw 2006f623ae\n"
+                  "wiegand decode -j --raw 2006f623ae\n"
+                  "wiegand decode -f wiegand.txt"
                  );
 
     void *argtable[] = {
         arg_param_begin,
         arg_lit0("p", "parity", "ignore invalid parity"),
-        arg_strx1(NULL, "raw", "<hex>", "raw hex to be decoded"),
+        arg_strx0(NULL, "raw", "<hex>", "raw hex to be decoded"),
+        arg_str0("f", "file", "<filename>", "file of raw hex to be decoded"),
+        arg_lit0("j", "json", "output as JSON, one object per raw hex"),
         arg_param_end
     };
     CLIExecWithReturn(ctx, Cmd, argtable, false);
@@ -132,19 +173,76 @@ int CmdWiegandDecode(const char *Cmd) {
     int len = 0;
     char hex[40] = {0};
     CLIParamStrToBuf(arg_get_str(ctx, 2), (uint8_t *)hex, sizeof(hex), &len);
+    int fnlen = 0;
+    char filename[FILE_PATH_SIZE] = {0};
+    CLIParamStrToBuf(arg_get_str(ctx, 3), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+    bool use_json = arg_get_lit(ctx, 4);
     CLIParserFree(ctx);
 
-    if (len == 0) {
+    if (len == 0 && fnlen == 0) {
         PrintAndLogEx(ERR, "empty input");
         return PM3_EINVARG;
     }
 
-    uint32_t top = 0, mid = 0, bot = 0;
-    hexstring_to_u96(&top, &mid, &bot, hex);
+    wiegand_message_t *packed = NULL;
+    size_t count = 0;
+
+    if (fnlen) {
+        int res = wiegand_load_file(filename, &packed, &count);
+        if (res != PM3_SUCCESS) {
+            free(packed);
+            return res;
+        }
+    } else {
+        packed = calloc(1, sizeof(wiegand_message_t));
+        if (packed == NULL)
+            return PM3_EMALLOC;
+
+        uint32_t top = 0, mid = 0, bot = 0;
+        hexstring_to_u96(&top, &mid, &bot, hex);
+        packed[count++] = initialize_message_object(top, mid, bot);
+    }
+
+    if (use_json) {
+        json_t *root = HIDUnpackBatchJSON(packed, count, ignore_parity);
+        size_t i;
+        json_t *value;
+        json_array_foreach(root, i, value) {
+            char *s = json_dumps(value, JSON_COMPACT | JSON_PRESERVE_ORDER);
+            if (s) {
+                PrintAndLogEx(NORMAL, "%s", s);
+                free(s);
+            }
+        }
+        json_decref(root);
+        free(packed);
+        return PM3_SUCCESS;
+    }
+
+    if (fnlen == 0) {
+        HIDTryUnpack(packed, ignore_parity);
+        free(packed);
+        return PM3_SUCCESS;
+    }
 
-    wiegand_message_t packed = initialize_message_object(top, mid, bot);
-    HIDTryUnpack(&packed, ignore_parity);
+    wiegand_result_t *results = calloc(count, sizeof(wiegand_result_t));
+    if (results == NULL) {
+        free(packed);
+        return PM3_EMALLOC;
+    }
+
+    size_t found = HIDUnpackBatch(packed, count, ignore_parity, results);
+    for (size_t i = 0; i < count; i++) {
+        if (packed[i].Top != 0)
+            PrintAndLogEx(INFO, "raw: " _YELLOW_("%X%08X%08X"), packed[i].Top, packed[i].Mid, packed[i].Bot);
+        else
+            PrintAndLogEx(INFO, "raw: " _YELLOW_("%X%08X"), packed[i].Mid, packed[i].Bot);
+        HIDDisplayUnpacked(&packed[i], &results[i]);
+    }
+    PrintAndLogEx(SUCCESS, "decoded " _YELLOW_("%zu") " of %zu", found, count);
 
+    free(results);
+    free(packed);
     return PM3_SUCCESS;
 }
 
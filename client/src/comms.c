@@ -21,6 +21,8 @@
 #include "util.h" // g_pendingPrompt
 #include "util_posix.h" // msclock
 #include "util_darwin.h" // en/dis-ableNapp();
+#include "cmdtrace.h"  // trace_stream_data, trace_stream_print
+#include "lfstream.h"  // lf_stream_data
 
 //#define COMMS_DEBUG
 //#define COMMS_DEBUG_RAW
@@ -312,6 +314,16 @@ static void PacketResponseReceived(PacketResponseNG *packet) {
                 PrintAndLogEx(NORMAL, "[" _MAGENTA_("pm3") "] ["_BLUE_("#")"] " "%" PRIx64 ", %" PRIx64 ", %" PRIx64 "", packet->oldarg[0], packet->oldarg[1], packet->oldarg[2]);
             break;
         }
+        case CMD_TRACE_STREAM_DATA: {
+            if (packet->ng)
+                trace_stream_data(packet->data.asBytes, packet->length);
+            break;
+        }
+        case CMD_LF_SNIFF_STREAM_DATA: {
+            if (packet->ng)
+                lf_stream_data(packet->data.asBytes, packet->length);
+            break;
+        }
         // iceman:  hw status - down the path on device, runs printusbspeed which starts sending a lot of
         // CMD_DOWNLOAD_BIGBUF packages which is not dealt with. I wonder if simply ignoring them will
         // work. lets try it.
@@ -750,6 +762,9 @@ bool WaitForResponseTimeoutW(uint32_t cmd, PacketResponseNG *response, size_t ms
             PrintAndLogEx(INFO, "You can cancel this operation by pressing the pm3 button");
             show_warning = false;
         }
+        // live decode of a trace stream, kept out of the comms thread
+        trace_stream_print();
+
         // just to avoid CPU busy loop:
         msleep(10);
     }
@@ -0,0 +1,440 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// reveng preset models compiled to table driven CRC engines
+//-----------------------------------------------------------------------------
+#include "crcmodels.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "reveng.h"
+#include "cmdcrc.h"             // RunModel
+#include "ui.h"
+#include "pm3_cmd.h"
+
+// One direction of a model. RunModel() runs a plain MSB first division over the
+// message bits, the input reflection only changes the order the bits of each
+// byte come in. When they come LSB first the register is kept reflected, the
+// classic table driven reflected CRC.
+typedef struct {
+    uint64_t table[8][256];
+    uint64_t init;          // register start, left aligned or reflected
+    uint64_t xorout;        // on the crc, as RunModel() applies it
+    bool lsb_first;
+} crc_engine_t;
+
+typedef struct {
+    char *name;
+    uint8_t width;
+    uint8_t chars;
+    int flags;                  // reveng P_ flags, for the output
+    crc_engine_t *engine[2];    // plain, reversed. NULL runs reveng
+} crc_model_t;
+
+static crc_model_t *crc_models = NULL;
+static int crc_models_len = 0;
+static pthread_once_t crc_models_once = PTHREAD_ONCE_INIT;
+
+// RunModel() keeps its model in a static
+static pthread_mutex_t crc_reveng_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char crc_hex[] = "0123456789abcdef0123456789ABCDEF";
+
+static uint64_t crc_reflect(uint64_t v, uint8_t bits) {
+    uint64_t r = 0;
+    for (uint8_t i = 0; i < bits; i++) {
+        r = (r << 1) | (v & 1);
+        v >>= 1;
+    }
+    return r;
+}
+
+static uint64_t crc_poly_u64(const poly_t p) {
+    char *s = ptostr(p, P_RTJUST, 8);
+    if (s == NULL)
+        return 0;
+    uint64_t v = strtoull(s, NULL, 16);
+    free(s);
+    return v;
+}
+
+static crc_engine_t *crc_engine_create(uint8_t width, uint64_t poly, uint64_t init, uint64_t xorout, bool lsb_first) {
+    crc_engine_t *e = calloc(1, sizeof(crc_engine_t));
+    if (e == NULL)
+        return NULL;
+
+    e->lsb_first = lsb_first;
+    e->xorout = xorout;
+
+    if (lsb_first) {
+        uint64_t rpoly = crc_reflect(poly, width);
+        for (int b = 0; b < 256; b++) {
+            uint64_t r = b;
+            for (int i = 0; i < 8; i++)
+                r = (r & 1) ? (r >> 1) ^ rpoly : r >> 1;
+            e->table[0][b] = r;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (int b = 0; b < 256; b++)
+                e->table[k][b] = (e->table[k - 1][b] >> 8) ^ e->table[0][e->table[k - 1][b] & 0xFF];
+        }
+        e->init = crc_reflect(init, width);
+    } else {
+        uint8_t shift = 64 - width;
+        uint64_t apoly = poly << shift;
+        for (int b = 0; b < 256; b++) {
+            uint64_t r = (uint64_t)b << 56;
+            for (int i = 0; i < 8; i++)
+                r = (r >> 63) ? (r << 1) ^ apoly : r << 1;
+            e->table[0][b] = r;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (int b = 0; b < 256; b++)
+                e->table[k][b] = (e->table[k - 1][b] << 8) ^ e->table[0][e->table[k - 1][b] >> 56];
+        }
+        e->init = init << shift;
+    }
+    return e;
+}
+
+// bytes in reverse order when the whole message is reflected
+static uint64_t crc_engine_run(const crc_engine_t *e, uint8_t width, const uint8_t *data, size_t len, bool backwards) {
+    const uint64_t (*t)[256] = e->table;
+    uint64_t reg = e->init;
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8) {
+        uint8_t b[8];
+        if (backwards) {
+            for (int k = 0; k < 8; k++)
+                b[k] = data[len - 1 - i - k];
+        } else {
+            memcpy(b, data + i, 8);
+        }
+
+        if (e->lsb_first) {
+            reg ^= (uint64_t)b[0] | (uint64_t)b[1] << 8 | (uint64_t)b[2] << 16 | (uint64_t)b[3] << 24
+                   | (uint64_t)b[4] << 32 | (uint64_t)b[5] << 40 | (uint64_t)b[6] << 48 | (uint64_t)b[7] << 56;
+            reg = t[7][reg & 0xFF] ^ t[6][(reg >> 8) & 0xFF] ^ t[5][(reg >> 16) & 0xFF] ^ t[4][(reg >> 24) & 0xFF]
+                  ^ t[3][(reg >> 32) & 0xFF] ^ t[2][(reg >> 40) & 0xFF] ^ t[1][(reg >> 48) & 0xFF] ^ t[0][reg >> 56];
+        } else {
+            reg ^= (uint64_t)b[0] << 56 | (uint64_t)b[1] << 48 | (uint64_t)b[2] << 40 | (uint64_t)b[3] << 32
+                   | (uint64_t)b[4] << 24 | (uint64_t)b[5] << 16 | (uint64_t)b[6] << 8 | (uint64_t)b[7];
+            reg = t[7][reg >> 56] ^ t[6][(reg >> 48) & 0xFF] ^ t[5][(reg >> 40) & 0xFF] ^ t[4][(reg >> 32) & 0xFF]
+                  ^ t[3][(reg >> 24) & 0xFF] ^ t[2][(reg >> 16) & 0xFF] ^ t[1][(reg >> 8) & 0xFF] ^ t[0][reg & 0xFF];
+        }
+    }
+
+    for (; i < len; i++) {
+        uint8_t b = backwards ? data[len - 1 - i] : data[i];
+        if (e->lsb_first)
+            reg = (reg >> 8) ^ t[0][(reg ^ b) & 0xFF];
+        else
+            reg = (reg << 8) ^ t[0][(reg >> 56) ^ b];
+    }
+
+    uint64_t crc = e->lsb_first ? crc_reflect(reg, width) : reg >> (64 - width);
+    return crc ^ e->xorout;
+}
+
+// as reveng's ptostr() with 8 bits per hex word
+static void crc_format(uint64_t crc, uint8_t width, int flags, char *out) {
+    const char *hex = crc_hex + ((flags & P_UPPER) ? 16 : 0);
+    uint8_t part = width % 8;
+    uint8_t left = width;
+
+    if (part && (flags & P_RTJUST)) {
+        uint8_t accu = (crc >> (width - part)) & ((1 << part) - 1);
+        if (flags & P_REFOUT)
+            accu = crc_reflect(accu, 8);
+        *out++ = hex[accu >> 4];
+        *out++ = hex[accu & 0xF];
+        left -= part;
+    }
+
+    for (; left >= 8; left -= 8) {
+        uint8_t accu = (crc >> (left - 8)) & 0xFF;
+        if (flags & P_REFOUT)
+            accu = crc_reflect(accu, 8);
+        *out++ = hex[accu >> 4];
+        *out++ = hex[accu & 0xF];
+    }
+
+    if (left) {
+        uint8_t accu = crc & ((1 << left) - 1);
+        if (flags & P_REFOUT)
+            accu = crc_reflect(accu, left);
+        else
+            accu <<= 8 - left;
+        *out++ = hex[accu >> 4];
+        *out++ = hex[accu & 0xF];
+    }
+    *out = '\0';
+}
+
+static void crc_reveng_calc(const crc_model_t *m, bool reverse, const uint8_t *data, size_t len, char *out) {
+    char *hexstr = calloc(len * 2 + 1, sizeof(char));
+    if (hexstr == NULL) {
+        out[0] = '\0';
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        hexstr[i * 2] = crc_hex[data[i] >> 4];
+        hexstr[i * 2 + 1] = crc_hex[data[i] & 0xF];
+    }
+
+    char result[50 + 1] = {0};
+    pthread_mutex_lock(&crc_reveng_lock);
+    int ans = RunModel(m->name, hexstr, reverse, 0, result);
+    pthread_mutex_unlock(&crc_reveng_lock);
+    free(hexstr);
+
+    if (ans == 0)
+        result[0] = '\0';
+    result[CRC_MODEL_MAX_CHARS - 1] = '\0';
+    strcpy(out, result);
+}
+
+static void crc_calc(const crc_model_t *m, bool reverse, const uint8_t *data, size_t len, char *out) {
+    const crc_engine_t *e = m->engine[reverse];
+    if (e == NULL) {
+        crc_reveng_calc(m, reverse, data, len, out);
+        return;
+    }
+
+    uint64_t crc = crc_engine_run(e, m->width, data, len, reverse);
+    if (reverse)
+        crc = crc_reflect(crc, m->width);
+    crc_format(crc, m->width, m->flags, out);
+}
+
+// the same steps as RunModel(), once
+static crc_engine_t *crc_compile(int num, bool reverse) {
+    model_t model = MZERO;
+    mbynum(&model, num);
+    mcanon(&model);
+
+    uint8_t width = plen(model.spoly);
+    if (width == 0 || width > 64) {
+        mfree(&model);
+        return NULL;
+    }
+
+    if (reverse) {
+        prcp(&model.spoly);
+        if (~model.flags & P_REFOUT) {
+            prev(&model.init);
+            prev(&model.xorout);
+        }
+        poly_t tmp = model.init;
+        model.init = model.xorout;
+        model.xorout = tmp;
+    }
+    if (model.flags & P_REFOUT)
+        prev(&model.xorout);
+
+    // reversing the whole message turns the bits of each byte around
+    bool lsb_first = ((model.flags & P_REFIN) != 0) != reverse;
+
+    crc_engine_t *e = crc_engine_create(width, crc_poly_u64(model.spoly), crc_poly_u64(model.init), crc_poly_u64(model.xorout), lsb_first);
+    mfree(&model);
+    return e;
+}
+
+static void crc_models_compile(void) {
+    SETBMP();
+
+    int count = mcount();
+    if (count <= 0)
+        return;
+
+    crc_models = calloc(count, sizeof(crc_model_t));
+    if (crc_models == NULL)
+        return;
+
+    static const uint8_t check[] = "123456789";
+
+    for (int i = 0; i < count; i++) {
+        crc_model_t *m = &crc_models[i];
+        model_t model = MZERO;
+        mbynum(&model, i);
+        mcanon(&model);
+        m->name = strdup(model.name ? model.name : "");
+        m->width = plen(model.spoly);
+        m->chars = ((m->width + 7) / 8) * 2;
+        m->flags = model.flags;
+        mfree(&model);
+
+        for (int r = 0; r < 2; r++) {
+            m->engine[r] = crc_compile(i, r);
+            if (m->engine[r] == NULL)
+                continue;
+
+            // an engine that doesn't agree with reveng on the check string isn't used
+            char want[CRC_MODEL_MAX_CHARS], got[CRC_MODEL_MAX_CHARS];
+            crc_calc(m, r, check, sizeof(check) - 1, got);
+            crc_engine_t *e = m->engine[r];
+            m->engine[r] = NULL;
+            crc_reveng_calc(m, r, check, sizeof(check) - 1, want);
+            if (strcmp(want, got) == 0) {
+                m->engine[r] = e;
+            } else {
+                PrintAndLogEx(DEBUG, "DEBUG: %s%s runs on reveng, %s != %s", m->name, r ? " reversed" : "", got, want);
+                free(e);
+            }
+        }
+    }
+    crc_models_len = count;
+}
+
+int crc_models_count(void) {
+    pthread_once(&crc_models_once, crc_models_compile);
+    return crc_models_len;
+}
+
+const char *crc_model_name(int idx) {
+    return (idx >= 0 && idx < crc_models_count()) ? crc_models[idx].name : NULL;
+}
+
+uint8_t crc_model_width(int idx) {
+    return (idx >= 0 && idx < crc_models_count()) ? crc_models[idx].width : 0;
+}
+
+uint8_t crc_model_chars(int idx) {
+    return (idx >= 0 && idx < crc_models_count()) ? crc_models[idx].chars : 0;
+}
+
+void crc_model_calc(int idx, bool reverse, const uint8_t *data, size_t len, char *out) {
+    if (idx < 0 || idx >= crc_models_count()) {
+        out[0] = '\0';
+        return;
+    }
+    crc_calc(&crc_models[idx], reverse, data, len, out);
+}
+
+typedef struct {
+    const char *hex;
+    size_t len;
+    uint8_t *bytes;         // the hex digit pairs, a last odd digit is dropped as reveng does
+} crc_frame_t;
+
+typedef struct {
+    const crc_frame_t *frames;
+    size_t count;
+    uint8_t *hits;
+    int next;
+    pthread_mutex_t lock;
+} crc_search_job_t;
+
+static void crc_swap_endian(const char *in, uint8_t chars, char *out) {
+    for (uint8_t i = 0; i < chars; i += 2) {
+        out[i] = in[chars - 2 - i];
+        out[i + 1] = in[chars - 1 - i];
+    }
+    out[chars] = '\0';
+}
+
+static uint8_t crc_match(const crc_model_t *m, const crc_frame_t *f) {
+    // can't test a model that has more crc digits than our data
+    if (m->chars == 0 || m->chars >= f->len)
+        return 0;
+
+    const char *crc = f->hex + (f->len - m->chars);
+    size_t n = (f->len - m->chars) / 2;
+    uint8_t match = 0;
+
+    for (int r = 0; r < 2; r++) {
+        char result[CRC_MODEL_MAX_CHARS], swapped[CRC_MODEL_MAX_CHARS];
+        crc_calc(m, r, f->bytes, n, result);
+        if (memcmp(result, crc, m->chars) == 0) {
+            match |= r ? CRC_MATCH_REV_VALUE : CRC_MATCH_VALUE;
+        } else if (m->chars > 2) {
+            crc_swap_endian(result, m->chars, swapped);
+            if (memcmp(swapped, crc, m->chars) == 0)
+                match |= r ? CRC_MATCH_REV_SWAPPED : CRC_MATCH_SWAPPED;
+        }
+    }
+    return match;
+}
+
+static void *crc_search_worker(void *arg) {
+    crc_search_job_t *job = (crc_search_job_t *)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int idx = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (idx >= crc_models_len)
+            break;
+
+        for (size_t f = 0; f < job->count; f++)
+            job->hits[f * crc_models_len + idx] = crc_match(&crc_models[idx], &job->frames[f]);
+    }
+    return NULL;
+}
+
+int crc_search(const char **frames, size_t count, int threads, uint8_t *hits) {
+
+    int nmodels = crc_models_count();
+    if (nmodels == 0) {
+        PrintAndLogEx(WARNING, "no preset models available");
+        return PM3_ESOFT;
+    }
+
+    crc_frame_t *f = calloc(count, sizeof(crc_frame_t));
+    if (f == NULL)
+        return PM3_EMALLOC;
+
+    int ret = PM3_SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        f[i].hex = frames[i];
+        f[i].len = strlen(frames[i]);
+        f[i].bytes = calloc(f[i].len / 2 + 1, sizeof(uint8_t));
+        if (f[i].bytes == NULL) {
+            ret = PM3_EMALLOC;
+            break;
+        }
+        for (size_t j = 0; j < f[i].len / 2; j++) {
+            char pair[3] = { frames[i][j * 2], frames[i][j * 2 + 1], 0 };
+            f[i].bytes[j] = strtoul(pair, NULL, 16);
+        }
+    }
+
+    if (ret == PM3_SUCCESS) {
+        crc_search_job_t job = {
+            .frames = f,
+            .count = count,
+            .hits = hits,
+        };
+        pthread_mutex_init(&job.lock, NULL);
+
+        threads = MAX(1, MIN(threads, nmodels));
+        pthread_t *tids = calloc(threads, sizeof(pthread_t));
+        int started = 0;
+        if (tids) {
+            // the calling thread works too
+            for (; started < threads - 1; started++) {
+                if (pthread_create(&tids[started], NULL, crc_search_worker, &job) != 0)
+                    break;
+            }
+        }
+
+        crc_search_worker(&job);
+
+        for (int i = 0; i < started; i++)
+            pthread_join(tids[i], NULL);
+
+        free(tids);
+        pthread_mutex_destroy(&job.lock);
+    }
+
+    for (size_t i = 0; i < count; i++)
+        free(f[i].bytes);
+    free(f);
+    return ret;
+}
@@ -0,0 +1,41 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// reveng preset models compiled to table driven CRC engines
+//
+// Every preset is compiled once, for the plain and the reversed calculation of
+// RunModel(). Widths up to 64 bits run slice-by-8 on a 64 bit register, wider
+// presets still go through reveng. The results are the strings reveng prints.
+//-----------------------------------------------------------------------------
+
+#ifndef CRCMODELS_H__
+#define CRCMODELS_H__
+
+#include "common.h"
+
+// hex digits of the widest preset, CRC-82/DARC, and a null
+#define CRC_MODEL_MAX_CHARS     24
+
+// how a model matched a frame
+#define CRC_MATCH_VALUE         0x01
+#define CRC_MATCH_SWAPPED       0x02    // value endian swapped
+#define CRC_MATCH_REV_VALUE     0x04    // model reversed
+#define CRC_MATCH_REV_SWAPPED   0x08
+
+// the presets are compiled on the first call, 0 if there are none
+int crc_models_count(void);
+const char *crc_model_name(int idx);
+uint8_t crc_model_width(int idx);
+// hex digits of the crc, the last ones of a frame
+uint8_t crc_model_chars(int idx);
+
+// the crc of data as RunModel() gives it for the hex string of data, not endian swapped
+void crc_model_calc(int idx, bool reverse, const uint8_t *data, size_t len, char *out);
+
+// Tries all presets against all frames, lowercase hex strings with the crc last.
+// The models are shared out over threads, hits[frame * crc_models_count() + model] gets the CRC_MATCH_ bits
+int crc_search(const char **frames, size_t count, int threads, uint8_t *hits);
+
+#endif
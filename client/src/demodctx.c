@@ -0,0 +1,199 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// LF demodulation context
+//-----------------------------------------------------------------------------
+#include "demodctx.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "pm3_cmd.h"            // error codes
+
+// console and plot window
+demod_ctx_t g_demod_default = {
+    .sigprop = { 255, -255, 0, 0, true },
+    .graph_gen = 1,
+};
+
+__thread demod_ctx_t *g_demod_ctx = NULL;
+
+// the plot window paints the default graph buffer from its own thread
+static pthread_mutex_t g_demod_graph_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void demod_graph_lock(void) {
+    pthread_mutex_lock(&g_demod_graph_lock);
+}
+
+void demod_graph_unlock(void) {
+    pthread_mutex_unlock(&g_demod_graph_lock);
+}
+
+static void demod_ctx_init(demod_ctx_t *ctx) {
+    ctx->graph_len = 0;
+    demod_ctx_touch(ctx);
+    ctx->demod_len = 0;
+    ctx->demod_start_idx = 0;
+    ctx->demod_clock = 0;
+    ctx->demod_errors = 0;
+    ctx->demod_bits = 0;
+    ctx->em410x_id = 0;
+    ctx->sigprop.low = 255;
+    ctx->sigprop.high = -255;
+    ctx->sigprop.mean = 0;
+    ctx->sigprop.amplitude = 0;
+    ctx->sigprop.isnoise = true;
+    ctx->shared_waves = NULL;
+}
+
+demod_ctx_t *demod_ctx_create(void) {
+    // zeroed, some demodulators read a little past the demod buffer length
+    demod_ctx_t *ctx = calloc(1, sizeof(demod_ctx_t));
+    if (ctx == NULL)
+        return NULL;
+
+    demod_ctx_init(ctx);
+    ctx->saved_graph = NULL;
+    ctx->saved_graph_len = 0;
+    ctx->saved_grid_offset = 0;
+    ctx->saved_demod = NULL;
+    ctx->saved_demod_len = 0;
+    ctx->saved_demod_start_idx = 0;
+    ctx->saved_demod_clock = 0;
+    ctx->graph = NULL;
+    ctx->graph_cap = 0;
+    ctx->scratch = NULL;
+    ctx->scratch_cap = 0;
+    ctx->scratch_used = 0;
+    ctx->fft_plan = NULL;
+    return ctx;
+}
+
+void demod_ctx_free(demod_ctx_t *ctx) {
+    if (ctx == NULL || ctx == &g_demod_default)
+        return;
+
+    if (g_demod_ctx == ctx)
+        g_demod_ctx = NULL;
+
+    free(ctx->graph);
+    free(ctx->saved_graph);
+    free(ctx->saved_demod);
+    free(ctx->scratch);
+    lfWavesFree(&ctx->waves);
+    fft_plan_free(ctx->fft_plan);
+    free(ctx);
+}
+
+void demod_ctx_reset(demod_ctx_t *ctx) {
+    demod_ctx_init(ctx);
+}
+
+demod_ctx_t *demod_ctx_select(demod_ctx_t *ctx) {
+    demod_ctx_t *prev = g_demod_ctx;
+    g_demod_ctx = (ctx == &g_demod_default) ? NULL : ctx;
+    return prev;
+}
+
+bool demod_ctx_reserve(demod_ctx_t *ctx, size_t len) {
+    if (len <= ctx->graph_cap)
+        return true;
+
+    if (len > SIZE_MAX / sizeof(int) / 2)
+        return false;
+
+    // the plot window reads the default context from its own thread, grow that one in few big steps
+    size_t cap = (ctx == &g_demod_default) ? MAX_GRAPH_TRACE_LEN : 1024;
+    while (cap < len)
+        cap *= 2;
+
+    bool plotted = (ctx == &g_demod_default);
+    if (plotted)
+        demod_graph_lock();
+
+    int *graph = realloc(ctx->graph, cap * sizeof(int));
+    if (graph) {
+        ctx->graph = graph;
+        ctx->graph_cap = cap;
+    }
+
+    if (plotted)
+        demod_graph_unlock();
+    return (graph != NULL);
+}
+
+uint8_t *demod_ctx_scratch(demod_ctx_t *ctx, size_t len) {
+    if (len > ctx->scratch_cap) {
+        // the clock detectors and demods read past short captures, never hand out less than a full graph
+        size_t cap = MAX(len, MAX_GRAPH_TRACE_LEN);
+        uint8_t *scratch = realloc(ctx->scratch, cap);
+        if (scratch == NULL)
+            return NULL;
+
+        memset(scratch + ctx->scratch_cap, 0, cap - ctx->scratch_cap);
+        ctx->scratch = scratch;
+        ctx->scratch_cap = cap;
+    }
+
+    // what the last caller wrote past len is zeroed again
+    if (ctx->scratch_used > len)
+        memset(ctx->scratch + len, 0, ctx->scratch_used - len);
+    ctx->scratch_used = len;
+    return ctx->scratch;
+}
+
+const fft_plan_t *demod_ctx_fft_plan(demod_ctx_t *ctx, size_t n) {
+    if (ctx->fft_plan && ctx->fft_plan->n == n)
+        return ctx->fft_plan;
+
+    fft_plan_free(ctx->fft_plan);
+    ctx->fft_plan = fft_plan_create(n);
+    return ctx->fft_plan;
+}
+
+int demod_ctx_load(demod_ctx_t *ctx, const int *samples, size_t len) {
+    demod_ctx_init(ctx);
+
+    if (demod_ctx_reserve(ctx, len) == false)
+        return PM3_EMALLOC;
+
+    if (len)
+        memcpy(ctx->graph, samples, len * sizeof(int));
+    ctx->graph_len = len;
+    return PM3_SUCCESS;
+}
+
+int demod_ctx_copy(demod_ctx_t *dst, const demod_ctx_t *src) {
+    if (dst == src)
+        return PM3_SUCCESS;
+    if (demod_ctx_reserve(dst, src->graph_len) == false)
+        return PM3_EMALLOC;
+    if (src->graph_len)
+        memcpy(dst->graph, src->graph, src->graph_len * sizeof(int));
+    dst->graph_len = src->graph_len;
+    memcpy(dst->demod, src->demod, src->demod_len);
+    dst->demod_len = src->demod_len;
+    dst->demod_start_idx = src->demod_start_idx;
+    dst->demod_clock = src->demod_clock;
+    dst->demod_errors = src->demod_errors;
+    dst->demod_bits = src->demod_bits;
+    dst->em410x_id = src->em410x_id;
+    dst->sigprop = src->sigprop;
+    demod_ctx_touch(dst);
+    if (src->sigprop_gen == src->graph_gen)
+        dst->sigprop_gen = dst->graph_gen;
+    return PM3_SUCCESS;
+}
+
+void demod_ctx_share_waves(demod_ctx_t *dst, const demod_ctx_t *src) {
+    dst->shared_waves = NULL;
+    if (src->waves_gen != src->graph_gen || src->waves.size == 0)
+        return;
+
+    dst->shared_waves = &src->waves;
+    dst->shared_waves_gen = dst->graph_gen;
+}
@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// LF demodulation context
+//
+// Everything the LF demodulators work on: the sample (graph) buffer, the
+// demod buffer, the detected clock and the signal properties. The well known
+// names GraphBuffer, DemodBuffer, g_DemodClock, ... resolve to the context
+// selected by the calling thread, or to the default context used by the
+// console and the plot window when none is selected.
+//
+// The graph buffer grows on demand, writers that extend it call
+// demod_ctx_reserve (or reserveGraphBuf) first. Its size is only bounded by
+// memory, MAX_GRAPH_TRACE_LEN is what a device capture holds. Writers call
+// demod_ctx_touch when done, the signal properties are only computed again
+// for samples that changed.
+//
+// A thread running decoders on its own samples creates a context, selects it,
+// loads the samples and calls the usual demod functions:
+//
+//   demod_ctx_t *ctx = demod_ctx_create();
+//   demod_ctx_select(ctx);
+//   demod_ctx_load(ctx, samples, len);
+//   demodEM410x(false);
+//   demod_ctx_select(NULL);
+//   demod_ctx_free(ctx);
+//-----------------------------------------------------------------------------
+
+#ifndef DEMODCTX_H__
+#define DEMODCTX_H__
+
+#include "common.h"
+#include "lfdemod.h"            // signal_t
+#include "fft.h"                // fft_plan_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAX_GRAPH_TRACE_LEN (40000 * 8)
+#define MAX_DEMOD_BUF_LEN (1024*128)
+
+typedef struct {
+    int *graph;
+    size_t graph_len;
+    size_t graph_cap;
+    uint8_t demod[MAX_DEMOD_BUF_LEN];
+    size_t demod_len;
+    int32_t demod_start_idx;
+    int demod_clock;
+    signal_t sigprop;
+
+    // left by the last raw demod and decoder: error bits among the bits
+    // demodulated, the EM410x ID
+    uint32_t demod_errors;
+    size_t demod_bits;
+    uint64_t em410x_id;
+
+    // bumped by every writer of the graph buffer. What is derived from the
+    // samples remembers the generation it was computed from
+    uint32_t graph_gen;
+    uint32_t sigprop_gen;
+
+    // save_restoreGB / save_restoreDB, allocated on first save
+    int *saved_graph;
+    size_t saved_graph_len;
+    int saved_grid_offset;
+    uint8_t *saved_demod;
+    size_t saved_demod_len;
+    int32_t saved_demod_start_idx;
+    int saved_demod_clock;
+
+    // 8 bit copy of the samples for the clock detectors and demods, kept between calls
+    uint8_t *scratch;
+    size_t scratch_cap;
+    size_t scratch_used;
+
+    // edges of the samples for the clock detectors, see getGraphWaves. A
+    // context can borrow those of the context its samples came from instead
+    lf_waves_t waves;
+    uint32_t waves_gen;
+    const lf_waves_t *shared_waves;
+    uint32_t shared_waves_gen;
+
+    // FFT plan of the autocorrelation, kept while the transform size stays the same
+    fft_plan_t *fft_plan;
+} demod_ctx_t;
+
+extern demod_ctx_t g_demod_default;
+extern __thread demod_ctx_t *g_demod_ctx;
+
+static inline demod_ctx_t *demod_ctx(void) {
+    return (g_demod_ctx) ? g_demod_ctx : &g_demod_default;
+}
+
+// plot window, cursors and grid only follow the default context
+static inline bool demod_ctx_is_default(void) {
+    return (g_demod_ctx == NULL);
+}
+
+demod_ctx_t *demod_ctx_create(void);
+void demod_ctx_free(demod_ctx_t *ctx);
+void demod_ctx_reset(demod_ctx_t *ctx);
+
+// selects the context of the calling thread, NULL for the default one. Returns the previous one
+demod_ctx_t *demod_ctx_select(demod_ctx_t *ctx);
+
+// writers of the graph buffer call this once done, so nothing computed from the old samples is reused
+static inline void demod_ctx_touch(demod_ctx_t *ctx) {
+    ctx->graph_gen++;
+}
+
+// makes room for len samples in the graph buffer, contents are kept. Moving the
+// default graph buffer holds the graph lock
+bool demod_ctx_reserve(demod_ctx_t *ctx, size_t len);
+// buffer owned by the context, valid until the next call. At least
+// MAX(len, MAX_GRAPH_TRACE_LEN) bytes, zero past len
+uint8_t *demod_ctx_scratch(demod_ctx_t *ctx, size_t len);
+
+// plan for n point transforms, owned by the context. NULL when n is no valid size or out of memory
+const fft_plan_t *demod_ctx_fft_plan(demod_ctx_t *ctx, size_t n);
+
+// held by the plot window while it reads the default graph buffer
+void demod_graph_lock(void);
+void demod_graph_unlock(void);
+
+// replaces the samples and clears the demod state
+int demod_ctx_load(demod_ctx_t *ctx, const int *samples, size_t len);
+// copies samples and demod state, not the saved buffers
+int demod_ctx_copy(demod_ctx_t *dst, const demod_ctx_t *src);
+// dst reads the edges built for src while its samples stay the same. Read only,
+// src must outlive dst or its samples
+void demod_ctx_share_waves(demod_ctx_t *dst, const demod_ctx_t *src);
+
+#define GraphBuffer         (demod_ctx()->graph)
+#define GraphTraceLen       (demod_ctx()->graph_len)
+#define DemodBuffer         (demod_ctx()->demod)
+#define DemodBufferLen      (demod_ctx()->demod_len)
+#define g_DemodStartIdx     (demod_ctx()->demod_start_idx)
+#define g_DemodClock        (demod_ctx()->demod_clock)
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,523 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Compiled (binary) key dictionaries
+//-----------------------------------------------------------------------------
+#include "dictionary.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "pm3_cmd.h"
+#include "ui.h"
+#include "util.h"
+#include "crc32.h"
+#include "fileutils.h"
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t dictionary_crc(const uint8_t *data, size_t len) {
+    uint8_t crc[4] = {0};
+    crc32_ex(data, len, crc);
+    return get_le32(crc);
+}
+
+static time_t file_mtime(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return 0;
+    return st.st_mtime;
+}
+
+const char *dictionary_order_str(uint8_t order) {
+    switch (order) {
+        case DICT_ORDER_FILE:
+            return "file";
+        case DICT_ORDER_FREQUENCY:
+            return "frequency";
+        case DICT_ORDER_SORTED:
+            return "sorted";
+        default:
+            return "unknown";
+    }
+}
+
+static int dictionary_check(dictionary_t *dict, const char *path, bool verify) {
+
+    if (dict->maplen < sizeof(dictionary_hdr_t))
+        return PM3_EFILE;
+
+    const dictionary_hdr_t *hdr = (const dictionary_hdr_t *)dict->map;
+    if (memcmp(hdr->magic, DICTIONARY_MAGIC, sizeof(hdr->magic)) != 0)
+        return PM3_EFILE;
+
+    if (hdr->version != DICTIONARY_VERSION) {
+        PrintAndLogEx(WARNING, "unsupported compiled dictionary version %u " _YELLOW_("%s"), hdr->version, path);
+        return PM3_EFILE;
+    }
+
+    if (hdr->keylen == 0 || hdr->keylen > DICTIONARY_MAX_KEYLEN)
+        return PM3_EFILE;
+
+    dict->keylen = hdr->keylen;
+    dict->order = hdr->order;
+    dict->keycnt = get_le32(hdr->keycnt);
+    dict->crc = get_le32(hdr->crc);
+    dict->keys = (const uint8_t *)dict->map + sizeof(dictionary_hdr_t);
+
+    if ((uint64_t)dict->keycnt * dict->keylen != dict->maplen - sizeof(dictionary_hdr_t)) {
+        PrintAndLogEx(WARNING, "compiled dictionary size mismatch " _YELLOW_("%s"), path);
+        return PM3_EFILE;
+    }
+
+    if (verify && dictionary_crc(dict->keys, (size_t)dict->keycnt * dict->keylen) != dict->crc) {
+        PrintAndLogEx(WARNING, "compiled dictionary checksum mismatch " _YELLOW_("%s"), path);
+        return PM3_ESOFT;
+    }
+    return PM3_SUCCESS;
+}
+
+int dictionary_open(const char *path, dictionary_t *dict, bool verify) {
+
+    if (path == NULL || dict == NULL)
+        return PM3_EINVARG;
+
+    memset(dict, 0, sizeof(dictionary_t));
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return PM3_EFILE;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(dictionary_hdr_t)) {
+        close(fd);
+        return PM3_EFILE;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return PM3_EFILE;
+
+    dict->map = map;
+    dict->maplen = st.st_size;
+    dict->mapped = true;
+#else
+    // no mmap, one read of the whole file is still parse free
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return PM3_EFILE;
+
+    fseek(f, 0, SEEK_END);
+    long fsize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (fsize < (long)sizeof(dictionary_hdr_t)) {
+        fclose(f);
+        return PM3_EFILE;
+    }
+
+    dict->map = calloc(fsize, sizeof(uint8_t));
+    if (dict->map == NULL) {
+        fclose(f);
+        return PM3_EMALLOC;
+    }
+    dict->maplen = fread(dict->map, 1, fsize, f);
+    fclose(f);
+#endif
+
+    int res = dictionary_check(dict, path, verify);
+    if (res != PM3_SUCCESS)
+        dictionary_close(dict);
+
+    return res;
+}
+
+void dictionary_close(dictionary_t *dict) {
+    if (dict == NULL || dict->map == NULL)
+        return;
+
+#ifndef _WIN32
+    if (dict->mapped)
+        munmap(dict->map, dict->maplen);
+    else
+        free(dict->map);
+#else
+    free(dict->map);
+#endif
+    memset(dict, 0, sizeof(dictionary_t));
+}
+
+size_t dictionary_key_offset(const dictionary_t *dict, uint32_t idx) {
+    return sizeof(dictionary_hdr_t) + (size_t)idx * dict->keylen;
+}
+
+char *dictionary_compiled_name(const char *textpath) {
+    if (textpath == NULL)
+        return NULL;
+
+    size_t len = strlen(textpath);
+    char *name = calloc(len + strlen(DICTIONARY_COMPILED_SUFFIX) + 1, sizeof(char));
+    if (name == NULL)
+        return NULL;
+
+    strcpy(name, textpath);
+    if (str_endswith(name, DICTIONARY_COMPILED_SUFFIX))
+        return name;
+
+    if (str_endswith(name, ".dic"))
+        name[len - 4] = '\0';
+
+    strcat(name, DICTIONARY_COMPILED_SUFFIX);
+    return name;
+}
+
+static int dictionary_try_compiled(const char *cpath, time_t textmtime, uint8_t keylen, dictionary_t *dict) {
+    if (fileExists(cpath) == false)
+        return PM3_EFILE;
+
+    if (textmtime && file_mtime(cpath) < textmtime) {
+        PrintAndLogEx(DEBUG, "compiled dictionary is older than its source, ignoring " _YELLOW_("%s"), cpath);
+        return PM3_EFILE;
+    }
+
+    int res = dictionary_open(cpath, dict, false);
+    if (res != PM3_SUCCESS)
+        return res;
+
+    if (dict->keylen != keylen) {
+        PrintAndLogEx(DEBUG, "compiled dictionary key length %u, expected %u, ignoring " _YELLOW_("%s"), dict->keylen, keylen, cpath);
+        dictionary_close(dict);
+        return PM3_EFILE;
+    }
+    return PM3_SUCCESS;
+}
+
+int dictionary_open_compiled(const char *textpath, const char *preferredName, uint8_t keylen, dictionary_t *dict, char **foundpath) {
+
+    time_t textmtime = (textpath) ? file_mtime(textpath) : 0;
+    char *cpath = NULL;
+    int res = PM3_EFILE;
+
+    // companion next to the text dictionary
+    if (textpath) {
+        cpath = dictionary_compiled_name(textpath);
+        if (cpath == NULL)
+            return PM3_EMALLOC;
+
+        res = dictionary_try_compiled(cpath, textmtime, keylen, dict);
+        if (res != PM3_SUCCESS) {
+            free(cpath);
+            cpath = NULL;
+        }
+    }
+
+    // compiled dictionary anywhere in the search path, e.g. user dictionaries directory
+    if (res != PM3_SUCCESS && preferredName) {
+        char *cname = dictionary_compiled_name(preferredName);
+        if (cname == NULL)
+            return PM3_EMALLOC;
+
+        res = searchFile(&cpath, DICTIONARIES_SUBDIR, cname, DICTIONARY_COMPILED_SUFFIX, true);
+        free(cname);
+        if (res == PM3_SUCCESS) {
+            res = dictionary_try_compiled(cpath, textmtime, keylen, dict);
+            if (res != PM3_SUCCESS) {
+                free(cpath);
+                cpath = NULL;
+            }
+        }
+    }
+
+    if (res != PM3_SUCCESS)
+        return res;
+
+    PrintAndLogEx(DEBUG, "using compiled dictionary " _YELLOW_("%s"), cpath);
+    if (foundpath)
+        *foundpath = cpath;
+    else
+        free(cpath);
+
+    return PM3_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+// compiler
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint8_t key[DICTIONARY_MAX_KEYLEN];
+    uint32_t count;
+    uint32_t first;
+} dictionary_entry_t;
+
+typedef struct {
+    dictionary_entry_t *entries;
+    uint32_t cnt;
+    uint32_t cap;
+    uint32_t *slots;    // entry index + 1, 0 is empty
+    uint32_t slotmask;
+    uint8_t keylen;
+} dictionary_builder_t;
+
+static uint32_t dictionary_hash(const uint8_t *key, uint8_t keylen) {
+    // FNV-1a
+    uint32_t h = 0x811C9DC5;
+    for (uint8_t i = 0; i < keylen; i++) {
+        h ^= key[i];
+        h *= 0x01000193;
+    }
+    return h;
+}
+
+static int builder_init(dictionary_builder_t *b, uint8_t keylen) {
+    memset(b, 0, sizeof(dictionary_builder_t));
+    b->keylen = keylen;
+    b->cap = 1024;
+    b->entries = calloc(b->cap, sizeof(dictionary_entry_t));
+    b->slots = calloc(b->cap * 2, sizeof(uint32_t));
+    b->slotmask = (b->cap * 2) - 1;
+    if (b->entries == NULL || b->slots == NULL) {
+        free(b->entries);
+        free(b->slots);
+        return PM3_EMALLOC;
+    }
+    return PM3_SUCCESS;
+}
+
+static void builder_free(dictionary_builder_t *b) {
+    free(b->entries);
+    free(b->slots);
+    memset(b, 0, sizeof(dictionary_builder_t));
+}
+
+static int builder_grow(dictionary_builder_t *b) {
+
+    uint32_t newcap = b->cap * 2;
+    dictionary_entry_t *entries = realloc(b->entries, (size_t)newcap * sizeof(dictionary_entry_t));
+    if (entries == NULL)
+        return PM3_EMALLOC;
+    b->entries = entries;
+
+    uint32_t *slots = calloc((size_t)newcap * 2, sizeof(uint32_t));
+    if (slots == NULL)
+        return PM3_EMALLOC;
+
+    free(b->slots);
+    b->slots = slots;
+    b->slotmask = (newcap * 2) - 1;
+    b->cap = newcap;
+
+    // rehash
+    for (uint32_t i = 0; i < b->cnt; i++) {
+        uint32_t s = dictionary_hash(b->entries[i].key, b->keylen) & b->slotmask;
+        while (b->slots[s])
+            s = (s + 1) & b->slotmask;
+        b->slots[s] = i + 1;
+    }
+    return PM3_SUCCESS;
+}
+
+static int builder_add(dictionary_builder_t *b, const uint8_t *key) {
+
+    uint32_t s = dictionary_hash(key, b->keylen) & b->slotmask;
+    while (b->slots[s]) {
+        dictionary_entry_t *e = &b->entries[b->slots[s] - 1];
+        if (memcmp(e->key, key, b->keylen) == 0) {
+            e->count++;
+            return PM3_SUCCESS;
+        }
+        s = (s + 1) & b->slotmask;
+    }
+
+    if (b->cnt == b->cap) {
+        int res = builder_grow(b);
+        if (res != PM3_SUCCESS)
+            return res;
+        // slot positions changed
+        return builder_add(b, key);
+    }
+
+    dictionary_entry_t *e = &b->entries[b->cnt];
+    memset(e->key, 0, sizeof(e->key));
+    memcpy(e->key, key, b->keylen);
+    e->count = 1;
+    e->first = b->cnt;
+    b->cnt++;
+    b->slots[s] = b->cnt;
+    return PM3_SUCCESS;
+}
+
+static int entry_cmp_frequency(const void *a, const void *b) {
+    const dictionary_entry_t *ea = (const dictionary_entry_t *)a;
+    const dictionary_entry_t *eb = (const dictionary_entry_t *)b;
+    if (ea->count != eb->count)
+        return (ea->count > eb->count) ? -1 : 1;
+    return (ea->first > eb->first) - (ea->first < eb->first);
+}
+
+static int entry_cmp_key(const void *a, const void *b) {
+    // keys are zero padded to DICTIONARY_MAX_KEYLEN
+    return memcmp(((const dictionary_entry_t *)a)->key, ((const dictionary_entry_t *)b)->key, DICTIONARY_MAX_KEYLEN);
+}
+
+static int builder_add_text(dictionary_builder_t *b, FILE *f, uint32_t *added) {
+
+    // same line rules as loadFileDICTIONARYEx
+    uint8_t hexlen = b->keylen << 1;
+    uint8_t key[DICTIONARY_MAX_KEYLEN];
+    char line[255];
+
+    while (fgets(line, sizeof(line), f)) {
+
+        line[hexlen] = 0;
+
+        if (strlen(line) < hexlen)
+            continue;
+
+        if (line[0] == '#')
+            continue;
+
+        if (!CheckStringIsHEXValue(line))
+            continue;
+
+        if (hex_to_bytes(line, key, b->keylen) != b->keylen)
+            continue;
+
+        int res = builder_add(b, key);
+        if (res != PM3_SUCCESS)
+            return res;
+
+        (*added)++;
+    }
+    return PM3_SUCCESS;
+}
+
+static int builder_add_file(dictionary_builder_t *b, const char *path, bool verbose) {
+
+    uint32_t added = 0;
+    int res;
+
+    dictionary_t dict;
+    if (dictionary_open(path, &dict, true) == PM3_SUCCESS) {
+        if (dict.keylen != b->keylen) {
+            PrintAndLogEx(WARNING, "key length %u does not match %u, skipping " _YELLOW_("%s"), dict.keylen, b->keylen, path);
+            dictionary_close(&dict);
+            return PM3_EINVARG;
+        }
+        for (uint32_t i = 0; i < dict.keycnt; i++) {
+            res = builder_add(b, dict.keys + (size_t)i * dict.keylen);
+            if (res != PM3_SUCCESS) {
+                dictionary_close(&dict);
+                return res;
+            }
+            added++;
+        }
+        dictionary_close(&dict);
+    } else {
+        FILE *f = fopen(path, "r");
+        if (f == NULL) {
+            PrintAndLogEx(WARNING, "file not found or locked. '" _YELLOW_("%s")"'", path);
+            return PM3_EFILE;
+        }
+        res = builder_add_text(b, f, &added);
+        fclose(f);
+        if (res != PM3_SUCCESS)
+            return res;
+    }
+
+    if (verbose)
+        PrintAndLogEx(INFO, "read " _YELLOW_("%u") " keys from " _YELLOW_("%s"), added, path);
+
+    return PM3_SUCCESS;
+}
+
+int dictionary_compile(const char **infiles, size_t infilecnt, const char *outfile, uint8_t keylen, dictionary_order_t order, bool verbose) {
+
+    if (infiles == NULL || infilecnt == 0 || outfile == NULL)
+        return PM3_EINVARG;
+
+    if (keylen == 0 || keylen > DICTIONARY_MAX_KEYLEN)
+        return PM3_EINVARG;
+
+    dictionary_builder_t b;
+    int res = builder_init(&b, keylen);
+    if (res != PM3_SUCCESS)
+        return res;
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < infilecnt; i++) {
+        res = builder_add_file(&b, infiles[i], verbose);
+        if (res != PM3_SUCCESS)
+            goto out;
+    }
+
+    for (uint32_t i = 0; i < b.cnt; i++)
+        total += b.entries[i].count;
+
+    if (order == DICT_ORDER_FREQUENCY)
+        qsort(b.entries, b.cnt, sizeof(dictionary_entry_t), entry_cmp_frequency);
+    else if (order == DICT_ORDER_SORTED)
+        qsort(b.entries, b.cnt, sizeof(dictionary_entry_t), entry_cmp_key);
+
+    size_t keyarealen = (size_t)b.cnt * keylen;
+    uint8_t *keyarea = calloc(keyarealen + 1, sizeof(uint8_t));
+    if (keyarea == NULL) {
+        res = PM3_EMALLOC;
+        goto out;
+    }
+
+    for (uint32_t i = 0; i < b.cnt; i++)
+        memcpy(keyarea + (size_t)i * keylen, b.entries[i].key, keylen);
+
+    dictionary_hdr_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DICTIONARY_MAGIC, sizeof(hdr.magic));
+    hdr.version = DICTIONARY_VERSION;
+    hdr.keylen = keylen;
+    hdr.order = order;
+    put_le32(hdr.keycnt, b.cnt);
+    put_le32(hdr.crc, dictionary_crc(keyarea, keyarealen));
+
+    FILE *f = fopen(outfile, "wb");
+    if (f == NULL) {
+        PrintAndLogEx(WARNING, "could not create file " _YELLOW_("%s"), outfile);
+        free(keyarea);
+        res = PM3_EFILE;
+        goto out;
+    }
+
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1 || fwrite(keyarea, 1, keyarealen, f) != keyarealen) {
+        PrintAndLogEx(WARNING, "could not write file " _YELLOW_("%s"), outfile);
+        res = PM3_EFILE;
+    }
+    fclose(f);
+    free(keyarea);
+
+    if (res == PM3_SUCCESS) {
+        PrintAndLogEx(SUCCESS, "saved " _GREEN_("%u") " unique keys (" _YELLOW_("%" PRIu64) " duplicates removed, %s order) to " _YELLOW_("%s"),
+                      b.cnt, total - b.cnt, dictionary_order_str(order), outfile);
+    }
+
+out:
+    builder_free(&b);
+    return res;
+}
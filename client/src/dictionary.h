@@ -0,0 +1,78 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Compiled (binary) key dictionaries
+//
+// A compiled dictionary is a deduplicated list of fixed width keys preceded
+// by a small header. It is memory mapped and used as is, no text parsing.
+//
+//  offset  size  field
+//  0       4     magic "PM3D"
+//  4       1     format version
+//  5       1     key length in bytes
+//  6       1     key order (dictionary_order_t)
+//  7       1     RFU
+//  8       4     number of keys (LE)
+//  12      4     CRC32 over the key area (LE)
+//  16      n     keys, key length bytes each
+//-----------------------------------------------------------------------------
+
+#ifndef DICTIONARY_H__
+#define DICTIONARY_H__
+
+#include "common.h"
+
+#define DICTIONARY_COMPILED_SUFFIX  ".dicb"
+#define DICTIONARY_MAGIC            "PM3D"
+#define DICTIONARY_VERSION          1
+#define DICTIONARY_MAX_KEYLEN       24
+
+typedef enum {
+    DICT_ORDER_FILE = 0,    // first occurrence order of the source files
+    DICT_ORDER_FREQUENCY,   // most frequent keys first, ties in file order
+    DICT_ORDER_SORTED,      // ascending key value, allows binary search
+} dictionary_order_t;
+
+typedef struct {
+    uint8_t magic[4];
+    uint8_t version;
+    uint8_t keylen;
+    uint8_t order;
+    uint8_t rfu;
+    uint8_t keycnt[4];
+    uint8_t crc[4];
+} PACKED dictionary_hdr_t;
+
+typedef struct {
+    const uint8_t *keys;    // points into the mapping, keycnt * keylen bytes
+    uint32_t keycnt;
+    uint8_t keylen;
+    uint8_t order;
+    uint32_t crc;
+    void *map;
+    size_t maplen;
+    bool mapped;            // true if map comes from mmap, false if malloc'd
+} dictionary_t;
+
+// map a compiled dictionary. Header and size are validated, CRC only if verify is set
+int dictionary_open(const char *path, dictionary_t *dict, bool verify);
+void dictionary_close(dictionary_t *dict);
+
+// byte offset of key index in the compiled file, used as file position by the loaders
+size_t dictionary_key_offset(const dictionary_t *dict, uint32_t idx);
+
+// returns malloc'd name of the compiled companion of a text dictionary
+char *dictionary_compiled_name(const char *textpath);
+
+// opens the compiled companion of textpath if it exists, is not older than textpath
+// and has the requested key length. foundpath (may be NULL) receives the malloc'd path used
+int dictionary_open_compiled(const char *textpath, const char *preferredName, uint8_t keylen, dictionary_t *dict, char **foundpath);
+
+// compile / merge text or compiled dictionaries into one compiled dictionary
+int dictionary_compile(const char **infiles, size_t infilecnt, const char *outfile, uint8_t keylen, dictionary_order_t order, bool verbose);
+
+const char *dictionary_order_str(uint8_t order);
+
+#endif
@@ -27,6 +27,8 @@
 #include "ui.h"
 #include "emv_tags.h"
 #include "fileutils.h"
+#include "util.h"           // num_CPUs
+#include "util_posix.h"     // msclock
 
 static int CmdHelp(const char *Cmd);
 
@@ -1802,6 +1804,87 @@ static int CmdEMVTest(const char *Cmd) {
     return ExecuteCryptoTests(true, ignoreTimeTest, runSlowTests);
 }
 
+// one modulus in hex per line, # starts a comment
+static int emv_roca_file(const char *filename, int threads) {
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        PrintAndLogEx(ERR, "Error: Could not open file ["_YELLOW_("%s")"]", filename);
+        return PM3_EFILE;
+    }
+
+    unsigned char **moduli = NULL;
+    size_t *lens = NULL;
+    size_t *lines = NULL;
+    size_t count = 0, cap = 0, lineno = 0;
+    int res = PM3_SUCCESS;
+
+    char line[2048];
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        line[strcspn(line, "#\r\n")] = '\0';
+
+        uint8_t buf[1024];
+        int len = 0;
+        if (param_gethex_to_eol(line, 0, buf, sizeof(buf), &len) || len == 0) {
+            if (strspn(line, " \t") != strlen(line))
+                PrintAndLogEx(WARNING, "line %zu is not a hex modulus, skipped", lineno);
+            continue;
+        }
+
+        if (count == cap) {
+            cap = cap ? cap * 2 : 256;
+            unsigned char **m = realloc(moduli, cap * sizeof(unsigned char *));
+            if (m)
+                moduli = m;
+            size_t *l = realloc(lens, cap * sizeof(size_t));
+            if (l)
+                lens = l;
+            size_t *n = realloc(lines, cap * sizeof(size_t));
+            if (n)
+                lines = n;
+            if (m == NULL || l == NULL || n == NULL) {
+                res = PM3_EMALLOC;
+                break;
+            }
+        }
+
+        moduli[count] = malloc(len);
+        if (moduli[count] == NULL) {
+            res = PM3_EMALLOC;
+            break;
+        }
+        memcpy(moduli[count], buf, len);
+        lens[count] = len;
+        lines[count] = lineno;
+        count++;
+    }
+    fclose(f);
+
+    bool *found = calloc(MAX(count, 1), sizeof(bool));
+    if (found == NULL)
+        res = PM3_EMALLOC;
+
+    if (res == PM3_SUCCESS) {
+        uint64_t t1 = msclock();
+        size_t n = emv_rocacheck_batch((const unsigned char **)moduli, lens, count, threads, found);
+        t1 = msclock() - t1;
+
+        for (size_t i = 0; i < count; i++) {
+            if (found[i])
+                PrintAndLogEx(SUCCESS, "line %4zu  %4zu bits  " _RED_("ROCA fingerprint found"), lines[i], lens[i] * 8);
+        }
+        PrintAndLogEx(SUCCESS, "checked " _YELLOW_("%zu") " moduli, " _YELLOW_("%zu") " with ROCA fingerprint  ( %" PRIu64 " ms, %d threads )", count, n, t1, threads);
+    }
+
+    for (size_t i = 0; i < count; i++)
+        free(moduli[i]);
+    free(moduli);
+    free(lens);
+    free(lines);
+    free(found);
+    return res;
+}
+
 static int CmdEMVRoca(const char *Cmd) {
     uint8_t AID[APDU_AID_LEN] = {0};
     size_t AIDlen = 0;
@@ -1818,6 +1901,7 @@ static int CmdEMVRoca(const char *Cmd) {
                   "Usage:\n"
                   "\temv roca -w -> select --CONTACT-- card and run test\n"
                   "\temv roca -> select --CONTACTLESS-- card and run test\n"
+                  "\temv roca -f moduli.txt -> test the hex moduli of a file, one per line, on all CPUs\n"
                  );
 
     void *argtable[] = {
@@ -1825,6 +1909,8 @@ static int CmdEMVRoca(const char *Cmd) {
         arg_lit0("tT",  "selftest",   "self test"),
         arg_lit0("aA",  "apdu",    "show APDU reqests and responses"),
         arg_lit0("wW",  "wired",   "Send data via contact (iso7816) interface. Contactless interface set by default"),
+        arg_str0("fF",  "file",    "<filename>", "test the moduli in this file offline"),
+        arg_int0("pP",  "threads", "<dec>", "number of threads for -f (def: number of CPUs)"),
         arg_param_end
     };
     CLIExecWithReturn(ctx, Cmd, argtable, true);
@@ -1834,6 +1920,22 @@ static int CmdEMVRoca(const char *Cmd) {
         return roca_self_test();
     }
 
+    char filename[FILE_PATH_SIZE] = {0};
+    int fnlen = 0;
+    CLIParamStrToBuf(arg_get_str(ctx, 4), (uint8_t *)filename, FILE_PATH_SIZE, &fnlen);
+    if (fnlen) {
+        int threads = arg_get_int_def(ctx, 5, num_CPUs());
+        CLIParserFree(ctx);
+        return emv_roca_file(filename, threads);
+    }
+
+    // only the self test and files work offline
+    if (!IfPm3Iso14443()) {
+        CLIParserFree(ctx);
+        PrintAndLogEx(WARNING, "PM3 is offline or has no ISO14443 support, only " _YELLOW_("-t") " and " _YELLOW_("-f") " work");
+        return PM3_EDEVNOTSUPP;
+    }
+
     bool show_apdu = arg_get_lit(ctx, 2);
 
     EMVCommandChannel channel = ECC_CONTACTLESS;
@@ -2094,7 +2196,7 @@ static command_t CommandTable[] =  {
     {"clone",       CmdEmvClone,                    IfPm3Iso14443,   "clone an EMV tag"},
     */
     {"list",        CmdEMVList,                     AlwaysAvailable,   "List ISO7816 history"},
-    {"roca",        CmdEMVRoca,                     IfPm3Iso14443,   "Extract public keys and run ROCA test"},
+    {"roca",        CmdEMVRoca,                     AlwaysAvailable, "Extract public keys and run ROCA test"},
     {NULL, NULL, NULL, NULL}
 };
 
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "ui.h"
 #include "crypto.h"
@@ -399,40 +400,110 @@ void emv_pk_free(struct emv_pk *pk) {
     free(pk);
 }
 
-static struct emv_pk *emv_pk_get_ca_pk_from_file(const char *fname,
-                                                 const unsigned char *rid,
-                                                 unsigned char idx) {
-    if (!fname)
-        return NULL;
+// The CA keys of capk.txt are parsed and their hashes checked once, then kept
+// sorted by RID and index. The RSA context of a key is opened when it is first
+// used and stays open, with its Montgomery constant already computed
+typedef struct {
+    struct emv_pk *pk;
+    size_t line;                // the first of two same keys in the file wins
+    bool verified;
+    struct crypto_pk *kcp;
+} emv_ca_key_t;
+
+static pthread_mutex_t emv_ca_lock = PTHREAD_MUTEX_INITIALIZER;
+static emv_ca_key_t *emv_ca_keys = NULL;
+static size_t emv_ca_count = 0;
+static bool emv_ca_loaded = false;     // also when capk.txt is missing or empty, it's not read again
+
+static int emv_ca_key_cmp(const void *a, const void *b) {
+    const emv_ca_key_t *x = a, *y = b;
+    int res = memcmp(x->pk->rid, y->pk->rid, sizeof(x->pk->rid));
+    if (res)
+        return res;
+    if (x->pk->index != y->pk->index)
+        return x->pk->index - y->pk->index;
+    return (x->line > y->line) - (x->line < y->line);
+}
 
+static bool emv_ca_load_file(const char *fname) {
     FILE *f = fopen(fname, "r");
     if (!f) {
         PrintAndLogEx(ERR, "Error: can't open file %s.", fname);
-        return NULL;
+        return false;
     }
 
+    size_t cap = 0, line = 0;
     while (!feof(f)) {
         char buf[2048];
         if (fgets(buf, sizeof(buf), f) == NULL)
             break;
+        line++;
 
         struct emv_pk *pk = emv_pk_parse_pk(buf, sizeof(buf));
         if (!pk)
             continue;
 
-        if (memcmp(pk->rid, rid, 5) || pk->index != idx) {
-            emv_pk_free(pk);
-            continue;
+        if (emv_ca_count == cap) {
+            cap = cap ? cap * 2 : 64;
+            emv_ca_key_t *tmp = realloc(emv_ca_keys, cap * sizeof(emv_ca_key_t));
+            if (tmp == NULL) {
+                emv_pk_free(pk);
+                break;
+            }
+            emv_ca_keys = tmp;
         }
 
-        fclose(f);
-        return pk;
+        emv_ca_key_t *key = &emv_ca_keys[emv_ca_count++];
+        key->pk = pk;
+        key->line = line;
+        key->verified = emv_pk_verify(pk);
+        key->kcp = NULL;
     }
-
     fclose(f);
+
+    qsort(emv_ca_keys, emv_ca_count, sizeof(emv_ca_key_t), emv_ca_key_cmp);
+    return true;
+}
+
+// call with emv_ca_lock held
+static emv_ca_key_t *emv_ca_find(const unsigned char *rid, unsigned char idx) {
+    if (emv_ca_loaded == false) {
+        emv_ca_loaded = true;
+        char *path;
+        if (searchFile(&path, RESOURCES_SUBDIR, "capk", ".txt", false) != PM3_SUCCESS)
+            return NULL;
+        emv_ca_load_file(path);
+        free(path);
+    }
+
+    size_t lo = 0, hi = emv_ca_count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const struct emv_pk *pk = emv_ca_keys[mid].pk;
+        int res = memcmp(pk->rid, rid, sizeof(pk->rid));
+        if (res < 0 || (res == 0 && pk->index < idx))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < emv_ca_count && memcmp(emv_ca_keys[lo].pk->rid, rid, 5) == 0 && emv_ca_keys[lo].pk->index == idx)
+        return &emv_ca_keys[lo];
     return NULL;
 }
 
+static struct emv_pk *emv_pk_copy(const struct emv_pk *src) {
+    struct emv_pk *pk = emv_pk_new(src->mlen, src->elen);
+    if (!pk)
+        return NULL;
+
+    unsigned char *modulus = pk->modulus;
+    *pk = *src;
+    pk->modulus = modulus;
+    memcpy(pk->modulus, src->modulus, src->mlen);
+    return pk;
+}
+
 char *emv_pk_get_ca_pk_file(const char *dirname, const unsigned char *rid, unsigned char idx) {
     if (!dirname)
         dirname = ".";//openemv_config_get_str("capk.dir", NULL);
@@ -473,36 +544,19 @@ char *emv_pk_get_ca_pk_rid_file(const char *dirname, const unsigned char *rid) {
 }
 
 struct emv_pk *emv_pk_get_ca_pk(const unsigned char *rid, unsigned char idx) {
+    pthread_mutex_lock(&emv_ca_lock);
+    emv_ca_key_t *key = emv_ca_find(rid, idx);
     struct emv_pk *pk = NULL;
-
-    /*  if (!pk) {
-            char *fname = emv_pk_get_ca_pk_file(NULL, rid, idx);
-            if (fname) {
-                pk = emv_pk_get_ca_pk_from_file(fname, rid, idx);
-                free(fname);
-            }
-        }
-
-        if (!pk) {
-            char *fname = emv_pk_get_ca_pk_rid_file(NULL, rid);
-            if (fname) {
-                pk = emv_pk_get_ca_pk_from_file(fname, rid, idx);
-                free(fname);
-            }
-        }
-    */
-    char *path;
-    if (searchFile(&path, RESOURCES_SUBDIR, "capk", ".txt", false) != PM3_SUCCESS) {
-        return NULL;
+    bool isok = false;
+    if (key) {
+        isok = key->verified;
+        pk = emv_pk_copy(key->pk);
     }
-    pk = emv_pk_get_ca_pk_from_file(path, rid, idx);
-    free(path);
+    pthread_mutex_unlock(&emv_ca_lock);
 
     if (!pk)
         return NULL;
 
-    bool isok = emv_pk_verify(pk);
-
     PrintAndLogEx(INFO, "Verifying CA PK for %02hhx:%02hhx:%02hhx:%02hhx:%02hhx IDX %02hhx %zu bits.  ( %s )",
                   pk->rid[0],
                   pk->rid[1],
@@ -521,3 +575,37 @@ struct emv_pk *emv_pk_get_ca_pk(const unsigned char *rid, unsigned char idx) {
     emv_pk_free(pk);
     return NULL;
 }
+
+struct crypto_pk *emv_pk_get_ca_crypto(const struct emv_pk *pk) {
+    if (!pk)
+        return NULL;
+
+    pthread_mutex_lock(&emv_ca_lock);
+    emv_ca_key_t *key = emv_ca_find(pk->rid, pk->index);
+
+    // issuer keys carry the RID and index of their CA, only the CA key itself is here
+    if (key == NULL || key->verified == false
+            || key->pk->mlen != pk->mlen || memcmp(key->pk->modulus, pk->modulus, pk->mlen)
+            || key->pk->elen != pk->elen || memcmp(key->pk->exp, pk->exp, pk->elen)) {
+        pthread_mutex_unlock(&emv_ca_lock);
+        return NULL;
+    }
+
+    if (key->kcp == NULL) {
+        key->kcp = crypto_pk_open(key->pk->pk_algo,
+                                  key->pk->modulus, key->pk->mlen,
+                                  key->pk->exp, key->pk->elen);
+
+        // the first operation computes R^2 mod N, later ones only read it
+        if (key->kcp) {
+            unsigned char one[key->pk->mlen];
+            memset(one, 0, sizeof(one));
+            one[sizeof(one) - 1] = 1;
+            size_t len = 0;
+            free(crypto_pk_encrypt(key->kcp, one, sizeof(one), &len));
+        }
+    }
+    struct crypto_pk *kcp = key->kcp;
+    pthread_mutex_unlock(&emv_ca_lock);
+    return kcp;
+}
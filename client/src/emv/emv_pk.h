@@ -43,5 +43,8 @@ bool emv_pk_verify(const struct emv_pk *pk);
 
 char *emv_pk_get_ca_pk_file(const char *dirname, const unsigned char *rid, unsigned char idx);
 char *emv_pk_get_ca_pk_rid_file(const char *dirname, const unsigned char *rid);
+// a copy of the CA key from capk.txt, the file is read once
 struct emv_pk *emv_pk_get_ca_pk(const unsigned char *rid, unsigned char idx);
+// the open RSA context of a CA key from capk.txt, owned by the key store. NULL for other keys
+struct crypto_pk *emv_pk_get_ca_crypto(const struct emv_pk *pk);
 #endif
@@ -62,14 +62,22 @@ static unsigned char *emv_pki_decode_message(const struct emv_pk *enc_pk,
         PrintAndLogEx(WARNING, "ERROR: Certificate length (%zu) not equal key length (%zu)", cert_tlv->len, enc_pk->mlen);
         return NULL;
     }
-    kcp = crypto_pk_open(enc_pk->pk_algo,
-                         enc_pk->modulus, enc_pk->mlen,
-                         enc_pk->exp, enc_pk->elen);
+
+    // CA keys come open from the key store, other keys are opened for this message
+    bool opened = false;
+    kcp = emv_pk_get_ca_crypto(enc_pk);
+    if (!kcp) {
+        kcp = crypto_pk_open(enc_pk->pk_algo,
+                             enc_pk->modulus, enc_pk->mlen,
+                             enc_pk->exp, enc_pk->elen);
+        opened = true;
+    }
     if (!kcp)
         return NULL;
 
     data = crypto_pk_encrypt(kcp, cert_tlv->value, cert_tlv->len, &data_len);
-    crypto_pk_close(kcp);
+    if (opened)
+        crypto_pk_close(kcp);
 
     /*  if (true){
             PrintAndLogEx(SUCCESS, "Recovered data:\n");
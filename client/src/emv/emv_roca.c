@@ -23,124 +23,178 @@
 
 #include "emv_roca.h"
 
+#include <pthread.h>
+
 #include "ui.h"  // Print...
 #include "bignum.h"
 
-static void rocacheck_init(mbedtls_mpi *prints) {
-
-    for (int i = 0; i < ROCA_PRINTS_LENGTH; i++)
-        mbedtls_mpi_init(&prints[i]);
-
-    mbedtls_mpi_read_string(&prints[0], 10, "1026");
-    mbedtls_mpi_read_string(&prints[1], 10, "5658");
-    mbedtls_mpi_read_string(&prints[2], 10, "107286");
-    mbedtls_mpi_read_string(&prints[3], 10, "199410");
-    mbedtls_mpi_read_string(&prints[4], 10, "67109890");
-    mbedtls_mpi_read_string(&prints[5], 10, "5310023542746834");
-    mbedtls_mpi_read_string(&prints[6], 10, "1455791217086302986");
-    mbedtls_mpi_read_string(&prints[7], 10, "20052041432995567486");
-    mbedtls_mpi_read_string(&prints[8], 10, "6041388139249378920330");
-    mbedtls_mpi_read_string(&prints[9], 10, "207530445072488465666");
-    mbedtls_mpi_read_string(&prints[10], 10, "79228162521181866724264247298");
-    mbedtls_mpi_read_string(&prints[11], 10, "1760368345969468176824550810518");
-    mbedtls_mpi_read_string(&prints[12], 10, "50079290986288516948354744811034");
-    mbedtls_mpi_read_string(&prints[13], 10, "473022961816146413042658758988474");
-    mbedtls_mpi_read_string(&prints[14], 10, "144390480366845522447407333004847678774");
-    mbedtls_mpi_read_string(&prints[15], 10, "1800793591454480341970779146165214289059119882");
-    mbedtls_mpi_read_string(&prints[16], 10, "126304807362733370595828809000324029340048915994");
-}
+static const uint8_t roca_primes[ROCA_PRINTS_LENGTH] = {
+    11, 13, 17, 19, 37, 53, 61, 71, 73, 79, 97, 103, 107, 109, 127, 151, 157
+};
+
+static const char *roca_prints_dec[ROCA_PRINTS_LENGTH] = {
+    "1026",
+    "5658",
+    "107286",
+    "199410",
+    "67109890",
+    "5310023542746834",
+    "1455791217086302986",
+    "20052041432995567486",
+    "6041388139249378920330",
+    "207530445072488465666",
+    "79228162521181866724264247298",
+    "1760368345969468176824550810518",
+    "50079290986288516948354744811034",
+    "473022961816146413042658758988474",
+    "144390480366845522447407333004847678774",
+    "1800793591454480341970779146165214289059119882",
+    "126304807362733370595828809000324029340048915994",
+};
+
+// bit r of roca_prints[i] is set when a ROCA key can be r modulo roca_primes[i]
+static uint64_t roca_prints[ROCA_PRINTS_LENGTH][3];
+
+// products of consecutive primes that fit in 32 bits, the modulus is reduced
+// once per product and the residues of its primes are taken from that
+typedef struct {
+    uint32_t product;
+    uint8_t first;
+    uint8_t count;
+} roca_group_t;
+
+static roca_group_t roca_groups[ROCA_PRINTS_LENGTH];
+static int roca_ngroups = 0;
+static pthread_once_t roca_once = PTHREAD_ONCE_INIT;
+
+static void rocacheck_init(void) {
 
-static void rocacheck_cleanup(mbedtls_mpi *prints) {
-    for (int i = 0; i < ROCA_PRINTS_LENGTH; i++)
-        mbedtls_mpi_free(&prints[i]);
-}
+    for (int i = 0; i < ROCA_PRINTS_LENGTH; i++) {
+        mbedtls_mpi print;
+        mbedtls_mpi_init(&print);
+        mbedtls_mpi_read_string(&print, 10, roca_prints_dec[i]);
 
-static int bitand_is_zero(mbedtls_mpi *a, mbedtls_mpi *b) {
+        for (int b = 0; b < roca_primes[i]; b++) {
+            if (mbedtls_mpi_get_bit(&print, b))
+                roca_prints[i][b / 64] |= 1ULL << (b % 64);
+        }
+        mbedtls_mpi_free(&print);
+    }
 
-    for (int i = 0; i < mbedtls_mpi_bitlen(a); i++) {
+    for (int i = 0; i < ROCA_PRINTS_LENGTH; i++) {
+        roca_group_t *g = &roca_groups[roca_ngroups];
+        if (g->count && (uint64_t)g->product * roca_primes[i] <= UINT32_MAX) {
+            g->product *= roca_primes[i];
+            g->count++;
+            continue;
+        }
 
-        if (mbedtls_mpi_get_bit(a, i) && mbedtls_mpi_get_bit(b, i))
-            return 0;
+        if (g->count)
+            g = &roca_groups[++roca_ngroups];
+        g->product = roca_primes[i];
+        g->first = i;
+        g->count = 1;
     }
-    return 1;
+    roca_ngroups++;
 }
 
+// big endian buf modulo m, a 32 bit word at a time
+static uint32_t roca_mod(const unsigned char *buf, size_t buflen, uint32_t m) {
+    uint64_t r = 0;
+    size_t i = 0;
 
-static mbedtls_mpi_uint mpi_get_uint(const mbedtls_mpi *X) {
+    for (; i < buflen % 4; i++)
+        r = ((r << 8) | buf[i]) % m;
 
-    if (X->n == 1 && X->s > 0) {
-        return X->p[0];
+    for (; i < buflen; i += 4) {
+        uint32_t w = (uint32_t)buf[i] << 24 | (uint32_t)buf[i + 1] << 16 | (uint32_t)buf[i + 2] << 8 | buf[i + 3];
+        r = ((r << 32) | w) % m;
     }
 
-    PrintAndLogEx(WARNING, "ZERRRRO!!!\n");
-    return 0;
+    return r;
 }
 
-/*
-static void print_mpi(const char *msg, int radix, const mbedtls_mpi *X) {
-
-    char Xchar[400] = {0};
-    size_t len = 0;
-
-    mbedtls_mpi_write_string(X, radix, Xchar, sizeof(Xchar), &len);
-    PrintAndLogEx(INFO, "%s[%zu] %s\n", msg, len, Xchar);
-}
-*/
 bool emv_rocacheck(const unsigned char *buf, size_t buflen, bool verbose) {
 
-    mbedtls_mpi t_modulus;
-    mbedtls_mpi_init(&t_modulus);
-
-    bool ret = false;
-    mbedtls_mpi prints[ROCA_PRINTS_LENGTH];
-    uint8_t primes[ROCA_PRINTS_LENGTH] = {
-        11, 13, 17, 19, 37, 53, 61, 71, 73, 79, 97, 103, 107, 109, 127, 151, 157
-    };
-
-    rocacheck_init(prints);
-
-    MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(&t_modulus, buf, buflen));
+    pthread_once(&roca_once, rocacheck_init);
 
-    for (int i = 0; i < ROCA_PRINTS_LENGTH; i++) {
-
-        mbedtls_mpi t_temp;
-        mbedtls_mpi t_prime;
-        mbedtls_mpi g_one;
+    for (int g = 0; g < roca_ngroups; g++) {
+        uint32_t r = roca_mod(buf, buflen, roca_groups[g].product);
 
-        mbedtls_mpi_init(&t_temp);
-        mbedtls_mpi_init(&t_prime);
-        mbedtls_mpi_init(&g_one);
+        for (int i = roca_groups[g].first; i < roca_groups[g].first + roca_groups[g].count; i++) {
+            uint8_t res = r % roca_primes[i];
+            if ((roca_prints[i][res / 64] >> (res % 64) & 1) == 0) {
+                if (verbose) {
+                    PrintAndLogEx(FAILED, "No fingerprint found.\n");
+                }
+                return false;
+            }
+        }
+    }
 
-        MBEDTLS_MPI_CHK(mbedtls_mpi_read_string(&g_one, 10, "1"));
+    if (verbose)
+        PrintAndLogEx(SUCCESS, "Fingerprint found!\n");
 
-        MBEDTLS_MPI_CHK(mbedtls_mpi_add_int(&t_prime, &t_prime, primes[i]));
+    return true;
+}
 
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&t_temp, &t_modulus, &t_prime));
+typedef struct {
+    const unsigned char **moduli;
+    const size_t *lens;
+    size_t count;
+    bool *found;
+    size_t next;
+    pthread_mutex_t lock;
+} roca_batch_t;
+
+static void *roca_batch_worker(void *arg) {
+    roca_batch_t *batch = (roca_batch_t *)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&batch->lock);
+        size_t i = batch->next;
+        batch->next += 64;
+        pthread_mutex_unlock(&batch->lock);
+        if (i >= batch->count)
+            break;
+
+        size_t end = MIN(i + 64, batch->count);
+        for (; i < end; i++)
+            batch->found[i] = emv_rocacheck(batch->moduli[i], batch->lens[i], false);
+    }
+    return NULL;
+}
 
-        MBEDTLS_MPI_CHK(mbedtls_mpi_shift_l(&g_one, mpi_get_uint(&t_temp)));
+size_t emv_rocacheck_batch(const unsigned char **moduli, const size_t *lens, size_t count, int threads, bool *found) {
 
-        mbedtls_mpi_free(&t_temp);
-        mbedtls_mpi_free(&t_prime);
+    pthread_once(&roca_once, rocacheck_init);
 
-        if (bitand_is_zero(&g_one, &prints[i])) {
-            if (verbose) {
-                PrintAndLogEx(FAILED, "No fingerprint found.\n");
-            }
-            mbedtls_mpi_free(&g_one);
-            goto cleanup;
-        }
-        mbedtls_mpi_free(&g_one);
+    roca_batch_t batch = {
+        .moduli = moduli,
+        .lens = lens,
+        .count = count,
+        .found = found,
+    };
+    pthread_mutex_init(&batch.lock, NULL);
+
+    threads = MAX(1, MIN(threads, 64));
+    pthread_t tids[64];
+    int started = 0;
+    // the calling thread works too
+    for (; started < threads - 1; started++) {
+        if (pthread_create(&tids[started], NULL, roca_batch_worker, &batch) != 0)
+            break;
     }
+    roca_batch_worker(&batch);
+    for (int i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
 
-    ret = true;
-    if (verbose)
-        PrintAndLogEx(SUCCESS, "Fingerprint found!\n");
+    pthread_mutex_destroy(&batch.lock);
 
-cleanup:
-    mbedtls_mpi_free(&t_modulus);
-
-    rocacheck_cleanup(prints);
-    return ret;
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+        n += found[i];
+    return n;
 }
 
 int roca_self_test(void) {
@@ -173,5 +227,25 @@ int roca_self_test(void) {
     } else {
         PrintAndLogEx(SUCCESS, "Strong modulus [ %s ]", _GREEN_("PASS"));
     }
+
+    // batch, alternating both keys
+    const unsigned char *moduli[256];
+    size_t lens[256];
+    bool found[256];
+    for (int i = 0; i < 256; i++) {
+        moduli[i] = (i & 1) ? keyn : keyp;
+        lens[i] = 64;
+    }
+
+    bool batchok = emv_rocacheck_batch(moduli, lens, 256, 4, found) == 128;
+    for (int i = 0; i < 256; i++)
+        batchok &= found[i] == !(i & 1);
+
+    if (batchok) {
+        PrintAndLogEx(SUCCESS, "Batch          [ %s ]", _GREEN_("PASS"));
+    } else {
+        ret++;
+        PrintAndLogEx(FAILED, "Batch          [ %s ]", _RED_("Fail"));
+    }
     return ret;
 }
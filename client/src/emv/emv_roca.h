@@ -29,6 +29,8 @@
 #define ROCA_PRINTS_LENGTH 17
 
 bool emv_rocacheck(const unsigned char *buf, size_t buflen, bool verbose);
+// checks count moduli on threads, found[i] is the result of moduli[i]. Returns the number found
+size_t emv_rocacheck_batch(const unsigned char **moduli, const size_t *lens, size_t count, int threads, bool *found);
 int roca_self_test(void);
 
 #endif
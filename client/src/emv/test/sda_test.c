@@ -254,6 +254,60 @@ static int sda_test_pk(bool verbose) {
     return 0;
 }
 
+// the CA key of the tests out of capk.txt, and the RSA context every user of it shares
+static int sda_test_capk(bool verbose) {
+    struct emv_pk *pk = emv_pk_get_ca_pk(vsdc_01.rid, vsdc_01.index);
+    if (!pk) {
+        PrintAndLogEx(WARNING, "CA key not found!");
+        return 2;
+    }
+
+    int ret = 0;
+    if (pk->mlen != vsdc_01.mlen || memcmp(pk->modulus, vsdc_01.modulus, pk->mlen)) {
+        PrintAndLogEx(WARNING, "CA key differs!");
+        ret = 2;
+    }
+
+    struct emv_pk *again = emv_pk_get_ca_pk(vsdc_01.rid, vsdc_01.index);
+    if (!again || again->mlen != pk->mlen || memcmp(again->modulus, pk->modulus, pk->mlen)) {
+        PrintAndLogEx(WARNING, "second lookup differs!");
+        ret = 2;
+    }
+    emv_pk_free(again);
+
+    unsigned char unknown_rid[5] = { 0xa0, 0x00, 0x00, 0x00, 0x03, };
+    if (emv_pk_get_ca_pk(unknown_rid, 0xfe) != NULL) {
+        PrintAndLogEx(WARNING, "unknown CA key found!");
+        ret = 2;
+    }
+
+    struct crypto_pk *kcp = emv_pk_get_ca_crypto(pk);
+    if (!kcp || emv_pk_get_ca_crypto(&vsdc_01) != kcp) {
+        PrintAndLogEx(WARNING, "RSA context not shared!");
+        ret = 2;
+    }
+
+    // the shared context recovers the issuer certificate
+    struct tlvdb *db = tlvdb_external(0x90, sizeof(issuer_cert), issuer_cert);
+    tlvdb_add(db, tlvdb_external(0x9f32, sizeof(issuer_exp), issuer_exp));
+    tlvdb_add(db, tlvdb_external(0x92, sizeof(issuer_rem), issuer_rem));
+    tlvdb_add(db, tlvdb_external(0x5a, sizeof(pan), pan));
+
+    struct emv_pk *ipk = emv_pki_recover_issuer_cert(pk, db);
+    if (!ipk) {
+        PrintAndLogEx(WARNING, "Could not recover Issuer certificate!");
+        ret = 2;
+    } else if (verbose) {
+        PrintAndLogEx(INFO, "issuer pk:");
+        dump_buffer(ipk->modulus, ipk->mlen, stdout, 0);
+    }
+
+    emv_pk_free(ipk);
+    tlvdb_free(db);
+    emv_pk_free(pk);
+    return ret;
+}
+
 int exec_sda_test(bool verbose) {
     int ret = sda_test_raw(verbose);
     if (ret) {
@@ -268,5 +322,12 @@ int exec_sda_test(bool verbose) {
         return ret;
     }
     PrintAndLogEx(SUCCESS, "SDA test pk: %s", _GREEN_("passed"));
+
+    ret = sda_test_capk(verbose);
+    if (ret) {
+        PrintAndLogEx(WARNING, "SDA test capk: %s", _RED_("failed"));
+        return ret;
+    }
+    PrintAndLogEx(SUCCESS, "SDA test capk: %s", _GREEN_("passed"));
     return 0;
 }
@@ -39,17 +39,39 @@
 //  const typeof( ((type *)0)->member ) *__mptr = (ptr);
 //        (type *)( (char *)__mptr - offsetof(type,member) );})
 
+// Every parsed TLV buffer, fixed and external element is one allocation, an
+// arena, holding its nodes in document order and the copy of the buffer the
+// values point into. Parsed arenas carry an index of their tags. As long as
+// nobody has relinked nodes of an arena, the subtree of a node is the node
+// range [pos, end) and a search in it is one hash lookup.
+struct tlvdb_arena;
+
 struct tlvdb {
     struct tlv tag;
     struct tlvdb *next;
     struct tlvdb *parent;
     struct tlvdb *children;
+    struct tlvdb_arena *arena;
+    uint32_t pos;
+    uint32_t end;
+};
+
+struct tlvdb_slot {
+    tlv_tag_t tag;      // TLV_TAG_INVALID for a free slot
+    uint32_t first;     // into order[]
+    uint32_t n;
 };
 
-struct tlvdb_root {
-    struct tlvdb db;
-    size_t len;
-    unsigned char buf[0];
+struct tlvdb_arena {
+    size_t count;       // nodes
+    size_t used;        // nodes handed out while parsing
+    size_t live;        // nodes not freed yet, the arena goes with the last one
+    bool indexed;       // false once a node of the arena was relinked
+    uint8_t shift;
+    struct tlvdb_slot *slots;
+    uint32_t *order;    // node positions grouped by tag, in document order
+    unsigned char *buf;
+    struct tlvdb nodes[];
 };
 
 static tlv_tag_t tlv_parse_tag(const unsigned char **buf, size_t *len) {
@@ -88,7 +110,7 @@ static size_t tlv_parse_len(const unsigned char **buf, size_t *len) {
         return l;
 
     size_t ll = l & ~ TLV_LEN_LONG;
-    if (ll > 5)
+    if (ll > 5 || ll > *len)
         return TLV_LEN_INVALID;
 
     l = 0;
@@ -115,7 +137,145 @@ bool tlv_parse_tl(const unsigned char **buf, size_t *len, struct tlv *tlv) {
     return true;
 }
 
-static struct tlvdb *tlvdb_parse_children(struct tlvdb *parent);
+static struct tlvdb_arena *tlvdb_arena_new(size_t count, size_t len, bool indexed) {
+    size_t nslots = 0;
+    uint8_t shift = 32;
+    if (indexed) {
+        nslots = 1;
+        while (nslots < count * 2) {
+            nslots <<= 1;
+            shift--;
+        }
+    }
+
+    size_t size = sizeof(struct tlvdb_arena)
+                  + count * sizeof(struct tlvdb)
+                  + nslots * sizeof(struct tlvdb_slot)
+                  + (indexed ? count * sizeof(uint32_t) : 0)
+                  + len;
+    struct tlvdb_arena *arena = malloc(size);
+    if (!arena)
+        return NULL;
+
+    arena->count = count;
+    arena->used = 0;
+    arena->live = count;
+    arena->indexed = indexed;
+    arena->shift = shift;
+    arena->slots = (struct tlvdb_slot *)&arena->nodes[count];
+    arena->order = (uint32_t *)&arena->slots[nslots];
+    arena->buf = (unsigned char *)&arena->order[indexed ? count : 0];
+    memset(arena->slots, 0, nslots * sizeof(struct tlvdb_slot));
+    return arena;
+}
+
+static struct tlvdb *tlvdb_arena_node(struct tlvdb_arena *arena) {
+    struct tlvdb *tlvdb = &arena->nodes[arena->used];
+    tlvdb->arena = arena;
+    tlvdb->pos = arena->used++;
+    tlvdb->end = tlvdb->pos + 1;
+    tlvdb->next = tlvdb->parent = tlvdb->children = NULL;
+    return tlvdb;
+}
+
+static struct tlvdb_slot *tlvdb_arena_slot(struct tlvdb_arena *arena, tlv_tag_t tag) {
+    uint32_t mask = (1U << (32 - arena->shift)) - 1;
+    uint32_t i = (arena->shift < 32) ? (uint32_t)(tag * 2654435761U) >> arena->shift : 0;
+
+    while (arena->slots[i].tag != TLV_TAG_INVALID && arena->slots[i].tag != tag)
+        i = (i + 1) & mask;
+
+    return &arena->slots[i];
+}
+
+static void tlvdb_arena_index(struct tlvdb_arena *arena) {
+    for (size_t i = 0; i < arena->used; i++) {
+        struct tlvdb_slot *slot = tlvdb_arena_slot(arena, arena->nodes[i].tag.tag);
+        slot->tag = arena->nodes[i].tag.tag;
+        slot->n++;
+    }
+
+    uint32_t first = 0;
+    for (size_t i = 0; i < (1U << (32 - arena->shift)); i++) {
+        arena->slots[i].first = first;
+        first += arena->slots[i].n;
+        arena->slots[i].n = 0;
+    }
+
+    for (size_t i = 0; i < arena->used; i++) {
+        struct tlvdb_slot *slot = tlvdb_arena_slot(arena, arena->nodes[i].tag.tag);
+        arena->order[slot->first + slot->n++] = i;
+    }
+}
+
+// the first node with this tag in the subtree of tlvdb, the arena must be indexed
+static struct tlvdb *tlvdb_arena_find(const struct tlvdb *tlvdb, tlv_tag_t tag) {
+    struct tlvdb_arena *arena = tlvdb->arena;
+    struct tlvdb_slot *slot = tlvdb_arena_slot(arena, tag);
+    if (slot->tag != tag)
+        return NULL;
+
+    const uint32_t *order = &arena->order[slot->first];
+    size_t lo = 0, hi = slot->n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (order[mid] < tlvdb->pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < slot->n && order[lo] < tlvdb->end)
+        return &arena->nodes[order[lo]];
+    return NULL;
+}
+
+static bool tlvdb_indexed(const struct tlvdb *tlvdb) {
+    return tlvdb->arena->indexed;
+}
+
+// the node after the subtree of tlvdb
+static const struct tlvdb *tlvdb_skip(const struct tlvdb *tlvdb) {
+    while (tlvdb) {
+        if (tlvdb->next)
+            return tlvdb->next;
+
+        tlvdb = tlvdb->parent;
+    }
+
+    return NULL;
+}
+
+// the number of nodes tlvdb_parse_one would make, or 0 for a bad buffer
+static size_t tlv_count_one(const unsigned char **tmp, size_t *left) {
+    struct tlv tlv;
+    tlv.tag = tlv_parse_tag(tmp, left);
+    if (tlv.tag == TLV_TAG_INVALID)
+        return 0;
+
+    tlv.len = tlv_parse_len(tmp, left);
+    if (tlv.len == TLV_LEN_INVALID || tlv.len > *left)
+        return 0;
+
+    const unsigned char *value = *tmp;
+    size_t vleft = tlv.len;
+    *tmp += tlv.len;
+    *left -= tlv.len;
+
+    size_t count = 1;
+    if (tlv_is_constructed(&tlv)) {
+        while (vleft != 0) {
+            size_t n = tlv_count_one(&value, &vleft);
+            if (!n)
+                return 0;
+            count += n;
+        }
+    }
+
+    return count;
+}
+
+static bool tlvdb_parse_children(struct tlvdb *parent);
 
 static bool tlvdb_parse_one(struct tlvdb *tlvdb,
                             struct tlvdb *parent,
@@ -141,136 +301,121 @@ static bool tlvdb_parse_one(struct tlvdb *tlvdb,
     *left -= tlvdb->tag.len;
 
     if (tlv_is_constructed(&tlvdb->tag) && (tlvdb->tag.len != 0)) {
-        tlvdb->children = tlvdb_parse_children(tlvdb);
-        if (!tlvdb->children)
+        if (!tlvdb_parse_children(tlvdb))
             goto err;
-    } else {
-        tlvdb->children = NULL;
     }
 
+    tlvdb->end = tlvdb->arena->used;
     return true;
 
 err:
     return false;
 }
 
-static struct tlvdb *tlvdb_parse_children(struct tlvdb *parent) {
+static bool tlvdb_parse_children(struct tlvdb *parent) {
     const unsigned char *tmp = parent->tag.value;
     size_t left = parent->tag.len;
-    struct tlvdb *tlvdb, *first = NULL, *prev = NULL;
+    struct tlvdb *tlvdb, *prev = NULL;
 
     while (left != 0) {
-        tlvdb = malloc(sizeof(*tlvdb));
+        tlvdb = tlvdb_arena_node(parent->arena);
         if (prev)
             prev->next = tlvdb;
         else
-            first = tlvdb;
+            parent->children = tlvdb;
         prev = tlvdb;
 
         if (!tlvdb_parse_one(tlvdb, parent, &tmp, &left))
-            goto err;
-
-        tlvdb->parent = parent;
+            return false;
     }
 
-    return first;
-
-err:
-    tlvdb_free(first);
-
-    return NULL;
+    return true;
 }
 
-struct tlvdb *tlvdb_parse(const unsigned char *buf, size_t len) {
-    struct tlvdb_root *root;
-    const unsigned char *tmp;
-    size_t left;
+static struct tlvdb *tlvdb_parse_arena(const unsigned char *buf, size_t len, bool multi) {
+    const unsigned char *tmp = buf;
+    size_t left = len;
+    size_t count = 0;
 
     if (!len || !buf)
         return NULL;
 
-    root = malloc(sizeof(*root) + len);
-    root->len = len;
-    memcpy(root->buf, buf, len);
-
-    tmp = root->buf;
-    left = len;
-
-    if (!tlvdb_parse_one(&root->db, NULL, &tmp, &left))
-        goto err;
+    // count the nodes first, the arena is allocated once
+    do {
+        size_t n = tlv_count_one(&tmp, &left);
+        if (!n)
+            return NULL;
+        count += n;
+    } while (multi && left != 0);
 
     if (left)
-        goto err;
-
-    return &root->db;
-
-err:
-    tlvdb_free(&root->db);
-
-    return NULL;
-}
-
-struct tlvdb *tlvdb_parse_multi(const unsigned char *buf, size_t len) {
-    struct tlvdb_root *root;
-    const unsigned char *tmp;
-    size_t left;
-
-    if (!len || !buf)
         return NULL;
 
-    root = malloc(sizeof(*root) + len);
-    root->len = len;
-    memcpy(root->buf, buf, len);
+    struct tlvdb_arena *arena = tlvdb_arena_new(count, len, true);
+    if (!arena)
+        return NULL;
 
-    tmp = root->buf;
+    memcpy(arena->buf, buf, len);
+    tmp = arena->buf;
     left = len;
 
-    if (!tlvdb_parse_one(&root->db, NULL, &tmp, &left))
-        goto err;
-
+    struct tlvdb *prev = NULL;
     while (left != 0) {
-        struct tlvdb *db = malloc(sizeof(*db));
-        if (!tlvdb_parse_one(db, NULL, &tmp, &left)) {
-            free(db);
-            goto err;
+        struct tlvdb *tlvdb = tlvdb_arena_node(arena);
+        if (!tlvdb_parse_one(tlvdb, NULL, &tmp, &left)) {
+            free(arena);
+            return NULL;
         }
 
-        tlvdb_add(&root->db, db);
+        if (prev)
+            prev->next = tlvdb;
+        prev = tlvdb;
     }
 
-    return &root->db;
+    tlvdb_arena_index(arena);
+    return &arena->nodes[0];
+}
 
-err:
-    tlvdb_free(&root->db);
+struct tlvdb *tlvdb_parse(const unsigned char *buf, size_t len) {
+    return tlvdb_parse_arena(buf, len, false);
+}
 
-    return NULL;
+struct tlvdb *tlvdb_parse_multi(const unsigned char *buf, size_t len) {
+    return tlvdb_parse_arena(buf, len, true);
 }
 
 struct tlvdb *tlvdb_fixed(tlv_tag_t tag, size_t len, const unsigned char *value) {
-    struct tlvdb_root *root = malloc(sizeof(*root) + len);
+    struct tlvdb_arena *arena = tlvdb_arena_new(1, len, false);
+    if (!arena)
+        return NULL;
 
-    root->len = len;
-    memcpy(root->buf, value, len);
+    memcpy(arena->buf, value, len);
 
-    root->db.parent = root->db.next = root->db.children = NULL;
-    root->db.tag.tag = tag;
-    root->db.tag.len = len;
-    root->db.tag.value = root->buf;
+    struct tlvdb *tlvdb = tlvdb_arena_node(arena);
+    tlvdb->tag.tag = tag;
+    tlvdb->tag.len = len;
+    tlvdb->tag.value = arena->buf;
 
-    return &root->db;
+    return tlvdb;
 }
 
 struct tlvdb *tlvdb_external(tlv_tag_t tag, size_t len, const unsigned char *value) {
-    struct tlvdb_root *root = malloc(sizeof(*root));
+    struct tlvdb_arena *arena = tlvdb_arena_new(1, 0, false);
+    if (!arena)
+        return NULL;
 
-    root->len = 0;
+    struct tlvdb *tlvdb = tlvdb_arena_node(arena);
+    tlvdb->tag.tag = tag;
+    tlvdb->tag.len = len;
+    tlvdb->tag.value = value;
 
-    root->db.parent = root->db.next = root->db.children = NULL;
-    root->db.tag.tag = tag;
-    root->db.tag.len = len;
-    root->db.tag.value = value;
+    return tlvdb;
+}
 
-    return &root->db;
+static void tlvdb_release(struct tlvdb_arena *arena, size_t count) {
+    arena->live -= count;
+    if (arena->live == 0)
+        free(arena);
 }
 
 void tlvdb_free(struct tlvdb *tlvdb) {
@@ -281,8 +426,15 @@ void tlvdb_free(struct tlvdb *tlvdb) {
 
     for (; tlvdb; tlvdb = next) {
         next = tlvdb->next;
+
+        // an untouched subtree is all in its arena
+        if (tlvdb_indexed(tlvdb)) {
+            tlvdb_release(tlvdb->arena, tlvdb->end - tlvdb->pos);
+            continue;
+        }
+
         tlvdb_free(tlvdb->children);
-        free(tlvdb);
+        tlvdb_release(tlvdb->arena, 1);
     }
 }
 
@@ -310,6 +462,13 @@ struct tlvdb *tlvdb_find_full(struct tlvdb *tlvdb, tlv_tag_t tag) {
         return NULL;
 
     for (; tlvdb; tlvdb = tlvdb->next) {
+        if (tlvdb_indexed(tlvdb)) {
+            struct tlvdb *ch = tlvdb_arena_find(tlvdb, tag);
+            if (ch)
+                return ch;
+            continue;
+        }
+
         if (tlvdb->tag.tag == tag)
             return tlvdb;
 
@@ -349,6 +508,10 @@ void tlvdb_add(struct tlvdb *tlvdb, struct tlvdb *other) {
         tlvdb = tlvdb->next;
     }
 
+    // a longer child list changes the subtree of the parent
+    if (tlvdb->parent)
+        tlvdb->parent->arena->indexed = false;
+
     tlvdb->next = other;
 }
 
@@ -368,6 +531,9 @@ void tlvdb_change_or_add_node_ex(struct tlvdb *tlvdb, tlv_tag_t tag, size_t len,
         // replace tlv element
         struct tlvdb *tnewelm = tlvdb_fixed(tag, len, value);
         bool tnewelm_linked = false;
+        telm->arena->indexed = false;
+        if (telm->parent)
+            telm->parent->arena->indexed = false;
         tnewelm->next = telm->next;
         tnewelm->parent = telm->parent;
 
@@ -450,6 +616,15 @@ const struct tlv *tlvdb_get(const struct tlvdb *tlvdb, tlv_tag_t tag, const stru
 
 
     while (tlvdb) {
+        if (tlvdb_indexed(tlvdb)) {
+            const struct tlvdb *found = tlvdb_arena_find(tlvdb, tag);
+            if (found)
+                return &found->tag;
+
+            tlvdb = tlvdb_skip(tlvdb);
+            continue;
+        }
+
         if (tlvdb->tag.tag == tag)
             return &tlvdb->tag;
 
@@ -0,0 +1,248 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Real input FFT and FFT based correlation
+//-----------------------------------------------------------------------------
+#include "fft.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "pm3_cmd.h"            // error codes
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+size_t fft_size(size_t n) {
+    size_t size = 4;
+    while (size < n)
+        size <<= 1;
+    return size;
+}
+
+fft_plan_t *fft_plan_create(size_t n) {
+
+    if (n < 4 || (n & (n - 1)))
+        return NULL;
+
+    fft_plan_t *plan = calloc(1, sizeof(fft_plan_t));
+    if (plan == NULL)
+        return NULL;
+
+    plan->n = n;
+    plan->half = n / 2;
+    plan->bitrev = calloc(plan->half, sizeof(uint32_t));
+    plan->tw = calloc(plan->half / 2, sizeof(fft_complex_t));
+    plan->split = calloc(plan->half, sizeof(fft_complex_t));
+    if (plan->bitrev == NULL || plan->tw == NULL || plan->split == NULL) {
+        fft_plan_free(plan);
+        return NULL;
+    }
+
+    uint8_t bits = 0;
+    while (((size_t)1 << bits) < plan->half)
+        bits++;
+
+    for (size_t i = 0; i < plan->half; i++) {
+        uint32_t r = 0;
+        for (uint8_t b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        plan->bitrev[i] = r;
+    }
+
+    for (size_t k = 0; k < plan->half / 2; k++) {
+        plan->tw[k].re = cos(-2.0 * M_PI * k / plan->half);
+        plan->tw[k].im = sin(-2.0 * M_PI * k / plan->half);
+    }
+
+    for (size_t k = 0; k < plan->half; k++) {
+        plan->split[k].re = cos(-2.0 * M_PI * k / n);
+        plan->split[k].im = sin(-2.0 * M_PI * k / n);
+    }
+    return plan;
+}
+
+void fft_plan_free(fft_plan_t *plan) {
+    if (plan == NULL)
+        return;
+    free(plan->bitrev);
+    free(plan->tw);
+    free(plan->split);
+    free(plan);
+}
+
+// in place radix-2 complex FFT of plan->half points, unscaled
+static void fft_complex(const fft_plan_t *plan, fft_complex_t *a, bool inverse) {
+
+    size_t m = plan->half;
+
+    for (size_t i = 0; i < m; i++) {
+        size_t r = plan->bitrev[i];
+        if (r > i) {
+            fft_complex_t t = a[i];
+            a[i] = a[r];
+            a[r] = t;
+        }
+    }
+
+    for (size_t size = 2; size <= m; size <<= 1) {
+        size_t h = size / 2;
+        size_t step = m / size;
+        for (size_t i = 0; i < m; i += size) {
+            for (size_t k = 0; k < h; k++) {
+                fft_complex_t w = plan->tw[k * step];
+                if (inverse)
+                    w.im = -w.im;
+                fft_complex_t *x = &a[i + k];
+                fft_complex_t *y = &a[i + k + h];
+                double tre = w.re * y->re - w.im * y->im;
+                double tim = w.re * y->im + w.im * y->re;
+                y->re = x->re - tre;
+                y->im = x->im - tim;
+                x->re += tre;
+                x->im += tim;
+            }
+        }
+    }
+}
+
+void fft_real_forward(const fft_plan_t *plan, const double *in, fft_complex_t *out) {
+
+    size_t m = plan->half;
+
+    // even samples as real, odd samples as imaginary part
+    for (size_t k = 0; k < m; k++) {
+        out[k].re = in[2 * k];
+        out[k].im = in[2 * k + 1];
+    }
+    fft_complex(plan, out, false);
+
+    // split into the spectrum of the real signal, bins k and m - k together
+    fft_complex_t z0 = out[0];
+    out[0].re = z0.re + z0.im;
+    out[0].im = 0;
+    out[m].re = z0.re - z0.im;
+    out[m].im = 0;
+
+    for (size_t k = 1; k <= m / 2; k++) {
+        fft_complex_t zk = out[k];
+        fft_complex_t zc = { out[m - k].re, -out[m - k].im };
+
+        // even and odd parts of both bins
+        double ere = (zk.re + zc.re) / 2, eim = (zk.im + zc.im) / 2;
+        double ore = (zk.im - zc.im) / 2, oim = -(zk.re - zc.re) / 2;
+
+        fft_complex_t w = plan->split[k];
+        out[k].re = ere + (w.re * ore - w.im * oim);
+        out[k].im = eim + (w.re * oim + w.im * ore);
+
+        // bin m - k: E' = conj(E), O' = conj(O), W^(m-k) = -conj(W^k)
+        if (k != m - k) {
+            out[m - k].re = ere - (w.re * ore - w.im * oim);
+            out[m - k].im = -eim + (w.re * oim + w.im * ore);
+        }
+    }
+}
+
+void fft_real_inverse(const fft_plan_t *plan, fft_complex_t *in, double *out) {
+
+    size_t m = plan->half;
+
+    // merge back into the half size complex spectrum, bins k and m - k together
+    fft_complex_t x0 = in[0], xm = in[m];
+    in[0].re = (x0.re + xm.re) / 2;
+    in[0].im = (x0.re - xm.re) / 2;
+
+    for (size_t k = 1; k <= m / 2; k++) {
+        fft_complex_t xk = in[k];
+        fft_complex_t xc = { in[m - k].re, -in[m - k].im };
+
+        double ere = (xk.re + xc.re) / 2, eim = (xk.im + xc.im) / 2;
+        double dre = (xk.re - xc.re) / 2, dim = (xk.im - xc.im) / 2;
+
+        // O = D * conj(W^k)
+        fft_complex_t w = plan->split[k];
+        double ore = dre * w.re + dim * w.im;
+        double oim = dim * w.re - dre * w.im;
+
+        // Z = E + iO
+        in[k].re = ere - oim;
+        in[k].im = eim + ore;
+
+        // bin m - k: E' = conj(E), O' = conj(O)
+        if (k != m - k) {
+            in[m - k].re = ere + oim;
+            in[m - k].im = -eim + ore;
+        }
+    }
+
+    fft_complex(plan, in, true);
+
+    for (size_t k = 0; k < m; k++) {
+        out[2 * k] = in[k].re / m;
+        out[2 * k + 1] = in[k].im / m;
+    }
+}
+
+void fft_apply_window(double *samples, size_t len, fft_window_t window) {
+
+    if (window == FFT_WINDOW_NONE || len < 2)
+        return;
+
+    double a0 = (window == FFT_WINDOW_HANN) ? 0.5 : 0.54;
+    for (size_t i = 0; i < len; i++)
+        samples[i] *= a0 - (1 - a0) * cos(2.0 * M_PI * i / (len - 1));
+}
+
+int fft_autocorr(const fft_plan_t *plan, const int *in, size_t len, double mean, fft_window_t window, double *sums, size_t lags) {
+
+    if (len == 0 || lags > len)
+        return PM3_EINVARG;
+
+    // zero padded to twice the length, so the circular correlation doesn't wrap
+    fft_plan_t *own = NULL;
+    if (plan == NULL) {
+        own = fft_plan_create(fft_size(2 * len));
+        plan = own;
+    }
+    if (plan == NULL)
+        return PM3_EMALLOC;
+
+    if (plan->n < 2 * len) {
+        fft_plan_free(own);
+        return PM3_EINVARG;
+    }
+
+    double *buf = calloc(plan->n, sizeof(double));
+    fft_complex_t *spec = calloc(plan->half + 1, sizeof(fft_complex_t));
+    if (buf == NULL || spec == NULL) {
+        free(buf);
+        free(spec);
+        fft_plan_free(own);
+        return PM3_EMALLOC;
+    }
+
+    for (size_t i = 0; i < len; i++)
+        buf[i] = in[i] - mean;
+    fft_apply_window(buf, len, window);
+
+    fft_real_forward(plan, buf, spec);
+
+    // power spectrum
+    for (size_t k = 0; k <= plan->half; k++) {
+        spec[k].re = spec[k].re * spec[k].re + spec[k].im * spec[k].im;
+        spec[k].im = 0;
+    }
+
+    fft_real_inverse(plan, spec, buf);
+    memcpy(sums, buf, lags * sizeof(double));
+
+    free(buf);
+    free(spec);
+    fft_plan_free(own);
+    return PM3_SUCCESS;
+}
@@ -0,0 +1,65 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Real input FFT and FFT based correlation
+//
+// A plan holds the twiddle factors and bit reversal table for one transform
+// size, it can be reused for any number of transforms of that size and is
+// read only once created, so one plan may be shared between threads.
+//
+// Real transforms of n samples are done as a complex FFT of n/2 points plus
+// a split step, the spectrum holds the n/2 + 1 non redundant bins.
+//
+// Autocorrelation uses Wiener-Khinchin: the inverse transform of the power
+// spectrum of the zero padded signal, O(n log n) instead of O(n * lags).
+//-----------------------------------------------------------------------------
+
+#ifndef FFT_H__
+#define FFT_H__
+
+#include "common.h"
+
+typedef struct {
+    double re;
+    double im;
+} fft_complex_t;
+
+typedef enum {
+    FFT_WINDOW_NONE,
+    FFT_WINDOW_HANN,
+    FFT_WINDOW_HAMMING,
+} fft_window_t;
+
+typedef struct {
+    size_t n;               // real samples, power of two
+    size_t half;            // complex points of the inner FFT
+    uint32_t *bitrev;       // half entries
+    fft_complex_t *tw;      // half / 2 twiddles of the inner FFT
+    fft_complex_t *split;   // half twiddles e^(-2 pi i k / n) of the split step
+} fft_plan_t;
+
+// smallest power of two >= n
+size_t fft_size(size_t n);
+
+// n must be a power of two >= 4. Returns NULL on bad size or out of memory
+fft_plan_t *fft_plan_create(size_t n);
+void fft_plan_free(fft_plan_t *plan);
+
+// in: n samples, out: n/2 + 1 bins
+void fft_real_forward(const fft_plan_t *plan, const double *in, fft_complex_t *out);
+// in: n/2 + 1 bins, out: n samples, scaled so forward + inverse is the identity.
+// in is used as scratch
+void fft_real_inverse(const fft_plan_t *plan, fft_complex_t *in, double *out);
+
+// multiplies len samples with the window
+void fft_apply_window(double *samples, size_t len, fft_window_t window);
+
+// Autocorrelation sums of the mean removed signal
+//   sums[k] = sum_(j < len - k) (in[j] - mean) * (in[j + k] - mean), k < lags
+// The window is applied to the mean removed signal. plan may be NULL, else it
+// must have been created for fft_size(2 * len).
+int fft_autocorr(const fft_plan_t *plan, const int *in, size_t len, double mean, fft_window_t window, double *sums, size_t lags);
+
+#endif
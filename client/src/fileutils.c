@@ -39,6 +39,7 @@
 #define _GNU_SOURCE
 #include "fileutils.h"
 #include "preferences.h"
+#include "dictionary.h"
 
 #include <dirent.h>
 #include <ctype.h>
@@ -1148,6 +1149,30 @@ out:
     return retval;
 }
 
+// locate a dictionary. A compiled dictionary not older than the text file is preferred
+static int searchDictionary(const char *preferredName, uint8_t keylen, char **path, dictionary_t *cdict, bool *compiled) {
+
+    *compiled = false;
+    char *textpath = NULL;
+    int res = searchFile(&textpath, DICTIONARIES_SUBDIR, preferredName, ".dic", true);
+
+    char *cpath = NULL;
+    if (dictionary_open_compiled((res == PM3_SUCCESS) ? textpath : NULL, preferredName, keylen, cdict, &cpath) == PM3_SUCCESS) {
+        free(textpath);
+        *path = cpath;
+        *compiled = true;
+        return PM3_SUCCESS;
+    }
+
+    if (res == PM3_SUCCESS) {
+        *path = textpath;
+        return PM3_SUCCESS;
+    }
+
+    // not found, search again to get the usual error message
+    return searchFile(path, DICTIONARIES_SUBDIR, preferredName, ".dic", false);
+}
+
 int loadFileDICTIONARY(const char *preferredName, void *data, size_t *datalen, uint8_t keylen, uint32_t *keycnt) {
     // t5577 == 4bytes
     // mifare == 6 bytes
@@ -1170,16 +1195,40 @@ int loadFileDICTIONARYEx(const char *preferredName, void *data, size_t maxdatale
         *endFilePosition = 0;
 
     char *path;
-    if (searchFile(&path, DICTIONARIES_SUBDIR, preferredName, ".dic", false) != PM3_SUCCESS)
+    dictionary_t cdict;
+    bool compiled;
+    if (searchDictionary(preferredName, keylen, &path, &cdict, &compiled) != PM3_SUCCESS)
         return PM3_EFILE;
 
+    uint32_t vkeycnt = 0;
+    size_t counter = 0;
+    int retval = PM3_SUCCESS;
+
+    if (compiled) {
+        // no parsing, keys are copied straight from the mapping
+        uint32_t idx = 0;
+        if (startFilePosition > sizeof(dictionary_hdr_t))
+            idx = (startFilePosition - sizeof(dictionary_hdr_t)) / keylen;
+        if (idx > cdict.keycnt)
+            idx = cdict.keycnt;
+
+        vkeycnt = cdict.keycnt - idx;
+        if (maxdatalen && ((size_t)vkeycnt * keylen > maxdatalen)) {
+            vkeycnt = maxdatalen / keylen;
+            retval = 1;
+            if (endFilePosition)
+                *endFilePosition = dictionary_key_offset(&cdict, idx + vkeycnt);
+        }
+        counter = (size_t)vkeycnt * keylen;
+        memcpy(data, cdict.keys + (size_t)idx * keylen, counter);
+        dictionary_close(&cdict);
+        goto done;
+    }
+
     // double up since its chars
     keylen <<= 1;
 
     char line[255];
-    uint32_t vkeycnt = 0;
-    size_t counter = 0;
-    int retval = PM3_SUCCESS;
 
     FILE *f = fopen(path, "r");
     if (!f) {
@@ -1238,6 +1287,8 @@ int loadFileDICTIONARYEx(const char *preferredName, void *data, size_t maxdatale
         counter += (keylen >> 1);
     }
     fclose(f);
+
+done:
     if (verbose)
         PrintAndLogEx(SUCCESS, "loaded " _GREEN_("%2d") " keys from dictionary file " _YELLOW_("%s"), vkeycnt, path);
 
@@ -1254,10 +1305,6 @@ int loadFileDICTIONARY_safe(const char *preferredName, void **pdata, uint8_t key
 
     int retval = PM3_SUCCESS;
 
-    char *path;
-    if (searchFile(&path, DICTIONARIES_SUBDIR, preferredName, ".dic", false) != PM3_SUCCESS)
-        return PM3_EFILE;
-
     // t5577 == 4bytes
     // mifare == 6 bytes
     // mf plus == 16 bytes
@@ -1267,6 +1314,28 @@ int loadFileDICTIONARY_safe(const char *preferredName, void **pdata, uint8_t key
         keylen = 6;
     }
 
+    char *path;
+    dictionary_t cdict;
+    bool compiled;
+    if (searchDictionary(preferredName, keylen, &path, &cdict, &compiled) != PM3_SUCCESS)
+        return PM3_EFILE;
+
+    if (compiled) {
+        // one allocation and copy, no parsing
+        *pdata = calloc(((size_t)cdict.keycnt * keylen) + 1, sizeof(uint8_t));
+        if (*pdata == NULL) {
+            dictionary_close(&cdict);
+            free(path);
+            return PM3_EMALLOC;
+        }
+        memcpy(*pdata, cdict.keys, (size_t)cdict.keycnt * keylen);
+        *keycnt += cdict.keycnt;
+        dictionary_close(&cdict);
+        PrintAndLogEx(SUCCESS, "loaded " _GREEN_("%2d") " keys from dictionary file " _YELLOW_("%s"), *keycnt, path);
+        free(path);
+        return PM3_SUCCESS;
+    }
+
     size_t mem_size;
     size_t block_size = 10 * keylen;
 
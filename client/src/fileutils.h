@@ -210,6 +210,8 @@ int loadFileJSONex(const char *preferredName, void *data, size_t maxdatalen, siz
 /**
  * @brief  Utility function to load data from a DICTIONARY textfile. This method takes a preferred name.
  * E.g. mfc_default_keys.dic
+ * A compiled dictionary (.dicb, see `dict compile`) with the same key length which is not older
+ * than the textfile is used instead of the textfile.
  *
  * @param preferredName
  * @param data The data array to store the loaded bytes from file
@@ -231,7 +233,7 @@ int loadFileDICTIONARY(const char *preferredName, void *data, size_t *datalen, u
  * @param datalen the number of bytes loaded from file. may be NULL
  * @param keylen  the number of bytes a key per row is
  * @param keycnt key count that lays in data. may be NULL
- * @param startFilePosition  start position in dictionary file. used for big dictionaries.
+ * @param startFilePosition  start position in dictionary file (text or compiled). used for big dictionaries.
  * @param endFilePosition in case we have keys in file and maxdatalen reached it returns current key position in file. may be NULL
  * @param verbose print messages if true
  * @return 0 for ok, 1 for failz
@@ -17,15 +17,23 @@
 #include "cmddata.h" //for g_debugmode
 
 
-int GraphBuffer[MAX_GRAPH_TRACE_LEN];
-size_t GraphTraceLen;
+// make room for len samples in the graph buffer, keeps what is there
+bool reserveGraphBuf(size_t len) {
+    if (demod_ctx_reserve(demod_ctx(), len))
+        return true;
 
-/* write a manchester bit to the graph
-TODO,  verfy that this doesn't overflow buffer  (iceman)
-*/
+    PrintAndLogEx(WARNING, "Failed to allocate memory for %zu samples", len);
+    return false;
+}
+
+// write a manchester bit to the graph
 void AppendGraph(bool redraw, uint16_t clock, int bit) {
     uint8_t half = clock / 2;
     uint8_t i;
+
+    if (reserveGraphBuf(GraphTraceLen + clock) == false)
+        return;
+
     //set first half the clock bit (all 1's or 0's for a 0 or 1 bit)
     for (i = 0; i < half; ++i)
         GraphBuffer[GraphTraceLen++] = bit;
@@ -34,6 +42,7 @@ void AppendGraph(bool redraw, uint16_t clock, int bit) {
     for (; i < clock; ++i)
         GraphBuffer[GraphTraceLen++] = bit ^ 1;
 
+    demod_ctx_touch(demod_ctx());
     if (redraw)
         RepaintGraphWindow();
 }
@@ -41,28 +50,36 @@ void AppendGraph(bool redraw, uint16_t clock, int bit) {
 // clear out our graph window
 size_t ClearGraph(bool redraw) {
     size_t gtl = GraphTraceLen;
-    memset(GraphBuffer, 0x00, GraphTraceLen);
+    if (gtl)
+        memset(GraphBuffer, 0x00, GraphTraceLen * sizeof(int));
     GraphTraceLen = 0;
+    demod_ctx_touch(demod_ctx());
     if (redraw)
         RepaintGraphWindow();
     return gtl;
 }
 // option '1' to save GraphBuffer any other to restore
 void save_restoreGB(uint8_t saveOpt) {
-    static int SavedGB[MAX_GRAPH_TRACE_LEN];
-    static size_t SavedGBlen = 0;
-    static bool GB_Saved = false;
-    static int SavedGridOffsetAdj = 0;
+    demod_ctx_t *ctx = demod_ctx();
 
     if (saveOpt == GRAPH_SAVE) { //save
-        memcpy(SavedGB, GraphBuffer, sizeof(GraphBuffer));
-        SavedGBlen = GraphTraceLen;
-        GB_Saved = true;
-        SavedGridOffsetAdj = GridOffset;
-    } else if (GB_Saved) { //restore
-        memcpy(GraphBuffer, SavedGB, sizeof(GraphBuffer));
-        GraphTraceLen = SavedGBlen;
-        GridOffset = SavedGridOffsetAdj;
+        // only as big as the samples to keep
+        int *saved = realloc(ctx->saved_graph, MAX(ctx->graph_len, 1) * sizeof(int));
+        if (saved == NULL)
+            return;
+        ctx->saved_graph = saved;
+        if (ctx->graph_len)
+            memcpy(ctx->saved_graph, ctx->graph, ctx->graph_len * sizeof(int));
+        ctx->saved_graph_len = GraphTraceLen;
+        ctx->saved_grid_offset = GridOffset;
+    } else if (ctx->saved_graph) { //restore
+        if (reserveGraphBuf(ctx->saved_graph_len) == false)
+            return;
+        if (ctx->saved_graph_len)
+            memcpy(ctx->graph, ctx->saved_graph, ctx->saved_graph_len * sizeof(int));
+        GraphTraceLen = ctx->saved_graph_len;
+        GridOffset = ctx->saved_grid_offset;
+        demod_ctx_touch(ctx);
         RepaintGraphWindow();
     }
 }
@@ -72,28 +89,35 @@ void setGraphBuf(uint8_t *buff, size_t size) {
 
     ClearGraph(false);
 
-    if (size > MAX_GRAPH_TRACE_LEN)
-        size = MAX_GRAPH_TRACE_LEN;
+    if (reserveGraphBuf(size) == false)
+        return;
 
     for (size_t i = 0; i < size; ++i)
         GraphBuffer[i] = buff[i] - 128;
 
     GraphTraceLen = size;
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
 }
 
 size_t getFromGraphBuf(uint8_t *buff) {
+    return getFromGraphBufEx(buff, GraphTraceLen);
+}
+
+// the first max samples at most, for fixed size buffers
+size_t getFromGraphBufEx(uint8_t *buff, size_t max) {
     if (buff == NULL) return 0;
     if (GraphTraceLen == 0) return 0;
 
-    size_t i;
-    for (i = 0; i < GraphTraceLen; ++i) {
+    int *graph = GraphBuffer;
+    size_t len = MIN(GraphTraceLen, max);
+    for (size_t i = 0; i < len; ++i) {
         //trim
-        if (GraphBuffer[i] > 127) GraphBuffer[i] = 127;
-        if (GraphBuffer[i] < -127) GraphBuffer[i] = -127;
-        buff[i] = (uint8_t)(GraphBuffer[i] + 128);
+        if (graph[i] > 127) graph[i] = 127;
+        if (graph[i] < -127) graph[i] = -127;
+        buff[i] = (uint8_t)(graph[i] + 128);
     }
-    return i;
+    return len;
 }
 
 // A simple test to see if there is any data inside Graphbuffer.
@@ -128,24 +152,48 @@ void convertGraphFromBitstreamEx(int hi, int low) {
         else
             GraphBuffer[i] = 0;
     }
+    demod_ctx_touch(demod_ctx());
 
-    uint8_t *bits = calloc(GraphTraceLen, sizeof(uint8_t));
+    // set signal properties low/high/mean/amplitude and is_noise detection
+    updateSignalProperties();
+    RepaintGraphWindow();
+}
+
+// signal properties of the graph buffer. The samples are only scanned again when they changed
+signal_t *updateSignalProperties(void) {
+    demod_ctx_t *ctx = demod_ctx();
+    if (ctx->sigprop_gen == ctx->graph_gen)
+        return &ctx->sigprop;
+
+    uint8_t *bits = demod_ctx_scratch(ctx, GraphTraceLen);
     if (bits == NULL) {
-        PrintAndLogEx(DEBUG, "ERR: convertGraphFromBitstreamEx, failed to allocate memory");
-        return;
+        PrintAndLogEx(DEBUG, "ERR: updateSignalProperties, failed to allocate memory");
+        return &ctx->sigprop;
     }
 
+    // clamping the graph to 8 bit doesn't change what the properties see, the generation stays
     size_t size = getFromGraphBuf(bits);
-    if (size == 0) {
-        PrintAndLogEx(WARNING, "Failed to copy from graphbuffer");
-        free(bits);
-        return;
-    }
-
-    // set signal properties low/high/mean/amplitude and is_noise detection
     computeSignalProperties(bits, size);
-    free(bits);
-    RepaintGraphWindow();
+    ctx->sigprop_gen = ctx->graph_gen;
+    return &ctx->sigprop;
+}
+
+// edges of the graph buffer for the clock detectors. bits is the 8 bit copy from
+// getFromGraphBuf, as it came. Built once per generation of the samples
+const lf_waves_t *getGraphWaves(const uint8_t *bits, size_t size) {
+    demod_ctx_t *ctx = demod_ctx();
+    const lf_waves_t *shared = ctx->shared_waves;
+    if (shared && ctx->shared_waves_gen == ctx->graph_gen && shared->size == size && shared->mean == ctx->sigprop.mean)
+        return shared;
+
+    if (ctx->waves_gen == ctx->graph_gen && ctx->waves.size == size && ctx->waves.mean == ctx->sigprop.mean)
+        return &ctx->waves;
+
+    if (lfWavesBuild(&ctx->waves, bits, size) == false)
+        return NULL;
+
+    ctx->waves_gen = ctx->graph_gen;
+    return &ctx->waves;
 }
 
 // Get or auto-detect ask clock rate
@@ -159,7 +207,7 @@ int GetAskClock(const char *str, bool printAns) {
 
     // Auto-detect clock
 
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN,  sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         PrintAndLogEx(WARNING, "Failed to allocate memory");
         return -1;
@@ -168,15 +216,16 @@ int GetAskClock(const char *str, bool printAns) {
     size_t size = getFromGraphBuf(bits);
     if (size == 0) {
         PrintAndLogEx(WARNING, "Failed to copy from graphbuffer");
-        free(bits);
         return -1;
     }
 
+    const lf_waves_t *waves = getGraphWaves(bits, size);
+
     size_t ststart = 0, stend = 0;
-    bool st = DetectST(bits, &size, &clock1, &ststart, &stend);
+    bool st = DetectST(bits, &size, &clock1, &ststart, &stend, waves);
     int idx = stend;
     if (st == false) {
-        idx = DetectASKClock(bits, size, &clock1, 20);
+        idx = DetectASKClock(bits, size, &clock1, 20, waves);
     }
 
     if (clock1 > 0) {
@@ -186,7 +235,6 @@ int GetAskClock(const char *str, bool printAns) {
     if (printAns || g_debugMode)
         PrintAndLogEx(SUCCESS, "Auto-detected clock rate: %d, Best Starting Position: %d", clock1, idx);
 
-    free(bits);
     return clock1;
 }
 
@@ -194,7 +242,7 @@ int GetPskCarrier(bool verbose) {
     if (getSignalProperties()->isnoise)
         return -1;
 
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN,  sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         PrintAndLogEx(WARNING, "Failed to allocate memory");
         return -1;
@@ -203,12 +251,10 @@ int GetPskCarrier(bool verbose) {
     size_t size = getFromGraphBuf(bits);
     if (size == 0) {
         PrintAndLogEx(WARNING, "Failed to copy from graphbuffer");
-        free(bits);
         return -1;
     }
 
-    uint16_t fc = countFC(bits, size, false);
-    free(bits);
+    uint16_t fc = countFC(bits, size, false, getGraphWaves(bits, size));
 
     uint8_t carrier = fc & 0xFF;
     if (carrier != 2 && carrier != 4 && carrier != 8) return 0;
@@ -230,7 +276,7 @@ int GetPskClock(const char *str, bool verbose) {
         return clock1;
 
     // Auto-detect clock
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN,  sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         PrintAndLogEx(WARNING, "Failed to allocate memory");
         return -1;
@@ -239,13 +285,12 @@ int GetPskClock(const char *str, bool verbose) {
     size_t size = getFromGraphBuf(bits);
     if (size == 0) {
         PrintAndLogEx(WARNING, "Failed to copy from graphbuffer");
-        free(bits);
         return -1;
     }
 
     size_t firstPhaseShiftLoc = 0;
     uint8_t curPhase = 0, fc = 0;
-    clock1 = DetectPSKClock(bits, size, 0, &firstPhaseShiftLoc, &curPhase, &fc);
+    clock1 = DetectPSKClock(bits, size, 0, &firstPhaseShiftLoc, &curPhase, &fc, getGraphWaves(bits, size));
 
     if (clock1 >= 0)
         setClockGrid(clock1, firstPhaseShiftLoc);
@@ -254,7 +299,6 @@ int GetPskClock(const char *str, bool verbose) {
     if (verbose)
         PrintAndLogEx(SUCCESS, "Auto-detected clock rate: %d", clock1);
 
-    free(bits);
     return clock1;
 }
 
@@ -268,7 +312,7 @@ int GetNrzClock(const char *str, bool verbose) {
         return clock1;
 
     // Auto-detect clock
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN,  sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         PrintAndLogEx(WARNING, "Failed to allocate memory");
         return -1;
@@ -277,7 +321,6 @@ int GetNrzClock(const char *str, bool verbose) {
     size_t size = getFromGraphBuf(bits);
     if (size == 0) {
         PrintAndLogEx(WARNING, "Failed to copy from graphbuffer");
-        free(bits);
         return -1;
     }
 
@@ -288,7 +331,6 @@ int GetNrzClock(const char *str, bool verbose) {
     if (verbose)
         PrintAndLogEx(SUCCESS, "Auto-detected clock rate: %d", clock1);
 
-    free(bits);
     return clock1;
 }
 
@@ -324,7 +366,7 @@ bool fskClocks(uint8_t *fc1, uint8_t *fc2, uint8_t *rf1, int *firstClockEdge) {
     if (getSignalProperties()->isnoise)
         return false;
 
-    uint8_t *bits = calloc(MAX_GRAPH_TRACE_LEN,  sizeof(uint8_t));
+    uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
     if (bits == NULL) {
         PrintAndLogEx(WARNING, "Failed to allocate memory");
         return false;
@@ -333,22 +375,20 @@ bool fskClocks(uint8_t *fc1, uint8_t *fc2, uint8_t *rf1, int *firstClockEdge) {
     size_t size = getFromGraphBuf(bits);
     if (size == 0) {
         PrintAndLogEx(WARNING, "Failed to copy from graphbuffer");
-        free(bits);
         return false;
     }
 
-    uint16_t ans = countFC(bits, size, true);
+    const lf_waves_t *waves = getGraphWaves(bits, size);
+
+    uint16_t ans = countFC(bits, size, true, waves);
     if (ans == 0) {
         PrintAndLogEx(DEBUG, "DEBUG: No data found");
-        free(bits);
         return false;
     }
 
     *fc1 = (ans >> 8) & 0xFF;
     *fc2 = ans & 0xFF;
-    *rf1 = detectFSKClk(bits, size, *fc1, *fc2, firstClockEdge);
-
-    free(bits);
+    *rf1 = detectFSKClk(bits, size, *fc1, *fc2, firstClockEdge, waves);
 
     if (*rf1 == 0) {
         PrintAndLogEx(DEBUG, "DEBUG: Clock detect error");
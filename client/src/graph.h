@@ -12,6 +12,7 @@
 #define GRAPH_H__
 
 #include "common.h"
+#include "demodctx.h"           // GraphBuffer, MAX_GRAPH_TRACE_LEN
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,11 +22,15 @@ void AppendGraph(bool redraw, uint16_t clock, int bit);
 size_t ClearGraph(bool redraw);
 bool HasGraphData(void);
 void setGraphBuf(uint8_t *buff, size_t size);
+bool reserveGraphBuf(size_t len);
 void save_restoreGB(uint8_t saveOpt);
 size_t getFromGraphBuf(uint8_t *buff);
+size_t getFromGraphBufEx(uint8_t *buff, size_t max);
 void convertGraphFromBitstream(void);
 void convertGraphFromBitstreamEx(int hi, int low);
 bool isGraphBitstream(void);
+signal_t *updateSignalProperties(void);
+const lf_waves_t *getGraphWaves(const uint8_t *bits, size_t size);
 
 int GetAskClock(const char *str, bool verbose);
 int GetPskClock(const char *str, bool verbose);
@@ -34,13 +39,9 @@ int GetNrzClock(const char *str, bool verbose);
 int GetFskClock(const char *str, bool verbose);
 bool fskClocks(uint8_t *fc1, uint8_t *fc2, uint8_t *rf1, int *firstClockEdge);
 
-#define MAX_GRAPH_TRACE_LEN (40000 * 8)
 #define GRAPH_SAVE 1
 #define GRAPH_RESTORE 0
 
-extern int GraphBuffer[MAX_GRAPH_TRACE_LEN];
-extern size_t GraphTraceLen;
-
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,721 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// LF search engine
+//-----------------------------------------------------------------------------
+#include "lfsearch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#include "jansson.h"
+#include "scandir.h"
+
+#include "pm3_cmd.h"        // error codes
+#include "commonutil.h"     // ARRAYLEN
+#include "util.h"           // g_debugMode, binarraytohex
+#include "util_posix.h"     // msclock
+#include "graph.h"          // clock detection
+#include "cmddata.h"        // setClockGrid, loadSamplesPM3
+#include "cmdlfawid.h"
+#include "cmdlfdestron.h"
+#include "cmdlfem4x.h"
+#include "cmdlffdxb.h"
+#include "cmdlfgallagher.h"
+#include "cmdlfguard.h"
+#include "cmdlfhid.h"
+#include "cmdlfidteck.h"
+#include "cmdlfindala.h"
+#include "cmdlfio.h"
+#include "cmdlfjablotron.h"
+#include "cmdlfkeri.h"
+#include "cmdlfnedap.h"
+#include "cmdlfnexwatch.h"
+#include "cmdlfnoralsy.h"
+#include "cmdlfpac.h"
+#include "cmdlfparadox.h"
+#include "cmdlfpresco.h"
+#include "cmdlfpyramid.h"
+#include "cmdlfsecurakey.h"
+#include "cmdlfviking.h"
+#include "cmdlfvisa2000.h"
+
+// demodulators use large buffers on the stack
+#define LF_SEARCH_STACK_SIZE    (8 * 1024 * 1024)
+
+// in the order `lf search` always tried them, decoders prone to false positives come last
+static const lf_search_decoder_t decoders[] = {
+    {"Visa2000 ID",              demodVisa2k,    LF_MOD_ASK},
+    {"FDX-A FECAVA Destron ID",  demodDestron,   LF_MOD_FSK}, // to do before HID
+    {"HID Prox ID",              demodHID,       LF_MOD_FSK},
+    {"AWID ID",                  demodAWID,      LF_MOD_FSK},
+    {"IO Prox ID",               demodIOProx,    LF_MOD_FSK},
+    {"Paradox ID",               demodParadox,   LF_MOD_FSK},
+    {"NexWatch ID",              demodNexWatch,  LF_MOD_PSK},
+    {"Indala ID",                demodIndala,    LF_MOD_PSK},
+    {"EM410x ID",                demodEM410x,    LF_MOD_ASK},
+    {"FDX-B ID",                 demodFDXB,      LF_MOD_ASK},
+    {"Guardall G-Prox II ID",    demodGuard,     LF_MOD_ASK},
+    {"Idteck ID",                demodIdteck,    LF_MOD_PSK},
+    {"Jablotron ID",             demodJablotron, LF_MOD_ASK},
+    {"NEDAP ID",                 demodNedap,     LF_MOD_ASK},
+    {"Noralsy ID",               demodNoralsy,   LF_MOD_ASK},
+    {"KERI ID",                  demodKeri,      LF_MOD_PSK},
+    {"PAC/Stanley ID",           demodPac,       LF_MOD_NRZ},
+    {"Presco ID",                demodPresco,    LF_MOD_ASK},
+    {"Pyramid ID",               demodPyramid,   LF_MOD_FSK},
+    {"Securakey ID",             demodSecurakey, LF_MOD_ASK},
+    {"Viking ID",                demodViking,    LF_MOD_ASK},
+    {"GALLAGHER ID",             demodGallagher, LF_MOD_ASK},
+};
+
+typedef struct {
+    bool found;
+    uint64_t ms;
+    print_capture_t out;
+    demod_ctx_t *ctx;
+} lf_search_slot_t;
+
+typedef struct {
+    const int *samples;
+    size_t len;
+    const signal_t *sigprop;
+    const demod_ctx_t *analysis;        // its edges of the samples are shared, read only
+    lf_search_slot_t *slots;
+    uint8_t next;
+    pthread_mutex_t lock;
+} lf_search_job_t;
+
+const lf_search_decoder_t *lf_search_decoder(uint8_t idx) {
+    return (idx < ARRAYLEN(decoders)) ? &decoders[idx] : NULL;
+}
+
+uint8_t lf_search_decoder_count(void) {
+    return ARRAYLEN(decoders);
+}
+
+// clock detection moves the demod clock, it runs on a scratch context. The
+// edges and the clocks found here go to every decoder with the samples
+static void lf_search_analyse(demod_ctx_t *ctx, lf_search_analysis_t *a) {
+    memset(a, 0, sizeof(lf_search_analysis_t));
+    a->sigprop = ctx->sigprop;
+    if (ctx->sigprop.isnoise)
+        return;
+
+    demod_ctx_t *prev = demod_ctx_select(ctx);
+    uint8_t *bits = demod_ctx_scratch(ctx, ctx->graph_len);
+    if (bits) {
+        size_t size = getFromGraphBuf(bits);
+        if (getGraphWaves(bits, size) == &ctx->waves)
+            lfWavesAnalyse(&ctx->waves, bits, size);
+    }
+
+    print_capture_t out = {0};
+    print_capture_t *prev_out = PrintAndLogCapture(&out);
+    int edge = 0;
+    if (fskClocks(&a->fsk_fc1, &a->fsk_fc2, &a->fsk_clk, &edge) == false) {
+        a->fsk_fc1 = 0;
+        a->fsk_fc2 = 0;
+        a->fsk_clk = 0;
+    }
+    a->ask_clk = GetAskClock("", false);
+    a->nrz_clk = GetNrzClock("", false);
+    a->psk_carrier = GetPskCarrier(false);
+    a->psk_clk = GetPskClock("", false);
+    PrintAndLogCapture(prev_out);
+    PrintAndLogCaptureFree(&out);
+    demod_ctx_select(prev);
+}
+
+// How well the samples fit a match, from what its demod left in the context.
+// 40 points for demodulating with the clock the analysis found for its modulation,
+// 30 for the error bits of its raw demod, each percent of them costs 3 points,
+// 30 for the share of the samples its raw bits cover, 90% counting as all of them
+// since the demods skip the edges, so a decoder that only locks onto a stretch of
+// a capture ranks below one that explains all of it.
+// The FSK tag demods (HID, AWID, IO Prox, Paradox, Pyramid) call lfdemod directly
+// and record no raw bits. Errors and coverage are unknown for them, each scores half
+// its points, so such a match ranks below a raw demod that shows a clean fit.
+static uint8_t lf_search_confidence(const lf_search_analysis_t *a, uint8_t idx, const demod_ctx_t *ctx) {
+    int clk;
+    switch (decoders[idx].mod) {
+        case LF_MOD_FSK:
+            clk = a->fsk_clk;
+            break;
+        case LF_MOD_PSK:
+            clk = a->psk_clk;
+            break;
+        case LF_MOD_NRZ:
+            clk = a->nrz_clk;
+            break;
+        case LF_MOD_ASK:
+        default:
+            clk = a->ask_clk;
+            break;
+    }
+
+    uint8_t score = 0;
+    if (clk > 0 && ctx->demod_clock == clk)
+        score += 40;
+
+    if (ctx->demod_bits == 0 || ctx->graph_len == 0)
+        return score + 15 + 15;
+
+    size_t errors = (ctx->demod_errors * 100) / ctx->demod_bits;
+    if (errors < 10)
+        score += 30 - errors * 3;
+
+    size_t cover = (ctx->demod_bits * ctx->demod_clock * 100) / ctx->graph_len;
+    score += (MIN(cover, 90) * 30) / 90;
+    return score;
+}
+
+static void lf_search_run(lf_search_job_t *job, uint8_t idx, demod_ctx_t *ctx) {
+    lf_search_slot_t *slot = &job->slots[idx];
+
+    if (demod_ctx_load(ctx, job->samples, job->len) != PM3_SUCCESS)
+        return;
+    ctx->sigprop = *job->sigprop;
+    ctx->sigprop_gen = ctx->graph_gen;
+    demod_ctx_share_waves(ctx, job->analysis);
+
+    print_capture_t *prev_out = PrintAndLogCapture(&slot->out);
+    uint64_t t1 = msclock();
+    slot->found = (decoders[idx].demod(true) == PM3_SUCCESS);
+    slot->ms = msclock() - t1;
+    PrintAndLogCapture(prev_out);
+
+    if (slot->found) {
+        slot->ctx = demod_ctx_create();
+        if (slot->ctx && demod_ctx_copy(slot->ctx, ctx) != PM3_SUCCESS) {
+            demod_ctx_free(slot->ctx);
+            slot->ctx = NULL;
+        }
+    }
+}
+
+static void *lf_search_worker(void *arg) {
+    lf_search_job_t *job = (lf_search_job_t *)arg;
+
+    demod_ctx_t *ctx = demod_ctx_create();
+    if (ctx == NULL)
+        return NULL;
+
+    demod_ctx_t *prev = demod_ctx_select(ctx);
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        uint8_t idx = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (idx >= ARRAYLEN(decoders))
+            break;
+
+        lf_search_run(job, idx, ctx);
+    }
+    demod_ctx_select(prev);
+    demod_ctx_free(ctx);
+    return NULL;
+}
+
+int lf_search(const int *samples, size_t len, const signal_t *sigprop, int threads, lf_search_result_t *res) {
+
+    memset(res, 0, sizeof(lf_search_result_t));
+    uint64_t t1 = msclock();
+
+    demod_ctx_t *actx = demod_ctx_create();
+    lf_search_slot_t *slots = calloc(ARRAYLEN(decoders), sizeof(lf_search_slot_t));
+    res->matches = calloc(ARRAYLEN(decoders), sizeof(lf_search_match_t));
+    if (actx == NULL || slots == NULL || res->matches == NULL) {
+        demod_ctx_free(actx);
+        free(slots);
+        free(res->matches);
+        res->matches = NULL;
+        return PM3_EMALLOC;
+    }
+
+    // shared analysis, once
+    if (demod_ctx_load(actx, samples, len) != PM3_SUCCESS) {
+        demod_ctx_free(actx);
+        free(slots);
+        free(res->matches);
+        res->matches = NULL;
+        return PM3_EMALLOC;
+    }
+    actx->sigprop = *sigprop;
+    actx->sigprop_gen = actx->graph_gen;
+    lf_search_analyse(actx, &res->analysis);
+
+    lf_search_job_t job = {
+        .samples = samples,
+        .len = len,
+        .sigprop = sigprop,
+        .analysis = actx,
+        .slots = slots,
+    };
+    pthread_mutex_init(&job.lock, NULL);
+
+    threads = MAX(1, MIN(threads, (int)ARRAYLEN(decoders)));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    int started = 0;
+
+    if (tids) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, LF_SEARCH_STACK_SIZE);
+        // the calling thread works too
+        for (; started < threads - 1; started++) {
+            if (pthread_create(&tids[started], &attr, lf_search_worker, &job) != 0)
+                break;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    lf_search_worker(&job);
+
+    for (int i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    free(tids);
+    pthread_mutex_destroy(&job.lock);
+    demod_ctx_free(actx);
+
+    int ret = PM3_SUCCESS;
+    if (job.next < ARRAYLEN(decoders)) {
+        // not even one demod context could be allocated
+        ret = PM3_EMALLOC;
+    }
+
+    if (g_debugMode) {
+        res->debug = calloc(1, sizeof(print_capture_t));
+    }
+
+    for (uint8_t i = 0; i < ARRAYLEN(decoders); i++) {
+
+        if (res->debug) {
+            // keep every decoder's output, in table order
+            print_capture_t *d = res->debug;
+            print_capture_t *o = &slots[i].out;
+            if (o->len && (d->len + o->len <= d->size || (d->buf = realloc(d->buf, (d->size = d->len + o->len))) != NULL)) {
+                memcpy(d->buf + d->len, o->buf, o->len);
+                d->len += o->len;
+            }
+        }
+
+        if (slots[i].found == false) {
+            PrintAndLogCaptureFree(&slots[i].out);
+            continue;
+        }
+
+        lf_search_match_t *m = &res->matches[res->count++];
+        m->decoder = i;
+        m->confidence = (slots[i].ctx) ? lf_search_confidence(&res->analysis, i, slots[i].ctx) : 0;
+        m->ms = slots[i].ms;
+        m->out = slots[i].out;
+        m->ctx = slots[i].ctx;
+    }
+    free(slots);
+
+    // rank, stable so equal scores keep the table order
+    for (uint8_t i = 1; i < res->count; i++) {
+        lf_search_match_t m = res->matches[i];
+        int j = i - 1;
+        while (j >= 0 && res->matches[j].confidence < m.confidence) {
+            res->matches[j + 1] = res->matches[j];
+            j--;
+        }
+        res->matches[j + 1] = m;
+    }
+
+    res->ms = msclock() - t1;
+    return ret;
+}
+
+int lf_search_sequential(const int *samples, size_t len, const signal_t *sigprop) {
+
+    demod_ctx_t *ctx = demod_ctx_create();
+    if (ctx == NULL)
+        return -1;
+
+    if (demod_ctx_load(ctx, samples, len) != PM3_SUCCESS) {
+        demod_ctx_free(ctx);
+        return -1;
+    }
+    demod_ctx_t *prev = demod_ctx_select(ctx);
+    ctx->sigprop = *sigprop;
+    ctx->sigprop_gen = ctx->graph_gen;
+
+    int found = -1;
+    print_capture_t out = {0};
+    print_capture_t *prev_out = PrintAndLogCapture(&out);
+    for (uint8_t i = 0; i < ARRAYLEN(decoders); i++) {
+        if (decoders[i].demod(true) == PM3_SUCCESS) {
+            found = i;
+            break;
+        }
+    }
+    PrintAndLogCapture(prev_out);
+    PrintAndLogCaptureFree(&out);
+
+    demod_ctx_select(prev);
+    demod_ctx_free(ctx);
+    return found;
+}
+
+int lf_search_verify(const int *samples, size_t len, const signal_t *sigprop, int threads) {
+
+    lf_search_result_t res;
+    if (lf_search(samples, len, sigprop, MAX(2, threads), &res) != PM3_SUCCESS) {
+        lf_search_free(&res);
+        return -1;
+    }
+
+    demod_ctx_t *ctx = demod_ctx_create();
+    if (ctx == NULL) {
+        lf_search_free(&res);
+        return -1;
+    }
+
+    demod_ctx_t *prev = demod_ctx_select(ctx);
+    print_capture_t out = {0};
+    print_capture_t *prev_out = PrintAndLogCapture(&out);
+
+    int diff = 0;
+    for (uint8_t i = 0; i < ARRAYLEN(decoders); i++) {
+
+        const demod_ctx_t *m = NULL;
+        bool matched = false;
+        for (uint8_t j = 0; j < res.count; j++) {
+            if (res.matches[j].decoder == i) {
+                m = res.matches[j].ctx;
+                matched = true;
+            }
+        }
+
+        if (demod_ctx_load(ctx, samples, len) != PM3_SUCCESS) {
+            diff = -1;
+            break;
+        }
+        ctx->sigprop = *sigprop;
+        ctx->sigprop_gen = ctx->graph_gen;
+
+        bool found = (decoders[i].demod(true) == PM3_SUCCESS);
+        if (found != matched) {
+            diff++;
+        } else if (found && m && (m->demod_len != ctx->demod_len
+                                  || m->demod_clock != ctx->demod_clock
+                                  || m->demod_start_idx != ctx->demod_start_idx
+                                  || memcmp(m->demod, ctx->demod, ctx->demod_len) != 0)) {
+            diff++;
+        }
+    }
+
+    PrintAndLogCapture(prev_out);
+    PrintAndLogCaptureFree(&out);
+    demod_ctx_select(prev);
+    demod_ctx_free(ctx);
+    lf_search_free(&res);
+    return diff;
+}
+
+void lf_search_print(lf_search_result_t *res, bool verbose) {
+
+    if (res->debug)
+        PrintAndLogReplay(res->debug);
+
+    for (uint8_t i = 0; i < res->count; i++) {
+        lf_search_match_t *m = &res->matches[i];
+        if (res->debug == NULL)
+            PrintAndLogReplay(&m->out);
+        PrintAndLogEx(SUCCESS, "\nValid " _GREEN_("%s") " found!", decoders[m->decoder].name);
+    }
+
+    if (res->count == 0)
+        return;
+
+    // the best match leaves its demod buffer behind, as if it had run alone
+    lf_search_match_t *best = &res->matches[0];
+    if (best->ctx && demod_ctx_copy(demod_ctx(), best->ctx) == PM3_SUCCESS) {
+        setClockGrid(g_DemodClock, g_DemodStartIdx);
+    }
+
+    if (verbose && res->count > 1) {
+        PrintAndLogEx(NORMAL, "");
+        PrintAndLogEx(INFO, "%u matches, most likely first", res->count);
+        for (uint8_t i = 0; i < res->count; i++) {
+            lf_search_match_t *m = &res->matches[i];
+            PrintAndLogEx(INFO, "  %-24s confidence " _YELLOW_("%3u") "  ( %" PRIu64 " ms )", decoders[m->decoder].name, m->confidence, m->ms);
+        }
+    }
+}
+
+void lf_search_free(lf_search_result_t *res) {
+    for (uint8_t i = 0; res->matches && i < res->count; i++) {
+        PrintAndLogCaptureFree(&res->matches[i].out);
+        demod_ctx_free(res->matches[i].ctx);
+    }
+    free(res->matches);
+    res->matches = NULL;
+    res->count = 0;
+
+    if (res->debug) {
+        PrintAndLogCaptureFree(res->debug);
+        free(res->debug);
+        res->debug = NULL;
+    }
+}
+
+typedef struct {
+    char **files;
+    int count;
+    FILE *out;
+    char **records;         // JSON per file, written out in file order as they complete
+    int next;
+    int emitted;
+    int matched;
+    int failed;
+    pthread_mutex_t lock;
+} lf_batch_job_t;
+
+// the decoder output as a list of lines, without the empty ones
+static json_t *lf_batch_lines(const print_capture_t *cap) {
+    json_t *lines = json_array();
+    for (size_t pos = 0; cap->buf && pos < cap->len; pos += strlen(cap->buf + pos) + 1) {
+        size_t n = strlen(cap->buf + pos) + 1;
+        char *entry = calloc(n, sizeof(char));
+        if (entry == NULL)
+            break;
+        memcpy_filter_ansi(entry, cap->buf + pos, n, true);
+        char *save = NULL;
+        for (char *line = strtok_r(entry, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+            if (strlen(line))
+                json_array_append_new(lines, json_string(line));
+        }
+        free(entry);
+    }
+    return lines;
+}
+
+static char *lf_batch_decode(const char *path, demod_ctx_t *ctx, bool *matched, bool *failed) {
+
+    json_t *rec = json_object();
+    json_object_set_new(rec, "file", json_string(path));
+
+    uint64_t t1 = msclock();
+
+    // nothing but the JSON records goes to the console
+    print_capture_t out = {0};
+    print_capture_t *prev_out = PrintAndLogCapture(&out);
+
+    int res = loadSamplesPM3(path);
+    if (res != PM3_SUCCESS) {
+        *failed = true;
+        json_object_set_new(rec, "status", json_string("error"));
+        json_object_set_new(rec, "error", json_string((res == PM3_EFILE) ? "couldn't open file" : "out of memory"));
+    } else if (ctx->graph_len < 2000) {
+        *failed = true;
+        json_object_set_new(rec, "status", json_string("error"));
+        json_object_set_new(rec, "error", json_string("too few samples"));
+        json_object_set_new(rec, "samples", json_integer(ctx->graph_len));
+    } else {
+        json_object_set_new(rec, "samples", json_integer(ctx->graph_len));
+
+        lf_search_result_t sr;
+        res = lf_search(ctx->graph, ctx->graph_len, &ctx->sigprop, 1, &sr);
+        if (res != PM3_SUCCESS) {
+            *failed = true;
+            json_object_set_new(rec, "status", json_string("error"));
+            json_object_set_new(rec, "error", json_string("out of memory"));
+        } else if (sr.count == 0) {
+            json_object_set_new(rec, "status", json_string("no tag"));
+        } else {
+            *matched = true;
+            lf_search_match_t *best = &sr.matches[0];
+            json_object_set_new(rec, "status", json_string("ok"));
+            json_object_set_new(rec, "protocol", json_string(decoders[best->decoder].name));
+            if (best->ctx) {
+                // the raw frame the decoder left in the demod buffer
+                char hex[512] = {0};
+                binarraytohex(hex, sizeof(hex), (char *)best->ctx->demod, best->ctx->demod_len);
+                json_object_set_new(rec, "id", json_string(hex));
+                json_object_set_new(rec, "clock", json_integer(best->ctx->demod_clock));
+                json_object_set_new(rec, "start", json_integer(best->ctx->demod_start_idx));
+            }
+            json_object_set_new(rec, "confidence", json_integer(best->confidence));
+
+            json_t *others = json_array();
+            for (uint8_t i = 1; i < sr.count; i++)
+                json_array_append_new(others, json_string(decoders[sr.matches[i].decoder].name));
+            json_object_set_new(rec, "others", others);
+            json_object_set_new(rec, "output", lf_batch_lines(&best->out));
+        }
+        lf_search_free(&sr);
+    }
+
+    PrintAndLogCapture(prev_out);
+    PrintAndLogCaptureFree(&out);
+
+    json_object_set_new(rec, "ms", json_integer(msclock() - t1));
+
+    char *s = json_dumps(rec, JSON_COMPACT | JSON_PRESERVE_ORDER);
+    json_decref(rec);
+    return s;
+}
+
+static void *lf_batch_worker(void *arg) {
+    lf_batch_job_t *job = (lf_batch_job_t *)arg;
+
+    demod_ctx_t *ctx = demod_ctx_create();
+    if (ctx == NULL)
+        return NULL;
+
+    demod_ctx_t *prev = demod_ctx_select(ctx);
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int idx = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (idx >= job->count)
+            break;
+
+        bool matched = false, failed = false;
+        char *rec = lf_batch_decode(job->files[idx], ctx, &matched, &failed);
+
+        pthread_mutex_lock(&job->lock);
+        job->records[idx] = (rec) ? rec : strdup("{}");
+        job->matched += matched;
+        job->failed += failed;
+        while (job->emitted < job->count && job->records[job->emitted]) {
+            fprintf(job->out, "%s\n", job->records[job->emitted]);
+            free(job->records[job->emitted]);
+            job->records[job->emitted] = NULL;
+            job->emitted++;
+        }
+        fflush(job->out);
+        pthread_mutex_unlock(&job->lock);
+    }
+    demod_ctx_select(prev);
+    demod_ctx_free(ctx);
+    return NULL;
+}
+
+static int lf_batch_collect(const char *path, char ***files, int *count, int *size) {
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        // the .pm3 files of a directory, not recursive
+        struct dirent **namelist;
+        int n = scandir(path, &namelist, NULL, alphasort);
+        if (n < 0)
+            return PM3_EFILE;
+
+        for (int i = 0; i < n; i++) {
+            if (str_endswith(namelist[i]->d_name, ".pm3")) {
+                char *full = calloc(strlen(path) + strlen(namelist[i]->d_name) + 2, sizeof(char));
+                if (full) {
+                    sprintf(full, "%s%s%s", path, str_endswith(path, "/") ? "" : "/", namelist[i]->d_name);
+                    lf_batch_collect(full, files, count, size);
+                    free(full);
+                }
+            }
+            free(namelist[i]);
+        }
+        free(namelist);
+        return PM3_SUCCESS;
+    }
+
+    if (*count == *size) {
+        *size = MAX(*size * 2, 64);
+        char **tmp = realloc(*files, *size * sizeof(char *));
+        if (tmp == NULL)
+            return PM3_EMALLOC;
+        *files = tmp;
+    }
+    (*files)[*count] = strdup(path);
+    if ((*files)[*count] == NULL)
+        return PM3_EMALLOC;
+    (*count)++;
+    return PM3_SUCCESS;
+}
+
+int lf_search_batch(char **paths, int npaths, int threads, FILE *out) {
+
+    lf_batch_job_t job = {
+        .out = out,
+    };
+    int size = 0;
+    for (int i = 0; i < npaths; i++) {
+        if (lf_batch_collect(paths[i], &job.files, &job.count, &size) == PM3_EMALLOC)
+            break;
+    }
+
+    if (job.count == 0) {
+        free(job.files);
+        return PM3_EINVARG;
+    }
+
+    job.records = calloc(job.count, sizeof(char *));
+    if (job.records == NULL) {
+        for (int i = 0; i < job.count; i++)
+            free(job.files[i]);
+        free(job.files);
+        return PM3_EMALLOC;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+
+    uint64_t t1 = msclock();
+
+    // files spread over the threads, each file searched on one
+    threads = MAX(1, MIN(threads, job.count));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    int started = 0;
+    if (tids) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, LF_SEARCH_STACK_SIZE);
+        for (; started < threads; started++) {
+            if (pthread_create(&tids[started], &attr, lf_batch_worker, &job) != 0)
+                break;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    // no thread, decode here
+    if (started == 0)
+        lf_batch_worker(&job);
+
+    for (int i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    free(tids);
+
+    uint64_t ms = msclock() - t1;
+
+    json_t *summary = json_object();
+    json_object_set_new(summary, "files", json_integer(job.count));
+    json_object_set_new(summary, "matched", json_integer(job.matched));
+    json_object_set_new(summary, "errors", json_integer(job.failed));
+    json_object_set_new(summary, "threads", json_integer(MAX(started, 1)));
+    json_object_set_new(summary, "ms", json_integer(ms));
+    json_object_set_new(summary, "files_per_sec", json_real((ms) ? job.count * 1000.0 / ms : job.count * 1000.0));
+    json_t *root = json_object();
+    json_object_set_new(root, "summary", summary);
+    char *s = json_dumps(root, JSON_COMPACT | JSON_PRESERVE_ORDER);
+    if (s) {
+        fprintf(out, "%s\n", s);
+        free(s);
+    }
+    json_decref(root);
+    fflush(out);
+
+    int ret = (job.emitted == job.count) ? PM3_SUCCESS : PM3_EMALLOC;
+    for (int i = 0; i < job.count; i++) {
+        free(job.files[i]);
+        free(job.records[i]);
+    }
+    free(job.files);
+    free(job.records);
+    pthread_mutex_destroy(&job.lock);
+    return ret;
+}
@@ -0,0 +1,89 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// LF search engine
+//
+// Runs all known tag demodulators over one set of samples. The signal is
+// analysed once (signal properties, edges, ASK / FSK / PSK / NRZ clocks) and the
+// demodulators, each on its own demod context on a pool of threads with its
+// output captured, reuse those clocks instead of detecting them again. Matches
+// are ranked by confidence: clock fit, raw demod errors and how much of the
+// samples the raw bits cover, with half marks for the last two when a demod
+// records no raw bits. Ties keep the order of the decoder table, so the
+// result doesn't depend on thread scheduling.
+//-----------------------------------------------------------------------------
+
+#ifndef LFSEARCH_H__
+#define LFSEARCH_H__
+
+#include <stdio.h>
+#include "common.h"
+#include "ui.h"                 // print_capture_t
+#include "demodctx.h"
+
+typedef enum {
+    LF_MOD_ASK,
+    LF_MOD_FSK,
+    LF_MOD_PSK,
+    LF_MOD_NRZ,
+} lf_modulation_t;
+
+typedef struct {
+    const char *name;
+    int (*demod)(bool verbose);
+    lf_modulation_t mod;
+} lf_search_decoder_t;
+
+typedef struct {
+    signal_t sigprop;
+    int ask_clk;
+    int nrz_clk;
+    int psk_clk;
+    int psk_carrier;
+    uint8_t fsk_fc1;
+    uint8_t fsk_fc2;
+    uint8_t fsk_clk;
+} lf_search_analysis_t;
+
+typedef struct {
+    uint8_t decoder;            // index in the decoder table
+    uint8_t confidence;         // 0 - 100
+    uint64_t ms;                // time spent in the demodulator
+    print_capture_t out;
+    demod_ctx_t *ctx;           // demod state the match left behind
+} lf_search_match_t;
+
+typedef struct {
+    lf_search_analysis_t analysis;
+    lf_search_match_t *matches; // ranked, best first
+    uint8_t count;
+    print_capture_t *debug;     // output of all decoders in table order, when client debug is on
+    uint64_t ms;
+} lf_search_result_t;
+
+const lf_search_decoder_t *lf_search_decoder(uint8_t idx);
+uint8_t lf_search_decoder_count(void);
+
+// searches samples for known tags using up to threads workers. Doesn't touch the current demod context
+int lf_search(const int *samples, size_t len, const signal_t *sigprop, int threads, lf_search_result_t *res);
+
+// the decoders one after another, stopping at the first match, like `lf search` always did.
+// Returns the matching decoder index, or -1
+int lf_search_sequential(const int *samples, size_t len, const signal_t *sigprop);
+
+// runs the search on at least two threads, then every decoder alone on a fresh context, and compares
+// found / not found and the demod buffer each one left. Returns the number of decoders that disagree, -1 on error
+int lf_search_verify(const int *samples, size_t len, const signal_t *sigprop, int threads);
+
+// prints the matches, best first, and leaves the demod state of the best one in the current context
+void lf_search_print(lf_search_result_t *res, bool verbose);
+void lf_search_free(lf_search_result_t *res);
+
+// Headless decoding of .pm3 sample files, directories are searched for *.pm3. Each file gets its own
+// demod context, files are spread over the threads. Writes one JSON line per file, in the given
+// order, then a summary line with the throughput
+int lf_search_batch(char **paths, int npaths, int threads, FILE *out);
+
+#endif
@@ -0,0 +1,780 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// LF live decoding
+//-----------------------------------------------------------------------------
+#include "lfstream.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <inttypes.h>
+
+#include "pm3_cmd.h"        // error codes, lf_stream_data_t
+#include "ui.h"
+#include "util.h"           // num_CPUs
+#include "graph.h"          // getFromGraphBuf
+#include "lfdemod.h"        // computeSignalProperties
+#include "demodctx.h"
+#include "lfsearch.h"
+#include "cmdlft55xx.h"
+#include "cmdlfem4x05.h"
+#include "cmddata.h"        // loadSamplesPM3, FSKrawDemod, PSKDemod, NRZrawDemod
+
+// the decoders see the samples cut at these positions, whatever size the blocks came in
+#define LF_STREAM_STEP      512
+
+// a shorter tail isn't worth searching at the end of the stream
+#define LF_STREAM_MIN_TAIL  2000
+
+typedef struct {
+    uint8_t decoder;
+    char id[128];
+} lf_stream_tag_t;
+
+struct lf_stream_s {
+    uint8_t decoders;
+    size_t count;               // samples fed so far
+    uint32_t frames;
+
+    t55xx_sniff_t t55;
+    size_t t55_base;            // stream index of the first sample the sniffers saw
+    em4x05_sniff_t em;
+    size_t em_base;
+
+    int *window;
+    size_t window_len;
+    size_t window_start;        // stream index of window[0]
+    size_t searched;            // stream index up to where the window was searched
+    demod_ctx_t *ctx;
+    lf_stream_tag_t *seen;      // tags of the last window, reported again only when they went away
+    uint8_t seen_count;
+
+    // raw demod
+    lf_modulation_t mod;
+    size_t detect;
+    uint8_t *head;              // samples the clock is detected on
+    size_t head_len;
+    bool demod_on;
+    bool demod_failed;          // nothing to demod until the next gap
+    union {
+        fsk_stream_t fsk;
+        ask_stream_t ask;
+        nrz_stream_t nrz;
+        psk_stream_t psk;
+    } dm;
+    int demod_clk;
+    size_t demod_base;          // stream index of the first sample the demod saw
+    size_t demod_bits;          // bits of the current demod run
+    uint64_t bits;
+    char line[65];
+    size_t line_len;
+    const uint8_t *check;
+    size_t check_len;
+    size_t checked;
+    size_t mismatch;
+};
+
+static void lf_stream_t55xx(const t55xx_sniff_frame_t *f, void *arg) {
+    lf_stream_t *s = (lf_stream_t *)arg;
+    s->frames++;
+    PrintAndLogEx(SUCCESS, "%9zu | T55xx  | %-20s | pwd " _GREEN_("%8s") " | data " _GREEN_("%8s") " | blk " _GREEN_("%d") " | page " _GREEN_("%d")
+                  , s->t55_base + f->offset
+                  , f->mode
+                  , f->pwd
+                  , f->data
+                  , f->blk
+                  , f->page
+                 );
+}
+
+static void lf_stream_em4x05(const em4x05_sniff_frame_t *f, void *arg) {
+    lf_stream_t *s = (lf_stream_t *)arg;
+    s->frames++;
+    PrintAndLogEx(SUCCESS, "%9zu | EM4x05 | %-20s |              data " _GREEN_("%8s") " | blk " _GREEN_("%3s")
+                  , s->em_base + f->offset
+                  , f->cmd
+                  , f->data
+                  , f->blk
+                 );
+}
+
+static void lf_stream_reset(lf_stream_t *s) {
+    t55xx_sniff_init(&s->t55, 0, 0, 5, lf_stream_t55xx, s);
+    s->t55_base = s->count;
+    em4x05_sniff_init(&s->em, false, lf_stream_em4x05, s);
+    s->em_base = s->count;
+    s->window_len = 0;
+    s->window_start = s->count;
+    s->searched = s->count;
+    s->seen_count = 0;
+    s->head_len = 0;
+    s->demod_on = false;
+    s->demod_failed = false;
+    s->demod_base = s->count;
+    s->demod_bits = 0;
+    s->line_len = 0;
+}
+
+lf_stream_t *lf_stream_create(uint8_t decoders) {
+    lf_stream_t *s = calloc(1, sizeof(lf_stream_t));
+    if (s == NULL)
+        return NULL;
+
+    s->decoders = decoders;
+    if (decoders & LF_STREAM_TAGS) {
+        s->window = calloc(LF_STREAM_WINDOW, sizeof(int));
+        s->seen = calloc(lf_search_decoder_count(), sizeof(lf_stream_tag_t));
+        s->ctx = demod_ctx_create();
+        if (s->window == NULL || s->seen == NULL || s->ctx == NULL) {
+            lf_stream_free(s);
+            return NULL;
+        }
+    }
+    lf_stream_reset(s);
+    return s;
+}
+
+void lf_stream_free(lf_stream_t *s) {
+    if (s == NULL)
+        return;
+    free(s->window);
+    free(s->seen);
+    free(s->head);
+    demod_ctx_free(s->ctx);
+    free(s);
+}
+
+int lf_stream_demod(lf_stream_t *s, lf_modulation_t mod, size_t detect) {
+    if (detect == 0)
+        return PM3_EINVARG;
+
+    uint8_t *head = realloc(s->head, detect);
+    if (head == NULL)
+        return PM3_EMALLOC;
+    s->head = head;
+
+    if (s->ctx == NULL) {
+        s->ctx = demod_ctx_create();
+        if (s->ctx == NULL)
+            return PM3_EMALLOC;
+    }
+    s->decoders |= LF_STREAM_DEMOD;
+    s->mod = mod;
+    s->detect = detect;
+    s->mismatch = SIZE_MAX;
+    lf_stream_reset(s);
+    return PM3_SUCCESS;
+}
+
+void lf_stream_check(lf_stream_t *s, const uint8_t *bits, size_t len) {
+    s->check = bits;
+    s->check_len = len;
+    s->checked = 0;
+    s->mismatch = SIZE_MAX;
+}
+
+// the line of the decoder output that tells the id, the first one with a value in it.
+// Without colors and prompt
+static void lf_stream_id_line(const print_capture_t *cap, char *dst, size_t size) {
+    dst[0] = 0;
+    for (size_t pos = 0; cap->buf && pos < cap->len; pos += strlen(cap->buf + pos) + 1) {
+        char entry[256];
+        memcpy_filter_ansi(entry, cap->buf + pos, MIN(strlen(cap->buf + pos) + 1, sizeof(entry)), true);
+        entry[sizeof(entry) - 1] = 0;
+
+        char *save = NULL;
+        for (char *line = strtok_r(entry, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+            if (line[0] == '[' && strlen(line) > 3 && line[2] == ']')
+                line += 3;
+            while (*line == ' ')
+                line++;
+
+            size_t n = MIN(strlen(line), size - 1);
+            if (n == 0)
+                continue;
+
+            // first line as fallback
+            if (dst[0] == 0 || strchr(line, ':')) {
+                memcpy(dst, line, n);
+                dst[n] = 0;
+            }
+            if (strchr(line, ':'))
+                return;
+        }
+    }
+}
+
+static bool lf_stream_seen(const lf_stream_tag_t *tags, uint8_t count, uint8_t decoder, const char *id) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (tags[i].decoder == decoder && strcmp(tags[i].id, id) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void lf_stream_search(lf_stream_t *s) {
+
+    s->searched = s->window_start + s->window_len;
+    if (demod_ctx_load(s->ctx, s->window, s->window_len) != PM3_SUCCESS)
+        return;
+
+    demod_ctx_t *prev = demod_ctx_select(s->ctx);
+    updateSignalProperties();
+    demod_ctx_select(prev);
+
+    lf_search_result_t res;
+    if (lf_search(s->ctx->graph, s->ctx->graph_len, &s->ctx->sigprop, num_CPUs(), &res) != PM3_SUCCESS) {
+        lf_search_free(&res);
+        return;
+    }
+
+    // every tag in the window, the ones already in the last window were reported then
+    lf_stream_tag_t *tags = calloc(lf_search_decoder_count(), sizeof(lf_stream_tag_t));
+    uint8_t count = 0;
+    for (uint8_t i = 0; tags && i < res.count; i++) {
+        lf_search_match_t *m = &res.matches[i];
+        lf_stream_tag_t *t = &tags[count++];
+        t->decoder = m->decoder;
+        lf_stream_id_line(&m->out, t->id, sizeof(t->id));
+
+        if (lf_stream_seen(s->seen, s->seen_count, t->decoder, t->id))
+            continue;
+
+        s->frames++;
+        size_t offset = s->window_start + ((m->ctx) ? m->ctx->demod_start_idx : 0);
+        PrintAndLogEx(SUCCESS, "%9zu | Tag    | " _GREEN_("%-20s") " | %s", offset, lf_search_decoder(t->decoder)->name, t->id);
+    }
+    lf_search_free(&res);
+
+    if (tags) {
+        free(s->seen);
+        s->seen = tags;
+        s->seen_count = count;
+    }
+}
+
+static void lf_stream_window(lf_stream_t *s, const int *samples, size_t len) {
+    while (len) {
+        size_t n = MIN(len, LF_STREAM_WINDOW - s->window_len);
+        memcpy(s->window + s->window_len, samples, n * sizeof(int));
+        s->window_len += n;
+        samples += n;
+        len -= n;
+
+        if (s->window_len == LF_STREAM_WINDOW) {
+            lf_stream_search(s);
+            // keep the overlap
+            memmove(s->window, s->window + LF_STREAM_HOP, (LF_STREAM_WINDOW - LF_STREAM_HOP) * sizeof(int));
+            s->window_len -= LF_STREAM_HOP;
+            s->window_start += LF_STREAM_HOP;
+        }
+    }
+}
+
+static const char *lf_stream_mod_name(lf_modulation_t mod) {
+    switch (mod) {
+        case LF_MOD_ASK:
+            return "ASK";
+        case LF_MOD_FSK:
+            return "FSK";
+        case LF_MOD_PSK:
+            return "PSK1";
+        case LF_MOD_NRZ:
+            return "NRZ";
+    }
+    return "";
+}
+
+static int lf_stream_demod_start_idx(lf_stream_t *s) {
+    switch (s->mod) {
+        case LF_MOD_ASK:
+            return s->dm.ask.start_idx;
+        case LF_MOD_FSK:
+            return s->dm.fsk.start_idx;
+        case LF_MOD_PSK:
+            return s->dm.psk.start_idx;
+        case LF_MOD_NRZ:
+            return s->dm.nrz.start_idx;
+    }
+    return 0;
+}
+
+// a line of bits, at the sample where its first bit starts
+static void lf_stream_demod_line(lf_stream_t *s) {
+    if (s->line_len == 0)
+        return;
+
+    s->line[s->line_len] = 0;
+    size_t first = s->demod_bits - s->line_len;
+    int start = lf_stream_demod_start_idx(s);
+    // ask/raw has two bits a clock
+    size_t step = (s->mod == LF_MOD_ASK) ? s->demod_clk / 2 : s->demod_clk;
+    size_t offset = s->demod_base + ((start > 0) ? start : 0) + first * step;
+    PrintAndLogEx(SUCCESS, "%9zu | %-6s | %s", offset, lf_stream_mod_name(s->mod), s->line);
+    s->line_len = 0;
+}
+
+static void lf_stream_bits(const uint8_t *bits, size_t len, void *arg) {
+    lf_stream_t *s = (lf_stream_t *)arg;
+    for (size_t i = 0; i < len; i++) {
+        if (s->check && s->checked < s->check_len) {
+            if (s->mismatch == SIZE_MAX && bits[i] != s->check[s->checked])
+                s->mismatch = s->checked;
+            s->checked++;
+        }
+
+        s->line[s->line_len++] = '0' + bits[i];
+        s->demod_bits++;
+        s->bits++;
+        if (s->line_len == sizeof(s->line) - 1)
+            lf_stream_demod_line(s);
+    }
+}
+
+static void lf_stream_demod_feed(lf_stream_t *s, const uint8_t *samples, size_t len) {
+    switch (s->mod) {
+        case LF_MOD_ASK:
+            ask_stream_feed(&s->dm.ask, samples, len);
+            break;
+        case LF_MOD_FSK:
+            fsk_stream_feed(&s->dm.fsk, samples, len);
+            break;
+        case LF_MOD_PSK:
+            psk_stream_feed(&s->dm.psk, samples, len);
+            break;
+        case LF_MOD_NRZ:
+            nrz_stream_feed(&s->dm.nrz, samples, len);
+            break;
+    }
+}
+
+// clock and thresholds from the first samples, then the demod catches up with them
+static void lf_stream_demod_setup(lf_stream_t *s) {
+
+    demod_ctx_t *prev = demod_ctx_select(s->ctx);
+    demod_ctx_reset(s->ctx);
+    computeSignalProperties(s->head, s->head_len);
+
+    int res = PM3_ESOFT;
+    switch (s->mod) {
+        case LF_MOD_ASK:
+            res = ask_stream_setup(&s->dm.ask, s->head, s->head_len, 0, 0, 100, 0, 0, lf_stream_bits, s);
+            s->demod_clk = s->dm.ask.clk;
+            break;
+        case LF_MOD_FSK:
+            res = fsk_stream_setup(&s->dm.fsk, s->head, s->head_len, 0, 0, 0, 0, lf_stream_bits, s);
+            s->demod_clk = s->dm.fsk.clk;
+            break;
+        case LF_MOD_PSK:
+            res = psk_stream_setup(&s->dm.psk, s->head, s->head_len, 0, 0, lf_stream_bits, s);
+            s->demod_clk = s->dm.psk.clock;
+            break;
+        case LF_MOD_NRZ:
+            res = nrz_stream_setup(&s->dm.nrz, s->head, s->head_len, 0, 0, lf_stream_bits, s);
+            s->demod_clk = s->dm.nrz.clk;
+            break;
+    }
+    demod_ctx_select(prev);
+
+    if (res != PM3_SUCCESS) {
+        PrintAndLogEx(INFO, "%9zu | %-6s | no signal found", s->demod_base, lf_stream_mod_name(s->mod));
+        s->demod_failed = true;
+        return;
+    }
+
+    s->demod_on = true;
+    PrintAndLogEx(SUCCESS, "%9zu | %-6s | clock " _YELLOW_("RF/%d"), s->demod_base, lf_stream_mod_name(s->mod), s->demod_clk);
+    lf_stream_demod_feed(s, s->head, s->head_len);
+}
+
+static void lf_stream_demod_samples(lf_stream_t *s, const int *samples, size_t len) {
+    if (s->demod_failed)
+        return;
+
+    // same conversion as getFromGraphBuf
+    uint8_t bits[LF_STREAM_STEP];
+    for (size_t i = 0; i < len; i++) {
+        int v = samples[i];
+        if (v > 127) v = 127;
+        if (v < -127) v = -127;
+        bits[i] = (uint8_t)(v + 128);
+    }
+
+    if (s->demod_on) {
+        lf_stream_demod_feed(s, bits, len);
+        return;
+    }
+
+    size_t n = MIN(len, s->detect - s->head_len);
+    memcpy(s->head + s->head_len, bits, n);
+    s->head_len += n;
+    if (s->head_len < s->detect)
+        return;
+
+    lf_stream_demod_setup(s);
+    if (s->demod_on && n < len)
+        lf_stream_demod_feed(s, bits + n, len - n);
+}
+
+static void lf_stream_demod_finish(lf_stream_t *s) {
+    // stream shorter than the detection
+    if (s->demod_on == false && s->demod_failed == false && s->head_len)
+        lf_stream_demod_setup(s);
+
+    if (s->demod_on) {
+        switch (s->mod) {
+            case LF_MOD_ASK:
+                ask_stream_finish(&s->dm.ask);
+                break;
+            case LF_MOD_FSK:
+                fsk_stream_finish(&s->dm.fsk);
+                break;
+            case LF_MOD_PSK:
+                psk_stream_finish(&s->dm.psk);
+                if (s->dm.psk.failed)
+                    PrintAndLogEx(WARNING, "%9zu | %-6s | too many short waves, gave up", s->demod_base, lf_stream_mod_name(s->mod));
+                break;
+            case LF_MOD_NRZ:
+                nrz_stream_finish(&s->dm.nrz);
+                break;
+        }
+        lf_stream_demod_line(s);
+    }
+}
+
+void lf_stream_feed(lf_stream_t *s, const int *samples, size_t len) {
+    while (len) {
+        size_t n = MIN(len, LF_STREAM_STEP - (s->count % LF_STREAM_STEP));
+
+        if (s->decoders & LF_STREAM_T55XX)
+            t55xx_sniff_feed(&s->t55, samples, n);
+        if (s->decoders & LF_STREAM_EM4X05)
+            em4x05_sniff_feed(&s->em, samples, n);
+        if (s->decoders & LF_STREAM_TAGS)
+            lf_stream_window(s, samples, n);
+        if (s->decoders & LF_STREAM_DEMOD)
+            lf_stream_demod_samples(s, samples, n);
+
+        s->count += n;
+        samples += n;
+        len -= n;
+    }
+}
+
+void lf_stream_gap(lf_stream_t *s) {
+    if (s->decoders & LF_STREAM_T55XX)
+        t55xx_sniff_finish(&s->t55);
+    if (s->decoders & LF_STREAM_EM4X05)
+        em4x05_sniff_finish(&s->em);
+    if (s->decoders & LF_STREAM_DEMOD)
+        lf_stream_demod_finish(s);
+    lf_stream_reset(s);
+}
+
+void lf_stream_finish(lf_stream_t *s) {
+    if (s->decoders & LF_STREAM_T55XX)
+        t55xx_sniff_finish(&s->t55);
+    if (s->decoders & LF_STREAM_EM4X05)
+        em4x05_sniff_finish(&s->em);
+    if ((s->decoders & LF_STREAM_TAGS) && s->window_len >= LF_STREAM_MIN_TAIL && s->count > s->searched)
+        lf_stream_search(s);
+    if (s->decoders & LF_STREAM_DEMOD)
+        lf_stream_demod_finish(s);
+
+    PrintAndLogEx(SUCCESS, "decoded " _YELLOW_("%u") " frames in " _YELLOW_("%zu") " samples", s->frames, s->count);
+
+    if (s->decoders & LF_STREAM_DEMOD) {
+        PrintAndLogEx(SUCCESS, "demodulated " _YELLOW_("%" PRIu64) " %s bits", s->bits, lf_stream_mod_name(s->mod));
+        if (s->check == NULL) {
+            // no reference
+        } else if (s->check_len == 0) {
+            PrintAndLogEx(INFO, "the batch demod found no bits");
+        } else if (s->mismatch != SIZE_MAX) {
+            PrintAndLogEx(FAILED, "bitstream " _RED_("differs") " from the batch demod at bit " _YELLOW_("%zu"), s->mismatch);
+        } else if (s->checked < s->check_len) {
+            PrintAndLogEx(FAILED, "bitstream " _RED_("ends") " after " _YELLOW_("%zu") " bits, the batch demod has " _YELLOW_("%zu"), s->checked, s->check_len);
+        } else {
+            PrintAndLogEx(SUCCESS, "bitstream " _GREEN_("identical") " to the batch demod, " _YELLOW_("%zu") " bits compared", s->checked);
+        }
+    }
+}
+
+static lf_stream_t *g_lf_stream = NULL;
+static uint32_t g_lf_stream_next = 0;
+static uint16_t g_lf_stream_overruns = 0;
+
+// Blocks queue here for the decoder thread. The comms thread only copies them
+// in and never waits, when the ring is full the block is dropped and the
+// decoders see the gap. The replay waits for room instead
+#define LF_STREAM_RING      256
+
+typedef struct {
+    uint32_t start;
+    uint16_t overruns;
+    uint16_t len;
+    uint8_t samples[LF_STREAM_BLOCK_SAMPLES];
+} lf_stream_block_t;
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t data;        // blocks queued or stop
+    pthread_cond_t room;        // a block taken by the decoder thread
+    lf_stream_block_t *blocks;
+    size_t head;                // next block to decode
+    size_t count;
+    uint32_t dropped;
+    bool running;
+    bool stop;
+} g_lf_ring = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .data = PTHREAD_COND_INITIALIZER,
+    .room = PTHREAD_COND_INITIALIZER,
+};
+
+static void lf_stream_block(const lf_stream_block_t *blk) {
+    if (blk->overruns != g_lf_stream_overruns || blk->start != g_lf_stream_next) {
+        PrintAndLogEx(WARNING, "samples lost before sample " _YELLOW_("%u") ", decoders restart", blk->start);
+        lf_stream_gap(g_lf_stream);
+        g_lf_stream_overruns = blk->overruns;
+    }
+    g_lf_stream_next = blk->start + blk->len;
+
+    int samples[LF_STREAM_BLOCK_SAMPLES];
+    for (uint16_t i = 0; i < blk->len; i++)
+        samples[i] = ((int)blk->samples[i]) - 127;
+
+    lf_stream_feed(g_lf_stream, samples, blk->len);
+}
+
+static void *lf_stream_decoder(void *arg) {
+    (void)arg;
+    lf_stream_block_t *blk = calloc(1, sizeof(lf_stream_block_t));
+
+    pthread_mutex_lock(&g_lf_ring.lock);
+    while (true) {
+        while (g_lf_ring.count == 0 && g_lf_ring.stop == false)
+            pthread_cond_wait(&g_lf_ring.data, &g_lf_ring.lock);
+
+        // what is queued is decoded before the thread ends
+        if (g_lf_ring.count == 0)
+            break;
+
+        lf_stream_block_t *slot = &g_lf_ring.blocks[g_lf_ring.head];
+        if (blk)
+            memcpy(blk, slot, sizeof(lf_stream_block_t));
+        g_lf_ring.head = (g_lf_ring.head + 1) % LF_STREAM_RING;
+        g_lf_ring.count--;
+        pthread_cond_signal(&g_lf_ring.room);
+        pthread_mutex_unlock(&g_lf_ring.lock);
+
+        if (blk)
+            lf_stream_block(blk);
+
+        pthread_mutex_lock(&g_lf_ring.lock);
+    }
+    pthread_mutex_unlock(&g_lf_ring.lock);
+    free(blk);
+    return NULL;
+}
+
+static bool lf_stream_queue(const uint8_t *data, uint16_t len, bool wait) {
+
+    if (len < sizeof(lf_stream_data_t))
+        return false;
+
+    const lf_stream_data_t *pkt = (const lf_stream_data_t *)data;
+    uint16_t n = MIN(len - sizeof(lf_stream_data_t), LF_STREAM_BLOCK_SAMPLES);
+
+    pthread_mutex_lock(&g_lf_ring.lock);
+    if (g_lf_ring.running == false || g_lf_ring.stop) {
+        pthread_mutex_unlock(&g_lf_ring.lock);
+        PrintAndLogEx(DEBUG, "dropped %u streamed samples, no stream active", n);
+        return false;
+    }
+
+    while (wait && g_lf_ring.count == LF_STREAM_RING)
+        pthread_cond_wait(&g_lf_ring.room, &g_lf_ring.lock);
+
+    if (g_lf_ring.count == LF_STREAM_RING) {
+        g_lf_ring.dropped++;
+        pthread_mutex_unlock(&g_lf_ring.lock);
+        return false;
+    }
+
+    lf_stream_block_t *slot = &g_lf_ring.blocks[(g_lf_ring.head + g_lf_ring.count) % LF_STREAM_RING];
+    slot->start = pkt->start;
+    slot->overruns = pkt->overruns;
+    slot->len = n;
+    memcpy(slot->samples, pkt->samples, n);
+    if (g_lf_ring.count++ == 0)
+        pthread_cond_signal(&g_lf_ring.data);
+    pthread_mutex_unlock(&g_lf_ring.lock);
+    return true;
+}
+
+static int lf_stream_start_ex(uint8_t decoders, lf_modulation_t mod, size_t detect, const uint8_t *check, size_t check_len) {
+    if (g_lf_ring.running)
+        return PM3_EINVARG;
+
+    g_lf_stream = lf_stream_create(decoders & ~LF_STREAM_DEMOD);
+    if (g_lf_stream && (decoders & LF_STREAM_DEMOD)) {
+        if (lf_stream_demod(g_lf_stream, mod, detect) != PM3_SUCCESS) {
+            lf_stream_free(g_lf_stream);
+            g_lf_stream = NULL;
+        } else if (check) {
+            lf_stream_check(g_lf_stream, check, check_len);
+        }
+    }
+    if (g_lf_stream == NULL)
+        return PM3_EMALLOC;
+
+    g_lf_stream_next = 0;
+    g_lf_stream_overruns = 0;
+
+    g_lf_ring.blocks = calloc(LF_STREAM_RING, sizeof(lf_stream_block_t));
+    if (g_lf_ring.blocks == NULL) {
+        lf_stream_free(g_lf_stream);
+        g_lf_stream = NULL;
+        return PM3_EMALLOC;
+    }
+    g_lf_ring.head = 0;
+    g_lf_ring.count = 0;
+    g_lf_ring.dropped = 0;
+    g_lf_ring.stop = false;
+
+    if (pthread_create(&g_lf_ring.thread, NULL, lf_stream_decoder, NULL) != 0) {
+        free(g_lf_ring.blocks);
+        g_lf_ring.blocks = NULL;
+        lf_stream_free(g_lf_stream);
+        g_lf_stream = NULL;
+        return PM3_EFAILED;
+    }
+
+    pthread_mutex_lock(&g_lf_ring.lock);
+    g_lf_ring.running = true;
+    pthread_mutex_unlock(&g_lf_ring.lock);
+    return PM3_SUCCESS;
+}
+
+int lf_stream_start(uint8_t decoders, lf_modulation_t mod) {
+    return lf_stream_start_ex(decoders, mod, LF_STREAM_DETECT, NULL, 0);
+}
+
+void lf_stream_data(const uint8_t *data, uint16_t len) {
+    lf_stream_queue(data, len, false);
+}
+
+int lf_stream_stop(void) {
+    pthread_mutex_lock(&g_lf_ring.lock);
+    if (g_lf_ring.running == false) {
+        pthread_mutex_unlock(&g_lf_ring.lock);
+        return PM3_EINVARG;
+    }
+    g_lf_ring.stop = true;
+    pthread_cond_signal(&g_lf_ring.data);
+    pthread_mutex_unlock(&g_lf_ring.lock);
+
+    pthread_join(g_lf_ring.thread, NULL);
+
+    pthread_mutex_lock(&g_lf_ring.lock);
+    g_lf_ring.running = false;
+    uint32_t dropped = g_lf_ring.dropped;
+    free(g_lf_ring.blocks);
+    g_lf_ring.blocks = NULL;
+    pthread_mutex_unlock(&g_lf_ring.lock);
+
+    if (dropped)
+        PrintAndLogEx(WARNING, "decoders fell behind, " _YELLOW_("%u") " blocks dropped", dropped);
+
+    lf_stream_finish(g_lf_stream);
+    lf_stream_free(g_lf_stream);
+    g_lf_stream = NULL;
+    return PM3_SUCCESS;
+}
+
+// what `data rawdemod` gives on the whole file, ask is the raw demod without the sequence terminator handling
+static void lf_stream_batch_demod(lf_modulation_t mod) {
+    int res = PM3_ESOFT;
+    switch (mod) {
+        case LF_MOD_ASK: {
+            uint8_t *bits = demod_ctx_scratch(demod_ctx(), GraphTraceLen);
+            if (bits == NULL)
+                break;
+            size_t size = getFromGraphBuf(bits);
+            int clk = 0, invert = 0, start = 0;
+            int errCnt = askdemod_ext(bits, &size, &clk, &invert, 100, 0, 0, &start, NULL);
+            if (errCnt >= 0 && errCnt <= 100 && size >= 16) {
+                setDemodBuff(bits, size, 0);
+                res = PM3_SUCCESS;
+            }
+            break;
+        }
+        case LF_MOD_FSK:
+            DemodBufferLen = 0;
+            res = FSKrawDemod(0, 0, 0, 0, false);
+            break;
+        case LF_MOD_PSK:
+            res = PSKDemod(0, 0, 100, false);
+            break;
+        case LF_MOD_NRZ:
+            res = NRZrawDemod(0, 0, 100, false);
+            break;
+    }
+    if (res != PM3_SUCCESS)
+        DemodBufferLen = 0;
+}
+
+// simulated device, feeds a .pm3 file in blocks of block samples
+int lf_stream_replay(const char *filename, uint8_t decoders, lf_modulation_t mod, uint16_t block, bool check) {
+
+    if (block == 0 || block > LF_STREAM_BLOCK_SAMPLES)
+        return PM3_EINVARG;
+
+    demod_ctx_t *ctx = demod_ctx_create();
+    if (ctx == NULL)
+        return PM3_EMALLOC;
+
+    demod_ctx_t *prev = demod_ctx_select(ctx);
+    int res = loadSamplesPM3(filename);
+    demod_ctx_select(prev);
+    if (res != PM3_SUCCESS) {
+        PrintAndLogEx(FAILED, "Could not open file " _YELLOW_("%s"), filename);
+        demod_ctx_free(ctx);
+        return res;
+    }
+
+    // the reference bits, before the samples go out
+    if ((decoders & LF_STREAM_DEMOD) && check) {
+        prev = demod_ctx_select(ctx);
+        lf_stream_batch_demod(mod);
+        demod_ctx_select(prev);
+    }
+
+    res = lf_stream_start_ex(decoders, mod, ctx->graph_len, (check) ? ctx->demod : NULL, ctx->demod_len);
+    if (res != PM3_SUCCESS) {
+        demod_ctx_free(ctx);
+        return res;
+    }
+
+    uint8_t buf[PM3_CMD_DATA_SIZE];
+    lf_stream_data_t *blk = (lf_stream_data_t *)buf;
+    blk->overruns = 0;
+    for (size_t pos = 0; pos < ctx->graph_len; pos += block) {
+        uint16_t n = MIN(block, ctx->graph_len - pos);
+        blk->start = pos;
+        for (uint16_t i = 0; i < n; i++) {
+            int v = ctx->graph[pos + i] + 127;
+            blk->samples[i] = (v < 0) ? 0 : (v > 255) ? 255 : v;
+        }
+        lf_stream_queue(buf, sizeof(lf_stream_data_t) + n, true);
+    }
+
+    // the check bits live in ctx
+    res = lf_stream_stop();
+    demod_ctx_free(ctx);
+    return res;
+}
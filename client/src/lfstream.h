@@ -0,0 +1,64 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// LF live decoding
+//
+// Decodes LF samples as they come in, in blocks of any size. T55xx downlink
+// and EM4x05 commands are decoded pulse by pulse, tag ids by `lf search` over
+// a window that slides over the samples. The raw bitstream of one modulation
+// comes from the streaming demods, with the clock detected on the first
+// samples. Memory doesn't grow with the length of the stream.
+//
+// The blocks are cut again at fixed sample positions before they go to the
+// decoders, so the output is the same whatever the block size the samples
+// arrive in.
+//-----------------------------------------------------------------------------
+
+#ifndef LFSTREAM_H__
+#define LFSTREAM_H__
+
+#include "common.h"
+#include "lfsearch.h"           // lf_modulation_t
+
+#define LF_STREAM_T55XX     0x01    // T55xx downlink commands
+#define LF_STREAM_EM4X05    0x02    // EM4x05 commands
+#define LF_STREAM_TAGS      0x04    // tag ids
+#define LF_STREAM_DEMOD     0x08    // raw bitstream of one modulation
+#define LF_STREAM_ALL       (LF_STREAM_T55XX | LF_STREAM_EM4X05 | LF_STREAM_TAGS)
+
+// tag search window and how far it moves on
+#define LF_STREAM_WINDOW    32768
+#define LF_STREAM_HOP       16384
+
+// the raw demod detects the clock on this many samples, one device capture
+#define LF_STREAM_DETECT    40000
+
+typedef struct lf_stream_s lf_stream_t;
+
+lf_stream_t *lf_stream_create(uint8_t decoders);
+void lf_stream_free(lf_stream_t *s);
+// raw demod of mod, clock and thresholds are detected on the first detect samples
+int lf_stream_demod(lf_stream_t *s, lf_modulation_t mod, size_t detect);
+// the raw demod bits are compared to these, the caller keeps them until the end
+void lf_stream_check(lf_stream_t *s, const uint8_t *bits, size_t len);
+
+// samples as in the graph buffer, centered on 0
+void lf_stream_feed(lf_stream_t *s, const int *samples, size_t len);
+// samples were lost, the decoders start over
+void lf_stream_gap(lf_stream_t *s);
+// decodes what is left and prints a summary
+void lf_stream_finish(lf_stream_t *s);
+
+// device stream, blocks arrive on the comms thread as CMD_LF_SNIFF_STREAM_DATA.
+// lf_stream_data only queues them, the decoders run on a thread of their own
+// until lf_stream_stop has decoded what is queued
+int lf_stream_start(uint8_t decoders, lf_modulation_t mod);
+void lf_stream_data(const uint8_t *data, uint16_t len);
+int lf_stream_stop(void);
+// simulated device, streams a .pm3 file in blocks of up to LF_STREAM_BLOCK_SAMPLES samples.
+// The raw demod detects on the whole file, check compares it to the batch demod of the file
+int lf_stream_replay(const char *filename, uint8_t decoders, lf_modulation_t mod, uint16_t block, bool check);
+
+#endif
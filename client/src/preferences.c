@@ -26,6 +26,9 @@
 #include <dirent.h>
 #include <proxmark3.h>
 
+// longest the log writer waits for a batch to fill
+#define LOG_FLUSH_MS_MAX 60000
+
 static int CmdHelp(const char *Cmd);
 static int setCmdHelp(const char *Cmd);
 
@@ -54,6 +57,7 @@ int preferences_load(void) {
     session.overlay.w = session.plot.w;
     session.overlay_sliders = true;
     session.show_hints = false;
+    session.log_flush_ms = 100;
 
 //    setDefaultPath (spDefault, "");
 //    setDefaultPath (spDump, "");
@@ -196,6 +200,9 @@ void preferences_save_callback(json_t *root) {
     JsonSaveInt(root, "window.overlay.wsize", session.overlay.w);
     JsonSaveBoolean(root, "window.overlay.sliders", session.overlay_sliders);
 
+    // Log file
+    JsonSaveInt(root, "logging.flush.ms", session.log_flush_ms);
+
     // Log level, convert to text
     switch (session.client_debug_level) {
         case cdbOFF:
@@ -283,6 +290,10 @@ void preferences_load_callback(json_t *root) {
     if (json_unpack_ex(root, &up_error, 0, "{s:b}", "window.overlay.sliders", &b1) == 0)
         session.overlay_sliders = (bool)b1;
 
+    // log file
+    if (json_unpack_ex(root, &up_error, 0, "{s:i}", "logging.flush.ms", &i1) == 0)
+        session.log_flush_ms = (i1 < 0) ? 0 : MIN(i1, LOG_FLUSH_MS_MAX);
+
     // show options
     if (json_unpack_ex(root, &up_error, 0, "{s:s}", "show.emoji", &s1) == 0) {
         strncpy(tempStr, s1, sizeof(tempStr) - 1);
@@ -375,6 +386,14 @@ static int usage_set_plotsliders(void) {
     return PM3_SUCCESS;
 }
 
+static int usage_set_logflush(void) {
+    PrintAndLogEx(NORMAL, "Usage: pref set logflush <ms>");
+    PrintAndLogEx(NORMAL, "Options:");
+    PrintAndLogEx(NORMAL, "     "_GREEN_("help")"        - This help");
+    PrintAndLogEx(NORMAL, "     "_GREEN_("<ms>")"        - Log file is written in batches of this many ms, 0 line by line");
+    return PM3_SUCCESS;
+}
+
 /*
 static int usage_set_savePaths(void) {
     PrintAndLogEx(NORMAL, "Usage: pref set savepaths [help] [create] [default <path>] [dump <path>] [trace <path>]");
@@ -514,6 +533,10 @@ static void showHintsState(prefShowOpt_t opt) {
         PrintAndLogEx(INFO, "   %s hints.................. "_WHITE_("off"), prefShowMsg(opt));
 }
 
+static void showLogFlushState(prefShowOpt_t opt) {
+    PrintAndLogEx(INFO, "   %s log flush interval..... "_GREEN_("%u")" ms", prefShowMsg(opt), session.log_flush_ms);
+}
+
 static void showPlotSliderState(prefShowOpt_t opt) {
     if (session.overlay_sliders)
         PrintAndLogEx(INFO, "   %s show plot sliders...... "_GREEN_("on"), prefShowMsg(opt));
@@ -830,6 +853,35 @@ static int setCmdPlotSliders(const char *Cmd) {
     return PM3_SUCCESS;
 }
 
+static int setCmdLogFlush(const char *Cmd) {
+    char strOpt[50] = {0};
+
+    if (param_getstr(Cmd, 0, strOpt, sizeof(strOpt)) == 0)
+        return usage_set_logflush();
+
+    str_lower(strOpt);
+    if (strncmp(strOpt, "help", 4) == 0)
+        return usage_set_logflush();
+
+    char *end = NULL;
+    unsigned long newValue = strtoul(strOpt, &end, 10);
+    if (end == strOpt || *end != '\0' || newValue > LOG_FLUSH_MS_MAX) {
+        PrintAndLogEx(ERR, "invalid option");
+        return usage_set_logflush();
+    }
+
+    if (session.log_flush_ms != newValue) {// changed
+        showLogFlushState(prefShowOLD);
+        session.log_flush_ms = newValue;
+        showLogFlushState(prefShowNEW);
+        preferences_save();
+    } else {
+        PrintAndLogEx(INFO, "nothing changed");
+        showLogFlushState(prefShowNone);
+    }
+    return PM3_SUCCESS;
+}
+
 /*
 static int setCmdSavePaths (const char *Cmd) {
     uint8_t cmdp = 0;
@@ -941,6 +993,11 @@ static int getCmdDebug(const char *Cmd) {
     return PM3_SUCCESS;
 }
 
+static int getCmdLogFlush(const char *Cmd) {
+    showLogFlushState(prefShowNone);
+    return PM3_SUCCESS;
+}
+
 static int getCmdPlotSlider(const char *Cmd) {
     showPlotSliderState(prefShowNone);
     return PM3_SUCCESS;
@@ -954,6 +1011,7 @@ static command_t getCommandTable[] = {
     //  {"defaultsavepaths", getCmdSavePaths,     AlwaysAvailable, "... to be adjusted next ... "},
     {"clientdebug",      getCmdDebug,         AlwaysAvailable, "Get client debug level preference"},
     {"plotsliders",      getCmdPlotSlider,    AlwaysAvailable, "Get plot slider display preference"},
+    {"logflush",         getCmdLogFlush,      AlwaysAvailable, "Get log file flush interval preference"},
     //  {"devicedebug",      getCmdDeviceDebug,   AlwaysAvailable, "Get device debug level"},
     {NULL, NULL, NULL, NULL}
 };
@@ -966,6 +1024,7 @@ static command_t setCommandTable[] = {
     //  {"defaultsavepaths", setCmdSavePaths,     AlwaysAvailable, "... to be adjusted next ... "},
     {"clientdebug",      setCmdDebug,         AlwaysAvailable, "Set client debug level"},
     {"plotsliders", setCmdPlotSliders,         AlwaysAvailable, "Set plot slider display"},
+    {"logflush",         setCmdLogFlush,      AlwaysAvailable, "Set log file flush interval"},
     //  {"devicedebug",      setCmdDeviceDebug,   AlwaysAvailable, "Set device debug level"},
     {NULL, NULL, NULL, NULL}
 };
@@ -1008,6 +1067,7 @@ static int CmdPrefShow(const char *Cmd) {
     //  showSavePathState(spTrace, prefShowNone);
     showClientDebugState(prefShowNone);
     showPlotSliderState(prefShowNone);
+    showLogFlushState(prefShowNone);
 //    showDeviceDebugState(prefShowNone);
     PrintAndLogEx(NORMAL, "");
     return PM3_SUCCESS;
@@ -25,6 +25,7 @@
 #include <QSlider>
 #include <QHBoxLayout>
 #include <string.h>
+#include <stdlib.h>
 #include <QtGui>
 #include "proxgui.h"
 #include "ui.h"
@@ -35,7 +36,9 @@
 
 extern "C" int preferences_save(void);
 
-static int s_Buff[MAX_GRAPH_TRACE_LEN];
+// overlay, as long as the graph it was computed from
+static int *s_Buff = NULL;
+static size_t s_BuffLen = 0;
 static bool g_useOverlays = false;
 static int g_absVMax = 0;
 static uint32_t startMax; // Maximum offset in the graph (right side of graph)
@@ -160,10 +163,24 @@ void SliderWidget::moveEvent(QMoveEvent *event) {
 }
 
 //--------------------
+static int *overlayBuffer(void) {
+    if (GraphTraceLen > s_BuffLen) {
+        int *buf = (int *)realloc(s_Buff, GraphTraceLen * sizeof(int));
+        if (buf == NULL)
+            return NULL;
+        s_Buff = buf;
+    }
+    s_BuffLen = GraphTraceLen;
+    return s_Buff;
+}
+
 void ProxWidget::applyOperation() {
     //printf("ApplyOperation()");
+    if (s_Buff == NULL || s_BuffLen != GraphTraceLen)
+        return;
     save_restoreGB(GRAPH_SAVE);
     memcpy(GraphBuffer, s_Buff, sizeof(int) * GraphTraceLen);
+    demod_ctx_touch(demod_ctx());
     RepaintGraphWindow();
 }
 void ProxWidget::stickOperation() {
@@ -171,21 +188,33 @@ void ProxWidget::stickOperation() {
     //printf("stickOperation()");
 }
 void ProxWidget::vchange_autocorr(int v) {
+    if (overlayBuffer() == NULL)
+        return;
+    demod_graph_lock();
     int ans = AutoCorrelate(GraphBuffer, s_Buff, GraphTraceLen, v, true, false);
+    demod_graph_unlock();
     if (g_debugMode) printf("vchange_autocorr(w:%d): %d\n", v, ans);
     g_useOverlays = true;
     RepaintGraphWindow();
 }
 void ProxWidget::vchange_askedge(int v) {
     //extern int AskEdgeDetect(const int *in, int *out, int len, int threshold);
+    if (overlayBuffer() == NULL)
+        return;
+    demod_graph_lock();
     int ans = AskEdgeDetect(GraphBuffer, s_Buff, GraphTraceLen, v);
+    demod_graph_unlock();
     if (g_debugMode) printf("vchange_askedge(w:%d)%d\n", v, ans);
     g_useOverlays = true;
     RepaintGraphWindow();
 }
 void ProxWidget::vchange_dthr_up(int v) {
     int down = opsController->horizontalSlider_dirthr_down->value();
+    if (overlayBuffer() == NULL)
+        return;
+    demod_graph_lock();
     directionalThreshold(GraphBuffer, s_Buff, GraphTraceLen, v, down);
+    demod_graph_unlock();
     //printf("vchange_dthr_up(%d)", v);
     g_useOverlays = true;
     RepaintGraphWindow();
@@ -193,7 +222,11 @@ void ProxWidget::vchange_dthr_up(int v) {
 void ProxWidget::vchange_dthr_down(int v) {
     //printf("vchange_dthr_down(%d)", v);
     int up = opsController->horizontalSlider_dirthr_up->value();
+    if (overlayBuffer() == NULL)
+        return;
+    demod_graph_lock();
     directionalThreshold(GraphBuffer, s_Buff, GraphTraceLen, v, up);
+    demod_graph_unlock();
     g_useOverlays = true;
     RepaintGraphWindow();
 }
@@ -542,6 +575,9 @@ void Plot::paintEvent(QPaintEvent *event) {
 
     painter.setFont(QFont("Courier New", 10));
 
+    // the console thread can move the graph buffer while it grows
+    demod_graph_lock();
+
     if (CursorAPos > GraphTraceLen)
         CursorAPos = 0;
     if (CursorBPos > GraphTraceLen)
@@ -575,11 +611,12 @@ void Plot::paintEvent(QPaintEvent *event) {
     if (showDemod && DemodBufferLen > 8) {
         PlotDemod(DemodBuffer, DemodBufferLen, plotRect, infoRect, &painter, 2, g_DemodStartIdx);
     }
-    if (g_useOverlays) {
+    if (g_useOverlays && s_Buff && s_BuffLen == GraphTraceLen) {
         //init graph variables
         setMaxAndStart(s_Buff, GraphTraceLen, plotRect);
         PlotGraph(s_Buff, GraphTraceLen, plotRect, infoRect, &painter, 1);
     }
+    demod_graph_unlock();
     // End graph drawing
 
     //Draw the cursors
@@ -729,6 +766,7 @@ void Plot::Trim(void) {
     for (uint32_t i = lref; i < rref; ++i)
         GraphBuffer[i - lref] = GraphBuffer[i];
     GraphTraceLen = rref - lref;
+    demod_ctx_touch(demod_ctx());
     GraphStart = 0;
 }
 
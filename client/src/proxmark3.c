@@ -33,6 +33,9 @@
 #include "fileutils.h"
 #include "flash.h"
 #include "preferences.h"
+#include "lfsearch.h"
+#include "util.h"
+#include "cmdtrace.h"     // trace_stream_print
 
 #define BANNERMSG1 "      Iceman :coffee:"
 #define BANNERMSG2 "  :snowflake: bleeding edge"
@@ -136,6 +139,8 @@ static int check_comm(void) {
 #endif
         CloseProxmark();
     }
+    // live decode of a trace stream while waiting at the prompt
+    trace_stream_print();
     msleep(10);
     return 0;
 }
@@ -550,6 +555,7 @@ static void show_help(bool showFullHelp, char *exec_name) {
 
     PrintAndLogEx(NORMAL, "\nsyntax: %s [-h|-t|-m]", exec_name);
     PrintAndLogEx(NORMAL, "        %s [[-p] <port>] [-b] [-w] [-f] [-c <command>]|[-l <lua_script_file>]|[-s <cmd_script_file>] [-i] [-d <0|1|2>]", exec_name);
+    PrintAndLogEx(NORMAL, "        %s [--offline] --batch <command> <files|dirs>...", exec_name);
     PrintAndLogEx(NORMAL, "        %s [-p] <port> --flash [--unlock-bootloader] [--image <imagefile>]+ [-w] [-f] [-d <0|1|2>]", exec_name);
 
     if (showFullHelp) {
@@ -570,6 +576,10 @@ static void show_help(bool showFullHelp, char *exec_name) {
         PrintAndLogEx(NORMAL, "      -s/--script-file <cmd_script_file>  script file with one Proxmark3 command per line");
         PrintAndLogEx(NORMAL, "      -i/--interactive                    enter interactive mode after executing the script or the command");
         PrintAndLogEx(NORMAL, "      --incognito                         do not use history, prefs file nor log files");
+        PrintAndLogEx(NORMAL, "      --offline                           do not connect to a Proxmark3, even if a port is given");
+        PrintAndLogEx(NORMAL, "\nOptions in batch mode:");
+        PrintAndLogEx(NORMAL, "      --batch <command> <files|dirs>...   run command on each LF sample file (.pm3) on all cores, without device.");
+        PrintAndLogEx(NORMAL, "                                          only " _YELLOW_("\"lf search\"") " is supported. One JSON line per file on stdout");
         PrintAndLogEx(NORMAL, "\nOptions in flasher mode:");
         PrintAndLogEx(NORMAL, "      --flash                             flash Proxmark3, requires at least one --image");
         PrintAndLogEx(NORMAL, "      --unlock-bootloader                 Enable flashing of bootloader area *DANGEROUS* (need --flash or --flash-info)");
@@ -584,6 +594,8 @@ static void show_help(bool showFullHelp, char *exec_name) {
         PrintAndLogEx(NORMAL, "      %s "SERIAL_PORT_EXAMPLE_H" -c \"hf mf chk 1* ?\"   -- execute cmd and quit client", exec_name);
         PrintAndLogEx(NORMAL, "      %s "SERIAL_PORT_EXAMPLE_H" -l hf_read            -- execute lua script " _YELLOW_("`hf_read`")" and quit client", exec_name);
         PrintAndLogEx(NORMAL, "      %s "SERIAL_PORT_EXAMPLE_H" -s mycmds.txt         -- execute each pm3 cmd in file and quit client", exec_name);
+        PrintAndLogEx(NORMAL, "\n  to decode LF sample files:\n");
+        PrintAndLogEx(NORMAL, "      %s --offline --batch \"lf search\" traces/  -- decode all .pm3 files of a directory", exec_name);
         PrintAndLogEx(NORMAL, "\n  to flash fullimage and bootloader:\n");
         PrintAndLogEx(NORMAL, "      %s "SERIAL_PORT_EXAMPLE_H" --flash --unlock-bootloader --image bootrom.elf --image fullimage.elf", exec_name);
 #ifdef __linux__
@@ -711,6 +723,10 @@ int main(int argc, char *argv[]) {
     char *script_cmd = NULL;
     char *port = NULL;
     uint32_t speed = 0;
+    bool force_offline = false;
+    char *batch_cmd = NULL;
+    char **batch_files = NULL;
+    int batch_num_files = 0;
 
 #ifdef HAVE_READLINE
     /* initialize history */
@@ -766,6 +782,11 @@ int main(int argc, char *argv[]) {
     for (int i = 1; i < argc; i++) {
 
         if (argv[i][0] != '-') {
+            // sample files to decode in batch mode
+            if (batch_cmd != NULL) {
+                batch_files[batch_num_files++] = argv[i];
+                continue;
+            }
             // For backward compatibility we accept direct port
             if (port != NULL) {
                 // We got already one
@@ -915,6 +936,29 @@ int main(int argc, char *argv[]) {
             continue;
         }
 
+        // never connect to a device
+        if (strcmp(argv[i], "--offline") == 0) {
+            force_offline = true;
+            continue;
+        }
+
+        // decode sample files without a device
+        if (strcmp(argv[i], "--batch") == 0) {
+            if (i + 1 == argc) {
+                PrintAndLogEx(ERR, _RED_("ERROR:") " missing command specification after --batch\n");
+                show_help(false, exec_name);
+                return 1;
+            }
+            batch_cmd = argv[++i];
+            if (batch_files == NULL)
+                batch_files = calloc(argc, sizeof(char *));
+            if (batch_files == NULL) {
+                PrintAndLogEx(ERR, _RED_("ERROR:") " out of memory\n");
+                return 1;
+            }
+            continue;
+        }
+
         // go to flash mode
         if (strcmp(argv[i], "--flash") == 0) {
             flash_mode = true;
@@ -948,6 +992,30 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // headless, no preferences, no log, no device. Only JSON on stdout
+    if (batch_cmd) {
+        char c1[16] = {0}, c2[16] = {0}, c3[16] = {0};
+        if (sscanf(batch_cmd, "%15s %15s %15s", c1, c2, c3) != 2 || strcmp(c1, "lf") || strcmp(c2, "search")) {
+            PrintAndLogEx(ERR, _RED_("ERROR:") " batch mode only supports " _YELLOW_("lf search") ", got " _YELLOW_("%s") "\n", batch_cmd);
+            free(batch_files);
+            return 1;
+        }
+        if (batch_num_files == 0) {
+            PrintAndLogEx(ERR, _RED_("ERROR:") " missing sample files after --batch\n");
+            show_help(false, exec_name);
+            free(batch_files);
+            return 1;
+        }
+        session.supports_colors = false;
+        session.emoji_mode = ALTTEXT;
+        session.incognito = true;
+        int res = lf_search_batch(batch_files, batch_num_files, num_CPUs(), stdout);
+        free(batch_files);
+        if (res == PM3_EINVARG)
+            PrintAndLogEx(ERR, _RED_("ERROR:") " no sample files found\n");
+        return (res == PM3_SUCCESS) ? 0 : 1;
+    }
+
     // Load Settings and assign
     // This will allow the command line to override the settings.json values
     preferences_load();
@@ -997,6 +1065,9 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (force_offline)
+        port = NULL;
+
     // try to open USB connection to Proxmark
     if (port != NULL) {
         OpenProxmark(port, waitCOMPort, 20, false, speed);
@@ -13,6 +13,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include <sys/stat.h>
 
 #include "lauxlib.h"
 #include "cmdmain.h"
@@ -39,6 +42,7 @@
 #include "cmdlfem4x05.h"  // read 4305
 #include "cmdlfem4x50.h"  // read 4350
 #include "em4x50.h"       // 4x50 structs
+#include "util_posix.h"   // msclock
 
 static int returnToLuaWithError(lua_State *L, const char *fmt, ...) {
     char buffer[200];
@@ -755,6 +759,9 @@ static int l_sha1(lua_State *L) {
     return 1;
 }
 
+// reveng keeps its model in globals, the states of `script batch` share it
+static pthread_mutex_t reveng_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static int l_reveng_models(lua_State *L) {
 
 // This array needs to be adjusted if RevEng adds more crc-models.
@@ -771,7 +778,10 @@ static int l_reveng_models(lua_State *L) {
 
     width[0] = in_width;
 
-    if (!GetModels(models, &count, width))
+    pthread_mutex_lock(&reveng_lock);
+    bool found = GetModels(models, &count, width);
+    pthread_mutex_unlock(&reveng_lock);
+    if (!found)
         return returnToLuaWithError(L, "didn't find any models");
 
     lua_newtable(L);
@@ -806,7 +816,9 @@ static int l_reveng_runmodel(lua_State *L) {
     bool reverse =  lua_toboolean(L, 3);
     const char endian = luaL_checkstring(L, 4)[0];
 
+    pthread_mutex_lock(&reveng_lock);
     int ans = RunModel((char *)inModel, (char *)inHexStr, reverse, endian, result);
+    pthread_mutex_unlock(&reveng_lock);
     if (!ans)
         return returnToLuaWithError(L, "Reveng failed");
 
@@ -1316,6 +1328,234 @@ static int l_printandlogex(lua_State *L) {
     return 0;
 }
 
+// Bytecode cache. A compiled chunk is kept in the user's luacache directory,
+// valid while the source has the same path, mtime to the nanosecond where the
+// platform has it, size and contents, and for the same Lua
+#define LUA_CACHE_MAGIC      "PM3M"
+#define LUA_CACHE_STATS      "pm3.luacache"
+
+typedef struct {
+    char magic[4];
+    uint32_t version;       // LUA_VERSION_NUM
+    int64_t mtime;          // ns
+    int64_t size;
+    uint64_t hash;          // FNV-1a of the source
+    uint32_t pathlen;       // followed by the source path, then the bytecode
+} PACKED lua_cache_header_t;
+
+// one writer at a time, `script batch` states compile the same modules
+static pthread_mutex_t lua_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int64_t lua_cache_mtime(const struct stat *st) {
+#if defined(__APPLE__)
+    return (int64_t)st->st_mtimespec.tv_sec * 1000000000LL + st->st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    return (int64_t)st->st_mtime * 1000000000LL;
+#else
+    return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#endif
+}
+
+// what the cached chunk must match. The contents are hashed as well, a same size
+// edit within the timestamp resolution of the file system keeps mtime and size
+static bool lua_cache_key(const char *filename, const struct stat *st, lua_cache_header_t *key) {
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL)
+        return false;
+
+    uint64_t h = 0xcbf29ce484222325ULL;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            h ^= buf[i];
+            h *= 0x100000001b3ULL;
+        }
+    }
+    bool ok = (ferror(f) == 0);
+    fclose(f);
+
+    memset(key, 0, sizeof(lua_cache_header_t));
+    memcpy(key->magic, LUA_CACHE_MAGIC, sizeof(key->magic));
+    key->version = LUA_VERSION_NUM;
+    key->mtime = lua_cache_mtime(st);
+    key->size = st->st_size;
+    key->hash = h;
+    key->pathlen = strlen(filename);
+    return ok;
+}
+
+static char *lua_cache_path(const char *filename) {
+    // FNV-1a of the source path names the cache file
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char *c = filename; *c; c++) {
+        h ^= (uint8_t) * c;
+        h *= 0x100000001b3ULL;
+    }
+    char name[24];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".luac", h);
+
+    char *path = NULL;
+    if (searchHomeFilePath(&path, LUA_CACHE_SUBDIR, name, true) != PM3_SUCCESS)
+        return NULL;
+    return path;
+}
+
+static bool lua_cache_read(lua_State *L, const char *cache, const char *filename, const lua_cache_header_t *key) {
+    FILE *f = fopen(cache, "rb");
+    if (f == NULL)
+        return false;
+
+    fseek(f, 0, SEEK_END);
+    long fsize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    size_t pathlen = key->pathlen;
+    if (fsize < (long)(sizeof(lua_cache_header_t) + pathlen)) {
+        fclose(f);
+        return false;
+    }
+
+    char *data = calloc(fsize, sizeof(char));
+    if (data == NULL) {
+        fclose(f);
+        return false;
+    }
+    size_t n = fread(data, 1, fsize, f);
+    fclose(f);
+
+    lua_cache_header_t hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+    const char *code = data + sizeof(hdr) + pathlen;
+
+    bool ok = (n == (size_t)fsize)
+              && memcmp(hdr.magic, key->magic, sizeof(hdr.magic)) == 0
+              && hdr.version == key->version
+              && hdr.mtime == key->mtime
+              && hdr.size == key->size
+              && hdr.hash == key->hash
+              && hdr.pathlen == pathlen
+              && memcmp(data + sizeof(hdr), filename, pathlen) == 0;
+
+    // lua checks the bytecode header itself
+    if (ok)
+        ok = luaL_loadbufferx(L, code, fsize - (code - data), filename, "b") == LUA_OK;
+
+    free(data);
+    return ok;
+}
+
+static int lua_cache_writer(lua_State *L, const void *p, size_t sz, void *ud) {
+    (void)L;
+    return fwrite(p, 1, sz, (FILE *)ud) == sz ? 0 : 1;
+}
+
+static void lua_cache_write(lua_State *L, const char *cache, const char *filename, const lua_cache_header_t *key) {
+    size_t pathlen = key->pathlen;
+
+    char tmp[strlen(cache) + 5];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", cache);
+
+    pthread_mutex_lock(&lua_cache_lock);
+    FILE *f = fopen(tmp, "wb");
+    if (f) {
+        bool ok = fwrite(key, sizeof(lua_cache_header_t), 1, f) == 1
+                  && fwrite(filename, 1, pathlen, f) == pathlen
+                  && lua_dump(L, lua_cache_writer, f) == 0;
+        ok = (fclose(f) == 0) && ok;
+
+        // readers see the old file or the new one
+#ifdef _WIN32
+        if (ok)
+            remove(cache);
+#endif
+        if (ok == false || rename(tmp, cache) != 0)
+            remove(tmp);
+    }
+    pthread_mutex_unlock(&lua_cache_lock);
+}
+
+int lua_cache_loadfile(lua_State *L, const char *filename) {
+    uint64_t t1 = msclock();
+
+    lua_getfield(L, LUA_REGISTRYINDEX, LUA_CACHE_STATS);
+    lua_cache_stats_t *stats = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    struct stat st;
+    lua_cache_header_t key;
+    char *cache = NULL;
+    if (stat(filename, &st) == 0 && lua_cache_key(filename, &st, &key))
+        cache = lua_cache_path(filename);
+
+    int top = lua_gettop(L);
+    int res = LUA_OK;
+    if (cache && lua_cache_read(L, cache, filename, &key)) {
+        if (stats)
+            stats->hits++;
+    } else {
+        lua_settop(L, top);
+        res = luaL_loadfile(L, filename);
+        if (res == LUA_OK) {
+            if (cache)
+                lua_cache_write(L, cache, filename, &key);
+            if (stats)
+                stats->compiled++;
+        }
+    }
+    free(cache);
+
+    if (stats)
+        stats->ms += msclock() - t1;
+    return res;
+}
+
+// package.searchers entry, finds modules on package.path as the lua searcher
+// and loads them through the cache
+static int l_cache_searcher(lua_State *L) {
+    const char *name = luaL_checkstring(L, 1);
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchpath");
+    lua_pushstring(L, name);
+    lua_getfield(L, -3, "path");
+    lua_call(L, 2, 2);
+    if (lua_isnil(L, -2))
+        return 1;   // the error message, lua goes on with the next searcher
+
+    const char *filename = lua_tostring(L, -2);
+    if (lua_cache_loadfile(L, filename) != LUA_OK)
+        return luaL_error(L, "error loading module " LUA_QS " from file " LUA_QS ":\n\t%s", name, filename, lua_tostring(L, -1));
+
+    lua_pushstring(L, filename);
+    return 2;
+}
+
+static void set_lua_cache(lua_State *L) {
+    lua_cache_stats_t *stats = lua_newuserdata(L, sizeof(lua_cache_stats_t));
+    memset(stats, 0, sizeof(lua_cache_stats_t));
+    lua_setfield(L, LUA_REGISTRYINDEX, LUA_CACHE_STATS);
+
+    // in front of the lua searcher, after the preload one
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchers");
+    for (int i = luaL_len(L, -1); i >= 2; i--) {
+        lua_rawgeti(L, -1, i);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushcfunction(L, l_cache_searcher);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 2);
+}
+
+void lua_cache_get_stats(lua_State *L, lua_cache_stats_t *stats) {
+    memset(stats, 0, sizeof(lua_cache_stats_t));
+    lua_getfield(L, LUA_REGISTRYINDEX, LUA_CACHE_STATS);
+    if (lua_touserdata(L, -1))
+        memcpy(stats, lua_touserdata(L, -1), sizeof(lua_cache_stats_t));
+    lua_pop(L, 1);
+}
+
 /**
  * @brief Sets the lua path to include "./lualibs/?.lua", in order for a script to be
  * able to do "require('foobar')" if foobar.lua is within lualibs folder.
@@ -1339,52 +1579,65 @@ static int setLuaPath(lua_State *L, const char *path) {
     return 0; // all done!
 }
 
-int set_pm3_libraries(lua_State *L) {
-    static const luaL_Reg libs[] = {
-        {"SendCommandOLD",              l_SendCommandOLD},
-        {"SendCommandMIX",              l_SendCommandMIX},
-        {"SendCommandNG",               l_SendCommandNG},
-        {"GetFromBigBuf",               l_GetFromBigBuf},
-        {"GetFromFlashMem",             l_GetFromFlashMem},
-        {"GetFromFlashMemSpiffs",       l_GetFromFlashMemSpiffs},
-        {"WaitForResponseTimeout",      l_WaitForResponseTimeout},
-        {"mfDarkside",                  l_mfDarkside},
-        {"foobar",                      l_foobar},
-        {"kbd_enter_pressed",               l_kbd_enter_pressed},
-        {"clearCommandBuffer",          l_clearCommandBuffer},
-        {"console",                     l_CmdConsole},
-        {"iso15693_crc",                l_iso15693_crc},
-        {"iso14443b_crc",               l_iso14443b_crc},
-        {"aes128_decrypt",              l_aes128decrypt_cbc},
-        {"aes128_decrypt_ecb",          l_aes128decrypt_ecb},
-        {"aes128_encrypt",              l_aes128encrypt_cbc},
-        {"aes128_encrypt_ecb",          l_aes128encrypt_ecb},
-        {"crc8legic",                   l_crc8legic},
-        {"crc16",                       l_crc16},
-        {"crc64",                       l_crc64},
-        {"crc64_ecma182",               l_crc64_ecma182},
-        {"sha1",                        l_sha1},
-        {"reveng_models",               l_reveng_models},
-        {"reveng_runmodel",             l_reveng_runmodel},
-        {"hardnested",                  l_hardnested},
-        {"detect_prng",                 l_detect_prng},
+// functions that never talk to the device, the only ones in the states of `script batch`
+static const luaL_Reg pm3_offline_libs[] = {
+    {"iso15693_crc",                l_iso15693_crc},
+    {"iso14443b_crc",               l_iso14443b_crc},
+    {"aes128_decrypt",              l_aes128decrypt_cbc},
+    {"aes128_decrypt_ecb",          l_aes128decrypt_ecb},
+    {"aes128_encrypt",              l_aes128encrypt_cbc},
+    {"aes128_encrypt_ecb",          l_aes128encrypt_ecb},
+    {"crc8legic",                   l_crc8legic},
+    {"crc16",                       l_crc16},
+    {"crc64",                       l_crc64},
+    {"crc64_ecma182",               l_crc64_ecma182},
+    {"sha1",                        l_sha1},
+    {"reveng_models",               l_reveng_models},
+    {"reveng_runmodel",             l_reveng_runmodel},
+    {"keygen_algo_d",               l_keygen_algoD},
+    {"search_file",                 l_searchfile},
+    {"cwd",                         l_cwd},
+    {"ewd",                         l_ewd},
+    {"ud",                          l_ud},
+    {NULL, NULL}
+};
+
+// functions that talk to the device or print to the console
+static const luaL_Reg pm3_client_libs[] = {
+    {"SendCommandOLD",              l_SendCommandOLD},
+    {"SendCommandMIX",              l_SendCommandMIX},
+    {"SendCommandNG",               l_SendCommandNG},
+    {"GetFromBigBuf",               l_GetFromBigBuf},
+    {"GetFromFlashMem",             l_GetFromFlashMem},
+    {"GetFromFlashMemSpiffs",       l_GetFromFlashMemSpiffs},
+    {"WaitForResponseTimeout",      l_WaitForResponseTimeout},
+    {"mfDarkside",                  l_mfDarkside},
+    {"foobar",                      l_foobar},
+    {"kbd_enter_pressed",               l_kbd_enter_pressed},
+    {"clearCommandBuffer",          l_clearCommandBuffer},
+    {"console",                     l_CmdConsole},
+    {"hardnested",                  l_hardnested},
+    {"detect_prng",                 l_detect_prng},
 //        {"keygen.algoA",                l_keygen_algoA},
 //        {"keygen.algoB",                l_keygen_algoB},
 //        {"keygen.algoC",                l_keygen_algoC},
-        {"keygen_algo_d",               l_keygen_algoD},
-        {"t55xx_readblock",             l_T55xx_readblock},
-        {"t55xx_detect",                l_T55xx_detect},
-        {"ndefparse",                   l_ndefparse},
-        {"fast_push_mode",              l_fast_push_mode},
-        {"search_file",                 l_searchfile},
-        {"cwd",                         l_cwd},
-        {"ewd",                         l_ewd},
-        {"ud",                          l_ud},
-        {"rem",                         l_remark},
-        {"em4x05_read",                 l_em4x05_read},
-        {"em4x50_read",                 l_em4x50_read},
-        {NULL, NULL}
-    };
+    {"t55xx_readblock",             l_T55xx_readblock},
+    {"t55xx_detect",                l_T55xx_detect},
+    {"ndefparse",                   l_ndefparse},
+    {"fast_push_mode",              l_fast_push_mode},
+    {"rem",                         l_remark},
+    {"em4x05_read",                 l_em4x05_read},
+    {"em4x50_read",                 l_em4x50_read},
+    {NULL, NULL}
+};
+
+// offline there is no command buffer, scripts still clear it in their error paths
+static int l_offline_clearCommandBuffer(lua_State *L) {
+    (void)L;
+    return 0;
+}
+
+static void set_pm3_core(lua_State *L, bool offline) {
 
     lua_pushglobaltable(L);
     // Core library is in this table. Contains '
@@ -1392,19 +1645,28 @@ int set_pm3_libraries(lua_State *L) {
     lua_newtable(L);
 
     // put the function into the hash table.
-    for (int i = 0; libs[i].name; i++) {
-        lua_pushcfunction(L, libs[i].func);
-        lua_setfield(L, -2, libs[i].name);//set the name, pop stack
+    for (int i = 0; pm3_offline_libs[i].name; i++) {
+        lua_pushcfunction(L, pm3_offline_libs[i].func);
+        lua_setfield(L, -2, pm3_offline_libs[i].name);//set the name, pop stack
+    }
+
+    if (offline) {
+        lua_pushcfunction(L, l_offline_clearCommandBuffer);
+        lua_setfield(L, -2, "clearCommandBuffer");
+    } else {
+        for (int i = 0; pm3_client_libs[i].name; i++) {
+            lua_pushcfunction(L, pm3_client_libs[i].func);
+            lua_setfield(L, -2, pm3_client_libs[i].name);
+        }
     }
     // Name of 'core'
     lua_setfield(L, -2, "core");
 
     // remove the global environment table from the stack
     lua_pop(L, 1);
+}
 
-    // print redirect here
-    lua_register(L, "print", l_printandlogex);
-
+static void set_pm3_paths(lua_State *L) {
     // add to the LUA_PATH (package.path in lua)
     // so we can load scripts from various places:
     const char *exec_path = get_my_executable_directory();
@@ -1457,5 +1719,22 @@ int set_pm3_libraries(lua_State *L) {
         strcat(libraries_path, LUA_LIBRARIES_WILDCARD);
         setLuaPath(L, libraries_path);
     }
+}
+
+int set_pm3_libraries(lua_State *L) {
+    set_pm3_core(L, false);
+    set_lua_cache(L);
+
+    // print redirect here
+    lua_register(L, "print", l_printandlogex);
+
+    set_pm3_paths(L);
+    return 1;
+}
+
+int set_pm3_offline_libraries(lua_State *L) {
+    set_pm3_core(L, true);
+    set_lua_cache(L);
+    set_pm3_paths(L);
     return 1;
 }
@@ -11,11 +11,18 @@
 #define SCRIPTING_H__
 
 #include <lua.h>
+#include "common.h"
 //#include <lualib.h>
 //#include <lauxlib.h>
 
 #define LUA_LIBRARIES_WILDCARD  "?.lua"
 
+typedef struct {
+    uint32_t hits;          // chunks loaded from the bytecode cache
+    uint32_t compiled;      // chunks compiled from source
+    uint64_t ms;            // time spent loading them
+} lua_cache_stats_t;
+
 /**
  * @brief set_libraries loads the core components of pm3 into the 'pm3'
  *  namespace within the given lua_State
@@ -24,4 +31,23 @@
 
 int set_pm3_libraries(lua_State *L);
 
+/**
+ * @brief set_pm3_offline_libraries loads only the pm3 functions that don't
+ *  use the device or the console, for states running on other threads
+ * @param L
+ */
+int set_pm3_offline_libraries(lua_State *L);
+
+/**
+ * @brief lua_cache_loadfile as luaL_loadfile, through the bytecode cache in
+ *  the user's luacache directory. require() uses it too, once the pm3
+ *  libraries are set
+ * @param L
+ * @param filename
+ */
+int lua_cache_loadfile(lua_State *L, const char *filename);
+
+// what the loads of this state took, so far
+void lua_cache_get_stats(lua_State *L, lua_cache_stats_t *stats);
+
 #endif
@@ -0,0 +1,312 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Indexed trace files
+//-----------------------------------------------------------------------------
+#include "tracefile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pm3_cmd.h"            // tracelog_hdr_t
+#include "ui.h"
+#include "lz4/lz4.h"
+
+#ifdef _WIN32
+#define tf_seek _fseeki64
+#else
+#define tf_seek fseeko
+#endif
+
+static int tracefile_flush_block(tracefile_writer_t *w) {
+
+    if (w->count == 0)
+        return PM3_SUCCESS;
+
+    // tags are collected at the end of the block buffer, move them in front of the records
+    uint32_t tags_at = w->block_size - w->hdr.block_records;
+    uint8_t *raw = calloc(w->count + w->block_len, sizeof(uint8_t));
+    if (raw == NULL)
+        return PM3_EMALLOC;
+    memcpy(raw, w->block + tags_at, w->count);
+    memcpy(raw + w->count, w->block, w->block_len);
+    uint32_t raw_len = w->count + w->block_len;
+
+    const uint8_t *out = raw;
+    uint32_t stored_len = raw_len;
+    uint8_t *cbuf = NULL;
+
+    if (w->hdr.flags & TRACEFILE_FLAG_LZ4) {
+        int bound = LZ4_compressBound(raw_len);
+        cbuf = calloc(bound, sizeof(uint8_t));
+        if (cbuf == NULL) {
+            free(raw);
+            return PM3_EMALLOC;
+        }
+        int clen = LZ4_compress_default((const char *)raw, (char *)cbuf, raw_len, bound);
+        // incompressible blocks are stored as is
+        if (clen > 0 && (uint32_t)clen < raw_len) {
+            out = cbuf;
+            stored_len = clen;
+        }
+    }
+
+    // timestamp was set when the first record of the block was added
+    tracefile_idx_t *idx = &w->index[w->hdr.block_count];
+    idx->offset = w->hdr.index_offset;
+    idx->count = w->count;
+    idx->raw_len = raw_len;
+    idx->stored_len = stored_len;
+    idx->rfu = 0;
+
+    int res = PM3_SUCCESS;
+    if (fwrite(out, 1, stored_len, w->f) != stored_len)
+        res = PM3_EFILE;
+
+    free(cbuf);
+    free(raw);
+
+    w->hdr.index_offset += stored_len;
+    w->hdr.block_count++;
+    w->block_len = 0;
+    w->count = 0;
+    return res;
+}
+
+int tracefile_create(tracefile_writer_t *w, const char *path, uint32_t block_records, bool compress) {
+
+    memset(w, 0, sizeof(tracefile_writer_t));
+
+    if (block_records == 0)
+        block_records = TRACEFILE_BLOCK_RECORDS;
+    if (block_records > 0xFFFF)
+        block_records = 0xFFFF;
+
+    w->f = fopen(path, "wb");
+    if (w->f == NULL) {
+        PrintAndLogEx(WARNING, "file not found or locked. '" _YELLOW_("%s")"'", path);
+        return PM3_EFILE;
+    }
+
+    memcpy(w->hdr.magic, TRACEFILE_MAGIC, sizeof(w->hdr.magic));
+    w->hdr.version = TRACEFILE_VERSION;
+    w->hdr.flags = (compress) ? TRACEFILE_FLAG_LZ4 : 0;
+    w->hdr.block_records = block_records;
+    // running file offset until the index gets written
+    w->hdr.index_offset = sizeof(tracefile_hdr_t);
+
+    // records area grows, the last block_records bytes keep the tags
+    w->block_size = PM3_CMD_DATA_SIZE + block_records;
+    w->block = calloc(w->block_size, sizeof(uint8_t));
+    if (w->block == NULL) {
+        fclose(w->f);
+        return PM3_EMALLOC;
+    }
+
+    // placeholder, rewritten by tracefile_finish
+    if (fwrite(&w->hdr, 1, sizeof(w->hdr), w->f) != sizeof(w->hdr)) {
+        fclose(w->f);
+        free(w->block);
+        return PM3_EFILE;
+    }
+    return PM3_SUCCESS;
+}
+
+int tracefile_append(tracefile_writer_t *w, const uint8_t *trace, uint32_t len, uint8_t protocol) {
+
+    uint32_t pos = 0;
+    while (pos + TRACELOG_HDR_LEN <= len) {
+        const tracelog_hdr_t *hdr = (const tracelog_hdr_t *)(trace + pos);
+        uint32_t reclen = TRACELOG_HDR_LEN + hdr->data_len + TRACELOG_PARITY_LEN(hdr);
+        if (pos + reclen > len)
+            break;
+
+        // extend the 32 bit device timestamp
+        if (w->hdr.record_count && hdr->timestamp < w->last_ts)
+            w->ext_ts += 0x100000000ULL;
+        w->last_ts = hdr->timestamp;
+
+        if (w->count == 0) {
+            if (w->hdr.block_count == w->index_size) {
+                uint32_t size = (w->index_size) ? w->index_size * 2 : 64;
+                tracefile_idx_t *tmp = realloc(w->index, size * sizeof(tracefile_idx_t));
+                if (tmp == NULL)
+                    return PM3_EMALLOC;
+                w->index = tmp;
+                w->index_size = size;
+            }
+            w->index[w->hdr.block_count].timestamp = w->ext_ts | hdr->timestamp;
+        }
+
+        uint32_t tags_at = w->block_size - w->hdr.block_records;
+        if (w->block_len + reclen > tags_at) {
+            uint32_t size = (w->block_size - w->hdr.block_records) * 2 + reclen + w->hdr.block_records;
+            uint8_t *tmp = realloc(w->block, size);
+            if (tmp == NULL)
+                return PM3_EMALLOC;
+            // keep the tags at the end
+            memmove(tmp + size - w->hdr.block_records, tmp + tags_at, w->count);
+            w->block = tmp;
+            w->block_size = size;
+            tags_at = size - w->hdr.block_records;
+        }
+
+        memcpy(w->block + w->block_len, trace + pos, reclen);
+        w->block_len += reclen;
+        w->block[tags_at + w->count] = protocol;
+        w->count++;
+        w->hdr.record_count++;
+        pos += reclen;
+
+        if (w->count == w->hdr.block_records) {
+            int res = tracefile_flush_block(w);
+            if (res != PM3_SUCCESS)
+                return res;
+        }
+    }
+    return PM3_SUCCESS;
+}
+
+int tracefile_finish(tracefile_writer_t *w) {
+
+    int res = tracefile_flush_block(w);
+
+    if (res == PM3_SUCCESS) {
+        size_t n = w->hdr.block_count;
+        if (n && fwrite(w->index, sizeof(tracefile_idx_t), n, w->f) != n)
+            res = PM3_EFILE;
+    }
+
+    if (res == PM3_SUCCESS) {
+        if (tf_seek(w->f, 0, SEEK_SET) != 0 || fwrite(&w->hdr, 1, sizeof(w->hdr), w->f) != sizeof(w->hdr))
+            res = PM3_EFILE;
+    }
+
+    fclose(w->f);
+    free(w->block);
+    free(w->index);
+    w->f = NULL;
+    w->block = NULL;
+    w->index = NULL;
+    return res;
+}
+
+int tracefile_open(const char *path, tracefile_t *tf) {
+
+    memset(tf, 0, sizeof(tracefile_t));
+    tf->cached = UINT32_MAX;
+
+    tf->f = fopen(path, "rb");
+    if (tf->f == NULL) {
+        PrintAndLogEx(WARNING, "file not found or locked. '" _YELLOW_("%s")"'", path);
+        return PM3_EFILE;
+    }
+
+    if (fread(&tf->hdr, 1, sizeof(tf->hdr), tf->f) != sizeof(tf->hdr)
+            || memcmp(tf->hdr.magic, TRACEFILE_MAGIC, sizeof(tf->hdr.magic)) != 0) {
+        PrintAndLogEx(WARNING, "not an indexed trace file " _YELLOW_("%s"), path);
+        tracefile_close(tf);
+        return PM3_EFILE;
+    }
+
+    if (tf->hdr.version != TRACEFILE_VERSION) {
+        PrintAndLogEx(WARNING, "unsupported indexed trace version %u " _YELLOW_("%s"), tf->hdr.version, path);
+        tracefile_close(tf);
+        return PM3_EFILE;
+    }
+
+    if (tf->hdr.block_count) {
+        tf->index = calloc(tf->hdr.block_count, sizeof(tracefile_idx_t));
+        if (tf->index == NULL) {
+            tracefile_close(tf);
+            return PM3_EMALLOC;
+        }
+
+        if (tf_seek(tf->f, tf->hdr.index_offset, SEEK_SET) != 0
+                || fread(tf->index, sizeof(tracefile_idx_t), tf->hdr.block_count, tf->f) != tf->hdr.block_count) {
+            PrintAndLogEx(WARNING, "truncated index in " _YELLOW_("%s"), path);
+            tracefile_close(tf);
+            return PM3_EFILE;
+        }
+    }
+    return PM3_SUCCESS;
+}
+
+void tracefile_close(tracefile_t *tf) {
+    if (tf->f)
+        fclose(tf->f);
+    free(tf->index);
+    free(tf->raw);
+    free(tf->stored);
+    memset(tf, 0, sizeof(tracefile_t));
+    tf->cached = UINT32_MAX;
+}
+
+uint32_t tracefile_find_block(const tracefile_t *tf, uint64_t ts) {
+    // last block starting at or before ts
+    uint32_t lo = 0, hi = tf->hdr.block_count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (tf->index[mid].timestamp <= ts)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int tracefile_grow(uint8_t **buf, uint32_t *size, uint32_t needed) {
+    if (needed <= *size)
+        return PM3_SUCCESS;
+    uint8_t *tmp = realloc(*buf, needed);
+    if (tmp == NULL)
+        return PM3_EMALLOC;
+    *buf = tmp;
+    *size = needed;
+    return PM3_SUCCESS;
+}
+
+int tracefile_read_block(tracefile_t *tf, uint32_t block, const uint8_t **tags, uint8_t **records, uint32_t *records_len) {
+
+    if (block >= tf->hdr.block_count)
+        return PM3_EINVARG;
+
+    const tracefile_idx_t *idx = &tf->index[block];
+
+    if (tf->cached != block) {
+        // the buffers are overwritten below, whatever block they held is gone on any error
+        tf->cached = UINT32_MAX;
+
+        if (idx->count > idx->raw_len || idx->stored_len > idx->raw_len)
+            return PM3_EFILE;
+
+        if (tracefile_grow(&tf->raw, &tf->raw_size, idx->raw_len) != PM3_SUCCESS)
+            return PM3_EMALLOC;
+
+        bool compressed = (idx->stored_len != idx->raw_len);
+        uint8_t *dst = tf->raw;
+        if (compressed) {
+            if (tracefile_grow(&tf->stored, &tf->stored_size, idx->stored_len) != PM3_SUCCESS)
+                return PM3_EMALLOC;
+            dst = tf->stored;
+        }
+
+        if (tf_seek(tf->f, idx->offset, SEEK_SET) != 0 || fread(dst, 1, idx->stored_len, tf->f) != idx->stored_len)
+            return PM3_EFILE;
+
+        if (compressed) {
+            int n = LZ4_decompress_safe((const char *)tf->stored, (char *)tf->raw, idx->stored_len, idx->raw_len);
+            if (n < 0 || (uint32_t)n != idx->raw_len)
+                return PM3_EFILE;
+        }
+        tf->cached = block;
+    }
+
+    *tags = tf->raw;
+    *records = tf->raw + idx->count;
+    *records_len = idx->raw_len - idx->count;
+    return PM3_SUCCESS;
+}
@@ -0,0 +1,96 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Indexed trace files
+//
+// Large traces are stored as blocks of a fixed number of records, each block
+// optionally LZ4 compressed, followed by a sparse index with one entry per
+// block. Records keep the tracelog_hdr_t layout, so a decoded block can be
+// walked like a normal trace buffer.
+//
+//  header      tracefile_hdr_t
+//  block 0     tags[count], records (tracelog_hdr_t, frame, parity) ...
+//  block 1     ...
+//  index       tracefile_idx_t[block_count], at hdr.index_offset
+//
+// Every record carries a protocol tag (protocols.h, 0xFF = raw).
+// Timestamps in the index are 64 bits, a record timestamp smaller than the
+// previous one counts as a wrap of the 32 bit device timestamp.
+// All fields are little endian.
+//-----------------------------------------------------------------------------
+
+#ifndef TRACEFILE_H__
+#define TRACEFILE_H__
+
+#include <stdio.h>
+#include "common.h"
+
+#define TRACEFILE_SUFFIX            ".trcx"
+#define TRACEFILE_MAGIC             "PM3X"
+#define TRACEFILE_VERSION           1
+#define TRACEFILE_FLAG_LZ4          0x01
+#define TRACEFILE_BLOCK_RECORDS     512
+#define TRACEFILE_TAG_RAW           0xFF
+
+typedef struct {
+    uint8_t magic[4];
+    uint8_t version;
+    uint8_t flags;
+    uint16_t rfu;
+    uint32_t block_records;     // records per block, i.e. one index entry every n records
+    uint32_t block_count;
+    uint64_t record_count;
+    uint64_t index_offset;
+} PACKED tracefile_hdr_t;
+
+typedef struct {
+    uint64_t timestamp;         // extended timestamp of the first record in the block
+    uint64_t offset;            // file offset of the block
+    uint32_t count;             // records in block
+    uint32_t raw_len;           // tags + records
+    uint32_t stored_len;        // equals raw_len when the block isn't compressed
+    uint32_t rfu;
+} PACKED tracefile_idx_t;
+
+typedef struct {
+    FILE *f;
+    tracefile_hdr_t hdr;
+    tracefile_idx_t *index;
+    uint32_t index_size;
+    uint8_t *block;             // tags followed by records of the pending block
+    uint32_t block_len;
+    uint32_t block_size;
+    uint32_t count;
+    uint32_t last_ts;
+    uint64_t ext_ts;
+} tracefile_writer_t;
+
+typedef struct {
+    FILE *f;
+    tracefile_hdr_t hdr;
+    tracefile_idx_t *index;
+    uint32_t cached;            // block currently decoded, UINT32_MAX if none
+    uint8_t *raw;
+    uint32_t raw_size;
+    uint8_t *stored;
+    uint32_t stored_size;
+} tracefile_t;
+
+int tracefile_create(tracefile_writer_t *w, const char *path, uint32_t block_records, bool compress);
+// appends complete records of a tracelog buffer, all tagged with protocol. Trailing partial records are ignored
+int tracefile_append(tracefile_writer_t *w, const uint8_t *trace, uint32_t len, uint8_t protocol);
+int tracefile_finish(tracefile_writer_t *w);
+
+int tracefile_open(const char *path, tracefile_t *tf);
+void tracefile_close(tracefile_t *tf);
+
+// index of the last block starting at or before extended timestamp ts, 0 when ts is before the first.
+// Records of that block before ts are for the caller to skip
+uint32_t tracefile_find_block(const tracefile_t *tf, uint64_t ts);
+
+// decodes a block, pointers stay valid until the next call
+int tracefile_read_block(tracefile_t *tf, uint32_t block, const uint8_t **tags, uint8_t **records, uint32_t *records_len);
+
+#endif
@@ -50,6 +50,7 @@ bool showDemod = true;
 pthread_mutex_t print_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static void fPrintAndLog(FILE *stream, const char *fmt, ...);
+static size_t print_filter_line(const char *src, size_t n, char *out, size_t outsize, char *log, size_t logsize);
 
 // needed by flasher, so let's put it here instead of fileutils.c
 int searchHomeFilePath(char **foundpath, const char *subdir, const char *filename, bool create_home) {
@@ -175,6 +176,7 @@ void PrintAndLogOptions(const char *str[][2], size_t size, size_t space) {
 }
 
 static uint8_t PrintAndLogEx_spinidx = 0;
+static __thread print_capture_t *g_print_capture = NULL;
 
 void PrintAndLogEx(logLevel_t level, const char *fmt, ...) {
 
@@ -187,8 +189,9 @@ void PrintAndLogEx(logLevel_t level, const char *fmt, ...) {
         return;
 
     char prefix[40] = {0};
-    char buffer[MAX_PRINT_BUFFER] = {0};
-    char buffer2[MAX_PRINT_BUFFER + sizeof(prefix)] = {0};
+    char buffer[MAX_PRINT_BUFFER];
+    char buffer2[MAX_PRINT_BUFFER + sizeof(prefix)];
+    buffer2[0] = '\0';
     char *token = NULL;
     char *tmp_ptr = NULL;
     FILE *stream = stdout;
@@ -267,14 +270,13 @@ void PrintAndLogEx(logLevel_t level, const char *fmt, ...) {
 
         token = strtok_r(buffer, delim, &tmp_ptr);
 
-        while (token != NULL) {
-
-            size_t size = strlen(buffer2);
+        size_t size = 0;
+        while (token != NULL && size < sizeof(buffer2)) {
 
             if (strlen(token))
-                snprintf(buffer2 + size, sizeof(buffer2) - size, "%s%s\n", prefix, token);
+                size += snprintf(buffer2 + size, sizeof(buffer2) - size, "%s%s\n", prefix, token);
             else
-                snprintf(buffer2 + size, sizeof(buffer2) - size, "\n");
+                size += snprintf(buffer2 + size, sizeof(buffer2) - size, "\n");
 
             token = strtok_r(NULL, delim, &tmp_ptr);
         }
@@ -282,11 +284,12 @@ void PrintAndLogEx(logLevel_t level, const char *fmt, ...) {
     } else {
         snprintf(buffer2, sizeof(buffer2), "%s%s", prefix, buffer);
         if (level == INPLACE) {
-            char buffer3[sizeof(buffer2)] = {0};
-            char buffer4[sizeof(buffer2)] = {0};
-            memcpy_filter_ansi(buffer3, buffer2, sizeof(buffer2), !session.supports_colors);
-            memcpy_filter_emoji(buffer4, buffer3, sizeof(buffer3), session.emoji_mode);
-            fprintf(stream, "\r%s", buffer4);
+            // progress spinners aren't worth keeping
+            if (g_print_capture)
+                return;
+            char buffer3[sizeof(buffer2) * 2];
+            print_filter_line(buffer2, strlen(buffer2), buffer3, sizeof(buffer3), NULL, 0);
+            fprintf(stream, "\r%s", buffer3);
             fflush(stream);
         } else {
             fPrintAndLog(stream, "%s", buffer2);
@@ -294,49 +297,199 @@ void PrintAndLogEx(logLevel_t level, const char *fmt, ...) {
     }
 }
 
-static void fPrintAndLog(FILE *stream, const char *fmt, ...) {
-    va_list argptr;
-    static FILE *logfile = NULL;
-    static int logging = 1;
-    char buffer[MAX_PRINT_BUFFER] = {0};
-    char buffer2[MAX_PRINT_BUFFER] = {0};
-    char buffer3[MAX_PRINT_BUFFER] = {0};
-    // lock this section to avoid interlacing prints from different threads
-    pthread_mutex_lock(&print_lock);
-    bool linefeed = true;
+// Log file writer. The printing threads append their lines to a queue and one
+// thread writes the queue out in batches, so the printing threads neither wait
+// on the disk nor flush the file for each line. The writer waits up to
+// session.log_flush_ms for a batch to fill, 0 writes out as soon as it can.
+// Whatever is queued is written before the client exits.
+#define LOG_QUEUE_SIZE (256 * 1024)
+
+static FILE *logfile = NULL;
+static int logging = 1;
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t data;        // lines queued or stop
+    pthread_cond_t room;        // queue taken by the writer
+    char *queue;
+    char *batch;
+    size_t len;
+    bool running;
+    bool stop;
+} g_log = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .data = PTHREAD_COND_INITIALIZER,
+    .room = PTHREAD_COND_INITIALIZER,
+};
+
+static void *log_writer(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_log.lock);
+    while (true) {
+        while (g_log.len == 0 && g_log.stop == false)
+            pthread_cond_wait(&g_log.data, &g_log.lock);
+
+        if (g_log.len == 0)
+            break;
 
-    if (logging && session.incognito) {
-        logging = 0;
+        // more lines join the batch until it's half full or the flush interval is over
+        uint32_t ms = session.log_flush_ms;
+        if (ms && g_log.stop == false) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += ms / 1000;
+            deadline.tv_nsec += (ms % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            while (g_log.stop == false && g_log.len < LOG_QUEUE_SIZE / 2) {
+                if (pthread_cond_timedwait(&g_log.data, &g_log.lock, &deadline) != 0)
+                    break;
+            }
+        }
+
+        char *batch = g_log.queue;
+        size_t len = g_log.len;
+        g_log.queue = g_log.batch;
+        g_log.batch = batch;
+        g_log.len = 0;
+        pthread_cond_broadcast(&g_log.room);
+        pthread_mutex_unlock(&g_log.lock);
+
+        fwrite(batch, 1, len, logfile);
+        fflush(logfile);
+
+        pthread_mutex_lock(&g_log.lock);
     }
-    if ((g_printAndLog & PRINTANDLOG_LOG) && logging && !logfile) {
-        char *my_logfile_path = NULL;
-        char filename[40];
-        struct tm *timenow;
-        time_t now = time(NULL);
-        timenow = gmtime(&now);
-        strftime(filename, sizeof(filename), PROXLOG, timenow);
-        if (searchHomeFilePath(&my_logfile_path, LOGS_SUBDIR, filename, true) != PM3_SUCCESS) {
-            printf(_YELLOW_("[-]") " Logging disabled!\n");
-            my_logfile_path = NULL;
+    pthread_mutex_unlock(&g_log.lock);
+    return NULL;
+}
+
+static void log_writer_stop(void) {
+    pthread_mutex_lock(&g_log.lock);
+    if (g_log.running == false) {
+        pthread_mutex_unlock(&g_log.lock);
+        return;
+    }
+    g_log.stop = true;
+    pthread_cond_signal(&g_log.data);
+    pthread_mutex_unlock(&g_log.lock);
+
+    pthread_join(g_log.thread, NULL);
+    g_log.running = false;
+}
+
+static bool log_writer_start(void) {
+    g_log.queue = malloc(LOG_QUEUE_SIZE);
+    g_log.batch = malloc(LOG_QUEUE_SIZE);
+    if (g_log.queue == NULL || g_log.batch == NULL) {
+        free(g_log.queue);
+        free(g_log.batch);
+        g_log.queue = NULL;
+        g_log.batch = NULL;
+        return false;
+    }
+    if (pthread_create(&g_log.thread, NULL, log_writer, NULL) != 0) {
+        free(g_log.queue);
+        free(g_log.batch);
+        g_log.queue = NULL;
+        g_log.batch = NULL;
+        return false;
+    }
+
+    g_log.running = true;
+    atexit(log_writer_stop);
+    return true;
+}
+
+static void log_writer_queue(const char *line, size_t len, bool linefeed) {
+    size_t n = len + (linefeed ? 1 : 0);
+
+    if (g_log.running == false) {
+        fwrite(line, 1, len, logfile);
+        if (linefeed)
+            fputc('\n', logfile);
+        fflush(logfile);
+        return;
+    }
+
+    pthread_mutex_lock(&g_log.lock);
+    while (g_log.len + n > LOG_QUEUE_SIZE)
+        pthread_cond_wait(&g_log.room, &g_log.lock);
+
+    size_t before = g_log.len;
+    memcpy(g_log.queue + g_log.len, line, len);
+    g_log.len += len;
+    if (linefeed)
+        g_log.queue[g_log.len++] = '\n';
+
+    // wake the writer when a batch starts and when it's worth writing right away
+    if (before == 0 || (before < LOG_QUEUE_SIZE / 2 && g_log.len >= LOG_QUEUE_SIZE / 2))
+        pthread_cond_signal(&g_log.data);
+    pthread_mutex_unlock(&g_log.lock);
+}
+
+static void log_open(void) {
+    char *my_logfile_path = NULL;
+    char filename[40];
+    struct tm *timenow;
+    time_t now = time(NULL);
+    timenow = gmtime(&now);
+    strftime(filename, sizeof(filename), PROXLOG, timenow);
+    if (searchHomeFilePath(&my_logfile_path, LOGS_SUBDIR, filename, true) != PM3_SUCCESS) {
+        printf(_YELLOW_("[-]") " Logging disabled!\n");
+        my_logfile_path = NULL;
+        logging = 0;
+    } else {
+        logfile = fopen(my_logfile_path, "a");
+        if (logfile == NULL) {
+            printf(_YELLOW_("[-]") " Can't open logfile %s, logging disabled!\n", my_logfile_path);
             logging = 0;
         } else {
-            logfile = fopen(my_logfile_path, "a");
-            if (logfile == NULL) {
-                printf(_YELLOW_("[-]") " Can't open logfile %s, logging disabled!\n", my_logfile_path);
-                logging = 0;
-            } else {
-
-                if (session.supports_colors) {
-                    printf("["_YELLOW_("=")"] Session log " _YELLOW_("%s") "\n", my_logfile_path);
-                } else {
-                    printf("[=] Session log %s\n", my_logfile_path);
-                }
 
+            if (session.supports_colors) {
+                printf("["_YELLOW_("=")"] Session log " _YELLOW_("%s") "\n", my_logfile_path);
+            } else {
+                printf("[=] Session log %s\n", my_logfile_path);
             }
-            free(my_logfile_path);
+
+            // written from the calling thread if the writer can't start
+            log_writer_start();
         }
+        free(my_logfile_path);
+    }
+}
+
+// Filters and writes one line. Formatting and filtering is done by the calling
+// thread on its own buffers, only the console write and the log queueing are
+// done under print_lock.
+static void print_line(FILE *stream, const char *line) {
+    size_t len = strlen(line);
+    bool linefeed = true;
+    if (len > 0 && line[len - 1] == NOLF[0]) {
+        linefeed = false;
+        len--;
+    }
+
+    if (logging && session.incognito) {
+        logging = 0;
     }
 
+    bool to_print = (g_printAndLog & PRINTANDLOG_PRINT);
+    bool to_log = (g_printAndLog & PRINTANDLOG_LOG) && logging;
+
+    char out[MAX_PRINT_BUFFER * 2];
+    char logline[MAX_PRINT_BUFFER * 2];
+    size_t loglen = print_filter_line(line, len, out, sizeof(out), to_log ? logline : NULL, sizeof(logline));
+
+    // lock this section to avoid interlacing prints from different threads
+    pthread_mutex_lock(&print_lock);
+
+    if (to_log && !logfile) {
+        log_open();
+    }
 
 // If there is an incoming message from the hardware (eg: lf hid read) in
 // the background (while the prompt is displayed and accepting user input),
@@ -356,20 +509,10 @@ static void fPrintAndLog(FILE *stream, const char *fmt, ...) {
     }
 #endif
 
-    va_start(argptr, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, argptr);
-    va_end(argptr);
-    if (strlen(buffer) > 0 && buffer[strlen(buffer) - 1] == NOLF[0]) {
-        linefeed = false;
-        buffer[strlen(buffer) - 1] = 0;
-    }
-    bool filter_ansi = !session.supports_colors;
-    memcpy_filter_ansi(buffer2, buffer, sizeof(buffer), filter_ansi);
-    if (g_printAndLog & PRINTANDLOG_PRINT) {
-        memcpy_filter_emoji(buffer3, buffer2, sizeof(buffer2), session.emoji_mode);
-        fprintf(stream, "%s", buffer3);
+    if (to_print) {
+        fputs(out, stream);
         if (linefeed)
-            fprintf(stream, "\n");
+            fputc('\n', stream);
     }
 
 #ifdef RL_STATE_READCMD
@@ -383,17 +526,8 @@ static void fPrintAndLog(FILE *stream, const char *fmt, ...) {
     }
 #endif
 
-    if ((g_printAndLog & PRINTANDLOG_LOG) && logging && logfile) {
-        memcpy_filter_emoji(buffer3, buffer2, sizeof(buffer2), ALTTEXT);
-        if (filter_ansi) { // already done
-            fprintf(logfile, "%s", buffer3);
-        } else {
-            memcpy_filter_ansi(buffer, buffer3, sizeof(buffer3), true);
-            fprintf(logfile, "%s", buffer);
-        }
-        if (linefeed)
-            fprintf(logfile, "\n");
-        fflush(logfile);
+    if (to_log && logging && logfile) {
+        log_writer_queue(logline, loglen, linefeed);
     }
 
     if (flushAfterWrite)
@@ -403,6 +537,53 @@ static void fPrintAndLog(FILE *stream, const char *fmt, ...) {
     pthread_mutex_unlock(&print_lock);
 }
 
+static void fPrintAndLog(FILE *stream, const char *fmt, ...) {
+    va_list argptr;
+    char buffer[MAX_PRINT_BUFFER];
+
+    va_start(argptr, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, argptr);
+    va_end(argptr);
+
+    if (g_print_capture) {
+        print_capture_t *cap = g_print_capture;
+        size_t n = strlen(buffer) + 1;
+        if (cap->len + n > cap->size) {
+            size_t size = MAX(cap->size * 2, cap->len + n + 1024);
+            char *tmp = realloc(cap->buf, size);
+            if (tmp == NULL)
+                return;
+            cap->buf = tmp;
+            cap->size = size;
+        }
+        memcpy(cap->buf + cap->len, buffer, n);
+        cap->len += n;
+        return;
+    }
+
+    print_line(stream, buffer);
+}
+
+print_capture_t *PrintAndLogCapture(print_capture_t *cap) {
+    print_capture_t *prev = g_print_capture;
+    g_print_capture = cap;
+    return prev;
+}
+
+void PrintAndLogReplay(print_capture_t *cap) {
+    for (size_t pos = 0; cap->buf && pos < cap->len; pos += strlen(cap->buf + pos) + 1) {
+        fPrintAndLog(stdout, "%s", cap->buf + pos);
+    }
+    PrintAndLogCaptureFree(cap);
+}
+
+void PrintAndLogCaptureFree(print_capture_t *cap) {
+    free(cap->buf);
+    cap->buf = NULL;
+    cap->len = 0;
+    cap->size = 0;
+}
+
 void SetFlushAfterWrite(bool value) {
     flushAfterWrite = value;
 }
@@ -555,6 +736,170 @@ void memcpy_filter_emoji(void *dest, const void *src, size_t n, emojiMode_t mode
     }
 }
 
+// ANSI sequence filter fed one char at a time, drops what memcpy_filter_ansi drops.
+// Returns how many chars come out, an ESC held back until the next char shows it
+// doesn't start a sequence and that char.
+enum {ANSI_NONE, ANSI_ESC, ANSI_PARAM, ANSI_INTERMEDIATE};
+
+static int ansi_filter_step(uint8_t *state, char c, char *out) {
+    uint8_t u = (uint8_t)c;
+    switch (*state) {
+        case ANSI_ESC:
+            if ((u >= 0x40) && (u <= 0x5F)) { // entering ANSI sequence
+                *state = (u == '[') ? ANSI_PARAM : ANSI_NONE;
+                return 0;
+            }
+            out[0] = '\x1b';
+            if (u == 0x1b)
+                return 1;
+            *state = ANSI_NONE;
+            out[1] = c;
+            return 2;
+        case ANSI_PARAM:
+            if ((u >= 0x30) && (u <= 0x3F)) // parameter bytes
+                return 0;
+        // fall through
+        case ANSI_INTERMEDIATE:
+            if ((u >= 0x20) && (u <= 0x2F)) { // intermediate bytes
+                *state = ANSI_INTERMEDIATE;
+                return 0;
+            }
+            *state = ANSI_NONE;
+            if ((u >= 0x40) && (u <= 0x7F)) // final byte
+                return 0;
+            out[0] = c;
+            return 1;
+        default:
+            if (u == 0x1b) {
+                *state = ANSI_ESC;
+                return 0;
+            }
+            out[0] = c;
+            return 1;
+    }
+}
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t size;
+    bool strip;         // drop ANSI sequences on the way in
+    uint8_t ansi;
+} filter_out_t;
+
+static void filter_out_put(filter_out_t *o, const char *s, size_t n) {
+    if (o->buf == NULL)
+        return;
+
+    for (size_t i = 0; i < n; i++) {
+        char c[2] = {s[i], 0};
+        int k = 1;
+        if (o->strip)
+            k = ansi_filter_step(&o->ansi, s[i], c);
+        for (int j = 0; j < k; j++) {
+            if (o->len + 1 < o->size)
+                o->buf[o->len++] = c[j];
+        }
+    }
+}
+
+static void filter_out_end(filter_out_t *o) {
+    if (o->buf == NULL)
+        return;
+
+    // a NUL resolves an ESC held back, then ends the line
+    char c[2];
+    if (o->strip && ansi_filter_step(&o->ansi, '\0', c) == 2 && o->len + 1 < o->size)
+        o->buf[o->len++] = c[0];
+    o->buf[o->len] = '\0';
+}
+
+// Console and log copies of a line in a single pass. The console copy is
+// memcpy_filter_ansi then memcpy_filter_emoji in the session modes, the log
+// copy has no ANSI sequences and the emoji alt text, as the log always had.
+// Both are NUL terminated, log may be NULL. Returns the length of the log copy.
+static size_t print_filter_line(const char *src, size_t n, char *out, size_t outsize, char *log, size_t logsize) {
+    bool filter_ansi = !session.supports_colors;
+    emojiMode_t mode = session.emoji_mode;
+
+    filter_out_t con = {out, 0, outsize, false, ANSI_NONE};
+    filter_out_t lg = {log, 0, logsize, !filter_ansi, ANSI_NONE};
+
+    // aliases only matter for the log
+    bool emojis = (mode != ALIAS) || (log != NULL);
+
+    uint8_t ansi = ANSI_NONE;
+    char token[256];
+    uint8_t token_length = 0;
+
+    // the NUL at the end goes through the ANSI filter too, it resolves a held back ESC
+    for (size_t i = 0; i <= n; i++) {
+        char c[2];
+        int k = 1;
+        c[0] = (i < n) ? src[i] : '\0';
+        if (filter_ansi)
+            k = ansi_filter_step(&ansi, c[0], c);
+
+        for (int j = 0; j < k; j++) {
+            char current_char = c[j];
+            if (current_char == '\0') {
+                filter_out_put(&con, token, token_length);
+                filter_out_put(&lg, token, token_length);
+                token_length = 0;
+                break;
+            }
+
+            if (emojis == false) {
+                filter_out_put(&con, &current_char, 1);
+                continue;
+            }
+
+            if (token_length == 0) {
+                // starting a new token.
+                if (current_char == ':') {
+                    token[0] = current_char;
+                    token_length = 1;
+                } else { // not starting a new token.
+                    filter_out_put(&con, &current_char, 1);
+                    filter_out_put(&lg, &current_char, 1);
+                }
+            } else if (current_char == ':') {
+                // finishing the current token.
+                const char *emojified_token = NULL;
+                uint8_t emojified_token_length = 0;
+                token[token_length] = current_char;
+                if (emojify_token(token, token_length + 1, &emojified_token, &emojified_token_length, ALTTEXT) == false) {
+                    // nothing changed? we still need the ending ':' as it might serve for an upcoming emoji
+                    filter_out_put(&con, token, token_length);
+                    filter_out_put(&lg, token, token_length);
+                    token[0] = current_char;
+                    token_length = 1;
+                } else {
+                    filter_out_put(&lg, emojified_token, emojified_token_length);
+                    if (mode == ALIAS) {
+                        filter_out_put(&con, token, token_length + 1);
+                    } else {
+                        emojify_token(token, token_length + 1, &emojified_token, &emojified_token_length, mode);
+                        filter_out_put(&con, emojified_token, emojified_token_length);
+                    }
+                    token_length = 0;
+                }
+            } else if (token_charset(current_char)) { // continuing the current token.
+                token[token_length++] = current_char;
+            } else { // dropping the current token.
+                token[token_length++] = current_char;
+                filter_out_put(&con, token, token_length);
+                filter_out_put(&lg, token, token_length);
+                token_length = 0;
+            }
+        }
+    }
+
+    filter_out_end(&con);
+    filter_out_end(&lg);
+    return lg.len;
+}
+
 /*
 // If reactivated, beware it doesn't compile on Android (DXL)
 void iceIIR_Butterworth(int *data, const size_t len) {
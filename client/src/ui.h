@@ -46,6 +46,7 @@ typedef struct {
     clientdebugLevel_t client_debug_level;
 //    uint8_t device_debug_level;
     char *history_path;
+    uint32_t log_flush_ms;  // the log file is written in batches of this many ms, 0 as soon as possible
 } session_arg_t;
 
 extern session_arg_t session;
@@ -67,6 +68,19 @@ int searchHomeFilePath(char **foundpath, const char *subdir, const char *filenam
 
 extern pthread_mutex_t print_lock;
 
+// Output of PrintAndLogEx kept aside by a worker thread, replayed later from the main thread
+typedef struct {
+    char *buf;          // one NUL terminated entry per printed line
+    size_t len;
+    size_t size;
+} print_capture_t;
+
+// captures what the calling thread prints into cap, NULL to print again. Returns the previous capture
+print_capture_t *PrintAndLogCapture(print_capture_t *cap);
+// prints the captured lines and frees them
+void PrintAndLogReplay(print_capture_t *cap);
+void PrintAndLogCaptureFree(print_capture_t *cap);
+
 void iceIIR_Butterworth(int *data, const size_t len);
 void iceSimple_Filter(int *data, const size_t len, uint8_t k);
 #ifdef __cplusplus
@@ -200,14 +200,15 @@ void print_hex_break(const uint8_t *data, const size_t len, uint8_t breaks) {
     PrintAndLogEx(NORMAL, "");
 }
 
+// sprint_* results live in per thread buffers, valid until the next call from the same thread
 char *sprint_hex(const uint8_t *data, const size_t len) {
-    static char buf[UTIL_BUFFER_SIZE_SPRINT - 3] = {0};
+    static __thread char buf[UTIL_BUFFER_SIZE_SPRINT - 3] = {0};
     hex_to_buffer((uint8_t *)buf, data, len, sizeof(buf) - 1, 0, 1, true);
     return buf;
 }
 
 char *sprint_hex_inrow_ex(const uint8_t *data, const size_t len, const size_t min_str_len) {
-    static char buf[UTIL_BUFFER_SIZE_SPRINT] = {0};
+    static __thread char buf[UTIL_BUFFER_SIZE_SPRINT] = {0};
     hex_to_buffer((uint8_t *)buf, data, len, sizeof(buf) - 1, min_str_len, 0, true);
     return buf;
 }
@@ -216,7 +217,7 @@ char *sprint_hex_inrow(const uint8_t *data, const size_t len) {
     return sprint_hex_inrow_ex(data, len, 0);
 }
 char *sprint_hex_inrow_spaces(const uint8_t *data, const size_t len, size_t spaces_between) {
-    static char buf[UTIL_BUFFER_SIZE_SPRINT] = {0};
+    static __thread char buf[UTIL_BUFFER_SIZE_SPRINT] = {0};
     hex_to_buffer((uint8_t *)buf, data, len, sizeof(buf) - 1, 0, spaces_between, true);
     return buf;
 }
@@ -233,7 +234,7 @@ char *sprint_bin_break(const uint8_t *data, const size_t len, const uint8_t brea
 
     //PrintAndLogEx(NORMAL, "(sprint_bin_break) rowlen %d", rowlen);
 
-    static char buf[MAX_BIN_BREAK_LENGTH]; // 3072 + end of line characters if broken at 8 bits
+    static __thread char buf[MAX_BIN_BREAK_LENGTH]; // 3072 + end of line characters if broken at 8 bits
     //clear memory
     memset(buf, 0x00, sizeof(buf));
     char *tmp = buf;
@@ -300,7 +301,7 @@ char *sprint_bin(const uint8_t *data, const size_t len) {
 }
 
 char *sprint_hex_ascii(const uint8_t *data, const size_t len) {
-    static char buf[UTIL_BUFFER_SIZE_SPRINT];
+    static __thread char buf[UTIL_BUFFER_SIZE_SPRINT];
     char *tmp = buf;
     memset(buf, 0x00, UTIL_BUFFER_SIZE_SPRINT);
     size_t max_len = (len > 1010) ? 1010 : len;
@@ -323,7 +324,7 @@ char *sprint_hex_ascii(const uint8_t *data, const size_t len) {
 }
 
 char *sprint_ascii_ex(const uint8_t *data, const size_t len, const size_t min_str_len) {
-    static char buf[UTIL_BUFFER_SIZE_SPRINT];
+    static __thread char buf[UTIL_BUFFER_SIZE_SPRINT];
     char *tmp = buf;
     memset(buf, 0x00, UTIL_BUFFER_SIZE_SPRINT);
     size_t max_len = (len > 1010) ? 1010 : len;
@@ -417,7 +418,7 @@ void num_to_bytebitsLSBF(uint64_t n, size_t len, uint8_t *dest) {
 // hh,gg,ff,ee,dd,cc,bb,aa, pp,oo,nn,mm,ll,kk,jj,ii
 // up to 64 bytes or 512 bits
 uint8_t *SwapEndian64(const uint8_t *src, const size_t len, const uint8_t blockSize) {
-    static uint8_t buf[64];
+    static __thread uint8_t buf[64];
     memset(buf, 0x00, 64);
     uint8_t *tmp = buf;
     for (uint8_t block = 0; block < (uint8_t)(len / blockSize); block++) {
@@ -0,0 +1,16 @@
+#include "common.h"
+/* Generated file, do not edit */
+#ifndef ON_DEVICE
+#define SECTVERSINFO
+#else
+#define SECTVERSINFO __attribute__((section(".version_information")))
+#endif
+
+const struct version_information SECTVERSINFO version_information = {
+    VERSION_INFORMATION_MAGIC,
+    1,
+    1,
+    0,
+    "RRG/Iceman/master/67436a7-dirty",
+    "2026-10-19 00:59:53",
+};
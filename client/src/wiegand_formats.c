@@ -8,6 +8,7 @@
 // HID card format packing/unpacking routines
 //-----------------------------------------------------------------------------
 #include "wiegand_formats.h"
+#include <pthread.h>
 #include "commonutil.h"
 
 static bool Pack_H10301(wiegand_card_t *card, wiegand_message_t *packed) {
@@ -26,18 +27,6 @@ static bool Pack_H10301(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_H10301(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-    if (packed->Length != 26) return false; // Wrong length? Stop here.
-
-    card->CardNumber = (packed->Bot >> 1) & 0xFFFF;
-    card->FacilityCode = (packed->Bot >> 17) & 0xFF;
-    card->ParityValid =
-        (oddparity32((packed->Bot >> 1) & 0xFFF) == (packed->Bot & 1)) &&
-        ((evenparity32((packed->Bot >> 13) & 0xFFF) & 1) == ((packed->Bot >> 25) & 1));
-    return true;
-}
-
 static bool Pack_Tecom27(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -52,16 +41,6 @@ static bool Pack_Tecom27(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_Tecom27(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 27) return false; // Wrong length? Stop here.
-
-    card->CardNumber = get_nonlinear_field(packed, 16, (uint8_t[]) {0, 1, 13, 12, 9, 26, 20, 16, 17, 21, 25, 7, 8, 11, 4, 5});
-    card->FacilityCode = get_nonlinear_field(packed, 10, (uint8_t[]) {15, 19, 24, 23, 22, 18, 6, 10, 14, 3, 2});
-    return true;
-}
-
 static bool Pack_2804W(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -85,20 +64,6 @@ static bool Pack_2804W(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_2804W(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 28) return false; // Wrong length? Stop here.
-
-    card->FacilityCode = get_linear_field(packed, 4, 8);
-    card->CardNumber = get_linear_field(packed, 12, 15);
-    card->ParityValid =
-        (get_bit_by_position(packed, 0) == evenparity32(get_linear_field(packed, 1, 13))) &&
-    (get_bit_by_position(packed, 2) == oddparity32(get_nonlinear_field(packed, 16, (uint8_t[]) {4, 5, 7, 8, 10, 11, 13, 14, 16, 17, 19, 20, 22, 23, 25, 26}))) &&
-    (get_bit_by_position(packed, 27) == oddparity32(get_linear_field(packed, 0, 27)));
-    return true;
-}
-
 static bool Pack_ATSW30(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -119,19 +84,6 @@ static bool Pack_ATSW30(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_ATSW30(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 30) return false; // Wrong length? Stop here.
-
-    card->FacilityCode = get_linear_field(packed, 1, 12);
-    card->CardNumber = get_linear_field(packed, 13, 16);
-    card->ParityValid =
-        (get_bit_by_position(packed, 0) == evenparity32(get_linear_field(packed, 1, 12))) &&
-        (get_bit_by_position(packed, 29) == oddparity32(get_linear_field(packed, 13, 16)));
-    return true;
-}
-
 static bool Pack_ADT31(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -147,15 +99,6 @@ static bool Pack_ADT31(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_ADT31(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 31) return false; // Wrong length? Stop here.
-    card->FacilityCode = get_linear_field(packed, 1, 4);
-    card->CardNumber = get_linear_field(packed, 5, 23);
-    return true;
-}
-
 static bool Pack_Kastle(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -174,21 +117,6 @@ static bool Pack_Kastle(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_Kastle(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 32) return false; // Wrong length? Stop here.
-    if (get_bit_by_position(packed, 1) != 1) return false; // Always 1 in this format
-
-    card->IssueLevel = get_linear_field(packed, 2, 5);
-    card->FacilityCode = get_linear_field(packed, 7, 8);
-    card->CardNumber = get_linear_field(packed, 15, 16);
-    card->ParityValid =
-        (get_bit_by_position(packed, 0) == evenparity32(get_linear_field(packed, 1, 16))) &&
-        (get_bit_by_position(packed, 31) == oddparity32(get_linear_field(packed, 14, 17)));
-    return true;
-}
-
 static bool Pack_D10202(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -205,19 +133,6 @@ static bool Pack_D10202(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_D10202(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 33) return false; // Wrong length? Stop here.
-
-    card->CardNumber = get_linear_field(packed, 8, 24);
-    card->FacilityCode = get_linear_field(packed, 1, 7);
-    card->ParityValid =
-        (get_bit_by_position(packed, 0) == evenparity32(get_linear_field(packed, 1, 16))) &&
-        (get_bit_by_position(packed, 32) == oddparity32(get_linear_field(packed, 16, 16)));
-    return true;
-}
-
 static bool Pack_H10306(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -235,19 +150,6 @@ static bool Pack_H10306(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_H10306(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 34) return false; // Wrong length? Stop here.
-
-    card->CardNumber = (packed->Bot >> 1) & 0xFFFF;
-    card->FacilityCode = ((packed->Mid & 1) << 15) | ((packed->Bot >> 17) & 0xFF);
-    card->ParityValid =
-        ((evenparity32((packed->Mid & 0x00000001) ^ (packed->Bot & 0xFFFE0000)) & 1) == ((packed->Mid >> 1) & 1)) &&
-        ((oddparity32(packed->Bot & 0x0001FFFE) & 1) == ((packed->Bot & 1)));
-    return true;
-}
-
 static bool Pack_N10002(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -262,16 +164,6 @@ static bool Pack_N10002(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_N10002(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 34) return false; // Wrong length? Stop here.
-
-    card->CardNumber = get_linear_field(packed, 17, 16);
-    card->FacilityCode = get_linear_field(packed, 9, 8);
-    return true;
-}
-
 static bool Pack_C1k35s(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -290,20 +182,6 @@ static bool Pack_C1k35s(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_C1k35s(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 35) return false; // Wrong length? Stop here.
-
-    card->CardNumber = (packed->Bot >> 1) & 0x000FFFFF;
-    card->FacilityCode = ((packed->Mid & 1) << 11) | ((packed->Bot >> 21));
-    card->ParityValid =
-        (evenparity32((packed->Mid & 0x00000001) ^ (packed->Bot & 0xB6DB6DB6)) == ((packed->Mid >> 1) & 1)) &&
-        (oddparity32((packed->Mid & 0x00000003) ^ (packed->Bot & 0x6DB6DB6C)) == ((packed->Bot >> 0) & 1)) &&
-        (oddparity32((packed->Mid & 0x00000003) ^ (packed->Bot & 0xFFFFFFFF)) == ((packed->Mid >> 2) & 1));
-    return true;
-}
-
 static bool Pack_H10320(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -332,30 +210,6 @@ static bool Pack_H10320(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_H10320(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 36) return false; // Wrong length? Stop here.
-
-    // This card is BCD-encoded rather than binary. Get the 4-bit groups independently.
-    for (uint32_t idx = 0; idx < 8; idx++) {
-        uint64_t val = get_linear_field(packed, idx * 4, 4);
-        if (val > 9) {
-            // Violation of BCD; Zero and exit.
-            card->CardNumber = 0;
-            return false;
-        } else {
-            card->CardNumber += val * pow(10, 7 - idx);
-        }
-    }
-    card->ParityValid =
-    (get_bit_by_position(packed, 32) == evenparity32(get_nonlinear_field(packed, 8, (uint8_t[]) {0, 4, 8, 12, 16, 20, 24, 28}))) &&
-    (get_bit_by_position(packed, 33) ==  oddparity32(get_nonlinear_field(packed, 8, (uint8_t[]) {1, 5, 9, 13, 17, 21, 25, 29}))) &&
-    (get_bit_by_position(packed, 34) == evenparity32(get_nonlinear_field(packed, 8, (uint8_t[]) {2, 6, 10, 14, 18, 22, 28, 30}))) &&
-    (get_bit_by_position(packed, 35) == evenparity32(get_nonlinear_field(packed, 8, (uint8_t[]) {3, 7, 11, 15, 19, 23, 29, 31})));
-    return true;
-}
-
 static bool Pack_S12906(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -373,20 +227,6 @@ static bool Pack_S12906(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_S12906(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 36) return false; // Wrong length? Stop here.
-
-    card->FacilityCode = get_linear_field(packed, 1, 8);
-    card->IssueLevel = get_linear_field(packed, 9, 2);
-    card->CardNumber = get_linear_field(packed, 11, 24);
-    card->ParityValid =
-        (get_bit_by_position(packed, 0) == oddparity32(get_linear_field(packed, 1, 17))) &&
-        (get_bit_by_position(packed, 35) == oddparity32(get_linear_field(packed, 17, 18)));
-    return true;
-}
-
 static bool Pack_Sie36(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -407,19 +247,6 @@ static bool Pack_Sie36(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_Sie36(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 36) return false; // Wrong length? Stop here.
-
-    card->FacilityCode = get_linear_field(packed, 1, 18);
-    card->CardNumber = get_linear_field(packed, 19, 16);
-    card->ParityValid =
-    (get_bit_by_position(packed, 0) == oddparity32(get_nonlinear_field(packed, 23, (uint8_t[]) {1, 3, 4, 6, 7, 9, 10, 12, 13, 15, 16, 18, 19, 21, 22, 24, 25, 27, 28, 30, 31, 33, 34}))) &&
-    (get_bit_by_position(packed, 35) == oddparity32(get_nonlinear_field(packed, 23, (uint8_t[]) {1, 2, 4, 5, 7, 8, 10, 11, 13, 14, 16, 17, 19, 20, 22, 23, 25, 26, 28, 29, 31, 32, 34})));
-    return true;
-}
-
 static bool Pack_C15001(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -437,20 +264,6 @@ static bool Pack_C15001(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_C15001(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 36) return false; // Wrong length? Stop here.
-
-    card->OEM = get_linear_field(packed, 1, 10);
-    card->FacilityCode = get_linear_field(packed, 11, 8);
-    card->CardNumber = get_linear_field(packed, 19, 16);
-    card->ParityValid =
-        (get_bit_by_position(packed, 0) == evenparity32(get_linear_field(packed, 1, 17))) &&
-        (get_bit_by_position(packed, 35) == oddparity32(get_linear_field(packed, 18, 17)));
-    return true;
-}
-
 static bool Pack_H10302(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -466,18 +279,6 @@ static bool Pack_H10302(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_H10302(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 37) return false; // Wrong length? Stop here.
-
-    card->CardNumber = get_linear_field(packed, 1, 35);
-    card->ParityValid =
-        (get_bit_by_position(packed, 0) == evenparity32(get_linear_field(packed, 1, 18))) &&
-        (get_bit_by_position(packed, 36) == oddparity32(get_linear_field(packed, 18, 18)));
-    return true;
-}
-
 static bool Pack_H10304(wiegand_card_t *card, wiegand_message_t *packed) {
     memset(packed, 0, sizeof(wiegand_message_t));
 
@@ -495,19 +296,6 @@ static bool Pack_H10304(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_H10304(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 37) return false; // Wrong length? Stop here.
-
-    card->CardNumber = (packed->Bot >> 1) & 0x0007FFFF;
-    card->FacilityCode = ((packed->Mid & 0xF) << 12) | ((packed->Bot >> 20));
-    card->ParityValid =
-        (evenparity32((packed->Mid & 0x0000000F) ^ (packed->Bot & 0xFFFC0000)) == ((packed->Mid >> 4) & 1)) &&
-        (oddparity32(packed->Bot & 0x0007FFFE) == (packed->Bot & 1));
-    return true;
-}
-
 static bool Pack_P10001(wiegand_card_t *card, wiegand_message_t *packed) {
 
     memset(packed, 0, sizeof(wiegand_message_t));
@@ -530,23 +318,6 @@ static bool Pack_P10001(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_P10001(wiegand_message_t *packed, wiegand_card_t *card) {
-
-    memset(card, 0, sizeof(wiegand_card_t));
-
-    if (packed->Length != 40) return false; // Wrong length? Stop here.
-
-    card->CardNumber = get_linear_field(packed, 16, 16);
-    card->FacilityCode = get_linear_field(packed, 4, 12);
-    card->ParityValid = (
-                            get_linear_field(packed, 0, 8) ^
-                            get_linear_field(packed, 8, 8) ^
-                            get_linear_field(packed, 16, 8) ^
-                            get_linear_field(packed, 24, 8)
-                        ) == get_linear_field(packed, 32, 8);
-    return true;
-}
-
 static bool Pack_C1k48s(wiegand_card_t *card, wiegand_message_t *packed) {
 
     memset(packed, 0, sizeof(wiegand_message_t));
@@ -566,39 +337,205 @@ static bool Pack_C1k48s(wiegand_card_t *card, wiegand_message_t *packed) {
     return add_HID_header(packed);
 }
 
-static bool Unpack_C1k48s(wiegand_message_t *packed, wiegand_card_t *card) {
-    memset(card, 0, sizeof(wiegand_card_t));
+// Unpacking is data driven. Each format describes where its fields and parity
+// bits are, positions count from 0 for the first bit sent as for
+// get_linear_field. A field is built from spans of bits, each span shifted to
+// its place in the value. A parity bit lists the bits it covers, or raw masks
+// of the message words for the formats that were defined that way.
+//
+// The parity bits are compiled once into masks over the message words, with
+// the parity bit itself folded in, and sorted by message length. Unpacking a
+// message then checks the parity of all the formats of its length in one pass.
+
+#define WIEGAND_MAX_SPANS   16
+#define WIEGAND_MAX_CHECKS  8
+
+typedef struct {
+    uint8_t first;      // position of the first bit
+    uint8_t len;
+    uint8_t shift;      // of the span's last bit in the value
+} wiegand_span_t;
+
+typedef struct {
+    uint8_t count;
+    wiegand_span_t span[WIEGAND_MAX_SPANS];
+} wiegand_field_t;
+
+typedef struct {
+    uint8_t bit;        // position of the parity bit
+    bool odd;
+    wiegand_field_t covers;
+    uint32_t top, mid, bot;
+} wiegand_parity_t;
+
+struct wiegand_layout_s {
+    uint8_t length;
+    wiegand_field_t fc, cn, issue, oem;
+    bool bcd;           // cn spans are decimal digits, most significant first
+    wiegand_field_t ones;   // bits always set, the format doesn't match otherwise
+    uint8_t nchecks;
+    wiegand_parity_t check[WIEGAND_MAX_CHECKS];
+};
 
-    if (packed->Length != 48) return false; // Wrong length? Stop here.
+#define SPANS(...)          { ARRAYLEN(((const wiegand_span_t[]){__VA_ARGS__})), {__VA_ARGS__} }
+#define LIN(first, len)     SPANS({first, len, 0})
+#define BIT(pos, shift)     {pos, 1, shift}
+#define PAR_EVEN(bit, field)    {bit, false, field, 0, 0, 0}
+#define PAR_ODD(bit, field)     {bit, true, field, 0, 0, 0}
+#define PAR_EVEN_RAW(bit, top, mid, bot)    {bit, false, {0}, top, mid, bot}
+#define PAR_ODD_RAW(bit, top, mid, bot)     {bit, true, {0}, top, mid, bot}
+
+static const wiegand_layout_t Layout_H10301 = {
+    .length = 26, .fc = LIN(1, 8), .cn = LIN(9, 16),
+    .nchecks = 2, .check = { PAR_EVEN(0, LIN(1, 12)), PAR_ODD(25, LIN(13, 12)) },
+};
 
-    card->CardNumber = (packed->Bot >> 1) & 0x007FFFFF;
-    card->FacilityCode = ((packed->Mid & 0x00003FFF) << 8) | ((packed->Bot >> 24));
-    card->ParityValid =
-        (evenparity32((packed->Mid & 0x00001B6D) ^ (packed->Bot & 0xB6DB6DB6)) == ((packed->Mid >> 14) & 1)) &&
-        (oddparity32((packed->Mid & 0x000036DB) ^ (packed->Bot & 0x6DB6DB6C)) == ((packed->Bot >> 0) & 1)) &&
-        (oddparity32((packed->Mid & 0x00007FFF) ^ (packed->Bot & 0xFFFFFFFF)) == ((packed->Mid >> 15) & 1));
-    return true;
-}
+static const wiegand_layout_t Layout_Tecom27 = {
+    .length = 27,
+    .cn = SPANS(BIT(0, 15), BIT(1, 14), BIT(13, 13), BIT(12, 12), BIT(9, 11), BIT(26, 10), BIT(20, 9), BIT(16, 8),
+                BIT(17, 7), BIT(21, 6), BIT(25, 5), BIT(7, 4), BIT(8, 3), BIT(11, 2), BIT(4, 1), BIT(5, 0)),
+    // Pack_Tecom27 lists an 11th bit, 2, which isn't part of the field
+    .fc = SPANS(BIT(15, 9), BIT(19, 8), BIT(24, 7), BIT(23, 6), BIT(22, 5), BIT(18, 4), BIT(6, 3), BIT(10, 2),
+                BIT(14, 1), BIT(3, 0)),
+};
+
+static const wiegand_layout_t Layout_2804W = {
+    .length = 28, .fc = LIN(4, 8), .cn = LIN(12, 15),
+    .nchecks = 3, .check = {
+        PAR_EVEN(0, LIN(1, 13)),
+        PAR_ODD(2, SPANS({4, 2, 0}, {7, 2, 0}, {10, 2, 0}, {13, 2, 0}, {16, 2, 0}, {19, 2, 0}, {22, 2, 0}, {25, 2, 0})),
+        PAR_ODD(27, LIN(0, 27)),
+    },
+};
+
+static const wiegand_layout_t Layout_ATSW30 = {
+    .length = 30, .fc = LIN(1, 12), .cn = LIN(13, 16),
+    .nchecks = 2, .check = { PAR_EVEN(0, LIN(1, 12)), PAR_ODD(29, LIN(13, 16)) },
+};
+
+static const wiegand_layout_t Layout_ADT31 = {
+    .length = 31, .fc = LIN(1, 4), .cn = LIN(5, 23),
+};
+
+static const wiegand_layout_t Layout_Kastle = {
+    .length = 32, .issue = LIN(2, 5), .fc = LIN(7, 8), .cn = LIN(15, 16),
+    .ones = LIN(1, 1),
+    .nchecks = 2, .check = { PAR_EVEN(0, LIN(1, 16)), PAR_ODD(31, LIN(14, 17)) },
+};
+
+static const wiegand_layout_t Layout_D10202 = {
+    .length = 33, .fc = LIN(1, 7), .cn = LIN(8, 24),
+    .nchecks = 2, .check = { PAR_EVEN(0, LIN(1, 16)), PAR_ODD(32, LIN(16, 16)) },
+};
+
+static const wiegand_layout_t Layout_H10306 = {
+    .length = 34, .fc = SPANS(BIT(1, 15), {9, 8, 0}), .cn = LIN(17, 16),
+    .nchecks = 2, .check = {
+        PAR_EVEN_RAW(0, 0, 0x00000001, 0xFFFE0000),
+        PAR_ODD_RAW(33, 0, 0, 0x0001FFFE),
+    },
+};
+
+static const wiegand_layout_t Layout_N10002 = {
+    .length = 34, .fc = LIN(9, 8), .cn = LIN(17, 16),
+};
+
+static const wiegand_layout_t Layout_C1k35s = {
+    .length = 35, .fc = SPANS(BIT(2, 11), {3, 11, 0}), .cn = LIN(14, 20),
+    .nchecks = 3, .check = {
+        PAR_EVEN_RAW(1, 0, 0x00000001, 0xB6DB6DB6),
+        PAR_ODD_RAW(34, 0, 0x00000003, 0x6DB6DB6C),
+        PAR_ODD_RAW(0, 0, 0x00000003, 0xFFFFFFFF),
+    },
+};
+
+static const wiegand_layout_t Layout_C15001 = {
+    .length = 36, .oem = LIN(1, 10), .fc = LIN(11, 8), .cn = LIN(19, 16),
+    .nchecks = 2, .check = { PAR_EVEN(0, LIN(1, 17)), PAR_ODD(35, LIN(18, 17)) },
+};
+
+static const wiegand_layout_t Layout_S12906 = {
+    .length = 36, .fc = LIN(1, 8), .issue = LIN(9, 2), .cn = LIN(11, 24),
+    .nchecks = 2, .check = { PAR_ODD(0, LIN(1, 17)), PAR_ODD(35, LIN(17, 18)) },
+};
+
+static const wiegand_layout_t Layout_Sie36 = {
+    .length = 36, .fc = LIN(1, 18), .cn = LIN(19, 16),
+    .nchecks = 2, .check = {
+        PAR_ODD(0, SPANS({1, 1, 0}, {3, 2, 0}, {6, 2, 0}, {9, 2, 0}, {12, 2, 0}, {15, 2, 0}, {18, 2, 0}, {21, 2, 0},
+                     {24, 2, 0}, {27, 2, 0}, {30, 2, 0}, {33, 2, 0})),
+        PAR_ODD(35, SPANS({1, 2, 0}, {4, 2, 0}, {7, 2, 0}, {10, 2, 0}, {13, 2, 0}, {16, 2, 0}, {19, 2, 0}, {22, 2, 0},
+                      {25, 2, 0}, {28, 2, 0}, {31, 2, 0}, {34, 1, 0})),
+    },
+};
+
+static const wiegand_layout_t Layout_H10320 = {
+    .length = 36, .bcd = true,
+    .cn = SPANS({0, 4, 0}, {4, 4, 0}, {8, 4, 0}, {12, 4, 0}, {16, 4, 0}, {20, 4, 0}, {24, 4, 0}, {28, 4, 0}),
+    .nchecks = 4, .check = {
+        PAR_EVEN(32, SPANS({0, 1, 0}, {4, 1, 0}, {8, 1, 0}, {12, 1, 0}, {16, 1, 0}, {20, 1, 0}, {24, 1, 0}, {28, 1, 0})),
+        PAR_ODD(33, SPANS({1, 1, 0}, {5, 1, 0}, {9, 1, 0}, {13, 1, 0}, {17, 1, 0}, {21, 1, 0}, {25, 1, 0}, {29, 1, 0})),
+        PAR_EVEN(34, SPANS({2, 1, 0}, {6, 1, 0}, {10, 1, 0}, {14, 1, 0}, {18, 1, 0}, {22, 1, 0}, {28, 1, 0}, {30, 1, 0})),
+        PAR_EVEN(35, SPANS({3, 1, 0}, {7, 1, 0}, {11, 1, 0}, {15, 1, 0}, {19, 1, 0}, {23, 1, 0}, {29, 1, 0}, {31, 1, 0})),
+    },
+};
+
+static const wiegand_layout_t Layout_H10302 = {
+    .length = 37, .cn = LIN(1, 35),
+    .nchecks = 2, .check = { PAR_EVEN(0, LIN(1, 18)), PAR_ODD(36, LIN(18, 18)) },
+};
+
+static const wiegand_layout_t Layout_H10304 = {
+    .length = 37, .fc = SPANS({1, 4, 12}, {5, 12, 0}), .cn = LIN(17, 19),
+    .nchecks = 2, .check = {
+        PAR_EVEN_RAW(0, 0, 0x0000000F, 0xFFFC0000),
+        PAR_ODD_RAW(36, 0, 0, 0x0007FFFE),
+    },
+};
+
+// the four first bytes xor'ed give the last one, one even parity bit per bit of it
+static const wiegand_layout_t Layout_P10001 = {
+    .length = 40, .fc = LIN(4, 12), .cn = LIN(16, 16),
+    .nchecks = 8, .check = {
+        PAR_EVEN(32, SPANS({0, 1, 0}, {8, 1, 0}, {16, 1, 0}, {24, 1, 0})),
+        PAR_EVEN(33, SPANS({1, 1, 0}, {9, 1, 0}, {17, 1, 0}, {25, 1, 0})),
+        PAR_EVEN(34, SPANS({2, 1, 0}, {10, 1, 0}, {18, 1, 0}, {26, 1, 0})),
+        PAR_EVEN(35, SPANS({3, 1, 0}, {11, 1, 0}, {19, 1, 0}, {27, 1, 0})),
+        PAR_EVEN(36, SPANS({4, 1, 0}, {12, 1, 0}, {20, 1, 0}, {28, 1, 0})),
+        PAR_EVEN(37, SPANS({5, 1, 0}, {13, 1, 0}, {21, 1, 0}, {29, 1, 0})),
+        PAR_EVEN(38, SPANS({6, 1, 0}, {14, 1, 0}, {22, 1, 0}, {30, 1, 0})),
+        PAR_EVEN(39, SPANS({7, 1, 0}, {15, 1, 0}, {23, 1, 0}, {31, 1, 0})),
+    },
+};
+
+static const wiegand_layout_t Layout_C1k48s = {
+    .length = 48, .fc = SPANS({2, 14, 8}, {16, 8, 0}), .cn = LIN(24, 23),
+    .nchecks = 3, .check = {
+        PAR_EVEN_RAW(1, 0, 0x00001B6D, 0xB6DB6DB6),
+        PAR_ODD_RAW(47, 0, 0x000036DB, 0x6DB6DB6C),
+        PAR_ODD_RAW(0, 0, 0x00007FFF, 0xFFFFFFFF),
+    },
+};
 
 static const cardformat_t FormatTable[] = {
-    {"H10301",  Pack_H10301,  Unpack_H10301,  "HID H10301 26-bit",          {1, 1, 0, 0, 1}}, // imported from old pack/unpack
-    {"Tecom27", Pack_Tecom27, Unpack_Tecom27, "Tecom 27-bit",               {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
-    {"2804W",   Pack_2804W,   Unpack_2804W,   "2804 Wiegand",               {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
-    {"ATSW30",  Pack_ATSW30,  Unpack_ATSW30,  "ATS Wiegand 30-bit",         {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
-    {"ADT31",   Pack_ADT31,   Unpack_ADT31,   "HID ADT 31-bit",             {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
-    {"Kastle",  Pack_Kastle,  Unpack_Kastle,  "Kastle 32-bit",              {1, 1, 1, 0, 1}}, // from @xilni; PR #23 on RfidResearchGroup/proxmark3
-    {"D10202",  Pack_D10202,  Unpack_D10202,  "HID D10202 33-bit",          {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
-    {"H10306",  Pack_H10306,  Unpack_H10306,  "HID H10306 34-bit",          {1, 1, 0, 0, 1}}, // imported from old pack/unpack
-    {"N10002",  Pack_N10002,  Unpack_N10002,  "HID N10002 34-bit",          {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
-    {"C1k35s",  Pack_C1k35s,  Unpack_C1k35s,  "HID Corporate 1000 35-bit standard layout", {1, 1, 0, 0, 1}}, // imported from old pack/unpack
-    {"C15001",  Pack_C15001,  Unpack_C15001,  "HID KeyScan 36-bit",         {1, 1, 0, 1, 1}}, // from Proxmark forums
-    {"S12906",  Pack_S12906,  Unpack_S12906,  "HID Simplex 36-bit",         {1, 1, 1, 0, 1}}, // from cardinfo.barkweb.com.au
-    {"Sie36",   Pack_Sie36,   Unpack_Sie36,   "HID 36-bit Siemens",         {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
-    {"H10320",  Pack_H10320,  Unpack_H10320,  "HID H10320 36-bit BCD",      {1, 0, 0, 0, 1}}, // from Proxmark forums
-    {"H10302",  Pack_H10302,  Unpack_H10302,  "HID H10302 37-bit huge ID",  {1, 0, 0, 0, 1}}, // from Proxmark forums
-    {"H10304",  Pack_H10304,  Unpack_H10304,  "HID H10304 37-bit",          {1, 1, 0, 0, 1}}, // imported from old pack/unpack
-    {"P10001",  Pack_P10001,  Unpack_P10001,  "HID P10001 Honeywell 40-bit", {1, 1, 0, 1, 0}}, // from cardinfo.barkweb.com.au
-    {"C1k48s",  Pack_C1k48s,  Unpack_C1k48s,  "HID Corporate 1000 48-bit standard layout", {1, 1, 0, 0, 1}}, // imported from old pack/unpack
+    {"H10301",  Pack_H10301,  &Layout_H10301,  "HID H10301 26-bit",          {1, 1, 0, 0, 1}}, // imported from old pack/unpack
+    {"Tecom27", Pack_Tecom27, &Layout_Tecom27, "Tecom 27-bit",               {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
+    {"2804W",   Pack_2804W,   &Layout_2804W,   "2804 Wiegand",               {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
+    {"ATSW30",  Pack_ATSW30,  &Layout_ATSW30,  "ATS Wiegand 30-bit",         {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
+    {"ADT31",   Pack_ADT31,   &Layout_ADT31,   "HID ADT 31-bit",             {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
+    {"Kastle",  Pack_Kastle,  &Layout_Kastle,  "Kastle 32-bit",              {1, 1, 1, 0, 1}}, // from @xilni; PR #23 on RfidResearchGroup/proxmark3
+    {"D10202",  Pack_D10202,  &Layout_D10202,  "HID D10202 33-bit",          {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
+    {"H10306",  Pack_H10306,  &Layout_H10306,  "HID H10306 34-bit",          {1, 1, 0, 0, 1}}, // imported from old pack/unpack
+    {"N10002",  Pack_N10002,  &Layout_N10002,  "HID N10002 34-bit",          {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
+    {"C1k35s",  Pack_C1k35s,  &Layout_C1k35s,  "HID Corporate 1000 35-bit standard layout", {1, 1, 0, 0, 1}}, // imported from old pack/unpack
+    {"C15001",  Pack_C15001,  &Layout_C15001,  "HID KeyScan 36-bit",         {1, 1, 0, 1, 1}}, // from Proxmark forums
+    {"S12906",  Pack_S12906,  &Layout_S12906,  "HID Simplex 36-bit",         {1, 1, 1, 0, 1}}, // from cardinfo.barkweb.com.au
+    {"Sie36",   Pack_Sie36,   &Layout_Sie36,   "HID 36-bit Siemens",         {1, 1, 0, 0, 1}}, // from cardinfo.barkweb.com.au
+    {"H10320",  Pack_H10320,  &Layout_H10320,  "HID H10320 36-bit BCD",      {1, 0, 0, 0, 1}}, // from Proxmark forums
+    {"H10302",  Pack_H10302,  &Layout_H10302,  "HID H10302 37-bit huge ID",  {1, 0, 0, 0, 1}}, // from Proxmark forums
+    {"H10304",  Pack_H10304,  &Layout_H10304,  "HID H10304 37-bit",          {1, 1, 0, 0, 1}}, // imported from old pack/unpack
+    {"P10001",  Pack_P10001,  &Layout_P10001,  "HID P10001 Honeywell 40-bit", {1, 1, 0, 1, 0}}, // from cardinfo.barkweb.com.au
+    {"C1k48s",  Pack_C1k48s,  &Layout_C1k48s,  "HID Corporate 1000 48-bit standard layout", {1, 1, 0, 0, 1}}, // imported from old pack/unpack
     {NULL, NULL, NULL, NULL, {0, 0, 0, 0, 0}} // Must null terminate array
 };
 
@@ -650,67 +587,261 @@ bool HIDPack(int format_idx, wiegand_card_t *card, wiegand_message_t *packed) {
     return FormatTable[format_idx].Pack(card, packed);
 }
 
-static void HIDDisplayUnpackedCard(wiegand_card_t *card, const cardformat_t format) {
+// compiled parity bit: the covered bits and the parity bit itself, over Bot, Mid, Top
+typedef struct {
+    uint32_t mask[3];
+    uint8_t odd;
+    uint8_t cand;       // which of the formats of the length
+} wiegand_check_t;
+
+typedef struct {
+    uint8_t count;
+    uint8_t format[WIEGAND_MAX_MATCHES];    // in table order
+    uint16_t first_check;
+    uint16_t nchecks;
+} wiegand_lut_t;
+
+static wiegand_lut_t wiegand_lut[97];
+static wiegand_check_t wiegand_checks[ARRAYLEN(FormatTable) * WIEGAND_MAX_CHECKS];
+static pthread_once_t wiegand_compiled = PTHREAD_ONCE_INIT;
+
+static void wiegand_toggle(uint32_t *mask, uint8_t length, uint8_t pos) {
+    uint8_t raw = length - pos - 1;
+    mask[raw / 32] ^= 1u << (raw % 32);
+}
+
+static void wiegand_field_mask(uint32_t *mask, uint8_t length, const wiegand_field_t *field) {
+    for (uint8_t i = 0; i < field->count; i++) {
+        for (uint8_t j = 0; j < field->span[i].len; j++) {
+            wiegand_toggle(mask, length, field->span[i].first + j);
+        }
+    }
+}
+
+static void wiegand_compile(void) {
+    uint16_t n = 0;
+    for (uint8_t length = 0; length < ARRAYLEN(wiegand_lut); length++) {
+        wiegand_lut_t *lut = &wiegand_lut[length];
+        lut->first_check = n;
+
+        for (uint8_t i = 0; FormatTable[i].Name; i++) {
+            const wiegand_layout_t *l = FormatTable[i].Layout;
+            if (l->length != length)
+                continue;
+
+            // a new format past the limit would never be tried, say so rather than drop it quietly
+            if (lut->count == WIEGAND_MAX_MATCHES) {
+                PrintAndLogEx(WARNING, "more than %u wiegand formats of %u bits, " _YELLOW_("%s") " is never decoded", WIEGAND_MAX_MATCHES, length, FormatTable[i].Name);
+                continue;
+            }
+
+            for (uint8_t j = 0; j < l->nchecks; j++) {
+                const wiegand_parity_t *p = &l->check[j];
+                wiegand_check_t *c = &wiegand_checks[n++];
+                c->mask[0] = p->bot;
+                c->mask[1] = p->mid;
+                c->mask[2] = p->top;
+                wiegand_field_mask(c->mask, length, &p->covers);
+                wiegand_toggle(c->mask, length, p->bit);
+                c->odd = p->odd;
+                c->cand = lut->count;
+            }
+            lut->format[lut->count++] = i;
+        }
+        lut->nchecks = n - lut->first_check;
+    }
+}
+
+// len bits of the message from raw bit lsb up, raw bit 0 is the last bit sent
+static uint64_t wiegand_bits(const uint32_t *w, uint8_t lsb, uint8_t len) {
+    uint64_t lo = ((uint64_t)w[1] << 32) | w[0];
+    uint64_t v;
+    if (lsb >= 64)
+        v = w[2] >> (lsb - 64);
+    else if (lsb == 0)
+        v = lo;
+    else
+        v = (lo >> lsb) | ((uint64_t)w[2] << (64 - lsb));
+    return (len >= 64) ? v : v & ((1ULL << len) - 1);
+}
+
+static uint64_t wiegand_field(const uint32_t *w, uint8_t length, const wiegand_field_t *field) {
+    uint64_t v = 0;
+    for (uint8_t i = 0; i < field->count; i++) {
+        const wiegand_span_t *s = &field->span[i];
+        v |= wiegand_bits(w, length - s->first - s->len, s->len) << s->shift;
+    }
+    return v;
+}
+
+static bool wiegand_unpack_layout(const uint32_t *w, const wiegand_layout_t *l, wiegand_card_t *card) {
+    memset(card, 0, sizeof(wiegand_card_t));
+
+    uint32_t ones[3] = {0};
+    wiegand_field_mask(ones, l->length, &l->ones);
+    if ((w[0] & ones[0]) != ones[0] || (w[1] & ones[1]) != ones[1] || (w[2] & ones[2]) != ones[2])
+        return false;
+
+    if (l->bcd) {
+        for (uint8_t i = 0; i < l->cn.count; i++) {
+            const wiegand_span_t *s = &l->cn.span[i];
+            uint64_t digit = wiegand_bits(w, l->length - s->first - s->len, s->len);
+            if (digit > 9) {
+                card->CardNumber = 0;
+                return false;
+            }
+            card->CardNumber = card->CardNumber * 10 + digit;
+        }
+    } else {
+        card->CardNumber = wiegand_field(w, l->length, &l->cn);
+    }
+    card->FacilityCode = wiegand_field(w, l->length, &l->fc);
+    card->IssueLevel = wiegand_field(w, l->length, &l->issue);
+    card->OEM = wiegand_field(w, l->length, &l->oem);
+    return true;
+}
+
+int HIDUnpack(wiegand_message_t *packed, bool ignore_parity, wiegand_result_t *result) {
+    pthread_once(&wiegand_compiled, wiegand_compile);
+
+    result->count = 0;
+    if (packed->Length >= ARRAYLEN(wiegand_lut))
+        return 0;
+
+    const wiegand_lut_t *lut = &wiegand_lut[packed->Length];
+    const uint32_t w[3] = {packed->Bot, packed->Mid, packed->Top};
+
+    // parity of every format of this length, a bit set per format with a wrong parity
+    uint32_t bad = 0;
+    const wiegand_check_t *c = &wiegand_checks[lut->first_check];
+    for (uint16_t i = 0; i < lut->nchecks; i++, c++) {
+        bool parity = evenparity32((w[0] & c->mask[0]) ^ (w[1] & c->mask[1]) ^ (w[2] & c->mask[2]));
+        bad |= (uint32_t)(parity ^ c->odd) << c->cand;
+    }
+
+    for (uint8_t i = 0; i < lut->count; i++) {
+        const cardformat_t *format = &FormatTable[lut->format[i]];
+        wiegand_match_t *m = &result->match[result->count];
+
+        if (wiegand_unpack_layout(w, format->Layout, &m->card) == false)
+            continue;
+
+        // formats without parity bits never have a valid parity
+        m->card.ParityValid = format->Layout->nchecks && ((bad >> i) & 1) == 0;
+        if (ignore_parity || !format->Fields.hasParity || m->card.ParityValid) {
+            m->format_idx = lut->format[i];
+            result->count++;
+        }
+    }
+    return result->count;
+}
+
+size_t HIDUnpackBatch(wiegand_message_t *packed, size_t count, bool ignore_parity, wiegand_result_t *results) {
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (HIDUnpack(&packed[i], ignore_parity, &results[i]))
+            found++;
+    }
+    return found;
+}
+
+static json_t *HIDResultToJSON(wiegand_message_t *packed, wiegand_result_t *result) {
+    char raw[25] = {0};
+    if (packed->Top != 0)
+        snprintf(raw, sizeof(raw), "%X%08X%08X", packed->Top, packed->Mid, packed->Bot);
+    else
+        snprintf(raw, sizeof(raw), "%X%08X", packed->Mid, packed->Bot);
+
+    json_t *root = json_object();
+    json_object_set_new(root, "raw", json_string(raw));
+    json_object_set_new(root, "bits", json_integer(packed->Length));
+
+    json_t *formats = json_array();
+    for (uint8_t i = 0; i < result->count; i++) {
+        const cardformat_t *format = &FormatTable[result->match[i].format_idx];
+        wiegand_card_t *card = &result->match[i].card;
+
+        json_t *m = json_object();
+        json_object_set_new(m, "format", json_string(format->Name));
+        if (format->Fields.hasFacilityCode)
+            json_object_set_new(m, "fc", json_integer(card->FacilityCode));
+        if (format->Fields.hasCardNumber)
+            json_object_set_new(m, "cn", json_integer(card->CardNumber));
+        if (format->Fields.hasIssueLevel)
+            json_object_set_new(m, "issue", json_integer(card->IssueLevel));
+        if (format->Fields.hasOEMCode)
+            json_object_set_new(m, "oem", json_integer(card->OEM));
+        if (format->Fields.hasParity)
+            json_object_set_new(m, "parity", json_boolean(card->ParityValid));
+        json_array_append_new(formats, m);
+    }
+    json_object_set_new(root, "formats", formats);
+    return root;
+}
+
+json_t *HIDUnpackBatchJSON(wiegand_message_t *packed, size_t count, bool ignore_parity) {
+    json_t *root = json_array();
+    for (size_t i = 0; i < count; i++) {
+        wiegand_result_t result;
+        HIDUnpack(&packed[i], ignore_parity, &result);
+        json_array_append_new(root, HIDResultToJSON(&packed[i], &result));
+    }
+    return root;
+}
+
+static void HIDDisplayUnpackedCard(wiegand_card_t *card, const cardformat_t *format) {
 
     /*
-        PrintAndLogEx(SUCCESS, "       Format: %s (%s)", format.Name, format.Descrp);
+        PrintAndLogEx(SUCCESS, "       Format: %s (%s)", format->Name, format->Descrp);
 
-        if (format.Fields.hasFacilityCode)
+        if (format->Fields.hasFacilityCode)
             PrintAndLogEx(SUCCESS, "Facility Code: %d",card->FacilityCode);
 
-        if (format.Fields.hasCardNumber)
+        if (format->Fields.hasCardNumber)
             PrintAndLogEx(SUCCESS, "  Card Number: %d",card->CardNumber);
 
-        if (format.Fields.hasIssueLevel)
+        if (format->Fields.hasIssueLevel)
             PrintAndLogEx(SUCCESS, "  Issue Level: %d",card->IssueLevel);
 
-        if (format.Fields.hasOEMCode)
+        if (format->Fields.hasOEMCode)
             PrintAndLogEx(SUCCESS, "     OEM Code: %d",card->OEM);
 
-        if (format.Fields.hasParity)
+        if (format->Fields.hasParity)
             PrintAndLogEx(SUCCESS, "       Parity: %s",card->ParityValid ? "Valid" : "Invalid");
     */
 
     char s[110] = {0};
-    if (format.Fields.hasFacilityCode)
+    if (format->Fields.hasFacilityCode)
         snprintf(s, sizeof(s), "FC: " _GREEN_("%u"), card->FacilityCode);
 
-    if (format.Fields.hasCardNumber)
+    if (format->Fields.hasCardNumber)
         snprintf(s + strlen(s), sizeof(s) - strlen(s), "  CN: " _GREEN_("%"PRIu64), card->CardNumber);
 
-    if (format.Fields.hasIssueLevel)
+    if (format->Fields.hasIssueLevel)
         snprintf(s + strlen(s), sizeof(s) - strlen(s), "  Issue " _GREEN_("%u"), card->IssueLevel);
 
-    if (format.Fields.hasOEMCode)
+    if (format->Fields.hasOEMCode)
         snprintf(s + strlen(s), sizeof(s) - strlen(s), "  OEM: " _GREEN_("%u"), card->OEM);
 
-    if (format.Fields.hasParity)
+    if (format->Fields.hasParity)
         snprintf(s + strlen(s), sizeof(s) - strlen(s), "    parity: %s", card->ParityValid ? _GREEN_("valid") : _RED_("invalid"));
 
-    PrintAndLogEx(SUCCESS, "[%s] - %s;  %s", format.Name, format.Descrp, s);
+    PrintAndLogEx(SUCCESS, "[%s] - %s;  %s", format->Name, format->Descrp, s);
 }
 
-bool HIDTryUnpack(wiegand_message_t *packed, bool ignore_parity) {
-    if (FormatTable[0].Name == NULL)
-        return false;
-
-    bool result = false;
-    int i = 0;
-    wiegand_card_t card;
-    memset(&card, 0, sizeof(wiegand_card_t));
-
-    while (FormatTable[i].Name) {
-        if (FormatTable[i].Unpack(packed, &card)) {
-            if (ignore_parity || !FormatTable[i].Fields.hasParity || card.ParityValid) {
-                result = true;
-                HIDDisplayUnpackedCard(&card, FormatTable[i]);
-            }
-        }
-        ++i;
+void HIDDisplayUnpacked(wiegand_message_t *packed, wiegand_result_t *result) {
+    for (uint8_t i = 0; i < result->count; i++) {
+        HIDDisplayUnpackedCard(&result->match[i].card, &FormatTable[result->match[i].format_idx]);
     }
-    if (result == false && packed->Length) {
+
+    if (result->count == 0 && packed->Length) {
         PrintAndLogEx(SUCCESS, "Unknown. Bit len %d", packed->Length);
     }
+}
 
-    return result;
+bool HIDTryUnpack(wiegand_message_t *packed, bool ignore_parity) {
+    wiegand_result_t result;
+    HIDUnpack(packed, ignore_parity, &result);
+    HIDDisplayUnpacked(packed, &result);
+    return result.count > 0;
 }
@@ -21,6 +21,7 @@
 #include "wiegand_formatutils.h"
 #include "parity.h" // for parity
 #include "ui.h"
+#include "jansson.h"
 
 typedef struct {
     bool hasCardNumber;
@@ -30,11 +31,14 @@ typedef struct {
     bool hasParity;
 } cardformatdescriptor_t;
 
+// Field and parity bit positions of a format, see wiegand_formats.c
+typedef struct wiegand_layout_s wiegand_layout_t;
+
 // Structure for defined Wiegand card formats available for packing/unpacking
 typedef struct {
     const char *Name;
     bool (*Pack)(wiegand_card_t *card, wiegand_message_t *packed);
-    bool (*Unpack)(wiegand_message_t *packed, wiegand_card_t *card);
+    const wiegand_layout_t *Layout;
     const char *Descrp;
     cardformatdescriptor_t Fields;
 } cardformat_t;
@@ -45,4 +49,26 @@ cardformat_t HIDGetCardFormat(int idx);
 bool HIDPack(int format_idx, wiegand_card_t *card, wiegand_message_t *packed);
 bool HIDTryUnpack(wiegand_message_t *packed, bool ignore_parity);
 
+// at most this many formats share a message length
+#define WIEGAND_MAX_MATCHES 8
+
+typedef struct {
+    int format_idx;
+    wiegand_card_t card;
+} wiegand_match_t;
+
+// formats a message unpacks to, in format table order
+typedef struct {
+    uint8_t count;
+    wiegand_match_t match[WIEGAND_MAX_MATCHES];
+} wiegand_result_t;
+
+// unpacks with every format of the message length, parity is checked unless ignore_parity. Returns the number of matches
+int HIDUnpack(wiegand_message_t *packed, bool ignore_parity, wiegand_result_t *result);
+void HIDDisplayUnpacked(wiegand_message_t *packed, wiegand_result_t *result);
+// unpacks count messages into results. Returns how many matched a format
+size_t HIDUnpackBatch(wiegand_message_t *packed, size_t count, bool ignore_parity, wiegand_result_t *results);
+// array of {"raw", "bits", "formats": [{"format", "fc", "cn", "issue", "oem", "parity"}]}, fields as the format has them
+json_t *HIDUnpackBatchJSON(wiegand_message_t *packed, size_t count, bool ignore_parity);
+
 #endif
@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Compressed BigBuf download
+//-----------------------------------------------------------------------------
+#include "bigbuf_lz4.h"
+
+#include <string.h>
+
+#include "pm3_cmd.h"    // PM3_CMD_DATA_SIZE, error codes
+
+int bigbuf_lz4_compress(uint8_t *buf, uint32_t len, uint8_t flags, bigbuf_lz4_send_t send, void *ctx) {
+
+    if (flags & BIGBUF_LZ4_DELTA) {
+        for (uint32_t i = len; i > 1; i--)
+            buf[i - 1] -= buf[i - 2];
+    }
+
+    LZ4_stream_t lz4;
+    LZ4_initStream(&lz4, sizeof(lz4));
+
+    uint8_t pkt[PM3_CMD_DATA_SIZE];
+    uint8_t block[LZ4_COMPRESSBOUND(BIGBUF_LZ4_BLOCK)];
+    uint16_t plen = 0;
+    pkt[plen++] = flags;
+
+    int res = PM3_SUCCESS;
+    for (uint32_t i = 0; i < len; i += BIGBUF_LZ4_BLOCK) {
+        int n = MIN(BIGBUF_LZ4_BLOCK, len - i);
+        int c = LZ4_compress_fast_continue(&lz4, (const char *)buf + i, (char *)block, n, sizeof(block), 1);
+        if (c <= 0) {
+            res = PM3_ESOFT;
+            break;
+        }
+
+        if (plen + 2 + c > sizeof(pkt)) {
+            res = send(pkt, plen, ctx);
+            if (res != PM3_SUCCESS)
+                break;
+            plen = 1;
+        }
+
+        pkt[plen++] = c & 0xFF;
+        pkt[plen++] = c >> 8;
+        memcpy(pkt + plen, block, c);
+        plen += c;
+    }
+
+    if (res == PM3_SUCCESS && plen > 1)
+        res = send(pkt, plen, ctx);
+
+    if (flags & BIGBUF_LZ4_DELTA) {
+        for (uint32_t i = 1; i < len; i++)
+            buf[i] += buf[i - 1];
+    }
+    return res;
+}
+
+void bigbuf_lz4_decode_init(bigbuf_lz4_decoder_t *d, uint8_t *ring, uint32_t cap, bigbuf_lz4_sink_t sink, void *ctx) {
+    LZ4_setStreamDecode(&d->lz4, NULL, 0);
+    d->ring = ring;
+    d->pos = 0;
+    d->cap = cap;
+    d->len = 0;
+    d->flags = 0;
+    d->sink = sink;
+    d->ctx = ctx;
+}
+
+int bigbuf_lz4_decode(bigbuf_lz4_decoder_t *d, const uint8_t *data, uint16_t len) {
+    if (len == 0)
+        return PM3_ESOFT;
+
+    d->flags = data[0];
+
+    uint16_t i = 1;
+    while (i < len) {
+        if (len - i < 2)
+            return PM3_ESOFT;
+
+        uint16_t c = data[i] | data[i + 1] << 8;
+        i += 2;
+        if (c > len - i)
+            return PM3_ESOFT;
+
+        // a block never wraps, the blocks before it stay where lz4 looks for them
+        if (d->pos + BIGBUF_LZ4_BLOCK > BIGBUF_LZ4_RING)
+            d->pos = 0;
+
+        int room = MIN(BIGBUF_LZ4_BLOCK, d->cap - d->len);
+        int n = LZ4_decompress_safe_continue(&d->lz4, (const char *)data + i, (char *)d->ring + d->pos, c, room);
+        if (n < 0)
+            return PM3_ESOFT;
+
+        if (d->sink)
+            d->sink(d->ring + d->pos, d->len, n, d->ctx);
+        d->pos += n;
+        d->len += n;
+        i += c;
+    }
+    return PM3_SUCCESS;
+}
@@ -0,0 +1,58 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// Compressed BigBuf download
+//
+// The device compresses BigBuf as one LZ4 stream of small blocks, each packet
+// holds whole blocks: [flags] ([u16 le compressed length] [lz4 block])...
+// A block is BIGBUF_LZ4_BLOCK bytes, the last one may be shorter, so a block
+// still fits a packet when it doesn't compress. Later blocks refer back to the
+// earlier ones, the client decodes them into one buffer in order.
+//
+// With BIGBUF_LZ4_DELTA the bytes are coded as the difference to the byte
+// before, smaller for smooth signals but often not for the square waves of a
+// tag. The device codes BigBuf in place and restores it after.
+//
+// The client decodes into a ring of BIGBUF_LZ4_RING bytes, enough for the
+// 64 kB lz4 looks back, and hands each block on as soon as it is decoded.
+//-----------------------------------------------------------------------------
+
+#ifndef BIGBUF_LZ4_H__
+#define BIGBUF_LZ4_H__
+
+#include "common.h"
+#include "lz4/lz4.h"
+
+#define BIGBUF_LZ4_BLOCK    480
+
+#define BIGBUF_LZ4_DELTA    0x01
+
+// hands one packet to the transport, returns PM3_SUCCESS to go on
+typedef int (*bigbuf_lz4_send_t)(const uint8_t *data, uint16_t len, void *ctx);
+
+// buf is delta coded while it is compressed, it has its bytes back on return
+int bigbuf_lz4_compress(uint8_t *buf, uint32_t len, uint8_t flags, bigbuf_lz4_send_t send, void *ctx);
+
+#define BIGBUF_LZ4_RING     LZ4_DECODER_RING_BUFFER_SIZE(BIGBUF_LZ4_BLOCK)
+
+// gets the n bytes of a block, still delta coded, that start at offset of the stream
+typedef void (*bigbuf_lz4_sink_t)(const uint8_t *bytes, uint32_t offset, uint16_t n, void *ctx);
+
+typedef struct {
+    LZ4_streamDecode_t lz4;
+    uint8_t *ring;          // BIGBUF_LZ4_RING bytes, the lz4 window
+    uint32_t pos;           // where the next block goes in the ring
+    uint32_t cap;           // bytes the stream may have
+    uint32_t len;           // bytes decoded so far
+    uint8_t flags;          // of the last packet
+    bigbuf_lz4_sink_t sink;
+    void *ctx;
+} bigbuf_lz4_decoder_t;
+
+void bigbuf_lz4_decode_init(bigbuf_lz4_decoder_t *d, uint8_t *ring, uint32_t cap, bigbuf_lz4_sink_t sink, void *ctx);
+// decodes the blocks of one packet after the ones before, PM3_ESOFT on bad data or past cap
+int bigbuf_lz4_decode(bigbuf_lz4_decoder_t *d, const uint8_t *data, uint16_t len);
+
+#endif
@@ -10,87 +10,850 @@
 #include <string.h>
 #include "commonutil.h"
 
-static uint16_t crc_table[256];
-static bool crc_table_init = false;
-static CrcType_t current_crc_type = CRC_NONE;
+// The tables are const, every crc type and thread uses them at the same time.
+// Slice k is the crc of a byte followed by k zero bytes, the client runs
+// eight bytes per step on long buffers. The device only keeps the first slice.
+#ifdef ON_DEVICE
+# define CRC16_SLICES 1
+#else
+# define CRC16_SLICES 8
+#endif
 
-void init_table(CrcType_t crctype) {
-
-    // same crc algo, and initialised already
-    if (crctype == current_crc_type && crc_table_init)
-        return;
-
-    // not the same crc algo. reset table.
-    if (crctype != current_crc_type)
-        reset_table();
-
-    current_crc_type = crctype;
-
-    switch (crctype) {
-        case CRC_14443_A:
-        case CRC_14443_B:
-        case CRC_15693:
-        case CRC_ICLASS:
-        case CRC_CRYPTORF:
-            generate_table(CRC16_POLY_CCITT, true);
-            break;
-        case CRC_FELICA:
-        case CRC_XMODEM:
-            generate_table(CRC16_POLY_CCITT, false);
-            break;
-        case CRC_LEGIC:
-            generate_table(CRC16_POLY_LEGIC, true);
-            break;
-        case CRC_CCITT:
-            generate_table(CRC16_POLY_CCITT, false);
-            break;
-        case CRC_KERMIT:
-            generate_table(CRC16_POLY_CCITT, true);
-            break;
-        case CRC_11784:
-            generate_table(CRC16_POLY_CCITT, false);
-            break;
-        case CRC_NONE:
-            crc_table_init = false;
-            current_crc_type = CRC_NONE;
-            break;
+// poly 0x1021, MSB first
+static const uint16_t crc16_table_ccitt[CRC16_SLICES][256] = {
+    {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+        0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+        0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+        0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+        0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+        0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+        0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+        0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+        0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+        0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+        0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+        0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+        0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+        0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+        0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+        0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+        0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+        0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+        0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+        0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+        0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+        0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+        0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+        0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+        0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+        0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+        0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+        0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+        0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+        0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+        0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+    },
+#if CRC16_SLICES == 8
+    {
+        0x0000, 0x3331, 0x6662, 0x5553, 0xCCC4, 0xFFF5, 0xAAA6, 0x9997,
+        0x89A9, 0xBA98, 0xEFCB, 0xDCFA, 0x456D, 0x765C, 0x230F, 0x103E,
+        0x0373, 0x3042, 0x6511, 0x5620, 0xCFB7, 0xFC86, 0xA9D5, 0x9AE4,
+        0x8ADA, 0xB9EB, 0xECB8, 0xDF89, 0x461E, 0x752F, 0x207C, 0x134D,
+        0x06E6, 0x35D7, 0x6084, 0x53B5, 0xCA22, 0xF913, 0xAC40, 0x9F71,
+        0x8F4F, 0xBC7E, 0xE92D, 0xDA1C, 0x438B, 0x70BA, 0x25E9, 0x16D8,
+        0x0595, 0x36A4, 0x63F7, 0x50C6, 0xC951, 0xFA60, 0xAF33, 0x9C02,
+        0x8C3C, 0xBF0D, 0xEA5E, 0xD96F, 0x40F8, 0x73C9, 0x269A, 0x15AB,
+        0x0DCC, 0x3EFD, 0x6BAE, 0x589F, 0xC108, 0xF239, 0xA76A, 0x945B,
+        0x8465, 0xB754, 0xE207, 0xD136, 0x48A1, 0x7B90, 0x2EC3, 0x1DF2,
+        0x0EBF, 0x3D8E, 0x68DD, 0x5BEC, 0xC27B, 0xF14A, 0xA419, 0x9728,
+        0x8716, 0xB427, 0xE174, 0xD245, 0x4BD2, 0x78E3, 0x2DB0, 0x1E81,
+        0x0B2A, 0x381B, 0x6D48, 0x5E79, 0xC7EE, 0xF4DF, 0xA18C, 0x92BD,
+        0x8283, 0xB1B2, 0xE4E1, 0xD7D0, 0x4E47, 0x7D76, 0x2825, 0x1B14,
+        0x0859, 0x3B68, 0x6E3B, 0x5D0A, 0xC49D, 0xF7AC, 0xA2FF, 0x91CE,
+        0x81F0, 0xB2C1, 0xE792, 0xD4A3, 0x4D34, 0x7E05, 0x2B56, 0x1867,
+        0x1B98, 0x28A9, 0x7DFA, 0x4ECB, 0xD75C, 0xE46D, 0xB13E, 0x820F,
+        0x9231, 0xA100, 0xF453, 0xC762, 0x5EF5, 0x6DC4, 0x3897, 0x0BA6,
+        0x18EB, 0x2BDA, 0x7E89, 0x4DB8, 0xD42F, 0xE71E, 0xB24D, 0x817C,
+        0x9142, 0xA273, 0xF720, 0xC411, 0x5D86, 0x6EB7, 0x3BE4, 0x08D5,
+        0x1D7E, 0x2E4F, 0x7B1C, 0x482D, 0xD1BA, 0xE28B, 0xB7D8, 0x84E9,
+        0x94D7, 0xA7E6, 0xF2B5, 0xC184, 0x5813, 0x6B22, 0x3E71, 0x0D40,
+        0x1E0D, 0x2D3C, 0x786F, 0x4B5E, 0xD2C9, 0xE1F8, 0xB4AB, 0x879A,
+        0x97A4, 0xA495, 0xF1C6, 0xC2F7, 0x5B60, 0x6851, 0x3D02, 0x0E33,
+        0x1654, 0x2565, 0x7036, 0x4307, 0xDA90, 0xE9A1, 0xBCF2, 0x8FC3,
+        0x9FFD, 0xACCC, 0xF99F, 0xCAAE, 0x5339, 0x6008, 0x355B, 0x066A,
+        0x1527, 0x2616, 0x7345, 0x4074, 0xD9E3, 0xEAD2, 0xBF81, 0x8CB0,
+        0x9C8E, 0xAFBF, 0xFAEC, 0xC9DD, 0x504A, 0x637B, 0x3628, 0x0519,
+        0x10B2, 0x2383, 0x76D0, 0x45E1, 0xDC76, 0xEF47, 0xBA14, 0x8925,
+        0x991B, 0xAA2A, 0xFF79, 0xCC48, 0x55DF, 0x66EE, 0x33BD, 0x008C,
+        0x13C1, 0x20F0, 0x75A3, 0x4692, 0xDF05, 0xEC34, 0xB967, 0x8A56,
+        0x9A68, 0xA959, 0xFC0A, 0xCF3B, 0x56AC, 0x659D, 0x30CE, 0x03FF
+    },
+    {
+        0x0000, 0x3730, 0x6E60, 0x5950, 0xDCC0, 0xEBF0, 0xB2A0, 0x8590,
+        0xA9A1, 0x9E91, 0xC7C1, 0xF0F1, 0x7561, 0x4251, 0x1B01, 0x2C31,
+        0x4363, 0x7453, 0x2D03, 0x1A33, 0x9FA3, 0xA893, 0xF1C3, 0xC6F3,
+        0xEAC2, 0xDDF2, 0x84A2, 0xB392, 0x3602, 0x0132, 0x5862, 0x6F52,
+        0x86C6, 0xB1F6, 0xE8A6, 0xDF96, 0x5A06, 0x6D36, 0x3466, 0x0356,
+        0x2F67, 0x1857, 0x4107, 0x7637, 0xF3A7, 0xC497, 0x9DC7, 0xAAF7,
+        0xC5A5, 0xF295, 0xABC5, 0x9CF5, 0x1965, 0x2E55, 0x7705, 0x4035,
+        0x6C04, 0x5B34, 0x0264, 0x3554, 0xB0C4, 0x87F4, 0xDEA4, 0xE994,
+        0x1DAD, 0x2A9D, 0x73CD, 0x44FD, 0xC16D, 0xF65D, 0xAF0D, 0x983D,
+        0xB40C, 0x833C, 0xDA6C, 0xED5C, 0x68CC, 0x5FFC, 0x06AC, 0x319C,
+        0x5ECE, 0x69FE, 0x30AE, 0x079E, 0x820E, 0xB53E, 0xEC6E, 0xDB5E,
+        0xF76F, 0xC05F, 0x990F, 0xAE3F, 0x2BAF, 0x1C9F, 0x45CF, 0x72FF,
+        0x9B6B, 0xAC5B, 0xF50B, 0xC23B, 0x47AB, 0x709B, 0x29CB, 0x1EFB,
+        0x32CA, 0x05FA, 0x5CAA, 0x6B9A, 0xEE0A, 0xD93A, 0x806A, 0xB75A,
+        0xD808, 0xEF38, 0xB668, 0x8158, 0x04C8, 0x33F8, 0x6AA8, 0x5D98,
+        0x71A9, 0x4699, 0x1FC9, 0x28F9, 0xAD69, 0x9A59, 0xC309, 0xF439,
+        0x3B5A, 0x0C6A, 0x553A, 0x620A, 0xE79A, 0xD0AA, 0x89FA, 0xBECA,
+        0x92FB, 0xA5CB, 0xFC9B, 0xCBAB, 0x4E3B, 0x790B, 0x205B, 0x176B,
+        0x7839, 0x4F09, 0x1659, 0x2169, 0xA4F9, 0x93C9, 0xCA99, 0xFDA9,
+        0xD198, 0xE6A8, 0xBFF8, 0x88C8, 0x0D58, 0x3A68, 0x6338, 0x5408,
+        0xBD9C, 0x8AAC, 0xD3FC, 0xE4CC, 0x615C, 0x566C, 0x0F3C, 0x380C,
+        0x143D, 0x230D, 0x7A5D, 0x4D6D, 0xC8FD, 0xFFCD, 0xA69D, 0x91AD,
+        0xFEFF, 0xC9CF, 0x909F, 0xA7AF, 0x223F, 0x150F, 0x4C5F, 0x7B6F,
+        0x575E, 0x606E, 0x393E, 0x0E0E, 0x8B9E, 0xBCAE, 0xE5FE, 0xD2CE,
+        0x26F7, 0x11C7, 0x4897, 0x7FA7, 0xFA37, 0xCD07, 0x9457, 0xA367,
+        0x8F56, 0xB866, 0xE136, 0xD606, 0x5396, 0x64A6, 0x3DF6, 0x0AC6,
+        0x6594, 0x52A4, 0x0BF4, 0x3CC4, 0xB954, 0x8E64, 0xD734, 0xE004,
+        0xCC35, 0xFB05, 0xA255, 0x9565, 0x10F5, 0x27C5, 0x7E95, 0x49A5,
+        0xA031, 0x9701, 0xCE51, 0xF961, 0x7CF1, 0x4BC1, 0x1291, 0x25A1,
+        0x0990, 0x3EA0, 0x67F0, 0x50C0, 0xD550, 0xE260, 0xBB30, 0x8C00,
+        0xE352, 0xD462, 0x8D32, 0xBA02, 0x3F92, 0x08A2, 0x51F2, 0x66C2,
+        0x4AF3, 0x7DC3, 0x2493, 0x13A3, 0x9633, 0xA103, 0xF853, 0xCF63
+    },
+    {
+        0x0000, 0x76B4, 0xED68, 0x9BDC, 0xCAF1, 0xBC45, 0x2799, 0x512D,
+        0x85C3, 0xF377, 0x68AB, 0x1E1F, 0x4F32, 0x3986, 0xA25A, 0xD4EE,
+        0x1BA7, 0x6D13, 0xF6CF, 0x807B, 0xD156, 0xA7E2, 0x3C3E, 0x4A8A,
+        0x9E64, 0xE8D0, 0x730C, 0x05B8, 0x5495, 0x2221, 0xB9FD, 0xCF49,
+        0x374E, 0x41FA, 0xDA26, 0xAC92, 0xFDBF, 0x8B0B, 0x10D7, 0x6663,
+        0xB28D, 0xC439, 0x5FE5, 0x2951, 0x787C, 0x0EC8, 0x9514, 0xE3A0,
+        0x2CE9, 0x5A5D, 0xC181, 0xB735, 0xE618, 0x90AC, 0x0B70, 0x7DC4,
+        0xA92A, 0xDF9E, 0x4442, 0x32F6, 0x63DB, 0x156F, 0x8EB3, 0xF807,
+        0x6E9C, 0x1828, 0x83F4, 0xF540, 0xA46D, 0xD2D9, 0x4905, 0x3FB1,
+        0xEB5F, 0x9DEB, 0x0637, 0x7083, 0x21AE, 0x571A, 0xCCC6, 0xBA72,
+        0x753B, 0x038F, 0x9853, 0xEEE7, 0xBFCA, 0xC97E, 0x52A2, 0x2416,
+        0xF0F8, 0x864C, 0x1D90, 0x6B24, 0x3A09, 0x4CBD, 0xD761, 0xA1D5,
+        0x59D2, 0x2F66, 0xB4BA, 0xC20E, 0x9323, 0xE597, 0x7E4B, 0x08FF,
+        0xDC11, 0xAAA5, 0x3179, 0x47CD, 0x16E0, 0x6054, 0xFB88, 0x8D3C,
+        0x4275, 0x34C1, 0xAF1D, 0xD9A9, 0x8884, 0xFE30, 0x65EC, 0x1358,
+        0xC7B6, 0xB102, 0x2ADE, 0x5C6A, 0x0D47, 0x7BF3, 0xE02F, 0x969B,
+        0xDD38, 0xAB8C, 0x3050, 0x46E4, 0x17C9, 0x617D, 0xFAA1, 0x8C15,
+        0x58FB, 0x2E4F, 0xB593, 0xC327, 0x920A, 0xE4BE, 0x7F62, 0x09D6,
+        0xC69F, 0xB02B, 0x2BF7, 0x5D43, 0x0C6E, 0x7ADA, 0xE106, 0x97B2,
+        0x435C, 0x35E8, 0xAE34, 0xD880, 0x89AD, 0xFF19, 0x64C5, 0x1271,
+        0xEA76, 0x9CC2, 0x071E, 0x71AA, 0x2087, 0x5633, 0xCDEF, 0xBB5B,
+        0x6FB5, 0x1901, 0x82DD, 0xF469, 0xA544, 0xD3F0, 0x482C, 0x3E98,
+        0xF1D1, 0x8765, 0x1CB9, 0x6A0D, 0x3B20, 0x4D94, 0xD648, 0xA0FC,
+        0x7412, 0x02A6, 0x997A, 0xEFCE, 0xBEE3, 0xC857, 0x538B, 0x253F,
+        0xB3A4, 0xC510, 0x5ECC, 0x2878, 0x7955, 0x0FE1, 0x943D, 0xE289,
+        0x3667, 0x40D3, 0xDB0F, 0xADBB, 0xFC96, 0x8A22, 0x11FE, 0x674A,
+        0xA803, 0xDEB7, 0x456B, 0x33DF, 0x62F2, 0x1446, 0x8F9A, 0xF92E,
+        0x2DC0, 0x5B74, 0xC0A8, 0xB61C, 0xE731, 0x9185, 0x0A59, 0x7CED,
+        0x84EA, 0xF25E, 0x6982, 0x1F36, 0x4E1B, 0x38AF, 0xA373, 0xD5C7,
+        0x0129, 0x779D, 0xEC41, 0x9AF5, 0xCBD8, 0xBD6C, 0x26B0, 0x5004,
+        0x9F4D, 0xE9F9, 0x7225, 0x0491, 0x55BC, 0x2308, 0xB8D4, 0xCE60,
+        0x1A8E, 0x6C3A, 0xF7E6, 0x8152, 0xD07F, 0xA6CB, 0x3D17, 0x4BA3
+    },
+    {
+        0x0000, 0xAA51, 0x4483, 0xEED2, 0x8906, 0x2357, 0xCD85, 0x67D4,
+        0x022D, 0xA87C, 0x46AE, 0xECFF, 0x8B2B, 0x217A, 0xCFA8, 0x65F9,
+        0x045A, 0xAE0B, 0x40D9, 0xEA88, 0x8D5C, 0x270D, 0xC9DF, 0x638E,
+        0x0677, 0xAC26, 0x42F4, 0xE8A5, 0x8F71, 0x2520, 0xCBF2, 0x61A3,
+        0x08B4, 0xA2E5, 0x4C37, 0xE666, 0x81B2, 0x2BE3, 0xC531, 0x6F60,
+        0x0A99, 0xA0C8, 0x4E1A, 0xE44B, 0x839F, 0x29CE, 0xC71C, 0x6D4D,
+        0x0CEE, 0xA6BF, 0x486D, 0xE23C, 0x85E8, 0x2FB9, 0xC16B, 0x6B3A,
+        0x0EC3, 0xA492, 0x4A40, 0xE011, 0x87C5, 0x2D94, 0xC346, 0x6917,
+        0x1168, 0xBB39, 0x55EB, 0xFFBA, 0x986E, 0x323F, 0xDCED, 0x76BC,
+        0x1345, 0xB914, 0x57C6, 0xFD97, 0x9A43, 0x3012, 0xDEC0, 0x7491,
+        0x1532, 0xBF63, 0x51B1, 0xFBE0, 0x9C34, 0x3665, 0xD8B7, 0x72E6,
+        0x171F, 0xBD4E, 0x539C, 0xF9CD, 0x9E19, 0x3448, 0xDA9A, 0x70CB,
+        0x19DC, 0xB38D, 0x5D5F, 0xF70E, 0x90DA, 0x3A8B, 0xD459, 0x7E08,
+        0x1BF1, 0xB1A0, 0x5F72, 0xF523, 0x92F7, 0x38A6, 0xD674, 0x7C25,
+        0x1D86, 0xB7D7, 0x5905, 0xF354, 0x9480, 0x3ED1, 0xD003, 0x7A52,
+        0x1FAB, 0xB5FA, 0x5B28, 0xF179, 0x96AD, 0x3CFC, 0xD22E, 0x787F,
+        0x22D0, 0x8881, 0x6653, 0xCC02, 0xABD6, 0x0187, 0xEF55, 0x4504,
+        0x20FD, 0x8AAC, 0x647E, 0xCE2F, 0xA9FB, 0x03AA, 0xED78, 0x4729,
+        0x268A, 0x8CDB, 0x6209, 0xC858, 0xAF8C, 0x05DD, 0xEB0F, 0x415E,
+        0x24A7, 0x8EF6, 0x6024, 0xCA75, 0xADA1, 0x07F0, 0xE922, 0x4373,
+        0x2A64, 0x8035, 0x6EE7, 0xC4B6, 0xA362, 0x0933, 0xE7E1, 0x4DB0,
+        0x2849, 0x8218, 0x6CCA, 0xC69B, 0xA14F, 0x0B1E, 0xE5CC, 0x4F9D,
+        0x2E3E, 0x846F, 0x6ABD, 0xC0EC, 0xA738, 0x0D69, 0xE3BB, 0x49EA,
+        0x2C13, 0x8642, 0x6890, 0xC2C1, 0xA515, 0x0F44, 0xE196, 0x4BC7,
+        0x33B8, 0x99E9, 0x773B, 0xDD6A, 0xBABE, 0x10EF, 0xFE3D, 0x546C,
+        0x3195, 0x9BC4, 0x7516, 0xDF47, 0xB893, 0x12C2, 0xFC10, 0x5641,
+        0x37E2, 0x9DB3, 0x7361, 0xD930, 0xBEE4, 0x14B5, 0xFA67, 0x5036,
+        0x35CF, 0x9F9E, 0x714C, 0xDB1D, 0xBCC9, 0x1698, 0xF84A, 0x521B,
+        0x3B0C, 0x915D, 0x7F8F, 0xD5DE, 0xB20A, 0x185B, 0xF689, 0x5CD8,
+        0x3921, 0x9370, 0x7DA2, 0xD7F3, 0xB027, 0x1A76, 0xF4A4, 0x5EF5,
+        0x3F56, 0x9507, 0x7BD5, 0xD184, 0xB650, 0x1C01, 0xF2D3, 0x5882,
+        0x3D7B, 0x972A, 0x79F8, 0xD3A9, 0xB47D, 0x1E2C, 0xF0FE, 0x5AAF
+    },
+    {
+        0x0000, 0x45A0, 0x8B40, 0xCEE0, 0x06A1, 0x4301, 0x8DE1, 0xC841,
+        0x0D42, 0x48E2, 0x8602, 0xC3A2, 0x0BE3, 0x4E43, 0x80A3, 0xC503,
+        0x1A84, 0x5F24, 0x91C4, 0xD464, 0x1C25, 0x5985, 0x9765, 0xD2C5,
+        0x17C6, 0x5266, 0x9C86, 0xD926, 0x1167, 0x54C7, 0x9A27, 0xDF87,
+        0x3508, 0x70A8, 0xBE48, 0xFBE8, 0x33A9, 0x7609, 0xB8E9, 0xFD49,
+        0x384A, 0x7DEA, 0xB30A, 0xF6AA, 0x3EEB, 0x7B4B, 0xB5AB, 0xF00B,
+        0x2F8C, 0x6A2C, 0xA4CC, 0xE16C, 0x292D, 0x6C8D, 0xA26D, 0xE7CD,
+        0x22CE, 0x676E, 0xA98E, 0xEC2E, 0x246F, 0x61CF, 0xAF2F, 0xEA8F,
+        0x6A10, 0x2FB0, 0xE150, 0xA4F0, 0x6CB1, 0x2911, 0xE7F1, 0xA251,
+        0x6752, 0x22F2, 0xEC12, 0xA9B2, 0x61F3, 0x2453, 0xEAB3, 0xAF13,
+        0x7094, 0x3534, 0xFBD4, 0xBE74, 0x7635, 0x3395, 0xFD75, 0xB8D5,
+        0x7DD6, 0x3876, 0xF696, 0xB336, 0x7B77, 0x3ED7, 0xF037, 0xB597,
+        0x5F18, 0x1AB8, 0xD458, 0x91F8, 0x59B9, 0x1C19, 0xD2F9, 0x9759,
+        0x525A, 0x17FA, 0xD91A, 0x9CBA, 0x54FB, 0x115B, 0xDFBB, 0x9A1B,
+        0x459C, 0x003C, 0xCEDC, 0x8B7C, 0x433D, 0x069D, 0xC87D, 0x8DDD,
+        0x48DE, 0x0D7E, 0xC39E, 0x863E, 0x4E7F, 0x0BDF, 0xC53F, 0x809F,
+        0xD420, 0x9180, 0x5F60, 0x1AC0, 0xD281, 0x9721, 0x59C1, 0x1C61,
+        0xD962, 0x9CC2, 0x5222, 0x1782, 0xDFC3, 0x9A63, 0x5483, 0x1123,
+        0xCEA4, 0x8B04, 0x45E4, 0x0044, 0xC805, 0x8DA5, 0x4345, 0x06E5,
+        0xC3E6, 0x8646, 0x48A6, 0x0D06, 0xC547, 0x80E7, 0x4E07, 0x0BA7,
+        0xE128, 0xA488, 0x6A68, 0x2FC8, 0xE789, 0xA229, 0x6CC9, 0x2969,
+        0xEC6A, 0xA9CA, 0x672A, 0x228A, 0xEACB, 0xAF6B, 0x618B, 0x242B,
+        0xFBAC, 0xBE0C, 0x70EC, 0x354C, 0xFD0D, 0xB8AD, 0x764D, 0x33ED,
+        0xF6EE, 0xB34E, 0x7DAE, 0x380E, 0xF04F, 0xB5EF, 0x7B0F, 0x3EAF,
+        0xBE30, 0xFB90, 0x3570, 0x70D0, 0xB891, 0xFD31, 0x33D1, 0x7671,
+        0xB372, 0xF6D2, 0x3832, 0x7D92, 0xB5D3, 0xF073, 0x3E93, 0x7B33,
+        0xA4B4, 0xE114, 0x2FF4, 0x6A54, 0xA215, 0xE7B5, 0x2955, 0x6CF5,
+        0xA9F6, 0xEC56, 0x22B6, 0x6716, 0xAF57, 0xEAF7, 0x2417, 0x61B7,
+        0x8B38, 0xCE98, 0x0078, 0x45D8, 0x8D99, 0xC839, 0x06D9, 0x4379,
+        0x867A, 0xC3DA, 0x0D3A, 0x489A, 0x80DB, 0xC57B, 0x0B9B, 0x4E3B,
+        0x91BC, 0xD41C, 0x1AFC, 0x5F5C, 0x971D, 0xD2BD, 0x1C5D, 0x59FD,
+        0x9CFE, 0xD95E, 0x17BE, 0x521E, 0x9A5F, 0xDFFF, 0x111F, 0x54BF
+    },
+    {
+        0x0000, 0xB861, 0x60E3, 0xD882, 0xC1C6, 0x79A7, 0xA125, 0x1944,
+        0x93AD, 0x2BCC, 0xF34E, 0x4B2F, 0x526B, 0xEA0A, 0x3288, 0x8AE9,
+        0x377B, 0x8F1A, 0x5798, 0xEFF9, 0xF6BD, 0x4EDC, 0x965E, 0x2E3F,
+        0xA4D6, 0x1CB7, 0xC435, 0x7C54, 0x6510, 0xDD71, 0x05F3, 0xBD92,
+        0x6EF6, 0xD697, 0x0E15, 0xB674, 0xAF30, 0x1751, 0xCFD3, 0x77B2,
+        0xFD5B, 0x453A, 0x9DB8, 0x25D9, 0x3C9D, 0x84FC, 0x5C7E, 0xE41F,
+        0x598D, 0xE1EC, 0x396E, 0x810F, 0x984B, 0x202A, 0xF8A8, 0x40C9,
+        0xCA20, 0x7241, 0xAAC3, 0x12A2, 0x0BE6, 0xB387, 0x6B05, 0xD364,
+        0xDDEC, 0x658D, 0xBD0F, 0x056E, 0x1C2A, 0xA44B, 0x7CC9, 0xC4A8,
+        0x4E41, 0xF620, 0x2EA2, 0x96C3, 0x8F87, 0x37E6, 0xEF64, 0x5705,
+        0xEA97, 0x52F6, 0x8A74, 0x3215, 0x2B51, 0x9330, 0x4BB2, 0xF3D3,
+        0x793A, 0xC15B, 0x19D9, 0xA1B8, 0xB8FC, 0x009D, 0xD81F, 0x607E,
+        0xB31A, 0x0B7B, 0xD3F9, 0x6B98, 0x72DC, 0xCABD, 0x123F, 0xAA5E,
+        0x20B7, 0x98D6, 0x4054, 0xF835, 0xE171, 0x5910, 0x8192, 0x39F3,
+        0x8461, 0x3C00, 0xE482, 0x5CE3, 0x45A7, 0xFDC6, 0x2544, 0x9D25,
+        0x17CC, 0xAFAD, 0x772F, 0xCF4E, 0xD60A, 0x6E6B, 0xB6E9, 0x0E88,
+        0xABF9, 0x1398, 0xCB1A, 0x737B, 0x6A3F, 0xD25E, 0x0ADC, 0xB2BD,
+        0x3854, 0x8035, 0x58B7, 0xE0D6, 0xF992, 0x41F3, 0x9971, 0x2110,
+        0x9C82, 0x24E3, 0xFC61, 0x4400, 0x5D44, 0xE525, 0x3DA7, 0x85C6,
+        0x0F2F, 0xB74E, 0x6FCC, 0xD7AD, 0xCEE9, 0x7688, 0xAE0A, 0x166B,
+        0xC50F, 0x7D6E, 0xA5EC, 0x1D8D, 0x04C9, 0xBCA8, 0x642A, 0xDC4B,
+        0x56A2, 0xEEC3, 0x3641, 0x8E20, 0x9764, 0x2F05, 0xF787, 0x4FE6,
+        0xF274, 0x4A15, 0x9297, 0x2AF6, 0x33B2, 0x8BD3, 0x5351, 0xEB30,
+        0x61D9, 0xD9B8, 0x013A, 0xB95B, 0xA01F, 0x187E, 0xC0FC, 0x789D,
+        0x7615, 0xCE74, 0x16F6, 0xAE97, 0xB7D3, 0x0FB2, 0xD730, 0x6F51,
+        0xE5B8, 0x5DD9, 0x855B, 0x3D3A, 0x247E, 0x9C1F, 0x449D, 0xFCFC,
+        0x416E, 0xF90F, 0x218D, 0x99EC, 0x80A8, 0x38C9, 0xE04B, 0x582A,
+        0xD2C3, 0x6AA2, 0xB220, 0x0A41, 0x1305, 0xAB64, 0x73E6, 0xCB87,
+        0x18E3, 0xA082, 0x7800, 0xC061, 0xD925, 0x6144, 0xB9C6, 0x01A7,
+        0x8B4E, 0x332F, 0xEBAD, 0x53CC, 0x4A88, 0xF2E9, 0x2A6B, 0x920A,
+        0x2F98, 0x97F9, 0x4F7B, 0xF71A, 0xEE5E, 0x563F, 0x8EBD, 0x36DC,
+        0xBC35, 0x0454, 0xDCD6, 0x64B7, 0x7DF3, 0xC592, 0x1D10, 0xA571
+    },
+    {
+        0x0000, 0x47D3, 0x8FA6, 0xC875, 0x0F6D, 0x48BE, 0x80CB, 0xC718,
+        0x1EDA, 0x5909, 0x917C, 0xD6AF, 0x11B7, 0x5664, 0x9E11, 0xD9C2,
+        0x3DB4, 0x7A67, 0xB212, 0xF5C1, 0x32D9, 0x750A, 0xBD7F, 0xFAAC,
+        0x236E, 0x64BD, 0xACC8, 0xEB1B, 0x2C03, 0x6BD0, 0xA3A5, 0xE476,
+        0x7B68, 0x3CBB, 0xF4CE, 0xB31D, 0x7405, 0x33D6, 0xFBA3, 0xBC70,
+        0x65B2, 0x2261, 0xEA14, 0xADC7, 0x6ADF, 0x2D0C, 0xE579, 0xA2AA,
+        0x46DC, 0x010F, 0xC97A, 0x8EA9, 0x49B1, 0x0E62, 0xC617, 0x81C4,
+        0x5806, 0x1FD5, 0xD7A0, 0x9073, 0x576B, 0x10B8, 0xD8CD, 0x9F1E,
+        0xF6D0, 0xB103, 0x7976, 0x3EA5, 0xF9BD, 0xBE6E, 0x761B, 0x31C8,
+        0xE80A, 0xAFD9, 0x67AC, 0x207F, 0xE767, 0xA0B4, 0x68C1, 0x2F12,
+        0xCB64, 0x8CB7, 0x44C2, 0x0311, 0xC409, 0x83DA, 0x4BAF, 0x0C7C,
+        0xD5BE, 0x926D, 0x5A18, 0x1DCB, 0xDAD3, 0x9D00, 0x5575, 0x12A6,
+        0x8DB8, 0xCA6B, 0x021E, 0x45CD, 0x82D5, 0xC506, 0x0D73, 0x4AA0,
+        0x9362, 0xD4B1, 0x1CC4, 0x5B17, 0x9C0F, 0xDBDC, 0x13A9, 0x547A,
+        0xB00C, 0xF7DF, 0x3FAA, 0x7879, 0xBF61, 0xF8B2, 0x30C7, 0x7714,
+        0xAED6, 0xE905, 0x2170, 0x66A3, 0xA1BB, 0xE668, 0x2E1D, 0x69CE,
+        0xFD81, 0xBA52, 0x7227, 0x35F4, 0xF2EC, 0xB53F, 0x7D4A, 0x3A99,
+        0xE35B, 0xA488, 0x6CFD, 0x2B2E, 0xEC36, 0xABE5, 0x6390, 0x2443,
+        0xC035, 0x87E6, 0x4F93, 0x0840, 0xCF58, 0x888B, 0x40FE, 0x072D,
+        0xDEEF, 0x993C, 0x5149, 0x169A, 0xD182, 0x9651, 0x5E24, 0x19F7,
+        0x86E9, 0xC13A, 0x094F, 0x4E9C, 0x8984, 0xCE57, 0x0622, 0x41F1,
+        0x9833, 0xDFE0, 0x1795, 0x5046, 0x975E, 0xD08D, 0x18F8, 0x5F2B,
+        0xBB5D, 0xFC8E, 0x34FB, 0x7328, 0xB430, 0xF3E3, 0x3B96, 0x7C45,
+        0xA587, 0xE254, 0x2A21, 0x6DF2, 0xAAEA, 0xED39, 0x254C, 0x629F,
+        0x0B51, 0x4C82, 0x84F7, 0xC324, 0x043C, 0x43EF, 0x8B9A, 0xCC49,
+        0x158B, 0x5258, 0x9A2D, 0xDDFE, 0x1AE6, 0x5D35, 0x9540, 0xD293,
+        0x36E5, 0x7136, 0xB943, 0xFE90, 0x3988, 0x7E5B, 0xB62E, 0xF1FD,
+        0x283F, 0x6FEC, 0xA799, 0xE04A, 0x2752, 0x6081, 0xA8F4, 0xEF27,
+        0x7039, 0x37EA, 0xFF9F, 0xB84C, 0x7F54, 0x3887, 0xF0F2, 0xB721,
+        0x6EE3, 0x2930, 0xE145, 0xA696, 0x618E, 0x265D, 0xEE28, 0xA9FB,
+        0x4D8D, 0x0A5E, 0xC22B, 0x85F8, 0x42E0, 0x0533, 0xCD46, 0x8A95,
+        0x5357, 0x1484, 0xDCF1, 0x9B22, 0x5C3A, 0x1BE9, 0xD39C, 0x944F
     }
-}
-
-void generate_table(uint16_t polynomial, bool refin) {
-
-    for (uint16_t i = 0; i < 256; i++) {
-        uint16_t c, crc = 0;
-        if (refin)
-            c = reflect8(i) << 8;
-        else
-            c = i << 8;
-
-        for (uint16_t j = 0; j < 8; j++) {
-
-            if ((crc ^ c) & 0x8000)
-                crc = (crc << 1) ^ polynomial;
-            else
-                crc =   crc << 1;
+#endif
+};
 
-            c = c << 1;
-        }
-        if (refin)
-            crc = reflect16(crc);
-
-        crc_table[i] = crc;
+// poly 0x1021, reflected
+static const uint16_t crc16_table_ccitt_refl[CRC16_SLICES][256] = {
+    {
+        0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+        0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+        0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+        0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+        0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+        0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+        0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+        0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+        0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+        0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+        0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+        0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+        0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+        0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+        0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+        0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+        0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+        0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+        0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+        0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+        0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+        0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+        0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+        0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+        0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+        0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+        0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+        0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+        0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+        0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+        0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+        0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78
+    },
+#if CRC16_SLICES == 8
+    {
+        0x0000, 0x19D8, 0x33B0, 0x2A68, 0x6760, 0x7EB8, 0x54D0, 0x4D08,
+        0xCEC0, 0xD718, 0xFD70, 0xE4A8, 0xA9A0, 0xB078, 0x9A10, 0x83C8,
+        0x9591, 0x8C49, 0xA621, 0xBFF9, 0xF2F1, 0xEB29, 0xC141, 0xD899,
+        0x5B51, 0x4289, 0x68E1, 0x7139, 0x3C31, 0x25E9, 0x0F81, 0x1659,
+        0x2333, 0x3AEB, 0x1083, 0x095B, 0x4453, 0x5D8B, 0x77E3, 0x6E3B,
+        0xEDF3, 0xF42B, 0xDE43, 0xC79B, 0x8A93, 0x934B, 0xB923, 0xA0FB,
+        0xB6A2, 0xAF7A, 0x8512, 0x9CCA, 0xD1C2, 0xC81A, 0xE272, 0xFBAA,
+        0x7862, 0x61BA, 0x4BD2, 0x520A, 0x1F02, 0x06DA, 0x2CB2, 0x356A,
+        0x4666, 0x5FBE, 0x75D6, 0x6C0E, 0x2106, 0x38DE, 0x12B6, 0x0B6E,
+        0x88A6, 0x917E, 0xBB16, 0xA2CE, 0xEFC6, 0xF61E, 0xDC76, 0xC5AE,
+        0xD3F7, 0xCA2F, 0xE047, 0xF99F, 0xB497, 0xAD4F, 0x8727, 0x9EFF,
+        0x1D37, 0x04EF, 0x2E87, 0x375F, 0x7A57, 0x638F, 0x49E7, 0x503F,
+        0x6555, 0x7C8D, 0x56E5, 0x4F3D, 0x0235, 0x1BED, 0x3185, 0x285D,
+        0xAB95, 0xB24D, 0x9825, 0x81FD, 0xCCF5, 0xD52D, 0xFF45, 0xE69D,
+        0xF0C4, 0xE91C, 0xC374, 0xDAAC, 0x97A4, 0x8E7C, 0xA414, 0xBDCC,
+        0x3E04, 0x27DC, 0x0DB4, 0x146C, 0x5964, 0x40BC, 0x6AD4, 0x730C,
+        0x8CCC, 0x9514, 0xBF7C, 0xA6A4, 0xEBAC, 0xF274, 0xD81C, 0xC1C4,
+        0x420C, 0x5BD4, 0x71BC, 0x6864, 0x256C, 0x3CB4, 0x16DC, 0x0F04,
+        0x195D, 0x0085, 0x2AED, 0x3335, 0x7E3D, 0x67E5, 0x4D8D, 0x5455,
+        0xD79D, 0xCE45, 0xE42D, 0xFDF5, 0xB0FD, 0xA925, 0x834D, 0x9A95,
+        0xAFFF, 0xB627, 0x9C4F, 0x8597, 0xC89F, 0xD147, 0xFB2F, 0xE2F7,
+        0x613F, 0x78E7, 0x528F, 0x4B57, 0x065F, 0x1F87, 0x35EF, 0x2C37,
+        0x3A6E, 0x23B6, 0x09DE, 0x1006, 0x5D0E, 0x44D6, 0x6EBE, 0x7766,
+        0xF4AE, 0xED76, 0xC71E, 0xDEC6, 0x93CE, 0x8A16, 0xA07E, 0xB9A6,
+        0xCAAA, 0xD372, 0xF91A, 0xE0C2, 0xADCA, 0xB412, 0x9E7A, 0x87A2,
+        0x046A, 0x1DB2, 0x37DA, 0x2E02, 0x630A, 0x7AD2, 0x50BA, 0x4962,
+        0x5F3B, 0x46E3, 0x6C8B, 0x7553, 0x385B, 0x2183, 0x0BEB, 0x1233,
+        0x91FB, 0x8823, 0xA24B, 0xBB93, 0xF69B, 0xEF43, 0xC52B, 0xDCF3,
+        0xE999, 0xF041, 0xDA29, 0xC3F1, 0x8EF9, 0x9721, 0xBD49, 0xA491,
+        0x2759, 0x3E81, 0x14E9, 0x0D31, 0x4039, 0x59E1, 0x7389, 0x6A51,
+        0x7C08, 0x65D0, 0x4FB8, 0x5660, 0x1B68, 0x02B0, 0x28D8, 0x3100,
+        0xB2C8, 0xAB10, 0x8178, 0x98A0, 0xD5A8, 0xCC70, 0xE618, 0xFFC0
+    },
+    {
+        0x0000, 0x5ADC, 0xB5B8, 0xEF64, 0x6361, 0x39BD, 0xD6D9, 0x8C05,
+        0xC6C2, 0x9C1E, 0x737A, 0x29A6, 0xA5A3, 0xFF7F, 0x101B, 0x4AC7,
+        0x8595, 0xDF49, 0x302D, 0x6AF1, 0xE6F4, 0xBC28, 0x534C, 0x0990,
+        0x4357, 0x198B, 0xF6EF, 0xAC33, 0x2036, 0x7AEA, 0x958E, 0xCF52,
+        0x033B, 0x59E7, 0xB683, 0xEC5F, 0x605A, 0x3A86, 0xD5E2, 0x8F3E,
+        0xC5F9, 0x9F25, 0x7041, 0x2A9D, 0xA698, 0xFC44, 0x1320, 0x49FC,
+        0x86AE, 0xDC72, 0x3316, 0x69CA, 0xE5CF, 0xBF13, 0x5077, 0x0AAB,
+        0x406C, 0x1AB0, 0xF5D4, 0xAF08, 0x230D, 0x79D1, 0x96B5, 0xCC69,
+        0x0676, 0x5CAA, 0xB3CE, 0xE912, 0x6517, 0x3FCB, 0xD0AF, 0x8A73,
+        0xC0B4, 0x9A68, 0x750C, 0x2FD0, 0xA3D5, 0xF909, 0x166D, 0x4CB1,
+        0x83E3, 0xD93F, 0x365B, 0x6C87, 0xE082, 0xBA5E, 0x553A, 0x0FE6,
+        0x4521, 0x1FFD, 0xF099, 0xAA45, 0x2640, 0x7C9C, 0x93F8, 0xC924,
+        0x054D, 0x5F91, 0xB0F5, 0xEA29, 0x662C, 0x3CF0, 0xD394, 0x8948,
+        0xC38F, 0x9953, 0x7637, 0x2CEB, 0xA0EE, 0xFA32, 0x1556, 0x4F8A,
+        0x80D8, 0xDA04, 0x3560, 0x6FBC, 0xE3B9, 0xB965, 0x5601, 0x0CDD,
+        0x461A, 0x1CC6, 0xF3A2, 0xA97E, 0x257B, 0x7FA7, 0x90C3, 0xCA1F,
+        0x0CEC, 0x5630, 0xB954, 0xE388, 0x6F8D, 0x3551, 0xDA35, 0x80E9,
+        0xCA2E, 0x90F2, 0x7F96, 0x254A, 0xA94F, 0xF393, 0x1CF7, 0x462B,
+        0x8979, 0xD3A5, 0x3CC1, 0x661D, 0xEA18, 0xB0C4, 0x5FA0, 0x057C,
+        0x4FBB, 0x1567, 0xFA03, 0xA0DF, 0x2CDA, 0x7606, 0x9962, 0xC3BE,
+        0x0FD7, 0x550B, 0xBA6F, 0xE0B3, 0x6CB6, 0x366A, 0xD90E, 0x83D2,
+        0xC915, 0x93C9, 0x7CAD, 0x2671, 0xAA74, 0xF0A8, 0x1FCC, 0x4510,
+        0x8A42, 0xD09E, 0x3FFA, 0x6526, 0xE923, 0xB3FF, 0x5C9B, 0x0647,
+        0x4C80, 0x165C, 0xF938, 0xA3E4, 0x2FE1, 0x753D, 0x9A59, 0xC085,
+        0x0A9A, 0x5046, 0xBF22, 0xE5FE, 0x69FB, 0x3327, 0xDC43, 0x869F,
+        0xCC58, 0x9684, 0x79E0, 0x233C, 0xAF39, 0xF5E5, 0x1A81, 0x405D,
+        0x8F0F, 0xD5D3, 0x3AB7, 0x606B, 0xEC6E, 0xB6B2, 0x59D6, 0x030A,
+        0x49CD, 0x1311, 0xFC75, 0xA6A9, 0x2AAC, 0x7070, 0x9F14, 0xC5C8,
+        0x09A1, 0x537D, 0xBC19, 0xE6C5, 0x6AC0, 0x301C, 0xDF78, 0x85A4,
+        0xCF63, 0x95BF, 0x7ADB, 0x2007, 0xAC02, 0xF6DE, 0x19BA, 0x4366,
+        0x8C34, 0xD6E8, 0x398C, 0x6350, 0xEF55, 0xB589, 0x5AED, 0x0031,
+        0x4AF6, 0x102A, 0xFF4E, 0xA592, 0x2997, 0x734B, 0x9C2F, 0xC6F3
+    },
+    {
+        0x0000, 0x1CBB, 0x3976, 0x25CD, 0x72EC, 0x6E57, 0x4B9A, 0x5721,
+        0xE5D8, 0xF963, 0xDCAE, 0xC015, 0x9734, 0x8B8F, 0xAE42, 0xB2F9,
+        0xC3A1, 0xDF1A, 0xFAD7, 0xE66C, 0xB14D, 0xADF6, 0x883B, 0x9480,
+        0x2679, 0x3AC2, 0x1F0F, 0x03B4, 0x5495, 0x482E, 0x6DE3, 0x7158,
+        0x8F53, 0x93E8, 0xB625, 0xAA9E, 0xFDBF, 0xE104, 0xC4C9, 0xD872,
+        0x6A8B, 0x7630, 0x53FD, 0x4F46, 0x1867, 0x04DC, 0x2111, 0x3DAA,
+        0x4CF2, 0x5049, 0x7584, 0x693F, 0x3E1E, 0x22A5, 0x0768, 0x1BD3,
+        0xA92A, 0xB591, 0x905C, 0x8CE7, 0xDBC6, 0xC77D, 0xE2B0, 0xFE0B,
+        0x16B7, 0x0A0C, 0x2FC1, 0x337A, 0x645B, 0x78E0, 0x5D2D, 0x4196,
+        0xF36F, 0xEFD4, 0xCA19, 0xD6A2, 0x8183, 0x9D38, 0xB8F5, 0xA44E,
+        0xD516, 0xC9AD, 0xEC60, 0xF0DB, 0xA7FA, 0xBB41, 0x9E8C, 0x8237,
+        0x30CE, 0x2C75, 0x09B8, 0x1503, 0x4222, 0x5E99, 0x7B54, 0x67EF,
+        0x99E4, 0x855F, 0xA092, 0xBC29, 0xEB08, 0xF7B3, 0xD27E, 0xCEC5,
+        0x7C3C, 0x6087, 0x454A, 0x59F1, 0x0ED0, 0x126B, 0x37A6, 0x2B1D,
+        0x5A45, 0x46FE, 0x6333, 0x7F88, 0x28A9, 0x3412, 0x11DF, 0x0D64,
+        0xBF9D, 0xA326, 0x86EB, 0x9A50, 0xCD71, 0xD1CA, 0xF407, 0xE8BC,
+        0x2D6E, 0x31D5, 0x1418, 0x08A3, 0x5F82, 0x4339, 0x66F4, 0x7A4F,
+        0xC8B6, 0xD40D, 0xF1C0, 0xED7B, 0xBA5A, 0xA6E1, 0x832C, 0x9F97,
+        0xEECF, 0xF274, 0xD7B9, 0xCB02, 0x9C23, 0x8098, 0xA555, 0xB9EE,
+        0x0B17, 0x17AC, 0x3261, 0x2EDA, 0x79FB, 0x6540, 0x408D, 0x5C36,
+        0xA23D, 0xBE86, 0x9B4B, 0x87F0, 0xD0D1, 0xCC6A, 0xE9A7, 0xF51C,
+        0x47E5, 0x5B5E, 0x7E93, 0x6228, 0x3509, 0x29B2, 0x0C7F, 0x10C4,
+        0x619C, 0x7D27, 0x58EA, 0x4451, 0x1370, 0x0FCB, 0x2A06, 0x36BD,
+        0x8444, 0x98FF, 0xBD32, 0xA189, 0xF6A8, 0xEA13, 0xCFDE, 0xD365,
+        0x3BD9, 0x2762, 0x02AF, 0x1E14, 0x4935, 0x558E, 0x7043, 0x6CF8,
+        0xDE01, 0xC2BA, 0xE777, 0xFBCC, 0xACED, 0xB056, 0x959B, 0x8920,
+        0xF878, 0xE4C3, 0xC10E, 0xDDB5, 0x8A94, 0x962F, 0xB3E2, 0xAF59,
+        0x1DA0, 0x011B, 0x24D6, 0x386D, 0x6F4C, 0x73F7, 0x563A, 0x4A81,
+        0xB48A, 0xA831, 0x8DFC, 0x9147, 0xC666, 0xDADD, 0xFF10, 0xE3AB,
+        0x5152, 0x4DE9, 0x6824, 0x749F, 0x23BE, 0x3F05, 0x1AC8, 0x0673,
+        0x772B, 0x6B90, 0x4E5D, 0x52E6, 0x05C7, 0x197C, 0x3CB1, 0x200A,
+        0x92F3, 0x8E48, 0xAB85, 0xB73E, 0xE01F, 0xFCA4, 0xD969, 0xC5D2
+    },
+    {
+        0x0000, 0x0B44, 0x1688, 0x1DCC, 0x2D10, 0x2654, 0x3B98, 0x30DC,
+        0x5A20, 0x5164, 0x4CA8, 0x47EC, 0x7730, 0x7C74, 0x61B8, 0x6AFC,
+        0xB440, 0xBF04, 0xA2C8, 0xA98C, 0x9950, 0x9214, 0x8FD8, 0x849C,
+        0xEE60, 0xE524, 0xF8E8, 0xF3AC, 0xC370, 0xC834, 0xD5F8, 0xDEBC,
+        0x6091, 0x6BD5, 0x7619, 0x7D5D, 0x4D81, 0x46C5, 0x5B09, 0x504D,
+        0x3AB1, 0x31F5, 0x2C39, 0x277D, 0x17A1, 0x1CE5, 0x0129, 0x0A6D,
+        0xD4D1, 0xDF95, 0xC259, 0xC91D, 0xF9C1, 0xF285, 0xEF49, 0xE40D,
+        0x8EF1, 0x85B5, 0x9879, 0x933D, 0xA3E1, 0xA8A5, 0xB569, 0xBE2D,
+        0xC122, 0xCA66, 0xD7AA, 0xDCEE, 0xEC32, 0xE776, 0xFABA, 0xF1FE,
+        0x9B02, 0x9046, 0x8D8A, 0x86CE, 0xB612, 0xBD56, 0xA09A, 0xABDE,
+        0x7562, 0x7E26, 0x63EA, 0x68AE, 0x5872, 0x5336, 0x4EFA, 0x45BE,
+        0x2F42, 0x2406, 0x39CA, 0x328E, 0x0252, 0x0916, 0x14DA, 0x1F9E,
+        0xA1B3, 0xAAF7, 0xB73B, 0xBC7F, 0x8CA3, 0x87E7, 0x9A2B, 0x916F,
+        0xFB93, 0xF0D7, 0xED1B, 0xE65F, 0xD683, 0xDDC7, 0xC00B, 0xCB4F,
+        0x15F3, 0x1EB7, 0x037B, 0x083F, 0x38E3, 0x33A7, 0x2E6B, 0x252F,
+        0x4FD3, 0x4497, 0x595B, 0x521F, 0x62C3, 0x6987, 0x744B, 0x7F0F,
+        0x8A55, 0x8111, 0x9CDD, 0x9799, 0xA745, 0xAC01, 0xB1CD, 0xBA89,
+        0xD075, 0xDB31, 0xC6FD, 0xCDB9, 0xFD65, 0xF621, 0xEBED, 0xE0A9,
+        0x3E15, 0x3551, 0x289D, 0x23D9, 0x1305, 0x1841, 0x058D, 0x0EC9,
+        0x6435, 0x6F71, 0x72BD, 0x79F9, 0x4925, 0x4261, 0x5FAD, 0x54E9,
+        0xEAC4, 0xE180, 0xFC4C, 0xF708, 0xC7D4, 0xCC90, 0xD15C, 0xDA18,
+        0xB0E4, 0xBBA0, 0xA66C, 0xAD28, 0x9DF4, 0x96B0, 0x8B7C, 0x8038,
+        0x5E84, 0x55C0, 0x480C, 0x4348, 0x7394, 0x78D0, 0x651C, 0x6E58,
+        0x04A4, 0x0FE0, 0x122C, 0x1968, 0x29B4, 0x22F0, 0x3F3C, 0x3478,
+        0x4B77, 0x4033, 0x5DFF, 0x56BB, 0x6667, 0x6D23, 0x70EF, 0x7BAB,
+        0x1157, 0x1A13, 0x07DF, 0x0C9B, 0x3C47, 0x3703, 0x2ACF, 0x218B,
+        0xFF37, 0xF473, 0xE9BF, 0xE2FB, 0xD227, 0xD963, 0xC4AF, 0xCFEB,
+        0xA517, 0xAE53, 0xB39F, 0xB8DB, 0x8807, 0x8343, 0x9E8F, 0x95CB,
+        0x2BE6, 0x20A2, 0x3D6E, 0x362A, 0x06F6, 0x0DB2, 0x107E, 0x1B3A,
+        0x71C6, 0x7A82, 0x674E, 0x6C0A, 0x5CD6, 0x5792, 0x4A5E, 0x411A,
+        0x9FA6, 0x94E2, 0x892E, 0x826A, 0xB2B6, 0xB9F2, 0xA43E, 0xAF7A,
+        0xC586, 0xCEC2, 0xD30E, 0xD84A, 0xE896, 0xE3D2, 0xFE1E, 0xF55A
+    },
+    {
+        0x0000, 0x042B, 0x0856, 0x0C7D, 0x10AC, 0x1487, 0x18FA, 0x1CD1,
+        0x2158, 0x2573, 0x290E, 0x2D25, 0x31F4, 0x35DF, 0x39A2, 0x3D89,
+        0x42B0, 0x469B, 0x4AE6, 0x4ECD, 0x521C, 0x5637, 0x5A4A, 0x5E61,
+        0x63E8, 0x67C3, 0x6BBE, 0x6F95, 0x7344, 0x776F, 0x7B12, 0x7F39,
+        0x8560, 0x814B, 0x8D36, 0x891D, 0x95CC, 0x91E7, 0x9D9A, 0x99B1,
+        0xA438, 0xA013, 0xAC6E, 0xA845, 0xB494, 0xB0BF, 0xBCC2, 0xB8E9,
+        0xC7D0, 0xC3FB, 0xCF86, 0xCBAD, 0xD77C, 0xD357, 0xDF2A, 0xDB01,
+        0xE688, 0xE2A3, 0xEEDE, 0xEAF5, 0xF624, 0xF20F, 0xFE72, 0xFA59,
+        0x02D1, 0x06FA, 0x0A87, 0x0EAC, 0x127D, 0x1656, 0x1A2B, 0x1E00,
+        0x2389, 0x27A2, 0x2BDF, 0x2FF4, 0x3325, 0x370E, 0x3B73, 0x3F58,
+        0x4061, 0x444A, 0x4837, 0x4C1C, 0x50CD, 0x54E6, 0x589B, 0x5CB0,
+        0x6139, 0x6512, 0x696F, 0x6D44, 0x7195, 0x75BE, 0x79C3, 0x7DE8,
+        0x87B1, 0x839A, 0x8FE7, 0x8BCC, 0x971D, 0x9336, 0x9F4B, 0x9B60,
+        0xA6E9, 0xA2C2, 0xAEBF, 0xAA94, 0xB645, 0xB26E, 0xBE13, 0xBA38,
+        0xC501, 0xC12A, 0xCD57, 0xC97C, 0xD5AD, 0xD186, 0xDDFB, 0xD9D0,
+        0xE459, 0xE072, 0xEC0F, 0xE824, 0xF4F5, 0xF0DE, 0xFCA3, 0xF888,
+        0x05A2, 0x0189, 0x0DF4, 0x09DF, 0x150E, 0x1125, 0x1D58, 0x1973,
+        0x24FA, 0x20D1, 0x2CAC, 0x2887, 0x3456, 0x307D, 0x3C00, 0x382B,
+        0x4712, 0x4339, 0x4F44, 0x4B6F, 0x57BE, 0x5395, 0x5FE8, 0x5BC3,
+        0x664A, 0x6261, 0x6E1C, 0x6A37, 0x76E6, 0x72CD, 0x7EB0, 0x7A9B,
+        0x80C2, 0x84E9, 0x8894, 0x8CBF, 0x906E, 0x9445, 0x9838, 0x9C13,
+        0xA19A, 0xA5B1, 0xA9CC, 0xADE7, 0xB136, 0xB51D, 0xB960, 0xBD4B,
+        0xC272, 0xC659, 0xCA24, 0xCE0F, 0xD2DE, 0xD6F5, 0xDA88, 0xDEA3,
+        0xE32A, 0xE701, 0xEB7C, 0xEF57, 0xF386, 0xF7AD, 0xFBD0, 0xFFFB,
+        0x0773, 0x0358, 0x0F25, 0x0B0E, 0x17DF, 0x13F4, 0x1F89, 0x1BA2,
+        0x262B, 0x2200, 0x2E7D, 0x2A56, 0x3687, 0x32AC, 0x3ED1, 0x3AFA,
+        0x45C3, 0x41E8, 0x4D95, 0x49BE, 0x556F, 0x5144, 0x5D39, 0x5912,
+        0x649B, 0x60B0, 0x6CCD, 0x68E6, 0x7437, 0x701C, 0x7C61, 0x784A,
+        0x8213, 0x8638, 0x8A45, 0x8E6E, 0x92BF, 0x9694, 0x9AE9, 0x9EC2,
+        0xA34B, 0xA760, 0xAB1D, 0xAF36, 0xB3E7, 0xB7CC, 0xBBB1, 0xBF9A,
+        0xC0A3, 0xC488, 0xC8F5, 0xCCDE, 0xD00F, 0xD424, 0xD859, 0xDC72,
+        0xE1FB, 0xE5D0, 0xE9AD, 0xED86, 0xF157, 0xF57C, 0xF901, 0xFD2A
+    },
+    {
+        0x0000, 0x9FD5, 0x37BB, 0xA86E, 0x6F76, 0xF0A3, 0x58CD, 0xC718,
+        0xDEEC, 0x4139, 0xE957, 0x7682, 0xB19A, 0x2E4F, 0x8621, 0x19F4,
+        0xB5C9, 0x2A1C, 0x8272, 0x1DA7, 0xDABF, 0x456A, 0xED04, 0x72D1,
+        0x6B25, 0xF4F0, 0x5C9E, 0xC34B, 0x0453, 0x9B86, 0x33E8, 0xAC3D,
+        0x6383, 0xFC56, 0x5438, 0xCBED, 0x0CF5, 0x9320, 0x3B4E, 0xA49B,
+        0xBD6F, 0x22BA, 0x8AD4, 0x1501, 0xD219, 0x4DCC, 0xE5A2, 0x7A77,
+        0xD64A, 0x499F, 0xE1F1, 0x7E24, 0xB93C, 0x26E9, 0x8E87, 0x1152,
+        0x08A6, 0x9773, 0x3F1D, 0xA0C8, 0x67D0, 0xF805, 0x506B, 0xCFBE,
+        0xC706, 0x58D3, 0xF0BD, 0x6F68, 0xA870, 0x37A5, 0x9FCB, 0x001E,
+        0x19EA, 0x863F, 0x2E51, 0xB184, 0x769C, 0xE949, 0x4127, 0xDEF2,
+        0x72CF, 0xED1A, 0x4574, 0xDAA1, 0x1DB9, 0x826C, 0x2A02, 0xB5D7,
+        0xAC23, 0x33F6, 0x9B98, 0x044D, 0xC355, 0x5C80, 0xF4EE, 0x6B3B,
+        0xA485, 0x3B50, 0x933E, 0x0CEB, 0xCBF3, 0x5426, 0xFC48, 0x639D,
+        0x7A69, 0xE5BC, 0x4DD2, 0xD207, 0x151F, 0x8ACA, 0x22A4, 0xBD71,
+        0x114C, 0x8E99, 0x26F7, 0xB922, 0x7E3A, 0xE1EF, 0x4981, 0xD654,
+        0xCFA0, 0x5075, 0xF81B, 0x67CE, 0xA0D6, 0x3F03, 0x976D, 0x08B8,
+        0x861D, 0x19C8, 0xB1A6, 0x2E73, 0xE96B, 0x76BE, 0xDED0, 0x4105,
+        0x58F1, 0xC724, 0x6F4A, 0xF09F, 0x3787, 0xA852, 0x003C, 0x9FE9,
+        0x33D4, 0xAC01, 0x046F, 0x9BBA, 0x5CA2, 0xC377, 0x6B19, 0xF4CC,
+        0xED38, 0x72ED, 0xDA83, 0x4556, 0x824E, 0x1D9B, 0xB5F5, 0x2A20,
+        0xE59E, 0x7A4B, 0xD225, 0x4DF0, 0x8AE8, 0x153D, 0xBD53, 0x2286,
+        0x3B72, 0xA4A7, 0x0CC9, 0x931C, 0x5404, 0xCBD1, 0x63BF, 0xFC6A,
+        0x5057, 0xCF82, 0x67EC, 0xF839, 0x3F21, 0xA0F4, 0x089A, 0x974F,
+        0x8EBB, 0x116E, 0xB900, 0x26D5, 0xE1CD, 0x7E18, 0xD676, 0x49A3,
+        0x411B, 0xDECE, 0x76A0, 0xE975, 0x2E6D, 0xB1B8, 0x19D6, 0x8603,
+        0x9FF7, 0x0022, 0xA84C, 0x3799, 0xF081, 0x6F54, 0xC73A, 0x58EF,
+        0xF4D2, 0x6B07, 0xC369, 0x5CBC, 0x9BA4, 0x0471, 0xAC1F, 0x33CA,
+        0x2A3E, 0xB5EB, 0x1D85, 0x8250, 0x4548, 0xDA9D, 0x72F3, 0xED26,
+        0x2298, 0xBD4D, 0x1523, 0x8AF6, 0x4DEE, 0xD23B, 0x7A55, 0xE580,
+        0xFC74, 0x63A1, 0xCBCF, 0x541A, 0x9302, 0x0CD7, 0xA4B9, 0x3B6C,
+        0x9751, 0x0884, 0xA0EA, 0x3F3F, 0xF827, 0x67F2, 0xCF9C, 0x5049,
+        0x49BD, 0xD668, 0x7E06, 0xE1D3, 0x26CB, 0xB91E, 0x1170, 0x8EA5
+    },
+    {
+        0x0000, 0x81BF, 0x0B6F, 0x8AD0, 0x16DE, 0x9761, 0x1DB1, 0x9C0E,
+        0x2DBC, 0xAC03, 0x26D3, 0xA76C, 0x3B62, 0xBADD, 0x300D, 0xB1B2,
+        0x5B78, 0xDAC7, 0x5017, 0xD1A8, 0x4DA6, 0xCC19, 0x46C9, 0xC776,
+        0x76C4, 0xF77B, 0x7DAB, 0xFC14, 0x601A, 0xE1A5, 0x6B75, 0xEACA,
+        0xB6F0, 0x374F, 0xBD9F, 0x3C20, 0xA02E, 0x2191, 0xAB41, 0x2AFE,
+        0x9B4C, 0x1AF3, 0x9023, 0x119C, 0x8D92, 0x0C2D, 0x86FD, 0x0742,
+        0xED88, 0x6C37, 0xE6E7, 0x6758, 0xFB56, 0x7AE9, 0xF039, 0x7186,
+        0xC034, 0x418B, 0xCB5B, 0x4AE4, 0xD6EA, 0x5755, 0xDD85, 0x5C3A,
+        0x65F1, 0xE44E, 0x6E9E, 0xEF21, 0x732F, 0xF290, 0x7840, 0xF9FF,
+        0x484D, 0xC9F2, 0x4322, 0xC29D, 0x5E93, 0xDF2C, 0x55FC, 0xD443,
+        0x3E89, 0xBF36, 0x35E6, 0xB459, 0x2857, 0xA9E8, 0x2338, 0xA287,
+        0x1335, 0x928A, 0x185A, 0x99E5, 0x05EB, 0x8454, 0x0E84, 0x8F3B,
+        0xD301, 0x52BE, 0xD86E, 0x59D1, 0xC5DF, 0x4460, 0xCEB0, 0x4F0F,
+        0xFEBD, 0x7F02, 0xF5D2, 0x746D, 0xE863, 0x69DC, 0xE30C, 0x62B3,
+        0x8879, 0x09C6, 0x8316, 0x02A9, 0x9EA7, 0x1F18, 0x95C8, 0x1477,
+        0xA5C5, 0x247A, 0xAEAA, 0x2F15, 0xB31B, 0x32A4, 0xB874, 0x39CB,
+        0xCBE2, 0x4A5D, 0xC08D, 0x4132, 0xDD3C, 0x5C83, 0xD653, 0x57EC,
+        0xE65E, 0x67E1, 0xED31, 0x6C8E, 0xF080, 0x713F, 0xFBEF, 0x7A50,
+        0x909A, 0x1125, 0x9BF5, 0x1A4A, 0x8644, 0x07FB, 0x8D2B, 0x0C94,
+        0xBD26, 0x3C99, 0xB649, 0x37F6, 0xABF8, 0x2A47, 0xA097, 0x2128,
+        0x7D12, 0xFCAD, 0x767D, 0xF7C2, 0x6BCC, 0xEA73, 0x60A3, 0xE11C,
+        0x50AE, 0xD111, 0x5BC1, 0xDA7E, 0x4670, 0xC7CF, 0x4D1F, 0xCCA0,
+        0x266A, 0xA7D5, 0x2D05, 0xACBA, 0x30B4, 0xB10B, 0x3BDB, 0xBA64,
+        0x0BD6, 0x8A69, 0x00B9, 0x8106, 0x1D08, 0x9CB7, 0x1667, 0x97D8,
+        0xAE13, 0x2FAC, 0xA57C, 0x24C3, 0xB8CD, 0x3972, 0xB3A2, 0x321D,
+        0x83AF, 0x0210, 0x88C0, 0x097F, 0x9571, 0x14CE, 0x9E1E, 0x1FA1,
+        0xF56B, 0x74D4, 0xFE04, 0x7FBB, 0xE3B5, 0x620A, 0xE8DA, 0x6965,
+        0xD8D7, 0x5968, 0xD3B8, 0x5207, 0xCE09, 0x4FB6, 0xC566, 0x44D9,
+        0x18E3, 0x995C, 0x138C, 0x9233, 0x0E3D, 0x8F82, 0x0552, 0x84ED,
+        0x355F, 0xB4E0, 0x3E30, 0xBF8F, 0x2381, 0xA23E, 0x28EE, 0xA951,
+        0x439B, 0xC224, 0x48F4, 0xC94B, 0x5545, 0xD4FA, 0x5E2A, 0xDF95,
+        0x6E27, 0xEF98, 0x6548, 0xE4F7, 0x78F9, 0xF946, 0x7396, 0xF229
     }
-    crc_table_init = true;
-}
+#endif
+};
 
-void reset_table(void) {
-    memset(crc_table, 0, sizeof(crc_table));
-    crc_table_init = false;
-    current_crc_type = CRC_NONE;
-}
+// poly 0xC6C6, reflected
+static const uint16_t crc16_table_legic[CRC16_SLICES][256] = {
+    {
+        0x0000, 0x0B11, 0x1622, 0x1D33, 0x2C44, 0x2755, 0x3A66, 0x3177,
+        0x5888, 0x5399, 0x4EAA, 0x45BB, 0x74CC, 0x7FDD, 0x62EE, 0x69FF,
+        0x77D7, 0x7CC6, 0x61F5, 0x6AE4, 0x5B93, 0x5082, 0x4DB1, 0x46A0,
+        0x2F5F, 0x244E, 0x397D, 0x326C, 0x031B, 0x080A, 0x1539, 0x1E28,
+        0x2969, 0x2278, 0x3F4B, 0x345A, 0x052D, 0x0E3C, 0x130F, 0x181E,
+        0x71E1, 0x7AF0, 0x67C3, 0x6CD2, 0x5DA5, 0x56B4, 0x4B87, 0x4096,
+        0x5EBE, 0x55AF, 0x489C, 0x438D, 0x72FA, 0x79EB, 0x64D8, 0x6FC9,
+        0x0636, 0x0D27, 0x1014, 0x1B05, 0x2A72, 0x2163, 0x3C50, 0x3741,
+        0x52D2, 0x59C3, 0x44F0, 0x4FE1, 0x7E96, 0x7587, 0x68B4, 0x63A5,
+        0x0A5A, 0x014B, 0x1C78, 0x1769, 0x261E, 0x2D0F, 0x303C, 0x3B2D,
+        0x2505, 0x2E14, 0x3327, 0x3836, 0x0941, 0x0250, 0x1F63, 0x1472,
+        0x7D8D, 0x769C, 0x6BAF, 0x60BE, 0x51C9, 0x5AD8, 0x47EB, 0x4CFA,
+        0x7BBB, 0x70AA, 0x6D99, 0x6688, 0x57FF, 0x5CEE, 0x41DD, 0x4ACC,
+        0x2333, 0x2822, 0x3511, 0x3E00, 0x0F77, 0x0466, 0x1955, 0x1244,
+        0x0C6C, 0x077D, 0x1A4E, 0x115F, 0x2028, 0x2B39, 0x360A, 0x3D1B,
+        0x54E4, 0x5FF5, 0x42C6, 0x49D7, 0x78A0, 0x73B1, 0x6E82, 0x6593,
+        0x6363, 0x6872, 0x7541, 0x7E50, 0x4F27, 0x4436, 0x5905, 0x5214,
+        0x3BEB, 0x30FA, 0x2DC9, 0x26D8, 0x17AF, 0x1CBE, 0x018D, 0x0A9C,
+        0x14B4, 0x1FA5, 0x0296, 0x0987, 0x38F0, 0x33E1, 0x2ED2, 0x25C3,
+        0x4C3C, 0x472D, 0x5A1E, 0x510F, 0x6078, 0x6B69, 0x765A, 0x7D4B,
+        0x4A0A, 0x411B, 0x5C28, 0x5739, 0x664E, 0x6D5F, 0x706C, 0x7B7D,
+        0x1282, 0x1993, 0x04A0, 0x0FB1, 0x3EC6, 0x35D7, 0x28E4, 0x23F5,
+        0x3DDD, 0x36CC, 0x2BFF, 0x20EE, 0x1199, 0x1A88, 0x07BB, 0x0CAA,
+        0x6555, 0x6E44, 0x7377, 0x7866, 0x4911, 0x4200, 0x5F33, 0x5422,
+        0x31B1, 0x3AA0, 0x2793, 0x2C82, 0x1DF5, 0x16E4, 0x0BD7, 0x00C6,
+        0x6939, 0x6228, 0x7F1B, 0x740A, 0x457D, 0x4E6C, 0x535F, 0x584E,
+        0x4666, 0x4D77, 0x5044, 0x5B55, 0x6A22, 0x6133, 0x7C00, 0x7711,
+        0x1EEE, 0x15FF, 0x08CC, 0x03DD, 0x32AA, 0x39BB, 0x2488, 0x2F99,
+        0x18D8, 0x13C9, 0x0EFA, 0x05EB, 0x349C, 0x3F8D, 0x22BE, 0x29AF,
+        0x4050, 0x4B41, 0x5672, 0x5D63, 0x6C14, 0x6705, 0x7A36, 0x7127,
+        0x6F0F, 0x641E, 0x792D, 0x723C, 0x434B, 0x485A, 0x5569, 0x5E78,
+        0x3787, 0x3C96, 0x21A5, 0x2AB4, 0x1BC3, 0x10D2, 0x0DE1, 0x06F0
+    },
+#if CRC16_SLICES == 8
+    {
+        0x0000, 0x7CCD, 0x3F5D, 0x4390, 0x7EBA, 0x0277, 0x41E7, 0x3D2A,
+        0x3BB3, 0x477E, 0x04EE, 0x7823, 0x4509, 0x39C4, 0x7A54, 0x0699,
+        0x7766, 0x0BAB, 0x483B, 0x34F6, 0x09DC, 0x7511, 0x3681, 0x4A4C,
+        0x4CD5, 0x3018, 0x7388, 0x0F45, 0x326F, 0x4EA2, 0x0D32, 0x71FF,
+        0x280B, 0x54C6, 0x1756, 0x6B9B, 0x56B1, 0x2A7C, 0x69EC, 0x1521,
+        0x13B8, 0x6F75, 0x2CE5, 0x5028, 0x6D02, 0x11CF, 0x525F, 0x2E92,
+        0x5F6D, 0x23A0, 0x6030, 0x1CFD, 0x21D7, 0x5D1A, 0x1E8A, 0x6247,
+        0x64DE, 0x1813, 0x5B83, 0x274E, 0x1A64, 0x66A9, 0x2539, 0x59F4,
+        0x5016, 0x2CDB, 0x6F4B, 0x1386, 0x2EAC, 0x5261, 0x11F1, 0x6D3C,
+        0x6BA5, 0x1768, 0x54F8, 0x2835, 0x151F, 0x69D2, 0x2A42, 0x568F,
+        0x2770, 0x5BBD, 0x182D, 0x64E0, 0x59CA, 0x2507, 0x6697, 0x1A5A,
+        0x1CC3, 0x600E, 0x239E, 0x5F53, 0x6279, 0x1EB4, 0x5D24, 0x21E9,
+        0x781D, 0x04D0, 0x4740, 0x3B8D, 0x06A7, 0x7A6A, 0x39FA, 0x4537,
+        0x43AE, 0x3F63, 0x7CF3, 0x003E, 0x3D14, 0x41D9, 0x0249, 0x7E84,
+        0x0F7B, 0x73B6, 0x3026, 0x4CEB, 0x71C1, 0x0D0C, 0x4E9C, 0x3251,
+        0x34C8, 0x4805, 0x0B95, 0x7758, 0x4A72, 0x36BF, 0x752F, 0x09E2,
+        0x66EB, 0x1A26, 0x59B6, 0x257B, 0x1851, 0x649C, 0x270C, 0x5BC1,
+        0x5D58, 0x2195, 0x6205, 0x1EC8, 0x23E2, 0x5F2F, 0x1CBF, 0x6072,
+        0x118D, 0x6D40, 0x2ED0, 0x521D, 0x6F37, 0x13FA, 0x506A, 0x2CA7,
+        0x2A3E, 0x56F3, 0x1563, 0x69AE, 0x5484, 0x2849, 0x6BD9, 0x1714,
+        0x4EE0, 0x322D, 0x71BD, 0x0D70, 0x305A, 0x4C97, 0x0F07, 0x73CA,
+        0x7553, 0x099E, 0x4A0E, 0x36C3, 0x0BE9, 0x7724, 0x34B4, 0x4879,
+        0x3986, 0x454B, 0x06DB, 0x7A16, 0x473C, 0x3BF1, 0x7861, 0x04AC,
+        0x0235, 0x7EF8, 0x3D68, 0x41A5, 0x7C8F, 0x0042, 0x43D2, 0x3F1F,
+        0x36FD, 0x4A30, 0x09A0, 0x756D, 0x4847, 0x348A, 0x771A, 0x0BD7,
+        0x0D4E, 0x7183, 0x3213, 0x4EDE, 0x73F4, 0x0F39, 0x4CA9, 0x3064,
+        0x419B, 0x3D56, 0x7EC6, 0x020B, 0x3F21, 0x43EC, 0x007C, 0x7CB1,
+        0x7A28, 0x06E5, 0x4575, 0x39B8, 0x0492, 0x785F, 0x3BCF, 0x4702,
+        0x1EF6, 0x623B, 0x21AB, 0x5D66, 0x604C, 0x1C81, 0x5F11, 0x23DC,
+        0x2545, 0x5988, 0x1A18, 0x66D5, 0x5BFF, 0x2732, 0x64A2, 0x186F,
+        0x6990, 0x155D, 0x56CD, 0x2A00, 0x172A, 0x6BE7, 0x2877, 0x54BA,
+        0x5223, 0x2EEE, 0x6D7E, 0x11B3, 0x2C99, 0x5054, 0x13C4, 0x6F09
+    },
+    {
+        0x0000, 0x4E10, 0x5AE7, 0x14F7, 0x7309, 0x3D19, 0x29EE, 0x67FE,
+        0x20D5, 0x6EC5, 0x7A32, 0x3422, 0x53DC, 0x1DCC, 0x093B, 0x472B,
+        0x41AA, 0x0FBA, 0x1B4D, 0x555D, 0x32A3, 0x7CB3, 0x6844, 0x2654,
+        0x617F, 0x2F6F, 0x3B98, 0x7588, 0x1276, 0x5C66, 0x4891, 0x0681,
+        0x4593, 0x0B83, 0x1F74, 0x5164, 0x369A, 0x788A, 0x6C7D, 0x226D,
+        0x6546, 0x2B56, 0x3FA1, 0x71B1, 0x164F, 0x585F, 0x4CA8, 0x02B8,
+        0x0439, 0x4A29, 0x5EDE, 0x10CE, 0x7730, 0x3920, 0x2DD7, 0x63C7,
+        0x24EC, 0x6AFC, 0x7E0B, 0x301B, 0x57E5, 0x19F5, 0x0D02, 0x4312,
+        0x4DE1, 0x03F1, 0x1706, 0x5916, 0x3EE8, 0x70F8, 0x640F, 0x2A1F,
+        0x6D34, 0x2324, 0x37D3, 0x79C3, 0x1E3D, 0x502D, 0x44DA, 0x0ACA,
+        0x0C4B, 0x425B, 0x56AC, 0x18BC, 0x7F42, 0x3152, 0x25A5, 0x6BB5,
+        0x2C9E, 0x628E, 0x7679, 0x3869, 0x5F97, 0x1187, 0x0570, 0x4B60,
+        0x0872, 0x4662, 0x5295, 0x1C85, 0x7B7B, 0x356B, 0x219C, 0x6F8C,
+        0x28A7, 0x66B7, 0x7240, 0x3C50, 0x5BAE, 0x15BE, 0x0149, 0x4F59,
+        0x49D8, 0x07C8, 0x133F, 0x5D2F, 0x3AD1, 0x74C1, 0x6036, 0x2E26,
+        0x690D, 0x271D, 0x33EA, 0x7DFA, 0x1A04, 0x5414, 0x40E3, 0x0EF3,
+        0x5D05, 0x1315, 0x07E2, 0x49F2, 0x2E0C, 0x601C, 0x74EB, 0x3AFB,
+        0x7DD0, 0x33C0, 0x2737, 0x6927, 0x0ED9, 0x40C9, 0x543E, 0x1A2E,
+        0x1CAF, 0x52BF, 0x4648, 0x0858, 0x6FA6, 0x21B6, 0x3541, 0x7B51,
+        0x3C7A, 0x726A, 0x669D, 0x288D, 0x4F73, 0x0163, 0x1594, 0x5B84,
+        0x1896, 0x5686, 0x4271, 0x0C61, 0x6B9F, 0x258F, 0x3178, 0x7F68,
+        0x3843, 0x7653, 0x62A4, 0x2CB4, 0x4B4A, 0x055A, 0x11AD, 0x5FBD,
+        0x593C, 0x172C, 0x03DB, 0x4DCB, 0x2A35, 0x6425, 0x70D2, 0x3EC2,
+        0x79E9, 0x37F9, 0x230E, 0x6D1E, 0x0AE0, 0x44F0, 0x5007, 0x1E17,
+        0x10E4, 0x5EF4, 0x4A03, 0x0413, 0x63ED, 0x2DFD, 0x390A, 0x771A,
+        0x3031, 0x7E21, 0x6AD6, 0x24C6, 0x4338, 0x0D28, 0x19DF, 0x57CF,
+        0x514E, 0x1F5E, 0x0BA9, 0x45B9, 0x2247, 0x6C57, 0x78A0, 0x36B0,
+        0x719B, 0x3F8B, 0x2B7C, 0x656C, 0x0292, 0x4C82, 0x5875, 0x1665,
+        0x5577, 0x1B67, 0x0F90, 0x4180, 0x267E, 0x686E, 0x7C99, 0x3289,
+        0x75A2, 0x3BB2, 0x2F45, 0x6155, 0x06AB, 0x48BB, 0x5C4C, 0x125C,
+        0x14DD, 0x5ACD, 0x4E3A, 0x002A, 0x67D4, 0x29C4, 0x3D33, 0x7323,
+        0x3408, 0x7A18, 0x6EEF, 0x20FF, 0x4701, 0x0911, 0x1DE6, 0x53F6
+    },
+    {
+        0x0000, 0x7799, 0x29F5, 0x5E6C, 0x53EA, 0x2473, 0x7A1F, 0x0D86,
+        0x6113, 0x168A, 0x48E6, 0x3F7F, 0x32F9, 0x4560, 0x1B0C, 0x6C95,
+        0x04E1, 0x7378, 0x2D14, 0x5A8D, 0x570B, 0x2092, 0x7EFE, 0x0967,
+        0x65F2, 0x126B, 0x4C07, 0x3B9E, 0x3618, 0x4181, 0x1FED, 0x6874,
+        0x09C2, 0x7E5B, 0x2037, 0x57AE, 0x5A28, 0x2DB1, 0x73DD, 0x0444,
+        0x68D1, 0x1F48, 0x4124, 0x36BD, 0x3B3B, 0x4CA2, 0x12CE, 0x6557,
+        0x0D23, 0x7ABA, 0x24D6, 0x534F, 0x5EC9, 0x2950, 0x773C, 0x00A5,
+        0x6C30, 0x1BA9, 0x45C5, 0x325C, 0x3FDA, 0x4843, 0x162F, 0x61B6,
+        0x1384, 0x641D, 0x3A71, 0x4DE8, 0x406E, 0x37F7, 0x699B, 0x1E02,
+        0x7297, 0x050E, 0x5B62, 0x2CFB, 0x217D, 0x56E4, 0x0888, 0x7F11,
+        0x1765, 0x60FC, 0x3E90, 0x4909, 0x448F, 0x3316, 0x6D7A, 0x1AE3,
+        0x7676, 0x01EF, 0x5F83, 0x281A, 0x259C, 0x5205, 0x0C69, 0x7BF0,
+        0x1A46, 0x6DDF, 0x33B3, 0x442A, 0x49AC, 0x3E35, 0x6059, 0x17C0,
+        0x7B55, 0x0CCC, 0x52A0, 0x2539, 0x28BF, 0x5F26, 0x014A, 0x76D3,
+        0x1EA7, 0x693E, 0x3752, 0x40CB, 0x4D4D, 0x3AD4, 0x64B8, 0x1321,
+        0x7FB4, 0x082D, 0x5641, 0x21D8, 0x2C5E, 0x5BC7, 0x05AB, 0x7232,
+        0x2708, 0x5091, 0x0EFD, 0x7964, 0x74E2, 0x037B, 0x5D17, 0x2A8E,
+        0x461B, 0x3182, 0x6FEE, 0x1877, 0x15F1, 0x6268, 0x3C04, 0x4B9D,
+        0x23E9, 0x5470, 0x0A1C, 0x7D85, 0x7003, 0x079A, 0x59F6, 0x2E6F,
+        0x42FA, 0x3563, 0x6B0F, 0x1C96, 0x1110, 0x6689, 0x38E5, 0x4F7C,
+        0x2ECA, 0x5953, 0x073F, 0x70A6, 0x7D20, 0x0AB9, 0x54D5, 0x234C,
+        0x4FD9, 0x3840, 0x662C, 0x11B5, 0x1C33, 0x6BAA, 0x35C6, 0x425F,
+        0x2A2B, 0x5DB2, 0x03DE, 0x7447, 0x79C1, 0x0E58, 0x5034, 0x27AD,
+        0x4B38, 0x3CA1, 0x62CD, 0x1554, 0x18D2, 0x6F4B, 0x3127, 0x46BE,
+        0x348C, 0x4315, 0x1D79, 0x6AE0, 0x6766, 0x10FF, 0x4E93, 0x390A,
+        0x559F, 0x2206, 0x7C6A, 0x0BF3, 0x0675, 0x71EC, 0x2F80, 0x5819,
+        0x306D, 0x47F4, 0x1998, 0x6E01, 0x6387, 0x141E, 0x4A72, 0x3DEB,
+        0x517E, 0x26E7, 0x788B, 0x0F12, 0x0294, 0x750D, 0x2B61, 0x5CF8,
+        0x3D4E, 0x4AD7, 0x14BB, 0x6322, 0x6EA4, 0x193D, 0x4751, 0x30C8,
+        0x5C5D, 0x2BC4, 0x75A8, 0x0231, 0x0FB7, 0x782E, 0x2642, 0x51DB,
+        0x39AF, 0x4E36, 0x105A, 0x67C3, 0x6A45, 0x1DDC, 0x43B0, 0x3429,
+        0x58BC, 0x2F25, 0x7149, 0x06D0, 0x0B56, 0x7CCF, 0x22A3, 0x553A
+    },
+    {
+        0x0000, 0x475A, 0x4873, 0x0F29, 0x5621, 0x117B, 0x1E52, 0x5908,
+        0x6A85, 0x2DDF, 0x22F6, 0x65AC, 0x3CA4, 0x7BFE, 0x74D7, 0x338D,
+        0x13CD, 0x5497, 0x5BBE, 0x1CE4, 0x45EC, 0x02B6, 0x0D9F, 0x4AC5,
+        0x7948, 0x3E12, 0x313B, 0x7661, 0x2F69, 0x6833, 0x671A, 0x2040,
+        0x279A, 0x60C0, 0x6FE9, 0x28B3, 0x71BB, 0x36E1, 0x39C8, 0x7E92,
+        0x4D1F, 0x0A45, 0x056C, 0x4236, 0x1B3E, 0x5C64, 0x534D, 0x1417,
+        0x3457, 0x730D, 0x7C24, 0x3B7E, 0x6276, 0x252C, 0x2A05, 0x6D5F,
+        0x5ED2, 0x1988, 0x16A1, 0x51FB, 0x08F3, 0x4FA9, 0x4080, 0x07DA,
+        0x4F34, 0x086E, 0x0747, 0x401D, 0x1915, 0x5E4F, 0x5166, 0x163C,
+        0x25B1, 0x62EB, 0x6DC2, 0x2A98, 0x7390, 0x34CA, 0x3BE3, 0x7CB9,
+        0x5CF9, 0x1BA3, 0x148A, 0x53D0, 0x0AD8, 0x4D82, 0x42AB, 0x05F1,
+        0x367C, 0x7126, 0x7E0F, 0x3955, 0x605D, 0x2707, 0x282E, 0x6F74,
+        0x68AE, 0x2FF4, 0x20DD, 0x6787, 0x3E8F, 0x79D5, 0x76FC, 0x31A6,
+        0x022B, 0x4571, 0x4A58, 0x0D02, 0x540A, 0x1350, 0x1C79, 0x5B23,
+        0x7B63, 0x3C39, 0x3310, 0x744A, 0x2D42, 0x6A18, 0x6531, 0x226B,
+        0x11E6, 0x56BC, 0x5995, 0x1ECF, 0x47C7, 0x009D, 0x0FB4, 0x48EE,
+        0x58AF, 0x1FF5, 0x10DC, 0x5786, 0x0E8E, 0x49D4, 0x46FD, 0x01A7,
+        0x322A, 0x7570, 0x7A59, 0x3D03, 0x640B, 0x2351, 0x2C78, 0x6B22,
+        0x4B62, 0x0C38, 0x0311, 0x444B, 0x1D43, 0x5A19, 0x5530, 0x126A,
+        0x21E7, 0x66BD, 0x6994, 0x2ECE, 0x77C6, 0x309C, 0x3FB5, 0x78EF,
+        0x7F35, 0x386F, 0x3746, 0x701C, 0x2914, 0x6E4E, 0x6167, 0x263D,
+        0x15B0, 0x52EA, 0x5DC3, 0x1A99, 0x4391, 0x04CB, 0x0BE2, 0x4CB8,
+        0x6CF8, 0x2BA2, 0x248B, 0x63D1, 0x3AD9, 0x7D83, 0x72AA, 0x35F0,
+        0x067D, 0x4127, 0x4E0E, 0x0954, 0x505C, 0x1706, 0x182F, 0x5F75,
+        0x179B, 0x50C1, 0x5FE8, 0x18B2, 0x41BA, 0x06E0, 0x09C9, 0x4E93,
+        0x7D1E, 0x3A44, 0x356D, 0x7237, 0x2B3F, 0x6C65, 0x634C, 0x2416,
+        0x0456, 0x430C, 0x4C25, 0x0B7F, 0x5277, 0x152D, 0x1A04, 0x5D5E,
+        0x6ED3, 0x2989, 0x26A0, 0x61FA, 0x38F2, 0x7FA8, 0x7081, 0x37DB,
+        0x3001, 0x775B, 0x7872, 0x3F28, 0x6620, 0x217A, 0x2E53, 0x6909,
+        0x5A84, 0x1DDE, 0x12F7, 0x55AD, 0x0CA5, 0x4BFF, 0x44D6, 0x038C,
+        0x23CC, 0x6496, 0x6BBF, 0x2CE5, 0x75ED, 0x32B7, 0x3D9E, 0x7AC4,
+        0x4949, 0x0E13, 0x013A, 0x4660, 0x1F68, 0x5832, 0x571B, 0x1041
+    },
+    {
+        0x0000, 0x6BE8, 0x1117, 0x7AFF, 0x222E, 0x49C6, 0x3339, 0x58D1,
+        0x445C, 0x2FB4, 0x554B, 0x3EA3, 0x6672, 0x0D9A, 0x7765, 0x1C8D,
+        0x4E7F, 0x2597, 0x5F68, 0x3480, 0x6C51, 0x07B9, 0x7D46, 0x16AE,
+        0x0A23, 0x61CB, 0x1B34, 0x70DC, 0x280D, 0x43E5, 0x391A, 0x52F2,
+        0x5A39, 0x31D1, 0x4B2E, 0x20C6, 0x7817, 0x13FF, 0x6900, 0x02E8,
+        0x1E65, 0x758D, 0x0F72, 0x649A, 0x3C4B, 0x57A3, 0x2D5C, 0x46B4,
+        0x1446, 0x7FAE, 0x0551, 0x6EB9, 0x3668, 0x5D80, 0x277F, 0x4C97,
+        0x501A, 0x3BF2, 0x410D, 0x2AE5, 0x7234, 0x19DC, 0x6323, 0x08CB,
+        0x72B5, 0x195D, 0x63A2, 0x084A, 0x509B, 0x3B73, 0x418C, 0x2A64,
+        0x36E9, 0x5D01, 0x27FE, 0x4C16, 0x14C7, 0x7F2F, 0x05D0, 0x6E38,
+        0x3CCA, 0x5722, 0x2DDD, 0x4635, 0x1EE4, 0x750C, 0x0FF3, 0x641B,
+        0x7896, 0x137E, 0x6981, 0x0269, 0x5AB8, 0x3150, 0x4BAF, 0x2047,
+        0x288C, 0x4364, 0x399B, 0x5273, 0x0AA2, 0x614A, 0x1BB5, 0x705D,
+        0x6CD0, 0x0738, 0x7DC7, 0x162F, 0x4EFE, 0x2516, 0x5FE9, 0x3401,
+        0x66F3, 0x0D1B, 0x77E4, 0x1C0C, 0x44DD, 0x2F35, 0x55CA, 0x3E22,
+        0x22AF, 0x4947, 0x33B8, 0x5850, 0x0081, 0x6B69, 0x1196, 0x7A7E,
+        0x23AD, 0x4845, 0x32BA, 0x5952, 0x0183, 0x6A6B, 0x1094, 0x7B7C,
+        0x67F1, 0x0C19, 0x76E6, 0x1D0E, 0x45DF, 0x2E37, 0x54C8, 0x3F20,
+        0x6DD2, 0x063A, 0x7CC5, 0x172D, 0x4FFC, 0x2414, 0x5EEB, 0x3503,
+        0x298E, 0x4266, 0x3899, 0x5371, 0x0BA0, 0x6048, 0x1AB7, 0x715F,
+        0x7994, 0x127C, 0x6883, 0x036B, 0x5BBA, 0x3052, 0x4AAD, 0x2145,
+        0x3DC8, 0x5620, 0x2CDF, 0x4737, 0x1FE6, 0x740E, 0x0EF1, 0x6519,
+        0x37EB, 0x5C03, 0x26FC, 0x4D14, 0x15C5, 0x7E2D, 0x04D2, 0x6F3A,
+        0x73B7, 0x185F, 0x62A0, 0x0948, 0x5199, 0x3A71, 0x408E, 0x2B66,
+        0x5118, 0x3AF0, 0x400F, 0x2BE7, 0x7336, 0x18DE, 0x6221, 0x09C9,
+        0x1544, 0x7EAC, 0x0453, 0x6FBB, 0x376A, 0x5C82, 0x267D, 0x4D95,
+        0x1F67, 0x748F, 0x0E70, 0x6598, 0x3D49, 0x56A1, 0x2C5E, 0x47B6,
+        0x5B3B, 0x30D3, 0x4A2C, 0x21C4, 0x7915, 0x12FD, 0x6802, 0x03EA,
+        0x0B21, 0x60C9, 0x1A36, 0x71DE, 0x290F, 0x42E7, 0x3818, 0x53F0,
+        0x4F7D, 0x2495, 0x5E6A, 0x3582, 0x6D53, 0x06BB, 0x7C44, 0x17AC,
+        0x455E, 0x2EB6, 0x5449, 0x3FA1, 0x6770, 0x0C98, 0x7667, 0x1D8F,
+        0x0102, 0x6AEA, 0x1015, 0x7BFD, 0x232C, 0x48C4, 0x323B, 0x59D3
+    },
+    {
+        0x0000, 0x403B, 0x46B1, 0x068A, 0x4BA5, 0x0B9E, 0x0D14, 0x4D2F,
+        0x518D, 0x11B6, 0x173C, 0x5707, 0x1A28, 0x5A13, 0x5C99, 0x1CA2,
+        0x65DD, 0x25E6, 0x236C, 0x6357, 0x2E78, 0x6E43, 0x68C9, 0x28F2,
+        0x3450, 0x746B, 0x72E1, 0x32DA, 0x7FF5, 0x3FCE, 0x3944, 0x797F,
+        0x0D7D, 0x4D46, 0x4BCC, 0x0BF7, 0x46D8, 0x06E3, 0x0069, 0x4052,
+        0x5CF0, 0x1CCB, 0x1A41, 0x5A7A, 0x1755, 0x576E, 0x51E4, 0x11DF,
+        0x68A0, 0x289B, 0x2E11, 0x6E2A, 0x2305, 0x633E, 0x65B4, 0x258F,
+        0x392D, 0x7916, 0x7F9C, 0x3FA7, 0x7288, 0x32B3, 0x3439, 0x7402,
+        0x1AFA, 0x5AC1, 0x5C4B, 0x1C70, 0x515F, 0x1164, 0x17EE, 0x57D5,
+        0x4B77, 0x0B4C, 0x0DC6, 0x4DFD, 0x00D2, 0x40E9, 0x4663, 0x0658,
+        0x7F27, 0x3F1C, 0x3996, 0x79AD, 0x3482, 0x74B9, 0x7233, 0x3208,
+        0x2EAA, 0x6E91, 0x681B, 0x2820, 0x650F, 0x2534, 0x23BE, 0x6385,
+        0x1787, 0x57BC, 0x5136, 0x110D, 0x5C22, 0x1C19, 0x1A93, 0x5AA8,
+        0x460A, 0x0631, 0x00BB, 0x4080, 0x0DAF, 0x4D94, 0x4B1E, 0x0B25,
+        0x725A, 0x3261, 0x34EB, 0x74D0, 0x39FF, 0x79C4, 0x7F4E, 0x3F75,
+        0x23D7, 0x63EC, 0x6566, 0x255D, 0x6872, 0x2849, 0x2EC3, 0x6EF8,
+        0x35F4, 0x75CF, 0x7345, 0x337E, 0x7E51, 0x3E6A, 0x38E0, 0x78DB,
+        0x6479, 0x2442, 0x22C8, 0x62F3, 0x2FDC, 0x6FE7, 0x696D, 0x2956,
+        0x5029, 0x1012, 0x1698, 0x56A3, 0x1B8C, 0x5BB7, 0x5D3D, 0x1D06,
+        0x01A4, 0x419F, 0x4715, 0x072E, 0x4A01, 0x0A3A, 0x0CB0, 0x4C8B,
+        0x3889, 0x78B2, 0x7E38, 0x3E03, 0x732C, 0x3317, 0x359D, 0x75A6,
+        0x6904, 0x293F, 0x2FB5, 0x6F8E, 0x22A1, 0x629A, 0x6410, 0x242B,
+        0x5D54, 0x1D6F, 0x1BE5, 0x5BDE, 0x16F1, 0x56CA, 0x5040, 0x107B,
+        0x0CD9, 0x4CE2, 0x4A68, 0x0A53, 0x477C, 0x0747, 0x01CD, 0x41F6,
+        0x2F0E, 0x6F35, 0x69BF, 0x2984, 0x64AB, 0x2490, 0x221A, 0x6221,
+        0x7E83, 0x3EB8, 0x3832, 0x7809, 0x3526, 0x751D, 0x7397, 0x33AC,
+        0x4AD3, 0x0AE8, 0x0C62, 0x4C59, 0x0176, 0x414D, 0x47C7, 0x07FC,
+        0x1B5E, 0x5B65, 0x5DEF, 0x1DD4, 0x50FB, 0x10C0, 0x164A, 0x5671,
+        0x2273, 0x6248, 0x64C2, 0x24F9, 0x69D6, 0x29ED, 0x2F67, 0x6F5C,
+        0x73FE, 0x33C5, 0x354F, 0x7574, 0x385B, 0x7860, 0x7EEA, 0x3ED1,
+        0x47AE, 0x0795, 0x011F, 0x4124, 0x0C0B, 0x4C30, 0x4ABA, 0x0A81,
+        0x1623, 0x5618, 0x5092, 0x10A9, 0x5D86, 0x1DBD, 0x1B37, 0x5B0C
+    },
+    {
+        0x0000, 0x1B45, 0x368A, 0x2DCF, 0x6D14, 0x7651, 0x5B9E, 0x40DB,
+        0x1CEF, 0x07AA, 0x2A65, 0x3120, 0x71FB, 0x6ABE, 0x4771, 0x5C34,
+        0x39DE, 0x229B, 0x0F54, 0x1411, 0x54CA, 0x4F8F, 0x6240, 0x7905,
+        0x2531, 0x3E74, 0x13BB, 0x08FE, 0x4825, 0x5360, 0x7EAF, 0x65EA,
+        0x73BC, 0x68F9, 0x4536, 0x5E73, 0x1EA8, 0x05ED, 0x2822, 0x3367,
+        0x6F53, 0x7416, 0x59D9, 0x429C, 0x0247, 0x1902, 0x34CD, 0x2F88,
+        0x4A62, 0x5127, 0x7CE8, 0x67AD, 0x2776, 0x3C33, 0x11FC, 0x0AB9,
+        0x568D, 0x4DC8, 0x6007, 0x7B42, 0x3B99, 0x20DC, 0x0D13, 0x1656,
+        0x21BF, 0x3AFA, 0x1735, 0x0C70, 0x4CAB, 0x57EE, 0x7A21, 0x6164,
+        0x3D50, 0x2615, 0x0BDA, 0x109F, 0x5044, 0x4B01, 0x66CE, 0x7D8B,
+        0x1861, 0x0324, 0x2EEB, 0x35AE, 0x7575, 0x6E30, 0x43FF, 0x58BA,
+        0x048E, 0x1FCB, 0x3204, 0x2941, 0x699A, 0x72DF, 0x5F10, 0x4455,
+        0x5203, 0x4946, 0x6489, 0x7FCC, 0x3F17, 0x2452, 0x099D, 0x12D8,
+        0x4EEC, 0x55A9, 0x7866, 0x6323, 0x23F8, 0x38BD, 0x1572, 0x0E37,
+        0x6BDD, 0x7098, 0x5D57, 0x4612, 0x06C9, 0x1D8C, 0x3043, 0x2B06,
+        0x7732, 0x6C77, 0x41B8, 0x5AFD, 0x1A26, 0x0163, 0x2CAC, 0x37E9,
+        0x437E, 0x583B, 0x75F4, 0x6EB1, 0x2E6A, 0x352F, 0x18E0, 0x03A5,
+        0x5F91, 0x44D4, 0x691B, 0x725E, 0x3285, 0x29C0, 0x040F, 0x1F4A,
+        0x7AA0, 0x61E5, 0x4C2A, 0x576F, 0x17B4, 0x0CF1, 0x213E, 0x3A7B,
+        0x664F, 0x7D0A, 0x50C5, 0x4B80, 0x0B5B, 0x101E, 0x3DD1, 0x2694,
+        0x30C2, 0x2B87, 0x0648, 0x1D0D, 0x5DD6, 0x4693, 0x6B5C, 0x7019,
+        0x2C2D, 0x3768, 0x1AA7, 0x01E2, 0x4139, 0x5A7C, 0x77B3, 0x6CF6,
+        0x091C, 0x1259, 0x3F96, 0x24D3, 0x6408, 0x7F4D, 0x5282, 0x49C7,
+        0x15F3, 0x0EB6, 0x2379, 0x383C, 0x78E7, 0x63A2, 0x4E6D, 0x5528,
+        0x62C1, 0x7984, 0x544B, 0x4F0E, 0x0FD5, 0x1490, 0x395F, 0x221A,
+        0x7E2E, 0x656B, 0x48A4, 0x53E1, 0x133A, 0x087F, 0x25B0, 0x3EF5,
+        0x5B1F, 0x405A, 0x6D95, 0x76D0, 0x360B, 0x2D4E, 0x0081, 0x1BC4,
+        0x47F0, 0x5CB5, 0x717A, 0x6A3F, 0x2AE4, 0x31A1, 0x1C6E, 0x072B,
+        0x117D, 0x0A38, 0x27F7, 0x3CB2, 0x7C69, 0x672C, 0x4AE3, 0x51A6,
+        0x0D92, 0x16D7, 0x3B18, 0x205D, 0x6086, 0x7BC3, 0x560C, 0x4D49,
+        0x28A3, 0x33E6, 0x1E29, 0x056C, 0x45B7, 0x5EF2, 0x733D, 0x6878,
+        0x344C, 0x2F09, 0x02C6, 0x1983, 0x5958, 0x421D, 0x6FD2, 0x7497
+    }
+#endif
+};
 
-// table lookup LUT solution
-uint16_t crc16_fast(uint8_t const *d, size_t n, uint16_t initval, bool refin, bool refout) {
+static uint16_t crc16_run(const uint16_t (*t)[256], uint8_t const *d, size_t n, uint16_t initval, bool refin, bool refout) {
 
     // fast lookup table algorithm without augmented zero bytes, e.g. used in pkzip.
     // only usable with polynom orders of 8, 16, 24 or 32.
@@ -99,13 +862,26 @@ uint16_t crc16_fast(uint8_t const *d, size_t n, uint16_t initval, bool refin, bo
 
     uint16_t crc = initval;
 
-    if (refin)
+    if (refin) {
         crc = reflect16(crc);
-
-    if (!refin)
-        while (n--) crc = (crc << 8) ^ crc_table[((crc >> 8) ^ *d++) & 0xFF ];
-    else
-        while (n--) crc = (crc >> 8) ^ crc_table[(crc & 0xFF) ^ *d++];
+#if CRC16_SLICES == 8
+        for (; n >= 8; n -= 8, d += 8) {
+            crc ^= d[0] | (d[1] << 8);
+            crc = t[7][crc & 0xFF] ^ t[6][crc >> 8] ^ t[5][d[2]] ^ t[4][d[3]]
+                  ^ t[3][d[4]] ^ t[2][d[5]] ^ t[1][d[6]] ^ t[0][d[7]];
+        }
+#endif
+        while (n--) crc = (crc >> 8) ^ t[0][(crc & 0xFF) ^ *d++];
+    } else {
+#if CRC16_SLICES == 8
+        for (; n >= 8; n -= 8, d += 8) {
+            crc ^= (d[0] << 8) | d[1];
+            crc = t[7][crc >> 8] ^ t[6][crc & 0xFF] ^ t[5][d[2]] ^ t[4][d[3]]
+                  ^ t[3][d[4]] ^ t[2][d[5]] ^ t[1][d[6]] ^ t[0][d[7]];
+        }
+#endif
+        while (n--) crc = (crc << 8) ^ t[0][((crc >> 8) ^ *d++) & 0xFF];
+    }
 
     if (refout ^ refin)
         crc = reflect16(crc);
@@ -113,6 +889,11 @@ uint16_t crc16_fast(uint8_t const *d, size_t n, uint16_t initval, bool refin, bo
     return crc;
 }
 
+// table lookup LUT solution, poly 0x1021
+uint16_t crc16_fast(uint8_t const *d, size_t n, uint16_t initval, bool refin, bool refout) {
+    return crc16_run(refin ? crc16_table_ccitt_refl : crc16_table_ccitt, d, n, initval, refin, refout);
+}
+
 // bit looped solution  TODO REMOVED
 uint16_t update_crc16_ex(uint16_t crc, uint8_t c, uint16_t polynomial) {
     uint16_t tmp = 0;
@@ -165,8 +946,6 @@ void compute_crc(CrcType_t ct, const uint8_t *d, size_t n, uint8_t *first, uint8
     // can't calc a crc on less than 1 byte
     if (n == 0) return;
 
-    init_table(ct);
-
     uint16_t crc = 0;
     switch (ct) {
         case CRC_14443_A:
@@ -206,8 +985,6 @@ uint16_t Crc16ex(CrcType_t ct, const uint8_t *d, size_t n) {
 
     // can't calc a crc on less than 3 byte. (1byte + 2 crc bytes)
     if (n < 3) return 0;
-
-    init_table(ct);
     switch (ct) {
         case CRC_14443_A:
             return crc16_a(d, n);
@@ -250,8 +1027,6 @@ bool check_crc(CrcType_t ct, const uint8_t *d, size_t n) {
     // can't calc a crc on less than 3 byte. (1byte + 2 crc bytes)
     if (n < 3) return false;
 
-    init_table(ct);
-
     switch (ct) {
         case CRC_14443_A:
             return (crc16_a(d, n) == 0);
@@ -331,6 +1106,6 @@ uint16_t crc16_iclass(uint8_t const *d, size_t n) {
 // poly=0xB400,  init=depends  refin=true  refout=true  xorout=0x0000  check=  name="CRC-16/LEGIC"
 uint16_t crc16_legic(uint8_t const *d, size_t n, uint8_t uidcrc) {
     uint16_t initial = uidcrc << 8 | uidcrc;
-    return crc16_fast(d, n, initial, true, true);
+    return crc16_run(crc16_table_legic, d, n, initial, true, true);
 }
 
@@ -38,9 +38,9 @@
 
 #include "lfdemod.h"
 #include <string.h>  // for memset, memcmp and size_t
-#include <stdlib.h>  // qsort
 #include "parity.h"  // for parity test
 #include "pm3_cmd.h" // error codes
+#include "commonutil.h"  // ARRAYLEN
 // **********************************************************************************************
 // ---------------------------------Utilities Section--------------------------------------------
 // **********************************************************************************************
@@ -50,17 +50,21 @@
 //to allow debug print calls when used not on dev
 
 #ifndef ON_DEVICE
+#include <stdlib.h>
 #include "ui.h"
 #include "util.h"
 # include "cmddata.h"
+# include "demodctx.h"
 # define prnt(args...) PrintAndLogEx(DEBUG, ## args );
+// signal properties are part of the demod context of the calling thread
+# define signalprop (demod_ctx()->sigprop)
 #else
 # include "dbprint.h"
 uint8_t g_debugMode = 0;
 # define prnt Dbprintf
+signal_t signalprop = { 255, -255, 0, 0, true };
 #endif
 
-signal_t signalprop = { 255, -255, 0, 0, true };
 signal_t *getSignalProperties(void) {
     return &signalprop;
 }
@@ -84,11 +88,35 @@ static void printSignal(void) {
 }
 
 #ifndef ON_DEVICE
-static int cmp_uint8(const void *a, const void *b) {
-    if (*(const uint8_t *)a < * (const uint8_t *)b)
-        return -1;
-    else
-        return *(const uint8_t *)a > *(const uint8_t *)b;
+// histogram of the sample values. Four tables, so runs of equal samples
+// don't wait on the same counter
+static void sampleHistogram(const uint8_t *samples, uint32_t size, uint32_t *hist) {
+    uint32_t h[4][256];
+    memset(h, 0, sizeof(h));
+
+    uint32_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        h[0][samples[i]]++;
+        h[1][samples[i + 1]]++;
+        h[2][samples[i + 2]]++;
+        h[3][samples[i + 3]]++;
+    }
+    for (; i < size; i++)
+        h[0][samples[i]]++;
+
+    for (uint16_t v = 0; v < 256; v++)
+        hist[v] = h[0][v] + h[1][v] + h[2][v] + h[3][v];
+}
+
+// the sample at index idx, if the samples were sorted
+static uint8_t histogramAt(const uint32_t *hist, uint32_t idx) {
+    uint32_t cnt = 0;
+    for (uint16_t v = 0; v < 256; v++) {
+        cnt += hist[v];
+        if (cnt > idx)
+            return v;
+    }
+    return 255;
 }
 #endif
 
@@ -101,23 +129,25 @@ void computeSignalProperties(uint8_t *samples, uint32_t size) {
     uint32_t offset_size = size - SIGNAL_IGNORE_FIRST_SAMPLES;
 
 #ifndef ON_DEVICE
-    uint8_t tmp[offset_size];
-    memcpy(tmp, samples + SIGNAL_IGNORE_FIRST_SAMPLES, sizeof(tmp));
-    qsort(tmp, sizeof(tmp), sizeof(uint8_t), cmp_uint8);
+    uint32_t hist[256];
+    sampleHistogram(samples + SIGNAL_IGNORE_FIRST_SAMPLES, offset_size, hist);
 
-    uint8_t low10 = 0.5 * (tmp[(int)(offset_size * 0.1)] + tmp[(int)((offset_size - 1) * 0.1)]);
-    uint8_t hi90 =  0.5 * (tmp[(int)(offset_size * 0.9)] + tmp[(int)((offset_size - 1) * 0.9)]);
+    uint8_t low10 = 0.5 * (histogramAt(hist, (int)(offset_size * 0.1)) + histogramAt(hist, (int)((offset_size - 1) * 0.1)));
+    uint8_t hi90 =  0.5 * (histogramAt(hist, (int)(offset_size * 0.9)) + histogramAt(hist, (int)((offset_size - 1) * 0.9)));
     uint32_t cnt = 0;
-    for (uint32_t i = SIGNAL_IGNORE_FIRST_SAMPLES; i < size; i++) {
+    for (uint16_t v = 0; v < 256; v++) {
 
-        if (samples[i] < signalprop.low) signalprop.low = samples[i];
-        if (samples[i] > signalprop.high) signalprop.high = samples[i];
+        if (hist[v] == 0)
+            continue;
 
-        if (samples[i] < low10 || samples[i] > hi90)
+        if (v < signalprop.low) signalprop.low = v;
+        if (v > signalprop.high) signalprop.high = v;
+
+        if (v < low10 || v > hi90)
             continue;
 
-        sum += samples[i];
-        cnt++;
+        sum += v * hist[v];
+        cnt += hist[v];
     }
     if (cnt > 0)
         signalprop.mean = sum / cnt;
@@ -149,21 +179,15 @@ void removeSignalOffset(uint8_t *samples, uint32_t size) {
     uint32_t offset_size = size - SIGNAL_IGNORE_FIRST_SAMPLES;
 
 #ifndef ON_DEVICE
+    uint32_t hist[256];
+    sampleHistogram(samples + SIGNAL_IGNORE_FIRST_SAMPLES, offset_size, hist);
 
-    uint8_t tmp[offset_size];
-    memcpy(tmp, samples + SIGNAL_IGNORE_FIRST_SAMPLES, sizeof(tmp));
-    qsort(tmp, sizeof(tmp), sizeof(uint8_t), cmp_uint8);
-
-    uint8_t low10 = 0.5 * (tmp[(int)(offset_size * 0.05)] + tmp[(int)((offset_size - 1) * 0.05)]);
-    uint8_t hi90 =  0.5 * (tmp[(int)(offset_size * 0.95)] + tmp[(int)((offset_size - 1) * 0.95)]);
+    uint8_t low10 = 0.5 * (histogramAt(hist, (int)(offset_size * 0.05)) + histogramAt(hist, (int)((offset_size - 1) * 0.05)));
+    uint8_t hi90 =  0.5 * (histogramAt(hist, (int)(offset_size * 0.95)) + histogramAt(hist, (int)((offset_size - 1) * 0.95)));
     int32_t cnt = 0;
-    for (uint32_t i = SIGNAL_IGNORE_FIRST_SAMPLES; i < size; i++) {
-
-        if (samples[i] < low10 || samples[i] > hi90)
-            continue;
-
-        acc_off += samples[i] - 128;
-        cnt++;
+    for (uint16_t v = low10; v <= hi90; v++) {
+        acc_off += ((int)v - 128) * (int)hist[v];
+        cnt += hist[v];
     }
     if (cnt > 0)
         acc_off /= cnt;
@@ -347,31 +371,6 @@ bool preambleSearchEx(uint8_t *bits, uint8_t *preamble, size_t pLen, size_t *siz
 }
 
 // find start of modulating data (for fsk and psk) in case of beginning noise or slow chip startup.
-static size_t findModStart(uint8_t *src, size_t size, uint8_t expWaveSize) {
-    size_t i = 0;
-    size_t waveSizeCnt = 0;
-    uint8_t thresholdCnt = 0;
-    bool isAboveThreshold = src[i++] >= signalprop.mean; //FSK_PSK_THRESHOLD;
-    for (; i < size - 20; i++) {
-        if (src[i] < signalprop.mean && isAboveThreshold) {
-            thresholdCnt++;
-            if (thresholdCnt > 2 && waveSizeCnt < expWaveSize + 1) break;
-            isAboveThreshold = false;
-            waveSizeCnt = 0;
-        } else if (src[i] >= signalprop.mean && !isAboveThreshold) {
-            thresholdCnt++;
-            if (thresholdCnt > 2 && waveSizeCnt < expWaveSize + 1) break;
-            isAboveThreshold = true;
-            waveSizeCnt = 0;
-        } else {
-            waveSizeCnt++;
-        }
-        if (thresholdCnt > 10) break;
-    }
-    if (g_debugMode == 2) prnt("DEBUG: threshold Count reached at index %zu, count: %u", i, thresholdCnt);
-    return i;
-}
-
 static int getClosestClock(int testclk) {
     uint16_t clocks[] = {8, 16, 32, 40, 50, 64, 100, 128, 256, 384};
     uint8_t limit[]  = {1,  2,  4,  4,  5,  8,   8,   8,   8,   8};
@@ -384,17 +383,334 @@ static int getClosestClock(int testclk) {
 }
 
 void getNextLow(uint8_t *samples, size_t size, int low, size_t *i) {
-    while ((samples[*i] > low) && (*i < size))
+    while ((*i < size) && (samples[*i] > low))
         *i += 1;
 }
 
 void getNextHigh(uint8_t *samples, size_t size, int high, size_t *i) {
-    while ((samples[*i] < high) && (*i < size))
+    while ((*i < size) && (samples[*i] < high))
         *i += 1;
 }
 
+// start positions DetectASKClock tries per clock before it sets up the running error count
+#define ASK_CLK_DIRECT_STARTS 8
+
+#ifndef ON_DEVICE
+static bool lfWavesReserve(lf_waves_t *waves, size_t size) {
+    if (size <= waves->cap)
+        return true;
+
+    uint32_t **lists[] = {
+        &waves->tops, &waves->cross,
+        &waves->level[0].hi, &waves->level[0].lo,
+        &waves->level[1].hi, &waves->level[1].lo,
+    };
+    for (uint8_t i = 0; i < ARRAYLEN(lists); i++) {
+        // a run list holds a start and an end per run, at most size + 1 of them
+        uint32_t *tmp = realloc(*lists[i], (size + 1) * sizeof(uint32_t));
+        if (tmp == NULL)
+            return false;
+        *lists[i] = tmp;
+    }
+    for (uint8_t i = 0; i < ARRAYLEN(waves->level); i++) {
+        uint8_t *tmp = realloc(waves->level[i].peak, size);
+        if (tmp == NULL)
+            return false;
+        waves->level[i].peak = tmp;
+    }
+    waves->cap = size;
+    return true;
+}
+
+static void lfLevelBuild(lf_level_t *level, const uint8_t *samples, size_t size, uint8_t fuzz) {
+    getHiLo(&level->high, &level->low, fuzz, fuzz);
+
+    size_t nhi = 0, nlo = 0;
+    bool inhi = false, inlo = false;
+    for (size_t i = 0; i < size; i++) {
+        bool hi = (samples[i] >= level->high);
+        bool lo = (samples[i] <= level->low);
+        level->peak[i] = hi | lo;
+        if (hi != inhi) {
+            level->hi[nhi++] = i;
+            inhi = hi;
+        }
+        if (lo != inlo) {
+            level->lo[nlo++] = i;
+            inlo = lo;
+        }
+    }
+    if (inhi)
+        level->hi[nhi++] = size;
+    if (inlo)
+        level->lo[nlo++] = size;
+
+    level->nhi = nhi / 2;
+    level->nlo = nlo / 2;
+}
+
+// one walk over the samples for all the detectors, against the current signal properties
+bool lfWavesBuild(lf_waves_t *waves, const uint8_t *samples, size_t size) {
+    waves->size = 0;
+    if (samples == NULL || size < 3 || lfWavesReserve(waves, size) == false)
+        return false;
+
+    size_t n = 0;
+    for (size_t i = 1; i < size - 1; i++) {
+        waves->tops[n] = i;
+        n += (samples[i - 1] < samples[i]) & (samples[i] >= samples[i + 1]);
+    }
+    waves->ntops = n;
+
+    waves->mean = signalprop.mean;
+    bool above = (samples[0] >= waves->mean);
+    n = 0;
+    for (size_t i = 1; i < size; i++) {
+        if ((samples[i] >= waves->mean) != above) {
+            above = !above;
+            if (n == 0)
+                waves->cross_up = above;
+            waves->cross[n++] = i;
+        }
+    }
+    waves->ncross = n;
+
+    lfLevelBuild(&waves->level[LF_LEVEL_ASK_CLOCK], samples, size, 75);
+    lfLevelBuild(&waves->level[LF_LEVEL_WAVES], samples, size, 80);
+
+    waves->clocks.valid = false;
+    waves->size = size;
+    return true;
+}
+
+void lfWavesFree(lf_waves_t *waves) {
+    free(waves->tops);
+    free(waves->cross);
+    for (uint8_t i = 0; i < ARRAYLEN(waves->level); i++) {
+        free(waves->level[i].peak);
+        free(waves->level[i].hi);
+        free(waves->level[i].lo);
+    }
+    memset(waves, 0, sizeof(lf_waves_t));
+}
+
+static uint32_t *lfAllocSums(size_t size) {
+    return calloc(size, sizeof(uint32_t));
+}
+
+static void lfFreeSums(uint32_t *sums) {
+    free(sums);
+}
+#else
+// no heap to spare on the device, the detectors take the direct way
+static uint32_t *lfAllocSums(size_t size) {
+    (void)size;
+    return NULL;
+}
+
+static void lfFreeSums(uint32_t *sums) {
+    (void)sums;
+}
+#endif
+
+// the level of the waves built for these thresholds, NULL when there is none
+static const lf_level_t *wavesLevel(const lf_waves_t *waves, size_t size, int high, int low) {
+    if (waves == NULL || waves->size != size)
+        return NULL;
+
+    for (uint8_t i = 0; i < ARRAYLEN(waves->level); i++) {
+        if (waves->level[i].high == high && waves->level[i].low == low)
+            return &waves->level[i];
+    }
+    return NULL;
+}
+
+// the clock detector answers for these samples and signal properties, NULL when there are none
+static const lf_clocks_t *wavesClocks(const lf_waves_t *waves, size_t size) {
+    if (waves == NULL || waves->size != size || waves->clocks.valid == false || g_debugMode == 2)
+        return NULL;
+
+    const signal_t *s = &waves->clocks.signal;
+    if (s->high != signalprop.high || s->low != signalprop.low || s->mean != signalprop.mean ||
+            s->amplitude != signalprop.amplitude || s->isnoise != signalprop.isnoise)
+        return NULL;
+
+    return &waves->clocks;
+}
+
+// first sample of the runs at or after *i, size when there is none before
+static void nextRun(const uint32_t *runs, size_t nruns, size_t size, size_t *i) {
+    if (*i >= size)
+        return;
+
+    // first run that ends after *i
+    size_t a = 0, b = nruns;
+    while (a < b) {
+        size_t m = (a + b) / 2;
+        if (runs[2 * m + 1] <= *i)
+            a = m + 1;
+        else
+            b = m;
+    }
+    if (a < nruns && runs[2 * a] > *i)
+        *i = runs[2 * a];
+    else if (a == nruns)
+        *i = size;
+    if (*i > size)
+        *i = size;
+}
+
+static void nextHigh(uint8_t *samples, size_t size, int high, size_t *i, const lf_level_t *level) {
+    if (level)
+        nextRun(level->hi, level->nhi, size, i);
+    else
+        getNextHigh(samples, size, high, i);
+}
+
+static void nextLow(uint8_t *samples, size_t size, int low, size_t *i, const lf_level_t *level) {
+    if (level)
+        nextRun(level->lo, level->nlo, size, i);
+    else
+        getNextLow(samples, size, low, i);
+}
+
+static bool isPeak(const uint8_t *samples, size_t i, int high, int low, const lf_level_t *level) {
+    if (level)
+        return level->peak[i];
+    return (samples[i] >= high || samples[i] <= low);
+}
+
+// walks the wave tops in [from, to), from the waves or over the samples. from >= 1
+typedef struct {
+    const uint8_t *samples;
+    const uint32_t *tops;
+    size_t ntops;
+    size_t i;
+    size_t to;
+} top_walk_t;
+
+static void topWalk(top_walk_t *t, const uint8_t *samples, size_t size, const lf_waves_t *waves, size_t from, size_t to) {
+    t->samples = samples;
+    t->tops = NULL;
+    t->ntops = 0;
+    t->i = from;
+    t->to = to;
+    if (waves == NULL || waves->size != size)
+        return;
+
+    t->tops = waves->tops;
+    t->ntops = waves->ntops;
+    // i indexes the top list from here on
+    size_t a = 0, b = t->ntops;
+    while (a < b) {
+        size_t m = (a + b) / 2;
+        if (t->tops[m] < from)
+            a = m + 1;
+        else
+            b = m;
+    }
+    t->i = a;
+}
+
+static bool topNext(top_walk_t *t, size_t *top) {
+    if (t->tops) {
+        if (t->i == t->ntops || t->tops[t->i] >= t->to)
+            return false;
+        *top = t->tops[t->i++];
+        return true;
+    }
+    for (; t->i < t->to; t->i++) {
+        if (t->samples[t->i - 1] < t->samples[t->i] && t->samples[t->i] >= t->samples[t->i + 1]) {
+            *top = t->i++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// walks the crossings of the signal mean in [from, to), from the waves or over the samples. from >= 1
+typedef struct {
+    const uint8_t *samples;
+    const uint32_t *cross;
+    size_t ncross;
+    size_t i;
+    size_t to;
+    bool above;             // the last sample walked, or the direction of the next crossing listed
+} cross_walk_t;
+
+static void crossWalk(cross_walk_t *c, const uint8_t *samples, size_t size, const lf_waves_t *waves, size_t from, size_t to) {
+    c->samples = samples;
+    c->cross = NULL;
+    c->ncross = 0;
+    c->i = from;
+    c->to = to;
+    if (waves == NULL || waves->size != size || waves->mean != signalprop.mean) {
+        c->above = (samples[from - 1] >= signalprop.mean);
+        return;
+    }
+
+    c->cross = waves->cross;
+    c->ncross = waves->ncross;
+    size_t a = 0, b = c->ncross;
+    while (a < b) {
+        size_t m = (a + b) / 2;
+        if (c->cross[m] < from)
+            a = m + 1;
+        else
+            b = m;
+    }
+    c->i = a;
+    c->above = (a % 2 == 0) ? waves->cross_up : !waves->cross_up;
+}
+
+// *up tells if the samples go at or above the mean there
+static bool crossNext(cross_walk_t *c, size_t *pos, bool *up) {
+    if (c->cross) {
+        if (c->i == c->ncross || c->cross[c->i] >= c->to)
+            return false;
+        *pos = c->cross[c->i++];
+        *up = c->above;
+        c->above = !c->above;
+        return true;
+    }
+    for (; c->i < c->to; c->i++) {
+        bool above = (c->samples[c->i] >= signalprop.mean);
+        if (above != c->above) {
+            c->above = above;
+            *pos = c->i++;
+            *up = above;
+            return true;
+        }
+    }
+    return false;
+}
+
+// find start of modulating data (for fsk and psk) in case of beginning noise or slow chip startup.
+static size_t findModStart(uint8_t *src, size_t size, uint8_t expWaveSize, const lf_waves_t *waves) {
+    size_t i = size - 20;
+    size_t lastCross = 0;
+    uint8_t thresholdCnt = 0;
+
+    cross_walk_t cross;
+    crossWalk(&cross, src, size, waves, 1, size - 20);
+    size_t pos;
+    bool up;
+    while (crossNext(&cross, &pos, &up)) {
+        thresholdCnt++;
+        // samples since the last crossing
+        size_t waveSizeCnt = pos - lastCross - 1;
+        lastCross = pos;
+        if ((thresholdCnt > 2 && waveSizeCnt < expWaveSize + 1) || thresholdCnt > 10) {
+            i = pos;
+            break;
+        }
+    }
+    if (g_debugMode == 2) prnt("DEBUG: threshold Count reached at index %zu, count: %u", i, thresholdCnt);
+    return i;
+}
+
 // load wave counters
-bool loadWaveCounters(uint8_t *samples, size_t size, int lowToLowWaveLen[], int highToLowWaveLen[], int *waveCnt, int *skip, int *minClk, int *high, int *low) {
+bool loadWaveCounters(uint8_t *samples, size_t size, int lowToLowWaveLen[], int highToLowWaveLen[], int *waveCnt, int *skip, int *minClk, int *high, int *low, const lf_waves_t *waves) {
     size_t i = 0;
     //size_t testsize = (size < 512) ? size : 512;
 
@@ -405,10 +721,11 @@ bool loadWaveCounters(uint8_t *samples, size_t size, int lowToLowWaveLen[], int
     }
 
     getHiLo(high, low, 80, 80);
+    const lf_level_t *level = wavesLevel(waves, size, *high, *low);
 
     // get to first full low to prime loop and skip incomplete first pulse
-    getNextHigh(samples, size, *high, &i);
-    getNextLow(samples, size, *low, &i);
+    nextHigh(samples, size, *high, &i, level);
+    nextLow(samples, size, *low, &i, level);
     *skip = i;
 
     // populate tmpbuff buffer with pulse lengths
@@ -416,10 +733,10 @@ bool loadWaveCounters(uint8_t *samples, size_t size, int lowToLowWaveLen[], int
         // measure from low to low
         size_t firstLow = i;
         //find first high point for this wave
-        getNextHigh(samples, size, *high, &i);
+        nextHigh(samples, size, *high, &i, level);
         size_t firstHigh = i;
 
-        getNextLow(samples, size, *low, &i);
+        nextLow(samples, size, *low, &i, level);
 
         if (*waveCnt >= (size / LOWEST_DEFAULT_CLOCK))
             break;
@@ -553,14 +870,14 @@ bool DetectCleanAskWave(uint8_t *dest, size_t size, uint8_t high, uint8_t low) {
 // by marshmellow
 // to help detect clocks on heavily clipped samples
 // based on count of low to low
-int DetectStrongAskClock(uint8_t *dest, size_t size, int high, int low, int *clock) {
+int DetectStrongAskClock(uint8_t *dest, size_t size, int high, int low, int *clock, const lf_level_t *level) {
     size_t i = 100;
     size_t minClk = 512;
     uint16_t shortestWaveIdx = 0;
 
     // get to first full low to prime loop and skip incomplete first pulse
-    getNextHigh(dest, size, high, &i);
-    getNextLow(dest, size, low, &i);
+    nextHigh(dest, size, high, &i, level);
+    nextLow(dest, size, low, &i, level);
 
     if (i == size)
         return -1;
@@ -586,8 +903,8 @@ int DetectStrongAskClock(uint8_t *dest, size_t size, int high, int low, int *clo
         // measure from low to low
         size_t startwave = i;
 
-        getNextHigh(dest, size, high, &i);
-        getNextLow(dest, size, low, &i);
+        nextHigh(dest, size, high, &i, level);
+        nextLow(dest, size, low, &i, level);
 
         //get minimum measured distance
         if (i - startwave < minClk && i < size) {
@@ -637,7 +954,7 @@ int DetectStrongAskClock(uint8_t *dest, size_t size, int high, int low, int *clo
 // not perfect especially with lower clocks or VERY good antennas (heavy wave clipping)
 // maybe somehow adjust peak trimming value based on samples to fix?
 // return start index of best starting position for that clock and return clock (by reference)
-int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr) {
+int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr, const lf_waves_t *waves) {
 
     //don't need to loop through entire array. (cotag has clock of 384)
     uint16_t loopCnt = 2000;
@@ -654,6 +971,12 @@ int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr) {
         return -2;
     }
 
+    const lf_clocks_t *known = wavesClocks(waves, size);
+    if (known && *clock == 0 && maxErr != 0) {
+        *clock = known->ask_clk;
+        return known->ask_start;
+    }
+
     size_t i = 1;
     uint16_t num_clks = 9;
     // first 255 value pos0 is placeholder for user inputed clock.
@@ -674,6 +997,7 @@ int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr) {
     // threshold 75% of high, low peak
     int peak_hi, peak_low;
     getHiLo(&peak_hi, &peak_low, 75, 75);
+    const lf_level_t *level = wavesLevel(waves, size + 60, peak_hi, peak_low);
 
     // test for large clean, STRONG, CLIPPED peaks
 
@@ -681,7 +1005,7 @@ int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr) {
 
         if (DetectCleanAskWave(dest, size, peak_hi, peak_low)) {
 
-            int idx = DetectStrongAskClock(dest, size, peak_hi, peak_low, clock);
+            int idx = DetectStrongAskClock(dest, size, peak_hi, peak_low, clock, level);
             if (g_debugMode == 2)
                 prnt("DEBUG ASK: DetectASKClock Clean ASK Wave detected: clk %i, Best Starting Position: %i", *clock, idx);
 
@@ -709,6 +1033,13 @@ int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr) {
         clkCnt = 1;
     }
 
+    // Errors per start position from a running count along the clock stride,
+    // errSum[k] = (no peak at k - tol, k, k + tol) + errSum[k - clk],
+    // so a start position costs two lookups instead of a walk over the samples.
+    // Only built from the peak mask of the waves, once a clock has tried a few
+    // start positions the direct way.
+    uint32_t *errSum = NULL;
+
     //test each valid clock from smallest to greatest to see which lines up
     for (; clkCnt < num_clks; clkCnt++) {
         if (clk[clkCnt] <= 32) {
@@ -725,20 +1056,40 @@ int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr) {
         //try lining up the peaks by moving starting point (try first few clocks)
 
         // get to first full low to prime loop and skip incomplete first pulse
-        getNextHigh(dest, size, peak_hi, &j);
-        getNextLow(dest, size, peak_low, &j);
+        nextHigh(dest, size, peak_hi, &j, level);
+        nextLow(dest, size, peak_low, &j, level);
 
+        size_t direct = 0;
+        bool summed = false;
         for (; j < loopCnt; j++) {
             errCnt = 0;
             // now that we have the first one lined up test rest of wave array
             loopEnd = ((size - j - tol) / clk[clkCnt]) - 1;
-            for (i = 0; i < loopEnd; ++i) {
-                arrLoc = j + (i * clk[clkCnt]);
-                if (dest[arrLoc] >= peak_hi || dest[arrLoc] <= peak_low) {
-                } else if (dest[arrLoc - tol] >= peak_hi || dest[arrLoc - tol] <= peak_low) {
-                } else if (dest[arrLoc + tol] >= peak_hi || dest[arrLoc + tol] <= peak_low) {
-                } else {  //error no peak detected
-                    errCnt++;
+            if (level && summed == false && direct++ == ASK_CLK_DIRECT_STARTS) {
+                if (errSum == NULL)
+                    errSum = lfAllocSums(size);
+                if (errSum) {
+                    for (size_t k = 0; k < size; k++) {
+                        uint8_t miss = (k >= tol && k + tol < size) ? !(level->peak[k] | level->peak[k - tol] | level->peak[k + tol]) : 0;
+                        errSum[k] = miss + ((k >= clk[clkCnt]) ? errSum[k - clk[clkCnt]] : 0);
+                    }
+                    summed = true;
+                }
+            }
+            if (summed && loopEnd < size) {
+                if (loopEnd) {
+                    size_t last = j + (loopEnd - 1) * clk[clkCnt];
+                    errCnt = errSum[last] - ((j >= clk[clkCnt]) ? errSum[j - clk[clkCnt]] : 0);
+                }
+            } else {
+                for (i = 0; i < loopEnd; ++i) {
+                    arrLoc = j + (i * clk[clkCnt]);
+                    if (isPeak(dest, arrLoc, peak_hi, peak_low, level)) {
+                    } else if (isPeak(dest, arrLoc - tol, peak_hi, peak_low, level)) {
+                    } else if (isPeak(dest, arrLoc + tol, peak_hi, peak_low, level)) {
+                    } else {  //error no peak detected
+                        errCnt++;
+                    }
                 }
             }
             // if we found no errors then we can stop here and a low clock (common clocks)
@@ -747,6 +1098,7 @@ int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr) {
             if (errCnt == 0 && clkCnt < 7) {
                 if (!found_clk)
                     *clock = clk[clkCnt];
+                lfFreeSums(errSum);
                 return j;
             }
             // if we found errors see if it is lowest so far and save it as best run
@@ -773,6 +1125,7 @@ int DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr) {
     if (!found_clk)
         *clock = clk[best];
 
+    lfFreeSums(errSum);
     return bestStart[best];
 }
 
@@ -947,61 +1300,46 @@ int DetectNRZClock(uint8_t *dest, size_t size, int clock, size_t *clockStartIdx)
     return clk[best];
 }
 
-//by marshmellow
-//countFC is to detect the field clock lengths.
-//counts and returns the 2 most common wave lengths
-//mainly used for FSK field clock detection
-uint16_t countFC(uint8_t *bits, size_t size, bool fskAdj) {
-    uint8_t fcLens[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    uint16_t fcCnts[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    uint8_t fcLensFnd = 0;
-    uint8_t lastFCcnt = 0;
-    uint8_t fcCounter = 0;
-    size_t i;
-    if (size < 180) return 0;
-
-    // prime i to first up transition
-    for (i = 160; i < size - 20; i++)
-        if (bits[i] > bits[i - 1] && bits[i] >= bits[i + 1])
-            break;
-
-    for (; i < size - 20; i++) {
-        if (bits[i] > bits[i - 1] && bits[i] >= bits[i + 1]) {
-            // new up transition
-            fcCounter++;
-            if (fskAdj) {
-                //if we had 5 and now have 9 then go back to 8 (for when we get a fc 9 instead of an 8)
-                if (lastFCcnt == 5 && fcCounter == 9) fcCounter--;
-
-                //if fc=9 or 4 add one (for when we get a fc 9 instead of 10 or a 4 instead of a 5)
-                if ((fcCounter == 9) || fcCounter == 4) fcCounter++;
-                // save last field clock count  (fc/xx)
-                lastFCcnt = fcCounter;
-            }
-            // find which fcLens to save it to:
-            for (int m = 0; m < 15; m++) {
-                if (fcLens[m] == fcCounter) {
-                    fcCnts[m]++;
-                    fcCounter = 0;
-                    break;
-                }
-            }
-            if (fcCounter > 0 && fcLensFnd < 15) {
-                //add new fc length
-                fcCnts[fcLensFnd]++;
-                fcLens[fcLensFnd++] = fcCounter;
-            }
+typedef struct {
+    uint8_t lens[15];
+    uint16_t cnts[15];
+    uint8_t found;
+    uint8_t last;
+} fc_count_t;
+
+// one wave of fcCounter samples, top to top
+static void countFCwave(fc_count_t *fc, uint8_t fcCounter, bool fskAdj) {
+    if (fskAdj) {
+        //if we had 5 and now have 9 then go back to 8 (for when we get a fc 9 instead of an 8)
+        if (fc->last == 5 && fcCounter == 9) fcCounter--;
+
+        //if fc=9 or 4 add one (for when we get a fc 9 instead of 10 or a 4 instead of a 5)
+        if ((fcCounter == 9) || fcCounter == 4) fcCounter++;
+        // save last field clock count  (fc/xx)
+        fc->last = fcCounter;
+    }
+    // find which fcLens to save it to:
+    for (int m = 0; m < 15; m++) {
+        if (fc->lens[m] == fcCounter) {
+            fc->cnts[m]++;
             fcCounter = 0;
-        } else {
-            // count sample
-            fcCounter++;
+            break;
         }
     }
+    if (fcCounter > 0 && fc->found < 15) {
+        //add new fc length
+        fc->cnts[fc->found]++;
+        fc->lens[fc->found++] = fcCounter;
+    }
+}
 
+static uint16_t countFCbest(fc_count_t *fc, size_t size, bool fskAdj) {
+    uint8_t *fcLens = fc->lens;
+    uint16_t *fcCnts = fc->cnts;
     uint8_t best1 = 14, best2 = 14, best3 = 14;
     uint16_t maxCnt1 = 0;
     // go through fclens and find which ones are bigest 2
-    for (i = 0; i < 15; i++) {
+    for (size_t i = 0; i < 15; i++) {
         // get the 3 best FC values
         if (fcCnts[i] > maxCnt1) {
             best3 = best2;
@@ -1038,10 +1376,41 @@ uint16_t countFC(uint8_t *bits, size_t size, bool fskAdj) {
     return (uint16_t)fcLens[best2] << 8 | fcLens[best1];
 }
 
+//by marshmellow
+//countFC is to detect the field clock lengths.
+//counts and returns the 2 most common wave lengths
+//mainly used for FSK field clock detection
+uint16_t countFC(uint8_t *bits, size_t size, bool fskAdj, const lf_waves_t *waves) {
+    if (size < 180) return 0;
+
+    const lf_clocks_t *known = wavesClocks(waves, size);
+    if (known) return known->fcs[fskAdj];
+
+    fc_count_t fc;
+    memset(&fc, 0, sizeof(fc));
+
+    top_walk_t tops;
+    topWalk(&tops, bits, size, waves, 160, size - 20);
+
+    // the first up transition counts as a wave of one sample
+    size_t top, prev = 0;
+    bool first = true;
+    while (topNext(&tops, &top)) {
+        if (first) {
+            prev = top - 1;
+            first = false;
+        }
+        // new up transition
+        countFCwave(&fc, (uint8_t)(top - prev), fskAdj);
+        prev = top;
+    }
+    return countFCbest(&fc, size, fskAdj);
+}
+
 //by marshmellow
 //detect psk clock by reading each phase shift
 // a phase shift is determined by measuring the sample length of each wave
-int DetectPSKClock(uint8_t *dest, size_t size, int clock, size_t *firstPhaseShift, uint8_t *curPhase, uint8_t *fc) {
+int DetectPSKClock(uint8_t *dest, size_t size, int clock, size_t *firstPhaseShift, uint8_t *curPhase, uint8_t *fc, const lf_waves_t *waves) {
     uint8_t clk[] = {255, 16, 32, 40, 50, 64, 100, 128, 255}; //255 is not a valid clock
     uint16_t loopCnt = 4096;  //don't need to loop through entire array...
 
@@ -1049,15 +1418,22 @@ int DetectPSKClock(uint8_t *dest, size_t size, int clock, size_t *firstPhaseShif
     // size must be larger than 20 here, and 160 later on.
     if (size < loopCnt) loopCnt = size - 20;
 
-    uint16_t fcs = countFC(dest, size, 0);
+    const lf_clocks_t *known = wavesClocks(waves, size);
+    if (known) {
+        *fc = known->psk_fc;
+        *curPhase ^= known->psk_flip;
+        if (known->psk_shift != SIZE_MAX)
+            *firstPhaseShift = known->psk_shift;
+        return known->psk_clk;
+    }
+
+    uint16_t fcs = countFC(dest, size, 0, waves);
 
     *fc = fcs & 0xFF;
 
     if (g_debugMode == 2) prnt("DEBUG PSK: FC: %d, FC2: %d", *fc, fcs >> 8);
 
-    if ((fcs >> 8) == 10 && *fc == 8) return 0;
-
-    if (*fc != 2 && *fc != 4 && *fc != 8) return 0;
+    if (((fcs >> 8) == 10 && *fc == 8) || (*fc != 2 && *fc != 4 && *fc != 8)) return 0;
 
 
     size_t waveEnd, firstFullWave = 0;
@@ -1068,7 +1444,7 @@ int DetectPSKClock(uint8_t *dest, size_t size, int clock, size_t *firstPhaseShif
     uint16_t peaksdet[] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
 
     //find start of modulating data in trace
-    size_t i = findModStart(dest, size, *fc);
+    size_t i = findModStart(dest, size, *fc, waves);
 
     firstFullWave = pskFindFirstPhaseShift(dest, size, curPhase, i, *fc, &fullWaveLen);
     if (firstFullWave == 0) {
@@ -1090,30 +1466,33 @@ int DetectPSKClock(uint8_t *dest, size_t size, int clock, size_t *firstPhaseShif
         uint16_t peakcnt = 0;
         if (g_debugMode == 2) prnt("DEBUG PSK: clk: %d, lastClkBit: %zu", clk[clkCnt], lastClkBit);
 
-        for (i = firstFullWave + fullWaveLen - 1; i < loopCnt - 2; i++) {
+        // only the wave tops, i + 1 is the top
+        top_walk_t tops;
+        topWalk(&tops, dest, size, waves, firstFullWave + fullWaveLen, loopCnt - 1);
+        size_t top;
+        while (topNext(&tops, &top)) {
+            i = top - 1;
             //top edge of wave = start of new wave
-            if (dest[i] < dest[i + 1] && dest[i + 1] >= dest[i + 2]) {
-                if (waveStart == 0) {
-                    waveStart = i + 1;
-                } else { //waveEnd
-                    waveEnd = i + 1;
-                    waveLenCnt = waveEnd - waveStart;
-                    if (waveLenCnt > *fc) {
-                        //if this wave is a phase shift
-                        if (g_debugMode == 2) prnt("DEBUG PSK: phase shift at: %zu, len: %d, nextClk: %zu, i: %zu, fc: %d", waveStart, waveLenCnt, lastClkBit + clk[clkCnt] - tol, i + 1, *fc);
-                        if (i + 1 >= lastClkBit + clk[clkCnt] - tol) { //should be a clock bit
-                            peakcnt++;
-                            lastClkBit += clk[clkCnt];
-                        } else if (i < lastClkBit + 8) {
-                            //noise after a phase shift - ignore
-                        } else { //phase shift before supposed to based on clock
-                            errCnt++;
-                        }
-                    } else if (i + 1 > lastClkBit + clk[clkCnt] + tol + *fc) {
-                        lastClkBit += clk[clkCnt]; //no phase shift but clock bit
+            if (waveStart == 0) {
+                waveStart = i + 1;
+            } else { //waveEnd
+                waveEnd = i + 1;
+                waveLenCnt = waveEnd - waveStart;
+                if (waveLenCnt > *fc) {
+                    //if this wave is a phase shift
+                    if (g_debugMode == 2) prnt("DEBUG PSK: phase shift at: %zu, len: %d, nextClk: %zu, i: %zu, fc: %d", waveStart, waveLenCnt, lastClkBit + clk[clkCnt] - tol, i + 1, *fc);
+                    if (i + 1 >= lastClkBit + clk[clkCnt] - tol) { //should be a clock bit
+                        peakcnt++;
+                        lastClkBit += clk[clkCnt];
+                    } else if (i < lastClkBit + 8) {
+                        //noise after a phase shift - ignore
+                    } else { //phase shift before supposed to based on clock
+                        errCnt++;
                     }
-                    waveStart = i + 1;
+                } else if (i + 1 > lastClkBit + clk[clkCnt] + tol + *fc) {
+                    lastClkBit += clk[clkCnt]; //no phase shift but clock bit
                 }
+                waveStart = i + 1;
             }
         }
         if (errCnt == 0) return clk[clkCnt];
@@ -1134,11 +1513,18 @@ int DetectPSKClock(uint8_t *dest, size_t size, int clock, size_t *firstPhaseShif
 
 //by marshmellow
 //detects the bit clock for FSK given the high and low Field Clocks
-uint8_t detectFSKClk(uint8_t *bits, size_t size, uint8_t fcHigh, uint8_t fcLow, int *firstClockEdge) {
+uint8_t detectFSKClk(uint8_t *bits, size_t size, uint8_t fcHigh, uint8_t fcLow, int *firstClockEdge, const lf_waves_t *waves) {
 
     if (size == 0)
         return 0;
 
+    const lf_clocks_t *known = wavesClocks(waves, size);
+    if (known && known->fsk_fc[0] == fcHigh && known->fsk_fc[1] == fcLow) {
+        if (known->fsk_edge >= 0)
+            *firstClockEdge = known->fsk_edge;
+        return known->fsk_clk;
+    }
+
     uint8_t clk[] = {8, 16, 32, 40, 50, 64, 100, 128, 0};
     uint16_t rfLens[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
     uint8_t rfCnts[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
@@ -1150,18 +1536,21 @@ uint8_t detectFSKClk(uint8_t *bits, size_t size, uint8_t fcHigh, uint8_t fcLow,
     size_t i;
     uint8_t fcTol = ((fcHigh * 100 - fcLow * 100) / 2 + 50) / 100; //(uint8_t)(0.5+(float)(fcHigh-fcLow)/2);
 
-    // prime i to first peak / up transition
-    for (i = 160; i < size - 20; i++)
-        if (bits[i] > bits[i - 1] && bits[i] >= bits[i + 1])
-            break;
-
-    for (; i < size - 20; i++) {
-        fcCounter++;
-        rfCounter++;
+    // peaks / up transitions, the first one counts as one sample
+    top_walk_t tops;
+    topWalk(&tops, bits, size, waves, 160, size - 20);
+    size_t lastPeak = 0, rfStart = 0;
+    bool first = true;
+    while (topNext(&tops, &i)) {
+        if (first) {
+            lastPeak = rfStart = i - 1;
+            first = false;
+        }
+        fcCounter = i - lastPeak;
+        rfCounter = i - rfStart;
+        lastPeak = i;
 
-        if (bits[i] <= bits[i - 1] || bits[i] < bits[i + 1])
-            continue;
-        // else new peak
+        // new peak
         // if we got less than the small fc + tolerance then set it to the small fc
         // if it is inbetween set it to the last counter
         if (fcCounter < fcHigh && fcCounter > fcLow)
@@ -1191,10 +1580,9 @@ uint8_t detectFSKClk(uint8_t *bits, size_t size, uint8_t fcHigh, uint8_t fcLow,
                 *firstClockEdge = i;
                 firstBitFnd++;
             }
-            rfCounter = 0;
+            rfStart = i;
             lastFCcnt = fcCounter;
         }
-        fcCounter = 0;
     }
     uint8_t rfHighest = 15, rfHighest2 = 15, rfHighest3 = 15;
 
@@ -1241,6 +1629,33 @@ uint8_t detectFSKClk(uint8_t *bits, size_t size, uint8_t fcHigh, uint8_t fcLow,
     return clk[m];
 }
 
+void lfWavesAnalyse(lf_waves_t *waves, uint8_t *samples, size_t size) {
+    lf_clocks_t *c = &waves->clocks;
+    c->valid = false;
+    if (waves->size != size || size < 180 || g_debugMode == 2)
+        return;
+
+    c->fcs[0] = countFC(samples, size, false, waves);
+    c->fcs[1] = countFC(samples, size, true, waves);
+
+    // the field clocks a FSK demod asks about, its defaults when there are none
+    c->fsk_fc[0] = (c->fcs[1]) ? c->fcs[1] >> 8 : 10;
+    c->fsk_fc[1] = (c->fcs[1]) ? c->fcs[1] & 0xFF : 8;
+    c->fsk_edge = -1;
+    c->fsk_clk = detectFSKClk(samples, size, c->fsk_fc[0], c->fsk_fc[1], &c->fsk_edge, waves);
+
+    c->ask_clk = 0;
+    c->ask_start = DetectASKClock(samples, size, &c->ask_clk, 1, waves);
+
+    c->psk_fc = 0;
+    c->psk_flip = 0;
+    c->psk_shift = SIZE_MAX;
+    c->psk_clk = DetectPSKClock(samples, size, 0, &c->psk_shift, &c->psk_flip, &c->psk_fc, waves);
+
+    c->signal = signalprop;
+    c->valid = true;
+}
+
 
 // **********************************************************************************************
 // --------------------Modulation Demods &/or Decoding Section-----------------------------------
@@ -1268,7 +1683,7 @@ static bool findST(int *stStopLoc, int *stStartIdx, int lowToLowWaveLen[], int h
 }
 //by marshmellow
 //attempt to identify a Sequence Terminator in ASK modulated raw wave
-bool DetectST(uint8_t *buffer, size_t *size, int *foundclock, size_t *ststart, size_t *stend) {
+bool DetectST(uint8_t *buffer, size_t *size, int *foundclock, size_t *ststart, size_t *stend, const lf_waves_t *waves) {
     size_t bufsize = *size;
     //need to loop through all samples and identify our clock, look for the ST pattern
     int clk = 0;
@@ -1284,7 +1699,7 @@ bool DetectST(uint8_t *buffer, size_t *size, int *foundclock, size_t *ststart, s
     memset(tmpbuff, 0, sizeof(tmpbuff));
     memset(waveLen, 0, sizeof(waveLen));
 
-    if (!loadWaveCounters(buffer, bufsize, tmpbuff, waveLen, &j, &skip, &minClk, &high, &low)) return false;
+    if (!loadWaveCounters(buffer, bufsize, tmpbuff, waveLen, &j, &skip, &minClk, &high, &low, waves)) return false;
     // set clock  - might be able to get this externally and remove this work...
     clk = getClosestClock(minClk);
     // clock not found - ERROR
@@ -1617,7 +2032,7 @@ static uint16_t cleanAskRawDemod(uint8_t *bits, size_t *size, int clk, int inver
 
 //by marshmellow
 //attempts to demodulate ask modulations, askType == 0 for ask/raw, askType==1 for ask/manchester
-int askdemod_ext(uint8_t *bits, size_t *size, int *clk, int *invert, int maxErr, uint8_t amp, uint8_t askType, int *startIdx) {
+int askdemod_ext(uint8_t *bits, size_t *size, int *clk, int *invert, int maxErr, uint8_t amp, uint8_t askType, int *startIdx, const lf_waves_t *waves) {
 
     if (*size == 0) return -1;
 
@@ -1626,7 +2041,7 @@ int askdemod_ext(uint8_t *bits, size_t *size, int *clk, int *invert, int maxErr,
         return -2;
     }
 
-    int start = DetectASKClock(bits, *size, clk, maxErr);
+    int start = DetectASKClock(bits, *size, clk, maxErr, waves);
     if (*clk == 0 || start < 0) return -3;
 
     if (*invert != 1) *invert = 0;
@@ -1712,7 +2127,7 @@ int askdemod_ext(uint8_t *bits, size_t *size, int *clk, int *invert, int maxErr,
 
 int askdemod(uint8_t *bits, size_t *size, int *clk, int *invert, int maxErr, uint8_t amp, uint8_t askType) {
     int start = 0;
-    return askdemod_ext(bits, size, clk, invert, maxErr, amp, askType, &start);
+    return askdemod_ext(bits, size, clk, invert, maxErr, amp, askType, &start, NULL);
 }
 
 // by marshmellow - demodulate NRZ wave - requires a read with strong signal
@@ -1760,7 +2175,7 @@ int nrzRawDemod(uint8_t *dest, size_t *size, int *clk, int *invert, int *startId
 }
 
 //translate wave to 11111100000 (1 for each short wave [higher freq] 0 for each long wave [lower freq])
-static size_t fsk_wave_demod(uint8_t *dest, size_t size, uint8_t fchigh, uint8_t fclow, int *startIdx) {
+static size_t fsk_wave_demod(uint8_t *dest, size_t size, uint8_t fchigh, uint8_t fclow, int *startIdx, const lf_waves_t *waves) {
 
     if (size < 1024) return 0;   // not enough samples
 
@@ -1773,12 +2188,9 @@ static size_t fsk_wave_demod(uint8_t *dest, size_t size, uint8_t fchigh, uint8_t
     size_t idx, numBits = 0;
 
     //find start of modulating data in trace
-    idx = findModStart(dest, size, fchigh);
-    // Need to threshold first sample
-    dest[idx] = (dest[idx] < signalprop.mean) ? 0 : 1;
+    idx = findModStart(dest, size, fchigh, waves);
 
     last_transition = idx;
-    idx++;
 
     // Definition:  cycles between consecutive lo-hi transitions
     // Lets define some expected lengths. FSK1 is easier since it has bigger differences between.
@@ -1810,13 +2222,14 @@ static size_t fsk_wave_demod(uint8_t *dest, size_t size, uint8_t fchigh, uint8_t
     // width should be divided with exp_one.  i:e 6+7+6+2=21,  21/5 = 4,
     // the 1-0 to 0-1  width should be divided with exp_zero.   Ie: 3+5+6+7 = 21/6 = 3
 
-    for (; idx < size - 20; idx++) {
-
-        // threshold current value
-        dest[idx] = (dest[idx] < signalprop.mean) ? 0 : 1;
+    // the bits go to dest behind the crossings, the samples ahead are still untouched
+    cross_walk_t cross;
+    crossWalk(&cross, dest, size, waves, idx + 1, size - 20);
+    bool up;
+    while (crossNext(&cross, &idx, &up)) {
 
         // Check for 0->1 transition
-        if (dest[idx - 1] < dest[idx]) {
+        if (up) {
             preLastSample = LastSample;
             LastSample = currSample;
             currSample = idx - last_transition;
@@ -1915,10 +2328,10 @@ static size_t aggregate_bits(uint8_t *dest, size_t size, uint8_t clk, uint8_t in
 
 //by marshmellow  (from holiman's base)
 // full fsk demod from GraphBuffer wave to decoded 1s and 0s (no mandemod)
-size_t fskdemod(uint8_t *dest, size_t size, uint8_t rfLen, uint8_t invert, uint8_t fchigh, uint8_t fclow, int *start_idx) {
+size_t fskdemod(uint8_t *dest, size_t size, uint8_t rfLen, uint8_t invert, uint8_t fchigh, uint8_t fclow, int *start_idx, const lf_waves_t *waves) {
     if (signalprop.isnoise) return 0;
     // FSK demodulator
-    size = fsk_wave_demod(dest, size, fchigh, fclow, start_idx);
+    size = fsk_wave_demod(dest, size, fchigh, fclow, start_idx, waves);
     if (g_debugMode == 2) prnt("DEBUG (fskdemod) got %zu bits", size);
     size = aggregate_bits(dest, size, rfLen, invert, fchigh, fclow, start_idx);
     if (g_debugMode == 2) prnt("DEBUG (fskdemod) got %zu bits", size);
@@ -1960,7 +2373,7 @@ void psk2TOpsk1(uint8_t *bits, size_t size) {
 //by marshmellow - demodulate PSK1 wave
 //uses wave lengths (# Samples)
 //TODO: Iceman - hard coded value 7,  should be #define
-int pskRawDemod_ext(uint8_t *dest, size_t *size, int *clock, int *invert, int *startIdx) {
+int pskRawDemod_ext(uint8_t *dest, size_t *size, int *clock, int *invert, int *startIdx, const lf_waves_t *waves) {
 
     // sanity check
     if (*size < 170) return -1;
@@ -1971,13 +2384,13 @@ int pskRawDemod_ext(uint8_t *dest, size_t *size, int *clock, int *invert, int *s
     uint16_t fullWaveLen = 0, waveLenCnt, avgWaveVal = 0;
     uint16_t errCnt = 0, errCnt2 = 0;
 
-    *clock = DetectPSKClock(dest, *size, *clock, &firstFullWave, &curPhase, &fc);
+    *clock = DetectPSKClock(dest, *size, *clock, &firstFullWave, &curPhase, &fc, waves);
     if (*clock <= 0) return -1;
     //if clock detect found firstfullwave...
     uint16_t tol = fc / 2;
     if (firstFullWave == 0) {
         //find start of modulating data in trace
-        i = findModStart(dest, *size, fc);
+        i = findModStart(dest, *size, fc, waves);
         //find first phase shift
         firstFullWave = pskFindFirstPhaseShift(dest, *size, &curPhase, i, fc, &fullWaveLen);
         if (firstFullWave == 0) {
@@ -2053,7 +2466,585 @@ int pskRawDemod_ext(uint8_t *dest, size_t *size, int *clock, int *invert, int *s
 
 int pskRawDemod(uint8_t *dest, size_t *size, int *clock, int *invert) {
     int start_idx = 0;
-    return pskRawDemod_ext(dest, size, clock, invert, &start_idx);
+    return pskRawDemod_ext(dest, size, clock, invert, &start_idx, NULL);
+}
+
+// **********************************************************************************************
+// -----------------Streaming demods-------------------------------------------------------------
+// **********************************************************************************************
+// The demods above get the whole capture and overwrite it with the bits. These
+// ones follow them step by step, one sample at a time, and keep only what the
+// next step needs. Where a batch demod stops short of the end of the buffer,
+// the streaming one waits for as many samples before it looks at a sample.
+
+static void lf_bits_init(lf_bits_t *o, lf_bits_cb_t cb, void *arg) {
+    o->len = 0;
+    o->total = 0;
+    o->cb = cb;
+    o->arg = arg;
+}
+
+static void lf_bits_flush(lf_bits_t *o) {
+    if (o->len == 0) return;
+    if (o->cb) o->cb(o->buf, o->len, o->arg);
+    o->total += o->len;
+    o->len = 0;
+}
+
+static void lf_bits_put(lf_bits_t *o, uint8_t bit, size_t n) {
+    while (n--) {
+        o->buf[o->len++] = bit;
+        if (o->len == sizeof(o->buf))
+            lf_bits_flush(o);
+    }
+}
+
+static inline size_t lf_bits_count(const lf_bits_t *o) {
+    return o->total + o->len;
+}
+
+// FSK, fsk_wave_demod then aggregate_bits
+
+void fsk_stream_init(fsk_stream_t *s, uint8_t clk, uint8_t invert, uint8_t fchigh, uint8_t fclow, int mean, lf_bits_cb_t cb, void *arg) {
+    s->clk = clk;
+    s->invert = invert;
+    s->fchigh = fchigh;
+    s->fclow = fclow;
+    s->mean = mean;
+    s->received = 0;
+    s->idx = 0;
+    s->modstart = true;
+    s->thresholds = 0;
+    s->wave_size = 0;
+    s->last_transition = 0;
+    s->cur_len = 0;
+    s->last_len = 0;
+    s->waves = 0;
+    s->committed = 0;
+    s->agg_idx = 0;
+    s->run = 0;
+    s->start_idx = 0;
+    lf_bits_init(&s->out, cb, arg);
+}
+
+// same field clock and bit clock detection as `data rawdemod fs`
+int fsk_stream_setup(fsk_stream_t *s, uint8_t *samples, size_t size, uint8_t clk, uint8_t invert, uint8_t fchigh, uint8_t fclow, lf_bits_cb_t cb, void *arg) {
+    if (size == 0) return PM3_EINVARG;
+    if (signalprop.isnoise) return PM3_ESOFT;
+
+    if (!fchigh || !fclow) {
+        uint16_t fcs = countFC(samples, size, true, NULL);
+        if (!fcs) {
+            fchigh = 10;
+            fclow = 8;
+        } else {
+            fchigh = (fcs >> 8) & 0x00FF;
+            fclow = fcs & 0x00FF;
+        }
+    }
+    if (!clk) {
+        int firstClockEdge = 0;
+        clk = detectFSKClk(samples, size, fchigh, fclow, &firstClockEdge, NULL);
+        if (!clk) clk = 50;
+    }
+    fsk_stream_init(s, clk, invert, fchigh, fclow, signalprop.mean, cb, arg);
+    return PM3_SUCCESS;
+}
+
+// aggregate_bits, one wave bit
+static void fsk_stream_aggregate(fsk_stream_t *s, uint8_t bit) {
+    size_t i = s->agg_idx++;
+    if (i == 0) {
+        s->lastval = bit;
+        s->run = 1;
+        s->prev1 = bit;
+        return;
+    }
+
+    s->run++;
+    if (bit != s->lastval) {
+        uint8_t hclk = s->clk / 2;
+        uint32_t n = s->run;
+        if (s->prev1 == 1)
+            n = (n * s->fclow + hclk) / s->clk;
+        else
+            n = (n * s->fchigh + hclk) / s->clk;
+
+        if (n == 0)
+            n = 1;
+
+        if (lf_bits_count(&s->out) == 0) {
+            if (s->lastval == 1)
+                s->start_idx += (s->fclow * i) - (n * s->clk);
+            else
+                s->start_idx += (s->fchigh * i) - (n * s->clk);
+        }
+
+        lf_bits_put(&s->out, s->prev1 ^ s->invert, n);
+        s->run = 0;
+        s->lastval = bit;
+    }
+    s->prev2 = s->prev1;
+    s->prev1 = bit;
+}
+
+// wave bits are final once there are three of them and a later one
+static void fsk_stream_commit(fsk_stream_t *s, bool all) {
+    while (s->committed < s->waves && (all || (s->waves >= 3 && s->committed + 1 < s->waves))) {
+        fsk_stream_aggregate(s, s->pending[s->committed & 3]);
+        s->committed++;
+    }
+}
+
+static void fsk_stream_wave(fsk_stream_t *s, uint8_t bit) {
+    s->pending[s->waves & 3] = bit;
+    s->waves++;
+    fsk_stream_commit(s, false);
+}
+
+static void fsk_stream_sample(fsk_stream_t *s, size_t idx, uint8_t sample) {
+
+    uint8_t fchigh = (s->fchigh) ? s->fchigh : 10;
+    uint8_t fclow = (s->fclow) ? s->fclow : 8;
+
+    // findModStart
+    if (s->modstart) {
+        if (idx == 0) {
+            s->above = sample >= s->mean;
+            return;
+        }
+        bool found = false;
+        if (sample < s->mean && s->above) {
+            s->thresholds++;
+            if (s->thresholds > 2 && s->wave_size < fchigh + 1) found = true;
+            s->above = false;
+            s->wave_size = 0;
+        } else if (sample >= s->mean && !s->above) {
+            s->thresholds++;
+            if (s->thresholds > 2 && s->wave_size < fchigh + 1) found = true;
+            s->above = true;
+            s->wave_size = 0;
+        } else {
+            s->wave_size++;
+        }
+        if (s->thresholds > 10) found = true;
+
+        if (found) {
+            s->modstart = false;
+            s->prev = (sample < s->mean) ? 0 : 1;
+            s->last_transition = idx;
+        }
+        return;
+    }
+
+    uint8_t cur = (sample < s->mean) ? 0 : 1;
+    if (s->prev < cur) {
+        size_t pre_last = s->last_len;
+        s->last_len = s->cur_len;
+        s->cur_len = idx - s->last_transition;
+        if (s->cur_len < (fclow - 2)) {
+            // garbage
+        } else if (s->cur_len < (fchigh - 1)) {
+            // correct previous 9 wave surrounded by 8 waves (or 6 surrounded by 5)
+            if (s->waves > 1 && s->last_len > (fchigh - 2) && (pre_last < (fchigh - 1)))
+                s->pending[(s->waves - 1) & 3] = 1;
+            fsk_stream_wave(s, 1);
+            if (s->start_idx == 0)
+                s->start_idx = idx - fclow;
+        } else if (s->cur_len > (fchigh + 1) && s->waves < 3) {
+            // beginning garbage
+            s->waves = 0;
+        } else if (s->cur_len == (fclow + 1) && s->last_len == (fclow - 1)) {
+            fsk_stream_wave(s, 1);
+            if (s->start_idx == 0)
+                s->start_idx = idx - fclow;
+        } else {
+            fsk_stream_wave(s, 0);
+            if (s->start_idx == 0)
+                s->start_idx = idx - fchigh;
+        }
+        s->last_transition = idx;
+    }
+    s->prev = cur;
+}
+
+void fsk_stream_feed(fsk_stream_t *s, const uint8_t *samples, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        s->ring[s->received % FSK_STREAM_HOLD] = samples[i];
+        s->received++;
+        if (s->received < FSK_STREAM_HOLD)
+            continue;
+
+        while (s->idx + FSK_STREAM_LAG < s->received) {
+            fsk_stream_sample(s, s->idx, s->ring[s->idx % FSK_STREAM_HOLD]);
+            s->idx++;
+        }
+    }
+    lf_bits_flush(&s->out);
+}
+
+void fsk_stream_finish(fsk_stream_t *s) {
+    if (s->received >= FSK_STREAM_HOLD) {
+        fsk_stream_commit(s, true);
+
+        // valid extra bits at the end, all the same frequency
+        if (s->agg_idx >= 2 && s->fchigh && s->run > s->clk / s->fchigh) {
+            uint32_t n = s->run;
+            if (s->prev2 == 1)
+                n = (n * s->fclow + s->clk / 2) / s->clk;
+            else
+                n = (n * s->fchigh + s->clk / 2) / s->clk;
+            lf_bits_put(&s->out, s->prev1 ^ s->invert, n);
+        }
+    }
+    lf_bits_flush(&s->out);
+}
+
+// ASK raw, the clean and the weak wave demod of askdemod_ext
+
+void ask_stream_init(ask_stream_t *s, int clk, int invert, int high, int low, bool clean, int start, uint8_t amp, uint8_t askType, lf_bits_cb_t cb, void *arg) {
+    s->clk = clk;
+    s->invert = (invert == 1) ? 1 : 0;
+    s->high = high;
+    s->low = low;
+    s->clean = clean;
+    s->manchester = (askType != 0);
+    s->amp = (amp == 1);
+    s->amp_last = 128;
+    s->idx = 0;
+    s->seek = true;
+    s->wave_high = true;
+    s->smpl_cnt = 1;
+    s->start = (start > 0) ? start : 0;
+    s->last_bit = start - clk;
+    s->mid_bit = 0;
+    s->tol = (clk <= 32) ? 1 : 0;
+    s->last_out = 0;
+    s->errors = 0;
+    s->start_idx = (clean) ? 0 : start - (clk / 2);
+    lf_bits_init(&s->out, cb, arg);
+}
+
+int ask_stream_setup(ask_stream_t *s, uint8_t *samples, size_t size, int clk, int invert, int maxErr, uint8_t amp, uint8_t askType, lf_bits_cb_t cb, void *arg) {
+    if (size == 0) return PM3_EINVARG;
+    if (signalprop.isnoise) return PM3_ESOFT;
+
+    int start = DetectASKClock(samples, size, &clk, maxErr, NULL);
+    if (clk == 0 || start < 0) return PM3_ESOFT;
+
+    int high, low;
+    getHiLo(&high, &low, 75, 75);
+
+    // the clean wave check looks at the amplified samples, without touching the callers
+    uint8_t head[1024 + 160];
+    size_t n = MIN(size, sizeof(head));
+    memcpy(head, samples, n);
+    if (amp == 1) askAmp(head, n);
+
+    ask_stream_init(s, clk, invert, high, low, DetectCleanAskWave(head, n, high, low), start, amp, askType, cb, arg);
+    return PM3_SUCCESS;
+}
+
+// cleanAskRawDemod
+static void ask_stream_clean(ask_stream_t *s, size_t i, uint8_t sample) {
+    int clk = s->clk;
+    uint8_t cl_4 = clk / 4;
+    uint8_t cl_2 = clk / 2;
+
+    // getNextHigh
+    if (s->seek) {
+        if (sample < s->high)
+            return;
+        s->seek = false;
+        // do not skip first transition
+        if ((i > cl_2 - cl_4 - 1) && (i <= clk + cl_4 + 1))
+            lf_bits_put(&s->out, s->invert ^ 1, 1);
+    }
+
+    if (sample >= s->high && s->wave_high) {
+        s->smpl_cnt++;
+    } else if (sample <= s->low && !s->wave_high) {
+        s->smpl_cnt++;
+    } else if ((sample >= s->high && !s->wave_high) || (sample <= s->low && s->wave_high)) {
+        if (s->smpl_cnt > clk - cl_4 - 1) { //full clock
+            if (s->smpl_cnt > clk + cl_4 + 1) {
+                s->errors++;
+                lf_bits_put(&s->out, 7, 1);
+            } else if (s->wave_high) {
+                lf_bits_put(&s->out, s->invert, 2);
+            } else {
+                lf_bits_put(&s->out, s->invert ^ 1, 2);
+            }
+            if (s->start_idx == 0)
+                s->start_idx = i - clk;
+            s->wave_high = !s->wave_high;
+            s->smpl_cnt = 0;
+        } else if (s->smpl_cnt > cl_2 - cl_4 - 1) { //half clock
+            if (s->smpl_cnt > cl_2 + cl_4 + 1) {
+                s->errors++;
+                lf_bits_put(&s->out, 7, 1);
+            }
+            lf_bits_put(&s->out, (s->wave_high) ? s->invert : s->invert ^ 1, 1);
+            if (s->start_idx == 0)
+                s->start_idx = i - cl_2;
+            s->wave_high = !s->wave_high;
+            s->smpl_cnt = 0;
+        } else {
+            s->smpl_cnt++;
+        }
+    } else {
+        s->smpl_cnt++;
+    }
+}
+
+static void ask_stream_out(ask_stream_t *s, uint8_t bit) {
+    lf_bits_put(&s->out, bit, 1);
+    s->last_out = bit;
+}
+
+// the weak wave part of askdemod_ext
+static void ask_stream_weak(ask_stream_t *s, size_t i, uint8_t sample) {
+    int clk = s->clk;
+    int tol = s->tol;
+
+    if (i < s->start)
+        return;
+
+    if (i - s->last_bit >= clk - tol) {
+        if (sample >= s->high) {
+            ask_stream_out(s, s->invert);
+        } else if (sample <= s->low) {
+            ask_stream_out(s, s->invert ^ 1);
+        } else if (i - s->last_bit >= clk + tol) {
+            if (lf_bits_count(&s->out) > 0) {
+                ask_stream_out(s, 7);
+                s->errors++;
+            }
+        } else { //in tolerance - looking for peak
+            return;
+        }
+        s->mid_bit = 0;
+        s->last_bit += clk;
+    } else if (i - s->last_bit >= (clk / 2 - tol) && !s->mid_bit && !s->manchester) {
+        if (sample >= s->high) {
+            ask_stream_out(s, s->invert);
+        } else if (sample <= s->low) {
+            ask_stream_out(s, s->invert ^ 1);
+        } else if (i - s->last_bit >= clk / 2 + tol) {
+            ask_stream_out(s, s->last_out);
+        } else { //in tolerance - looking for peak
+            return;
+        }
+        s->mid_bit = 1;
+    }
+}
+
+void ask_stream_feed(ask_stream_t *s, const uint8_t *samples, size_t len) {
+    for (size_t n = 0; n < len; n++) {
+        uint8_t sample = samples[n];
+
+        // askAmp
+        if (s->amp) {
+            if (s->idx > 0) {
+                if (sample - s->amp_prev >= 30)
+                    s->amp_last = 255;
+                else if (s->amp_prev - sample >= 20)
+                    s->amp_last = 0;
+                sample = s->amp_last;
+            }
+            s->amp_prev = sample;
+        }
+
+        if (s->clean)
+            ask_stream_clean(s, s->idx, sample);
+        else
+            ask_stream_weak(s, s->idx, sample);
+        s->idx++;
+    }
+    lf_bits_flush(&s->out);
+}
+
+void ask_stream_finish(ask_stream_t *s) {
+    // no high at all, the first transition check runs at the end of the samples
+    if (s->clean && s->seek) {
+        uint8_t cl_4 = s->clk / 4;
+        uint8_t cl_2 = s->clk / 2;
+        if ((s->idx > cl_2 - cl_4 - 1) && (s->idx <= s->clk + cl_4 + 1))
+            lf_bits_put(&s->out, s->invert ^ 1, 1);
+    }
+    lf_bits_flush(&s->out);
+}
+
+// NRZ
+
+void nrz_stream_init(nrz_stream_t *s, int clk, int invert, int high, int low, lf_bits_cb_t cb, void *arg) {
+    s->clk = clk;
+    s->invert = invert;
+    s->high = high;
+    s->low = low;
+    s->received = 0;
+    s->idx = 0;
+    s->bit = 0;
+    s->prev = 0;
+    s->last_bit = 0;
+    s->start_idx = 0;
+    lf_bits_init(&s->out, cb, arg);
+}
+
+int nrz_stream_setup(nrz_stream_t *s, uint8_t *samples, size_t size, int clk, int invert, lf_bits_cb_t cb, void *arg) {
+    if (size == 0) return PM3_EINVARG;
+    if (signalprop.isnoise) return PM3_ESOFT;
+
+    size_t clkStartIdx = 0;
+    clk = DetectNRZClock(samples, size, clk, &clkStartIdx);
+    if (clk == 0) return PM3_ESOFT;
+
+    int high, low;
+    getHiLo(&high, &low, 75, 75);
+    nrz_stream_init(s, clk, invert, high, low, cb, arg);
+    return PM3_SUCCESS;
+}
+
+static void nrz_stream_sample(nrz_stream_t *s, size_t i, uint8_t sample) {
+    if (i < 20)
+        return;
+
+    if (sample >= s->high) s->bit = 1;
+    if (sample <= s->low) s->bit = 0;
+
+    if (i > 20) {
+        //if transition detected or large number of same bits - store the passed bits
+        if (s->bit != s->prev || (i - s->last_bit) == (10 * s->clk)) {
+            lf_bits_put(&s->out, s->prev ^ s->invert, (i - s->last_bit + (s->clk / 4)) / s->clk);
+            if (s->last_bit == 0)
+                s->start_idx = i - (lf_bits_count(&s->out) * s->clk);
+            s->last_bit = i - 1;
+        }
+    }
+    s->prev = s->bit;
+}
+
+void nrz_stream_feed(nrz_stream_t *s, const uint8_t *samples, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        s->ring[s->received % sizeof(s->ring)] = samples[i];
+        s->received++;
+        while (s->idx + NRZ_STREAM_LAG < s->received) {
+            nrz_stream_sample(s, s->idx, s->ring[s->idx % sizeof(s->ring)]);
+            s->idx++;
+        }
+    }
+    lf_bits_flush(&s->out);
+}
+
+void nrz_stream_finish(nrz_stream_t *s) {
+    lf_bits_flush(&s->out);
+}
+
+// PSK1, the start is found the way pskRawDemod_ext does, the bits before it are set at once
+
+int psk_stream_setup(psk_stream_t *s, uint8_t *samples, size_t size, int clock, int invert, lf_bits_cb_t cb, void *arg) {
+
+    if (size < 170) return PM3_EINVARG;
+
+    uint8_t curPhase = invert;
+    uint8_t fc = 0;
+    size_t firstFullWave = 0;
+    uint16_t fullWaveLen = 0;
+    uint8_t first;
+
+    clock = DetectPSKClock(samples, size, clock, &firstFullWave, &curPhase, &fc, NULL);
+    if (clock <= 0) return PM3_ESOFT;
+
+    if (firstFullWave == 0) {
+        size_t i = findModStart(samples, size, fc, NULL);
+        firstFullWave = pskFindFirstPhaseShift(samples, size, &curPhase, i, fc, &fullWaveLen);
+        if (firstFullWave == 0) {
+            // no phase shift, all 1's or 0's
+            firstFullWave = 160;
+            first = curPhase;
+        } else {
+            first = curPhase ^ 1;
+        }
+    } else {
+        first = curPhase ^ 1;
+    }
+
+    s->clock = clock;
+    s->fc = fc;
+    s->tol = fc / 2;
+    s->phase = curPhase;
+    s->received = 0;
+    s->idx = firstFullWave + fullWaveLen - 1;
+    s->wave_start = 0;
+    s->last_clk_bit = firstFullWave;
+    s->errors = 0;
+    s->short_waves = 0;
+    s->failed = false;
+    lf_bits_init(&s->out, cb, arg);
+
+    size_t numBits = firstFullWave / clock;
+    lf_bits_put(&s->out, first, numBits);
+    s->start_idx = firstFullWave - (clock * numBits) + 2;
+    lf_bits_put(&s->out, curPhase, 1);
+    return PM3_SUCCESS;
+}
+
+static void psk_stream_sample(psk_stream_t *s, size_t i, uint8_t s0, uint8_t s1, uint8_t s2) {
+    //top edge of wave = start of new wave
+    if (!(s0 + s->fc < s1 && s1 >= s2))
+        return;
+
+    if (s->wave_start == 0) {
+        s->wave_start = i + 1;
+        return;
+    }
+
+    uint16_t waveLenCnt = (i + 1) - s->wave_start;
+    if (waveLenCnt > s->fc) {
+        //this wave is a phase shift
+        if (i + 1 >= s->last_clk_bit + s->clock - s->tol) { //should be a clock bit
+            s->phase ^= 1;
+            lf_bits_put(&s->out, s->phase, 1);
+            s->last_clk_bit += s->clock;
+        } else if (i < s->last_clk_bit + 10 + s->fc) {
+            //noise after a phase shift - ignore
+        } else { //phase shift before supposed to based on clock
+            s->errors++;
+            lf_bits_put(&s->out, 7, 1);
+        }
+    } else if (i + 1 > s->last_clk_bit + s->clock + s->tol + s->fc) {
+        s->last_clk_bit += s->clock; //no phase shift but clock bit
+        lf_bits_put(&s->out, s->phase, 1);
+    } else if (waveLenCnt < s->fc - 1) { //wave is smaller than field clock (shouldn't happen often)
+        s->short_waves++;
+        // the batch demod gives up here, without bits
+        if (s->short_waves > 101) {
+            s->failed = true;
+            s->errors = s->short_waves;
+        }
+        return;
+    }
+    s->wave_start = i + 1;
+}
+
+void psk_stream_feed(psk_stream_t *s, const uint8_t *samples, size_t len) {
+    for (size_t n = 0; n < len && !s->failed; n++) {
+        s->ring[s->received % sizeof(s->ring)] = samples[n];
+        s->received++;
+        while (s->idx + PSK_STREAM_LAG < s->received && !s->failed) {
+            psk_stream_sample(s, s->idx
+                              , s->ring[s->idx % sizeof(s->ring)]
+                              , s->ring[(s->idx + 1) % sizeof(s->ring)]
+                              , s->ring[(s->idx + 2) % sizeof(s->ring)]
+                             );
+            s->idx++;
+        }
+    }
+    lf_bits_flush(&s->out);
+}
+
+void psk_stream_finish(psk_stream_t *s) {
+    lf_bits_flush(&s->out);
 }
 
 
@@ -2064,14 +3055,14 @@ int pskRawDemod(uint8_t *dest, size_t *size, int *clock, int *invert) {
 
 // by marshmellow
 // FSK Demod then try to locate an AWID ID
-int detectAWID(uint8_t *dest, size_t *size, int *waveStartIdx) {
+int detectAWID(uint8_t *dest, size_t *size, int *waveStartIdx, const lf_waves_t *waves) {
     //make sure buffer has enough data (96bits * 50clock samples)
     if (*size < 96 * 50) return -1;
 
     if (signalprop.isnoise) return -2;
 
     // FSK2a demodulator  clock 50, invert 1, fcHigh 10, fcLow 8
-    *size = fskdemod(dest, *size, 50, 1, 10, 8, waveStartIdx); //awid fsk2a
+    *size = fskdemod(dest, *size, 50, 1, 10, 8, waveStartIdx, waves); //awid fsk2a
 
     //did we get a good demod?
     if (*size < 96) return -3;
@@ -2130,14 +3121,14 @@ int Em410xDecode(uint8_t *bits, size_t *size, size_t *start_idx, uint32_t *hi, u
 
 
 // loop to get raw HID waveform then FSK demodulate the TAG ID from it
-int HIDdemodFSK(uint8_t *dest, size_t *size, uint32_t *hi2, uint32_t *hi, uint32_t *lo, int *waveStartIdx) {
+int HIDdemodFSK(uint8_t *dest, size_t *size, uint32_t *hi2, uint32_t *hi, uint32_t *lo, int *waveStartIdx, const lf_waves_t *waves) {
     //make sure buffer has data
     if (*size < 96 * 50) return -1;
 
     if (signalprop.isnoise) return -2;
 
     // FSK demodulator  fsk2a so invert and fc/10/8
-    *size = fskdemod(dest, *size, 50, 1, 10, 8, waveStartIdx); //hid fsk2a
+    *size = fskdemod(dest, *size, 50, 1, 10, 8, waveStartIdx, waves); //hid fsk2a
 
     //did we get a good demod?
     if (*size < 96 * 2) return -3;
@@ -2169,14 +3160,14 @@ int HIDdemodFSK(uint8_t *dest, size_t *size, uint32_t *hi2, uint32_t *hi, uint32
     return (int)start_idx;
 }
 
-int detectIOProx(uint8_t *dest, size_t *size, int *waveStartIdx) {
+int detectIOProx(uint8_t *dest, size_t *size, int *waveStartIdx, const lf_waves_t *waves) {
     //make sure buffer has data
     if (*size < 66 * 64) return -1;
 
     if (signalprop.isnoise) return -2;
 
     // FSK demodulator  RF/64, fsk2a so invert, and fc/10/8
-    *size = fskdemod(dest, *size, 64, 1, 10, 8, waveStartIdx);  //io fsk2a
+    *size = fskdemod(dest, *size, 64, 1, 10, 8, waveStartIdx, waves);  //io fsk2a
 
     //did we get enough demod data?
     if (*size < 64) return -3;
@@ -33,31 +33,86 @@ typedef struct {
 } signal_t;
 signal_t *getSignalProperties(void);
 
+// Edges of one capture, built once by lfWavesBuild and handed to the clock
+// detectors and demods, which then don't walk the samples again. The wave tops,
+// the crossings of the signal mean, and for the peak thresholds of the ASK clock
+// detection (75%) and of the wave counters (80%) the peak mask and the runs of
+// high and low samples. Detectors given NULL, or waves of other samples or
+// thresholds, walk the samples as they always did. The device always does.
+typedef struct {
+    int high;
+    int low;
+    uint8_t *peak;              // 1 for each sample >= high or <= low
+    uint32_t *hi;               // runs of samples >= high, start and end of each
+    size_t nhi;
+    uint32_t *lo;               // runs of samples <= low
+    size_t nlo;
+} lf_level_t;
+
+#define LF_LEVEL_ASK_CLOCK  0
+#define LF_LEVEL_WAVES      1
+
+// what the clock detectors answer for the samples of the waves, see lfWavesAnalyse
+typedef struct {
+    bool valid;
+    signal_t signal;            // signal properties they were found with
+    uint16_t fcs[2];            // countFC, without and with fskAdj
+    uint8_t fsk_fc[2];          // detectFSKClk for these field clocks, high and low
+    uint8_t fsk_clk;
+    int fsk_edge;               // -1 when none was found
+    int ask_clk;                // DetectASKClock, clock to detect and errors allowed
+    int ask_start;
+    int psk_clk;                // DetectPSKClock
+    uint8_t psk_fc;
+    uint8_t psk_flip;           // 1 when the phase flips
+    size_t psk_shift;           // SIZE_MAX when none was found
+} lf_clocks_t;
+
+typedef struct {
+    size_t size;                // samples they describe
+    uint32_t *tops;             // samples[i - 1] < samples[i] >= samples[i + 1]
+    size_t ntops;
+    int mean;
+    uint32_t *cross;            // samples[i - 1] and samples[i] on either side of the mean
+    size_t ncross;
+    bool cross_up;              // the first crossing goes up, they alternate
+    lf_level_t level[2];
+    lf_clocks_t clocks;
+    size_t cap;
+} lf_waves_t;
+
+bool lfWavesBuild(lf_waves_t *waves, const uint8_t *samples, size_t size);
+void lfWavesFree(lf_waves_t *waves);
+// runs the clock detectors once, detectors given the waves afterwards answer
+// the same questions on the same samples from there. Not at debug level 2,
+// which wants to see them work
+void lfWavesAnalyse(lf_waves_t *waves, uint8_t *samples, size_t size);
+
 void computeSignalProperties(uint8_t *samples, uint32_t size);
 void removeSignalOffset(uint8_t *samples, uint32_t size);
 void getNextLow(uint8_t *samples, size_t size, int low, size_t *i);
 void getNextHigh(uint8_t *samples, size_t size, int high, size_t *i);
-bool loadWaveCounters(uint8_t *samples, size_t size, int lowToLowWaveLen[], int highToLowWaveLen[], int *waveCnt, int *skip, int *minClk, int *high, int *low);
+bool loadWaveCounters(uint8_t *samples, size_t size, int lowToLowWaveLen[], int highToLowWaveLen[], int *waveCnt, int *skip, int *minClk, int *high, int *low, const lf_waves_t *waves);
 size_t pskFindFirstPhaseShift(uint8_t *samples, size_t size, uint8_t *curPhase, size_t waveStart, uint16_t fc, uint16_t *fullWaveLen);
 
 size_t   addParity(uint8_t *src, uint8_t *dest, uint8_t sourceLen, uint8_t pLen, uint8_t pType);
 int      askdemod(uint8_t *bits, size_t *size, int *clk, int *invert, int maxErr, uint8_t amp, uint8_t askType);
-int      askdemod_ext(uint8_t *bits, size_t *size, int *clk, int *invert, int maxErr, uint8_t amp, uint8_t askType, int *startIdx);
+int      askdemod_ext(uint8_t *bits, size_t *size, int *clk, int *invert, int maxErr, uint8_t amp, uint8_t askType, int *startIdx, const lf_waves_t *waves);
 void     askAmp(uint8_t *bits, size_t size);
 int      BiphaseRawDecode(uint8_t *bits, size_t *size, int *offset, int invert);
 int      bits_to_array(const uint8_t *bits, size_t size, uint8_t *dest);
 uint32_t bytebits_to_byte(uint8_t *src, size_t numbits);
 uint32_t bytebits_to_byteLSBF(uint8_t *src, size_t numbits);
-uint16_t countFC(uint8_t *bits, size_t size, bool fskAdj);
-int      DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr);
+uint16_t countFC(uint8_t *bits, size_t size, bool fskAdj, const lf_waves_t *waves);
+int      DetectASKClock(uint8_t *dest, size_t size, int *clock, int maxErr, const lf_waves_t *waves);
 bool     DetectCleanAskWave(uint8_t *dest, size_t size, uint8_t high, uint8_t low);
-uint8_t  detectFSKClk(uint8_t *bits, size_t size, uint8_t fcHigh, uint8_t fcLow, int *firstClockEdge);
+uint8_t  detectFSKClk(uint8_t *bits, size_t size, uint8_t fcHigh, uint8_t fcLow, int *firstClockEdge, const lf_waves_t *waves);
 int      DetectNRZClock(uint8_t *dest, size_t size, int clock, size_t *clockStartIdx);
-int      DetectPSKClock(uint8_t *dest, size_t size, int clock, size_t *firstPhaseShift, uint8_t *curPhase, uint8_t *fc);
-int      DetectStrongAskClock(uint8_t *dest, size_t size, int high, int low, int *clock);
+int      DetectPSKClock(uint8_t *dest, size_t size, int clock, size_t *firstPhaseShift, uint8_t *curPhase, uint8_t *fc, const lf_waves_t *waves);
+int      DetectStrongAskClock(uint8_t *dest, size_t size, int high, int low, int *clock, const lf_level_t *level);
 int      DetectStrongNRZClk(uint8_t *dest, size_t size, int peak, int low, bool *strong);
-bool     DetectST(uint8_t *buffer, size_t *size, int *foundclock, size_t *ststart, size_t *stend);
-size_t   fskdemod(uint8_t *dest, size_t size, uint8_t rfLen, uint8_t invert, uint8_t fchigh, uint8_t fclow, int *start_idx);
+bool     DetectST(uint8_t *buffer, size_t *size, int *foundclock, size_t *ststart, size_t *stend, const lf_waves_t *waves);
+size_t   fskdemod(uint8_t *dest, size_t size, uint8_t rfLen, uint8_t invert, uint8_t fchigh, uint8_t fclow, int *start_idx, const lf_waves_t *waves);
 //void     getHiLo(uint8_t *bits, size_t size, int *high, int *low, uint8_t fuzzHi, uint8_t fuzzLo);
 void     getHiLo(int *high, int *low, uint8_t fuzzHi, uint8_t fuzzLo);
 uint32_t manchesterEncode2Bytes(uint16_t datain);
@@ -69,15 +124,146 @@ bool     parityTest(uint32_t bits, uint8_t bitLen, uint8_t pType);
 bool     preambleSearch(uint8_t *bits, uint8_t *preamble, size_t pLen, size_t *size, size_t *startIdx);
 bool     preambleSearchEx(uint8_t *bits, uint8_t *preamble, size_t pLen, size_t *size, size_t *startIdx, bool findone);
 int      pskRawDemod(uint8_t *dest, size_t *size, int *clock, int *invert);
-int      pskRawDemod_ext(uint8_t *dest, size_t *size, int *clock, int *invert, int *startIdx);
+int      pskRawDemod_ext(uint8_t *dest, size_t *size, int *clock, int *invert, int *startIdx, const lf_waves_t *waves);
 void     psk2TOpsk1(uint8_t *bits, size_t size);
 void     psk1TOpsk2(uint8_t *bits, size_t size);
 size_t   removeParity(uint8_t *bits, size_t startIdx, uint8_t pLen, uint8_t pType, size_t bLen);
 
+// streaming demods
+//
+// Same bits as fskdemod, askdemod_ext (raw), nrzRawDemod and pskRawDemod_ext for
+// samples fed in chunks of any size, from the first sample of the capture on.
+// The state holds a few samples at most, bits go to the callback as soon as
+// they are certain. The *_stream_setup functions detect clock and thresholds on
+// the first samples the way the batch demods do on the whole capture.
+// Unlike the batch demods the bitstream has no length limit.
+typedef void (*lf_bits_cb_t)(const uint8_t *bits, size_t len, void *arg);
+
+typedef struct {
+    uint8_t buf[64];
+    size_t len;
+    size_t total;               // bits passed to the callback
+    lf_bits_cb_t cb;
+    void *arg;
+} lf_bits_t;
+
+#define FSK_STREAM_HOLD 1024    // fskdemod doesn't look at shorter captures
+#define FSK_STREAM_LAG  20      // the batch demods stop this many samples before the end
+
+typedef struct {
+    uint8_t clk;
+    uint8_t invert;
+    uint8_t fchigh;
+    uint8_t fclow;
+    int mean;
+    uint8_t ring[FSK_STREAM_HOLD];
+    size_t received;
+    size_t idx;                 // next sample to demod
+    bool modstart;              // still looking for the start of modulation
+    bool above;
+    uint8_t thresholds;
+    size_t wave_size;
+    uint8_t prev;               // previous sample, thresholded
+    size_t last_transition;
+    size_t cur_len;
+    size_t last_len;
+    size_t waves;               // one bit per wave, the last ones can still change
+    size_t committed;
+    uint8_t pending[4];
+    size_t agg_idx;             // waves aggregated into bits
+    uint8_t lastval;
+    uint32_t run;
+    uint8_t prev1;
+    uint8_t prev2;
+    int start_idx;
+    lf_bits_t out;
+} fsk_stream_t;
+
+typedef struct {
+    int clk;
+    int invert;
+    int high;
+    int low;
+    bool clean;
+    bool manchester;
+    bool amp;
+    uint8_t amp_prev;
+    uint8_t amp_last;
+    size_t idx;
+    // clean wave
+    bool seek;
+    bool wave_high;
+    size_t smpl_cnt;
+    // weak wave
+    size_t start;
+    int last_bit;
+    uint8_t mid_bit;
+    uint8_t tol;
+    uint8_t last_out;
+    size_t errors;
+    int start_idx;
+    lf_bits_t out;
+} ask_stream_t;
+
+#define NRZ_STREAM_LAG  20
+
+typedef struct {
+    int clk;
+    int invert;
+    int high;
+    int low;
+    uint8_t ring[32];
+    size_t received;
+    size_t idx;
+    uint8_t bit;
+    uint8_t prev;
+    size_t last_bit;
+    int start_idx;
+    lf_bits_t out;
+} nrz_stream_t;
+
+#define PSK_STREAM_LAG  3
+
+typedef struct {
+    int clock;
+    uint8_t fc;
+    uint16_t tol;
+    uint8_t phase;
+    uint8_t ring[8];
+    size_t received;
+    size_t idx;
+    size_t wave_start;
+    size_t last_clk_bit;
+    uint16_t errors;
+    uint16_t short_waves;
+    bool failed;
+    int start_idx;
+    lf_bits_t out;
+} psk_stream_t;
+
+void fsk_stream_init(fsk_stream_t *s, uint8_t clk, uint8_t invert, uint8_t fchigh, uint8_t fclow, int mean, lf_bits_cb_t cb, void *arg);
+int  fsk_stream_setup(fsk_stream_t *s, uint8_t *samples, size_t size, uint8_t clk, uint8_t invert, uint8_t fchigh, uint8_t fclow, lf_bits_cb_t cb, void *arg);
+void fsk_stream_feed(fsk_stream_t *s, const uint8_t *samples, size_t len);
+void fsk_stream_finish(fsk_stream_t *s);
+
+void ask_stream_init(ask_stream_t *s, int clk, int invert, int high, int low, bool clean, int start, uint8_t amp, uint8_t askType, lf_bits_cb_t cb, void *arg);
+int  ask_stream_setup(ask_stream_t *s, uint8_t *samples, size_t size, int clk, int invert, int maxErr, uint8_t amp, uint8_t askType, lf_bits_cb_t cb, void *arg);
+void ask_stream_feed(ask_stream_t *s, const uint8_t *samples, size_t len);
+void ask_stream_finish(ask_stream_t *s);
+
+void nrz_stream_init(nrz_stream_t *s, int clk, int invert, int high, int low, lf_bits_cb_t cb, void *arg);
+int  nrz_stream_setup(nrz_stream_t *s, uint8_t *samples, size_t size, int clk, int invert, lf_bits_cb_t cb, void *arg);
+void nrz_stream_feed(nrz_stream_t *s, const uint8_t *samples, size_t len);
+void nrz_stream_finish(nrz_stream_t *s);
+
+int  psk_stream_setup(psk_stream_t *s, uint8_t *samples, size_t size, int clock, int invert, lf_bits_cb_t cb, void *arg);
+void psk_stream_feed(psk_stream_t *s, const uint8_t *samples, size_t len);
+void psk_stream_finish(psk_stream_t *s);
+
 //tag specific
-int detectAWID(uint8_t *dest, size_t *size, int *waveStartIdx);
+int detectAWID(uint8_t *dest, size_t *size, int *waveStartIdx, const lf_waves_t *waves);
 int Em410xDecode(uint8_t *bits, size_t *size, size_t *start_idx, uint32_t *hi, uint64_t *lo);
-int HIDdemodFSK(uint8_t *dest, size_t *size, uint32_t *hi2, uint32_t *hi, uint32_t *lo, int *waveStartIdx);
-int detectIOProx(uint8_t *dest, size_t *size, int *waveStartIdx);
+int HIDdemodFSK(uint8_t *dest, size_t *size, uint32_t *hi2, uint32_t *hi, uint32_t *lo, int *waveStartIdx, const lf_waves_t *waves);
+int detectIOProx(uint8_t *dest, size_t *size, int *waveStartIdx, const lf_waves_t *waves);
 
 #endif
@@ -29,6 +29,7 @@
 #define DICTIONARIES_SUBDIR  "dictionaries" PATHSEP
 #define LUA_LIBRARIES_SUBDIR "lualibs" PATHSEP
 #define LUA_SCRIPTS_SUBDIR   "luascripts" PATHSEP
+#define LUA_CACHE_SUBDIR     "luacache" PATHSEP
 #define RESOURCES_SUBDIR     "resources" PATHSEP
 #define TRACES_SUBDIR        "traces" PATHSEP
 #define LOGS_SUBDIR          "logs" PATHSEP
@@ -122,6 +122,15 @@ typedef struct {
     bool verbose;
 } PACKED sample_config;
 
+// A block of streamed LF samples, decimated 8 bit ADC values
+typedef struct {
+    uint32_t start;         // index of the first sample in the stream
+    uint16_t overruns;      // times the ADC buffer ran full so far, samples were dropped
+    uint8_t samples[];
+} PACKED lf_stream_data_t;
+
+#define LF_STREAM_BLOCK_SAMPLES (PM3_CMD_DATA_SIZE - sizeof(lf_stream_data_t))
+
 // A struct used to send hf14a-configs over USB
 typedef struct {
     int8_t forceanticol; // 0:auto 1:force executing anticol 2:force skipping anticol
@@ -214,8 +223,11 @@ typedef struct {
     // rdv4
     bool hw_available_flash            : 1;
     bool hw_available_smartcard        : 1;
+
+    // misc
+    bool bigbuf_lz4_download           : 1;
 } PACKED capabilities_t;
-#define CAPABILITIES_VERSION 5
+#define CAPABILITIES_VERSION 6
 extern capabilities_t pm3_capabilities;
 
 // For CMD_LF_T55XX_WRITEBL
@@ -413,6 +425,8 @@ typedef struct {
 #define CMD_TIA                                                           0x0117
 #define CMD_BREAK_LOOP                                                    0x0118
 #define CMD_SET_TEAROFF                                                   0x0119
+#define CMD_SET_TRACE_STREAMING                                           0x011A
+#define CMD_TRACE_STREAM_DATA                                             0x011B
 
 // RDV40, Flash memory operations
 #define CMD_FLASHMEM_WRITE                                                0x0121
@@ -491,6 +505,8 @@ typedef struct {
 #define CMD_SET_ADC_MUX                                                   0x020F
 #define CMD_LF_HID_CLONE                                                  0x0210
 #define CMD_LF_EM410X_WRITE                                               0x0211
+#define CMD_DOWNLOAD_BIGBUF_LZ4                                           0x0212
+#define CMD_DOWNLOADED_BIGBUF_LZ4                                         0x0213
 #define CMD_LF_T55XX_READBL                                               0x0214
 #define CMD_LF_T55XX_WRITEBL                                              0x0215
 #define CMD_LF_T55XX_RESET_READ                                           0x0216
@@ -539,6 +555,8 @@ typedef struct {
 #define CMD_HF_ISO15693_CSETUID                                           0x0316
 
 #define CMD_LF_SNIFF_RAW_ADC                                              0x0360
+#define CMD_LF_SNIFF_STREAM                                               0x0361
+#define CMD_LF_SNIFF_STREAM_DATA                                          0x0362
 
 // For Hitag2 transponders
 #define CMD_LF_HITAG_SNIFF                                                0x0370
@@ -332,10 +332,25 @@ while true; do
       echo -e "\n${C_BLUE}Testing data manipulation:${C_NC}"
       if ! CheckExecute "reveng readline test"    "$CLIENTBIN -c 'reveng -h;reveng -D'" "CRC-64/GO-ISO"; then break; fi
       if ! CheckExecute "reveng -g test"          "$CLIENTBIN -c 'reveng -g abda202c'" "CRC-16/ISO-IEC-14443-3-A"; then break; fi
+      if ! CheckExecute "reveng -g batch test"    "$CLIENTBIN -c 'reveng -g 3132333435363738393dbb 01020304a10f'" "]     CRC-16/ARC$"; then break; fi
       if ! CheckExecute "reveng -w test"          "$CLIENTBIN -c 'reveng -w 8 -s 01020304e3 010204039d'" "CRC-8/SMBUS"; then break; fi
+      if ! CheckExecute "analyse crc bench test"  "$CLIENTBIN -c 'analyse crc b'" "14443-A .*ok"; then break; fi
+      if ! CheckExecute "analyse aid test"        "$CLIENTBIN -c 'analyse aid A000000004101001'" "Name: MasterCard Credit/Debit"; then break; fi
+      if ! CheckExecute "analyse aid bench test"  "$CLIENTBIN -c 'analyse aid b'" "index and scan agree .*ok"; then break; fi
+      if ! CheckExecute "analyse chksum search test" "printf '021020339C\\n0201A55A07F8\\n02FFFE1122339C\\n0244800932\\n' > /tmp/.pm3test-chksum; $CLIENTBIN -c 'analyse chksum f /tmp/.pm3test-chksum'; rm -f /tmp/.pm3test-chksum" "add bytes .*\[1:-1\] .*0x0000 | 0x00FF$"; then break; fi
+      if ! CheckExecute "script batch test"       "printf -- '-b 3132333435363738 -w 16\\n-b 010203 -w 8\\n' > /tmp/.pm3test-batch; $CLIENTBIN -c 'script batch -n data_hex_crc -f /tmp/.pm3test-batch -t 2'; rm -f /tmp/.pm3test-batch" "data_hex_crc, 2 lines, 0 failed"; then break; fi
+      if ! CheckExecute "script bytecode cache test" "$CLIENTBIN -c 'script run data_hex_crc -b 010203 -w 8; script run data_hex_crc -b 010203 -w 8'" "startup .* [1-9][0-9]* chunks from cache"; then break; fi
       if ! CheckExecute "mfu pwdgen test"         "$CLIENTBIN -c 'hf mfu pwdgen t'" "Selftest OK"; then break; fi
+      if ! CheckExecute "dict compile test"       "$CLIENTBIN -c 'dict compile -f mfc_default_keys -o /tmp/.pm3test.dicb; dict info -f /tmp/.pm3test.dicb' 2>&1; rm -f /tmp/.pm3test.dicb" "crc32.*ok"; then break; fi
+      if ! CheckExecute "dict compiled load test" "$CLIENTBIN -c 'dict compile -f iclass_default_keys -k 8 -o /tmp/.pm3test_iclass.dicb; hf iclass lookup u 9655a400f8ff12e0 p f0ffffffffffffff m 0000000089cb984b f /tmp/.pm3test_iclass' 2>&1; rm -f /tmp/.pm3test_iclass.dicb" "Found valid key AE A6 84 A6 DA B2 32 78"; then break; fi
+      if ! CheckExecute "data autocorr fft test"  "$CLIENTBIN -c 'data load -f traces/lf_EM4102-1.pm3; data autocorr w 4000 b'" "correlation.*matches"; then break; fi
+      if ! CheckExecute "data samples lz4 test"    "$CLIENTBIN -c 'data load -f traces/lf_EM4102-1.pm3; data samples t'" "round trip ok, delta"; then break; fi
+      if ! CheckExecute "data samples lz4 traces test" "T=\$(ls traces/*.pm3 | wc -l); OK=\$($CLIENTBIN -c \"\$(for f in traces/*.pm3; do printf 'data load -f %s; data samples t; ' \$f; done)\" | grep -c 'round trip ok'); [ \$OK -eq \$((2 * T)) ] && echo \"\$T traces round trip ok\"" "[1-9][0-9]* traces round trip ok"; then break; fi
       if ! CheckExecute "trace load/list 14a"     "$CLIENTBIN -c 'trace load -f traces/hf_14a_mfu.trace; trace list -1 -t 14a;'" "READBLOCK(8)"; then break; fi
       if ! CheckExecute "trace load/list x"       "$CLIENTBIN -c 'trace load -f traces/hf_14a_mfu.trace; trace list -x1 -t 14a;'" "0.0101840425"; then break; fi
+      if ! CheckExecute "trace indexed lz4 list"  "$CLIENTBIN -c 'trace load -f traces/hf_14a_mfu.trace; trace save -f /tmp/.pm3test-idx --lz4 -n 4 -t 14a; trace load -f /tmp/.pm3test-idx.trcx; trace list -1 --from 4000000;' 2>&1; rm -f /tmp/.pm3test-idx.trcx" "READBLOCK(8)"; then break; fi
+      if ! CheckExecute "trace list json"         "$CLIENTBIN -c 'trace load -f traces/hf_14a_mfu.trace; trace list -1 -t 14a --json -j 4;'" "\"annotation\":\"READBLOCK(8)\""; then break; fi
+      if ! CheckExecute "trace stream replay"     "$CLIENTBIN -c 'trace stream -f /tmp/.pm3test-stream --replay traces/hf_14a_mfu.trace; trace load -f /tmp/.pm3test-stream; trace list -1 -t 14a;' 2>&1; rm -f /tmp/.pm3test-stream.trace" "READBLOCK(8)"; then break; fi
 
       echo -e "\n${C_BLUE}Testing LF:${C_NC}"
       if ! CheckExecute "lf AWID test"          "$CLIENTBIN -c 'data load -f traces/lf_AWID-15-259.pm3;lf search 1'" "AWID ID found"; then break; fi
@@ -355,6 +370,18 @@ while true; do
       if ! CheckExecute "lf PARADOX test"       "$CLIENTBIN -c 'data load -f traces/lf_Paradox-96_40426-APJN08.pm3;lf search 1'" "Paradox ID found"; then break; fi
       if ! CheckExecute "lf VIKING test"        "$CLIENTBIN -c 'data load -f traces/lf_Transit999-best.pm3;lf search 1'" "Viking ID found"; then break; fi
       if ! CheckExecute "lf VISA2000 test"      "$CLIENTBIN -c 'data load -f traces/lf_VISA2000.pm3;lf search 1'" "Visa2000 ID found"; then break; fi
+      if ! CheckExecute "lf search benchmark"   "$CLIENTBIN -c 'data load -f traces/lf_EM4102-1.pm3;lf search 1 b'" "sequential.*EM410x ID"; then break; fi
+      if ! CheckExecute "lf search contexts ask" "$CLIENTBIN -c 'data load -f traces/lf_EM4102-1.pm3;lf search 1 b'" "contexts.*ok"; then break; fi
+      if ! CheckExecute "lf search contexts psk" "$CLIENTBIN -c 'data load -f traces/lf_Indala-504278295.pm3;lf search 1 b'" "contexts.*ok"; then break; fi
+      if ! CheckExecute "lf search batch"       "$CLIENTBIN --offline --batch 'lf search' traces/lf_AWID-15-259.pm3" "\"protocol\":\"AWID ID\".*\"clock\":50"; then break; fi
+      if ! CheckExecute "lf stream replay"      "$CLIENTBIN -c 'lf stream -f traces/lf_sniff_blue_cloner_em4100.pm3 -b 7'" "decoded .*22.* frames in .*108120"; then break; fi
+      if ! CheckExecute "lf stream replay em4x05" "$CLIENTBIN -c 'lf stream -e -f traces/lf_sniff_blue_cloner_em4100.pm3 -b 1'" "78907 | EM4x05 | Write"; then break; fi
+      if ! CheckExecute "lf stream replay tag"  "$CLIENTBIN -c 'lf stream -i -f traces/lf_AWID-15-259.pm3'" "AWID - len: 26 FC: 15 Card: 259"; then break; fi
+      if ! CheckExecute "lf stream fsk demod"   "$CLIENTBIN -c 'lf stream -d fs -f traces/lf_AWID-15-259.pm3 -b 7 -c'" "bitstream .*identical.* to the batch demod, .*399"; then break; fi
+      if ! CheckExecute "lf stream psk demod"   "$CLIENTBIN -c 'lf stream -d p1 -f traces/lf_Indala-504278295.pm3 -b 1 -c'" "bitstream .*identical.* to the batch demod"; then break; fi
+      if ! CheckExecute "wiegand decode test"   "$CLIENTBIN -c 'wiegand decode --raw 2006f623ae'" "H10301.*FC: .*123.*CN: .*4567.*parity: .*valid"; then break; fi
+      if ! CheckExecute "wiegand decode json"   "$CLIENTBIN -c 'wiegand decode -j --raw 2006f623ae'" "\"format\":\"H10301\",\"fc\":123,\"cn\":4567,\"parity\":true"; then break; fi
+      if ! CheckExecute "lf long graph test"    "$CLIENTBIN -c 'data load -f traces/lf_AWID-15-259.pm3; data undec 32; data save -f /tmp/.pm3test-long; data load -f /tmp/.pm3test-long.pm3' 2>&1; rm -f /tmp/.pm3test-long.pm3" "loaded 640000 samples"; then break; fi
 
       if ! CheckExecute slow "lf T55 awid 26 test"               "$CLIENTBIN -c 'data load -f traces/lf_ATA5577_awid_26.pm3; lf search 1'" "AWID ID found"; then break; fi
       if ! CheckExecute slow "lf T55 awid 26 test2"              "$CLIENTBIN -c 'data load -f traces/lf_ATA5577_awid_26.pm3; lf awid demod'" \